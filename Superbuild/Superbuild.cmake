@@ -105,6 +105,13 @@ endif()
 
 option(BUILD_WITH_PYTHON "Build with python support." ON)
 
+###########################################
+# Configure large volume brick codecs
+###########################################
+
+option(BUILD_WITH_LZ4 "Build the LZ4 codec for large volume bricks (requires system LZ4)." OFF)
+option(BUILD_WITH_ZSTD "Build the Zstd codec for large volume bricks (requires system Zstd)." OFF)
+
 ###########################################
 # Configure Seg3D library build
 ###########################################
@@ -292,6 +299,8 @@ set(SEG3D_CACHE_ARGS
     "-DSEG3D_BUILD_INTERFACE:BOOL=${SEG3D_BUILD_INTERFACE}"
     "-DSEG3D_SHOW_CONSOLE:BOOL=${SEG3D_SHOW_CONSOLE}"
     "-DBUILD_WITH_PYTHON:BOOL=${BUILD_WITH_PYTHON}"
+    "-DBUILD_WITH_LZ4:BOOL=${BUILD_WITH_LZ4}"
+    "-DBUILD_WITH_ZSTD:BOOL=${BUILD_WITH_ZSTD}"
     "-DBUILD_STANDALONE_LIBRARY:BOOL=${BUILD_STANDALONE_LIBRARY}"
     "-DBUILD_MANUAL_TOOLS_ONLY:BOOL=${BUILD_MANUAL_TOOLS_ONLY}"
     "-DDO_ZLIB_MANGLE:BOOL=${DO_ZLIB_MANGLE}"
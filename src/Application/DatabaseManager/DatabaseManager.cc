@@ -28,6 +28,9 @@
 
 #include <sqlite3.h>
 
+// STL includes
+#include <typeinfo>
+
 // Core includes
 #include <Core/Utils/StringUtil.h>
 
@@ -37,6 +40,7 @@
 // Core includes
 #include <Core/Utils/Exception.h>
 #include <Core/Utils/Lockable.h>
+#include <Core/Utils/Log.h>
 
 
 namespace Seg3D
@@ -44,10 +48,30 @@ namespace Seg3D
 
 class DatabaseManagerPrivate : public Core::RecursiveLockable {
 public:
+  // Finalize all the cached prepared statements
+  void finalize_prepared_statements();
+
   // The actual database
   sqlite3* database_;
+
+  // The file the database was opened on, empty if the database lives in memory
+  boost::filesystem::path database_file_;
+
+  // Compiled statements of run_prepared_statement, indexed by their SQL
+  typedef std::map< std::string, sqlite3_stmt* > prepared_statement_map_type;
+  prepared_statement_map_type prepared_statements_;
 };
 
+void DatabaseManagerPrivate::finalize_prepared_statements()
+{
+  prepared_statement_map_type::iterator it = this->prepared_statements_.begin();
+  for ( ; it != this->prepared_statements_.end(); ++it )
+  {
+    sqlite3_finalize( it->second );
+  }
+  this->prepared_statements_.clear();
+}
+
 
 DatabaseManager::DatabaseManager() :
   private_( new DatabaseManagerPrivate )
@@ -98,11 +122,24 @@ DatabaseManager::~DatabaseManager()
   // We need to close the database to avoid memory leak.
   if ( this->private_->database_ )
   {
+    // The database can only be closed once all its statements are finalized
+    this->private_->finalize_prepared_statements();
     sqlite3_close( this->private_->database_ );
   }
 }
 
-static int InternalExecuteSqlStatement( sqlite3_stmt* statement, ResultSet& results )
+// Callback that stores the first column of the result row of a PRAGMA statement
+static int InternalPragmaCallback( void* value, int num_columns, char** column_values, 
+  char** /*column_names*/ )
+{
+  if ( num_columns > 0 && column_values[ 0 ] )
+  {
+    *static_cast< std::string* >( value ) = column_values[ 0 ];
+  }
+  return SQLITE_OK;
+}
+
+static int InternalStepSqlStatement( sqlite3_stmt* statement, ResultSet& results )
 {
   assert( statement != NULL );
 
@@ -145,11 +182,62 @@ static int InternalExecuteSqlStatement( sqlite3_stmt* statement, ResultSet& resu
     results.push_back( temp_map );
   }
 
+  return result;
+}
+
+static int InternalExecuteSqlStatement( sqlite3_stmt* statement, ResultSet& results )
+{
+  int result = InternalStepSqlStatement( statement, results );
   sqlite3_finalize( statement );
 
   return result;
 }
 
+static bool InternalBindParameters( sqlite3_stmt* statement, const std::vector< boost::any >& params )
+{
+  if ( static_cast< int >( params.size() ) != sqlite3_bind_parameter_count( statement ) )
+  {
+    return false;
+  }
+
+  for ( size_t j = 0; j < params.size(); ++j )
+  {
+    const boost::any& param = params[ j ];
+    int index = static_cast< int >( j + 1 );
+    int result;
+    if ( param.empty() )
+    {
+      result = sqlite3_bind_null( statement, index );
+    }
+    else if ( param.type() == typeid( long long ) )
+    {
+      result = sqlite3_bind_int64( statement, index, boost::any_cast< long long >( param ) );
+    }
+    else if ( param.type() == typeid( int ) )
+    {
+      result = sqlite3_bind_int( statement, index, boost::any_cast< int >( param ) );
+    }
+    else if ( param.type() == typeid( double ) )
+    {
+      result = sqlite3_bind_double( statement, index, boost::any_cast< double >( param ) );
+    }
+    else if ( param.type() == typeid( std::string ) )
+    {
+      const std::string& str = *boost::any_cast< std::string >( &param );
+      result = sqlite3_bind_text( statement, index, str.c_str(),
+        static_cast< int >( str.size() ), SQLITE_TRANSIENT );
+    }
+    else
+    {
+      return false;
+    }
+
+    if ( result != SQLITE_OK ) return false;
+  }
+
+  return true;
+}
+
 bool DatabaseManager::run_sql_statement( const std::string& sql_str, std::string& error )
 {
   ResultSet dummy_results;
@@ -188,6 +276,78 @@ bool DatabaseManager::run_sql_statement( const std::string& sql_str, ResultSet&
   return true;
 }
 
+bool DatabaseManager::run_prepared_statement( const std::string& sql_str,
+  const std::vector< boost::any >& params, std::string& error )
+{
+  ResultSet dummy_results;
+  return this->run_prepared_statement( sql_str, params, dummy_results, error );
+}
+
+bool DatabaseManager::run_prepared_statement( const std::string& sql_str,
+  const std::vector< boost::any >& params, ResultSet& results, std::string& error )
+{
+  results.clear();
+
+  DatabaseManagerPrivate::lock_type lock( this->private_->get_mutex() );
+
+  if ( this->private_->database_ == NULL )
+  {
+    error = "Invalid database connection.";
+    return false;
+  }
+
+  DatabaseManagerPrivate::prepared_statement_map_type::iterator it =
+    this->private_->prepared_statements_.find( sql_str );
+  if ( it == this->private_->prepared_statements_.end() )
+  {
+    sqlite3_stmt* new_statement = NULL;
+    if ( sqlite3_prepare_v2( this->private_->database_, sql_str.c_str(),
+      static_cast< int >( sql_str.size() ), &new_statement, NULL ) != SQLITE_OK )
+    {
+      error =  "The SQL statement '" + sql_str + "' failed to compile with error: "
+        + sqlite3_errmsg( this->private_->database_ );
+      sqlite3_finalize( new_statement );
+      return false;
+    }
+    it = this->private_->prepared_statements_.insert( std::make_pair( sql_str, new_statement ) ).first;
+  }
+  sqlite3_stmt* statement = it->second;
+
+  bool success = true;
+  if ( !InternalBindParameters( statement, params ) )
+  {
+    error = "Failed to bind the parameters of SQL statement '" + sql_str + "'.";
+    success = false;
+  }
+  else if ( InternalStepSqlStatement( statement, results ) != SQLITE_DONE )
+  {
+    error =  "The SQL statement '" + sql_str + "' returned error: "
+      + sqlite3_errmsg( this->private_->database_ );
+    success = false;
+  }
+
+  // Make the statement ready for the next run
+  sqlite3_reset( statement );
+  sqlite3_clear_bindings( statement );
+
+  return success;
+}
+
+bool DatabaseManager::begin_transaction( std::string& error )
+{
+  return this->run_sql_statement( "BEGIN TRANSACTION;", error );
+}
+
+bool DatabaseManager::commit_transaction( std::string& error )
+{
+  return this->run_sql_statement( "COMMIT TRANSACTION;", error );
+}
+
+bool DatabaseManager::rollback_transaction( std::string& error )
+{
+  return this->run_sql_statement( "ROLLBACK TRANSACTION;", error );
+}
+
 bool DatabaseManager::run_sql_script( const std::string& sql_str, std::string& error )
 {
   DatabaseManagerPrivate::lock_type lock( this->private_->get_mutex() );
@@ -278,6 +438,27 @@ bool DatabaseManager::save_database( const boost::filesystem::path& database_fil
   std::string& error )
 {
   DatabaseManagerPrivate::lock_type lock( this->private_->get_mutex() );
+
+  // If the database lives in this file, the changes are on disk already. Move the write-ahead
+  // log into the database file, so the file can be copied on its own.
+  boost::system::error_code ec;
+  if ( !this->private_->database_file_.empty() &&
+    boost::filesystem::equivalent( this->private_->database_file_, database_file, ec ) )
+  {
+    int result = sqlite3_wal_checkpoint_v2( this->private_->database_, NULL,
+      SQLITE_CHECKPOINT_PASSIVE, NULL, NULL );
+    // NOTE: A busy database is checkpointed by sqlite later on, its log is still consistent.
+    if ( result != SQLITE_OK && result != SQLITE_BUSY )
+    {
+      error = std::string( "Could not checkpoint database file '" ) + database_file.string() +
+        "': " + sqlite3_errmsg( this->private_->database_ );
+      return false;
+    }
+
+    error = "";
+    return true;
+  }
+
   int result;
   sqlite3* temp_open_database;
   sqlite3_backup* backup_database_object;
@@ -313,6 +494,75 @@ bool DatabaseManager::save_database( const boost::filesystem::path& database_fil
   return true;
 }
 
+bool DatabaseManager::open_database( const boost::filesystem::path& database_file,
+  std::string& error )
+{
+  DatabaseManagerPrivate::lock_type lock( this->private_->get_mutex() );
+
+  sqlite3* temp_open_database = 0;
+  int result = sqlite3_open_v2( database_file.string().c_str(), &temp_open_database,
+    SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL );
+
+  // NOTE: Setting the journal mode reads the file, so this also fails if the file is not a
+  // valid database. Files that still use a rollback journal are converted here.
+  std::string journal_mode;
+  if ( result == SQLITE_OK )
+  {
+    result = sqlite3_exec( temp_open_database, "PRAGMA journal_mode = WAL;", 
+      &InternalPragmaCallback, &journal_mode, NULL );
+  }
+
+  // NOTE: Relaxed syncing is only durable with a write-ahead log. Some file systems, like
+  // network shares, do not support it and the database keeps its rollback journal.
+  if ( result == SQLITE_OK )
+  {
+    bool wal = Core::StringToLower( journal_mode ) == "wal";
+    if ( !wal )
+    {
+      CORE_LOG_WARNING( std::string( "Could not enable write-ahead logging for database '" ) +
+        database_file.string() + "', journal mode is '" + journal_mode + "'." );
+    }
+    result = sqlite3_exec( temp_open_database, wal ? 
+      "PRAGMA synchronous = NORMAL; PRAGMA foreign_keys = ON;" :
+      "PRAGMA synchronous = FULL; PRAGMA foreign_keys = ON;", NULL, NULL, NULL );
+  }
+
+  if ( result != SQLITE_OK )
+  {
+    error = std::string( "Could not open database file '" ) + database_file.string() + "'.";
+    if ( temp_open_database )
+    {
+      error += std::string( " " ) + sqlite3_errmsg( temp_open_database );
+    }
+    sqlite3_close( temp_open_database );
+    return false;
+  }
+
+  // The cached statements belong to the old database
+  if ( this->private_->database_ )
+  {
+    this->private_->finalize_prepared_statements();
+    sqlite3_close( this->private_->database_ );
+  }
+
+  this->private_->database_ = temp_open_database;
+  this->private_->database_file_ = database_file;
+
+  error = "";
+  return true;
+}
+
+boost::filesystem::path DatabaseManager::get_database_file()
+{
+  DatabaseManagerPrivate::lock_type lock( this->private_->get_mutex() );
+  return this->private_->database_file_;
+}
+
+DatabaseManager::mutex_type& DatabaseManager::get_mutex()
+{
+  return this->private_->get_mutex();
+}
+
 long long DatabaseManager::get_last_insert_rowid()
 {
   if ( this->private_->database_ != 0 )
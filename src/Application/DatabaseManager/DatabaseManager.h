@@ -35,6 +35,8 @@
 
 // STL includes
 #include <map>
+#include <string>
+#include <vector>
 
 // Boost includes
 #include <boost/filesystem.hpp>
@@ -42,6 +44,9 @@
 #include <boost/any.hpp>
 #include <boost/noncopyable.hpp>
 
+// Core includes
+#include <Core/Utils/Lockable.h>
+
 namespace Seg3D
 {
 
@@ -65,6 +70,11 @@ public:
 
   virtual ~DatabaseManager();
 
+  // -- types --
+public:
+  typedef Core::RecursiveLockable::mutex_type mutex_type;
+  typedef Core::RecursiveLockable::lock_type lock_type;
+
 public:
   /// RUN_SQL_STATEMENT:
   /// Execute the given SQL statement on the database. If the statement generates
@@ -81,14 +91,61 @@ public:
   /// Execute multiple SQL statements sequentially.
   bool run_sql_script( const std::string& sql_str, std::string& error );
 
+  /// RUN_PREPARED_STATEMENT:
+  /// Execute the given SQL statement with the parameters bound to its '?' placeholders.
+  /// The compiled statement is cached, so a statement that is run repeatedly is only compiled
+  /// once. Parameters can be of type long long, int, double or std::string, an empty parameter
+  /// is bound as NULL. If the statement generates any results, they will be put in the result set.
+  /// Returns true on success, otherwise false.
+  bool run_prepared_statement( const std::string& sql_str, const std::vector< boost::any >& params,
+    ResultSet& results, std::string& error );
+
+  /// RUN_PREPARED_STATEMENT:
+  /// Execute the given SQL statement with the parameters bound to its '?' placeholders.
+  /// Returns true on success, otherwise false.
+  bool run_prepared_statement( const std::string& sql_str, const std::vector< boost::any >& params,
+    std::string& error );
+
+  /// BEGIN_TRANSACTION:
+  /// Start a transaction. The statements run until the transaction is committed are written
+  /// to the database as a whole, which is much faster than writing each statement on its own.
+  /// NOTE: The lock of the database needs to be held until the transaction is committed,
+  /// otherwise statements of other threads end up in the transaction.
+  bool begin_transaction( std::string& error );
+
+  /// COMMIT_TRANSACTION:
+  /// Commit the transaction started by begin_transaction.
+  bool commit_transaction( std::string& error );
+
+  /// ROLLBACK_TRANSACTION:
+  /// Discard the changes of the transaction started by begin_transaction.
+  bool rollback_transaction( std::string& error );
+
   /// SAVE_DATABASE:
-  /// Save the database to disk
+  /// Save the database to disk. If the database is already opened on the given file, all its
+  /// changes are on disk already and only the write-ahead log is checkpointed into the file.
   bool save_database( const boost::filesystem::path& database_file, std::string& error );
 
+  /// OPEN_DATABASE:
+  /// Open the database file and use it instead of the current database, every change made
+  /// afterwards is written directly to the file. The file is switched to write-ahead logging,
+  /// which also converts database files written by older versions. If the file cannot be
+  /// opened, the current database is kept.
+  bool open_database( const boost::filesystem::path& database_file, std::string& error );
+
+  /// GET_DATABASE_FILE:
+  /// Get the file the database was opened on, or an empty path for an in-memory database.
+  boost::filesystem::path get_database_file();
+
   /// LOAD_DATABASE:
   /// Load the database from disk
   bool load_database( const boost::filesystem::path& database_file, std::string& error );
 
+  /// GET_MUTEX:
+  /// Get the mutex that serializes access to the database. It is recursive, so the functions
+  /// of the database can be called while holding it.
+  mutex_type& get_mutex();
+
   /// GET_LAST_INSERT_ROWID:
   /// Return the row ID of last successful insert statement.
   long long get_last_insert_rowid();
@@ -0,0 +1,149 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <Application/DatabaseManager/DatabaseManager.h>
+
+using namespace Seg3D;
+
+class DatabaseManagerBenchmarks : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    this->directory_ = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path( "seg3d-database-%%%%-%%%%" );
+    boost::filesystem::create_directories( this->directory_ );
+  }
+
+  virtual void TearDown()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all( this->directory_, ec );
+  }
+
+  boost::filesystem::path directory_;
+};
+
+static long long CountRows( DatabaseManager& database, const std::string& table )
+{
+  ResultSet results;
+  std::string error;
+  if ( !database.run_sql_statement( "SELECT COUNT(*) AS num_rows FROM " + table + ";",
+    results, error ) || results.size() != 1 )
+  {
+    return -1;
+  }
+  return boost::any_cast< long long >( results[ 0 ][ "num_rows" ] );
+}
+
+// Mimics the provenance step table, which is by far the largest table of a project
+static void CreateStepTable( DatabaseManager& database )
+{
+  std::string error;
+  ASSERT_TRUE( database.run_sql_statement( "CREATE TABLE provenance_step "
+    "(prov_step_id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+    "action TEXT NOT NULL, "
+    "user_id INTEGER NOT NULL, "
+    "timestamp TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP);", error ) ) << error;
+}
+
+static void AddSteps( DatabaseManager& database, size_t num_steps )
+{
+  std::string error;
+  ASSERT_TRUE( database.begin_transaction( error ) ) << error;
+  for ( size_t j = 0; j < num_steps; j++ )
+  {
+    std::vector< boost::any > params;
+    params.push_back( std::string( "Threshold layerid=layer_" ) +
+      boost::lexical_cast< std::string >( j ) + " lower_threshold=10 upper_threshold=200" );
+    params.push_back( static_cast< long long >( j % 4 ) );
+    ASSERT_TRUE( database.run_prepared_statement(
+      "INSERT INTO provenance_step (action, user_id) VALUES (?, ?);", params, error ) ) << error;
+  }
+  ASSERT_TRUE( database.commit_transaction( error ) ) << error;
+}
+
+TEST_F( DatabaseManagerBenchmarks, SaveLatency )
+{
+  // Compare the time it takes to save a project after a few new provenance steps, with an
+  // in-memory database that is copied to disk as a whole and with a database that lives on
+  // disk and only needs to be checkpointed.
+  const size_t num_rows[] = { 1000, 10000, 100000 };
+  const size_t num_new_steps = 10;
+  const int num_saves = 5;
+
+  for ( size_t i = 0; i < sizeof( num_rows ) / sizeof( size_t ); i++ )
+  {
+    std::string error;
+    boost::filesystem::path memory_file = this->directory_ /
+      ( "memory_" + boost::lexical_cast< std::string >( num_rows[ i ] ) + ".sqlite" );
+    boost::filesystem::path disk_file = this->directory_ /
+      ( "disk_" + boost::lexical_cast< std::string >( num_rows[ i ] ) + ".sqlite" );
+
+    DatabaseManager memory_database;
+    CreateStepTable( memory_database );
+    AddSteps( memory_database, num_rows[ i ] );
+    ASSERT_TRUE( memory_database.save_database( memory_file, error ) ) << error;
+
+    DatabaseManager disk_database;
+    ASSERT_TRUE( disk_database.open_database( disk_file, error ) ) << error;
+    CreateStepTable( disk_database );
+    AddSteps( disk_database, num_rows[ i ] );
+    ASSERT_TRUE( disk_database.save_database( disk_file, error ) ) << error;
+
+    boost::posix_time::time_duration memory_time, disk_time;
+    for ( int j = 0; j < num_saves; j++ )
+    {
+      AddSteps( memory_database, num_new_steps );
+      boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+      ASSERT_TRUE( memory_database.save_database( memory_file, error ) ) << error;
+      memory_time += boost::posix_time::microsec_clock::local_time() - start;
+
+      start = boost::posix_time::microsec_clock::local_time();
+      AddSteps( disk_database, num_new_steps );
+      ASSERT_TRUE( disk_database.save_database( disk_file, error ) ) << error;
+      disk_time += boost::posix_time::microsec_clock::local_time() - start;
+    }
+
+    size_t total_rows = num_rows[ i ] + num_saves * num_new_steps;
+    EXPECT_EQ( static_cast< long long >( total_rows ), CountRows( memory_database, "provenance_step" ) );
+    EXPECT_EQ( static_cast< long long >( total_rows ), CountRows( disk_database, "provenance_step" ) );
+
+    std::cout << num_rows[ i ] << " provenance rows: in-memory save " <<
+      memory_time.total_microseconds() / num_saves << " us, write-through save " <<
+      disk_time.total_microseconds() / num_saves << " us" << std::endl;
+  }
+}
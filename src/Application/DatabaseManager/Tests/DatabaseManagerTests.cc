@@ -0,0 +1,212 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <Application/DatabaseManager/DatabaseManager.h>
+
+using namespace Seg3D;
+
+class DatabaseManagerTests : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    this->directory_ = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path( "seg3d-database-%%%%-%%%%" );
+    boost::filesystem::create_directories( this->directory_ );
+  }
+
+  virtual void TearDown()
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all( this->directory_, ec );
+  }
+
+  boost::filesystem::path directory_;
+};
+
+static std::string GetJournalMode( DatabaseManager& database )
+{
+  ResultSet results;
+  std::string error;
+  if ( !database.run_sql_statement( "PRAGMA journal_mode;", results, error ) ||
+    results.size() != 1 )
+  {
+    return "";
+  }
+  return boost::any_cast< std::string >( results[ 0 ][ "journal_mode" ] );
+}
+
+static long long GetSynchronous( DatabaseManager& database )
+{
+  ResultSet results;
+  std::string error;
+  if ( !database.run_sql_statement( "PRAGMA synchronous;", results, error ) ||
+    results.size() != 1 )
+  {
+    return -1;
+  }
+  return boost::any_cast< long long >( results[ 0 ][ "synchronous" ] );
+}
+
+static long long CountRows( DatabaseManager& database, const std::string& table )
+{
+  ResultSet results;
+  std::string error;
+  if ( !database.run_sql_statement( "SELECT COUNT(*) AS num_rows FROM " + table + ";",
+    results, error ) || results.size() != 1 )
+  {
+    return -1;
+  }
+  return boost::any_cast< long long >( results[ 0 ][ "num_rows" ] );
+}
+
+// Mimics the provenance step table, which is by far the largest table of a project
+static void CreateStepTable( DatabaseManager& database )
+{
+  std::string error;
+  ASSERT_TRUE( database.run_sql_statement( "CREATE TABLE provenance_step "
+    "(prov_step_id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+    "action TEXT NOT NULL, "
+    "user_id INTEGER NOT NULL, "
+    "timestamp TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP);", error ) ) << error;
+}
+
+static void AddSteps( DatabaseManager& database, size_t num_steps )
+{
+  std::string error;
+  ASSERT_TRUE( database.begin_transaction( error ) ) << error;
+  for ( size_t j = 0; j < num_steps; j++ )
+  {
+    std::vector< boost::any > params;
+    params.push_back( std::string( "Threshold layerid=layer_" ) +
+      boost::lexical_cast< std::string >( j ) + " lower_threshold=10 upper_threshold=200" );
+    params.push_back( static_cast< long long >( j % 4 ) );
+    ASSERT_TRUE( database.run_prepared_statement(
+      "INSERT INTO provenance_step (action, user_id) VALUES (?, ?);", params, error ) ) << error;
+  }
+  ASSERT_TRUE( database.commit_transaction( error ) ) << error;
+}
+
+TEST_F( DatabaseManagerTests, OpenDatabaseWritesThrough )
+{
+  boost::filesystem::path database_file = this->directory_ / "provenance.sqlite";
+  std::string error;
+
+  {
+    DatabaseManager database;
+    EXPECT_TRUE( database.get_database_file().empty() );
+    ASSERT_TRUE( database.open_database( database_file, error ) ) << error;
+    EXPECT_EQ( database_file, database.get_database_file() );
+    EXPECT_EQ( "wal", GetJournalMode( database ) );
+    // NORMAL
+    EXPECT_EQ( 1, GetSynchronous( database ) );
+
+    CreateStepTable( database );
+    AddSteps( database, 100 );
+    // No save: the rows are on disk as soon as they are committed
+  }
+
+  DatabaseManager database;
+  ASSERT_TRUE( database.open_database( database_file, error ) ) << error;
+  EXPECT_EQ( 100, CountRows( database, "provenance_step" ) );
+
+  // Saving onto its own file only checkpoints the log
+  AddSteps( database, 10 );
+  ASSERT_TRUE( database.save_database( database_file, error ) ) << error;
+
+  DatabaseManager copy;
+  ASSERT_TRUE( copy.load_database( database_file, error ) ) << error;
+  EXPECT_EQ( 110, CountRows( copy, "provenance_step" ) );
+}
+
+TEST_F( DatabaseManagerTests, OpenDatabaseMigratesRollbackJournal )
+{
+  boost::filesystem::path database_file = this->directory_ / "sessions.sqlite";
+  std::string error;
+
+  // Files written by earlier versions are snapshots of an in-memory database
+  {
+    DatabaseManager database;
+    CreateStepTable( database );
+    AddSteps( database, 25 );
+    ASSERT_TRUE( database.save_database( database_file, error ) ) << error;
+
+    DatabaseManager loaded;
+    ASSERT_TRUE( loaded.load_database( database_file, error ) ) << error;
+    EXPECT_EQ( 25, CountRows( loaded, "provenance_step" ) );
+  }
+
+  DatabaseManager database;
+  ASSERT_TRUE( database.open_database( database_file, error ) ) << error;
+  EXPECT_EQ( "wal", GetJournalMode( database ) );
+  EXPECT_EQ( 25, CountRows( database, "provenance_step" ) );
+
+  AddSteps( database, 5 );
+  EXPECT_EQ( 30, CountRows( database, "provenance_step" ) );
+}
+
+TEST_F( DatabaseManagerTests, OpenInvalidFileKeepsDatabase )
+{
+  boost::filesystem::path database_file = this->directory_ / "notes.sqlite";
+  {
+    std::ofstream file( database_file.string().c_str() );
+    file << "This is not a database, it is long enough to contain a header though.\n";
+  }
+
+  std::string error;
+  DatabaseManager database;
+  CreateStepTable( database );
+  AddSteps( database, 3 );
+
+  EXPECT_FALSE( database.open_database( database_file, error ) );
+  EXPECT_FALSE( error.empty() );
+  EXPECT_TRUE( database.get_database_file().empty() );
+  EXPECT_EQ( 3, CountRows( database, "provenance_step" ) );
+}
+
+TEST_F( DatabaseManagerTests, OpenDatabaseWithoutLogSyncsFully )
+{
+  // An in-memory database cannot use a write-ahead log, just like files on some network shares
+  std::string error;
+  DatabaseManager database;
+  ASSERT_TRUE( database.open_database( ":memory:", error ) ) << error;
+  EXPECT_EQ( "memory", GetJournalMode( database ) );
+  // FULL
+  EXPECT_EQ( 2, GetSynchronous( database ) );
+
+  CreateStepTable( database );
+  AddSteps( database, 3 );
+  EXPECT_EQ( 3, CountRows( database, "provenance_step" ) );
+}
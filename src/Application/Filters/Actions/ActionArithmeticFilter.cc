@@ -164,6 +164,8 @@ bool ActionArithmeticFilterPrivate::validate_parser( Core::ActionContextHandle&
   std::vector< LayerHandle > layers( layer_ids.size() );
 
   std::string name( "A" );
+  // Single precision cannot represent all values of 32 and 64 bit integer and double data
+  bool double_precision = false;
   for ( size_t i = 0; i < layer_ids.size(); ++i )
   {
     name[ 0 ] = static_cast< char >( 'A' + i );
@@ -203,6 +205,12 @@ bool ActionArithmeticFilterPrivate::validate_parser( Core::ActionContextHandle&
         return false;
       }
 
+      Core::DataType data_type = input_data_block->get_data_type();
+      if ( data_type != Core::DataType::FLOAT_E && Core::GetSizeDataType( data_type ) >= 4 )
+      {
+        double_precision = true;
+      }
+
       if ( i == 0 && replace )
       {
         if ( ! ( this->algo_->lock_for_processing( layers[ i ] ) ) )
@@ -284,6 +292,8 @@ bool ActionArithmeticFilterPrivate::validate_parser( Core::ActionContextHandle&
     this->algo_->src_layer_ = layers[ 0 ];
   }
 
+  this->algo_->engine_.set_double_precision( double_precision );
+
   const Core::GridTransform& grid_trans = layers[ 0 ]->get_grid_transform();
   std::string error;
 
@@ -302,6 +312,7 @@ bool ActionArithmeticFilterPrivate::validate_parser( Core::ActionContextHandle&
   {
     if( !this->algo_->engine_.add_output_data_block( ActionArithmeticFilter::RESULT_C, 
       grid_trans.get_nx(), grid_trans.get_ny(), grid_trans.get_nz(), 
+      ( double_precision && this->preserve_data_format_ ) ? Core::DataType::DOUBLE_E :
       Core::DataType::FLOAT_E, error ) )
     {
       context->report_error( error );
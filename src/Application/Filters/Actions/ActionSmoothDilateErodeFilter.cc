@@ -26,18 +26,16 @@
  DEALINGS IN THE SOFTWARE.
  */
 
-// ITK includes
-#include <itkBinaryBallStructuringElement.h>
-#include <itkBinaryErodeImageFilter.h>
-#include <itkBinaryDilateImageFilter.h>
+// Boost includes
+#include <boost/bind.hpp>
 
 // Core includes
-#include <Core/DataBlock/StdDataBlock.h>
+#include <Core/DataBlock/MaskMorphology.h>
 
 // Application includes
 #include <Application/Layer/LayerManager.h>
 #include <Application/StatusBar/StatusBar.h>
-#include <Application/Filters/ITKFilter.h> // ITKFilter inherits LayerFilter
+#include <Application/Filters/LayerFilter.h>
 #include <Application/Filters/Actions/ActionSmoothDilateErodeFilter.h>
 
 // REGISTER ACTION:
@@ -118,7 +116,7 @@ bool ActionSmoothDilateErodeFilter::validate( Core::ActionContextHandle& context
 // NOTE: The separation of the algorithm into a private class is for the purpose of running the
 // filter on a separate thread.
 
-class SmoothDilateErodeFilterAlgo : public ITKFilter
+class SmoothDilateErodeFilterAlgo : public LayerFilter
 {
 public:
   LayerHandle src_layer_;
@@ -133,127 +131,50 @@ public:
   bool only2d_;
   int slice_type_;
   
-public:
-  void run_dilate_filter();
-  void run_erode_filter();
-
 public:
   // RUN_FILTER:
   // Implemtation of run of the Runnable base class, this function is called when the thread
   // is launched.
 
-  // NOTE: The macro needs a data type to select which version to run. This needs to be
-  // a member variable of the algorithm class.
-  SCI_BEGIN_TYPED_ITK_RUN( this->src_layer_->get_data_type() )
+  virtual void run_filter()
   {
-    // Define the type of filter that we use.
-    // OutputImageType same as InputImageType (mask)
-    typedef itk::BinaryBallStructuringElement< float, 3 > structuring_element_type;
-    typedef itk::BinaryErodeImageFilter
-      < TYPED_IMAGE_TYPE, TYPED_IMAGE_TYPE, structuring_element_type > erode_filter_type;
-    typedef itk::BinaryDilateImageFilter
-      < TYPED_IMAGE_TYPE, TYPED_IMAGE_TYPE, structuring_element_type > dilate_filter_type;
-
-    // Retrieve the image as an itk image from the underlying data structure
-    // NOTE: This only does wrapping and does not regenerate the data.
-    typename Core::ITKImageDataT<VALUE_TYPE>::Handle input_image; 
-    this->get_itk_image_from_layer<VALUE_TYPE>( this->src_layer_, input_image );
-
-    //
-    // Dilate
-    //
-
-    // Create a new ITK filter instantiation. 
-    typename dilate_filter_type::Pointer dilate_filter = dilate_filter_type::New();
-
-    // Relay abort and progress information to the layer that is executing the filter.
-    this->forward_abort_to_filter( dilate_filter, this->dst_layer_ );
-    this->observe_itk_progress( dilate_filter, this->dst_layer_, 0.0, 0.5 );
-
-    // Setup the filter parameters that we do not want to change.
-    dilate_filter->SetInput( input_image->get_image() );
-    
-    structuring_element_type dilate_structuring_element;
-    dilate_structuring_element.SetRadius( this->dilate_radius_ );
-    dilate_structuring_element.CreateStructuringElement();
-    dilate_filter->SetKernel( dilate_structuring_element );
-
-    dilate_filter->SetDilateValue( 1 );
-
-    // Ensure we will have some threads left for doing something else
-    this->limit_number_of_itk_threads( dilate_filter );
-
-    // Run the actual ITK filter.
-    // This needs to be in a try/catch statement as certain filters throw exceptions when they
-    // are aborted. In that case we will relay a message to the status bar for information.
-    try 
-    { 
-      dilate_filter->Update(); 
-    } 
-    catch ( ... ) 
+    MaskLayerHandle input_mask = boost::dynamic_pointer_cast<MaskLayer>( this->src_layer_ );
+
+    // The morphology works directly on the bit-plane of the mask, without expanding it into
+    // a full data block first
+    Core::MaskMorphology morphology;
+    if ( !( morphology.set_input( input_mask->get_mask_volume()->get_mask_data_block() ) ) )
     {
-      if ( this->check_abort() )
-      {
-        this->report_error( "Filter was aborted." );
-        return;
-      }
-      this->report_error( "ITK filter failed to complete." );
+      this->report_error( "Could not allocate enough memory." );
       return;
     }
 
-    // As ITK filters generate an inconsistent abort behavior, we record our own abort flag
-    // This one is set when the abort button is pressed and an abort is sent to ITK.
-    if ( this->check_abort() ) return;
-
-    //
-    // Erode
-    //
-
-    // Create a new ITK filter instantiation. 
-    typename erode_filter_type::Pointer erode_filter = erode_filter_type::New();
-
-    // Relay abort and progress information to the layer that is executing the filter.
-    this->forward_abort_to_filter( erode_filter, this->dst_layer_ );
-    this->observe_itk_progress( erode_filter, this->dst_layer_, 0.5, 0.5 );
-
-    // Setup the filter parameters that we do not want to change.
-    erode_filter->SetInput( dilate_filter->GetOutput() );
+    morphology.set_abort_function( boost::bind( &LayerFilter::check_abort, this ) );
 
-    structuring_element_type erode_structuring_element;
-    erode_structuring_element.SetRadius( this->erode_radius_ );
-    erode_structuring_element.CreateStructuringElement();
-    erode_filter->SetKernel( erode_structuring_element );
+    // The rounded ball includes all voxels closer than half a voxel beyond the radius, 
+    // which gives the smoother outline this filter is named after
+    morphology.set_progress_function( boost::bind( &Layer::update_progress, 
+      this->dst_layer_, _1, 0.0, 0.5 ) );
+    if ( !( morphology.dilate( this->dilate_radius_, 
+      Core::MaskMorphology::ROUNDED_BALL_E ) ) ) return;
 
-    erode_filter->SetErodeValue( 1 );
+    morphology.set_progress_function( boost::bind( &Layer::update_progress, 
+      this->dst_layer_, _1, 0.5, 0.5 ) );
+    if ( !( morphology.erode( this->erode_radius_, 
+      Core::MaskMorphology::ROUNDED_BALL_E ) ) ) return;
 
-    // Ensure we will have some threads left for doing something else
-    this->limit_number_of_itk_threads( erode_filter );
-
-    // Run the actual ITK filter.
-    // This needs to be in a try/catch statement as certain filters throw exceptions when they
-    // are aborted. In that case we will relay a message to the status bar for information.
-    try 
-    { 
-      erode_filter->Update(); 
-    } 
-    catch ( ... ) 
+    Core::MaskDataBlockHandle output_mask;
+    if ( !( morphology.get_output( this->src_layer_->get_grid_transform(), output_mask ) ) )
     {
-      if ( this->check_abort() )
-      {
-        this->report_error( "Filter was aborted." );
-        return;
-      }
-      this->report_error( "ITK filter failed to complete." );
+      this->report_error( "Could not allocate enough memory." );
       return;
     }
 
-    // As ITK filters generate an inconsistent abort behavior, we record our own abort flag
-    // This one is set when the abort button is pressed and an abort is sent to ITK.
-    if ( this->check_abort() ) return;
+    Core::MaskVolumeHandle mask_volume( new Core::MaskVolume( 
+      this->src_layer_->get_grid_transform(), output_mask ) );
 
-    this->insert_itk_image_into_layer( this->dst_layer_, erode_filter->GetOutput() ); 
+    this->dispatch_insert_mask_volume_into_layer( this->dst_layer_, mask_volume );
   }
-  SCI_END_TYPED_ITK_RUN()
   
   // GET_FITLER_NAME:
   // The name of the filter, this information is used for generating new layer labels.
@@ -271,14 +192,6 @@ public:
   }
 };
 
-void SmoothDilateErodeFilterAlgo::run_dilate_filter()
-{
-}
-
-void SmoothDilateErodeFilterAlgo::run_erode_filter()
-{
-}
-
 
 bool ActionSmoothDilateErodeFilter::run( Core::ActionContextHandle& context, 
   Core::ActionResultHandle& result )
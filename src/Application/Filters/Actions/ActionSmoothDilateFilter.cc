@@ -26,17 +26,16 @@
  DEALINGS IN THE SOFTWARE.
  */
 
-// ITK includes
-#include <itkBinaryBallStructuringElement.h>
-#include <itkBinaryDilateImageFilter.h>
+// Boost includes
+#include <boost/bind.hpp>
 
 // Core includes
-#include <Core/DataBlock/StdDataBlock.h>
+#include <Core/DataBlock/MaskMorphology.h>
 
 // Application includes
 #include <Application/Layer/LayerManager.h>
 #include <Application/StatusBar/StatusBar.h>
-#include <Application/Filters/ITKFilter.h> // ITKFilter inherits LayerFilter
+#include <Application/Filters/LayerFilter.h>
 #include <Application/Filters/Actions/ActionSmoothDilateFilter.h>
 
 // REGISTER ACTION:
@@ -105,7 +104,7 @@ bool ActionSmoothDilateFilter::validate( Core::ActionContextHandle& context )
 // NOTE: The separation of the algorithm into a private class is for the purpose of running the
 // filter on a separate thread.
 
-class SmoothDilateFilterAlgo : public ITKFilter
+class SmoothDilateFilterAlgo : public LayerFilter
 {
 
 public:
@@ -124,70 +123,40 @@ public:
   // Implementation of run of the Runnable base class, this function is called when the thread
   // is launched.
 
-  // NOTE: The macro needs a data type to select which version to run. This needs to be
-  // a member variable of the algorithm class.
-  SCI_BEGIN_TYPED_ITK_RUN( this->src_layer_->get_data_type() )
+  virtual void run_filter()
   {
-    // Define the type of filter that we use.
-    // OutputImageType same as InputImageType (mask)
-    typedef itk::BinaryBallStructuringElement< float, 3 > structuring_element_type;
-    typedef itk::BinaryDilateImageFilter
-      < TYPED_IMAGE_TYPE, TYPED_IMAGE_TYPE, structuring_element_type > filter_type;
+    MaskLayerHandle input_mask = boost::dynamic_pointer_cast<MaskLayer>( this->src_layer_ );
 
-    // Retrieve the image as an itk image from the underlying data structure
-    // NOTE: This only does wrapping and does not regenerate the data.
-    typename Core::ITKImageDataT<VALUE_TYPE>::Handle input_image; 
-    this->get_itk_image_from_layer<VALUE_TYPE>( this->src_layer_, input_image );
-
-    //
-    // Dilate
-    //
-
-    // Create a new ITK filter instantiation. 
-    typename filter_type::Pointer filter = filter_type::New();
-
-    // Relay abort and progress information to the layer that is executing the filter.
-    this->forward_abort_to_filter( filter, this->dst_layer_ );
-    this->observe_itk_progress( filter, this->dst_layer_ );
-
-    // Setup the filter parameters that we do not want to change.
-    filter->SetInput( input_image->get_image() );
-
-    structuring_element_type structuring_element;
-    structuring_element.SetRadius( this->radius_ );
-    structuring_element.CreateStructuringElement();
-    filter->SetKernel(structuring_element );
+    // The morphology works directly on the bit-plane of the mask, without expanding it into
+    // a full data block first
+    Core::MaskMorphology morphology;
+    if ( !( morphology.set_input( input_mask->get_mask_volume()->get_mask_data_block() ) ) )
+    {
+      this->report_error( "Could not allocate enough memory." );
+      return;
+    }
 
-    filter->SetDilateValue( 1 );
+    morphology.set_abort_function( boost::bind( &LayerFilter::check_abort, this ) );
 
-    // Ensure we will have some threads left for doing something else
-    this->limit_number_of_itk_threads( filter );
+    // The rounded ball includes all voxels closer than half a voxel beyond the radius, 
+    // which gives the smoother outline this filter is named after
+    morphology.set_progress_function( boost::bind( &Layer::update_progress, 
+      this->dst_layer_, _1, 0.0, 1.0 ) );
+    if ( !( morphology.dilate( this->radius_, 
+      Core::MaskMorphology::ROUNDED_BALL_E ) ) ) return;
 
-    // Run the actual ITK filter.
-    // This needs to be in a try/catch statement as certain filters throw exceptions when they
-    // are aborted. In that case we will relay a message to the status bar for information.
-    try 
-    { 
-      filter->Update(); 
-    } 
-    catch ( ... ) 
+    Core::MaskDataBlockHandle output_mask;
+    if ( !( morphology.get_output( this->src_layer_->get_grid_transform(), output_mask ) ) )
     {
-      if ( this->check_abort() )
-      {
-        this->report_error( "Filter was aborted." );
-        return;
-      }
-      this->report_error( "ITK filter failed to complete." );
+      this->report_error( "Could not allocate enough memory." );
       return;
     }
 
-    // As ITK filters generate an inconsistent abort behavior, we record our own abort flag
-    // This one is set when the abort button is pressed and an abort is sent to ITK.
-    if ( this->check_abort() ) return;
+    Core::MaskVolumeHandle mask_volume( new Core::MaskVolume( 
+      this->src_layer_->get_grid_transform(), output_mask ) );
 
-    this->insert_itk_image_into_layer( this->dst_layer_, filter->GetOutput() ); 
+    this->dispatch_insert_mask_volume_into_layer( this->dst_layer_, mask_volume );
   }
-  SCI_END_TYPED_ITK_RUN()
   
   // GET_FITLER_NAME:
   // The name of the filter, this information is used for generating new layer labels.
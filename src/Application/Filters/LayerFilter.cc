@@ -39,6 +39,7 @@
 // Core includes
 #include <Core/Utils/Log.h>
 #include <Core/Utils/Exception.h>
+#include <Core/Utils/ThreadPool.h>
 
 // Application includes
 #include <Application/StatusBar/StatusBar.h>
@@ -528,6 +529,13 @@ bool LayerFilter::check_abort()
   return this->private_->abort_;
 }
 
+bool LayerFilter::parallel_for( size_t begin, size_t end, size_t grain,
+  boost::function< void ( size_t, size_t ) > body )
+{
+  return Core::ThreadPool::Instance()->parallel_for( begin, end, grain, body,
+    boost::bind( &LayerFilter::check_abort, this ) );
+}
+
 bool LayerFilter::check_stop()
 {
   boost::mutex::scoped_lock lock( this->private_->mutex_ );
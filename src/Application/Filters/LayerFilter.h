@@ -31,6 +31,7 @@
 
 // Boost includes
 #include <boost/smart_ptr.hpp>
+#include <boost/function.hpp>
 
 // Core includes
 #include <Core/Utils/Notifier.h>
@@ -96,6 +97,15 @@ public:
   /// Monitor the stop flag of a layer
   void connect_stop( const LayerHandle& layer );
 
+  // -- parallel processing --
+public:
+  /// PARALLEL_FOR:
+  /// Run body( chunk_begin, chunk_end ) over chunks of [ begin, end ) on the shared thread pool.
+  /// Chunks that have not started yet are skipped once the filter has been aborted.
+  /// Returns false if the filter was aborted.
+  bool parallel_for( size_t begin, size_t end, size_t grain, 
+    boost::function< void ( size_t, size_t ) > body );
+
   // -- Filter Notifier --
 public:
   /// GET_NOTIFIER:
@@ -49,39 +49,6 @@ public:
 
   ~SingleThresholdFilter() {}
 
-  template< class T >
-  void threshold_data( Core::DataBlockHandle dst, double val )
-  {
-    Core::DataBlockHandle src_data_block = this->src_layer_->get_data_volume()->get_data_block();
-    T* src_data = reinterpret_cast< T* >( src_data_block->get_data() );
-    unsigned char* dst_data = reinterpret_cast< unsigned char* >( dst->get_data() );
-    size_t z_plane_size = src_data_block->get_nx() * src_data_block->get_ny();
-    size_t nz = src_data_block->get_nz();
-    size_t tenth_nz = nz / 10;
-
-    // Lock the source data block
-    Core::DataBlock::shared_lock_type lock( src_data_block->get_mutex() );
-    size_t index = 0;
-    for ( size_t z = 0; z < nz; ++z )
-    {
-      for ( size_t i = 0; i < z_plane_size; ++i, ++index )
-      {
-        dst_data[ index ] = ( src_data[ index ] == val ) ? 1 : 0;
-      }
-
-      if ( this->check_abort() )
-      {
-        return;
-      }
-
-      if ( tenth_nz > 0 && z > 0 && z % tenth_nz == 0 )
-      {
-        this->dst_layer_->update_progress_signal_( ( z * 0.5 ) / nz );
-      }
-    }
-    this->dst_layer_->update_progress_signal_( 0.5 );
-  }
-
   inline void set_data_layer(Seg3D::DataLayerHandle data) { this->src_layer_ = data; }
   inline Seg3D::DataLayerHandle data_layer() { return this->src_layer_; }
 
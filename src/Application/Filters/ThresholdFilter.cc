@@ -28,10 +28,12 @@
 
 #include <Application/Filters/ThresholdFilter.h>
 #include <Core/DataBlock/MaskDataBlockManager.h>
-#include <Core/DataBlock/StdDataBlock.h>
+#include <Core/DataBlock/MaskThreshold.h>
 
 #include <sstream>
 
+#include <boost/bind.hpp>
+
 using namespace Filter;
 using namespace Seg3D;
 using namespace Core;
@@ -54,70 +56,21 @@ std::string ThresholdFilter::get_layer_prefix() const
 
 void ThresholdFilter::run_filter()
 {
-  DataBlockHandle threshold_result =
-    StdDataBlock::New(this->src_layer_->get_grid_transform(), DataType::UCHAR_E );
-
-  switch ( this->src_layer_->get_data_type() )
-  {
-    case DataType::CHAR_E:
-      this->threshold_data< signed char >( threshold_result,
-                                           this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::UCHAR_E:
-      this->threshold_data< unsigned char >( threshold_result,
-                                             this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::SHORT_E:
-      this->threshold_data< short >( threshold_result,
-                                     this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::USHORT_E:
-      this->threshold_data< unsigned short >( threshold_result,
-                                              this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::INT_E:
-      this->threshold_data< int >( threshold_result,
-                                   this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::UINT_E:
-      this->threshold_data< unsigned int >( threshold_result,
-                                            this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::LONGLONG_E:
-      this->threshold_data< long long >( threshold_result,
-                                         this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::ULONGLONG_E:
-      this->threshold_data< unsigned long long >( threshold_result,
-                                                  this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::FLOAT_E:
-      this->threshold_data< float >( threshold_result,
-                                     this->lower_threshold_, this->upper_threshold_ );
-      break;
-    case DataType::DOUBLE_E:
-      this->threshold_data< double >( threshold_result,
-                                      this->lower_threshold_, this->upper_threshold_ );
-      break;
-  }
-
-  if ( this->check_abort() )
+  // The threshold is written directly into the bit-plane of the new mask
+  MaskDataBlockHandle threshold_mask;
+  if ( !MaskDataBlockManager::Create( this->dst_layer_->get_grid_transform(), threshold_mask ) )
   {
+    this->report_error( "Could not allocate enough memory." );
     return;
   }
 
-  MaskDataBlockHandle threshold_mask;
-  MaskDataBlockManager::Convert( threshold_result,
-                                 this->dst_layer_->get_grid_transform(),
-                                 threshold_mask );
-
-  if ( this->check_abort() )
+  if ( !MaskThreshold::Threshold( this->src_layer_->get_data_volume()->get_data_block(),
+    threshold_mask, this->lower_threshold_, this->upper_threshold_, false, boost::bind( &LayerFilter::check_abort, this ),
+    boost::bind( &Layer::update_progress, this->dst_layer_, _1, 0.0, 1.0 ) ) )
   {
     return;
   }
 
-  this->dst_layer_->update_progress_signal_( 1.0 );
-
   this->dispatch_insert_mask_volume_into_layer( this->dst_layer_,
     MaskVolumeHandle( new MaskVolume( this->dst_layer_->get_grid_transform(),
                                       threshold_mask ) ) );
@@ -45,6 +45,7 @@
 #include <itkImageRegistrationMethod.h>
 #include <itkMeanSquaresImageToImageMetric.h>
 
+#include <Core/Application/Application.h>
 #include <Core/Utils/Exception.h>
 #include <Core/Utils/Log.h>
 
@@ -53,6 +54,7 @@
 
 // boost:
 #include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
 
 namespace bfs=boost::filesystem;
 
@@ -61,6 +63,49 @@ CORE_REGISTER_ACTION( Seg3D, FFTFilter )
 namespace Seg3D
 {
 
+// FFTPLANNINGSCOPE:
+/// Switches the FFT planner to measured plans while the filter runs. The measured
+/// plans are kept as FFTW wisdom in the configuration directory, so that subsequent
+/// runs with the same tile sizes do not need to measure them again.
+class FFTPlanningScope : public boost::noncopyable
+{
+public:
+  explicit FFTPlanningScope( bool measure ) :
+    measure_( measure ),
+    previous_measure_( false )
+  {
+    if ( !this->measure_ ) return;
+
+    if ( Core::Application::Instance()->get_config_directory( this->wisdom_file_ ) )
+    {
+      this->wisdom_file_ /= "fftw_wisdom";
+      if ( bfs::exists( this->wisdom_file_ ) &&
+        !itk_fft::load_fftw_wisdom( this->wisdom_file_.string() ) )
+      {
+        CORE_LOG_WARNING( "Could not load FFTW wisdom from " + this->wisdom_file_.string() );
+      }
+    }
+    this->previous_measure_ = itk_fft::set_fft_planning_measure( true );
+  }
+
+  ~FFTPlanningScope()
+  {
+    if ( !this->measure_ ) return;
+
+    itk_fft::set_fft_planning_measure( this->previous_measure_ );
+    if ( !this->wisdom_file_.empty() &&
+      !itk_fft::save_fftw_wisdom( this->wisdom_file_.string() ) )
+    {
+      CORE_LOG_WARNING( "Could not save FFTW wisdom to " + this->wisdom_file_.string() );
+    }
+  }
+
+private:
+  bool measure_;
+  bool previous_measure_;
+  bfs::path wisdom_file_;
+};
+
 bool
 ActionFFTFilter::validate( Core::ActionContextHandle& context )
 {
@@ -117,6 +162,9 @@ ActionFFTFilter::run( Core::ActionContextHandle& context, Core::ActionResultHand
     fftwf_init_threads();
     itk_fft::set_num_fftw_threads(num_threads);
     
+    // plans are cached per tile size, optionally measure them:
+    FFTPlanningScope fft_planning(this->measure_fft_plans_);
+    
     // TODO: does it make sense to expose this?
     // for debugging:
     bfs::path prefix;
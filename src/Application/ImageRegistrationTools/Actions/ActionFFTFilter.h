@@ -67,6 +67,7 @@ CORE_ACTION(
   CORE_ACTION_OPTIONAL_ARGUMENT( "use_standard_mask", "false", "Use standard mask." )
   CORE_ACTION_OPTIONAL_ARGUMENT( "try_refining", "false", "Try refining image." )
   CORE_ACTION_OPTIONAL_ARGUMENT( "run_on_one", "false", "Run on one image only." )
+  CORE_ACTION_OPTIONAL_ARGUMENT( "measure_fft_plans", "false", "Measure FFT plans for the tile sizes instead of estimating them. Slower to start, but faster for large mosaics. Measured plans are kept in the configuration directory." )
   CORE_ACTION_OPTIONAL_ARGUMENT( "sandbox", "-1", "The sandbox in which to run the action." )
   CORE_ACTION_ARGUMENT_IS_NONPERSISTENT( "sandbox" )
 //  CORE_ACTION_CHANGES_PROJECT_DATA()
@@ -94,6 +95,7 @@ public:
     this->add_parameter( this->use_standard_mask_ );
     this->add_parameter( this->try_refining_ );
     this->add_parameter( this->run_on_one_ );
+    this->add_parameter( this->measure_fft_plans_ );
     this->add_parameter( this->sandbox_ );
   }
   
@@ -143,6 +145,7 @@ private:
   bool use_standard_mask_;
   bool try_refining_;
   bool run_on_one_;
+  bool measure_fft_plans_;
 };
 
 }
@@ -0,0 +1,127 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+// STL includes
+#include <limits>
+#include <vector>
+
+// Core includes
+#include <Core/Geometry/BBox.h>
+
+// Application includes
+#include <Application/Layer/MaskLayer.h>
+#include <Application/Layer/LayerManager.h>
+#include <Application/Layer/Actions/ActionCalculateMaskStatistics.h>
+
+// REGISTER ACTION:
+// Define a function that registers the action. The action also needs to be
+// registered in the CMake file.
+CORE_REGISTER_ACTION( Seg3D, CalculateMaskStatistics )
+
+namespace Seg3D
+{
+
+bool ActionCalculateMaskStatistics::validate( Core::ActionContextHandle& context )
+{
+  if ( !LayerManager::Instance()->find_layer_by_id( this->mask_name_ ) )
+  {
+    // If they passed the name instead, then we'll take the opportunity to get the id instead.
+    LayerHandle layer = LayerManager::Instance()->find_layer_by_name( this->mask_name_ );
+    if ( layer ) this->mask_name_ = layer->get_layer_id();
+  }
+
+  if ( !( LayerManager::CheckLayerExistenceAndType( this->mask_name_, 
+    Core::VolumeType::MASK_E, context ) ) ) return false;
+
+  // The data needs to be complete before it can be counted
+  if ( !( LayerManager::CheckLayerAvailabilityForUse( this->mask_name_, 
+    context ) ) ) return false;
+
+  return true; // validated
+}
+
+bool ActionCalculateMaskStatistics::run( Core::ActionContextHandle& context, 
+  Core::ActionResultHandle& result )
+{
+  MaskLayerHandle mask_layer = LayerManager::FindMaskLayer( this->mask_name_ );
+  Core::MaskStatisticsHandle statistics = mask_layer->get_mask_statistics();
+  if ( !statistics )
+  {
+    context->report_error( "Could not calculate the statistics of layer '" + 
+      this->mask_name_ + "'." );
+    return false;
+  }
+
+  Core::GridTransform grid_transform = mask_layer->get_grid_transform();
+  size_t voxel_count = statistics->get_count();
+
+  std::vector< double > values;
+  values.push_back( static_cast< double >( voxel_count ) );
+  values.push_back( grid_transform.spacing_x() * grid_transform.spacing_y() * 
+    grid_transform.spacing_z() * voxel_count );
+
+  Core::IndexVector min, max;
+  Core::Point centroid;
+  if ( statistics->get_bounding_box( min, max ) && statistics->get_centroid( centroid ) )
+  {
+    // The grid transform may rotate the grid, hence all corners are needed
+    Core::BBox bbox;
+    for ( size_t k = 0; k < 8; k++ )
+    {
+      bbox.extend( grid_transform * Core::Point( ( k & 1 ) ? max.xd() : min.xd(), 
+        ( k & 2 ) ? max.yd() : min.yd(), ( k & 4 ) ? max.zd() : min.zd() ) );
+    }
+    centroid = grid_transform * centroid;
+
+    for ( size_t k = 0; k < 3; k++ ) values.push_back( bbox.min()[ k ] );
+    for ( size_t k = 0; k < 3; k++ ) values.push_back( bbox.max()[ k ] );
+    for ( size_t k = 0; k < 3; k++ ) values.push_back( centroid[ k ] );
+  }
+  else
+  {
+    values.resize( values.size() + 9, std::numeric_limits< double >::quiet_NaN() );
+  }
+
+  std::vector< size_t > slice_counts = statistics->get_slice_counts();
+  values.insert( values.end(), slice_counts.begin(), slice_counts.end() );
+
+  result.reset( new Core::ActionResult( values ) );
+
+  return true;
+}
+
+void ActionCalculateMaskStatistics::Dispatch( Core::ActionContextHandle context, 
+  const std::string& mask_name )
+{
+  ActionCalculateMaskStatistics* action = new ActionCalculateMaskStatistics;
+  action->mask_name_ = mask_name;
+  
+  Core::ActionDispatcher::PostAction( Core::ActionHandle( action ), context );
+}
+
+} // end namespace Seg3D
@@ -0,0 +1,78 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef APPLICATION_LAYER_ACTIONS_ACTIONCALCULATEMASKSTATISTICS_H
+#define APPLICATION_LAYER_ACTIONS_ACTIONCALCULATEMASKSTATISTICS_H
+
+// Core includes
+#include <Core/Action/Actions.h>
+#include <Core/Interface/Interface.h>
+
+// Application includes
+#include <Application/Layer/LayerFWD.h>
+
+namespace Seg3D
+{
+
+class ActionCalculateMaskStatistics : public Core::Action
+{
+
+CORE_ACTION( 
+  CORE_ACTION_TYPE( "CalculateMaskStatistics", "Calculate the statistics of a mask layer. The "
+    "result is a list with the voxel count, the volume, the minimum and maximum corner of the "
+    "bounding box, the centroid and the voxel count of each slice along the z-axis. The bounding "
+    "box and centroid are given in world coordinates and are NaN for an empty mask." )
+  CORE_ACTION_ARGUMENT( "mask", "The id or name of the mask layer." )
+)
+  
+  // -- Constructor/Destructor --
+public:
+  ActionCalculateMaskStatistics()
+  {
+    this->add_parameter( this->mask_name_ );
+  }
+  
+// -- Functions that describe action --
+public:
+  virtual bool validate( Core::ActionContextHandle& context ) override;
+  virtual bool run( Core::ActionContextHandle& context, Core::ActionResultHandle& result ) override;
+
+private:
+  /// This parameter contains the id of the mask layer
+  std::string mask_name_;
+
+  // -- Dispatch this action from the interface --
+public:
+  /// DISPATCH
+  /// Create and dispatch action that calculates the statistics of a mask layer
+  static void Dispatch( Core::ActionContextHandle context, const std::string& mask_name );  
+};
+  
+} // end namespace Seg3D
+
+#endif
@@ -30,6 +30,7 @@
 #include <limits>
 
 // Boost includes
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 
 // Core includes
@@ -370,6 +371,19 @@ bool DataLayer::set_data_volume( Core::DataVolumeHandle data_volume )
   return true;
 }
 
+// Write the volume of a data layer to the data directory of the project
+static bool SaveDataVolumeFile( boost::filesystem::path data_file, Core::DataVolumeHandle volume,
+  bool compress, int level )
+{
+  std::string error;
+  if ( ! Core::DataVolume::SaveDataVolume( data_file, volume, error, compress, level ) )
+  {
+    CORE_LOG_ERROR( error );
+    return false;
+  }
+  return true;
+}
+
 bool DataLayer::pre_save_states( Core::StateIO& state_io )
 {
   if ( this->data_volume_ )
@@ -393,15 +407,10 @@ bool DataLayer::pre_save_states( Core::StateIO& state_io )
     bool compress = PreferencesManager::Instance()->compression_state_->get();
     int level = PreferencesManager::Instance()->compression_level_state_->get();
 
-    std::string error;
-    if ( ! Core::DataVolume::SaveDataVolume( full_data_file_name.string(), this->data_volume_,
-      error, compress, level ) )
-    {
-      CORE_LOG_ERROR( error );
-      return false;
-    }
-
-    return true;
+    // The file is written in parallel with the other layers of the session
+    return ProjectManager::Instance()->get_current_project()->schedule_data_save( 
+      full_data_file_name, boost::bind( &SaveDataVolumeFile, full_data_file_name, 
+      this->data_volume_, compress, level ) );
   }
 
   return true;
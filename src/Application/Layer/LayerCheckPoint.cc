@@ -26,12 +26,19 @@
  DEALINGS IN THE SOFTWARE.
  */
 
+// STL includes
+#include <fstream>
+
 // Core includes
 #include <Core/DataBlock/DataSlice.h>
 #include <Core/DataBlock/MaskDataSlice.h>
 #include <Core/DataBlock/DataBlock.h>
+#include <Core/DataBlock/StdDataBlock.h>
 #include <Core/DataBlock/MaskDataBlock.h>
 #include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/LargeVolume/LargeVolumeCodec.h>
+#include <Core/Utils/Log.h>
+#include <Core/Utils/ThreadPool.h>
 
 // Application includes
 #include <Application/Provenance/Provenance.h>
@@ -39,16 +46,103 @@
 #include <Application/Layer/LayerManager.h>
 
 // Boost includes
+#include <boost/bind.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 namespace Seg3D
 {
 
+// Append a value to a run-length buffer as a variable length integer
+static void AppendRunLength( std::vector< char >& buffer, size_t value )
+{
+  while ( value >= 0x80 )
+  {
+    buffer.push_back( static_cast< char >( ( value & 0x7f ) | 0x80 ) );
+    value >>= 7;
+  }
+  buffer.push_back( static_cast< char >( value ) );
+}
+
+// Read a variable length integer from a run-length buffer
+static bool ReadRunLength( const std::vector< char >& buffer, size_t& pos, size_t& value )
+{
+  value = 0;
+  for ( size_t shift = 0; pos < buffer.size() && shift < 64; shift += 7 )
+  {
+    unsigned char byte = static_cast< unsigned char >( buffer[ pos++ ] );
+    value |= static_cast< size_t >( byte & 0x7f ) << shift;
+    if ( ( byte & 0x80 ) == 0 ) return true;
+  }
+  return false;
+}
+
 class LayerCheckPointPrivate : public boost::noncopyable
 {
 public:
+  LayerCheckPointPrivate() :
+    volume_type_( Core::VolumeType::DATA_E ),
+    data_type_( Core::DataType::UCHAR_E ),
+    slices_per_chunk_( 0 ),
+    element_size_( 0 ),
+    compressed_( false ),
+    compressed_size_( 0 ),
+    spilled_( false ),
+    loading_( false ),
+    compressing_( false )
+  {
+  }
+
+  ~LayerCheckPointPrivate()
+  {
+    if ( !this->spill_file_.empty() )
+    {
+      boost::system::error_code ec;
+      boost::filesystem::remove( this->spill_file_, ec );
+    }
+  }
+
+  // ENCODE_VOLUME:
+  // Compress volume_ into chunks of slices
+  bool encode_volume();
+
+  // ENCODE_CHUNKS:
+  // Compress the chunks [ begin, end ) of volume_
+  void encode_chunks( size_t begin, size_t end, std::vector< char >* success );
+
+  // DECODE_VOLUME:
+  // Reconstruct the volume from the compressed chunks
+  bool decode_volume( Core::VolumeHandle& volume );
+
+  // DECODE_CHUNKS:
+  // Decompress the chunks [ begin, end ) into the data of a data block or a mask
+  void decode_chunks( size_t begin, size_t end, char* data, unsigned char mask_value, 
+    std::vector< char >* success );
+
+  // READ_SPILL_FILE:
+  // Read the compressed chunks from the spill file
+  bool read_spill_file( std::vector< std::vector< char > >& chunks );
+
+  // LOAD_SPILL_FILE:
+  // Read the spill file back into memory, run on a service thread by prefetch()
+  void load_spill_file();
+
+  // WAIT_FOR_CHUNKS:
+  // Wait until the compressed chunks are in memory. Needs to be called with mutex_ locked.
+  bool wait_for_chunks( boost::mutex::scoped_lock& lock );
+
+  // WAIT_FOR_COMPRESSION:
+  // Wait until another thread has finished compressing the volume. Needs to be called with 
+  // mutex_ locked.
+  void wait_for_compression( boost::mutex::scoped_lock& lock );
+
   // Check point consisting of a full volume
   Core::VolumeHandle volume_;
+
+  // The layer the volume was taken from
+  LayerWeakHandle layer_;
   
   // Check point consisting of a slice
   typedef std::vector<Core::DataSliceHandle> data_slice_vector_type;
@@ -58,8 +152,313 @@ public:
   mask_slice_vector_type mask_slices_;
   
   ProvenanceID provenance_id_;
+
+  // Description of the compressed volume
+  Core::VolumeType volume_type_;
+  Core::GridTransform grid_transform_;
+  Core::DataType data_type_;
+  size_t slices_per_chunk_;
+  size_t element_size_;
+
+  // Compressed chunks of slices and the size of each chunk before compression. For masks the
+  // chunks hold the run lengths of the bit-plane.
+  std::vector< std::vector< char > > chunks_;
+  std::vector< size_t > chunk_raw_sizes_;
+  std::vector< size_t > chunk_sizes_;
+  bool compressed_;
+  size_t compressed_size_;
+
+  // File the compressed chunks were written to
+  boost::filesystem::path spill_file_;
+  // Whether the compressed chunks are only available on disk
+  bool spilled_;
+  // Whether the spill file is being read in the background
+  bool loading_;
+  // Whether the volume is being compressed by another thread
+  bool compressing_;
+
+  // Protects the volume and the state of the compressed chunks
+  boost::mutex mutex_;
+  // Signalled when the spill file has been read or the volume has been compressed
+  boost::condition_variable finished_;
+
+  // Raw size of a chunk of slices
+  const static size_t CHUNK_SIZE_C;
 };
 
+const size_t LayerCheckPointPrivate::CHUNK_SIZE_C = 4 << 20;
+
+void LayerCheckPointPrivate::wait_for_compression( boost::mutex::scoped_lock& lock )
+{
+  while ( this->compressing_ )
+  {
+    this->finished_.wait( lock );
+  }
+}
+
+bool LayerCheckPointPrivate::encode_volume()
+{
+  // NOTE: This is called without holding mutex_, the volume is not released while it is being
+  // compressed
+  this->volume_type_ = this->volume_->get_type();
+  this->grid_transform_ = this->volume_->get_grid_transform();
+
+  if ( this->volume_type_ == Core::VolumeType::DATA_E )
+  {
+    Core::DataVolumeHandle data_volume = 
+      boost::dynamic_pointer_cast< Core::DataVolume >( this->volume_ );
+    if ( !data_volume || !data_volume->get_data_block() ) return false;
+    this->data_type_ = data_volume->get_data_type();
+    this->element_size_ = Core::GetSizeDataType( this->data_type_ );
+  }
+  else if ( this->volume_type_ == Core::VolumeType::MASK_E )
+  {
+    Core::MaskVolumeHandle mask_volume = 
+      boost::dynamic_pointer_cast< Core::MaskVolume >( this->volume_ );
+    if ( !mask_volume || !mask_volume->get_mask_data_block() ) return false;
+    this->data_type_ = Core::DataType::UCHAR_E;
+    this->element_size_ = 1;
+  }
+  else
+  {
+    return false;
+  }
+
+  size_t slice_size = this->grid_transform_.get_nx() * this->grid_transform_.get_ny() * 
+    this->element_size_;
+  size_t nz = this->grid_transform_.get_nz();
+  if ( slice_size == 0 || nz == 0 ) return false;
+
+  this->slices_per_chunk_ = std::max( CHUNK_SIZE_C / slice_size, static_cast< size_t >( 1 ) );
+  size_t num_chunks = ( nz + this->slices_per_chunk_ - 1 ) / this->slices_per_chunk_;
+  this->chunks_.resize( num_chunks );
+  this->chunk_raw_sizes_.resize( num_chunks );
+  this->chunk_sizes_.resize( num_chunks );
+
+  std::vector< char > success( num_chunks, 0 );
+  Core::parallel_for( 0, num_chunks, 1, boost::bind( &LayerCheckPointPrivate::encode_chunks,
+    this, _1, _2, &success ) );
+
+  this->compressed_size_ = 0;
+  for ( size_t j = 0; j < num_chunks; j++ )
+  {
+    if ( !success[ j ] ) return false;
+    this->chunk_sizes_[ j ] = this->chunks_[ j ].size();
+    this->compressed_size_ += this->chunks_[ j ].size();
+  }
+
+  return true;
+}
+
+void LayerCheckPointPrivate::encode_chunks( size_t begin, size_t end, 
+  std::vector< char >* success )
+{
+  size_t nxy = this->grid_transform_.get_nx() * this->grid_transform_.get_ny();
+  size_t nz = this->grid_transform_.get_nz();
+
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t z_begin = j * this->slices_per_chunk_;
+    size_t z_end = std::min( z_begin + this->slices_per_chunk_, nz );
+    size_t start = z_begin * nxy;
+    size_t size = ( z_end - z_begin ) * nxy;
+    std::string error;
+
+    if ( this->volume_type_ == Core::VolumeType::MASK_E )
+    {
+      Core::MaskDataBlockHandle mask = boost::dynamic_pointer_cast< Core::MaskVolume >( 
+        this->volume_ )->get_mask_data_block();
+      Core::MaskDataBlock::shared_lock_type lock( mask->get_mutex() );
+      const unsigned char* data = mask->get_mask_data() + start;
+      unsigned char mask_value = mask->get_mask_value();
+
+      // Store the lengths of alternating runs of voxels that are off and on
+      std::vector< char > runs;
+      bool state = false;
+      size_t run = 0;
+      for ( size_t i = 0; i < size; i++ )
+      {
+        bool bit = ( data[ i ] & mask_value ) != 0;
+        if ( bit != state )
+        {
+          AppendRunLength( runs, run );
+          state = bit;
+          run = 0;
+        }
+        run++;
+      }
+      AppendRunLength( runs, run );
+
+      this->chunk_raw_sizes_[ j ] = runs.size();
+      ( *success )[ j ] = Core::LargeVolumeBrickCodec::Encode( &runs[ 0 ], runs.size(), 1,
+        "zlib-fast", Core::LargeVolumeFilter::NONE_E, this->chunks_[ j ], error );
+    }
+    else
+    {
+      Core::DataBlockHandle data_block = boost::dynamic_pointer_cast< Core::DataVolume >( 
+        this->volume_ )->get_data_block();
+      Core::DataBlock::shared_lock_type lock( data_block->get_mutex() );
+      const char* data = reinterpret_cast< const char* >( data_block->get_data() ) + 
+        start * this->element_size_;
+
+      this->chunk_raw_sizes_[ j ] = size * this->element_size_;
+      ( *success )[ j ] = Core::LargeVolumeBrickCodec::Encode( data, 
+        this->chunk_raw_sizes_[ j ], this->element_size_, "zlib-fast", 
+        this->element_size_ > 1 ? Core::LargeVolumeFilter::DELTA_E : 
+        Core::LargeVolumeFilter::NONE_E, this->chunks_[ j ], error );
+    }
+
+    if ( !( *success )[ j ] )
+    {
+      CORE_LOG_ERROR( "Could not compress check point: " + error );
+    }
+  }
+}
+
+bool LayerCheckPointPrivate::decode_volume( Core::VolumeHandle& volume )
+{
+  {
+    boost::mutex::scoped_lock lock( this->mutex_ );
+    if ( !this->wait_for_chunks( lock ) ) return false;
+  }
+
+  size_t num_chunks = this->chunks_.size();
+  std::vector< char > success( num_chunks, 0 );
+
+  if ( this->volume_type_ == Core::VolumeType::MASK_E )
+  {
+    Core::MaskDataBlockHandle mask;
+    if ( !Core::MaskDataBlockManager::Create( this->grid_transform_, mask ) ) return false;
+    {
+      Core::MaskDataBlock::lock_type lock( mask->get_mutex() );
+      Core::parallel_for( 0, num_chunks, 1, boost::bind( &LayerCheckPointPrivate::decode_chunks,
+        this, _1, _2, reinterpret_cast< char* >( mask->get_mask_data() ), 
+        mask->get_mask_value(), &success ) );
+    }
+    volume.reset( new Core::MaskVolume( this->grid_transform_, mask ) );
+  }
+  else
+  {
+    Core::DataBlockHandle data_block = Core::StdDataBlock::New( this->grid_transform_, 
+      this->data_type_ );
+    if ( !data_block ) return false;
+    Core::parallel_for( 0, num_chunks, 1, boost::bind( &LayerCheckPointPrivate::decode_chunks,
+      this, _1, _2, reinterpret_cast< char* >( data_block->get_data() ), 0, &success ) );
+    data_block->update_histogram();
+    volume.reset( new Core::DataVolume( this->grid_transform_, data_block ) );
+  }
+
+  for ( size_t j = 0; j < num_chunks; j++ )
+  {
+    if ( !success[ j ] ) return false;
+  }
+  return true;
+}
+
+void LayerCheckPointPrivate::decode_chunks( size_t begin, size_t end, char* data, 
+  unsigned char mask_value, std::vector< char >* success )
+{
+  size_t nxy = this->grid_transform_.get_nx() * this->grid_transform_.get_ny();
+  size_t nz = this->grid_transform_.get_nz();
+
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t z_begin = j * this->slices_per_chunk_;
+    size_t z_end = std::min( z_begin + this->slices_per_chunk_, nz );
+    size_t start = z_begin * nxy;
+    size_t size = ( z_end - z_begin ) * nxy;
+    std::string error;
+
+    if ( this->volume_type_ == Core::VolumeType::MASK_E )
+    {
+      std::vector< char > runs( this->chunk_raw_sizes_[ j ] );
+      if ( !Core::LargeVolumeBrickCodec::Decode( &this->chunks_[ j ][ 0 ], 
+        this->chunks_[ j ].size(), &runs[ 0 ], runs.size(), 1, error ) )
+      {
+        CORE_LOG_ERROR( "Could not decompress check point: " + error );
+        continue;
+      }
+
+      // The mask was cleared when it was created, only the runs that are on need to be set
+      unsigned char* mask_data = reinterpret_cast< unsigned char* >( data ) + start;
+      size_t pos = 0;
+      size_t index = 0;
+      bool state = false;
+      size_t run;
+      while ( index < size && ReadRunLength( runs, pos, run ) )
+      {
+        size_t run_end = std::min( index + run, size );
+        if ( state )
+        {
+          for ( size_t i = index; i < run_end; i++ ) mask_data[ i ] |= mask_value;
+        }
+        index = run_end;
+        state = !state;
+      }
+      ( *success )[ j ] = index == size && pos == runs.size();
+    }
+    else
+    {
+      ( *success )[ j ] = Core::LargeVolumeBrickCodec::Decode( &this->chunks_[ j ][ 0 ], 
+        this->chunks_[ j ].size(), data + start * this->element_size_, 
+        this->chunk_raw_sizes_[ j ], this->element_size_, error );
+      if ( !( *success )[ j ] )
+      {
+        CORE_LOG_ERROR( "Could not decompress check point: " + error );
+      }
+    }
+  }
+}
+
+bool LayerCheckPointPrivate::read_spill_file( std::vector< std::vector< char > >& chunks )
+{
+  std::ifstream file( this->spill_file_.string().c_str(), std::ios::binary );
+  if ( !file ) return false;
+
+  chunks.resize( this->chunk_sizes_.size() );
+  for ( size_t j = 0; j < this->chunk_sizes_.size(); j++ )
+  {
+    chunks[ j ].resize( this->chunk_sizes_[ j ] );
+    if ( !file.read( &chunks[ j ][ 0 ], this->chunk_sizes_[ j ] ) ) return false;
+  }
+  return true;
+}
+
+void LayerCheckPointPrivate::load_spill_file()
+{
+  // NOTE: The spill file and the chunk sizes do not change once the file is written
+  std::vector< std::vector< char > > chunks;
+  bool success = this->read_spill_file( chunks );
+
+  boost::mutex::scoped_lock lock( this->mutex_ );
+  if ( success )
+  {
+    this->chunks_.swap( chunks );
+    this->spilled_ = false;
+  }
+  this->loading_ = false;
+  this->finished_.notify_all();
+}
+
+bool LayerCheckPointPrivate::wait_for_chunks( boost::mutex::scoped_lock& lock )
+{
+  while ( this->loading_ )
+  {
+    this->finished_.wait( lock );
+  }
+
+  // Read the file now if it was not prefetched, or if prefetching failed
+  if ( this->spilled_ )
+  {
+    if ( !this->read_spill_file( this->chunks_ ) )
+    {
+      CORE_LOG_ERROR( "Could not read check point from '" + this->spill_file_.string() + "'" );
+      return false;
+    }
+    this->spilled_ = false;
+  }
+  return true;
+}
 
 LayerCheckPoint::LayerCheckPoint( LayerHandle layer ) :
   private_( new LayerCheckPointPrivate )
@@ -81,16 +480,38 @@ LayerCheckPoint::LayerCheckPoint( LayerHandle layer, Core::SliceType type,
   this->create_slice( layer, type, start, end );
 }
 
+LayerCheckPoint::LayerCheckPoint( Core::VolumeHandle volume ) :
+  private_( new LayerCheckPointPrivate )
+{
+  this->create_volume( volume );
+}
+
+LayerCheckPoint::LayerCheckPoint( Core::VolumeHandle volume, Core::SliceType type, 
+  Core::DataBlock::index_type start, Core::DataBlock::index_type end ) :
+  private_( new LayerCheckPointPrivate )
+{
+  this->create_slice( volume, type, start, end );
+}
+
 LayerCheckPoint::~LayerCheckPoint()
 {
 }
   
 bool LayerCheckPoint::apply( LayerHandle layer ) const
 {
-  // If there is a full volume in the check point insert it into the layer
-  if ( this->private_->volume_ )
+  // If there is a full volume in the check point insert it into the layer, if the volume was 
+  // compressed it is reconstructed first
+  if ( this->is_volume() )
   {
-    LayerManager::DispatchInsertVolumeIntoLayer( layer, this->private_->volume_, 
+    Core::VolumeHandle volume;
+    if ( !this->get_volume( volume ) )
+    {
+      CORE_LOG_ERROR( "Could not restore check point of layer '" + 
+        layer->get_layer_name() + "'" );
+      return false;
+    }
+
+    LayerManager::DispatchInsertVolumeIntoLayer( layer, volume, 
       this->private_->provenance_id_ );
     return true;
   }
@@ -117,78 +538,117 @@ bool LayerCheckPoint::apply( LayerHandle layer ) const
 
   return false;
 }
-  
-bool LayerCheckPoint::create_volume( LayerHandle layer )
+
+bool LayerCheckPoint::apply_slices( Core::VolumeHandle volume ) const
 {
-  this->private_->provenance_id_ = layer->provenance_id_state_->get();
+  if ( !( this->private_->data_slices_.empty() ) )
+  {
+    Core::DataVolumeHandle data_volume = boost::dynamic_pointer_cast<Core::DataVolume>( volume );
+    if ( ! data_volume ) return false;
+
+    for ( size_t j = 0; j < this->private_->data_slices_.size(); j++ )
+    {
+      if ( !data_volume->insert_slice( this->private_->data_slices_[ j ] ) ) return false;
+    }
+    return true;
+  }
+
+  if ( !( this->private_->mask_slices_.empty() ) )
+  {
+    Core::MaskVolumeHandle mask_volume = boost::dynamic_pointer_cast<Core::MaskVolume>( volume );
+    if ( ! mask_volume ) return false;
+
+    for ( size_t j = 0; j < this->private_->mask_slices_.size(); j++ )
+    {
+      if ( !mask_volume->insert_slice( this->private_->mask_slices_[ j ] ) ) return false;
+    }
+    return true;
+  }
 
-  this->private_->volume_ = layer->get_volume();
   return false;
 }
 
-bool LayerCheckPoint::create_slice( LayerHandle layer, Core::SliceType type, 
-  Core::DataBlock::index_type index )
+bool LayerCheckPoint::is_volume() const
 {
-  this->private_->provenance_id_ = layer->provenance_id_state_->get();
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  return this->private_->volume_ || this->private_->compressed_;
+}
 
-  if ( layer->get_type() == Core::VolumeType::MASK_E )
-  {
-    MaskLayerHandle mask = boost::dynamic_pointer_cast<MaskLayer>( layer );
-    if ( ! mask->has_valid_data() ) return false;
-    
-    Core::MaskDataSliceHandle slice;
-    if ( !( mask->get_mask_volume()->extract_slice( type, index, slice ) ) ) return false;
-    
-    this->private_->mask_slices_.push_back( slice );
-    return true;
-  }
-  else if ( layer->get_type() == Core::VolumeType::DATA_E )
+bool LayerCheckPoint::get_volume( Core::VolumeHandle& volume ) const
+{
   {
-    DataLayerHandle data = boost::dynamic_pointer_cast<DataLayer>( layer );
-    if ( ! data->has_valid_data() ) return false;
-    
-    Core::DataSliceHandle slice;
-    if ( !( data->get_data_volume()->extract_slice( type, index, slice ) ) ) return false;
-    
-    this->private_->data_slices_.push_back( slice );
-    return true;
+    boost::mutex::scoped_lock lock( this->private_->mutex_ );
+    if ( this->private_->volume_ )
+    {
+      volume = this->private_->volume_;
+      return true;
+    }
+    if ( !this->private_->compressed_ ) return false;
   }
+
+  // Reconstruct the volume from the compressed chunks, reading them back from disk if needed
+  return this->private_->decode_volume( volume );
+}
+
+bool LayerCheckPoint::create_volume( LayerHandle layer )
+{
+  this->private_->provenance_id_ = layer->provenance_id_state_->get();
+  this->private_->layer_ = layer;
+  return this->create_volume( layer->get_volume() );
+}
+
+bool LayerCheckPoint::create_volume( Core::VolumeHandle volume )
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  this->private_->volume_ = volume;
   return false;
 }
 
+bool LayerCheckPoint::create_slice( LayerHandle layer, Core::SliceType type, 
+  Core::DataBlock::index_type index )
+{
+  return this->create_slice( layer, type, index, index );
+}
 
 bool LayerCheckPoint::create_slice( LayerHandle layer, Core::SliceType type, 
   Core::DataBlock::index_type start, Core::DataBlock::index_type end )
 {
   this->private_->provenance_id_ = layer->provenance_id_state_->get();
+  if ( ! layer->has_valid_data() ) return false;
+
+  return this->create_slice( layer->get_volume(), type, start, end );
+}
 
-  if ( layer->get_type() == Core::VolumeType::MASK_E )
+bool LayerCheckPoint::create_slice( Core::VolumeHandle volume, Core::SliceType type, 
+  Core::DataBlock::index_type start, Core::DataBlock::index_type end )
+{
+  if ( ! volume ) return false;
+
+  if ( volume->get_type() == Core::VolumeType::MASK_E )
   {
+    Core::MaskVolumeHandle mask_volume = boost::dynamic_pointer_cast<Core::MaskVolume>( volume );
+    if ( ! mask_volume ) return false;
+
     for ( Core::DataBlock::index_type j = start; j <= end; j++ )
     {
-
-      MaskLayerHandle mask = boost::dynamic_pointer_cast<MaskLayer>( layer );
-      if ( ! mask->has_valid_data() ) return false;
-      
       Core::MaskDataSliceHandle slice;
-      if ( !( mask->get_mask_volume()->extract_slice( type, j, slice ) ) ) return false;
+      if ( !( mask_volume->extract_slice( type, j, slice ) ) ) return false;
       
       this->private_->mask_slices_.push_back( slice );
     }
     return true;
   }
-  else if ( layer->get_type() == Core::VolumeType::DATA_E )
+  else if ( volume->get_type() == Core::VolumeType::DATA_E )
   {
+    Core::DataVolumeHandle data_volume = boost::dynamic_pointer_cast<Core::DataVolume>( volume );
+    if ( ! data_volume ) return false;
+
     for ( Core::DataBlock::index_type j = start; j <= end; j++ )
     {
-      DataLayerHandle data = boost::dynamic_pointer_cast<DataLayer>( layer );
-      if ( ! data->has_valid_data() ) return false;
-      
       Core::DataSliceHandle slice;
-      if ( !( data->get_data_volume()->extract_slice( type, j, slice ) ) ) return false;
+      if ( !( data_volume->extract_slice( type, j, slice ) ) ) return false;
       
       this->private_->data_slices_.push_back( slice );
-      return true;
     }
     return true;
   }
@@ -198,7 +658,15 @@ bool LayerCheckPoint::create_slice( LayerHandle layer, Core::SliceType type,
 size_t LayerCheckPoint::get_byte_size() const
 {
   size_t size = 0;
-  if ( this->private_->volume_ ) size += this->private_->volume_->get_byte_size();
+
+  {
+    boost::mutex::scoped_lock lock( this->private_->mutex_ );
+    if ( this->private_->volume_ ) size += this->private_->volume_->get_byte_size();
+    if ( this->private_->compressed_ && !this->private_->spilled_ ) 
+    {
+      size += this->private_->compressed_size_;
+    }
+  }
 
   {
     LayerCheckPointPrivate::data_slice_vector_type::iterator it = this->private_->data_slices_.begin();
@@ -224,5 +692,94 @@ size_t LayerCheckPoint::get_byte_size() const
   return size;
 }
 
+bool LayerCheckPoint::compress()
+{
+  {
+    boost::mutex::scoped_lock lock( this->private_->mutex_ );
+    this->private_->wait_for_compression( lock );
+    if ( this->private_->compressed_ ) return true;
+    if ( !this->private_->volume_ ) return false;
+
+    // As long as the layer uses the volume, the check point does not take any extra memory
+    LayerHandle layer = this->private_->layer_.lock();
+    if ( layer && layer->get_volume() == this->private_->volume_ ) return false;
+
+    this->private_->compressing_ = true;
+  }
+
+  // NOTE: The volume is compressed without holding the lock, so the check point can still be
+  // applied in the mean time
+  bool success = this->private_->encode_volume();
+
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  this->private_->compressing_ = false;
+  this->private_->finished_.notify_all();
+
+  // The volume may have been put back into the layer while it was being compressed
+  LayerHandle layer = this->private_->layer_.lock();
+  if ( !success || ( layer && layer->get_volume() == this->private_->volume_ ) )
+  {
+    std::vector< std::vector< char > >().swap( this->private_->chunks_ );
+    return false;
+  }
+
+  this->private_->volume_.reset();
+  this->private_->compressed_ = true;
+  return true;
+}
+
+bool LayerCheckPoint::spill( const boost::filesystem::path& directory )
+{
+  // Check points are only written to disk in their compressed form
+  if ( !this->compress() ) return false;
+
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  while ( this->private_->loading_ )
+  {
+    this->private_->finished_.wait( lock );
+  }
+  if ( this->private_->spilled_ ) return true;
+
+  // The data only needs to be written once, afterwards it can be dropped from memory again
+  if ( this->private_->spill_file_.empty() )
+  {
+    boost::filesystem::path filename = directory / 
+      boost::filesystem::unique_path( "checkpoint-%%%%-%%%%-%%%%-%%%%.dat" );
+    std::ofstream file( filename.string().c_str(), std::ios::binary );
+    for ( size_t j = 0; j < this->private_->chunks_.size() && file; j++ )
+    {
+      file.write( &this->private_->chunks_[ j ][ 0 ], this->private_->chunks_[ j ].size() );
+    }
+    file.close();
+    if ( !file )
+    {
+      boost::system::error_code ec;
+      boost::filesystem::remove( filename, ec );
+      CORE_LOG_WARNING( "Could not write check point to '" + filename.string() + "'" );
+      return false;
+    }
+    this->private_->spill_file_ = filename;
+  }
+
+  std::vector< std::vector< char > >().swap( this->private_->chunks_ );
+  this->private_->spilled_ = true;
+  return true;
+}
+
+bool LayerCheckPoint::is_spilled() const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  return this->private_->spilled_;
+}
+
+void LayerCheckPoint::prefetch()
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  if ( !this->private_->spilled_ || this->private_->loading_ ) return;
+
+  this->private_->loading_ = true;
+  Core::ThreadPool::Instance()->start( boost::bind( &LayerCheckPointPrivate::load_spill_file,
+    this->private_ ) );
+}
   
 } // end namespace Seg3D
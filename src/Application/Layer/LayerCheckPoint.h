@@ -32,6 +32,7 @@
 // Boost includes
 #include <boost/smart_ptr.hpp> 
 #include <boost/utility.hpp> 
+#include <boost/filesystem/path.hpp>
  
 // Core includes
 #include <Core/Volume/VolumeSlice.h>
@@ -65,6 +66,13 @@ public:
   LayerCheckPoint( LayerHandle layer, Core::SliceType type,
     Core::DataBlock::index_type start, Core::DataBlock::index_type end );
 
+  /// Create a volume check point of a volume that is not part of a layer
+  explicit LayerCheckPoint( Core::VolumeHandle volume );
+
+  /// Create a slice check point of a volume that is not part of a layer
+  LayerCheckPoint( Core::VolumeHandle volume, Core::SliceType type,
+    Core::DataBlock::index_type start, Core::DataBlock::index_type end );
+
   // destructor
   virtual ~LayerCheckPoint();
   
@@ -73,12 +81,28 @@ public:
   /// APPLY:
   /// Applies a check point to a layer
   bool apply( LayerHandle layer ) const;
+
+  /// APPLY_SLICES:
+  /// Insert the slices of a slice check point into a volume directly
+  bool apply_slices( Core::VolumeHandle volume ) const;
+
+  /// IS_VOLUME:
+  /// Whether this is a check point of a full volume
+  bool is_volume() const;
+
+  /// GET_VOLUME:
+  /// Get the volume of a volume check point, it is reconstructed if it was compressed
+  bool get_volume( Core::VolumeHandle& volume ) const;
   
   // -- making check points --
 public:
   /// CREATE_VOLUME:
   /// Check point the full volume
   bool create_volume( LayerHandle layer );
+
+  /// CREATE_VOLUME:
+  /// Check point the full volume
+  bool create_volume( Core::VolumeHandle volume );
   
   /// CREATE_SLICE:
   /// Check point a slice check point
@@ -89,10 +113,40 @@ public:
   /// Check point a slice check point
   bool create_slice( LayerHandle layer, Core::SliceType type,
     Core::DataBlock::index_type start, Core::DataBlock::index_type end );
+
+  /// CREATE_SLICE:
+  /// Check point the slices [ start, end ] of a volume
+  bool create_slice( Core::VolumeHandle volume, Core::SliceType type,
+    Core::DataBlock::index_type start, Core::DataBlock::index_type end );
   
   /// GET_BYTE_SIZE:
-  /// Get the size of the check point
+  /// Get the size of the check point in memory
   size_t get_byte_size() const;
+
+  // -- compression --
+public:
+  /// COMPRESS:
+  /// Replace the volume of a volume check point by compressed chunks of slices once the layer 
+  /// no longer uses that volume. Masks are stored as run-length encoded bit-planes, data 
+  /// volumes are shuffled and delta filtered before they are compressed.
+  /// Returns true if the check point holds compressed data.
+  /// NOTE: This function is thread safe and can be run on a service thread, the check point
+  /// can be applied while it is being compressed.
+  bool compress();
+
+  /// SPILL:
+  /// Write the compressed data to a file in the given directory and release it from memory.
+  /// The check point is compressed first if that did not happen yet.
+  bool spill( const boost::filesystem::path& directory );
+
+  /// IS_SPILLED:
+  /// Whether the compressed data is only available on disk
+  bool is_spilled() const;
+
+  /// PREFETCH:
+  /// Start reading spilled data back into memory in the background, so that applying the
+  /// check point does not need to wait for the disk.
+  void prefetch();
   
         // -- internals --
 private:
@@ -364,6 +364,38 @@ void LayerUndoBufferItem::compute_size()
   this->private_->size_ = size;
 }
 
+bool LayerUndoBufferItem::compress()
+{
+  bool compressed = false;
+  for ( size_t j = 0; j < this->private_->layers_to_restore_.size(); j++ )
+  {
+    if ( this->private_->layers_to_restore_[ j ].second->compress() ) compressed = true;
+  }
+  return compressed;
+}
+
+bool LayerUndoBufferItem::spill( const boost::filesystem::path& directory )
+{
+  // NOTE: Only compressed check points can be moved to disk, slice check points and layers 
+  // that were deleted by the action remain in memory.
+  bool success = true;
+  for ( size_t j = 0; j < this->private_->layers_to_restore_.size(); j++ )
+  {
+    if ( !this->private_->layers_to_restore_[ j ].second->spill( directory ) ) success = false;
+  }
+
+  this->compute_size();
+  return success;
+}
+
+void LayerUndoBufferItem::prefetch()
+{
+  for ( size_t j = 0; j < this->private_->layers_to_restore_.size(); j++ )
+  {
+    this->private_->layers_to_restore_[ j ].second->prefetch();
+  }
+}
+
 void LayerUndoBufferItem::add_id_count_to_restore( LayerManager::id_count_type id_count )
 {
     this->private_->id_count_ = id_count;
@@ -116,6 +116,20 @@ public:
   /// Compute the size of the item
   virtual void compute_size();
 
+  // -- memory management --
+public:
+  /// COMPRESS:
+  /// Compress the volume check points of layers that have moved on to a new volume
+  virtual bool compress();
+
+  /// SPILL:
+  /// Move the compressed check points to files in the given directory
+  virtual bool spill( const boost::filesystem::path& directory );
+
+  /// PREFETCH:
+  /// Start loading spilled check points back into memory
+  virtual void prefetch();
+
   // -- internals --
 private:
   LayerUndoBufferItemPrivateHandle private_;
@@ -29,6 +29,7 @@
 // STL includes
 
 // Boost includes 
+#include <boost/bind.hpp>
 
 // Core includes
 #include <Core/Application/Application.h>
@@ -67,6 +68,9 @@ public:
   Core::MaskVolumeHandle mask_volume_;
   Core::IsosurfaceHandle isosurface_;
 
+  // Statistics of the mask that are kept up to date incrementally
+  Core::MaskStatisticsHandle statistics_;
+
   MaskLayer * layer_;
 };
 
@@ -155,6 +159,7 @@ MaskLayer::MaskLayer( const std::string& name, const Core::MaskVolumeHandle& vol
 {
   this->private_->mask_volume_ = volume;
   this->private_->mask_volume_->register_data();
+  this->private_->statistics_.reset( new Core::MaskStatistics );
   this->private_->layer_ = this;
   
   this->private_->initialize_states();
@@ -171,6 +176,7 @@ MaskLayer::MaskLayer( const std::string& state_id ) :
   Layer( "not_initialized", state_id ),
   private_( new MaskLayerPrivate )
 {
+  this->private_->statistics_.reset( new Core::MaskStatistics );
   this->private_->layer_ = this;
   this->private_->initialize_states();
 }
@@ -282,6 +288,22 @@ bool MaskLayer::set_mask_volume( Core::MaskVolumeHandle volume )
   return true;
 }
 
+// Write the data block of a mask layer to the data directory of the project
+static bool SaveMaskDataFile( boost::filesystem::path data_file, Core::DataBlockHandle data_block,
+  Core::GridTransform grid_transform, bool compress, int level )
+{
+  Core::NrrdDataHandle nrrd( new Core::NrrdData( data_block, grid_transform ) );
+
+  std::string error;
+  Core::DataBlock::shared_lock_type slock( data_block->get_mutex() );
+  if ( !Core::NrrdData::SaveNrrd( data_file.string(), nrrd, error, compress, level ) )
+  {
+    CORE_LOG_ERROR( error );
+    return false;
+  }
+  return true;
+}
+
 bool MaskLayer::pre_save_states( Core::StateIO& state_io )
 {
   long long generation_number = this->get_mask_volume()->get_generation();
@@ -303,17 +325,11 @@ bool MaskLayer::pre_save_states( Core::StateIO& state_io )
 
   Core::DataBlockHandle data_block = this->get_mask_volume()->
     get_mask_data_block()->get_data_block();
-  Core::NrrdDataHandle nrrd( new Core::NrrdData( data_block, this->get_grid_transform() ) );
 
-  std::string error;
-  Core::DataBlock::shared_lock_type slock( data_block->get_mutex() );
-  if ( !Core::NrrdData::SaveNrrd( data_file.string(), nrrd, error, compress, level ) )
-  {
-    CORE_LOG_ERROR( error );
-    return false;
-  }
-  
-  return true;
+  // The file is written in parallel with the other layers of the session
+  return ProjectManager::Instance()->get_current_project()->schedule_data_save( data_file,
+    boost::bind( &SaveMaskDataFile, data_file, data_block, this->get_grid_transform(), 
+    compress, level ) );
 }
 
 bool MaskLayer::post_load_states( const Core::StateIO& state_io )
@@ -453,17 +469,10 @@ void MaskLayer::delete_isosurface()
 
 void MaskLayer::calculate_volume()
 {
-  Core::MaskDataBlockHandle mask_block = this->get_mask_volume()->
-    get_mask_data_block();
-    
-  size_t voxel_count = 0;
-  for( size_t j = 0; j < mask_block->get_size(); ++j )
-  {
-    if( mask_block->get_mask_at( j ) )
-    {
-      voxel_count++;
-    }
-  }
+  Core::MaskStatisticsHandle statistics = this->get_mask_statistics();
+  if ( !statistics ) return;
+
+  size_t voxel_count = statistics->get_count();
   
   double calculated_mask_volume = ( this->get_grid_transform().spacing_x() * 
     this->get_grid_transform().spacing_y() * this->get_grid_transform().spacing_z() )
@@ -473,6 +482,19 @@ void MaskLayer::calculate_volume()
   this->counted_pixels_state_->set( Core::ExportToString( voxel_count ) );  
 }
 
+Core::MaskStatisticsHandle MaskLayer::get_mask_statistics()
+{
+  Core::MaskVolumeHandle mask_volume = this->get_mask_volume();
+  if ( !mask_volume || !mask_volume->is_valid() ) return Core::MaskStatisticsHandle();
+
+  if ( !this->private_->statistics_->update( mask_volume->get_mask_data_block() ) )
+  {
+    return Core::MaskStatisticsHandle();
+  }
+
+  return this->private_->statistics_;
+}
+
 size_t MaskLayer::get_byte_size() const
 {
   Layer::lock_type lock( Layer::GetMutex() );
@@ -34,6 +34,7 @@
 #endif
 
 // Core includes
+#include <Core/DataBlock/MaskStatistics.h>
 #include <Core/Isosurface/Isosurface.h>
 #include <Core/Volume/MaskVolume.h>
 
@@ -121,6 +122,12 @@ public:
   /// function that is called by the calculate volume action that calculate the volume of the mask
   void calculate_volume();
 
+  /// GET_MASK_STATISTICS:
+  /// Get the voxel count, bounding box, centroid and per-slice counts of the mask in index space.
+  /// The statistics are cached with the layer, so only the slices that were modified since the 
+  /// last call are counted again. Returns an empty handle if the layer has no valid data.
+  Core::MaskStatisticsHandle get_mask_statistics();
+
   /// DELETE_ISOSURFACE:
   /// Delete the isosurface associated with this layer
   void delete_isosurface();
@@ -0,0 +1,260 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/StdDataBlock.h>
+#include <Core/Volume/DataVolume.h>
+#include <Core/Volume/MaskVolume.h>
+
+#include <Application/Layer/LayerCheckPoint.h>
+
+using namespace Core;
+using namespace Seg3D;
+
+namespace
+{
+
+// Large enough to be split into several chunks of slices when compressed
+const size_t NX_C = 160, NY_C = 128, NZ_C = 72;
+
+DataVolumeHandle createDataVolume( DataType type )
+{
+  GridTransform grid_transform( NX_C, NY_C, NZ_C );
+  DataBlockHandle data_block = StdDataBlock::New( grid_transform, type );
+  for ( size_t z = 0; z < NZ_C; z++ )
+    for ( size_t y = 0; y < NY_C; y++ )
+      for ( size_t x = 0; x < NX_C; x++ )
+      {
+        // A smooth gradient with some noise, so the volume compresses but not to nothing
+        double value = 0.5 * x + 0.25 * y - 0.75 * z + ( ( x * 7919 + y * 104729 + z * 31 ) % 13 );
+        data_block->set_data_at( x, y, z, value );
+      }
+  return DataVolumeHandle( new DataVolume( grid_transform, data_block ) );
+}
+
+MaskVolumeHandle createMaskVolume()
+{
+  GridTransform grid_transform( NX_C, NY_C, NZ_C );
+  MaskDataBlockHandle mask;
+  MaskDataBlockManager::Create( grid_transform, mask );
+  for ( size_t z = 0; z < NZ_C; z++ )
+    for ( size_t y = 0; y < NY_C; y++ )
+      for ( size_t x = 0; x < NX_C; x++ )
+      {
+        double dx = x - 70.0, dy = y - 60.0, dz = z - 30.0;
+        if ( dx * dx + dy * dy + dz * dz < 45.0 * 45.0 || ( x + 2 * y + 3 * z ) % 37 == 0 ) 
+        {
+          mask->set_mask_at( x, y, z );
+        }
+      }
+  return MaskVolumeHandle( new MaskVolume( grid_transform, mask ) );
+}
+
+std::vector< char > getData( const VolumeHandle& volume )
+{
+  DataBlockHandle data_block = boost::dynamic_pointer_cast< DataVolume >( volume )->
+    get_data_block();
+  const char* data = reinterpret_cast< const char* >( data_block->get_data() );
+  return std::vector< char >( data, data + data_block->get_byte_size() );
+}
+
+std::vector< char > getMask( const VolumeHandle& volume )
+{
+  MaskDataBlockHandle mask = boost::dynamic_pointer_cast< MaskVolume >( volume )->
+    get_mask_data_block();
+  std::vector< char > bits( mask->get_size() );
+  for ( size_t j = 0; j < bits.size(); j++ ) bits[ j ] = mask->get_mask_at( j );
+  return bits;
+}
+
+std::vector< char > getContents( const VolumeHandle& volume )
+{
+  return volume->get_type() == VolumeType::MASK_E ? getMask( volume ) : getData( volume );
+}
+
+void expectSameVolume( const VolumeHandle& result, const VolumeHandle& reference )
+{
+  ASSERT_TRUE( result );
+  EXPECT_NE( reference, result );
+  EXPECT_EQ( reference->get_type(), result->get_type() );
+  EXPECT_EQ( reference->get_grid_transform(), result->get_grid_transform() );
+  EXPECT_TRUE( getContents( result ) == getContents( reference ) );
+}
+
+std::vector< VolumeHandle > createVolumes()
+{
+  std::vector< VolumeHandle > volumes;
+  volumes.push_back( createMaskVolume() );
+  volumes.push_back( createDataVolume( DataType::UCHAR_E ) );
+  volumes.push_back( createDataVolume( DataType::SHORT_E ) );
+  volumes.push_back( createDataVolume( DataType::FLOAT_E ) );
+  return volumes;
+}
+
+size_t countFiles( const boost::filesystem::path& directory )
+{
+  size_t count = 0;
+  boost::filesystem::directory_iterator it( directory ), it_end;
+  for ( ; it != it_end; ++it ) count++;
+  return count;
+}
+
+}
+
+TEST( LayerCheckPointTests, CompressedVolumeRestores )
+{
+  std::vector< VolumeHandle > volumes = createVolumes();
+  for ( size_t j = 0; j < volumes.size(); j++ )
+  {
+    SCOPED_TRACE( testing::Message() << "volume " << j );
+
+    LayerCheckPoint check_point( volumes[ j ] );
+    EXPECT_TRUE( check_point.is_volume() );
+    size_t size = check_point.get_byte_size();
+    EXPECT_EQ( volumes[ j ]->get_byte_size(), size );
+
+    ASSERT_TRUE( check_point.compress() );
+    EXPECT_LT( check_point.get_byte_size(), size );
+    EXPECT_LT( 0u, check_point.get_byte_size() );
+
+    // The compressed data stays available, so the check point can be restored again
+    for ( int k = 0; k < 2; k++ )
+    {
+      VolumeHandle restored;
+      ASSERT_TRUE( check_point.get_volume( restored ) );
+      expectSameVolume( restored, volumes[ j ] );
+    }
+  }
+}
+
+TEST( LayerCheckPointTests, SpilledVolumeRestores )
+{
+  boost::filesystem::path directory = boost::filesystem::temp_directory_path() /
+    boost::filesystem::unique_path( "LayerCheckPointTests-%%%%-%%%%" );
+  ASSERT_TRUE( boost::filesystem::create_directories( directory ) );
+
+  std::vector< VolumeHandle > volumes = createVolumes();
+  for ( size_t j = 0; j < volumes.size(); j++ )
+  {
+    SCOPED_TRACE( testing::Message() << "volume " << j );
+    {
+      LayerCheckPoint check_point( volumes[ j ] );
+
+      // Spilling compresses the check point first
+      ASSERT_TRUE( check_point.spill( directory ) );
+      EXPECT_TRUE( check_point.is_spilled() );
+      EXPECT_EQ( 0u, check_point.get_byte_size() );
+      EXPECT_EQ( 1u, countFiles( directory ) );
+
+      // Read back in the background
+      check_point.prefetch();
+      VolumeHandle restored;
+      ASSERT_TRUE( check_point.get_volume( restored ) );
+      expectSameVolume( restored, volumes[ j ] );
+      EXPECT_FALSE( check_point.is_spilled() );
+      EXPECT_LT( 0u, check_point.get_byte_size() );
+
+      // Spilling again reuses the file, and restoring without prefetching reads it on demand
+      ASSERT_TRUE( check_point.spill( directory ) );
+      EXPECT_EQ( 1u, countFiles( directory ) );
+      restored.reset();
+      ASSERT_TRUE( check_point.get_volume( restored ) );
+      expectSameVolume( restored, volumes[ j ] );
+    }
+
+    // The file is removed together with the check point
+    EXPECT_EQ( 0u, countFiles( directory ) );
+  }
+
+  boost::filesystem::remove_all( directory );
+}
+
+TEST( LayerCheckPointTests, SliceRangeRestores )
+{
+  const SliceType slice_types[] = { SliceType::AXIAL_E, SliceType::CORONAL_E, 
+    SliceType::SAGITTAL_E };
+  const DataBlock::index_type start = 5, end = 9;
+
+  for ( size_t t = 0; t < 3; t++ )
+  {
+    std::vector< VolumeHandle > volumes = createVolumes();
+    for ( size_t j = 0; j < volumes.size(); j++ )
+    {
+      SCOPED_TRACE( testing::Message() << "slice type " << t << ", volume " << j );
+      VolumeHandle volume = volumes[ j ];
+      std::vector< char > original = getContents( volume );
+
+      LayerCheckPoint check_point( volume, slice_types[ t ], start, end );
+      EXPECT_FALSE( check_point.is_volume() );
+      EXPECT_FALSE( check_point.compress() );
+
+      // Overwrite the whole volume, only the slices in the check point are restored
+      if ( volume->get_type() == VolumeType::MASK_E )
+      {
+        MaskDataBlockHandle mask = boost::dynamic_pointer_cast< MaskVolume >( volume )->
+          get_mask_data_block();
+        for ( size_t i = 0; i < mask->get_size(); i++ ) mask->clear_mask_at( i );
+      }
+      else
+      {
+        DataBlockHandle data_block = boost::dynamic_pointer_cast< DataVolume >( volume )->
+          get_data_block();
+        std::memset( data_block->get_data(), 0, data_block->get_byte_size() );
+      }
+      std::vector< char > cleared = getContents( volume );
+
+      ASSERT_TRUE( check_point.apply_slices( volume ) );
+      std::vector< char > restored = getContents( volume );
+
+      size_t element_size = restored.size() / ( NX_C * NY_C * NZ_C );
+      size_t num_wrong = 0;
+      for ( size_t z = 0; z < NZ_C; z++ )
+        for ( size_t y = 0; y < NY_C; y++ )
+          for ( size_t x = 0; x < NX_C; x++ )
+          {
+            size_t index = t == 0 ? z : ( t == 1 ? y : x );
+            bool inside = index >= static_cast< size_t >( start ) && 
+              index <= static_cast< size_t >( end );
+            const std::vector< char >& expected = inside ? original : cleared;
+            size_t offset = ( ( z * NY_C + y ) * NX_C + x ) * element_size;
+            if ( std::memcmp( &restored[ offset ], &expected[ offset ], element_size ) != 0 ) 
+            {
+              num_wrong++;
+            }
+          }
+      EXPECT_EQ( 0u, num_wrong );
+    }
+  }
+}
@@ -84,6 +84,7 @@ bool ActionExportIsosurface::validate( Core::ActionContextHandle& context )
           (extension == ".val") ||
           (extension == ".stl") ||
           (extension == ".obj") ||
+          (extension == ".ply") ||
           (extension == ".vtk") ) )
   {
     std::ostringstream error;
@@ -132,6 +133,10 @@ bool ActionExportIsosurface::run( Core::ActionContextHandle& context, Core::Acti
       mask_layer->get_isosurface()->export_stl_ascii_isosurface( filename_and_path, this->name_ );
     }
   }
+  else if (extension == ".ply")
+  {
+    mask_layer->get_isosurface()->export_ply_isosurface( filename_and_path );
+  }
   else if(extension == ".obj")
   {
     mask_layer->get_isosurface()->export_obj_isosurface( filename_and_path );
@@ -27,6 +27,7 @@
 */
 
 // Boost includes
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 
 #include <sstream>
@@ -181,11 +182,15 @@ bool ActionImportSeries::run( Core::ActionContextHandle& context, Core::ActionRe
   std::ostringstream message;
   message << "Importing file series from '" << file_path.filename().string() << "'";
   Core::ActionProgressHandle progress;
+  boost::signals2::scoped_connection progress_connection;
 
   // Progress reporting is only needed if not running in a sandbox
   if ( this->sandbox_ == -1 )
   {
-    progress.reset( new Core::ActionProgress( message.str() ) );
+    progress.reset( new Core::ActionProgress( message.str(), false,
+      this->layer_importer_->has_progress_updates() ) );
+    progress_connection = this->layer_importer_->update_progress_signal_.connect( 
+      boost::bind( &Core::ActionProgress::set_progress, progress, _1 ) );
     // Indicate that we have started the process
     progress->begin_progress_reporting();
   }
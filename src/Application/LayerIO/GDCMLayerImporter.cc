@@ -34,6 +34,9 @@
 // STL includes
 #include <limits>
 
+// Boost includes
+#include <boost/bind.hpp>
+
 // GDCM Includes
 #include <gdcmImageReader.h>
 #include <gdcmImageHelper.h>
@@ -51,6 +54,7 @@
 // Application includes
 #include <Application/LayerIO/GDCMLayerImporter.h>
 #include <Application/LayerIO/LayerIO.h>
+#include <Application/LayerIO/SliceSeriesReader.h>
 
 SEG3D_REGISTER_IMPORTER( Seg3D, GDCMLayerImporter );
 
@@ -91,7 +95,10 @@ public:
   bool read_data();
 
   // READ_IMAGE
-  bool read_image( const std::string& filename, char* buffer );
+  // Read the image with the given index into data. This function is called in parallel by
+  // SliceSeriesReader, hence errors are returned instead of set on the importer.
+  bool read_image( const std::vector< std::string >& filenames, char* data, size_t index,
+    std::vector< char >& buffer, std::string& error );
 
 
 public:
@@ -360,13 +367,15 @@ bool GDCMLayerImporterPrivate::read_data()
   char* data = reinterpret_cast< char* >( this->data_block_->get_data() );
   std::vector<std::string> filenames = this->importer_->get_filenames();
 
-  for ( size_t i = 0; i < filenames.size(); i++ )
+  // Decode the slices in parallel straight into the data block
+  std::string error;
+  if ( !SliceSeriesReader::Read( filenames.size(), boost::bind( 
+    &GDCMLayerImporterPrivate::read_image, this, boost::cref( filenames ), data, _1, _2, _3 ),
+    boost::ref( this->importer_->update_progress_signal_ ), error ) )
   {
-    if ( !this->read_image( filenames[ i ], data + this->slice_data_size_ * i ) )
-    {
-      this->data_block_.reset();
-      return false;
-    }
+    this->importer_->set_error( error );
+    this->data_block_.reset();
+    return false;
   }
 
   if ( filenames.size() )
@@ -380,52 +389,63 @@ bool GDCMLayerImporterPrivate::read_data()
   return true;
 }
 
-bool GDCMLayerImporterPrivate::read_image( const std::string& filename, char* buffer )
+bool GDCMLayerImporterPrivate::read_image( const std::vector< std::string >& filenames,
+  char* data, size_t index, std::vector< char >& buffer, std::string& error )
 {
+  const std::string& filename = filenames[ index ];
+  char* destination = data + this->slice_data_size_ * index;
+
   gdcm::ImageReader reader;
   reader.SetFileName( filename.c_str() );
 
   if ( !reader.Read() )
   {
-    this->importer_->set_error( "Failed to read file '" + filename + "'" );
+    error = "Failed to read file '" + filename + "'";
     return false;
   }
 
   gdcm::Image& image = reader.GetImage();
   if ( this->buffer_length_ != image.GetBufferLength() )
   {
-    this->importer_->set_error( "Images in the series have different sizes" );
+    error = "Images in the series have different sizes";
     return false;
   }
 
-  image.GetBuffer( buffer );
   const gdcm::PixelFormat& pixeltype = image.GetPixelFormat();
-  if ( pixeltype == gdcm::PixelFormat::UINT12 )
+  bool unpack = ( pixeltype == gdcm::PixelFormat::UINT12 );
+  bool rescale = ( this->rescale_slope_ != 1.0 || this->rescale_intercept_ != 0.0 );
+
+  if ( unpack && rescale )
   {
-    if ( this->rescale_slope_ != 1.0 || this->rescale_intercept_ != 0.0 )
-    {
-      this->importer_->set_error( "Unsupported data format" );
-      return false;
-    }
+    error = "Unsupported data format";
+    return false;
+  }
 
-    std::vector< char > copy( this->buffer_length_ );
-    memcpy( &copy[ 0 ], buffer, this->buffer_length_ );
-    if ( !gdcm::Unpacker12Bits::Unpack( buffer, &copy[ 0 ], this->buffer_length_ ) )
+  if ( !unpack && !rescale )
+  {
+    image.GetBuffer( destination );
+    return true;
+  }
+
+  // Decode into the scratch buffer of this thread and convert straight into the data block
+  buffer.resize( this->buffer_length_ );
+  image.GetBuffer( &buffer[ 0 ] );
+
+  if ( unpack )
+  {
+    if ( !gdcm::Unpacker12Bits::Unpack( destination, &buffer[ 0 ], this->buffer_length_ ) )
     {
-      this->importer_->set_error( "Failed to unpack 12bit data" );
+      error = "Failed to unpack 12bit data";
       return false;
     }
   }
-
-  if ( this->rescale_slope_ != 1.0 || this->rescale_intercept_ != 0.0 )
+  else
   {
     gdcm::Rescaler rescaler;
     rescaler.SetIntercept( this->rescale_intercept_ );
     rescaler.SetSlope( this->rescale_slope_ );
     rescaler.SetPixelFormat( pixeltype );
-    std::vector< char > copy( this->buffer_length_ );
-    memcpy( &copy[ 0 ], buffer, this->buffer_length_ );
-    rescaler.Rescale( buffer, &copy[ 0 ], this->buffer_length_ );
+    rescaler.Rescale( destination, &buffer[ 0 ], this->buffer_length_ );
   }
 
   return true;
@@ -445,6 +465,11 @@ GDCMLayerImporter::~GDCMLayerImporter()
 {
 }
 
+bool GDCMLayerImporter::has_progress_updates() const
+{
+  return true;
+}
+
 void GDCMLayerImporter::set_dicom_swap_xyspacing_hint( bool swap_xy_spacing )
 {
   this->private_->swap_xy_spacing_ = swap_xy_spacing;
@@ -66,6 +66,10 @@ public:
   /// NOTE: The information is generated again, so that hints can be processed
   virtual bool get_file_data( LayerImporterFileDataHandle& data );
   
+  /// HAS_PROGRESS_UPDATES:
+  /// The slices are read in parallel and progress is reported while reading
+  virtual bool has_progress_updates() const;
+
   // -- Addional hints to compensate for file formats where user input is needed --
 public:
   /// SET_DICOM_SWAP_XYSPACING_HINT
@@ -389,15 +389,22 @@ bool ITKMaskLayerExporter::export_layer_internal( const std::string& mode,
                                                                 temp_mask->get_mask_volume()->get_nz(),
                                                                 this->pixel_type_ );
 
-    data_block->clear();
-    Core::MaskDataBlockManager::Inscribe( temp_mask->get_mask_volume()->get_mask_data_block(), data_block,
-                                          static_cast<double>( this->label_values_[ 0 ] ), true );
-
+    // Step 3: Write the labels of all masks in a single pass. Voxels outside of the masks get
+    // the background value, where masks overlap the last one wins.
+    std::vector< Core::MaskDataBlockHandle > mask_blocks;
+    std::vector< double > labels;
     for ( size_t j = 1; j < this->layers_.size(); j++ )
     {
       MaskLayer* mask = dynamic_cast< MaskLayer* >( this->layers_[ j ].get() );
-      Core::MaskDataBlockManager::Inscribe( mask->get_mask_volume()->get_mask_data_block(), data_block,
-                                            static_cast<double>( this->label_values_[ j ] ) );
+      mask_blocks.push_back( mask->get_mask_volume()->get_mask_data_block() );
+      labels.push_back( this->label_values_[ j ] );
+    }
+
+    if ( !( Core::MaskDataBlockManager::InscribeLabels( mask_blocks, labels,
+      this->label_values_[ 0 ], data_block ) ) )
+    {
+      CORE_LOG_ERROR( "Failed to combine the masks into a label map." );
+      return false;
     }
 
     Core::DataVolumeHandle volume( new Core::DataVolume( this->layers_[ 1 ]->get_grid_transform(), data_block ) );
@@ -28,6 +28,7 @@
 
 // boost includes
 #include <boost/algorithm/string/case_conv.hpp>
+#include <boost/bind.hpp>
 
 // ITK Includes
 #include <itkRGBPixel.h>
@@ -44,11 +45,13 @@
 // Core includes
 #include <Core/DataBlock/ITKImageData.h>
 #include <Core/DataBlock/ITKDataBlock.h>
+#include <Core/DataBlock/StdDataBlock.h>
 #include <Core/Volume/DataVolume.h>
 #include <Core/Utils/FilesystemUtil.h>
 
 // Application includes
 #include <Application/LayerIO/ITKSeriesLayerImporter.h>
+#include <Application/LayerIO/SliceSeriesReader.h>
 
 SEG3D_REGISTER_IMPORTER( Seg3D, ITKSeriesLayerImporter );
 
@@ -62,7 +65,8 @@ public:
   ITKSeriesLayerImporterPrivate() :
     data_type_( Core::DataType::UCHAR_E ),
     read_header_( false ),
-    read_data_( false )
+    read_data_( false ),
+    single_slice_files_( false )
   {
   }
 
@@ -93,6 +97,13 @@ public:
   template< class ItkImporterType >
   bool import_simple_series();
 
+  // READ_TYPED_SLICE:
+  // Read the slice with the given index into data. This function is called in parallel by
+  // SliceSeriesReader, hence errors are returned instead of set on the importer.
+  template< class DataType, class ItkImporterType >
+  bool read_typed_slice( const std::vector< std::string >& filenames, size_t nx, size_t ny,
+    DataType* data, size_t index, std::vector< char >& buffer, std::string& error );
+
 public:
   // File type that we are importing
   std::string file_type_;
@@ -111,6 +122,10 @@ public:
 
   // Whether the data was read
   bool read_data_;
+
+  // Whether the first file holds a single slice, in which case the slices are read in parallel
+  // and progress is reported
+  bool single_slice_files_;
 };
 
 Core::DataType convert_data_type(itk::CommonEnums::IOComponent type )
@@ -255,6 +270,7 @@ bool ITKSeriesLayerImporterPrivate::scan_simple_series()
   // Store the information we just extracted from the file in this private class
   this->data_type_ = convert_data_type(IO->GetComponentType());
   this->grid_transform_ = image_data->get_grid_transform();
+  this->single_slice_files_ = IO->GetNumberOfDimensions() < 3 || IO->GetDimensions( 2 ) == 1;
 
   this->read_header_ = true;
   return true;
@@ -282,8 +298,58 @@ bool ITKSeriesLayerImporterPrivate::import_simple_typed_series()
   typename ImageIOType::Pointer IO = ImageIOType::New();
 
   // Setup file names and IO
+  std::vector< std::string > filenames = this->importer_->get_filenames();
   reader->SetImageIO( IO );
-  reader->SetFileNames( this->importer_->get_filenames() );
+  reader->SetFileNames( filenames );
+
+  // Only read the information of the series, so the transform is derived by ITK as before
+  try
+  {
+    reader->UpdateOutputInformation();
+  }
+  catch ( itk::ExceptionObject &err )
+  {
+    this->importer_->set_error( err.GetDescription() );
+    return false;
+  }
+  catch ( ... )
+  {
+    this->importer_->set_error( "ITK crashed while reading file." );
+    return false;
+  }
+
+  // If each file holds one slice, decode the slices in parallel straight into a data block
+  typename ImageType::Pointer output = reader->GetOutput();
+  typename ImageType::SizeType size = output->GetLargestPossibleRegion().GetSize();
+  if ( this->single_slice_files_ && size[ 2 ] == filenames.size() )
+  {
+    // NOTE: The wrapper reads the size from the buffered region, no data is allocated here
+    output->SetBufferedRegion( output->GetLargestPossibleRegion() );
+    this->grid_transform_ = Core::ITKImageDataT< DataType >( output ).get_grid_transform();
+
+    Core::DataBlockHandle data_block = Core::StdDataBlock::New( this->grid_transform_, 
+      this->data_type_ );
+    if ( !data_block )
+    {
+      this->importer_->set_error( "Could not allocate enough memory to read the series." );
+      return false;
+    }
+
+    std::string error;
+    if ( !SliceSeriesReader::Read( filenames.size(), boost::bind( 
+      &ITKSeriesLayerImporterPrivate::read_typed_slice< DataType, ItkImporterType >, this, 
+      boost::cref( filenames ), size[ 0 ], size[ 1 ], 
+      reinterpret_cast< DataType* >( data_block->get_data() ), _1, _2, _3 ),
+      boost::ref( this->importer_->update_progress_signal_ ), error ) )
+    {
+      this->importer_->set_error( error );
+      return false;
+    }
+
+    this->data_block_ = data_block;
+    this->read_data_ = true;
+    return true;
+  }
 
   try
   {
@@ -328,6 +394,50 @@ bool ITKSeriesLayerImporterPrivate::import_simple_typed_series()
   return false;
 }
 
+template< class DataType, class ItkImporterType >
+bool ITKSeriesLayerImporterPrivate::read_typed_slice( const std::vector< std::string >& filenames,
+  size_t nx, size_t ny, DataType* data, size_t index, std::vector< char >& /*buffer*/, 
+  std::string& error )
+{
+  typedef itk::Image< DataType, 2 > ImageType;
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  typename ReaderType::Pointer reader = ReaderType::New();
+
+  typedef ItkImporterType ImageIOType;
+  typename ImageIOType::Pointer IO = ImageIOType::New();
+
+  reader->SetImageIO( IO );
+  reader->SetFileName( filenames[ index ] );
+
+  try
+  {
+    reader->Update();
+  }
+  catch ( itk::ExceptionObject &err )
+  {
+    error = err.GetDescription();
+    return false;
+  }
+  catch ( ... )
+  {
+    error = "ITK crashed while reading file.";
+    return false;
+  }
+
+  ImageType* image = reader->GetOutput();
+  typename ImageType::SizeType size = image->GetBufferedRegion().GetSize();
+  if ( size[ 0 ] != nx || size[ 1 ] != ny )
+  {
+    error = "Size mismatch! The size of " + filenames[ index ] + 
+      " does not match the size of " + filenames[ 0 ] + ".";
+    return false;
+  }
+
+  std::copy( image->GetBufferPointer(), image->GetBufferPointer() + nx * ny, 
+    data + index * nx * ny );
+  return true;
+}
+
 template< class ItkImporterType >
 bool ITKSeriesLayerImporterPrivate::import_simple_series()
 {
@@ -408,6 +518,12 @@ ITKSeriesLayerImporter::~ITKSeriesLayerImporter()
 {
 }
 
+bool ITKSeriesLayerImporter::has_progress_updates() const
+{
+  // Only the slices of single slice files are read in parallel, which reports progress
+  return this->private_->read_header_ && this->private_->single_slice_files_;
+}
+
 bool ITKSeriesLayerImporter::get_file_info( LayerImporterFileInfoHandle& info )
 {
   try
@@ -85,6 +85,11 @@ public:
   /// NOTE: The information is generated again, so that hints can be processed
   virtual bool get_file_data( LayerImporterFileDataHandle& data );
 
+  /// HAS_PROGRESS_UPDATES:
+  /// If each file holds a single slice, the slices are read in parallel and progress is
+  /// reported while reading. This is known once the header was read.
+  virtual bool has_progress_updates() const;
+
   // -- internals of the class --
 private:
   ITKSeriesLayerImporterPrivateHandle private_;
@@ -73,6 +73,11 @@ std::string LayerImporter::get_warning() const
   return this->private_->warning_;
 }
 
+bool LayerImporter::has_progress_updates() const
+{
+  return false;
+}
+
 void LayerImporter::set_dicom_swap_xyspacing_hint( bool )
 {
 }
@@ -41,6 +41,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
+#include <boost/signals2/signal.hpp>
 
 // Application includes
 #include <Application/Project/InputFilesImporter.h>
@@ -117,6 +118,19 @@ public:
   /// Set the warning message
   void set_warning( const std::string& warning );
 
+  // -- Progress reporting --
+public:
+  /// HAS_PROGRESS_UPDATES:
+  /// Whether the importer triggers update_progress_signal_ while reading the data
+  virtual bool has_progress_updates() const;
+
+  typedef boost::signals2::signal< void ( double ) > update_progress_signal_type;
+
+  /// UPDATE_PROGRESS_SIGNAL_:
+  /// Triggered while get_file_data reads the data, with the fraction of the data that was read.
+  /// NOTE: This signal may be triggered from any thread.
+  update_progress_signal_type update_progress_signal_;
+
   // -- file_importer_id handling --
 public:
   /// GET_INPUTFILES_ID:
@@ -30,6 +30,7 @@
 
 // Core includes
 #include <Core/DataBlock/NrrdData.h>
+#include <Core/DataBlock/MaskDataBlockManager.h>
 #include <Core/DataBlock/StdDataBlock.h>
 
 // Application includes
@@ -322,31 +323,23 @@ bool MatlabLayerExporter::export_mask_label( const std::string& file_path )
   Core::DataBlockHandle new_data_block = Core::StdDataBlock::New( mask_block->get_nx(),
     mask_block->get_ny(), mask_block->get_nz(), Core::DataType::UCHAR_E );
 
-  // Step 3: Get the value the user set for the background and preset the contents of our new
-  // datablock to that value
-  for( size_t i = 0; i < mask_block->get_size(); ++i )
+  // Step 3: Write the value of each MaskLayer into our new DataBlock, in a single pass over all
+  // the masks. Voxels outside of the masks get the value the user set for the background, where
+  // masks overlap the last MaskLayer wins.
+  std::vector< Core::MaskDataBlockHandle > mask_blocks;
+  std::vector< double > labels;
+  for ( size_t i = 1; i < this->layers_.size(); ++i )
   {
-    new_data_block->set_data_at( i, this->label_values_[ 0 ] );
+    layer = dynamic_cast< MaskLayer* >( this->layers_[ i ].get() );
+    mask_blocks.push_back( layer->get_mask_volume()->get_mask_data_block() );
+    labels.push_back( this->label_values_[ i ] );
   }
 
-  // Step 4: Loop through all the MaskLayers and insert their values into our new DataBlock
-  std::vector< MaskLayer* >  mask_layers;
-  for( int i = 1; i < static_cast< int >( this->layers_.size() ); ++i )
+  if ( !( Core::MaskDataBlockManager::InscribeLabels( mask_blocks, labels, 
+    this->label_values_[ 0 ], new_data_block ) ) )
   {
-    layer = dynamic_cast< MaskLayer* >( this->layers_[ i ].get() );
-    mask_block = layer->get_mask_volume()->get_mask_data_block();
-
-    Core::DataBlock::shared_lock_type lock( mask_block->get_mutex() );
-
-    for( size_t j = 0; j < mask_block->get_size(); ++j )
-    {
-      if( mask_block->get_mask_at( j ) )
-      {
-        new_data_block->set_data_at( j, this->label_values_[ i ] );
-      }
-    }
-
-    lock.unlock();
+    CORE_LOG_ERROR( "Failed to combine the masks into a label map." );
+    return false;
   }
 
   MatlabIO::matlabarray mldata;
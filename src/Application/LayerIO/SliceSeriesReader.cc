@@ -0,0 +1,154 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+#include <limits>
+
+// Boost includes
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Core includes
+#include <Core/Utils/ThreadPool.h>
+
+// Application includes
+#include <Application/LayerIO/SliceSeriesReader.h>
+
+namespace Seg3D
+{
+
+const size_t SliceSeriesReader::MAX_OUTSTANDING_READS_C = 8;
+
+class SliceSeriesReaderPrivate : public boost::noncopyable
+{
+public:
+  SliceSeriesReaderPrivate() :
+    num_slices_( 0 ),
+    next_slice_( 0 ),
+    failed_slice_( std::numeric_limits< size_t >::max() ),
+    num_read_( 0 ),
+    last_percentage_( 0 )
+  {
+  }
+
+  // RUN_WORKER:
+  // Read slices until all slices have been claimed
+  void run_worker();
+
+  size_t num_slices_;
+  SliceSeriesReader::read_function_type read_slice_;
+  SliceSeriesReader::progress_function_type progress_;
+
+  boost::mutex mutex_;
+
+  // Next slice that needs to be read
+  size_t next_slice_;
+
+  // First slice that failed to read and its error
+  size_t failed_slice_;
+  std::string error_;
+
+  // Number of slices read so far and the last progress that was reported
+  size_t num_read_;
+  size_t last_percentage_;
+};
+
+void SliceSeriesReaderPrivate::run_worker()
+{
+  std::vector< char > buffer;
+
+  while ( true )
+  {
+    size_t slice;
+    {
+      boost::mutex::scoped_lock lock( this->mutex_ );
+      // Slices after a failed slice do not need to be read
+      if ( this->next_slice_ >= this->num_slices_ || 
+        this->next_slice_ > this->failed_slice_ ) return;
+      slice = this->next_slice_++;
+    }
+
+    std::string error;
+    bool success = false;
+    try
+    {
+      success = this->read_slice_( slice, buffer, error );
+    }
+    catch ( ... )
+    {
+      error = "Importer crashed when reading file.";
+    }
+
+    boost::mutex::scoped_lock lock( this->mutex_ );
+    if ( !success && slice < this->failed_slice_ )
+    {
+      this->failed_slice_ = slice;
+      this->error_ = error;
+    }
+
+    this->num_read_++;
+    size_t percentage = ( 100 * this->num_read_ ) / this->num_slices_;
+    if ( this->progress_ && percentage > this->last_percentage_ )
+    {
+      this->last_percentage_ = percentage;
+      this->progress_( static_cast< double >( percentage ) / 100.0 );
+    }
+  }
+}
+
+bool SliceSeriesReader::Read( size_t num_slices, read_function_type read_slice,
+  progress_function_type progress, std::string& error )
+{
+  SliceSeriesReaderPrivate reader;
+  reader.num_slices_ = num_slices;
+  reader.read_slice_ = read_slice;
+  reader.progress_ = progress;
+
+  size_t num_workers = std::min( std::min( MAX_OUTSTANDING_READS_C, num_slices ), 
+    static_cast< size_t >( Core::ThreadPool::Instance()->get_concurrency() ) );
+
+  {
+    Core::TaskGroup workers;
+    for ( size_t j = 0; j < num_workers; j++ )
+    {
+      workers.run( boost::bind( &SliceSeriesReaderPrivate::run_worker, &reader ) );
+    }
+    workers.wait();
+  }
+
+  if ( reader.failed_slice_ < num_slices )
+  {
+    error = reader.error_;
+    return false;
+  }
+
+  return true;
+}
+
+} // end namespace Seg3D
@@ -0,0 +1,80 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef APPLICATION_LAYERIO_SLICESERIESREADER_H
+#define APPLICATION_LAYERIO_SLICESERIESREADER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif 
+
+// STL includes
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+namespace Seg3D
+{
+
+/// CLASS SliceSeriesReader
+/// Helper for importers that read a volume as a series of files. Slices are read and decoded
+/// concurrently on the thread pool, with a bounded number of outstanding reads, so that stacks
+/// on network storage are not limited by a single outstanding request.
+
+class SliceSeriesReader : public boost::noncopyable
+{
+  // -- types --
+public:
+  /// Function that reads slice index into its place in the destination. The buffer is a scratch
+  /// buffer that is reused between the slices read by the same worker. If reading fails the
+  /// function returns false and sets error.
+  typedef boost::function< bool ( size_t, std::vector< char >&, std::string& ) > 
+    read_function_type;
+
+  /// Function that receives the fraction of slices that was read
+  typedef boost::function< void ( double ) > progress_function_type;
+
+  // -- reading --
+public:
+  /// READ:
+  /// Read slices [ 0, num_slices ) in parallel. If slices fail to read, the error of the first
+  /// slice in order is returned, as if the slices had been read one after another. Slices after
+  /// a failed slice are not read.
+  static bool Read( size_t num_slices, read_function_type read_slice, 
+    progress_function_type progress, std::string& error );
+
+  /// Maximum number of slices that are read at the same time
+  const static size_t MAX_OUTSTANDING_READS_C;
+};
+
+} // end namespace Seg3D
+
+#endif
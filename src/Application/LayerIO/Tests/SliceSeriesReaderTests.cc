@@ -0,0 +1,220 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <Core/Utils/ThreadPool.h>
+#include <Application/LayerIO/SliceSeriesReader.h>
+
+using namespace Seg3D;
+
+namespace
+{
+
+// Stub for decoding a slice file, which records the order in which the slices are stored and
+// how many slices are decoded at the same time
+class SliceDecoder
+{
+public:
+  explicit SliceDecoder( size_t num_slices ) :
+    slices_( num_slices, -1 ),
+    slow_slice_( num_slices ),
+    num_active_( 0 ),
+    max_active_( 0 ),
+    num_read_( 0 )
+  {
+  }
+
+  bool read( size_t slice, std::vector< char >& buffer, std::string& error )
+  {
+    {
+      boost::mutex::scoped_lock lock( this->mutex_ );
+      this->num_active_++;
+      this->max_active_ = std::max( this->max_active_, this->num_active_ );
+      this->num_read_++;
+    }
+
+    // Later slices finish first, so slices complete out of order
+    buffer.assign( 64, static_cast< char >( slice ) );
+    boost::this_thread::sleep( boost::posix_time::microseconds( 
+      200 + 50 * ( ( this->slices_.size() - slice ) % 7 ) + this->delay( slice ) ) );
+
+    bool success = std::find( this->failing_slices_.begin(), this->failing_slices_.end(), 
+      slice ) == this->failing_slices_.end();
+    if ( success )
+    {
+      this->slices_[ slice ] = static_cast< int >( slice );
+    }
+    else
+    {
+      error = "Could not read slice " + boost::lexical_cast< std::string >( slice );
+    }
+
+    boost::mutex::scoped_lock lock( this->mutex_ );
+    this->num_active_--;
+    return success;
+  }
+
+  int delay( size_t slice )
+  {
+    return slice == this->slow_slice_ ? 20000 : 0;
+  }
+
+  void progress( double fraction )
+  {
+    this->progress_.push_back( fraction );
+  }
+
+  std::vector< int > slices_;
+  std::vector< size_t > failing_slices_;
+  size_t slow_slice_;
+
+  boost::mutex mutex_;
+  size_t num_active_;
+  size_t max_active_;
+  size_t num_read_;
+  std::vector< double > progress_;
+};
+
+// Restores the concurrency of the thread pool when the test is done
+class SliceSeriesReaderTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    this->concurrency_ = Core::ThreadPool::Instance()->get_concurrency();
+  }
+
+  virtual void TearDown()
+  {
+    Core::ThreadPool::Instance()->set_concurrency( this->concurrency_ );
+  }
+
+  int concurrency_;
+};
+
+bool ReadSlices( SliceDecoder& decoder, std::string& error )
+{
+  return SliceSeriesReader::Read( decoder.slices_.size(), 
+    boost::bind( &SliceDecoder::read, &decoder, _1, _2, _3 ),
+    boost::bind( &SliceDecoder::progress, &decoder, _1 ), error );
+}
+
+}
+
+TEST_F( SliceSeriesReaderTest, SlicesKeepTheirOrder )
+{
+  Core::ThreadPool::Instance()->set_concurrency( 64 );
+  SliceDecoder decoder( 150 );
+  decoder.slow_slice_ = 3;
+
+  std::string error;
+  ASSERT_TRUE( ReadSlices( decoder, error ) ) << error;
+  EXPECT_TRUE( error.empty() );
+  EXPECT_EQ( 150u, decoder.num_read_ );
+  for ( size_t j = 0; j < decoder.slices_.size(); j++ )
+  {
+    ASSERT_EQ( static_cast< int >( j ), decoder.slices_[ j ] );
+  }
+
+  // Progress is only reported when it increases and ends with all the slices read
+  ASSERT_FALSE( decoder.progress_.empty() );
+  for ( size_t j = 1; j < decoder.progress_.size(); j++ )
+  {
+    EXPECT_LT( decoder.progress_[ j - 1 ], decoder.progress_[ j ] );
+  }
+  EXPECT_DOUBLE_EQ( 1.0, decoder.progress_.back() );
+}
+
+TEST_F( SliceSeriesReaderTest, ReportsFirstFailingSlice )
+{
+  Core::ThreadPool::Instance()->set_concurrency( 64 );
+  SliceDecoder decoder( 200 );
+  // The first failing slice is slow, so a later slice fails before it is done
+  decoder.failing_slices_.push_back( 40 );
+  decoder.failing_slices_.push_back( 45 );
+  decoder.failing_slices_.push_back( 120 );
+  decoder.slow_slice_ = 40;
+
+  std::string error;
+  EXPECT_FALSE( ReadSlices( decoder, error ) );
+  EXPECT_EQ( "Could not read slice 40", error );
+
+  // Slices after a failed slice are not read, except the ones that were already started
+  EXPECT_GE( 45u + SliceSeriesReader::MAX_OUTSTANDING_READS_C, decoder.num_read_ );
+  for ( size_t j = 0; j < 40; j++ )
+  {
+    ASSERT_EQ( static_cast< int >( j ), decoder.slices_[ j ] );
+  }
+
+  // Without the slow slice the result is the same
+  SliceDecoder fast_decoder( 200 );
+  fast_decoder.failing_slices_ = decoder.failing_slices_;
+  fast_decoder.slow_slice_ = 45;
+  EXPECT_FALSE( ReadSlices( fast_decoder, error ) );
+  EXPECT_EQ( "Could not read slice 40", error );
+}
+
+TEST_F( SliceSeriesReaderTest, CapsOutstandingReads )
+{
+  Core::ThreadPool::Instance()->set_concurrency( 64 );
+  size_t concurrency = static_cast< size_t >( Core::ThreadPool::Instance()->get_concurrency() );
+  SliceDecoder decoder( 120 );
+  decoder.slow_slice_ = 0;
+
+  std::string error;
+  ASSERT_TRUE( ReadSlices( decoder, error ) ) << error;
+  EXPECT_GE( std::min( SliceSeriesReader::MAX_OUTSTANDING_READS_C, concurrency ), 
+    decoder.max_active_ );
+  if ( concurrency > 1 )
+  {
+    EXPECT_LT( 1u, decoder.max_active_ );
+  }
+
+  // The concurrency of the thread pool caps the reads as well
+  Core::ThreadPool::Instance()->set_concurrency( 2 );
+  SliceDecoder limited_decoder( 60 );
+  limited_decoder.slow_slice_ = 0;
+  ASSERT_TRUE( ReadSlices( limited_decoder, error ) ) << error;
+  EXPECT_GE( 2u, limited_decoder.max_active_ );
+
+  // Fewer slices than workers
+  SliceDecoder small_decoder( 1 );
+  ASSERT_TRUE( ReadSlices( small_decoder, error ) ) << error;
+  EXPECT_EQ( 0, small_decoder.slices_[ 0 ] );
+  EXPECT_EQ( 1u, small_decoder.max_active_ );
+}
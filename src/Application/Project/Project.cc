@@ -37,6 +37,8 @@
 #include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
 
 // Core includes
 #include <Core/Application/Application.h>
@@ -45,6 +47,7 @@
 #include <Core/Utils/FilesystemUtil.h>
 #include <Core/Utils/StringUtil.h>
 #include <Core/Utils/Log.h>
+#include <Core/Utils/ThreadPool.h>
 #include <Core/DataBlock/DataBlockManager.h>
 
 // Application includes
@@ -52,6 +55,7 @@
 #include <Application/Provenance/Provenance.h>
 #include <Application/PreferencesManager/PreferencesManager.h>
 #include <Application/DatabaseManager/DatabaseManager.h>
+#include <Application/Project/ProvenanceWriter.h>
 #include <Application/Layer/Layer.h>
 #include <Application/Layer/LayerManager.h>
 
@@ -84,8 +88,16 @@ public:
     project_( 0 ),
     changed_( false ),
     last_saved_session_time_stamp_( boost::posix_time::second_clock::local_time() ),
-    need_anonymize_( false )
+    need_anonymize_( false ),
+    data_save_failed_( false )
   {
+    this->provenance_writer_.reset( new ProvenanceWriter( this->provenance_database_ ) );
+  }
+
+  ~ProjectPrivate()
+  {
+    // Write the remaining provenance records before the database goes away
+    this->provenance_writer_.reset();
   }
 
 public:
@@ -212,16 +224,6 @@ public:
   // NOTE: This function can only can called from the application thread.
   void set_project_changed( Core::ActionHandle action, Core::ActionResultHandle result );
 
-  // GET_USER_ID:
-  // Get the user_id of the given user_name in the provenance database.
-  // If the user_name doesn't exist yet, it will be inserted into the database.
-  long long get_user_id( const std::string& user_name );
-
-  // GET_ACTION_ID:
-  // Get the action_id of the given action_name in the provenance database.
-  // If the action_name doesn't exist yet, it will be inserted into the database.
-  long long get_action_id( const std::string& action_name );
-
   // GET_USER_NAME:
   // Get the user name identified by the given ID.
   bool get_user_name( long long user_id, std::string& user_name );
@@ -230,6 +232,19 @@ public:
   // Get the action name identified by the given ID.
   bool get_action_name( long long action_id, std::string& action_name );
 
+  // RUN_DATA_SAVE:
+  // Run a data save task that was scheduled by schedule_data_save and record whether it failed.
+  void run_data_save( boost::function< bool () > task );
+
+  // EXECUTE_DATA_SAVE:
+  // Run a data save task and return whether it succeeded.
+  static bool ExecuteDataSave( boost::function< bool () > task );
+
+  // WAIT_FOR_DATA_SAVES:
+  // Wait for all the data save tasks of the current session save. Returns false if one of them
+  // failed.
+  bool wait_for_data_saves();
+
   // -- internal variables --
 public:
   // Pointer back to the project
@@ -255,6 +270,9 @@ public:
   // The database that contains the provenance information
   DatabaseManager provenance_database_;
 
+  // Queues the provenance records and writes them into the provenance database
+  ProvenanceWriterHandle provenance_writer_;
+
   // The database that contains  the project notes.
   DatabaseManager note_database_;
 
@@ -270,6 +288,14 @@ public:
   // Whether data needs to be anonymized on the next save
   bool need_anonymize_;
 
+  // Data files of the session that is being saved, these are written in parallel
+  boost::shared_ptr< Core::TaskGroup > data_save_tasks_;
+  // NOTE: Masks that share a data block have the same generation and hence the same data file,
+  // which must only be written once.
+  std::set< std::string > data_save_files_;
+  bool data_save_failed_;
+  boost::mutex data_save_mutex_;
+
   // -- static helper functions --
 public:
   // UPDATE_PROJECT_DIRECTORY:
@@ -278,6 +304,43 @@ public:
 };
 
 
+bool ProjectPrivate::ExecuteDataSave( boost::function< bool () > task )
+{
+  try
+  {
+    return task();
+  }
+  catch ( ... )
+  {
+    CORE_LOG_ERROR( "Failed to write a data file of the session." );
+  }
+  return false;
+}
+
+void ProjectPrivate::run_data_save( boost::function< bool () > task )
+{
+  if ( !ProjectPrivate::ExecuteDataSave( task ) )
+  {
+    boost::mutex::scoped_lock lock( this->data_save_mutex_ );
+    this->data_save_failed_ = true;
+  }
+}
+
+bool ProjectPrivate::wait_for_data_saves()
+{
+  if ( this->data_save_tasks_ )
+  {
+    this->data_save_tasks_->wait();
+    this->data_save_tasks_.reset();
+  }
+  this->data_save_files_.clear();
+
+  boost::mutex::scoped_lock lock( this->data_save_mutex_ );
+  bool success = !this->data_save_failed_;
+  this->data_save_failed_ = false;
+  return success;
+}
+
 void ProjectPrivate::update_project_size()
 {
   // Get the directory that we need scan
@@ -460,6 +523,36 @@ bool ProjectPrivate::clean_up_session_database()
   return true;
 }
 
+// SAVEDATABASE:
+// Save the database into the project and keep working on the saved file, so later changes
+// go straight to disk and the next save only needs to checkpoint the database.
+// If the saved file cannot be opened in place, the database stays in memory.
+static bool SaveDatabase( DatabaseManager& database, const boost::filesystem::path& database_file,
+  std::string& error )
+{
+  if ( !database.save_database( database_file, error ) ) return false;
+  if ( database.get_database_file() == database_file ) return true;
+
+  std::string open_error;
+  if ( !database.open_database( database_file, open_error ) )
+  {
+    CORE_LOG_WARNING( open_error );
+  }
+  return true;
+}
+
+// OPENDATABASE:
+// Open a database of the project in place. If the file cannot be switched to write-ahead 
+// logging, e.g. on a read-only or network file system, it is loaded into memory instead.
+static bool OpenDatabase( DatabaseManager& database, const boost::filesystem::path& database_file,
+  std::string& error )
+{
+  if ( database.open_database( database_file, error ) ) return true;
+
+  CORE_LOG_WARNING( error );
+  return database.load_database( database_file, error );
+}
+
 bool ProjectPrivate::save_state( const boost::filesystem::path& project_directory )
 {
   if ( ! boost::filesystem::exists( project_directory ) )
@@ -499,25 +592,29 @@ bool ProjectPrivate::save_state( const boost::filesystem::path& project_director
   // Save the session database to disk
   boost::filesystem::path session_database = project_directory /
     DATABASE_DIR_C / SESSION_DATABASE_C;
-  if ( !this->session_database_.save_database( session_database, error ) )
+  if ( !SaveDatabase( this->session_database_, session_database, error ) )
   {
     CORE_LOG_ERROR( error );
     return false;
   }
 
-  // Save the provenance database to disk
+  // Save the provenance database to disk, including the records that are still queued
   boost::filesystem::path provenance_database = project_directory /
     DATABASE_DIR_C / PROVENANCE_DATABASE_C;
-  if ( !this->provenance_database_.save_database( provenance_database, error ) )
   {
-    CORE_LOG_ERROR( error );
-    return false;
+    ProvenanceWriter::lock_type lock( this->provenance_writer_->get_mutex() );
+    this->provenance_writer_->flush();
+    if ( !SaveDatabase( this->provenance_database_, provenance_database, error ) )
+    {
+      CORE_LOG_ERROR( error );
+      return false;
+    }
   }
 
   // Save the note database to disk
   boost::filesystem::path note_database = project_directory /
     DATABASE_DIR_C / NOTE_DATABASE_C;
-  if ( !this->note_database_.save_database( note_database, error ) )
+  if ( !SaveDatabase( this->note_database_, note_database, error ) )
   {
     CORE_LOG_ERROR( error );
     return false;
@@ -696,6 +793,8 @@ bool ProjectPrivate::initialize_provenance_database()
   sql_statements += "INSERT INTO database_version VALUES (1);";
 
   std::string error;
+  ProvenanceWriter::lock_type lock( this->provenance_writer_->get_mutex() );
+  this->provenance_writer_->reset();
   if ( !this->provenance_database_.run_sql_script( sql_statements, error ) )
   {
     CORE_LOG_ERROR( "Failed to initialize the provenance database: " + error );
@@ -734,10 +833,14 @@ bool ProjectPrivate::clear_provenance_database()
   sql_statements += "DELETE FROM provenance_inputfiles_cache;";
 
   std::string error;
-  if ( !this->provenance_database_.run_sql_script( sql_statements, error ) )
   {
-    CORE_LOG_ERROR( "Failed to clear the provenance database: " + error );
-    return false;
+    ProvenanceWriter::lock_type lock( this->provenance_writer_->get_mutex() );
+    this->provenance_writer_->reset();
+    if ( !this->provenance_database_.run_sql_script( sql_statements, error ) )
+    {
+      CORE_LOG_ERROR( "Failed to clear the provenance database: " + error );
+      return false;
+    }
   }
 
   // Let the GUI know that provenance has changed
@@ -821,6 +924,10 @@ bool ProjectPrivate::query_provenance_trail( const std::vector< ProvenanceID >&
 {
   if ( prov_ids.size() == 0 ) return false;
 
+  // Make sure the queued provenance records are part of the query
+  ProvenanceWriter::lock_type lock( this->provenance_writer_->get_mutex() );
+  this->provenance_writer_->flush();
+
   // Get all the provenance steps that lead to the provenance ID
   std::set< ProvenanceStepID > prov_steps;
   this->get_provenance_steps( prov_ids, prov_steps );
@@ -1527,6 +1634,10 @@ bool ProjectPrivate::get_session_file( SessionID session_id, boost::filesystem::
 void ProjectPrivate::get_provenance_steps( const std::vector< ProvenanceID >& prov_ids,
                       std::set< ProvenanceStepID >& prov_steps )
 {
+  // Make sure the queued provenance records are part of the query
+  ProvenanceWriter::lock_type lock( this->provenance_writer_->get_mutex() );
+  this->provenance_writer_->flush();
+
   typedef std::queue< ProvenanceID > prov_id_queue_type;
   void ( prov_id_queue_type::*push_queue_func )( const ProvenanceID& ) = &prov_id_queue_type::push;
   prov_id_queue_type provenance_queue;
@@ -1593,60 +1704,6 @@ void ProjectPrivate::set_project_changed( Core::ActionHandle action, Core::Actio
   }
 }
 
-long long ProjectPrivate::get_user_id( const std::string& user_name )
-{
-  std::string sql_str = "SELECT user_id FROM user WHERE user_name = '" +
-    DatabaseManager::EscapeQuotes( user_name ) + "';";
-  std::string error;
-  ResultSet results;
-  if ( !this->provenance_database_.run_sql_statement( sql_str, results, error ) )
-  {
-    CORE_LOG_ERROR( error );
-    return -1;
-  }
-
-  if ( results.size() > 0 )
-  {
-    return boost::any_cast< long long >( results[ 0 ][ "user_id" ] );
-  }
-
-  sql_str = "INSERT INTO user (user_name) VALUES('" +
-    DatabaseManager::EscapeQuotes( user_name ) + "');";
-  if ( !this->provenance_database_.run_sql_statement( sql_str, error ) )
-  {
-    CORE_LOG_ERROR( error );
-    return -1;
-  }
-
-  return this->provenance_database_.get_last_insert_rowid();
-}
-
-long long ProjectPrivate::get_action_id( const std::string& action_name )
-{
-  std::string sql_str = "SELECT action_id FROM action WHERE action_name = '" + action_name + "';";
-  std::string error;
-  ResultSet results;
-  if ( !this->provenance_database_.run_sql_statement( sql_str, results, error ) )
-  {
-    CORE_LOG_ERROR( error );
-    return -1;
-  }
-
-  if ( results.size() > 0 )
-  {
-    return boost::any_cast< long long >( results[ 0 ][ "action_id" ] );
-  }
-
-  sql_str = "INSERT INTO action (action_name) VALUES('" + action_name + "');";
-  if ( !this->provenance_database_.run_sql_statement( sql_str, error ) )
-  {
-    CORE_LOG_ERROR( error );
-    return -1;
-  }
-
-  return this->provenance_database_.get_last_insert_rowid();
-}
-
 bool ProjectPrivate::get_user_name( long long user_id, std::string& user_name )
 {
   std::map< long long, std::string >::iterator it = this->user_name_map_.find( user_id );
@@ -1970,28 +2027,42 @@ bool Project::load_project( const boost::filesystem::path& project_file )
     boost::filesystem::path session_db_file = full_filename.parent_path() /
       DATABASE_DIR_C / SESSION_DATABASE_C;
     std::string error;
-    // If the session database doesn't exist or it's invalid, create an empty one
-    if ( !boost::filesystem::exists( session_db_file ) ||
-      !this->private_->session_database_.load_database( session_db_file, error ) )
+    // If a database doesn't exist, create an empty one
+    if ( !boost::filesystem::exists( session_db_file ) )
     {
       this->private_->initialize_session_database();
     }
+    else if ( !OpenDatabase( this->private_->session_database_, session_db_file, error ) )
+    {
+      CORE_LOG_ERROR( error );
+      return false;
+    }
 
     boost::filesystem::path provenance_db_file = full_filename.parent_path() /
       DATABASE_DIR_C / PROVENANCE_DATABASE_C;
-    if ( !boost::filesystem::exists( provenance_db_file ) ||
-      !this->private_->provenance_database_.load_database( provenance_db_file, error ) )
+    // NOTE: The database is replaced, so the writer needs to forget its cached IDs
+    this->private_->provenance_writer_->reset();
+    if ( !boost::filesystem::exists( provenance_db_file ) )
     {
       this->private_->initialize_provenance_database();
     }
+    else if ( !OpenDatabase( this->private_->provenance_database_, provenance_db_file, error ) )
+    {
+      CORE_LOG_ERROR( error );
+      return false;
+    }
 
     boost::filesystem::path note_db_file = full_filename.parent_path() /
       DATABASE_DIR_C / NOTE_DATABASE_C;
-    if ( !boost::filesystem::exists( note_db_file ) ||
-      !this->private_->note_database_.load_database( note_db_file, error ) )
+    if ( !boost::filesystem::exists( note_db_file ) )
     {
       this->private_->initialize_note_database();
     }
+    else if ( !OpenDatabase( this->private_->note_database_, note_db_file, error ) )
+    {
+      CORE_LOG_ERROR( error );
+      return false;
+    }
   }
 
   // Delete session records from the database that don't have corresponding session files
@@ -2385,6 +2456,8 @@ bool Project::export_project( const boost::filesystem::path& export_path,
 
   // Make copies of the session and provenance databases
   DatabaseManager export_session_db( this->private_->session_database_ );
+  ProvenanceWriter::lock_type provenance_lock( this->private_->provenance_writer_->get_mutex() );
+  this->private_->provenance_writer_->flush();
   DatabaseManager export_prov_db( this->private_->provenance_database_ );
 
   // Delete all the session entries except the one to be exported
@@ -2706,9 +2779,14 @@ bool Project::save_session( const std::string& name )
   this->private_->process_inputfile_importers();
 
   // NOTE: We need to save first before making an entry into the database to be sure it will succeed.
+  // NOTE: Layers schedule their data files to be written in parallel while their states are
+  // saved, the session can only be recorded once all of them are on disk.
   Core::StateIO state_io;
   state_io.initialize();
-  if ( !Core::StateEngine::Instance()->save_states( state_io ) )
+  this->private_->data_save_tasks_.reset( new Core::TaskGroup );
+  bool states_saved = Core::StateEngine::Instance()->save_states( state_io );
+  bool data_saved = this->private_->wait_for_data_saves();
+  if ( !states_saved || !data_saved )
   {
     std::string error = "Could not extract all the session information from the project.";
     CORE_LOG_ERROR( error );
@@ -2937,119 +3015,18 @@ bool Project::is_session( SessionID session_id )
 
 ProvenanceStepID Project::add_provenance_record( const ProvenanceStepHandle& step )
 {
-  long long user_id = this->private_->get_user_id( step->get_username() );
-  long long action_id = this->private_->get_action_id( step->get_action_name() );
-  if ( user_id == -1 || action_id == -1 ) return -1;
-
-  // Make sure action_params is not empty.
-  // NOTE: A non-empty parameter string simplifies the query process
-  std::string action_params = step->get_action_params();
-  if ( action_params.empty() )
-  {
-    action_params = " ";
-  }
-
-  ProvenanceIDList output_list = step->get_output_provenance_ids();
-  ProvenanceIDList input_list = step->get_input_provenance_ids();
-  ProvenanceIDList deleted_list = step->get_replaced_provenance_ids();
-  InputFilesID inputfiles_id = step->get_inputfiles_id();
-
-  std::string sql_str = "INSERT INTO provenance_step (action_id, action_params, user_id)"
-    " VALUES(" + Core::ExportToString( action_id ) + ", '" +
-    DatabaseManager::EscapeQuotes( action_params ) +
-    "', " + Core::ExportToString( user_id ) + ");";
-  std::string error;
-  if ( !this->private_->provenance_database_.run_sql_statement( sql_str, error ) )
-  {
-    CORE_LOG_ERROR( error );
-    return -1;
-  }
-  ProvenanceStepID step_id = this->private_->provenance_database_.get_last_insert_rowid();
-
-  for ( size_t i = 0; i < input_list.size(); ++i )
-  {
-    sql_str = "INSERT INTO provenance_input (prov_step_id,prov_id) VALUES(" + Core::ExportToString( step_id ) + ", " +
-      Core::ExportToString( input_list[ i ] ) + ");";
-    if ( !this->private_->provenance_database_.run_sql_statement( sql_str, error ) )
-    {
-      CORE_LOG_ERROR( error );
-      this->delete_provenance_record( step_id );
-      return -1;
-    }
-  }
-
-  for ( size_t i = 0; i < output_list.size(); ++i )
-  {
-    sql_str = "INSERT INTO provenance_output (prov_step_id,prov_id) VALUES(" + Core::ExportToString( step_id ) + ", " +
-      Core::ExportToString( output_list[ i ] ) + ");";
-    if ( !this->private_->provenance_database_.run_sql_statement( sql_str, error ) )
-    {
-      CORE_LOG_ERROR( error );
-      this->delete_provenance_record( step_id );
-      return -1;
-    }
-  }
-
-  for ( size_t i = 0; i < deleted_list.size(); ++i )
-  {
-    sql_str = "INSERT INTO provenance_replaced (prov_step_id,prov_id) VALUES(" + Core::ExportToString( step_id ) + ", " +
-      Core::ExportToString( deleted_list[ i ] ) + ");";
-    if ( !this->private_->provenance_database_.run_sql_statement( sql_str, error ) )
-    {
-      CORE_LOG_ERROR( error );
-      this->delete_provenance_record( step_id );
-      return -1;
-    }
-  }
-
-  if ( inputfiles_id > -1 )
-  { // If it is a valid ID add it to the table
-    sql_str = "INSERT INTO provenance_inputfiles_cache VALUES (" +
-      Core::ExportToString( step_id ) + ", " + Core::ExportToString( inputfiles_id ) + ");";
-
-    if ( !this->private_->provenance_database_.run_sql_statement( sql_str, error ) )
-    {
-      CORE_LOG_ERROR( error );
-      this->delete_provenance_record( step_id );
-      return -1;
-    }
-  }
-
-  return step_id;
+  return this->private_->provenance_writer_->add_record( step );
 }
 
 bool Project::delete_provenance_record( ProvenanceStepID record_id )
 {
-  std::string sql_str = "DELETE FROM provenance_step WHERE prov_step_id = " +
-    Core::ExportToString( record_id ) + ";";
-  std::string error;
-  if ( !this->private_->provenance_database_.run_sql_statement( sql_str, error ) )
-  {
-    CORE_LOG_ERROR( error );
-    return false;
-  }
+  this->private_->provenance_writer_->delete_record( record_id );
   return true;
 }
 
 void Project::update_provenance_record( ProvenanceStepID record_id, const ProvenanceStepHandle& prov_step )
 {
-  std::string action_params = prov_step->get_action_params();
-
-  // Make sure action_params is not empty.
-  // NOTE: A non-empty parameter string simplifies the query process
-  if ( action_params.empty() )
-  {
-    action_params = " ";
-  }
-
-  std::string sql_str = "UPDATE provenance_step SET action_params = '" +
-    DatabaseManager::EscapeQuotes( action_params ) +
-    "' WHERE prov_step_id = " + Core::ExportToString( record_id ) + ";";
-  std::string error;
-  if ( !this->private_->provenance_database_.run_sql_statement( sql_str, error ) )
-  {
-    CORE_LOG_ERROR( error );
-  }
+  this->private_->provenance_writer_->update_record( record_id, prov_step->get_action_params() );
 }
 
 boost::posix_time::ptime Project::get_last_saved_session_time_stamp() const
@@ -3170,6 +3147,24 @@ void Project::add_generation_number( const long long generation_number )
   this->private_->session_generation_numbers_.insert( generation_number );
 }
 
+bool Project::schedule_data_save( const boost::filesystem::path& data_file, 
+  boost::function< bool () > task )
+{
+  if ( this->private_->data_save_tasks_ )
+  {
+    // The file is already written by another layer
+    if ( !this->private_->data_save_files_.insert( data_file.string() ).second ) return true;
+
+    // NOTE: A failure is reported when save_session waits for the data saves
+    this->private_->data_save_tasks_->run( boost::bind( &ProjectPrivate::run_data_save,
+      this->private_, task ) );
+    return true;
+  }
+
+  // Not part of a session save, hence the result is reported to the caller directly
+  return ProjectPrivate::ExecuteDataSave( task );
+}
+
 bool Project::execute_or_add_inputfiles_importer( const InputFilesImporterHandle& importer )
 {
   // Add the importer to the list
@@ -40,6 +40,7 @@
 // Boost includes
 #include <boost/filesystem/path.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 
 // Core includes
 #include <Core/Action/Action.h>
@@ -295,10 +296,12 @@ public:
 public: 
   /// ADD_PROVENANCE_RECORD:
   /// Add the provenance step to the database and return the ID of the new record.
+  /// NOTE: The record is written asynchronously, the queued records are written at the latest
+  /// when the session is saved or the provenance database is queried.
   ProvenanceStepID add_provenance_record( const ProvenanceStepHandle& step );
 
   /// DELETE_PROVENANCE_RECORD:
-  /// Delete the specified provenance record.
+  /// Delete the specified provenance record. The deletion is queued like new records.
   bool delete_provenance_record( ProvenanceStepID record_id );
 
   /// UPDATE_PROVENANCE_RECORD:
@@ -321,6 +324,14 @@ public:
   /// Tell the project which generation numbers are part of the project
   void add_generation_number( const long long generation_number );
 
+  /// SCHEDULE_DATA_SAVE:
+  /// Write a data file of the session that is being saved on the thread pool. The session is
+  /// only recorded once all the scheduled writes have finished. A data file that is already
+  /// scheduled for the session is not written again. Outside of save_session the task is run
+  /// right away and its result is returned, otherwise failures are reported by save_session.
+  bool schedule_data_save( const boost::filesystem::path& data_file, 
+    boost::function< bool () > task );
+
   //-- input file directory handling --
 public:
   /// Add a file list of files to import to the project and execute if it already resides on
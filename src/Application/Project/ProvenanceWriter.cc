@@ -0,0 +1,446 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+// STL includes
+#include <map>
+#include <vector>
+
+// Boost includes
+#include <boost/any.hpp>
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Core includes
+#include <Core/Utils/Log.h>
+#include <Core/Utils/StringUtil.h>
+#include <Core/Utils/ThreadPool.h>
+
+// Application includes
+#include <Application/DatabaseManager/DatabaseManager.h>
+#include <Application/Project/ProvenanceWriter.h>
+
+namespace Seg3D
+{
+
+// A queued change to the provenance database
+class ProvenanceRecord
+{
+public:
+  enum record_type
+  {
+    ADD_E,
+    UPDATE_E,
+    DELETE_E
+  };
+
+  record_type type_;
+  ProvenanceStepID step_id_;
+  std::string user_name_;
+  std::string action_name_;
+  std::string action_params_;
+  ProvenanceIDList input_ids_;
+  ProvenanceIDList output_ids_;
+  ProvenanceIDList replaced_ids_;
+  InputFilesID inputfiles_id_;
+};
+
+class ProvenanceWriterPrivate : public Core::RecursiveLockable,
+  public boost::enable_shared_from_this< ProvenanceWriterPrivate >
+{
+public:
+  ProvenanceWriterPrivate( DatabaseManager& database ) :
+    database_( database ),
+    next_step_id_( -1 ),
+    write_scheduled_( false )
+  {
+  }
+
+  // QUEUE_RECORD:
+  // Add a record to the queue and schedule a background write if needed.
+  void queue_record( const ProvenanceRecord& record );
+
+  // WRITE_QUEUED_RECORDS:
+  // Write all the records that are in the queue in one transaction. If the transaction fails,
+  // the records are put back in front of the queue.
+  bool write_queued_records();
+
+  // REQUEUE_RECORDS:
+  // Put records that could not be written back in front of the queue, so the next write
+  // retries them in their original order.
+  void requeue_records( std::vector< ProvenanceRecord >& records );
+
+  // WRITE_RECORD:
+  // Write one record into the database.
+  bool write_record( const ProvenanceRecord& record, std::string& error );
+
+  // GET_NAME_ID:
+  // Get the ID of a user or action name, names that do not exist yet are inserted.
+  long long get_name_id( const std::string& table, const std::string& name,
+    std::map< std::string, long long >& cache, std::string& error );
+
+  // GET_NEXT_STEP_ID:
+  // Get the ID the database will assign to the next provenance step.
+  ProvenanceStepID get_next_step_id();
+
+  // The database that is written
+  DatabaseManager& database_;
+
+  // Protects the queue and the step ID counter
+  // NOTE: It is always taken last, after the writer and the database mutexes
+  boost::mutex queue_mutex_;
+
+  // Records that still need to be written
+  std::vector< ProvenanceRecord > queue_;
+
+  // The ID of the next provenance step, -1 if it still needs to be read from the database
+  ProvenanceStepID next_step_id_;
+
+  // Whether a background write has been scheduled
+  bool write_scheduled_;
+
+  // Cached user and action name IDs
+  std::map< std::string, long long > user_ids_;
+  std::map< std::string, long long > action_ids_;
+};
+
+void ProvenanceWriterPrivate::queue_record( const ProvenanceRecord& record )
+{
+  bool schedule_write = false;
+  {
+    boost::mutex::scoped_lock lock( this->queue_mutex_ );
+    this->queue_.push_back( record );
+    schedule_write = !this->write_scheduled_;
+    this->write_scheduled_ = true;
+  }
+
+  // NOTE: Records that are queued while a batch is written are collected in the next batch
+  if ( schedule_write )
+  {
+    Core::ThreadPool::Instance()->start( boost::bind(
+      &ProvenanceWriterPrivate::write_queued_records, this->shared_from_this() ) );
+  }
+}
+
+bool ProvenanceWriterPrivate::write_queued_records()
+{
+  // NOTE: The lock is held while writing, so batches are written in the order they were queued
+  lock_type lock( this->get_mutex() );
+
+  std::vector< ProvenanceRecord > records;
+  {
+    boost::mutex::scoped_lock queue_lock( this->queue_mutex_ );
+    records.swap( this->queue_ );
+    this->write_scheduled_ = false;
+  }
+
+  if ( records.empty() ) return true;
+
+  // NOTE: The database is locked for the whole transaction, so statements of other threads
+  // do not end up in it
+  DatabaseManager::lock_type database_lock( this->database_.get_mutex() );
+
+  std::string error;
+  if ( !this->database_.begin_transaction( error ) )
+  {
+    CORE_LOG_ERROR( error );
+    this->requeue_records( records );
+    return false;
+  }
+
+  bool success = true;
+  for ( size_t j = 0; j < records.size(); ++j )
+  {
+    if ( !this->write_record( records[ j ], error ) )
+    {
+      CORE_LOG_ERROR( error );
+      success = false;
+    }
+  }
+
+  if ( !this->database_.commit_transaction( error ) )
+  {
+    CORE_LOG_ERROR( error );
+    this->database_.rollback_transaction( error );
+
+    // The names that were inserted in this transaction are gone
+    this->user_ids_.clear();
+    this->action_ids_.clear();
+    this->requeue_records( records );
+    return false;
+  }
+
+  return success;
+}
+
+void ProvenanceWriterPrivate::requeue_records( std::vector< ProvenanceRecord >& records )
+{
+  boost::mutex::scoped_lock lock( this->queue_mutex_ );
+  records.insert( records.end(), this->queue_.begin(), this->queue_.end() );
+  this->queue_.swap( records );
+}
+
+bool ProvenanceWriterPrivate::write_record( const ProvenanceRecord& record, std::string& error )
+{
+  std::vector< boost::any > params;
+  params.push_back( boost::any( record.step_id_ ) );
+
+  if ( record.type_ == ProvenanceRecord::DELETE_E )
+  {
+    return this->database_.run_prepared_statement(
+      "DELETE FROM provenance_step WHERE prov_step_id = ?;", params, error );
+  }
+
+  if ( record.type_ == ProvenanceRecord::UPDATE_E )
+  {
+    params.insert( params.begin(), boost::any( record.action_params_ ) );
+    return this->database_.run_prepared_statement(
+      "UPDATE provenance_step SET action_params = ? WHERE prov_step_id = ?;", params, error );
+  }
+
+  long long user_id = this->get_name_id( "user", record.user_name_, this->user_ids_, error );
+  if ( user_id == -1 ) return false;
+  long long action_id = this->get_name_id( "action", record.action_name_, this->action_ids_, error );
+  if ( action_id == -1 ) return false;
+
+  params.push_back( boost::any( action_id ) );
+  params.push_back( boost::any( record.action_params_ ) );
+  params.push_back( boost::any( user_id ) );
+  if ( !this->database_.run_prepared_statement( "INSERT INTO provenance_step "
+    "(prov_step_id, action_id, action_params, user_id) VALUES(?, ?, ?, ?);", params, error ) )
+  {
+    return false;
+  }
+
+  const char* id_list_sql[] =
+  {
+    "INSERT INTO provenance_input (prov_step_id, prov_id) VALUES(?, ?);",
+    "INSERT INTO provenance_output (prov_step_id, prov_id) VALUES(?, ?);",
+    "INSERT INTO provenance_replaced (prov_step_id, prov_id) VALUES(?, ?);"
+  };
+  const ProvenanceIDList* id_lists[] =
+  {
+    &record.input_ids_, &record.output_ids_, &record.replaced_ids_
+  };
+
+  bool success = true;
+  params.resize( 2 );
+  for ( size_t k = 0; k < 3 && success; ++k )
+  {
+    for ( size_t j = 0; j < id_lists[ k ]->size() && success; ++j )
+    {
+      params[ 1 ] = boost::any( ( *id_lists[ k ] )[ j ] );
+      success = this->database_.run_prepared_statement( id_list_sql[ k ], params, error );
+    }
+  }
+
+  // If it is a valid ID add it to the table
+  if ( success && record.inputfiles_id_ > -1 )
+  {
+    params[ 1 ] = boost::any( record.inputfiles_id_ );
+    success = this->database_.run_prepared_statement(
+      "INSERT INTO provenance_inputfiles_cache VALUES (?, ?);", params, error );
+  }
+
+  if ( !success )
+  {
+    // Remove the partial record, the other tables cascade on this one
+    std::string delete_error;
+    params.resize( 1 );
+    this->database_.run_prepared_statement(
+      "DELETE FROM provenance_step WHERE prov_step_id = ?;", params, delete_error );
+  }
+
+  return success;
+}
+
+long long ProvenanceWriterPrivate::get_name_id( const std::string& table,
+  const std::string& name, std::map< std::string, long long >& cache, std::string& error )
+{
+  std::map< std::string, long long >::iterator it = cache.find( name );
+  if ( it != cache.end() ) return it->second;
+
+  std::vector< boost::any > params( 1, boost::any( name ) );
+  ResultSet results;
+  if ( !this->database_.run_prepared_statement( "SELECT " + table + "_id FROM " + table +
+    " WHERE " + table + "_name = ?;", params, results, error ) )
+  {
+    return -1;
+  }
+
+  long long id;
+  if ( results.size() > 0 )
+  {
+    id = boost::any_cast< long long >( results[ 0 ][ table + "_id" ] );
+  }
+  else
+  {
+    if ( !this->database_.run_prepared_statement( "INSERT INTO " + table + " (" + table +
+      "_name) VALUES(?);", params, error ) )
+    {
+      return -1;
+    }
+    id = this->database_.get_last_insert_rowid();
+  }
+
+  cache[ name ] = id;
+  return id;
+}
+
+ProvenanceStepID ProvenanceWriterPrivate::get_next_step_id()
+{
+  // NOTE: provenance_step uses AUTOINCREMENT, hence IDs of deleted steps are never reused and
+  // the next ID follows the largest ID that was ever used.
+  ProvenanceStepID next_id = 1;
+  std::string error;
+  ResultSet results;
+  if ( this->database_.run_sql_statement( "SELECT MAX(prov_step_id) AS max_id "
+    "FROM provenance_step;", results, error ) && results.size() > 0 &&
+    !results[ 0 ][ "max_id" ].empty() )
+  {
+    next_id = std::max( next_id, boost::any_cast< long long >( results[ 0 ][ "max_id" ] ) + 1 );
+  }
+
+  if ( this->database_.run_sql_statement( "SELECT seq FROM sqlite_sequence "
+    "WHERE name = 'provenance_step';", results, error ) && results.size() > 0 &&
+    !results[ 0 ][ "seq" ].empty() )
+  {
+    next_id = std::max( next_id, boost::any_cast< long long >( results[ 0 ][ "seq" ] ) + 1 );
+  }
+
+  return next_id;
+}
+
+//////////////////////////////////////////////////////////
+
+ProvenanceWriter::ProvenanceWriter( DatabaseManager& database ) :
+  private_( new ProvenanceWriterPrivate( database ) )
+{
+}
+
+ProvenanceWriter::~ProvenanceWriter()
+{
+  this->flush();
+}
+
+ProvenanceStepID ProvenanceWriter::add_record( const ProvenanceStepHandle& step )
+{
+  ProvenanceRecord record;
+  record.type_ = ProvenanceRecord::ADD_E;
+  record.user_name_ = step->get_username();
+  record.action_name_ = step->get_action_name();
+  record.action_params_ = step->get_action_params();
+  record.input_ids_ = step->get_input_provenance_ids();
+  record.output_ids_ = step->get_output_provenance_ids();
+  record.replaced_ids_ = step->get_replaced_provenance_ids();
+  record.inputfiles_id_ = step->get_inputfiles_id();
+
+  // Make sure action_params is not empty.
+  // NOTE: A non-empty parameter string simplifies the query process
+  if ( record.action_params_.empty() )
+  {
+    record.action_params_ = " ";
+  }
+
+  bool has_step_id = false;
+  {
+    boost::mutex::scoped_lock lock( this->private_->queue_mutex_ );
+    if ( this->private_->next_step_id_ != -1 )
+    {
+      record.step_id_ = this->private_->next_step_id_++;
+      has_step_id = true;
+    }
+  }
+
+  if ( !has_step_id )
+  {
+    // NOTE: The writer lock keeps records from being written while the next ID is read from
+    // the database. It is taken before the database and queue mutexes, as in
+    // write_queued_records, and the SQL runs without holding the queue mutex.
+    lock_type lock( this->private_->get_mutex() );
+    ProvenanceStepID next_step_id = this->private_->get_next_step_id();
+
+    boost::mutex::scoped_lock queue_lock( this->private_->queue_mutex_ );
+    if ( this->private_->next_step_id_ == -1 )
+    {
+      this->private_->next_step_id_ = next_step_id;
+    }
+    record.step_id_ = this->private_->next_step_id_++;
+  }
+
+  this->private_->queue_record( record );
+  return record.step_id_;
+}
+
+void ProvenanceWriter::update_record( ProvenanceStepID record_id, const std::string& action_params )
+{
+  ProvenanceRecord record;
+  record.type_ = ProvenanceRecord::UPDATE_E;
+  record.step_id_ = record_id;
+  record.action_params_ = action_params.empty() ? std::string( " " ) : action_params;
+  record.inputfiles_id_ = -1;
+  this->private_->queue_record( record );
+}
+
+void ProvenanceWriter::delete_record( ProvenanceStepID record_id )
+{
+  ProvenanceRecord record;
+  record.type_ = ProvenanceRecord::DELETE_E;
+  record.step_id_ = record_id;
+  record.inputfiles_id_ = -1;
+  this->private_->queue_record( record );
+}
+
+bool ProvenanceWriter::flush()
+{
+  return this->private_->write_queued_records();
+}
+
+void ProvenanceWriter::reset()
+{
+  lock_type lock( this->private_->get_mutex() );
+  this->private_->write_queued_records();
+
+  // Records that could not be written belong to the database that is replaced
+  boost::mutex::scoped_lock queue_lock( this->private_->queue_mutex_ );
+  if ( !this->private_->queue_.empty() )
+  {
+    CORE_LOG_ERROR( "Discarding provenance records that could not be written." );
+    this->private_->queue_.clear();
+  }
+  this->private_->next_step_id_ = -1;
+  this->private_->user_ids_.clear();
+  this->private_->action_ids_.clear();
+}
+
+ProvenanceWriter::mutex_type& ProvenanceWriter::get_mutex()
+{
+  return this->private_->get_mutex();
+}
+
+} // end namespace Seg3D
@@ -0,0 +1,118 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef APPLICATION_PROJECT_PROVENANCEWRITER_H
+#define APPLICATION_PROJECT_PROVENANCEWRITER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif
+
+// STL includes
+#include <string>
+
+// Boost includes
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+// Core includes
+#include <Core/Utils/Lockable.h>
+
+// Application includes
+#include <Application/Provenance/ProvenanceStep.h>
+
+namespace Seg3D
+{
+
+// Forward declaration
+class DatabaseManager;
+class ProvenanceWriter;
+class ProvenanceWriterPrivate;
+
+typedef boost::shared_ptr< ProvenanceWriter > ProvenanceWriterHandle;
+typedef boost::shared_ptr< ProvenanceWriterPrivate > ProvenanceWriterPrivateHandle;
+
+// CLASS PROVENANCEWRITER:
+/// Writes provenance records into the provenance database. Records are queued and written
+/// asynchronously in batches, each batch is a single transaction that uses cached prepared
+/// statements. The IDs of new provenance steps are assigned when they are queued, hence they
+/// are available immediately.
+/// NOTE: Anything reading the provenance database needs to hold the lock of the writer and
+/// call flush() first, so that it sees all the queued records.
+
+class ProvenanceWriter : public boost::noncopyable
+{
+  // -- constructor/destructor --
+public:
+  ProvenanceWriter( DatabaseManager& database );
+
+  /// NOTE: The destructor writes the records that are still queued
+  virtual ~ProvenanceWriter();
+
+  // -- types --
+public:
+  typedef Core::RecursiveLockable::mutex_type mutex_type;
+  typedef Core::RecursiveLockable::lock_type lock_type;
+
+  // -- writing records --
+public:
+  /// ADD_RECORD:
+  /// Queue the provenance step for writing and return the ID of the new record.
+  ProvenanceStepID add_record( const ProvenanceStepHandle& step );
+
+  /// UPDATE_RECORD:
+  /// Queue an update of the action parameters of the given record.
+  void update_record( ProvenanceStepID record_id, const std::string& action_params );
+
+  /// DELETE_RECORD:
+  /// Queue the deletion of the given record.
+  void delete_record( ProvenanceStepID record_id );
+
+  /// FLUSH:
+  /// Write all the queued records. Returns false if any of them could not be written. If the
+  /// transaction could not be committed, the records stay queued and the next write retries
+  /// them.
+  bool flush();
+
+  /// RESET:
+  /// Write all the queued records and forget the cached IDs. This needs to be called whenever
+  /// the content of the database is replaced or cleared.
+  void reset();
+
+  /// GET_MUTEX:
+  /// Get the mutex that serializes access to the provenance database.
+  mutex_type& get_mutex();
+
+  // -- internals --
+private:
+  ProvenanceWriterPrivateHandle private_;
+};
+
+} // end namespace Seg3D
+
+#endif
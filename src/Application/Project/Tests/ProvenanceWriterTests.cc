@@ -0,0 +1,335 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/any.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/random.hpp>
+
+#include <Core/Utils/StringUtil.h>
+
+#include <Application/DatabaseManager/DatabaseManager.h>
+#include <Application/Project/ProvenanceWriter.h>
+
+using namespace Seg3D;
+
+namespace
+{
+
+// The provenance tables of a project, see ProjectPrivate::initialize_provenance_database
+const char* PROVENANCE_TABLES_C = 
+  "CREATE TABLE user "
+  "(user_id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+  "user_name TEXT NOT NULL UNIQUE);"
+  "CREATE TABLE action "
+  "(action_id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+  "action_name TEXT NOT NULL UNIQUE);"
+  "CREATE TABLE provenance_step "
+  "(prov_step_id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+  "action_id INTEGER NOT NULL REFERENCES action(action_id) ON DELETE CASCADE, "
+  "action_params TEXT NOT NULL, "
+  "timestamp TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP, "
+  "user_id INTEGER NOT NULL REFERENCES user(user_id) ON DELETE CASCADE);"
+  "CREATE TABLE provenance_input "
+  "(input_id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+  "prov_step_id INTEGER NOT NULL REFERENCES provenance_step(prov_step_id) ON DELETE CASCADE, "
+  "prov_id INTEGER NOT NULL);"
+  "CREATE TABLE provenance_output "
+  "(output_id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+  "prov_step_id INTEGER NOT NULL REFERENCES provenance_step(prov_step_id) ON DELETE CASCADE, "
+  "prov_id INTEGER NOT NULL UNIQUE);"
+  "CREATE TABLE provenance_replaced "
+  "(prov_step_id INTEGER NOT NULL REFERENCES provenance_step(prov_step_id) ON DELETE CASCADE, "
+  "prov_id INTEGER NOT NULL, "
+  "PRIMARY KEY (prov_step_id, prov_id));"
+  "CREATE TABLE provenance_inputfiles_cache "
+  "(prov_step_id INTEGER NOT NULL REFERENCES provenance_step(prov_step_id) ON DELETE CASCADE, "
+  "inputfiles_cache_id INTEGER NOT NULL PRIMARY KEY);";
+
+// Look up or insert a name, as the project did before the writer existed
+long long ReferenceNameId( DatabaseManager& database, const std::string& table, 
+  const std::string& name )
+{
+  std::string error;
+  ResultSet results;
+  if ( !database.run_sql_statement( "SELECT " + table + "_id FROM " + table + " WHERE " + 
+    table + "_name = '" + DatabaseManager::EscapeQuotes( name ) + "';", results, error ) )
+  {
+    return -1;
+  }
+  if ( results.size() > 0 )
+  {
+    return boost::any_cast< long long >( results[ 0 ][ table + "_id" ] );
+  }
+  if ( !database.run_sql_statement( "INSERT INTO " + table + " (" + table + "_name) VALUES('" +
+    DatabaseManager::EscapeQuotes( name ) + "');", error ) )
+  {
+    return -1;
+  }
+  return database.get_last_insert_rowid();
+}
+
+// Add a step with one statement per row, as the project did before the writer existed
+ProvenanceStepID ReferenceAddRecord( DatabaseManager& database, const ProvenanceStepHandle& step )
+{
+  long long user_id = ReferenceNameId( database, "user", step->get_username() );
+  long long action_id = ReferenceNameId( database, "action", step->get_action_name() );
+  if ( user_id == -1 || action_id == -1 ) return -1;
+
+  std::string action_params = step->get_action_params();
+  if ( action_params.empty() ) action_params = " ";
+
+  std::string error;
+  if ( !database.run_sql_statement( "INSERT INTO provenance_step (action_id, action_params, "
+    "user_id) VALUES(" + Core::ExportToString( action_id ) + ", '" + 
+    DatabaseManager::EscapeQuotes( action_params ) + "', " + Core::ExportToString( user_id ) + 
+    ");", error ) )
+  {
+    return -1;
+  }
+  ProvenanceStepID step_id = database.get_last_insert_rowid();
+
+  const char* tables[] = { "provenance_input", "provenance_output", "provenance_replaced" };
+  const ProvenanceIDList* id_lists[] = { &step->get_input_provenance_ids(), 
+    &step->get_output_provenance_ids(), &step->get_replaced_provenance_ids() };
+  for ( size_t k = 0; k < 3; k++ )
+  {
+    for ( size_t j = 0; j < id_lists[ k ]->size(); j++ )
+    {
+      if ( !database.run_sql_statement( std::string( "INSERT INTO " ) + tables[ k ] + 
+        " (prov_step_id,prov_id) VALUES(" + Core::ExportToString( step_id ) + ", " + 
+        Core::ExportToString( ( *id_lists[ k ] )[ j ] ) + ");", error ) )
+      {
+        return -1;
+      }
+    }
+  }
+
+  if ( step->get_inputfiles_id() > -1 )
+  {
+    if ( !database.run_sql_statement( "INSERT INTO provenance_inputfiles_cache VALUES (" +
+      Core::ExportToString( step_id ) + ", " + 
+      Core::ExportToString( step->get_inputfiles_id() ) + ");", error ) )
+    {
+      return -1;
+    }
+  }
+  return step_id;
+}
+
+// Get the rows of a query as strings, leaving out the time stamps
+std::vector< std::string > DumpTable( DatabaseManager& database, const std::string& sql )
+{
+  std::vector< std::string > rows;
+  std::string error;
+  ResultSet results;
+  EXPECT_TRUE( database.run_sql_statement( sql, results, error ) ) << error;
+  for ( size_t i = 0; i < results.size(); i++ )
+  {
+    std::string row;
+    std::map< std::string, boost::any >::const_iterator it = results[ i ].begin();
+    for ( ; it != results[ i ].end(); ++it )
+    {
+      row += it->first + "=";
+      if ( it->second.type() == typeid( long long ) )
+      {
+        row += Core::ExportToString( boost::any_cast< long long >( it->second ) );
+      }
+      else if ( it->second.type() == typeid( std::string ) )
+      {
+        row += boost::any_cast< std::string >( it->second );
+      }
+      row += ";";
+    }
+    rows.push_back( row );
+  }
+  return rows;
+}
+
+void ExpectSameTables( DatabaseManager& result, DatabaseManager& reference )
+{
+  const char* queries[] =
+  {
+    "SELECT * FROM user ORDER BY user_id;",
+    "SELECT * FROM action ORDER BY action_id;",
+    "SELECT prov_step_id, action_id, action_params, user_id FROM provenance_step "
+      "ORDER BY prov_step_id;",
+    "SELECT * FROM provenance_input ORDER BY input_id;",
+    "SELECT * FROM provenance_output ORDER BY output_id;",
+    "SELECT * FROM provenance_replaced ORDER BY prov_step_id, prov_id;",
+    "SELECT * FROM provenance_inputfiles_cache ORDER BY inputfiles_cache_id;",
+    "SELECT seq FROM sqlite_sequence WHERE name = 'provenance_step';"
+  };
+  for ( size_t k = 0; k < sizeof( queries ) / sizeof( queries[ 0 ] ); k++ )
+  {
+    SCOPED_TRACE( queries[ k ] );
+    std::vector< std::string > reference_rows = DumpTable( reference, queries[ k ] );
+    EXPECT_FALSE( reference_rows.empty() );
+    EXPECT_TRUE( reference_rows == DumpTable( result, queries[ k ] ) );
+  }
+}
+
+void CreateTables( DatabaseManager& database )
+{
+  std::string error;
+  ASSERT_TRUE( database.run_sql_script( PROVENANCE_TABLES_C, error ) ) << error;
+}
+
+ProvenanceStepHandle CreateStep( const std::string& action, const std::string& params )
+{
+  ProvenanceStepHandle step( new ProvenanceStep );
+  step->set_username( "user" );
+  step->set_action_name( action );
+  step->set_action_params( params );
+  return step;
+}
+
+} // end anonymous namespace
+
+TEST( ProvenanceWriterTests, MatchesStatementPerRow )
+{
+  DatabaseManager reference;
+  DatabaseManager database;
+  CreateTables( reference );
+  CreateTables( database );
+
+  const char* users[] = { "alice", "bob", "o'brien" };
+  const char* actions[] = { "Threshold", "Paint", "FloodFill", "MaskDataFromLabel", "Crop" };
+
+  boost::mt19937 rng( 13 );
+  boost::uniform_int<> percent( 0, 99 );
+  boost::uniform_int<> small( 0, 3 );
+  std::vector< ProvenanceStepID > step_ids;
+  ProvenanceID next_prov_id = 1;
+  InputFilesID next_inputfiles_id = 1;
+  {
+    ProvenanceWriter writer( database );
+    for ( int i = 0; i < 2000; i++ )
+    {
+      int choice = percent( rng );
+      if ( choice < 10 && !step_ids.empty() )
+      {
+        // Deleting a step that was already deleted does nothing
+        ProvenanceStepID step_id = step_ids[ boost::uniform_int<>( 0, 
+          static_cast< int >( step_ids.size() ) - 1 )( rng ) ];
+        std::string error;
+        ASSERT_TRUE( reference.run_sql_statement( "DELETE FROM provenance_step WHERE "
+          "prov_step_id = " + Core::ExportToString( step_id ) + ";", error ) ) << error;
+        writer.delete_record( step_id );
+        continue;
+      }
+      if ( choice < 20 && !step_ids.empty() )
+      {
+        ProvenanceStepID step_id = step_ids[ boost::uniform_int<>( 0, 
+          static_cast< int >( step_ids.size() ) - 1 )( rng ) ];
+        std::string params = choice % 2 ? "" : "radius='" + Core::ExportToString( i ) + "'";
+        std::string error;
+        ASSERT_TRUE( reference.run_sql_statement( "UPDATE provenance_step SET action_params = '" +
+          DatabaseManager::EscapeQuotes( params.empty() ? std::string( " " ) : params ) + 
+          "' WHERE prov_step_id = " + Core::ExportToString( step_id ) + ";", error ) ) << error;
+        writer.update_record( step_id, params );
+        continue;
+      }
+
+      ProvenanceStepHandle step = CreateStep( actions[ percent( rng ) % 5 ], 
+        choice % 7 ? "layerid='layer_" + Core::ExportToString( i ) + "' value=" + 
+        Core::ExportToString( choice ) : "" );
+      step->set_username( users[ percent( rng ) % 3 ] );
+      ProvenanceIDList inputs, outputs, replaced;
+      for ( int j = small( rng ); j > 0 && next_prov_id > 1; j-- )
+      {
+        inputs.push_back( boost::uniform_int< ProvenanceID >( 1, next_prov_id - 1 )( rng ) );
+      }
+      for ( int j = small( rng ); j > 0; j-- ) outputs.push_back( next_prov_id++ );
+      if ( !inputs.empty() && choice % 3 == 0 ) replaced.push_back( inputs[ 0 ] );
+      step->set_input_provenance_ids( inputs );
+      step->set_output_provenance_ids( outputs );
+      step->set_replaced_provenance_ids( replaced );
+      step->set_inputfiles_id( choice % 5 == 0 ? next_inputfiles_id++ : -1 );
+
+      ProvenanceStepID reference_id = ReferenceAddRecord( reference, step );
+      ASSERT_NE( -1, reference_id );
+      ASSERT_EQ( reference_id, writer.add_record( step ) );
+      step_ids.push_back( reference_id );
+    }
+
+    ProvenanceWriter::lock_type lock( writer.get_mutex() );
+    ASSERT_TRUE( writer.flush() );
+    ExpectSameTables( database, reference );
+  }
+
+  // A new writer continues with the IDs the database would assign
+  ProvenanceWriter writer( database );
+  ProvenanceStepHandle step = CreateStep( "Threshold", "" );
+  ASSERT_EQ( ReferenceAddRecord( reference, step ), writer.add_record( step ) );
+  ProvenanceWriter::lock_type lock( writer.get_mutex() );
+  ASSERT_TRUE( writer.flush() );
+  ExpectSameTables( database, reference );
+}
+
+TEST( ProvenanceWriterTests, FailedCommitKeepsRecords )
+{
+  DatabaseManager database;
+  CreateTables( database );
+
+  // Every new step violates a deferred foreign key, which fails the commit of the transaction
+  std::string error;
+  ASSERT_TRUE( database.run_sql_script( "CREATE TABLE commit_parent (id INTEGER PRIMARY KEY);"
+    "CREATE TABLE commit_guard (id INTEGER REFERENCES commit_parent(id) "
+    "DEFERRABLE INITIALLY DEFERRED);"
+    "CREATE TRIGGER commit_trigger AFTER INSERT ON provenance_step BEGIN "
+    "INSERT INTO commit_guard VALUES (NEW.prov_step_id); END;", error ) ) << error;
+
+  ProvenanceWriter writer( database );
+  ProvenanceStepID first_id = writer.add_record( CreateStep( "Threshold", "value=1" ) );
+  ProvenanceStepID second_id = writer.add_record( CreateStep( "Paint", "" ) );
+  EXPECT_EQ( first_id + 1, second_id );
+
+  ProvenanceWriter::lock_type lock( writer.get_mutex() );
+  EXPECT_FALSE( writer.flush() );
+  std::vector< std::string > steps = DumpTable( database, 
+    "SELECT prov_step_id FROM provenance_step;" );
+  EXPECT_TRUE( steps.empty() );
+
+  // The records are written once the commit succeeds, in their original order
+  ASSERT_TRUE( database.run_sql_statement( "DROP TRIGGER commit_trigger;", error ) ) << error;
+  writer.update_record( first_id, "value=2" );
+  EXPECT_TRUE( writer.flush() );
+  steps = DumpTable( database, 
+    "SELECT prov_step_id, action_params FROM provenance_step ORDER BY prov_step_id;" );
+  ASSERT_EQ( 2u, steps.size() );
+  EXPECT_EQ( "action_params=value=2;prov_step_id=" + Core::ExportToString( first_id ) + ";", 
+    steps[ 0 ] );
+  EXPECT_EQ( "action_params= ;prov_step_id=" + Core::ExportToString( second_id ) + ";", 
+    steps[ 1 ] );
+}
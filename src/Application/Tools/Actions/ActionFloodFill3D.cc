@@ -0,0 +1,318 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#include <Core/Action/ActionFactory.h>
+#include <Core/DataBlock/MaskFloodFill.h>
+#include <Core/Math/MathFunctions.h>
+
+#include <Application/Tools/Actions/ActionFloodFill3D.h>
+#include <Application/Layer/DataLayer.h>
+#include <Application/Layer/MaskLayer.h>
+#include <Application/Layer/LayerManager.h>
+#include <Application/Layer/LayerUndoBufferItem.h>
+#include <Application/UndoBuffer/UndoBuffer.h>
+#include <Application/ProjectManager/ProjectManager.h>
+
+CORE_REGISTER_ACTION( Seg3D, FloodFill3D )
+
+namespace Seg3D
+{
+
+class ActionFloodFill3DPrivate
+{
+public:
+  // FIND_MASK_CONSTRAINT:
+  // Find the mask constraint layer with the given id. Returns false if the layer cannot be 
+  // used, an invalid layer is reported and ignored.
+  bool find_mask_constraint( const std::string& layer_id, MaskLayerHandle target_layer, 
+    const std::string& name, Core::ActionContextHandle& context, 
+    Core::MaskDataBlockHandle& mask_cstr );
+
+  std::string target_layer_id_;
+  std::vector< Core::Point > seeds_;
+  std::string data_cstr_layer_id_;
+  double min_val_;
+  double max_val_;
+  bool negative_data_cstr_;
+  std::string mask_cstr1_layer_id_;
+  bool negative_mask_cstr1_;
+  std::string mask_cstr2_layer_id_;
+  bool negative_mask_cstr2_;
+  bool erase_;
+  SandboxID sandbox_;
+
+  Core::MaskDataBlockHandle mask_;
+  Core::DataBlockHandle data_cstr_;
+  Core::MaskDataBlockHandle mask_cstr1_;
+  Core::MaskDataBlockHandle mask_cstr2_;
+
+  std::vector< Core::IndexVector > seeds_3d_;
+};
+
+bool ActionFloodFill3DPrivate::find_mask_constraint( const std::string& layer_id, 
+  MaskLayerHandle target_layer, const std::string& name, Core::ActionContextHandle& context, 
+  Core::MaskDataBlockHandle& mask_cstr )
+{
+  mask_cstr.reset();
+  if ( layer_id == "" || layer_id == "<none>" ) return true;
+
+  MaskLayerHandle mask_cstr_layer = LayerManager::FindMaskLayer( layer_id, this->sandbox_ );
+
+  // NOTE: Compare layer grid transforms instead of their groups as in a sandbox
+  // layers aren't grouped.
+  if ( !mask_cstr_layer || 
+    mask_cstr_layer->get_grid_transform() != target_layer->get_grid_transform() )
+  {
+    context->report_error( "Layer '" + layer_id + "' is not a valid mask constraint layer, "
+      "will proceed as if no " + name + "." );
+    return true;
+  }
+  
+  if ( !LayerManager::Instance()->CheckLayerAvailabilityForUse( layer_id, context, 
+    this->sandbox_ ) )
+  {
+    return false;
+  }
+
+  mask_cstr = mask_cstr_layer->get_mask_volume()->get_mask_data_block();
+  return true;
+}
+
+ActionFloodFill3D::ActionFloodFill3D() :
+  private_( new ActionFloodFill3DPrivate )
+{
+  this->add_layer_id( this->private_->target_layer_id_ );
+  this->add_parameter( this->private_->seeds_ );
+  this->add_layer_id( this->private_->data_cstr_layer_id_ );
+  this->add_parameter( this->private_->min_val_ );
+  this->add_parameter( this->private_->max_val_ );
+  this->add_parameter( this->private_->negative_data_cstr_ );
+  this->add_layer_id( this->private_->mask_cstr1_layer_id_ );
+  this->add_parameter( this->private_->negative_mask_cstr1_ );
+  this->add_layer_id( this->private_->mask_cstr2_layer_id_ );
+  this->add_parameter( this->private_->negative_mask_cstr2_ );
+  this->add_parameter( this->private_->erase_ );
+  this->add_parameter( this->private_->sandbox_ );
+}
+
+bool ActionFloodFill3D::validate( Core::ActionContextHandle& context )
+{ 
+  // Make sure that the sandbox exists
+  if ( !LayerManager::CheckSandboxExistence( this->private_->sandbox_, context ) )
+  {
+    return false;
+  }
+
+  // Check whether the target layer exists
+  MaskLayerHandle target_layer = LayerManager::FindMaskLayer( 
+    this->private_->target_layer_id_, this->private_->sandbox_ );
+  if ( !target_layer )
+  {
+    context->report_error( "Layer '" + this->private_->target_layer_id_ +
+      "' is not a valid mask layer." );
+    return false;
+  }
+
+  // Check whether the target layer can be used for processing
+  if ( !LayerManager::Instance()->CheckLayerAvailabilityForProcessing(
+    this->private_->target_layer_id_, context, this->private_->sandbox_ ) ) return false;
+
+  this->private_->mask_ = target_layer->get_mask_volume()->get_mask_data_block();
+  
+  this->private_->data_cstr_.reset();
+  if ( this->private_->data_cstr_layer_id_ != "" &&
+    this->private_->data_cstr_layer_id_ != "<none>" )
+  {
+    DataLayerHandle data_cstr_layer = LayerManager::FindDataLayer( 
+      this->private_->data_cstr_layer_id_, this->private_->sandbox_ );
+
+    // NOTE: Compare layer grid transforms instead of their groups as in a sandbox
+    // layers aren't grouped.
+    if ( !data_cstr_layer || 
+      data_cstr_layer->get_grid_transform() != target_layer->get_grid_transform() )
+    {
+      context->report_error( "Layer '" + this->private_->data_cstr_layer_id_ +
+        "' is not a valid data constraint layer, will proceed as if no data constraint." );
+    }
+    else if ( !LayerManager::Instance()->CheckLayerAvailabilityForUse( 
+      this->private_->data_cstr_layer_id_, context, this->private_->sandbox_ ) )
+    {
+      return false;
+    }
+    else
+    {
+      this->private_->data_cstr_ = data_cstr_layer->get_data_volume()->get_data_block();
+    }
+  }
+  
+  if ( !this->private_->find_mask_constraint( this->private_->mask_cstr1_layer_id_, 
+    target_layer, "mask constraint 1", context, this->private_->mask_cstr1_ ) ||
+    !this->private_->find_mask_constraint( this->private_->mask_cstr2_layer_id_, 
+    target_layer, "mask constraint 2", context, this->private_->mask_cstr2_ ) )
+  {
+    return false;
+  }
+
+  // Convert the seed points into indices of the volume
+  const Core::Transform& inverse_transform = 
+    target_layer->get_mask_volume()->get_inverse_transform();
+  const std::vector< Core::Point >& seeds = this->private_->seeds_;
+  int nx = static_cast< int >( this->private_->mask_->get_nx() );
+  int ny = static_cast< int >( this->private_->mask_->get_ny() );
+  int nz = static_cast< int >( this->private_->mask_->get_nz() );
+  this->private_->seeds_3d_.clear();
+
+  for ( size_t i = 0; i < seeds.size(); ++i )
+  {
+    Core::Point index = inverse_transform * seeds[ i ];
+    int x = Core::Round( index.x() );
+    int y = Core::Round( index.y() );
+    int z = Core::Round( index.z() );
+    if ( x >= 0 && x < nx && y >= 0 && y < ny && z >= 0 && z < nz )
+    {
+      this->private_->seeds_3d_.push_back( Core::IndexVector( x, y, z ) );
+    }
+  }
+
+  if ( this->private_->seeds_3d_.size() == 0 )
+  {
+    context->report_error( "All seed points are outside the boundary of the volume." );
+    return false;
+  }
+  
+  return true;
+}
+
+bool ActionFloodFill3D::run( Core::ActionContextHandle& context, Core::ActionResultHandle& result )
+{
+  // Find the voxels to fill first, so only the slices that change need a check point
+  Core::MaskFloodFill flood_fill( this->private_->mask_, this->private_->erase_ );
+  if ( this->private_->data_cstr_ )
+  {
+    flood_fill.set_data_constraint( this->private_->data_cstr_, this->private_->min_val_,
+      this->private_->max_val_, this->private_->negative_data_cstr_ );
+  }
+  if ( this->private_->mask_cstr1_ )
+  {
+    flood_fill.add_mask_constraint( this->private_->mask_cstr1_, 
+      this->private_->negative_mask_cstr1_ );
+  }
+  if ( this->private_->mask_cstr2_ )
+  {
+    flood_fill.add_mask_constraint( this->private_->mask_cstr2_, 
+      this->private_->negative_mask_cstr2_ );
+  }
+  flood_fill.compute( this->private_->seeds_3d_ );
+
+  size_t min_z, max_z;
+  if ( !flood_fill.get_z_range( min_z, max_z ) )
+  {
+    // Nothing changes, hence there is nothing to undo
+    result.reset( new Core::ActionResult( this->private_->target_layer_id_ ) );
+    return true;
+  }
+
+  if ( this->private_->sandbox_ == -1 )
+  {
+    // Get the layer on which this action operates
+    LayerHandle layer = LayerManager::FindLayer( this->private_->target_layer_id_ );
+
+    // Create a provenance record
+    ProvenanceStepHandle provenance_step( new ProvenanceStep );
+    
+    // Get the input provenance ids from the translate step
+    provenance_step->set_input_provenance_ids( this->get_input_provenance_ids() );
+    
+    // Get the output and replace provenance ids from the analysis above
+    provenance_step->set_output_provenance_ids(  this->get_output_provenance_ids( 1 )  );
+    
+    ProvenanceIDList deleted_provenance_ids( 1, layer->provenance_id_state_->get() );
+    provenance_step->set_replaced_provenance_ids( deleted_provenance_ids );
+  
+    provenance_step->set_action_name( this->get_type() );
+    provenance_step->set_action_params( this->export_params_to_provenance_string() );   
+    
+    ProvenanceStepID step_id = ProjectManager::Instance()->get_current_project()->
+      add_provenance_record( provenance_step );
+
+    // Build the undo/redo for this action
+    LayerUndoBufferItemHandle item( new LayerUndoBufferItem( "FloodFill3D" ) );
+
+    // Create a check point of the axial slices that the flood fill changes
+    LayerCheckPointHandle check_point( new LayerCheckPoint( layer, Core::SliceType::AXIAL_E, 
+      min_z, max_z ) );
+
+    // The redo action is the current one
+    item->set_redo_action( this->shared_from_this() );
+    // Tell which provenance record to delete when undone
+    item->set_provenance_step_id( step_id );
+    // Tell the item which layer to restore with which check point for the undo action
+    item->add_layer_to_restore( layer, check_point );
+
+    // Now add the undo/redo action to undo buffer
+    UndoBuffer::Instance()->insert_undo_item( context, item );
+
+    // Set the output provenance id
+    layer->provenance_id_state_->set( this->get_output_provenance_id( 0 ) );
+  }
+
+  flood_fill.apply();
+
+  result.reset( new Core::ActionResult( this->private_->target_layer_id_ ) );
+  return true;
+}
+
+void ActionFloodFill3D::clear_cache()
+{
+  this->private_->mask_.reset();
+  this->private_->data_cstr_.reset();
+  this->private_->mask_cstr1_.reset();
+  this->private_->mask_cstr2_.reset();
+  this->private_->seeds_3d_.clear();
+}
+
+void ActionFloodFill3D::Dispatch( Core::ActionContextHandle context, 
+  const FloodFillInfo& params )
+{
+  ActionFloodFill3D* action = new ActionFloodFill3D;
+  action->private_->target_layer_id_ = params.target_layer_id_;
+  action->private_->seeds_ = params.seeds_;
+  action->private_->data_cstr_layer_id_ = params.data_constraint_layer_id_;
+  action->private_->min_val_ = params.min_val_;
+  action->private_->max_val_ = params.max_val_;
+  action->private_->negative_data_cstr_ = params.negative_data_constraint_;
+  action->private_->mask_cstr1_layer_id_ = params.mask_constraint1_layer_id_;
+  action->private_->negative_mask_cstr1_ = params.negative_mask_constraint1_;
+  action->private_->mask_cstr2_layer_id_ = params.mask_constraint2_layer_id_;
+  action->private_->negative_mask_cstr2_ = params.negative_mask_constraint2_;
+  action->private_->erase_ = params.erase_;
+
+  Core::ActionDispatcher::PostAction( Core::ActionHandle( action ), context );
+}
+
+} // end namespace Seg3D
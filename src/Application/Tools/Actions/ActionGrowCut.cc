@@ -29,8 +29,10 @@
 // Core includes
 #include <Core/Math/MathFunctions.h>
 #include <Core/Utils/TimeSince.h>
+#include <Core/DataBlock/MaskDataBlockManager.h>
 
 // Application includes
+#include <Application/Layer/DataLayer.h>
 #include <Application/Layer/LayerManager.h>
 #include <Application/Layer/LayerGroup.h>
 #include <Application/StatusBar/StatusBar.h>
@@ -127,37 +129,44 @@ public:
   virtual void run_filter()
   {
     Core::TimeSince::start_timer( "growcut" );
-    // Retrieve the image as an itk image from the underlying data structure
-    // NOTE: This only does wrapping and does not regenerate the data.
-
-    Core::ITKImageDataT<short>::Handle data_image;
-    this->get_itk_image_from_layer<short>( this->data_layer_, data_image );
-
-    Core::ITKImageDataT<unsigned char>::Handle foreground_image;
-    this->get_itk_image_from_layer<unsigned char>( this->foreground_layer_, foreground_image );
-
-    Core::ITKImageDataT<unsigned char>::Handle background_image;
-    this->get_itk_image_from_layer<unsigned char>( this->background_layer_, background_image );
+    // NOTE: GrowCut reads the data and the seeds directly from their data blocks and writes
+    // its result directly into the bit-plane of a new mask, only within a region around the
+    // seeds.
+    DataLayerHandle data_layer = boost::dynamic_pointer_cast<DataLayer>( this->data_layer_ );
+    MaskLayerHandle foreground_layer = boost::dynamic_pointer_cast<MaskLayer>( this->foreground_layer_ );
+    MaskLayerHandle background_layer = boost::dynamic_pointer_cast<MaskLayer>( this->background_layer_ );
+
+    Core::MaskDataBlockHandle output_mask;
+    if ( !Core::MaskDataBlockManager::Create( this->output_layer_->get_grid_transform(), output_mask ) )
+    {
+      this->report_error( "Could not allocate enough memory." );
+      return;
+    }
 
     if ( !this->grow_cutter_ )
     {
       this->grow_cutter_ = GrowCutterHandle( new GrowCutter() );
-      std::cerr << " New grow cutter handle" << std::endl;
     }
 
     this->output_layer_->update_progress_signal_( 0.1 );
 
-    this->grow_cutter_->set_foreground_image( foreground_image->get_image() );
-    this->grow_cutter_->set_background_image( background_image->get_image() );
-    this->grow_cutter_->set_data_image( data_image->get_image() );
+    this->grow_cutter_->set_foreground_mask( foreground_layer->get_mask_volume()->get_mask_data_block() );
+    this->grow_cutter_->set_background_mask( background_layer->get_mask_volume()->get_mask_data_block() );
+    this->grow_cutter_->set_data_block( data_layer->get_data_volume()->get_data_block() );
+    this->grow_cutter_->set_output_mask( output_mask );
 
     this->output_layer_->update_progress_signal_( 0.2 );
 
-    this->grow_cutter_->execute();
+    if ( !this->grow_cutter_->execute() )
+    {
+      this->report_error( "GrowCut needs foreground or background seeds." );
+      return;
+    }
 
     this->output_layer_->update_progress_signal_( 1.0 );
 
-    this->insert_itk_image_into_layer( this->output_layer_, this->grow_cutter_->get_output().GetPointer() );
+    this->dispatch_insert_mask_volume_into_layer( this->output_layer_, Core::MaskVolumeHandle( 
+      new Core::MaskVolume( this->output_layer_->get_grid_transform(), output_mask ) ) );
 
     CORE_LOG_SUCCESS( "GrowCut duration: " +
                       Core::TimeSince::format_double( Core::TimeSince::get_time_since( "growcut" ) / 1000, 2 ) + "s" );
@@ -336,8 +336,9 @@ bool ActionPolyline::run( Core::ActionContextHandle& context, Core::ActionResult
     }
   }
   
+  mask_data_block->increase_generation( volume_slice->get_slice_type(), 
+    volume_slice->get_slice_number() );
   mask_data_lock.unlock();
-  mask_data_block->increase_generation();
   mask_data_block->mask_updated_signal_();
 
   result.reset( new Core::ActionResult( this->private_->target_layer_id_ ) );
@@ -45,10 +45,12 @@
 #include <Application/Tools/SpeedlineTool.h>
 
 //ITK Includes
-#include <itkExtractImageFilter.h>
 #include <itkPathIterator.h>
 #include <itkImageBase.h>
 
+#include <boost/thread/mutex.hpp>
+
+#include <map>
 #include <sstream>
 
 CORE_REGISTER_ACTION( Seg3D, Speedline )
@@ -58,9 +60,42 @@ namespace Seg3D
 
 using namespace Core;
 
+namespace
+{
+
+// SPEEDLINECACHE:
+// The cost map of the last slice that was traced and the paths that were found on it. As long
+// as the slice, its data and the cost function settings do not change, the next run only has to
+// trace the segments that were moved.
+class SpeedlineCache
+{
+public:
+  typedef std::pair< std::pair< long, long >, std::pair< long, long > > segment_key_type;
+  typedef std::map< segment_key_type, std::vector< Point > > segment_map_type;
+
+  // Settings and generations the cached cost map was computed for
+  std::string key_;
+
+  // The live-wire function with the cost map and the searches from the recent anchors
+  itk::LightObject::Pointer livewire_;
+
+  // The segments of the last run, keyed by the slice indices of their end points
+  segment_map_type segments_;
+
+  // Only one Speedline is traced at a time, as the live-wire keeps its searches in place
+  boost::mutex mutex_;
+};
+
+SpeedlineCache& GetSpeedlineCache()
+{
+  static SpeedlineCache cache;
+  return cache;
+}
+
+} // end anonymous namespace
+
 class ActionSpeedlineAlgo : public  ITKFilter
 {
-  static const unsigned int VOL_DIM_C = 3;
   static const unsigned int SLICE_DIM_C = 2;
 
   Path world_paths_;
@@ -88,52 +123,137 @@ public:
 //  long action_id_;
 //  AtomicCounterHandle action_handle_;
 
+  DataVolumeSliceHandle volume_slice_;
+
+  // Layout of the slice in the volume
+  size_t width_;
+  size_t height_;
+  size_t start_;
+  size_t stride_x_;
+  size_t stride_y_;
+  double spacing_x_;
+  double spacing_y_;
+
 public:
-  template< class TYPED_IMAGE_TYPE, class TYPED_IMAGE_TYPE_2D >
-  typename TYPED_IMAGE_TYPE_2D::Pointer extract_2D_image( typename TYPED_IMAGE_TYPE::Pointer image )
+  // COMPUTE_SLICE_LAYOUT:
+  // Compute where the pixels of the slice are found in the volume, so the slice can be copied
+  // without converting the whole volume first.
+  void compute_slice_layout()
   {
-    // Create 2D itk image
-    typedef itk::ExtractImageFilter< TYPED_IMAGE_TYPE, TYPED_IMAGE_TYPE_2D >  extract_filter_type;
-    typename extract_filter_type::Pointer extract_filter = extract_filter_type::New();
-
-    typename TYPED_IMAGE_TYPE::RegionType input_region = image->GetLargestPossibleRegion();
-    typename TYPED_IMAGE_TYPE::SizeType size = input_region.GetSize();
-    typename TYPED_IMAGE_TYPE::IndexType start = input_region.GetIndex();
+    const GridTransform& transform = this->target_layer_->get_grid_transform();
+    const size_t nx = transform.get_nx();
+    const size_t ny = transform.get_ny();
+    const size_t nz = transform.get_nz();
+    double spacing_x = transform.project( GridTransform::X_AXIS ).length();
+    double spacing_y = transform.project( GridTransform::Y_AXIS ).length();
+    double spacing_z = transform.project( GridTransform::Z_AXIS ).length();
 
     if ( this->slice_type_ == VolumeSliceType::SAGITTAL_E )
     {
-      // Collapse Dim X (YZ plane)
-      size[ 0 ] = 0;
-      start[ 0 ] = this->slice_number_;
+      // YZ plane
+      this->width_ = ny;
+      this->height_ = nz;
+      this->start_ = this->slice_number_;
+      this->stride_x_ = nx;
+      this->stride_y_ = nx * ny;
+      this->spacing_x_ = spacing_y;
+      this->spacing_y_ = spacing_z;
     }
     else if ( this->slice_type_ == VolumeSliceType::CORONAL_E )
     {
-      // Collapse Dim Y (XZ plane)
-      size[ 1 ] = 0;
-      start[ 1 ] = this->slice_number_;
-
+      // XZ plane
+      this->width_ = nx;
+      this->height_ = nz;
+      this->start_ = this->slice_number_ * nx;
+      this->stride_x_ = 1;
+      this->stride_y_ = nx * ny;
+      this->spacing_x_ = spacing_x;
+      this->spacing_y_ = spacing_z;
     }
     else
     {
       // AXIAL_E
-      // Collapse Dim Z (XY plane)
-      size[ 2 ] = 0;
-      start[ 2 ] = this->slice_number_;
+      // XY plane
+      this->width_ = nx;
+      this->height_ = ny;
+      this->start_ = this->slice_number_ * nx * ny;
+      this->stride_x_ = 1;
+      this->stride_y_ = nx;
+      this->spacing_x_ = spacing_x;
+      this->spacing_y_ = spacing_y;
     }
+  }
+
+  template< class TYPED_IMAGE_TYPE_2D >
+  typename TYPED_IMAGE_TYPE_2D::Pointer create_2D_image()
+  {
+    typename TYPED_IMAGE_TYPE_2D::RegionType region;
+    typename TYPED_IMAGE_TYPE_2D::SizeType size;
+    typename TYPED_IMAGE_TYPE_2D::IndexType start;
+    size[ 0 ] = this->width_;
+    size[ 1 ] = this->height_;
+    start[ 0 ] = 0;
+    start[ 1 ] = 0;
+    region.SetSize( size );
+    region.SetIndex( start );
+
+    typename TYPED_IMAGE_TYPE_2D::SpacingType spacing;
+    spacing[ 0 ] = this->spacing_x_;
+    spacing[ 1 ] = this->spacing_y_;
+
+    typename TYPED_IMAGE_TYPE_2D::Pointer image = TYPED_IMAGE_TYPE_2D::New();
+    image->SetRegions( region );
+    image->SetSpacing( spacing );
+    image->Allocate();
+    return image;
+  }
 
-    typename TYPED_IMAGE_TYPE::RegionType desired_region;
-    desired_region.SetSize( size );
-    desired_region.SetIndex( start );
+  template< class TYPED_IMAGE_TYPE_2D >
+  typename TYPED_IMAGE_TYPE_2D::Pointer extract_2D_image()
+  {
+    typedef typename TYPED_IMAGE_TYPE_2D::PixelType value_type;
+    typename TYPED_IMAGE_TYPE_2D::Pointer image = create_2D_image< TYPED_IMAGE_TYPE_2D >();
+    value_type* dst = image->GetBufferPointer();
 
-    extract_filter->SetExtractionRegion( desired_region );
-    extract_filter->SetInput( image );
-    extract_filter->SetDirectionCollapseToIdentity();
-    extract_filter->Update();
+    DataVolumeHandle volume = this->target_layer_->get_data_volume();
+    DataVolume::shared_lock_type lock( volume->get_mutex() );
+    const value_type* src = reinterpret_cast< const value_type* >( 
+      volume->get_data_block()->get_data() ) + this->start_;
 
-    typename TYPED_IMAGE_TYPE_2D::Pointer input_image_2D = extract_filter->GetOutput();
-    input_image_2D->DisconnectPipeline();
+    for ( size_t y = 0; y < this->height_; y++ )
+    {
+      const value_type* src_row = src + y * this->stride_y_;
+      for ( size_t x = 0; x < this->width_; x++, dst++ )
+      {
+        *dst = src_row[ x * this->stride_x_ ];
+      }
+    }
 
-    return input_image_2D;
+    return image;
+  }
+
+  template< class MASK_IMAGE_TYPE_2D >
+  typename MASK_IMAGE_TYPE_2D::Pointer extract_2D_mask()
+  {
+    typedef typename MASK_IMAGE_TYPE_2D::PixelType value_type;
+    typename MASK_IMAGE_TYPE_2D::Pointer image = create_2D_image< MASK_IMAGE_TYPE_2D >();
+    value_type* dst = image->GetBufferPointer();
+
+    MaskDataBlockHandle mask = this->roi_mask_layer_->get_mask_volume()->get_mask_data_block();
+    MaskDataBlock::shared_lock_type lock( mask->get_mutex() );
+    const unsigned char* src = mask->get_mask_data() + this->start_;
+    const unsigned char mask_value = mask->get_mask_value();
+
+    for ( size_t y = 0; y < this->height_; y++ )
+    {
+      const unsigned char* src_row = src + y * this->stride_y_;
+      for ( size_t x = 0; x < this->width_; x++, dst++ )
+      {
+        *dst = ( src_row[ x * this->stride_x_ ] & mask_value ) ? 1 : 0;
+      }
+    }
+
+    return image;
   }
 
   template< class TYPED_IMAGE_TYPE_2D >
@@ -141,13 +261,10 @@ public:
   {
     typename TYPED_IMAGE_TYPE_2D::IndexType slice_point;
 
-    VolumeSliceType slice_type = static_cast< VolumeSliceType::enum_type >( this->slice_type_ );
-    DataVolumeSliceHandle volume_slice( new DataVolumeSlice( this->target_layer_->get_data_volume(), slice_type ) );
-
     double world_x, world_y;
     int x = -1, y = -1;
-    volume_slice->project_onto_slice( point, world_x, world_y );
-    volume_slice->world_to_index( world_x, world_y, x, y );
+    this->volume_slice_->project_onto_slice( point, world_x, world_y );
+    this->volume_slice_->world_to_index( world_x, world_y, x, y );
     slice_point[0] = x;
     slice_point[1] = y;
 
@@ -159,16 +276,32 @@ public:
   {
     Point point;
 
-    VolumeSliceType slice_type = static_cast< VolumeSliceType::enum_type >( this->slice_type_ );
-    DataVolumeSliceHandle volume_slice( new DataVolumeSlice( this->target_layer_->get_data_volume(), slice_type ) );
-
     double world_x, world_y;
-    volume_slice->index_to_world( slice_point[0], slice_point[1], world_x, world_y );
-    volume_slice->get_world_coord( world_x, world_y, point );
+    this->volume_slice_->index_to_world( slice_point[0], slice_point[1], world_x, world_y );
+    this->volume_slice_->get_world_coord( world_x, world_y, point );
 
     return point;
   }
 
+  // GET_CACHE_KEY:
+  // Everything the cost map depends on. The generations change whenever the data of the
+  // target or the region of interest is modified.
+  std::string get_cache_key()
+  {
+    std::ostringstream oss;
+    oss << this->target_layer_id_ << ' ' << 
+      this->target_layer_->get_data_volume()->get_generation() << ' ';
+    if ( this->roi_mask_layer_ )
+    {
+      oss << this->roi_mask_layer_id_ << ' ' << 
+        this->roi_mask_layer_->get_mask_volume()->get_generation() << ' ';
+    }
+    oss << this->slice_type_ << ' ' << this->slice_number_ << ' ' << 
+      this->grad_mag_weight_ << ' ' << this->zero_cross_weight_ << ' ' << 
+      this->grad_dir_weight_ << ' ' << this->image_spacing_ << ' ' << this->face_conn_;
+    return oss.str();
+  }
+
   SCI_BEGIN_TYPED_ITK_RUN( this->target_layer_->get_data_type() )
   {
     StateSpeedlinePathHandle world_path_state;
@@ -189,38 +322,48 @@ public:
 
     this->world_paths_.delete_all_paths();
 
-    typedef itk::Image< int, VOL_DIM_C> MASK_IMAGE_TYPE;
     typedef itk::Image< int, SLICE_DIM_C > MASK_IMAGE_TYPE_2D;
     typedef itk::Image< VALUE_TYPE, SLICE_DIM_C > TYPED_IMAGE_TYPE_2D;
     typedef itk::LiveWireImageFunction< TYPED_IMAGE_TYPE_2D > LiveWireType;
     typedef typename LiveWireType::OutputType PATH_TYPE;
 
-    typename ITKImageDataT< int >::Handle roi_mask_image;
-    typename ITKImageDataT< VALUE_TYPE >::Handle input_image;
+    VolumeSliceType slice_type = static_cast< VolumeSliceType::enum_type >( this->slice_type_ );
+    this->volume_slice_.reset( new DataVolumeSlice( this->target_layer_->get_data_volume(), 
+      slice_type ) );
 
-    this->get_itk_image_from_layer< VALUE_TYPE >( this->target_layer_, input_image );
+    SpeedlineCache& cache = GetSpeedlineCache();
+    boost::mutex::scoped_lock cache_lock( cache.mutex_ );
 
-    typename TYPED_IMAGE_TYPE_2D::Pointer input_image_2D =
-      extract_2D_image< TYPED_IMAGE_TYPE, TYPED_IMAGE_TYPE_2D >( input_image->get_image() );
+    // Only copy the slice and recompute its cost map if the data or the settings changed
+    std::string cache_key = this->get_cache_key();
+    typename LiveWireType::Pointer livewire = 
+      dynamic_cast< LiveWireType* >( cache.livewire_.GetPointer() );
+    if ( !livewire || cache.key_ != cache_key )
+    {
+      cache.key_.clear();
+      cache.livewire_ = nullptr;
+      cache.segments_.clear();
 
-    typename LiveWireType::Pointer livewire = LiveWireType::New();
+      this->compute_slice_layout();
 
-    livewire->SetGradientMagnitudeWeight( this->grad_mag_weight_ );
-    livewire->SetZeroCrossingWeight( this->zero_cross_weight_ );
-    livewire->SetGradientDirectionWeight( this->grad_dir_weight_ );
-    livewire->SetUseImageSpacing( this->image_spacing_ );
-    livewire->SetUseFaceConnectedness( this->face_conn_ );
+      livewire = LiveWireType::New();
+      livewire->SetGradientMagnitudeWeight( this->grad_mag_weight_ );
+      livewire->SetZeroCrossingWeight( this->zero_cross_weight_ );
+      livewire->SetGradientDirectionWeight( this->grad_dir_weight_ );
+      livewire->SetUseImageSpacing( this->image_spacing_ );
+      livewire->SetUseFaceConnectedness( this->face_conn_ );
 
-    livewire->SetInputImage( input_image_2D );
+      livewire->SetInputImage( this->extract_2D_image< TYPED_IMAGE_TYPE_2D >() );
 
-    if ( this->roi_mask_layer_id_ != "<none>" )
-    {
-      this->get_itk_image_from_layer< int >( this->roi_mask_layer_, roi_mask_image );
-      typename MASK_IMAGE_TYPE_2D::Pointer roi_mask_image_2D =
-        extract_2D_image< MASK_IMAGE_TYPE, MASK_IMAGE_TYPE_2D >( roi_mask_image->get_image() );
+      if ( this->roi_mask_layer_ )
+      {
+        // The extracted mask is 1 inside the region of interest
+        livewire->SetInsidePixelValue( 1 );
+        livewire->SetMaskImage( this->extract_2D_mask< MASK_IMAGE_TYPE_2D >() );
+      }
 
-      livewire->SetInsidePixelValue( this->roi_mask_layer_->get_mask_volume()->get_mask_data_block()->get_mask_bit() );
-      livewire->SetMaskImage( roi_mask_image_2D );
+      cache.key_ = cache_key;
+      cache.livewire_ = livewire.GetPointer();
     }
 
     const size_t num_of_vertices = this->vertices_.size();
@@ -229,6 +372,9 @@ public:
     this->world_paths_.set_start_point( this->vertices_[0] );
     this->world_paths_.set_end_point( this->vertices_[end_index] );
 
+    // Only the segments of this run are kept for the next one
+    SpeedlineCache::segment_map_type segments;
+
     for ( size_t index = 0; index < this->vertices_.size(); ++index )
     {
       Point p0 = this->vertices_[ index ];
@@ -237,31 +383,49 @@ public:
       SinglePath new_path( p0, p1 );
 
       typename TYPED_IMAGE_TYPE_2D::IndexType anchor = extract_2D_point< TYPED_IMAGE_TYPE_2D >( p0 );
-      livewire->SetAnchorSeed( anchor );
-
       typename TYPED_IMAGE_TYPE_2D::IndexType free = extract_2D_point< TYPED_IMAGE_TYPE_2D >( p1 );
-      typename PATH_TYPE::Pointer path = livewire->EvaluateAtIndex( free );
-      if ( path == nullptr )
+      SpeedlineCache::segment_key_type segment_key( std::make_pair( anchor[ 0 ], anchor[ 1 ] ),
+        std::make_pair( free[ 0 ], free[ 1 ] ) );
+
+      std::vector< Point >& points = segments[ segment_key ];
+      SpeedlineCache::segment_map_type::iterator it = cache.segments_.find( segment_key );
+      if ( it != cache.segments_.end() )
       {
-        // TODO: report point
-        std::ostringstream oss;
-        oss << "Error computing path at " << p0 << " and " << p1 << "." << std::endl;
-        this->report_error( oss.str() );
-        StateEngine::lock_type lock( StateEngine::GetMutex() );
-        Application::PostEvent( boost::bind( &StateSpeedlinePath::set, world_path_state, Path(), ActionSource::NONE_E ) );
-        return;
+        points = it->second;
+      }
+      else if ( points.empty() )
+      {
+        livewire->SetAnchorSeed( anchor );
+        typename PATH_TYPE::Pointer path = livewire->EvaluateAtIndex( free );
+        if ( path == nullptr )
+        {
+          // TODO: report point
+          std::ostringstream oss;
+          oss << "Error computing path at " << p0 << " and " << p1 << "." << std::endl;
+          this->report_error( oss.str() );
+          StateEngine::lock_type lock( StateEngine::GetMutex() );
+          Application::PostEvent( boost::bind( &StateSpeedlinePath::set, world_path_state, Path(), ActionSource::NONE_E ) );
+          return;
+        }
+
+        const typename PATH_TYPE::VertexListType* vertexList = path->GetVertexList();
+        points.reserve( vertexList->Size() );
+        for (size_t j = 0; j < vertexList->Size(); ++j)
+        {
+          points.push_back( build_3D_point< PATH_TYPE >( vertexList->GetElement(j) ) );
+        }
       }
 
-      const typename PATH_TYPE::VertexListType* vertexList = path->GetVertexList();
-      for (size_t j = 0; j < vertexList->Size(); ++j)
+      for ( size_t j = 0; j < points.size(); ++j )
       {
-        Point point = build_3D_point< PATH_TYPE >( vertexList->GetElement(j) );
-        new_path.add_a_point( point );
+        new_path.add_a_point( points[ j ] );
       }
 
       this->world_paths_.add_one_path( new_path );
     }
 
+    cache.segments_.swap( segments );
+
     StateEngine::lock_type lock( StateEngine::GetMutex() );
     Application::PostEvent( boost::bind( &StateSpeedlinePath::set, world_path_state, this->world_paths_, ActionSource::NONE_E ) );
   }
@@ -30,35 +30,45 @@
 #ifndef FASTGROWCUT_H
 #define FASTGROWCUT_H
 
-#include <math.h>
-#include <queue>
-#include <set>
-#include <vector>
 #include <stdlib.h>
-#include <fstream>
-#include <iterator>
+#include <limits>
+#include <vector>
 
-#include "utilities.h"
+#include "RadixHeap.h"
 
-#include "fibheap.h"
-#include "HeapNode.h"
 namespace FGC {
 
-const float DIST_INF = std::numeric_limits<float>::max();
-const float DIST_EPSION = 1e-3;
+typedef RadixHeap::KeyType DistPixelType;
+const DistPixelType DIST_INF = std::numeric_limits<DistPixelType>::max();
 const unsigned char NNGBH = 26;
-typedef float FPixelType;
 
+// GrowCut on a region of interest of a volume. The source values and seeds are copied out of
+// the volume for the region only, and the result is written back into it, so the memory used
+// is proportional to the region. As the source values are integers, the distances are exact
+// integers and the propagation uses a radix heap instead of a Fibonacci heap.
 template<typename SrcPixelType, typename LabPixelType>
 class FastGrowCut {
 public:
-  void SetSourceImage( const std::vector<SrcPixelType>& imSrc );
-  void SetSeedlImage( std::vector<LabPixelType>& imSeed );
-  void SetWorkMode( bool bSegInitialized = false );
+  // Set the size of the volume and the region of interest, given as the first and last index
+  // along each axis: [x0, y0, z0, x1, y1, z1]
   void SetImageSize( const std::vector<long>& imSize );
+  void SetROI( const std::vector<long>& imROI );
+
+  // Copy the source values in the region of interest out of the volume
+  template<typename VolumePixelType>
+  void SetSourceImage( const VolumePixelType* imSrc );
+
+  // Clear the seeds, then label the voxels of the region of interest that are set in a mask
+  // bit-plane of the volume. Voxels that already have a label keep it.
+  void ClearSeedImage();
+  void AddSeedImage( const unsigned char* maskData, unsigned char maskValue, LabPixelType label );
+
+  void SetWorkMode( bool bSegInitialized = false );
   void DoSegmentation();
-  void GetLabeImage( std::vector<LabPixelType>& imLab );
-  void GetForegroundmage( std::vector<LabPixelType>& imFgrd );
+
+  // Set or clear a mask bit-plane of the volume within the region of interest, depending on
+  // whether a voxel was labeled as foreground
+  void GetForegroundImage( unsigned char* maskData, unsigned char maskValue ) const;
 
 private:
   void InitializationAHP();
@@ -67,17 +77,16 @@ private:
   std::vector<SrcPixelType> m_imSrc;
   std::vector<LabPixelType> m_imSeed;
   std::vector<LabPixelType> m_imLabPre;
-  std::vector<FPixelType> m_imDistPre;
+  std::vector<DistPixelType> m_imDistPre;
   std::vector<LabPixelType> m_imLab;
-  std::vector<FPixelType> m_imDist;
+  std::vector<DistPixelType> m_imDist;
 
   std::vector<long> m_imSize;
+  std::vector<long> m_imROI;
   long m_DIMX{0}, m_DIMY{0}, m_DIMZ{0}, m_DIMXY{0}, m_DIMXYZ{0};
-  std::vector<int> m_indOff;
-  std::vector<unsigned char>  m_NBSIZE;
+  std::vector<long> m_indOff;
 
-  FibHeap m_heap;
-  std::vector<HeapNode> m_hpNodes;
+  RadixHeap m_heap;
   bool m_bSegInitialized {false};
 };
 } // end namespace FGC
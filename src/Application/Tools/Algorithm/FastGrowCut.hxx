@@ -1,4 +1,3 @@
-
 /*
    For more information, please see: http://software.sci.utah.edu
 
@@ -30,217 +29,189 @@
 
 #include "FastGrowCut.h"
 
-#include "itkImageRegionIterator.h"
-#include "itkImageRegionIteratorWithIndex.h"
-#include "itkNumericTraits.h"
-#include "itkRegionOfInterestImageFilter.h"
-#include "HeapNode.h"
+#include <algorithm>
 
 namespace FGC {
 
 template<typename SrcPixelType, typename LabPixelType>
 void FastGrowCut<SrcPixelType, LabPixelType>
-::SetSourceImage(const std::vector<SrcPixelType>& imSrc) {
+::SetImageSize(const std::vector<long>& imSize) {
 
-    m_imSrc = imSrc;
+    m_imSize = imSize;
 }
 
 template<typename SrcPixelType, typename LabPixelType>
 void FastGrowCut<SrcPixelType, LabPixelType>
-::SetSeedlImage(std::vector<LabPixelType>& imSeed) {
+::SetROI(const std::vector<long>& imROI) {
+
+    m_imROI = imROI;
+    m_DIMX = m_imROI[3] - m_imROI[0] + 1;
+    m_DIMY = m_imROI[4] - m_imROI[1] + 1;
+    m_DIMZ = m_imROI[5] - m_imROI[2] + 1;
+    m_DIMXY = m_DIMX*m_DIMY;
+    m_DIMXYZ = m_DIMXY*m_DIMZ;
+}
 
-    m_imSeed = imSeed;
+template<typename SrcPixelType, typename LabPixelType>
+template<typename VolumePixelType>
+void FastGrowCut<SrcPixelType, LabPixelType>
+::SetSourceImage(const VolumePixelType* imSrc) {
+
+    m_imSrc.resize(m_DIMXYZ);
+    long j, k, kk = 0;
+    for(k = 0; k < m_DIMZ; k++)
+        for(j = 0; j < m_DIMY; j++) {
+            const VolumePixelType* row = imSrc + m_imROI[0] +
+                (m_imROI[1] + j)*m_imSize[0] + (m_imROI[2] + k)*m_imSize[0]*m_imSize[1];
+            for(long i = 0; i < m_DIMX; i++) {
+                m_imSrc[kk++] = static_cast<SrcPixelType>(row[i]);
+            }
+        }
 }
 
 template<typename SrcPixelType, typename LabPixelType>
 void FastGrowCut<SrcPixelType, LabPixelType>
-::SetWorkMode(bool bSegUnInitialized ) {
+::ClearSeedImage() {
 
-    m_bSegInitialized = bSegUnInitialized;
+    m_imSeed.assign(m_DIMXYZ, 0);
 }
+
 template<typename SrcPixelType, typename LabPixelType>
 void FastGrowCut<SrcPixelType, LabPixelType>
-::SetImageSize(const std::vector<long>& imSize) {
+::AddSeedImage(const unsigned char* maskData, unsigned char maskValue, LabPixelType label) {
+
+    long j, k, kk = 0;
+    for(k = 0; k < m_DIMZ; k++)
+        for(j = 0; j < m_DIMY; j++) {
+            const unsigned char* row = maskData + m_imROI[0] +
+                (m_imROI[1] + j)*m_imSize[0] + (m_imROI[2] + k)*m_imSize[0]*m_imSize[1];
+            for(long i = 0; i < m_DIMX; i++, kk++) {
+                if(m_imSeed[kk] == 0 && (row[i] & maskValue)) m_imSeed[kk] = label;
+            }
+        }
+}
 
-    m_imSize = imSize;
+template<typename SrcPixelType, typename LabPixelType>
+void FastGrowCut<SrcPixelType, LabPixelType>
+::SetWorkMode(bool bSegUnInitialized ) {
+
+    m_bSegInitialized = bSegUnInitialized;
 }
 
 template<typename SrcPixelType, typename LabPixelType>
 void FastGrowCut<SrcPixelType, LabPixelType>
 ::InitializationAHP() {
 
-     m_DIMX = m_imSize[0];
-     m_DIMY = m_imSize[1];
-     m_DIMZ = m_imSize[2];
-     m_DIMXY = m_DIMX*m_DIMY;
-     m_DIMXYZ = m_DIMXY*m_DIMZ;
-
-     m_hpNodes.resize(m_DIMXYZ+1);
-    m_heap.ClearHeapOwnership();
-
-    long  i,j,k, index;
-     if(!m_bSegInitialized) {
-         m_imLab.resize(m_DIMXYZ);
-         m_imDist.resize(m_DIMXYZ);
-         m_imLabPre.resize(m_DIMXYZ);
-         m_imDistPre.resize(m_DIMXYZ);
-         // Compute index offset
-         m_indOff.clear();
-         long ix,iy,iz;
-         for(ix = -1; ix <= 1; ix++)
-             for(iy = -1; iy <= 1; iy++)
-                 for(iz = -1; iz <= 1; iz++) {
-                     if(!(ix == 0 && iy == 0 && iz == 0)) {
-                         m_indOff.push_back(ix + iy*m_DIMX + iz*m_DIMXY);
-                     }
-                 }
-
-         // Determine neighborhood size at each vertice
-         m_NBSIZE = std::vector<unsigned char>(m_DIMXYZ, 0);
-         for(i = 1; i < m_DIMX - 1; i++)
-             for(j = 1; j < m_DIMY - 1; j++)
-                 for(k = 1; k < m_DIMZ - 1; k++) {
-                     index = i + j*m_DIMX + k*m_DIMXY;
-                     m_NBSIZE[index] = NNGBH;
-                 }
-
-         for(index = 0; index < m_DIMXYZ; index++) {
-             m_imLab[index] = m_imSeed[index];
-             if(m_imLab[index] == 0) {
-                 m_hpNodes[index] = (float)DIST_INF;
-                 m_imDist[index] = DIST_INF;
-             }
-             else {
-                 m_hpNodes[index] = (float)DIST_EPSION;
-                 m_imDist[index] = DIST_EPSION;
-              }
-
-              m_heap.Insert(&m_hpNodes[index]);
-              m_hpNodes[index].SetIndexValue(index);
-         }
-     }
-     // SB: If already initialized, then build heap
-     else {
-         for(index = 0; index < m_DIMXYZ; index++) {
-             if(m_imSeed[index] != 0 && m_imSeed[index] != m_imLabPre[index]) {
-//             if(m_imSeed[index] != 0 && (m_imDistPre[index] != 0 ||  (m_imDistPre[index] == 0 && \
-//               m_imSeed[index] != m_imLabPre[index]))) {
-                 m_hpNodes[index] = (float)DIST_EPSION;
-                 m_imDist[index] = DIST_EPSION;
-                 m_imLab[index] = m_imSeed[index];
-             }
-             else {
-                 m_hpNodes[index] = (float)DIST_INF;
-                 m_imDist[index] = DIST_INF;
-                 m_imLab[index] = 0;
-             }
-             m_heap.Insert(&m_hpNodes[index]);
-             m_hpNodes[index].SetIndexValue(index);
-         }
-     }
+    m_heap.Clear();
+    m_imLab.resize(m_DIMXYZ);
+    m_imDist.resize(m_DIMXYZ);
+
+    long index;
+    if(!m_bSegInitialized) {
+        m_imLabPre.resize(m_DIMXYZ);
+        m_imDistPre.resize(m_DIMXYZ);
+
+        // Compute index offset
+        m_indOff.clear();
+        long ix,iy,iz;
+        for(ix = -1; ix <= 1; ix++)
+            for(iy = -1; iy <= 1; iy++)
+                for(iz = -1; iz <= 1; iz++) {
+                    if(!(ix == 0 && iy == 0 && iz == 0)) {
+                        m_indOff.push_back(ix + iy*m_DIMX + iz*m_DIMXY);
+                    }
+                }
+
+        for(index = 0; index < m_DIMXYZ; index++) {
+            m_imLab[index] = m_imSeed[index];
+            if(m_imLab[index] == 0) {
+                m_imDist[index] = DIST_INF;
+            }
+            else {
+                m_imDist[index] = 0;
+                m_heap.Push(0, index);
+            }
+        }
+    }
+    // SB: If already initialized, only the new seeds start the propagation
+    else {
+        for(index = 0; index < m_DIMXYZ; index++) {
+            if(m_imSeed[index] != 0 && m_imSeed[index] != m_imLabPre[index]) {
+                m_imDist[index] = 0;
+                m_imLab[index] = m_imSeed[index];
+                m_heap.Push(0, index);
+            }
+            else {
+                m_imDist[index] = DIST_INF;
+                m_imLab[index] = 0;
+            }
+        }
+    }
 }
 
 template<typename SrcPixelType, typename LabPixelType>
 void FastGrowCut<SrcPixelType, LabPixelType>
 ::DijkstraBasedClassificationAHP() {
 
-    HeapNode *hnMin, hnTmp;
-    float t, tOri, tSrc;
-    long i, index, indexNgbh;
+    DistPixelType tSrc;
+    unsigned long long t;
+    long i, index, indexNgbh, x, y, z;
     LabPixelType labSrc;
-    SrcPixelType pixCenter;
+    int pixCenter;
 
-    // Insert 0 then extract it, which will balance heap
-    m_heap.Insert(&hnTmp); m_heap.ExtractMin();
+    while(!m_heap.IsEmpty()) {
+        m_heap.Pop(tSrc, index);
 
-    long k = 0;
-
-    // Adpative Dijkstra if already initialized
-    if(m_bSegInitialized) {
-        while(!m_heap.IsEmpty()) {
-            hnMin = (HeapNode *) m_heap.ExtractMin();
-            index = hnMin->GetIndexValue();
-            tSrc = hnMin->GetKeyValue();
-
-            // stop propagation when the new distance is larger than the previous one
-            if(tSrc == DIST_INF) break;
-            if(tSrc > m_imDistPre[index]) {
-                m_imDist[index] = m_imDistPre[index];
-                m_imLab[index] = m_imLabPre[index];
-                continue;
-            }
+        // Skip entries that were superseded by a shorter distance
+        if(tSrc != m_imDist[index]) continue;
 
-            labSrc = m_imLab[index];
-            m_imDist[index] = tSrc;
+        // Adpative Dijkstra: stop propagation when the new distance is larger than the
+        // previous one
+        if(m_bSegInitialized && tSrc > m_imDistPre[index]) {
+            m_imDist[index] = m_imDistPre[index];
+            m_imLab[index] = m_imLabPre[index];
+            continue;
+        }
 
-             // Update neighbors
-            pixCenter = m_imSrc[index];
-            for(i = 0; i < m_NBSIZE[index]; i++) {
+        // Only the voxels inside the region propagate their label
+        z = index / m_DIMXY;
+        y = (index - z*m_DIMXY) / m_DIMX;
+        x = index - z*m_DIMXY - y*m_DIMX;
+        if(x == 0 || x == m_DIMX - 1 || y == 0 || y == m_DIMY - 1 || z == 0 || z == m_DIMZ - 1) {
+            continue;
+        }
 
-                    indexNgbh = index + m_indOff[i];
-                    tOri = m_imDist[indexNgbh];
-                    t = std::abs(pixCenter - m_imSrc[indexNgbh]) + tSrc;
-                    if(tOri > t) {
-                        m_imDist[indexNgbh] = t;
-                        m_imLab[indexNgbh] = labSrc;
+        labSrc = m_imLab[index];
 
-                        hnTmp = m_hpNodes[indexNgbh];
-                        hnTmp.SetKeyValue(t);
-                        m_heap.DecreaseKey(&m_hpNodes[indexNgbh], hnTmp);
-                    }
+        // Update neighbors
+        pixCenter = m_imSrc[index];
+        for(i = 0; i < NNGBH; i++) {
 
+            indexNgbh = index + m_indOff[i];
+            t = static_cast<unsigned long long>(tSrc) +
+                static_cast<unsigned long long>(std::abs(pixCenter - static_cast<int>(m_imSrc[indexNgbh])));
+            if(t >= DIST_INF) t = DIST_INF - 1;
+            if(m_imDist[indexNgbh] > t) {
+                m_imDist[indexNgbh] = static_cast<DistPixelType>(t);
+                m_imLab[indexNgbh] = labSrc;
+                m_heap.Push(static_cast<DistPixelType>(t), indexNgbh);
             }
-
-            k++;
-
         }
+    }
 
-        // Update previous labels and distance information
-        for(long i = 0; i < m_DIMXYZ; i++) {
-            if(m_imDist[i] < DIST_INF) {
-                m_imLabPre[i] = m_imLab[i];
-                m_imDistPre[i] = m_imDist[i];
+    // Update previous labels and distance information
+    if(m_bSegInitialized) {
+        for(index = 0; index < m_DIMXYZ; index++) {
+            if(m_imDist[index] < DIST_INF) {
+                m_imLabPre[index] = m_imLab[index];
+                m_imDistPre[index] = m_imDist[index];
             }
         }
-        std::copy(m_imLabPre.begin(), m_imLabPre.end(), m_imLab.begin());
-        std::copy(m_imDistPre.begin(), m_imDistPre.end(), m_imDist.begin());
     }
-     // Normal Dijkstra to be used in initializing the segmenter for the current image
     else {
-        while(!m_heap.IsEmpty()) {
-            hnMin = (HeapNode *) m_heap.ExtractMin();
-            index = hnMin->GetIndexValue();
-            tSrc = hnMin->GetKeyValue();
-            labSrc = m_imLab[index];
-            m_imDist[index] = tSrc;
-
-             // Update neighbors
-            pixCenter = m_imSrc[index];
-            for(i = 0; i < m_NBSIZE[index]; i++) {
-
-                    indexNgbh = index + m_indOff[i];
-                    tOri = m_imDist[indexNgbh];
-                    t = std::abs(pixCenter - m_imSrc[indexNgbh]) + tSrc;
-                    if(tOri > t) {
-                        m_imDist[indexNgbh] = t;
-                        m_imLab[indexNgbh] = labSrc;
-
-                        hnTmp = m_hpNodes[indexNgbh];
-                        hnTmp.SetKeyValue(t);
-                        m_heap.DecreaseKey(&m_hpNodes[indexNgbh], hnTmp);
-                    }
-
-            }
-
-            k++;
-
-        }
+        m_imLabPre.swap(m_imLab);
+        m_imDistPre.swap(m_imDist);
     }
-
-    std::copy(m_imLab.begin(), m_imLab.end(), m_imLabPre.begin());
-    std::copy(m_imDist.begin(), m_imDist.end(), m_imDistPre.begin());
-
-    m_hpNodes.clear();
 }
 
 template<typename SrcPixelType, typename LabPixelType>
@@ -254,22 +225,18 @@ void FastGrowCut<SrcPixelType, LabPixelType>
 
 template<typename SrcPixelType, typename LabPixelType>
 void FastGrowCut<SrcPixelType, LabPixelType>
-::GetLabeImage(std::vector<LabPixelType>& imLab) {
-
-    imLab.resize(m_DIMXYZ);
-    std::copy(m_imLab.begin(), m_imLab.end(), imLab.begin());
-}
-
-template<typename SrcPixelType, typename LabPixelType>
-void FastGrowCut<SrcPixelType, LabPixelType>
-::GetForegroundmage(std::vector<LabPixelType>& imFgrd) {
-
-    long index;
-    imFgrd.resize(m_DIMXYZ);
-    index = 0;
-    for(index = 0; index < m_DIMXYZ; index++) {
-        imFgrd[index] = m_imLab[index] == 1 ? 1 :0;
-    }
-
+::GetForegroundImage(unsigned char* maskData, unsigned char maskValue) const {
+
+    const unsigned char notMaskValue = ~maskValue;
+    long j, k, kk = 0;
+    for(k = 0; k < m_DIMZ; k++)
+        for(j = 0; j < m_DIMY; j++) {
+            unsigned char* row = maskData + m_imROI[0] +
+                (m_imROI[1] + j)*m_imSize[0] + (m_imROI[2] + k)*m_imSize[0]*m_imSize[1];
+            for(long i = 0; i < m_DIMX; i++, kk++) {
+                if(m_imLabPre[kk] == 1) row[i] |= maskValue;
+                else row[i] &= notMaskValue;
+            }
+        }
 }
 } // end FGC
@@ -27,23 +27,24 @@
  */
  // Adapted from: https://github.com/ljzhu/FastGrowCut
 
-#include <Application/Tools/Algorithm/GrowCutter.h>
+#include <algorithm>
+
+#include <Core/Utils/Log.h>
 
-//itk
-#include <itkImageRegionIterator.h>
+#include <Application/Tools/Algorithm/GrowCutter.h>
 
 namespace Seg3D
 {
 
+// Number of voxels the bounding box of the seeds is padded with on each side
+static const long ROI_PADDING_C = 17;
+
 //---------------------------------------------------------------------------
-GrowCutter::GrowCutter()
+GrowCutter::GrowCutter() :
+  foreground_statistics_( new Core::MaskStatistics ),
+  background_statistics_( new Core::MaskStatistics )
 {
   this->reset_growcut();
-  for ( unsigned int i = 0; i < 3; i++ )
-  {
-    this->bbox_lower_[i] = 0;
-    this->bbox_upper_[i] = 0;
-  }
 }
 
 //---------------------------------------------------------------------------
@@ -51,136 +52,149 @@ GrowCutter::~GrowCutter()
 {}
 
 //---------------------------------------------------------------------------
-void GrowCutter::set_data_image( typename DataImageType::Pointer data_image )
+void GrowCutter::set_data_block( Core::DataBlockHandle data_block )
 {
-  this->data_image_ = data_image;
+  this->data_block_ = data_block;
 }
 
 //---------------------------------------------------------------------------
-void GrowCutter::set_foreground_image( typename ImageType::Pointer foreground_image )
+void GrowCutter::set_foreground_mask( Core::MaskDataBlockHandle foreground_mask )
 {
-  this->foreground_image_ = foreground_image;
+  this->foreground_mask_ = foreground_mask;
 }
 
 //---------------------------------------------------------------------------
-void GrowCutter::set_background_image( typename ImageType::Pointer background_image )
+void GrowCutter::set_background_mask( Core::MaskDataBlockHandle background_mask )
 {
-  this->background_image_ = background_image;
+  this->background_mask_ = background_mask;
 }
 
 //---------------------------------------------------------------------------
-void GrowCutter::set_output_image( typename ImageType::Pointer output_image )
+void GrowCutter::set_output_mask( Core::MaskDataBlockHandle output_mask )
 {
-  this->output_image_ = output_image;
+  this->output_mask_ = output_mask;
 }
 
 //---------------------------------------------------------------------------
-void GrowCutter::execute()
+template< class T >
+void GrowCutter::set_source_image( const Core::DataBlockHandle& data_block )
 {
-  typedef itk::Image< unsigned char, 3 > ImageType;
-  typedef itk::Image< short, 3 > DataImageType;
-  typedef itk::ImageRegionIterator< ImageType > IteratorType;
-  typedef ImageType::RegionType RegionType;
-
-  ImageType::RegionType original_region = this->foreground_image_->GetLargestPossibleRegion();
-  RegionType::SizeType img_size = original_region.GetSize();
-  RegionType::IndexType img_corner = original_region.GetIndex();
-
-  ImageType::IndexType idx;
-  ImageType::IndexType lower = img_corner + img_size;
-  ImageType::IndexType upper = img_corner;
-
-  IteratorType fit( this->foreground_image_, this->foreground_image_->GetLargestPossibleRegion() );
-  IteratorType bit( this->background_image_, this->background_image_->GetLargestPossibleRegion() );
-
-  fit.GoToBegin();
-  bit.GoToBegin();
+  this->fast_grow_cut_->SetSourceImage( reinterpret_cast< const T* >( data_block->get_data() ) );
+}
 
-  // set foreground pixels to 1, background to 2
-  for (; !fit.IsAtEnd(); ++fit, ++bit )
+//---------------------------------------------------------------------------
+bool GrowCutter::execute()
+{
+  // Find the bounding box of the seeds, only the slices that were painted since the last
+  // run are scanned again
+  this->foreground_statistics_->update( this->foreground_mask_ );
+  this->background_statistics_->update( this->background_mask_ );
+
+  Core::IndexVector lower, upper, mask_lower, mask_upper;
+  bool found_seeds = false;
+  if ( this->foreground_statistics_->get_bounding_box( lower, upper ) )
   {
-    ImageType::PixelType foreground_pixel = fit.Get();
-    ImageType::PixelType background_pixel = bit.Get();
-
-    if ( foreground_pixel == 1 || background_pixel == 1 )
+    found_seeds = true;
+  }
+  if ( this->background_statistics_->get_bounding_box( mask_lower, mask_upper ) )
+  {
+    if ( found_seeds )
     {
-      idx = bit.GetIndex();
-      // update the bounding box
-      for ( unsigned int i = 0; i < 3; i++ )
+      for ( size_t i = 0; i < 3; i++ )
       {
-        if ( lower[i] > idx[i] )
-        {
-          lower[i] = idx[i];
-        }
-        if ( upper[i] < idx[i] )
-        {
-          upper[i] = idx[i];
-        }
-      }
-
-      // combine fore and back
-      if ( foreground_pixel == 1 ) // foreground takes precedence
-      {
-        bit.Set( 1 );
-      }
-      else
-      {
-        if ( background_pixel == 1 )
-        {
-          bit.Set( 2 );
-        }
+        lower[ i ] = std::min( lower[ i ], mask_lower[ i ] );
+        upper[ i ] = std::max( upper[ i ], mask_upper[ i ] );
       }
     }
+    else
+    {
+      lower = mask_lower;
+      upper = mask_upper;
+    }
+    found_seeds = true;
   }
 
-  // check if bounding box has changed
-  bool needs_reset = false;
-  for ( unsigned int i = 0; i < 3; i++ )
+  if ( !found_seeds )
   {
-    if ( this->bbox_lower_[i] != lower[i] || this->bbox_upper_[i] != upper[i] )
-    {
-      needs_reset = true;
-    }
+    return false;
   }
 
-  if ( needs_reset )
+  // check if bounding box has changed
+  if ( this->bbox_lower_ != lower || this->bbox_upper_ != upper )
   {
     // reset growcut because the bounding box has changed
     this->reset_growcut();
     this->bbox_lower_ = lower;
     this->bbox_upper_ = upper;
-    std::cerr << "Bounding box changed, resetting growcut\n";
+    CORE_LOG_DEBUG( "Bounding box changed, resetting growcut" );
   }
 
-  // Call GrowCut
-  // TODO: Add segmenter initialization flag check. See CarreraSliceEffect.py
+  std::vector< long > image_size( 3 );
+  image_size[ 0 ] = static_cast< long >( this->data_block_->get_nx() );
+  image_size[ 1 ] = static_cast< long >( this->data_block_->get_ny() );
+  image_size[ 2 ] = static_cast< long >( this->data_block_->get_nz() );
+
   if ( this->initialization_flag_ == false )
   {
-    this->fast_grow_cut_->SetInput( data_image_ );
-    this->fast_grow_cut_->SetSeedImage( background_image_ );
-    this->fast_grow_cut_->SetInitializationFlag( this->initialization_flag_ );
-    this->fast_grow_cut_->GenerateData();
-    this->initialization_flag_ = true;
+    // Pad the bounding box of the seeds, GrowCut only runs within this region
+    std::vector< long > roi( 6 );
+    for ( size_t i = 0; i < 3; i++ )
+    {
+      roi[ i ] = std::max( static_cast< long >( lower[ i ] ) - ROI_PADDING_C, 0l );
+      roi[ i + 3 ] = std::min( static_cast< long >( upper[ i ] ) + ROI_PADDING_C, 
+        image_size[ i ] - 1 );
+    }
+    this->fast_grow_cut_->SetImageSize( image_size );
+    this->fast_grow_cut_->SetROI( roi );
+
+    // NOTE: GrowCut works on the data converted to short
+    Core::DataBlock::shared_lock_type lock( this->data_block_->get_mutex() );
+    switch ( this->data_block_->get_data_type() )
+    {
+    case Core::DataType::CHAR_E: this->set_source_image< signed char >( this->data_block_ ); break;
+    case Core::DataType::UCHAR_E: this->set_source_image< unsigned char >( this->data_block_ ); break;
+    case Core::DataType::SHORT_E: this->set_source_image< short >( this->data_block_ ); break;
+    case Core::DataType::USHORT_E: this->set_source_image< unsigned short >( this->data_block_ ); break;
+    case Core::DataType::INT_E: this->set_source_image< int >( this->data_block_ ); break;
+    case Core::DataType::UINT_E: this->set_source_image< unsigned int >( this->data_block_ ); break;
+    case Core::DataType::LONGLONG_E: this->set_source_image< long long >( this->data_block_ ); break;
+    case Core::DataType::ULONGLONG_E: this->set_source_image< unsigned long long >( this->data_block_ ); break;
+    case Core::DataType::FLOAT_E: this->set_source_image< float >( this->data_block_ ); break;
+    case Core::DataType::DOUBLE_E: this->set_source_image< double >( this->data_block_ ); break;
+    default: return false;
+    }
   }
-  else
+
+  // set foreground seeds to 1, background to 2, foreground takes precedence
+  this->fast_grow_cut_->ClearSeedImage();
   {
-    this->fast_grow_cut_->SetSeedImage( background_image_ );
-    this->fast_grow_cut_->SetInitializationFlag( this->initialization_flag_ );
-    this->fast_grow_cut_->GenerateData();
+    Core::MaskDataBlock::shared_lock_type lock( this->foreground_mask_->get_mutex() );
+    this->fast_grow_cut_->AddSeedImage( this->foreground_mask_->get_mask_data(), 
+      this->foreground_mask_->get_mask_value(), 1 );
+  }
+  {
+    Core::MaskDataBlock::shared_lock_type lock( this->background_mask_->get_mutex() );
+    this->fast_grow_cut_->AddSeedImage( this->background_mask_->get_mask_data(), 
+      this->background_mask_->get_mask_value(), 2 );
   }
-  this->output_image_ = this->fast_grow_cut_->GetOutput();
-}
 
-//---------------------------------------------------------------------------
-typename GrowCutter::ImageType::Pointer GrowCutter::get_output()
-{
-  return this->output_image_;
+  this->fast_grow_cut_->SetWorkMode( this->initialization_flag_ );
+  this->fast_grow_cut_->DoSegmentation();
+  this->initialization_flag_ = true;
+
+  {
+    Core::MaskDataBlock::lock_type lock( this->output_mask_->get_mutex() );
+    this->fast_grow_cut_->GetForegroundImage( this->output_mask_->get_mask_data(), 
+      this->output_mask_->get_mask_value() );
+  }
+
+  return true;
 }
 
 //---------------------------------------------------------------------------
 void GrowCutter::reset_growcut()
 {
-  this->fast_grow_cut_ = FastGrowCutType::New();
+  this->fast_grow_cut_.reset( new FastGrowCutType );
   this->initialization_flag_ = false;
 }
 }
@@ -30,51 +30,65 @@
 #ifndef APPLICATION_ALGORITHM_GROWCUTTER_H
 #define APPLICATION_ALGORITHM_GROWCUTTER_H
 
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 
-#include <itkImage.h>
+#include <Core/DataBlock/DataBlock.h>
+#include <Core/DataBlock/MaskDataBlock.h>
+#include <Core/DataBlock/MaskStatistics.h>
+#include <Core/Geometry/IndexVector.h>
 
 //GrowCut
-#include <itkSmartPointer.h>
-#include "itkFastGrowCut.h"
+#include <Application/Tools/Algorithm/FastGrowCut.h>
 
 namespace Seg3D {
 
 class GrowCutter;
 typedef boost::shared_ptr<GrowCutter> GrowCutterHandle;
 
+// GrowCutter runs GrowCut on a padded bounding box around the foreground and background seeds.
+// The data and the seeds are read directly from their data blocks and the result is written
+// into the bit-plane of the output mask. As long as the bounding box of the seeds does not
+// change, successive runs only propagate from the seeds that changed.
 class GrowCutter
 {
 public:
   GrowCutter();
   ~GrowCutter();
 
-  typedef itk::Image< unsigned char, 3 > ImageType;
-  typedef itk::Image< short, 3 > DataImageType;
-
-  void set_data_image( typename DataImageType::Pointer data_image );
-  void set_foreground_image( typename ImageType::Pointer foreground_image );
-  void set_background_image( typename ImageType::Pointer background_image );
-  void set_output_image( typename ImageType::Pointer output_image_ );
-  void execute();
+  void set_data_block( Core::DataBlockHandle data_block );
+  void set_foreground_mask( Core::MaskDataBlockHandle foreground_mask );
+  void set_background_mask( Core::MaskDataBlockHandle background_mask );
+  void set_output_mask( Core::MaskDataBlockHandle output_mask );
 
-  itk::Image<unsigned char, 3>::Pointer get_output();
+  // EXECUTE:
+  // Run GrowCut and write the foreground into the output mask. Returns false if there are no
+  // seeds.
+  bool execute();
 
 private:
 
   void reset_growcut();
 
-  typename DataImageType::Pointer data_image_;
-  typename ImageType::Pointer foreground_image_;
-  typename ImageType::Pointer background_image_;
-  typename ImageType::Pointer output_image_;
+  template< class T >
+  void set_source_image( const Core::DataBlockHandle& data_block );
+
+  Core::DataBlockHandle data_block_;
+  Core::MaskDataBlockHandle foreground_mask_;
+  Core::MaskDataBlockHandle background_mask_;
+  Core::MaskDataBlockHandle output_mask_;
   bool initialization_flag_;
 
-  using FastGrowCutType = itk::FastGrowCut< DataImageType, ImageType>;
-  typename FastGrowCutType::Pointer fast_grow_cut_;
+  typedef FGC::FastGrowCut< short, unsigned char > FastGrowCutType;
+  boost::shared_ptr< FastGrowCutType > fast_grow_cut_;
+
+  // The bounding boxes of the seeds are cached per slice
+  Core::MaskStatisticsHandle foreground_statistics_;
+  Core::MaskStatisticsHandle background_statistics_;
 
-  typename ImageType::IndexType bbox_lower_;
-  typename ImageType::IndexType bbox_upper_;
+  Core::IndexVector bbox_lower_;
+  Core::IndexVector bbox_upper_;
 };
 }
 
@@ -1,60 +0,0 @@
-/*
-   For more information, please see: http://software.sci.utah.edu
-
-   The MIT License
-
-   Copyright (c) 2021 Scientific Computing and Imaging Institute,
-   University of Utah.
-
-
-   Permission is hereby granted, free of charge, to any person obtaining a
-   copy of this software and associated documentation files (the "Software"),
-   to deal in the Software without restriction, including without limitation
-   the rights to use, copy, modify, merge, publish, distribute, sublicense,
-   and/or sell copies of the Software, and to permit persons to whom the
-   Software is furnished to do so, subject to the following conditions:
-
-   The above copyright notice and this permission notice shall be included
-   in all copies or substantial portions of the Software.
-
-   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
-   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
-   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
-   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
-   DEALINGS IN THE SOFTWARE.
- */
-//  Created by Salma Bengali on 4/15/14.
-
-#include "HeapNode.h"
-
-namespace FGC{
-void HeapNode::Print() {
-    FibHeapNode::Print();
-    //    mexPrintf( "%f (%d)" , N , IndexV );
-}
-
-void HeapNode::operator =(double NewKeyVal) {
-    HeapNode Tmp;
-    Tmp.N = N = NewKeyVal;
-    FHN_Assign(Tmp);
-}
-
-void HeapNode::operator =(FibHeapNode& RHS) {
-    FHN_Assign(RHS);
-    N = ((HeapNode&) RHS).N;
-}
-
-int  HeapNode::operator ==(FibHeapNode& RHS) {
-    if (FHN_Cmp(RHS)) return 0;
-    return N == ((HeapNode&) RHS).N ? 1 : 0;
-}
-
-int  HeapNode::operator <(FibHeapNode& RHS) {
-    int X;
-    if ((X=FHN_Cmp(RHS)) != 0)
-        return X < 0 ? 1 : 0;
-    return N < ((HeapNode&) RHS).N ? 1 : 0;
-}
-} // end namespace
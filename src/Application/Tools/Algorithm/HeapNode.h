@@ -1,56 +0,0 @@
-/*
-   For more information, please see: http://software.sci.utah.edu
-
-   The MIT License
-
-   Copyright (c) 2021 Scientific Computing and Imaging Institute,
-   University of Utah.
-
-
-   Permission is hereby granted, free of charge, to any person obtaining a
-   copy of this software and associated documentation files (the "Software"),
-   to deal in the Software without restriction, including without limitation
-   the rights to use, copy, modify, merge, publish, distribute, sublicense,
-   and/or sell copies of the Software, and to permit persons to whom the
-   Software is furnished to do so, subject to the following conditions:
-
-   The above copyright notice and this permission notice shall be included
-   in all copies or substantial portions of the Software.
-
-   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
-   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
-   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
-   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
-   DEALINGS IN THE SOFTWARE.
- */
-//  Created by Salma Bengali on 4/15/14.
-
-#ifndef ____HeapNode__
-#define ____HeapNode__
-
-#include "fibheap.h"
-/***************************************************************************
- * class HeapNode
- ***************************************************************************/
-namespace FGC {
-    class HeapNode : public FibHeapNode {
-        float   N;
-        long IndexV;
-
-    public:
-        HeapNode() : FibHeapNode() { N = 0; }
-        virtual void operator =(FibHeapNode& RHS);
-        virtual int  operator ==(FibHeapNode& RHS);
-        virtual int  operator <(FibHeapNode& RHS);
-        virtual void operator =(double NewKeyVal );
-        virtual void Print();
-        double GetKeyValue() { return N; }
-        void SetKeyValue(double n) { N = n; }
-        long int GetIndexValue() { return IndexV; }
-        void SetIndexValue( long int v) { IndexV = v; }
-    };
-}
-
-#endif /* defined(____HeapNode__) */
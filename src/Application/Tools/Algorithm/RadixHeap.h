@@ -0,0 +1,116 @@
+/*
+   For more information, please see: http://software.sci.utah.edu
+
+   The MIT License
+
+   Copyright (c) 2021 Scientific Computing and Imaging Institute,
+   University of Utah.
+
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included
+   in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+   THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+   DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RADIXHEAP_H
+#define RADIXHEAP_H
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace FGC {
+
+// Monotone priority queue for unsigned integer keys. Keys that are pushed may not be smaller
+// than the last key that was popped, which holds for Dijkstra with non-negative integer
+// weights. Elements are kept in buckets by the highest bit in which their key differs from
+// the last popped key, so every element is moved at most once per bit and the buckets are
+// plain arrays that are read and written sequentially.
+class RadixHeap {
+public:
+  typedef unsigned int KeyType;
+  typedef long ValueType;
+  typedef std::pair<KeyType, ValueType> ElementType;
+
+  RadixHeap() : m_Last(0), m_Size(0) {}
+
+  void Clear() {
+    for(unsigned int b = 0; b < NumberOfBuckets; b++) {
+      m_Buckets[b].clear();
+    }
+    m_Last = 0;
+    m_Size = 0;
+  }
+
+  bool IsEmpty() const { return m_Size == 0; }
+
+  size_t Size() const { return m_Size; }
+
+  void Push(KeyType key, ValueType value) {
+    assert(key >= m_Last);
+    m_Buckets[Bucket(key)].push_back(ElementType(key, value));
+    m_Size++;
+  }
+
+  // Remove an element with the smallest key
+  void Pop(KeyType& key, ValueType& value) {
+    assert(m_Size > 0);
+    if(m_Buckets[0].empty()) {
+      // Find the first non-empty bucket, its smallest key becomes the new reference and
+      // its elements are spread over the lower buckets
+      unsigned int b = 1;
+      while(m_Buckets[b].empty()) b++;
+
+      std::vector<ElementType>& bucket = m_Buckets[b];
+      KeyType last = bucket[0].first;
+      for(size_t i = 1; i < bucket.size(); i++) {
+        if(bucket[i].first < last) last = bucket[i].first;
+      }
+      m_Last = last;
+      for(size_t i = 0; i < bucket.size(); i++) {
+        m_Buckets[Bucket(bucket[i].first)].push_back(bucket[i]);
+      }
+      bucket.clear();
+    }
+
+    key = m_Buckets[0].back().first;
+    value = m_Buckets[0].back().second;
+    m_Buckets[0].pop_back();
+    m_Size--;
+  }
+
+private:
+  enum { NumberOfBuckets = sizeof(KeyType) * 8 + 1 };
+
+  // Bucket 0 holds the keys equal to the last popped key, bucket b the keys whose highest
+  // bit that differs from it is bit b - 1
+  unsigned int Bucket(KeyType key) const {
+    KeyType diff = key ^ m_Last;
+    unsigned int b = 0;
+    while(diff >= 256) { diff >>= 8; b += 8; }
+    while(diff) { diff >>= 1; b++; }
+    return b;
+  }
+
+  std::vector<ElementType> m_Buckets[NumberOfBuckets];
+  KeyType m_Last;
+  size_t m_Size;
+};
+
+} // end namespace FGC
+
+#endif // ifndef RADIXHEAP_H
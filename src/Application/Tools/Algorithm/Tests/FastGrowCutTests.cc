@@ -0,0 +1,253 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <Application/Tools/Algorithm/FastGrowCut.h>
+
+using namespace FGC;
+
+namespace
+{
+
+typedef FastGrowCut< short, unsigned char > FastGrowCutType;
+
+const long NX_C = 30, NY_C = 26, NZ_C = 22;
+const unsigned char FOREGROUND_C = 0x04, BACKGROUND_C = 0x10, OUTPUT_C = 0x40;
+
+inline long Index( long x, long y, long z )
+{
+  return x + NX_C * ( y + NY_C * z );
+}
+
+bool InBall( long x, long y, long z, double cx, double cy, double cz, double r )
+{
+  double dx = x - cx, dy = y - cy, dz = z - cz;
+  return dx * dx + dy * dy + dz * dz <= r * r;
+}
+
+// A bright ball on a noisy dark background
+std::vector< short > CreateSource()
+{
+  std::vector< short > source( NX_C * NY_C * NZ_C );
+  for ( long z = 0; z < NZ_C; z++ )
+    for ( long y = 0; y < NY_C; y++ )
+      for ( long x = 0; x < NX_C; x++ )
+      {
+        short noise = static_cast< short >( ( x * 7919 + y * 104729 + z * 1299709 ) % 11 );
+        source[ Index( x, y, z ) ] =
+          ( InBall( x, y, z, 14.0, 12.0, 11.0, 6.5 ) ? 200 : 20 ) + noise;
+      }
+  return source;
+}
+
+void AddBall( std::vector< unsigned char >& seeds, unsigned char value,
+  double cx, double cy, double cz, double r )
+{
+  for ( long z = 0; z < NZ_C; z++ )
+    for ( long y = 0; y < NY_C; y++ )
+      for ( long x = 0; x < NX_C; x++ )
+        if ( InBall( x, y, z, cx, cy, cz, r ) ) seeds[ Index( x, y, z ) ] |= value;
+}
+
+// Distances from the seeds that are set in a mask bit-plane, computed over the region of
+// interest with a binary heap. As in GrowCut, the voxels on the border of the region are
+// reached but do not propagate further.
+std::vector< unsigned long long > ReferenceDistances( const std::vector< short >& source,
+  const std::vector< unsigned char >& seeds, unsigned char value, const std::vector< long >& roi )
+{
+  const unsigned long long infinity = std::numeric_limits< unsigned long long >::max();
+  std::vector< unsigned long long > distances( source.size(), infinity );
+  typedef std::pair< unsigned long long, long > element_type;
+  std::priority_queue< element_type, std::vector< element_type >,
+    std::greater< element_type > > queue;
+
+  for ( long z = roi[ 2 ]; z <= roi[ 5 ]; z++ )
+    for ( long y = roi[ 1 ]; y <= roi[ 4 ]; y++ )
+      for ( long x = roi[ 0 ]; x <= roi[ 3 ]; x++ )
+        if ( seeds[ Index( x, y, z ) ] & value )
+        {
+          distances[ Index( x, y, z ) ] = 0;
+          queue.push( element_type( 0, Index( x, y, z ) ) );
+        }
+
+  while ( !queue.empty() )
+  {
+    element_type top = queue.top();
+    queue.pop();
+    if ( top.first != distances[ top.second ] ) continue;
+
+    long x = top.second % NX_C, y = ( top.second / NX_C ) % NY_C, z = top.second / ( NX_C * NY_C );
+    if ( x == roi[ 0 ] || x == roi[ 3 ] || y == roi[ 1 ] || y == roi[ 4 ] ||
+      z == roi[ 2 ] || z == roi[ 5 ] ) continue;
+
+    for ( long dz = -1; dz <= 1; dz++ )
+      for ( long dy = -1; dy <= 1; dy++ )
+        for ( long dx = -1; dx <= 1; dx++ )
+        {
+          long neighbor = Index( x + dx, y + dy, z + dz );
+          unsigned long long distance = top.first +
+            std::abs( source[ top.second ] - source[ neighbor ] );
+          if ( distance < distances[ neighbor ] )
+          {
+            distances[ neighbor ] = distance;
+            queue.push( element_type( distance, neighbor ) );
+          }
+        }
+  }
+  return distances;
+}
+
+// Check the voxels of the region whose label is decided without a tie. Voxels outside the
+// region and the other bits of the mask need to be unchanged.
+void ExpectSameLabels( const std::vector< unsigned char >& result,
+  const std::vector< unsigned char >& before, const std::vector< short >& source,
+  const std::vector< unsigned char >& seeds, const std::vector< long >& roi )
+{
+  std::vector< unsigned long long > foreground =
+    ReferenceDistances( source, seeds, FOREGROUND_C, roi );
+  std::vector< unsigned long long > background =
+    ReferenceDistances( source, seeds, BACKGROUND_C, roi );
+
+  size_t num_checked = 0, num_foreground = 0, num_wrong = 0;
+  for ( long z = 0; z < NZ_C; z++ )
+    for ( long y = 0; y < NY_C; y++ )
+      for ( long x = 0; x < NX_C; x++ )
+      {
+        long index = Index( x, y, z );
+        if ( ( result[ index ] & ~OUTPUT_C ) != ( before[ index ] & ~OUTPUT_C ) ) num_wrong++;
+
+        bool inside = x >= roi[ 0 ] && x <= roi[ 3 ] && y >= roi[ 1 ] && y <= roi[ 4 ] &&
+          z >= roi[ 2 ] && z <= roi[ 5 ];
+        if ( !inside )
+        {
+          if ( result[ index ] != before[ index ] ) num_wrong++;
+          continue;
+        }
+        if ( foreground[ index ] == background[ index ] ) continue;
+
+        bool expected = foreground[ index ] < background[ index ];
+        if ( ( ( result[ index ] & OUTPUT_C ) != 0 ) != expected ) num_wrong++;
+        num_checked++;
+        if ( expected ) num_foreground++;
+      }
+
+  EXPECT_EQ( 0u, num_wrong );
+  // Most of the region needs to be decided for the comparison to mean anything
+  long roi_size = ( roi[ 3 ] - roi[ 0 ] + 1 ) * ( roi[ 4 ] - roi[ 1 ] + 1 ) *
+    ( roi[ 5 ] - roi[ 2 ] + 1 );
+  EXPECT_LT( static_cast< size_t >( roi_size * 0.9 ), num_checked );
+  EXPECT_LT( 0u, num_foreground );
+  EXPECT_LT( num_foreground, num_checked );
+}
+
+void RunGrowCut( FastGrowCutType& grow_cut, const std::vector< unsigned char >& seeds,
+  bool initialized, std::vector< unsigned char >& output )
+{
+  grow_cut.ClearSeedImage();
+  grow_cut.AddSeedImage( &seeds[ 0 ], FOREGROUND_C, 1 );
+  grow_cut.AddSeedImage( &seeds[ 0 ], BACKGROUND_C, 2 );
+  grow_cut.SetWorkMode( initialized );
+  grow_cut.DoSegmentation();
+  grow_cut.GetForegroundImage( &output[ 0 ], OUTPUT_C );
+}
+
+}
+
+TEST( FastGrowCutTests, MatchesDijkstraOnRegion )
+{
+  std::vector< short > source = CreateSource();
+
+  // The region does not touch the border of the volume
+  std::vector< long > image_size( 3 );
+  image_size[ 0 ] = NX_C;
+  image_size[ 1 ] = NY_C;
+  image_size[ 2 ] = NZ_C;
+  std::vector< long > roi( 6 );
+  roi[ 0 ] = 3; roi[ 1 ] = 2; roi[ 2 ] = 4;
+  roi[ 3 ] = 26; roi[ 4 ] = 22; roi[ 5 ] = 18;
+
+  std::vector< unsigned char > seeds( source.size(), 0 );
+  AddBall( seeds, FOREGROUND_C, 14.0, 12.0, 11.0, 2.0 );
+  AddBall( seeds, BACKGROUND_C, 6.0, 5.0, 7.0, 1.5 );
+  AddBall( seeds, BACKGROUND_C, 23.0, 19.0, 15.0, 1.5 );
+
+  // Other bits of the output mask and the voxels outside the region are left alone
+  std::vector< unsigned char > output( source.size() );
+  for ( size_t j = 0; j < output.size(); j++ )
+  {
+    output[ j ] = static_cast< unsigned char >( ( j * 37 ) & 0xff );
+  }
+  std::vector< unsigned char > before = output;
+
+  FastGrowCutType grow_cut;
+  grow_cut.SetImageSize( image_size );
+  grow_cut.SetROI( roi );
+  grow_cut.SetSourceImage( &source[ 0 ] );
+  RunGrowCut( grow_cut, seeds, false, output );
+  {
+    SCOPED_TRACE( "initial segmentation" );
+    ExpectSameLabels( output, before, source, seeds, roi );
+  }
+
+  // Add background seeds inside the foreground that was found, the adaptive update needs to
+  // give the same labels as segmenting with all the seeds from scratch
+  std::vector< unsigned char > more_seeds = seeds;
+  AddBall( more_seeds, BACKGROUND_C, 17.0, 15.0, 14.0, 1.0 );
+  for ( size_t j = 0; j < more_seeds.size(); j++ )
+  {
+    if ( ( more_seeds[ j ] & ~seeds[ j ] ) != 0 )
+    {
+      ASSERT_TRUE( ( output[ j ] & OUTPUT_C ) != 0 );
+    }
+  }
+
+  RunGrowCut( grow_cut, more_seeds, true, output );
+  {
+    SCOPED_TRACE( "adaptive segmentation" );
+    ExpectSameLabels( output, before, source, more_seeds, roi );
+  }
+
+  std::vector< unsigned char > scratch_output = before;
+  FastGrowCutType scratch_grow_cut;
+  scratch_grow_cut.SetImageSize( image_size );
+  scratch_grow_cut.SetROI( roi );
+  scratch_grow_cut.SetSourceImage( &source[ 0 ] );
+  RunGrowCut( scratch_grow_cut, more_seeds, false, scratch_output );
+  {
+    SCOPED_TRACE( "segmentation from scratch" );
+    ExpectSameLabels( scratch_output, before, source, more_seeds, roi );
+  }
+}
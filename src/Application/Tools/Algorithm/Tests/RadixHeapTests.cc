@@ -0,0 +1,207 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <Application/Tools/Algorithm/RadixHeap.h>
+
+using namespace FGC;
+
+TEST( RadixHeapTests, MonotonePops )
+{
+  boost::random::mt19937 generator( 7 );
+  boost::random::uniform_int_distribution< int > choice( 0, 2 );
+  boost::random::uniform_int_distribution< int > bits( 0, 31 );
+
+  RadixHeap heap;
+  std::multiset< RadixHeap::ElementType > reference;
+  RadixHeap::KeyType last = 0;
+  long value = 0;
+
+  for ( int step = 0; step < 200000; step++ )
+  {
+    if ( reference.empty() || choice( generator ) != 0 )
+    {
+      // Keys may be pushed anywhere from the last popped key up to the largest key, spread
+      // over all the buckets
+      RadixHeap::KeyType max_offset = std::numeric_limits< RadixHeap::KeyType >::max() - last;
+      RadixHeap::KeyType range = ( static_cast< RadixHeap::KeyType >( 1 ) << bits( generator ) );
+      if ( range > max_offset ) range = max_offset;
+      RadixHeap::KeyType key = last + boost::random::uniform_int_distribution<
+        RadixHeap::KeyType >( 0, range )( generator );
+      heap.Push( key, value );
+      reference.insert( RadixHeap::ElementType( key, value ) );
+      value++;
+    }
+    else
+    {
+      RadixHeap::KeyType key;
+      long popped_value;
+      heap.Pop( key, popped_value );
+      ASSERT_GE( key, last );
+      ASSERT_EQ( reference.begin()->first, key );
+
+      // Elements with the same key may come out in any order
+      std::multiset< RadixHeap::ElementType >::iterator it =
+        reference.find( RadixHeap::ElementType( key, popped_value ) );
+      ASSERT_TRUE( it != reference.end() );
+      reference.erase( it );
+      last = key;
+    }
+    ASSERT_EQ( reference.size(), heap.Size() );
+    ASSERT_EQ( reference.empty(), heap.IsEmpty() );
+  }
+
+  // After clearing, the heap starts from key zero again
+  heap.Clear();
+  EXPECT_TRUE( heap.IsEmpty() );
+  heap.Push( 3, 1 );
+  heap.Push( 0, 2 );
+  RadixHeap::KeyType key;
+  long popped_value;
+  heap.Pop( key, popped_value );
+  EXPECT_EQ( 0u, key );
+  EXPECT_EQ( 2, popped_value );
+  heap.Pop( key, popped_value );
+  EXPECT_EQ( 3u, key );
+  EXPECT_EQ( 1, popped_value );
+  EXPECT_TRUE( heap.IsEmpty() );
+}
+
+TEST( RadixHeapTests, LazyDeletion )
+{
+  // Dijkstra on a random graph where a shorter distance is pushed as a new entry and the
+  // superseded entries are skipped when they are popped, as GrowCut does
+  const long num_nodes = 20000;
+  const int num_edges = 6;
+  boost::random::mt19937 generator( 11 );
+  boost::random::uniform_int_distribution< long > node( 0, num_nodes - 1 );
+  boost::random::uniform_int_distribution< RadixHeap::KeyType > weight( 0, 300 );
+
+  std::vector< std::vector< std::pair< long, RadixHeap::KeyType > > > edges( num_nodes );
+  for ( long j = 0; j < num_nodes; j++ )
+  {
+    for ( int k = 0; k < num_edges; k++ )
+    {
+      edges[ j ].push_back( std::make_pair( node( generator ), weight( generator ) ) );
+    }
+  }
+
+  const RadixHeap::KeyType infinity = std::numeric_limits< RadixHeap::KeyType >::max();
+  const long sources[] = { 0, 17, 4242 };
+
+  // Reference with a binary heap that tracks which nodes are done
+  std::vector< RadixHeap::KeyType > reference( num_nodes, infinity );
+  {
+    typedef std::pair< RadixHeap::KeyType, long > element_type;
+    std::priority_queue< element_type, std::vector< element_type >,
+      std::greater< element_type > > queue;
+    std::vector< char > done( num_nodes, 0 );
+    for ( int s = 0; s < 3; s++ )
+    {
+      reference[ sources[ s ] ] = 0;
+      queue.push( element_type( 0, sources[ s ] ) );
+    }
+    while ( !queue.empty() )
+    {
+      element_type top = queue.top();
+      queue.pop();
+      if ( done[ top.second ] ) continue;
+      done[ top.second ] = 1;
+      for ( size_t k = 0; k < edges[ top.second ].size(); k++ )
+      {
+        long next = edges[ top.second ][ k ].first;
+        RadixHeap::KeyType distance = top.first + edges[ top.second ][ k ].second;
+        if ( !done[ next ] && distance < reference[ next ] )
+        {
+          reference[ next ] = distance;
+          queue.push( element_type( distance, next ) );
+        }
+      }
+    }
+  }
+
+  RadixHeap heap;
+  std::vector< RadixHeap::KeyType > distances( num_nodes, infinity );
+  std::vector< int > num_expanded( num_nodes, 0 );
+  for ( int s = 0; s < 3; s++ )
+  {
+    distances[ sources[ s ] ] = 0;
+    heap.Push( 0, sources[ s ] );
+  }
+
+  size_t num_skipped = 0;
+  RadixHeap::KeyType last = 0;
+  while ( !heap.IsEmpty() )
+  {
+    RadixHeap::KeyType key;
+    long current;
+    heap.Pop( key, current );
+    ASSERT_GE( key, last );
+    last = key;
+
+    if ( key != distances[ current ] )
+    {
+      // A shorter distance was found after this entry was pushed
+      ASSERT_GT( key, distances[ current ] );
+      num_skipped++;
+      continue;
+    }
+    num_expanded[ current ]++;
+
+    for ( size_t k = 0; k < edges[ current ].size(); k++ )
+    {
+      long next = edges[ current ][ k ].first;
+      RadixHeap::KeyType distance = key + edges[ current ][ k ].second;
+      if ( distance < distances[ next ] )
+      {
+        distances[ next ] = distance;
+        heap.Push( distance, next );
+      }
+    }
+  }
+
+  EXPECT_LT( 0u, num_skipped );
+  size_t num_wrong = 0;
+  for ( long j = 0; j < num_nodes; j++ )
+  {
+    if ( distances[ j ] != reference[ j ] ) num_wrong++;
+    // Every reachable node is expanded once, with its final distance
+    if ( num_expanded[ j ] != ( reference[ j ] == infinity ? 0 : 1 ) ) num_wrong++;
+  }
+  EXPECT_EQ( 0u, num_wrong );
+}
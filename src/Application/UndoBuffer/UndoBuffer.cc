@@ -28,9 +28,16 @@
 
 // STL includes
 #include <deque>
+#include <vector>
+
+// Boost includes
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
 
 // Core includes
 #include <Core/Action/ActionContextContainer.h>
+#include <Core/Utils/Log.h>
+#include <Core/Utils/ThreadPool.h>
 
 // Application includes
 #include <Application/UndoBuffer/UndoBuffer.h>
@@ -75,10 +82,61 @@ public:
   
   UndoBuffer* buffer_;
   long long max_mem_;
+
+  // Directory where undo items are moved to when they do not fit in memory
+  boost::filesystem::path scratch_directory_;
   
   void handle_enable( bool enable );
+
+  // GET_SCRATCH_DIRECTORY:
+  // Get the scratch directory, it is created the first time it is needed
+  bool get_scratch_directory( boost::filesystem::path& directory );
+
+  // REMOVE_SCRATCH_DIRECTORY:
+  // Remove the scratch directory and any files that are left in it
+  void remove_scratch_directory();
+
+  // COMPRESS_ITEMS:
+  // Compress the data of the given items, run on a service thread
+  static void CompressItems( std::vector< UndoBufferItemHandle > items );
 };
 
+bool UndoBufferPrivate::get_scratch_directory( boost::filesystem::path& directory )
+{
+  if ( this->scratch_directory_.empty() )
+  {
+    boost::system::error_code ec;
+    boost::filesystem::path scratch_directory = boost::filesystem::temp_directory_path( ec ) /
+      boost::filesystem::unique_path( "Seg3D-undo-%%%%-%%%%-%%%%" );
+    if ( ec || !boost::filesystem::create_directories( scratch_directory, ec ) )
+    {
+      CORE_LOG_WARNING( "Could not create a scratch directory for the undo buffer" );
+      return false;
+    }
+    this->scratch_directory_ = scratch_directory;
+  }
+
+  directory = this->scratch_directory_;
+  return true;
+}
+
+void UndoBufferPrivate::remove_scratch_directory()
+{
+  if ( !this->scratch_directory_.empty() )
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all( this->scratch_directory_, ec );
+    this->scratch_directory_.clear();
+  }
+}
+
+void UndoBufferPrivate::CompressItems( std::vector< UndoBufferItemHandle > items )
+{
+  for ( size_t j = 0; j < items.size(); j++ )
+  {
+    items[ j ]->compress();
+  }
+}
 
 void UndoBufferPrivate::handle_enable( bool enable )
 {
@@ -105,6 +163,9 @@ UndoBuffer::UndoBuffer() :
 UndoBuffer::~UndoBuffer()
 {
   this->disconnect_all();
+  this->private_->undo_list_.clear();
+  this->private_->redo_list_.clear();
+  this->private_->remove_scratch_directory();
 }
 
 void UndoBuffer::insert_undo_item( Core::ActionContextHandle context, 
@@ -134,14 +195,36 @@ void UndoBuffer::insert_undo_item( Core::ActionContextHandle context,
 
   while ( it != it_end )
   {
+    // Account for the items that were compressed in the background since the last insert
+    (*it)->compute_size();
+
     size += (*it)->get_byte_size();
     max_num_undos++;
-    if ( size > max_size ) break;
+    if ( size > max_size )
+    {
+      // Move the item to disk rather than dropping it
+      boost::filesystem::path directory;
+      size -= (*it)->get_byte_size();
+      if ( this->private_->get_scratch_directory( directory ) ) (*it)->spill( directory );
+      size += (*it)->get_byte_size();
+      if ( size > max_size ) break;
+    }
     if ( max_num_undos >= 100 ) break;
     ++it;
   }
 
   this->private_->undo_list_.erase( it, it_end );
+
+  // Layers have moved on from the volumes stored in the older items. These are compressed in 
+  // the background, so the action does not need to wait for it.
+  if ( !this->private_->undo_list_.empty() )
+  {
+    std::vector< UndoBufferItemHandle > items( this->private_->undo_list_.begin(), 
+      this->private_->undo_list_.end() );
+    Core::ThreadPool::Instance()->start( boost::bind( &UndoBufferPrivate::CompressItems, 
+      items ) );
+  }
+
   this->private_->undo_list_.push_front( undo_item );
   
   this->update_undo_tag_signal_( undo_item->get_tag() );
@@ -173,6 +256,12 @@ bool UndoBuffer::undo( Core::ActionContextHandle context )
   // redo the action
   this->private_->redo_list_.push_front( undo_item );
 
+  // Start loading the next item from disk, if it was moved there
+  if ( !this->private_->undo_list_.empty() )
+  {
+    this->private_->undo_list_.front()->prefetch();
+  }
+
   // Update the entries in the menu
   this->update_undo_tag_signal_( this->get_undo_tag() );
   this->update_redo_tag_signal_( this->get_redo_tag() );
@@ -210,6 +299,7 @@ void UndoBuffer::reset_undo_buffer()
 {
   this->private_->redo_list_.clear();
   this->private_->undo_list_.clear();
+  this->private_->remove_scratch_directory();
 
   this->update_redo_tag_signal_( this->get_redo_tag() );
   this->update_undo_tag_signal_( this->get_undo_tag() );
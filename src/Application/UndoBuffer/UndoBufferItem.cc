@@ -87,4 +87,18 @@ std::string UndoBufferItem::get_tag() const
   return this->private_->tag_;
 }
 
+bool UndoBufferItem::compress()
+{
+  return false;
+}
+
+bool UndoBufferItem::spill( const boost::filesystem::path& )
+{
+  return false;
+}
+
+void UndoBufferItem::prefetch()
+{
+}
+
 } // end namespace Seg3D
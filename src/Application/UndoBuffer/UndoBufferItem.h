@@ -29,6 +29,9 @@
 #ifndef APPLICATION_UNDOBUFFER_UNDOBUFFERITEM_H
 #define APPLICATION_UNDOBUFFER_UNDOBUFFERITEM_H
 
+// Boost includes
+#include <boost/filesystem/path.hpp>
+
 // Core includes
 #include <Core/Action/Action.h>
 
@@ -78,6 +81,24 @@ public:
   /// Compute the size of the item
   virtual void compute_size() = 0;
 
+  // -- memory management --
+public:
+  /// COMPRESS:
+  /// Compress the data stored in the item that is no longer in use elsewhere. Returns true if 
+  /// the item holds compressed data.
+  /// NOTE: The undo buffer calls this from a service thread, the size of the item is updated
+  /// by the next call to compute_size.
+  virtual bool compress();
+
+  /// SPILL:
+  /// Move the data of the item to files in the given directory to free memory. Returns false
+  /// if not all of the data could be moved to disk.
+  virtual bool spill( const boost::filesystem::path& directory );
+
+  /// PREFETCH:
+  /// Start loading the data of the item back into memory in the background.
+  virtual void prefetch();
+
   /// GET_TAG:
   /// Tag that appears in the menu for this item
   std::string get_tag() const;
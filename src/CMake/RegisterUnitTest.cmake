@@ -33,6 +33,12 @@ macro(REGISTER_UNIT_TEST test)
   add_test(${test} ${SEG3D_BINARY_DIR}/${test})
 endmacro()
 
+# Benchmarks are built like unit tests, but are not run by ctest as they only report timings
+macro(REGISTER_BENCHMARK benchmark)
+  set(CMAKE_RUNTIME_OUTPUT_DIRECTORY ${SEG3D_BINARY_DIR})
+  add_executable(${benchmark} ${ARGN})
+endmacro()
+
 macro(ADD_TEST_DIR directory)
   if(BUILD_TESTING)
     add_subdirectory(${directory})
@@ -26,9 +26,15 @@
  DEALINGS IN THE SOFTWARE.
 */
 
+#include <algorithm>
+#include <cstring>
+
+#include <boost/bind.hpp>
+
 #include <Core/DataBlock/DataBlock.h>
 #include <Core/DataBlock/DataBlockManager.h>
 #include <Core/DataBlock/StdDataBlock.h>
+#include <Core/Utils/ThreadPool.h>
 
 namespace Core
 {
@@ -262,15 +268,20 @@ void DataBlock::set_generation( generation_type generation )
   this->generation_ = generation;
 }
 
-void DataBlock::increase_generation()
+DataBlock::generation_type DataBlock::increase_generation()
 {
   this->generation_ = DataBlockManager::Instance()->increase_generation( this->generation_ );
+  return this->generation_;
 }
 
 bool DataBlock::update_histogram()
 {
   lock_type lock( this->get_mutex() );
+  return this->compute_histogram();
+}
 
+bool DataBlock::compute_histogram()
+{
   switch( this->data_type_ )
   {
     case DataType::CHAR_E:
@@ -298,6 +309,61 @@ bool DataBlock::update_histogram()
   return false;
 }
 
+bool DataBlock::update_histogram( const void* old_data, const void* new_data, size_t size )
+{
+  bool updated = false;
+  switch( this->data_type_ )
+  {
+    case DataType::CHAR_E:
+      updated = this->histogram_.update( reinterpret_cast<const signed char*>( old_data ),
+        reinterpret_cast<const signed char*>( new_data ), size );
+      break;
+    case DataType::UCHAR_E:
+      updated = this->histogram_.update( reinterpret_cast<const unsigned char*>( old_data ),
+        reinterpret_cast<const unsigned char*>( new_data ), size );
+      break;
+    case DataType::SHORT_E:
+      updated = this->histogram_.update( reinterpret_cast<const short*>( old_data ),
+        reinterpret_cast<const short*>( new_data ), size );
+      break;
+    case DataType::USHORT_E:
+      updated = this->histogram_.update( reinterpret_cast<const unsigned short*>( old_data ),
+        reinterpret_cast<const unsigned short*>( new_data ), size );
+      break;
+    case DataType::INT_E:
+      updated = this->histogram_.update( reinterpret_cast<const int*>( old_data ),
+        reinterpret_cast<const int*>( new_data ), size );
+      break;
+    case DataType::UINT_E:
+      updated = this->histogram_.update( reinterpret_cast<const unsigned int*>( old_data ),
+        reinterpret_cast<const unsigned int*>( new_data ), size );
+      break;
+    case DataType::LONGLONG_E:
+      updated = this->histogram_.update( reinterpret_cast<const long long*>( old_data ),
+        reinterpret_cast<const long long*>( new_data ), size );
+      break;
+    case DataType::ULONGLONG_E:
+      updated = this->histogram_.update( 
+        reinterpret_cast<const unsigned long long*>( old_data ),
+        reinterpret_cast<const unsigned long long*>( new_data ), size );
+      break;
+    case DataType::FLOAT_E:
+      updated = this->histogram_.update( reinterpret_cast<const float*>( old_data ),
+        reinterpret_cast<const float*>( new_data ), size );
+      break;
+    case DataType::DOUBLE_E:
+      updated = this->histogram_.update( reinterpret_cast<const double*>( old_data ),
+        reinterpret_cast<const double*>( new_data ), size );
+      break;
+    default:
+      return false;
+  }
+
+  // The range of the data changed, hence the bins need to be laid out again
+  if ( !updated ) return this->compute_histogram();
+  return true;
+}
+
 // same as set_type()
 void DataBlock::update_data_type( DataType type )
 {
@@ -477,131 +543,78 @@ void SwapEndian( void* data, size_t size, size_t elem_size )
   }
 }
 
+// Minimum number of elements that a task of the operations on whole data blocks processes
+const size_t ELEMENT_GRAIN_C = 1 << 16;
+
+// Minimum number of bytes that a task copies when duplicating a data block
+const size_t BYTE_GRAIN_C = 1 << 20;
+
+// Edge length of the tiles in which PermuteData copies the data
+const DataBlock::index_type TILE_SIZE_C = 16;
+
+// SWAPENDIANRANGE:
+// Swap the bytes of the elements begin up to end - 1.
+static void SwapEndianRange( unsigned char* data, size_t elem_size, size_t begin, size_t end )
+{
+  SwapEndian( data + begin * elem_size, end - begin, elem_size );
+}
+
 void DataBlock::swap_endian()
 {
   lock_type lock( this->get_mutex() );
 
-  switch( this->data_type_ )
+  size_t elem_size = this->get_elem_size();
+  if ( elem_size < 2 ) return;
+
+  parallel_for( 0, this->get_size(), ELEMENT_GRAIN_C, boost::bind( &SwapEndianRange, 
+    reinterpret_cast<unsigned char*>( this->get_data() ), elem_size, _1, _2 ) );
+}
+
+// CONVERTRANGE:
+// Convert the elements begin up to end - 1 of src into the type of dst.
+template<class SRC, class DST>
+static void ConvertRange( const SRC* src, DST* dst, size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
   {
-    case DataType::CHAR_E:
-    case DataType::UCHAR_E:
-      break;
-    case DataType::SHORT_E:
-    case DataType::USHORT_E:
-      SwapEndian( get_data(), get_size(), 2 );
-      break;
-    case DataType::INT_E:
-    case DataType::UINT_E:
-    case DataType::FLOAT_E:
-      SwapEndian( get_data(), get_size(), 4 );
-      break;
-    case DataType::LONGLONG_E:
-    case DataType::ULONGLONG_E:
-    case DataType::DOUBLE_E:
-      SwapEndian( get_data(), get_size(), 8 );
-      break;
+    dst[ j ] = static_cast<DST>( src[ j ] );
   }
 }
 
+template<class SRC, class DST>
+static bool ConvertDataTypeTyped( const SRC* src, const DataBlockHandle& dst_data_block )
+{
+  parallel_for( 0, dst_data_block->get_size(), ELEMENT_GRAIN_C, boost::bind( 
+    &ConvertRange<SRC, DST>, src, reinterpret_cast<DST*>( dst_data_block->get_data() ), 
+    _1, _2 ) );
+  return true;
+}
 
 template<class DATA>
 static bool ConvertDataTypeInternal( DATA* src, DataBlockHandle& dst_data_block )
 {
-  size_t size = dst_data_block->get_size();
   switch ( dst_data_block->get_data_type() )
   {
     case DataType::CHAR_E:
-    {
-      signed char* dst = reinterpret_cast<signed char*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<signed char>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, signed char>( src, dst_data_block );
     case DataType::UCHAR_E:
-    {
-      unsigned char* dst = reinterpret_cast<unsigned char*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<unsigned char>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, unsigned char>( src, dst_data_block );
     case DataType::SHORT_E:
-    {
-      short* dst = reinterpret_cast<short*>( dst_data_block->get_data() );
-      size_t size8 = size & ~(0x7);
-      size_t j = 0;
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<short>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, short>( src, dst_data_block );
     case DataType::USHORT_E:
-    {
-      unsigned short* dst = reinterpret_cast<unsigned short*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<unsigned short>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, unsigned short>( src, dst_data_block );
     case DataType::INT_E:
-    {
-      int* dst = reinterpret_cast<int*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<int>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, int>( src, dst_data_block );
     case DataType::UINT_E:
-    {
-      unsigned int* dst = reinterpret_cast<unsigned int*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<unsigned int>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, unsigned int>( src, dst_data_block );
     case DataType::LONGLONG_E:
-    {
-      long long* dst = reinterpret_cast<long long*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<long long>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, long long>( src, dst_data_block );
     case DataType::ULONGLONG_E:
-    {
-      unsigned long long* dst = reinterpret_cast<unsigned long long*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<unsigned long long>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, unsigned long long>( src, dst_data_block );
     case DataType::FLOAT_E:
-    {
-      float* dst = reinterpret_cast<float*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<float>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, float>( src, dst_data_block );
     case DataType::DOUBLE_E:
-    {
-      double* dst = reinterpret_cast<double*>( dst_data_block->get_data() );
-      for ( size_t j = 0; j < size; j++ )
-      {
-        dst[ j ] = static_cast<double>( src[ j ] );
-      }
-      return true;
-    }
+      return ConvertDataTypeTyped<DATA, double>( src, dst_data_block );
     default:
     {
       dst_data_block.reset();
@@ -665,6 +678,75 @@ bool DataBlock::ConvertDataType( const DataBlockHandle& src_data_block,
   }
 }
 
+// CLASS PERMUTESLABS:
+// Copies slabs of TILE_SIZE_C slices of the destination of PermuteData. A slab is copied in tiles,
+// so the source data that a tile reads stays in the cache, whichever axis of the source becomes
+// the x-axis of the destination.
+template<class DATA>
+class PermuteSlabs
+{
+public:
+  typedef DataBlock::index_type index_type;
+
+  PermuteSlabs( const DATA* src, DATA* dst, const index_type* start, const index_type* stride,
+    index_type dnx, index_type dny, index_type dnz ) :
+    src_( src ),
+    dst_( dst ),
+    dnx_( dnx ),
+    dny_( dny ),
+    dnz_( dnz )
+  {
+    std::copy( start, start + 3, this->start_ );
+    std::copy( stride, stride + 3, this->stride_ );
+  }
+
+  void operator()( size_t begin, size_t end ) const
+  {
+    const index_type dnxy = this->dnx_ * this->dny_;
+    const index_type sx_stride = this->stride_[ 0 ];
+
+    // Rows of the source are read in order and do not need to be split into tiles
+    const index_type tile_x = ( sx_stride == 1 || sx_stride == -1 ) ? this->dnx_ : TILE_SIZE_C;
+
+    for ( size_t slab = begin; slab < end; slab++ )
+    {
+      const index_type z0 = static_cast<index_type>( slab ) * TILE_SIZE_C;
+      const index_type z1 = Min( z0 + TILE_SIZE_C, this->dnz_ );
+      for ( index_type y0 = 0; y0 < this->dny_; y0 += TILE_SIZE_C )
+      {
+        const index_type y1 = Min( y0 + TILE_SIZE_C, this->dny_ );
+        for ( index_type x0 = 0; x0 < this->dnx_; x0 += tile_x )
+        {
+          const index_type x1 = Min( x0 + tile_x, this->dnx_ );
+          for ( index_type dz = z0; dz < z1; dz++ )
+          {
+            for ( index_type dy = y0; dy < y1; dy++ )
+            {
+              const DATA* src_row = this->src_ + this->start_[ 0 ] + 
+                this->start_[ 1 ] + dy * this->stride_[ 1 ] + 
+                this->start_[ 2 ] + dz * this->stride_[ 2 ];
+              DATA* dst_row = this->dst_ + dz * dnxy + dy * this->dnx_;
+              for ( index_type dx = x0; dx < x1; dx++ )
+              {
+                dst_row[ dx ] = src_row[ dx * sx_stride ];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+private:
+  const DATA* src_;
+  DATA* dst_;
+  index_type start_[ 3 ];
+  index_type stride_[ 3 ];
+  index_type dnx_;
+  index_type dny_;
+  index_type dnz_;
+};
+
 template<class DATA>
 static bool PermuteDataInternal( const DataBlockHandle& src_data_block,
   DataBlockHandle& dst_data_block, std::vector<int>& permutation )
@@ -674,8 +756,8 @@ static bool PermuteDataInternal( const DataBlockHandle& src_data_block,
 
   typedef DataBlock::index_type index_type;
 
-  std::vector<index_type> start(3);
-  std::vector<index_type> stride(3);
+  index_type start[ 3 ] = { 0, 0, 0 };
+  index_type stride[ 3 ] = { 0, 0, 0 };
 
   index_type nx = static_cast<index_type>( src_data_block->get_nx() );
   index_type ny = static_cast<index_type>( src_data_block->get_ny() );
@@ -720,27 +802,10 @@ static bool PermuteDataInternal( const DataBlockHandle& src_data_block,
   index_type dnx = static_cast<index_type>( dst_data_block->get_nx() );
   index_type dny = static_cast<index_type>( dst_data_block->get_ny() );
   index_type dnz = static_cast<index_type>( dst_data_block->get_nz() );
-  index_type dnxy = dnx * dny;
-  index_type dnxyz = dnx * dny * dnz;
-  index_type sz = start[ 2 ];
-  index_type sz_stride = stride[ 2 ];
-  for ( index_type dz = 0; dz < dnxyz; dz += dnxy )
-  {
-    index_type sy = start[ 1 ];
-    index_type sy_stride = stride[ 1 ];
-    for ( index_type dy = 0; dy < dnxy; dy += dnx )
-    {
-      index_type sx = start[ 0 ];
-      index_type sx_stride = stride[ 0 ];
-      for ( index_type dx = 0; dx < dnx; dx++ )
-      {
-        dst[ dx + dy + dz ] = src[ sx + sy + sz ];
-        sx += sx_stride;
-      }
-      sy += sy_stride;
-    }
-    sz += sz_stride;
-  }
+  size_t num_slabs = static_cast<size_t>( ( dnz + TILE_SIZE_C - 1 ) / TILE_SIZE_C );
+
+  parallel_for( 0, num_slabs, 1, PermuteSlabs<DATA>( src, dst, start, stride, 
+    dnx, dny, dnz ) );
 
   return true;
 }
@@ -814,141 +879,101 @@ bool DataBlock::PermuteData( const DataBlockHandle& src_data_block,
 }
 
 
+// QUANTIZERANGE:
+// Map the elements begin up to end - 1 of src linearly onto the range of the type of dst, the
+// arithmetic is done in type CALC.
+template<class SRC, class DST, class CALC>
+static void QuantizeRange( const SRC* src, DST* dst, CALC multiplier, CALC min, CALC offset,
+  size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    dst[ j ] = static_cast<DST>( multiplier * ( static_cast<CALC>( src[ j ] ) - min ) + offset );
+  }
+}
+
+template<class SRC, class DST, class CALC>
+static bool QuantizeDataTyped( const SRC* src, const DataBlockHandle& dst_data_block, 
+  CALC multiplier, CALC min, CALC offset )
+{
+  parallel_for( 0, dst_data_block->get_size(), ELEMENT_GRAIN_C, boost::bind( 
+    &QuantizeRange<SRC, DST, CALC>, src, reinterpret_cast<DST*>( dst_data_block->get_data() ),
+    multiplier, min, offset, _1, _2 ) );
+  return true;
+}
+
 template<class DATA>
 static bool QuantizeDataInternal( double min, double max, DATA* src, DataBlockHandle& dst_data_block )
 {
   float fmin = static_cast<float>( min );
   float fmax = static_cast<float>( max );
 
-  size_t size = dst_data_block->get_size();
   switch ( dst_data_block->get_data_type() )
   {
     case DataType::CHAR_E:
     {
-      signed char* dst = reinterpret_cast<signed char*>( dst_data_block->get_data() );
-
       float offset = 0.5f - static_cast<float>( 0x80 );
       float multiplier = 0.0f;
       if ( fmax > fmin ) multiplier = static_cast<float>( 0x100 ) / (fmax - fmin);
-
-      for ( size_t j = 0 ; j < size; j++ )
-      {
-        dst[ j ] = static_cast<signed char>( multiplier *
-          (static_cast<float>( src[ j ] ) - fmin)  + offset );
-      }
-
-      return true;
+      return QuantizeDataTyped<DATA, signed char, float>( src, dst_data_block, 
+        multiplier, fmin, offset );
     }
     case DataType::UCHAR_E:
     {
-      unsigned char* dst = reinterpret_cast<unsigned char*>( dst_data_block->get_data() );
-
       float offset = 0.5f;
       float multiplier = 0.0f;
       if ( fmax > fmin ) multiplier = static_cast<float>( 0x100 ) / (fmax - fmin);
-
-      for ( size_t j = 0 ; j < size; j++ )
-      {
-        dst[ j ] = static_cast<unsigned char>( multiplier *
-          (static_cast<float>( src[ j ] ) - fmin)  + offset );
-      }
-      return true;
+      return QuantizeDataTyped<DATA, unsigned char, float>( src, dst_data_block, 
+        multiplier, fmin, offset );
     }
     case DataType::SHORT_E:
     {
-      short* dst = reinterpret_cast<short*>( dst_data_block->get_data() );
-
       float offset = 0.5f - static_cast<float>( 0x8000 );
       float multiplier = 0.0f;
       if ( fmax > fmin ) multiplier = static_cast<float>( 0x10000 ) / (fmax - fmin);
-
-      for ( size_t j = 0 ; j < size; j++ )
-      {
-        dst[ j ] = static_cast<short>( multiplier *
-          (static_cast<float>( src[ j ] ) - fmin)  + offset );
-      }
-
-      return true;
+      return QuantizeDataTyped<DATA, short, float>( src, dst_data_block, 
+        multiplier, fmin, offset );
     }
     case DataType::USHORT_E:
     {
-      unsigned short* dst = reinterpret_cast<unsigned short*>( dst_data_block->get_data() );
-
       float offset = 0.5f;
       float multiplier = 0.0f;
       if ( fmax > fmin ) multiplier = static_cast<float>( 0x10000 ) / (fmax - fmin);
-
-      for ( size_t j = 0 ; j < size; j++ )
-      {
-        dst[ j ] = static_cast<unsigned short>( multiplier *
-          (static_cast<float>( src[ j ] ) - fmin)  + offset);
-      }
-
-      return true;
+      return QuantizeDataTyped<DATA, unsigned short, float>( src, dst_data_block, 
+        multiplier, fmin, offset );
     }
     case DataType::INT_E:
     {
-      int* dst = reinterpret_cast<int*>( dst_data_block->get_data() );
-
       double offset = 0.5 -  static_cast<double>( 0x80000000 );
       double multiplier = 0.0;
       if ( max > min ) multiplier = static_cast<double>( 0x100000000ull ) / (max - min);
-
-      for ( size_t j = 0 ; j < size; j++ )
-      {
-        dst[ j ] = static_cast<int>( multiplier *
-          (static_cast<double>( src[ j ] ) - min)  + offset);
-      }
-
-      return true;
+      return QuantizeDataTyped<DATA, int, double>( src, dst_data_block, 
+        multiplier, min, offset );
     }
     case DataType::UINT_E:
     {
-      unsigned int* dst = reinterpret_cast<unsigned int*>( dst_data_block->get_data() );
-
       double offset = 0.5;
       double multiplier = 0.0;
       if ( max > min ) multiplier = static_cast<double>( 0x100000000ull ) / (max - min);
-
-      for ( size_t j = 0 ; j < size; j++ )
-      {
-        dst[ j ] = static_cast<unsigned int>( multiplier *
-          (static_cast<double>( src[ j ] ) - min)  + offset);
-      }
-
-      return true;
+      return QuantizeDataTyped<DATA, unsigned int, double>( src, dst_data_block, 
+        multiplier, min, offset );
     }
+    // NOTE: The 64 bit types subtract the minimum rounded to float
     case DataType::LONGLONG_E:
     {
-      long long* dst = reinterpret_cast<long long*>( dst_data_block->get_data() );
-
-      const static double offset = 0.5 -  static_cast<double>( 0x80000000 ) * static_cast<double>( 0x100000000ull );
+      double offset = 0.5 -  static_cast<double>( 0x80000000 ) * static_cast<double>( 0x100000000ull );
       double multiplier = 0.0;
       if ( max > min ) multiplier = static_cast<double>( 0x100000000ull ) * static_cast<double>( 0x100000000ull ) / (max - min);
-
-      for ( size_t j = 0 ; j < size; j++ )
-      {
-        dst[ j ] = static_cast<long long>( multiplier *
-          (static_cast<double>( src[ j ] ) - fmin)  + offset );
-      }
-
-      return true;
+      return QuantizeDataTyped<DATA, long long, double>( src, dst_data_block, 
+        multiplier, static_cast<double>( fmin ), offset );
     }
     case DataType::ULONGLONG_E:
     {
-      unsigned long long* dst = reinterpret_cast<unsigned long long*>( dst_data_block->get_data() );
-
-      const static double offset = 0.5;
+      double offset = 0.5;
       double multiplier = 0.0;
       if ( max > min ) multiplier = static_cast<double>( 0x100000000ull ) * static_cast<double>( 0x100000000ull ) / (max - min);
-
-      for ( size_t j = 0 ; j < size; j++ )
-      {
-        dst[ j ] = static_cast<unsigned long long>( multiplier *
-          (static_cast<double>( src[ j ] ) - fmin)  + offset);
-      }
-
-      return true;
+      return QuantizeDataTyped<DATA, unsigned long long, double>( src, dst_data_block, 
+        multiplier, static_cast<double>( fmin ), offset );
     }
     default:
     {
@@ -1022,6 +1047,13 @@ bool DataBlock::QuantizeData( const DataBlockHandle& src_data_block,
   }
 }
 
+// COPYRANGE:
+// Copy the bytes begin up to end - 1 of src into dst.
+static void CopyRange( const unsigned char* src, unsigned char* dst, size_t begin, size_t end )
+{
+  std::memcpy( dst + begin, src + begin, end - begin );
+}
+
 bool DataBlock::Duplicate( const DataBlockHandle& src_data_block,
     DataBlockHandle& dst_data_block )
 {
@@ -1037,43 +1069,13 @@ bool DataBlock::Duplicate( const DataBlockHandle& src_data_block,
     src_data_block->get_ny(), src_data_block->get_nz(), src_data_block->get_data_type() );
 
   // Step (4): Copy the data
-  size_t mem_size = src_data_block->get_size();
-  switch( src_data_block->get_data_type() )
-  {
-    case DataType::CHAR_E:
-      mem_size *= sizeof( signed char );
-      break;
-    case DataType::UCHAR_E:
-      mem_size *= sizeof( unsigned char );
-      break;
-    case DataType::SHORT_E:
-      mem_size *= sizeof( short );
-      break;
-    case DataType::USHORT_E:
-      mem_size *= sizeof( unsigned short );
-      break;
-    case DataType::INT_E:
-      mem_size *= sizeof( int );
-      break;
-    case DataType::UINT_E:
-      mem_size *= sizeof( unsigned int );
-      break;
-    case DataType::LONGLONG_E:
-      mem_size *= sizeof( long long );
-      break;
-    case DataType::ULONGLONG_E:
-      mem_size *= sizeof( unsigned long long );
-      break;
-    case DataType::FLOAT_E:
-      mem_size *= sizeof( float );
-      break;
-    case DataType::DOUBLE_E:
-      mem_size *= sizeof( double );
-      break;
-    default:
-      return false;
-  }
-  std::memcpy( dst_data_block->get_data(), src_data_block->get_data(), mem_size );
+  size_t elem_size = src_data_block->get_elem_size();
+  if ( elem_size == 0 ) return false;
+  size_t mem_size = src_data_block->get_size() * elem_size;
+
+  parallel_for( 0, mem_size, BYTE_GRAIN_C, boost::bind( &CopyRange, 
+    reinterpret_cast<const unsigned char*>( src_data_block->get_data() ),
+    reinterpret_cast<unsigned char*>( dst_data_block->get_data() ), _1, _2 ) );
 
   // Step (5) : Copy the histogram
   dst_data_block->set_histogram( src_data_block->get_histogram() );
@@ -1255,6 +1257,53 @@ bool DataBlock::extract_slice( SliceType type, index_type index, DataSliceHandle
 }
 
 
+template<class T>
+bool GetSliceValues( DataBlock* volume_data_block, SliceType type, DataBlock::index_type index,
+  std::vector<T>& values )
+{
+  size_t nx = volume_data_block->get_nx();
+  size_t ny = volume_data_block->get_ny();
+  size_t nz = volume_data_block->get_nz();
+  size_t nxy = nx * ny;
+  const T* volume_ptr = reinterpret_cast<const T*>( volume_data_block->get_data() );
+
+  switch( type )
+  {
+    case SliceType::SAGITTAL_E:
+    {
+      if ( index < 0 || index >= static_cast<DataBlock::index_type>( nx ) ) return false;
+      values.resize( ny * nz );
+      for ( size_t z = 0; z < nz; z++ )
+      {
+        for ( size_t y = 0; y < ny; y++ )
+        {
+          values[ y + z * ny ] = volume_ptr[ index + y * nx + z * nxy ];
+        }
+      }
+      return true;
+    }
+    case SliceType::CORONAL_E:
+    {
+      if ( index < 0 || index >= static_cast<DataBlock::index_type>( ny ) ) return false;
+      values.resize( nx * nz );
+      for ( size_t z = 0; z < nz; z++ )
+      {
+        std::memcpy( &values[ z * nx ], volume_ptr + index * nx + z * nxy, nx * sizeof( T ) );
+      }
+      return true;
+    }
+    case SliceType::AXIAL_E:
+    {
+      if ( index < 0 || index >= static_cast<DataBlock::index_type>( nz ) ) return false;
+      values.resize( nxy );
+      std::memcpy( &values[ 0 ], volume_ptr + index * nxy, nxy * sizeof( T ) );
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
 template<class T>
 bool InsertSliceInternal( DataBlock* volume_data_block, const DataSliceHandle& slice )
 {
@@ -1273,6 +1322,14 @@ bool InsertSliceInternal( DataBlock* volume_data_block, const DataSliceHandle& s
   DataBlock::shared_lock_type slock( slice_data_block->get_mutex() );
 
   DataBlock::index_type index = slice->get_index();
+
+  // Keep the values that are about to be overwritten, so that the histogram can be updated by
+  // binning only the values of this slice
+  std::vector<T> old_values;
+  bool update_histogram = volume_data_block->get_histogram().is_valid() &&
+    GetSliceValues( volume_data_block, slice->get_slice_type(), index, old_values ) &&
+    old_values.size() == slice_data_block->get_size();
+
   // For each axis there is an optimized algorithm
   switch( slice->get_slice_type() )
   {
@@ -1315,6 +1372,10 @@ bool InsertSliceInternal( DataBlock* volume_data_block, const DataSliceHandle& s
         }
       }
 
+      if ( update_histogram )
+      {
+        volume_data_block->update_histogram( &old_values[ 0 ], slice_ptr, old_values.size() );
+      }
       volume_data_block->increase_generation();
 
       return true;
@@ -1357,6 +1418,10 @@ bool InsertSliceInternal( DataBlock* volume_data_block, const DataSliceHandle& s
         }
       }
 
+      if ( update_histogram )
+      {
+        volume_data_block->update_histogram( &old_values[ 0 ], slice_ptr, old_values.size() );
+      }
       volume_data_block->increase_generation();
 
       return true;
@@ -1373,6 +1438,10 @@ bool InsertSliceInternal( DataBlock* volume_data_block, const DataSliceHandle& s
       // Copy data as one memory block back
       std::memcpy( volume_ptr + index * ( nx * ny ), slice_ptr, nx * ny * sizeof( T ) );
 
+      if ( update_histogram )
+      {
+        volume_data_block->update_histogram( &old_values[ 0 ], slice_ptr, old_values.size() );
+      }
       volume_data_block->increase_generation();
 
       return true;
@@ -1432,65 +1501,82 @@ bool DataBlock::IsLittleEndian()
   if ( test_ptr[ 0 ] ) return true; else return false;
 }
 
+// CLASS PADSLICES:
+// Fills the slices begin up to end - 1 of the destination of Pad. Voxel ( x, y, z ) of the 
+// destination receives voxel ( x - pad, y - pad, z - pad ) of the source, or the pad value if
+// that is outside of the source.
 template<class T>
-bool PadInternal( DataBlockHandle src, DataBlockHandle dst, int pad, double val)
+class PadSlices
 {
-    T* src_data = reinterpret_cast<T*>(src->get_data());
-    T* dst_data = reinterpret_cast<T*>(dst->get_data());
-    T typed_val = static_cast<T>(val);
+public:
+  typedef DataBlock::index_type index_type;
 
-    DataBlock::index_type nx = src->get_nx();
-    DataBlock::index_type ny = src->get_ny();
-    DataBlock::index_type nz = src->get_nz();
-    DataBlock::index_type pnx = dst->get_nx();
-    DataBlock::index_type pny = dst->get_ny();
-    DataBlock::index_type pnz = dst->get_nz();
+  PadSlices( const DataBlockHandle& src, const DataBlockHandle& dst, index_type pad, T value ) :
+    src_( reinterpret_cast<const T*>( src->get_data() ) ),
+    dst_( reinterpret_cast<T*>( dst->get_data() ) ),
+    nx_( src->get_nx() ),
+    ny_( src->get_ny() ),
+    nz_( src->get_nz() ),
+    pnx_( dst->get_nx() ),
+    pny_( dst->get_ny() ),
+    pad_( pad ),
+    value_( value )
+  {
+  }
 
-    DataBlock::index_type p = static_cast<DataBlock::index_type>(pad);
+  void operator()( size_t begin, size_t end ) const
+  {
+    const index_type p = this->pad_;
+    const index_type x_begin = Max( index_type( 0 ), p );
+    const index_type x_end = Min( this->pnx_, this->nx_ + p );
 
-    if (p > 0)
+    for ( index_type dz = static_cast<index_type>( begin ); 
+      dz < static_cast<index_type>( end ); dz++ )
     {
-        size_t size = dst->get_size();
-        for(size_t j = 0; j< size; j++)
-        {
-            dst_data[j] = typed_val;
-        }
-    }
+      T* dst_slice = this->dst_ + dz * this->pnx_ * this->pny_;
+      const index_type sz = dz - p;
+      if ( sz < 0 || sz >= this->nz_ )
+      {
+        std::fill( dst_slice, dst_slice + this->pnx_ * this->pny_, this->value_ );
+        continue;
+      }
 
-    if (p >= 0)
-    {
-        DataBlock::index_type k = 0;
-        DataBlock::index_type m = p + p * pnx + p * pnx * pny;
-        for(DataBlock::index_type z = 0; z < nz ; z++, m += 2*p*pnx )
+      for ( index_type dy = 0; dy < this->pny_; dy++ )
+      {
+        T* dst_row = dst_slice + dy * this->pnx_;
+        const index_type sy = dy - p;
+        if ( sy < 0 || sy >= this->ny_ || x_begin >= x_end )
         {
-            for(DataBlock::index_type y = 0; y < ny; y++, m += 2*p )
-            {
-                for(DataBlock::index_type x = 0; x < nx; x++, k++, m++ )
-                {
-                    dst_data[m] = src_data[k];
-                }
-            }
+          std::fill( dst_row, dst_row + this->pnx_, this->value_ );
+          continue;
         }
-    }
-    else
-    {
-        p = -p;
-        DataBlock::index_type k = p + p * nx + p * nx * ny;
-        DataBlock::index_type m = 0;
 
-        for(DataBlock::index_type z = 0; z < pnz ; z++, k += 2*p*nx )
-        {
-            for(DataBlock::index_type y =0; y < pny; y++, k += 2*p )
-            {
-                for(DataBlock::index_type x = 0; x < pnx; x++, k++, m++ )
-                {
-                    dst_data[m] = src_data[k];
-                }
-            }
-        }
+        const T* src_row = this->src_ + ( sz * this->ny_ + sy ) * this->nx_ - p;
+        std::fill( dst_row, dst_row + x_begin, this->value_ );
+        std::copy( src_row + x_begin, src_row + x_end, dst_row + x_begin );
+        std::fill( dst_row + x_end, dst_row + this->pnx_, this->value_ );
+      }
     }
+  }
 
-    return true;
+private:
+  const T* src_;
+  T* dst_;
+  index_type nx_;
+  index_type ny_;
+  index_type nz_;
+  index_type pnx_;
+  index_type pny_;
+  index_type pad_;
+  T value_;
+};
+
+template<class T>
+bool PadInternal( DataBlockHandle src, DataBlockHandle dst, int pad, double val)
+{
+  parallel_for( 0, dst->get_nz(), 1, PadSlices<T>( src, dst, 
+    static_cast<DataBlock::index_type>( pad ), static_cast<T>( val ) ) );
+  return true;
 }
 
 bool DataBlock::Pad( DataBlockHandle src_data_block,
@@ -1541,59 +1627,71 @@ bool DataBlock::Pad( DataBlockHandle src_data_block,
 
 
 
+// CLASS CLIPSLICES:
+// Fills the slices begin up to end - 1 of the destination of Clip. Voxel ( x, y, z ) of the 
+// destination receives the same voxel of the source, or the fill value if that is outside of 
+// the source.
 template<class T>
-bool ClipInternal( DataBlockHandle src, DataBlockHandle dst, double val)
+class ClipSlices
 {
-    T* sdata = reinterpret_cast<T*>(src->get_data());
-    T* ddata = reinterpret_cast<T*>(dst->get_data());
-    T typed_val = static_cast<T>(val);
-
-    DataBlock::index_type snx = src->get_nx();
-    DataBlock::index_type sny = src->get_ny();
-    DataBlock::index_type snz = src->get_nz();
-    DataBlock::index_type dnx = dst->get_nx();
-    DataBlock::index_type dny = dst->get_ny();
-    DataBlock::index_type dnz = dst->get_nz();
-
-  DataBlock::index_type mnx = Min( snx, dnx );
-  DataBlock::index_type mny = Min( sny, dny );
-  DataBlock::index_type mnz = Min( snz, dnz );
-
-  DataBlock::index_type sk = 0;
-  DataBlock::index_type dk = 0;
-
-    DataBlock::index_type sx_offset = Max( DataBlock::index_type( 0 ) , snx - dnx );
-    DataBlock::index_type dx_offset = Max( DataBlock::index_type( 0 ), dnx - snx );
-
-    DataBlock::index_type sy_offset = Max( DataBlock::index_type( 0 ) , sny - dny ) * snx;
-    DataBlock::index_type dy_offset = Max( DataBlock::index_type( 0 ), dny - sny ) * dny;
+public:
+  typedef DataBlock::index_type index_type;
 
-  DataBlock::index_type dz_offset = Max( DataBlock::index_type( 0 ),  dnz - snz ) * dny * dnx;
+  ClipSlices( const DataBlockHandle& src, const DataBlockHandle& dst, T value ) :
+    src_( reinterpret_cast<const T*>( src->get_data() ) ),
+    dst_( reinterpret_cast<T*>( dst->get_data() ) ),
+    snx_( src->get_nx() ),
+    sny_( src->get_ny() ),
+    snz_( src->get_nz() ),
+    dnx_( dst->get_nx() ),
+    dny_( dst->get_ny() ),
+    value_( value )
+  {
+  }
 
-  for ( DataBlock::index_type z = 0; z < mnz; z++,  sk += sy_offset)
+  void operator()( size_t begin, size_t end ) const
   {
-    for ( DataBlock::index_type y = 0; y < mny; y++, sk += sx_offset )
+    const index_type mnx = Min( this->snx_, this->dnx_ );
+    const index_type mny = Min( this->sny_, this->dny_ );
+
+    for ( index_type z = static_cast<index_type>( begin ); 
+      z < static_cast<index_type>( end ); z++ )
     {
-      for ( DataBlock::index_type x = 0; x < mnx; x++, sk++, dk++ )
+      T* dst_slice = this->dst_ + z * this->dnx_ * this->dny_;
+      if ( z >= this->snz_ )
       {
-        ddata[dk] = sdata[sk];
+        std::fill( dst_slice, dst_slice + this->dnx_ * this->dny_, this->value_ );
+        continue;
       }
-      for ( DataBlock::index_type x = 0; x < dx_offset; x++, dk++ )
+
+      for ( index_type y = 0; y < mny; y++ )
       {
-        ddata[dk] = typed_val;
+        const T* src_row = this->src_ + ( z * this->sny_ + y ) * this->snx_;
+        T* dst_row = dst_slice + y * this->dnx_;
+        std::copy( src_row, src_row + mnx, dst_row );
+        std::fill( dst_row + mnx, dst_row + this->dnx_, this->value_ );
       }
+      std::fill( dst_slice + mny * this->dnx_, dst_slice + this->dny_ * this->dnx_, 
+        this->value_ );
     }
-    for ( DataBlock::index_type m = 0; m < dy_offset; m++, dk++ )
-    {
-      ddata[dk] = typed_val;
-    }
-  }
-  for ( DataBlock::index_type m = 0; m < dz_offset; m++, dk++ )
-  {
-    ddata[dk] = typed_val;
   }
 
-    return true;
+private:
+  const T* src_;
+  T* dst_;
+  index_type snx_;
+  index_type sny_;
+  index_type snz_;
+  index_type dnx_;
+  index_type dny_;
+  T value_;
+};
+
+template<class T>
+bool ClipInternal( DataBlockHandle src, DataBlockHandle dst, double val)
+{
+  parallel_for( 0, dst->get_nz(), 1, ClipSlices<T>( src, dst, static_cast<T>( val ) ) );
+  return true;
 }
 
 bool DataBlock::Clip( DataBlockHandle src_data_block,
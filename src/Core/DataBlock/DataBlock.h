@@ -200,6 +200,15 @@ public:
   // UPDATE_HISTOGRAM:
   /// Recompute the histogram. This needs to be triggered each time the data is updated
   bool update_histogram();
+
+  // UPDATE_HISTOGRAM:
+  /// Update the histogram after the values in old_data have been overwritten by the values in
+  /// new_data. Both arrays contain size values of the data type of this data block. Only the
+  /// changed values are binned, unless the range of the data changed, in which case the whole
+  /// histogram is recomputed.
+  /// NOTE: This one does not lock the mutex, the caller should hold the lock while altering
+  /// the data.
+  bool update_histogram( const void* old_data, const void* new_data, size_t size );
   
   // UPDATE_DATA_TYPE:
   /// Reset the data type
@@ -214,7 +223,8 @@ public:
   /// Increase the generation number to a new unique number.
   /// NOTE: THis one does not lock the mutex as the mutex should
   /// protect both the data change and the update of the generation atomically.
-  void increase_generation();
+  /// Returns the new generation number.
+  generation_type increase_generation();
 
   // SET_HISTOGRAM:
   /// Set the histogram of the dataset
@@ -227,6 +237,10 @@ public:
 private:
   friend class DataBlockManager;
   void set_generation( generation_type generation );
+
+  // COMPUTE_HISTOGRAM:
+  /// Recompute the histogram from all the data without locking the mutex
+  bool compute_histogram();
   
 protected:
 
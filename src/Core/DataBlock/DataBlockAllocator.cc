@@ -0,0 +1,326 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+#include <list>
+#include <new>
+#include <vector>
+
+// Boost includes
+#include <boost/bind.hpp>
+
+#if defined( _WIN32 )
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+
+#if defined( __linux__ )
+#include <sys/mman.h>
+#endif
+
+// Core includes
+#include <Core/DataBlock/DataBlockAllocator.h>
+#include <Core/Utils/Log.h>
+#include <Core/Utils/ThreadPool.h>
+
+namespace Core
+{
+
+CORE_SINGLETON_IMPLEMENTATION( DataBlockAllocator );
+
+const size_t DataBlockAllocator::ALIGNMENT_C = 64;
+const size_t DataBlockAllocator::LARGE_BUFFER_SIZE_C = 4 << 20;
+const size_t DataBlockAllocator::HUGE_PAGE_SIZE_C = 2 << 20;
+
+namespace
+{
+
+// Default number of bytes that the pool may keep
+const size_t DEFAULT_POOL_LIMIT_C = size_t( 1 ) << 30;
+
+// Stride of the first touch, the smallest page size
+const size_t PAGE_SIZE_C = 4096;
+
+// Number of pages that a task touches
+const size_t TOUCH_GRAIN_C = 256;
+
+void* SystemAllocate( size_t size, size_t alignment )
+{
+#if defined( _WIN32 )
+  return _aligned_malloc( size, alignment );
+#else
+  void* data = 0;
+  if ( posix_memalign( &data, alignment, size ) != 0 ) return 0;
+  return data;
+#endif
+}
+
+void SystemFree( void* data )
+{
+#if defined( _WIN32 )
+  _aligned_free( data );
+#else
+  free( data );
+#endif
+}
+
+void FreeBuffers( const std::vector< void* >& buffers )
+{
+  for ( size_t j = 0; j < buffers.size(); j++ )
+  {
+    SystemFree( buffers[ j ] );
+  }
+}
+
+void TouchPages( char* data, size_t begin, size_t end )
+{
+  for ( size_t page = begin; page < end; page++ )
+  {
+    data[ page * PAGE_SIZE_C ] = 0;
+  }
+}
+
+} // end anonymous namespace
+
+DataBlockAllocatorStatistics::DataBlockAllocatorStatistics() :
+  num_allocations_( 0 ),
+  num_deallocations_( 0 ),
+  num_pool_hits_( 0 ),
+  num_system_allocations_( 0 ),
+  num_huge_page_allocations_( 0 ),
+  bytes_in_use_( 0 ),
+  peak_bytes_in_use_( 0 ),
+  bytes_pooled_( 0 )
+{
+}
+
+class DataBlockAllocatorPrivate
+{
+public:
+  // GET_CAPACITY:
+  // Size of the buffer that is allocated for a request of size bytes. Large buffers are rounded 
+  // up to whole huge pages, which also makes them fall into buckets for the pool.
+  size_t get_capacity( size_t size ) const
+  {
+    if ( size >= DataBlockAllocator::LARGE_BUFFER_SIZE_C )
+    {
+      return ( size + DataBlockAllocator::HUGE_PAGE_SIZE_C - 1 ) / 
+        DataBlockAllocator::HUGE_PAGE_SIZE_C * DataBlockAllocator::HUGE_PAGE_SIZE_C;
+    }
+    // new[] of zero elements returns a valid pointer as well
+    return std::max( size, static_cast< size_t >( 1 ) );
+  }
+
+  // TAKE_FROM_POOL:
+  // Remove a buffer of the given capacity from the pool, returns 0 if there is none.
+  void* take_from_pool( size_t capacity );
+
+  // TRIM_POOL:
+  // Remove the least recently released buffers until the pool fits in limit. The buffers are 
+  // appended to released so they can be freed without holding the lock.
+  void trim_pool( size_t limit, std::vector< void* >& released );
+
+  // Pooled buffers and their capacity, the most recently released buffer is at the front
+  std::list< std::pair< size_t, void* > > pool_;
+
+  size_t pool_limit_;
+  bool huge_pages_;
+  DataBlockAllocatorStatistics statistics_;
+};
+
+void* DataBlockAllocatorPrivate::take_from_pool( size_t capacity )
+{
+  std::list< std::pair< size_t, void* > >::iterator it = this->pool_.begin();
+  for ( ; it != this->pool_.end(); ++it )
+  {
+    if ( it->first == capacity )
+    {
+      void* data = it->second;
+      this->pool_.erase( it );
+      this->statistics_.bytes_pooled_ -= capacity;
+      return data;
+    }
+  }
+  return 0;
+}
+
+void DataBlockAllocatorPrivate::trim_pool( size_t limit, std::vector< void* >& released )
+{
+  while ( this->statistics_.bytes_pooled_ > limit )
+  {
+    this->statistics_.bytes_pooled_ -= this->pool_.back().first;
+    released.push_back( this->pool_.back().second );
+    this->pool_.pop_back();
+  }
+}
+
+DataBlockAllocator::DataBlockAllocator() :
+  private_( new DataBlockAllocatorPrivate )
+{
+  this->private_->pool_limit_ = DEFAULT_POOL_LIMIT_C;
+  this->private_->huge_pages_ = true;
+}
+
+DataBlockAllocator::~DataBlockAllocator()
+{
+  this->flush_pool();
+}
+
+void* DataBlockAllocator::allocate( size_t size )
+{
+  size_t capacity = this->private_->get_capacity( size );
+  bool large = capacity >= LARGE_BUFFER_SIZE_C;
+  bool huge_pages = false;
+  {
+    lock_type lock( this->get_mutex() );
+    DataBlockAllocatorStatistics& statistics = this->private_->statistics_;
+    statistics.num_allocations_++;
+    void* data = large ? this->private_->take_from_pool( capacity ) : 0;
+    if ( data )
+    {
+      statistics.num_pool_hits_++;
+      statistics.bytes_in_use_ += capacity;
+      statistics.peak_bytes_in_use_ = std::max( statistics.peak_bytes_in_use_, 
+        statistics.bytes_in_use_ );
+      return data;
+    }
+    huge_pages = large && this->private_->huge_pages_;
+  }
+
+  // NOTE: Allocating and touching a new buffer can take a while, so it is done without holding
+  // the lock.
+  size_t alignment = huge_pages ? HUGE_PAGE_SIZE_C : ALIGNMENT_C;
+  void* data = SystemAllocate( capacity, alignment );
+  if ( data == 0 )
+  {
+    // Give the memory that the pool holds back to the system and try again
+    CORE_LOG_DEBUG( "DataBlockAllocator: releasing the pool to allocate a buffer" );
+    this->flush_pool();
+    data = SystemAllocate( capacity, alignment );
+    if ( data == 0 ) throw std::bad_alloc();
+  }
+
+  if ( large )
+  {
+#if defined( __linux__ ) && defined( MADV_HUGEPAGE )
+    if ( huge_pages && madvise( data, capacity, MADV_HUGEPAGE ) != 0 ) huge_pages = false;
+#else
+    huge_pages = false;
+#endif
+    // Fault the pages in on the threads of the pool, which also places them close to the 
+    // threads that process the volume in parallel
+    parallel_for( 0, ( capacity + PAGE_SIZE_C - 1 ) / PAGE_SIZE_C, TOUCH_GRAIN_C, 
+      boost::bind( &TouchPages, static_cast< char* >( data ), _1, _2 ) );
+  }
+
+  lock_type lock( this->get_mutex() );
+  DataBlockAllocatorStatistics& statistics = this->private_->statistics_;
+  statistics.num_system_allocations_++;
+  if ( huge_pages ) statistics.num_huge_page_allocations_++;
+  statistics.bytes_in_use_ += capacity;
+  statistics.peak_bytes_in_use_ = std::max( statistics.peak_bytes_in_use_, 
+    statistics.bytes_in_use_ );
+  return data;
+}
+
+void DataBlockAllocator::deallocate( void* data, size_t size )
+{
+  if ( data == 0 ) return;
+
+  size_t capacity = this->private_->get_capacity( size );
+  std::vector< void* > released;
+  {
+    lock_type lock( this->get_mutex() );
+    DataBlockAllocatorStatistics& statistics = this->private_->statistics_;
+    statistics.num_deallocations_++;
+    statistics.bytes_in_use_ -= capacity;
+    if ( capacity >= LARGE_BUFFER_SIZE_C && capacity <= this->private_->pool_limit_ )
+    {
+      this->private_->pool_.push_front( std::make_pair( capacity, data ) );
+      statistics.bytes_pooled_ += capacity;
+      this->private_->trim_pool( this->private_->pool_limit_, released );
+    }
+    else
+    {
+      released.push_back( data );
+    }
+  }
+
+  FreeBuffers( released );
+}
+
+void DataBlockAllocator::flush_pool()
+{
+  std::vector< void* > released;
+  {
+    lock_type lock( this->get_mutex() );
+    this->private_->trim_pool( 0, released );
+  }
+
+  FreeBuffers( released );
+}
+
+void DataBlockAllocator::set_pool_limit( size_t limit )
+{
+  std::vector< void* > released;
+  {
+    lock_type lock( this->get_mutex() );
+    this->private_->pool_limit_ = limit;
+    this->private_->trim_pool( limit, released );
+  }
+
+  FreeBuffers( released );
+}
+
+size_t DataBlockAllocator::get_pool_limit()
+{
+  lock_type lock( this->get_mutex() );
+  return this->private_->pool_limit_;
+}
+
+void DataBlockAllocator::set_huge_pages( bool enable )
+{
+  lock_type lock( this->get_mutex() );
+  this->private_->huge_pages_ = enable;
+}
+
+bool DataBlockAllocator::get_huge_pages()
+{
+  lock_type lock( this->get_mutex() );
+  return this->private_->huge_pages_;
+}
+
+DataBlockAllocatorStatistics DataBlockAllocator::get_statistics()
+{
+  lock_type lock( this->get_mutex() );
+  return this->private_->statistics_;
+}
+
+} // end namespace Core
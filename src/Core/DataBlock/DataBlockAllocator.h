@@ -0,0 +1,148 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORE_DATABLOCK_DATABLOCKALLOCATOR_H
+#define CORE_DATABLOCK_DATABLOCKALLOCATOR_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif 
+
+// Boost includes
+#include <boost/smart_ptr.hpp>
+
+// Core includes
+#include <Core/Utils/Singleton.h>
+#include <Core/Utils/Lockable.h>
+
+namespace Core
+{
+
+// Forward Declaration
+class DataBlockAllocator;
+class DataBlockAllocatorPrivate;
+typedef boost::shared_ptr< DataBlockAllocatorPrivate > DataBlockAllocatorPrivateHandle;
+
+// CLASS DATABLOCKALLOCATORSTATISTICS:
+/// Counters of the DataBlockAllocator. Sizes are in bytes and include the rounding to the 
+/// bucket size.
+class DataBlockAllocatorStatistics
+{
+public:
+  DataBlockAllocatorStatistics();
+
+  // Number of calls to allocate and deallocate
+  size_t num_allocations_;
+  size_t num_deallocations_;
+
+  // Number of allocations that reused a pooled buffer
+  size_t num_pool_hits_;
+
+  // Number of buffers that were requested from the system, and how many of them were advised to
+  // use huge pages
+  size_t num_system_allocations_;
+  size_t num_huge_page_allocations_;
+
+  // Memory handed out, the most that was handed out at once, and memory kept in the pool
+  size_t bytes_in_use_;
+  size_t peak_bytes_in_use_;
+  size_t bytes_pooled_;
+};
+
+// CLASS DATABLOCKALLOCATOR:
+/// Allocates the memory of StdDataBlocks. Buffers are aligned to 64 bytes for SIMD code, and 
+/// large buffers are aligned to, and on Linux advised to use, transparent huge pages. Large 
+/// buffers that are released are kept in a pool, bucketed by size, so that a filter that 
+/// creates a volume of the same size as the one it just released does not have to allocate and 
+/// page in the memory again. New large buffers are first touched in parallel, so the page 
+/// faults are spread over the ThreadPool instead of being taken serially by the first filter 
+/// that writes the data.
+
+class DataBlockAllocator : public Lockable
+{
+  CORE_SINGLETON( DataBlockAllocator );
+
+  // -- Constructor/destructor --
+private:
+  DataBlockAllocator();
+  virtual ~DataBlockAllocator();
+
+  // -- Allocation --
+public:
+  // ALLOCATE:
+  /// Allocate a buffer of at least size bytes. The contents are undefined. Throws 
+  /// std::bad_alloc if the memory is not available, even after releasing the pool.
+  void* allocate( size_t size );
+
+  // DEALLOCATE:
+  /// Release a buffer that was allocated with the same size. Large buffers are kept in the pool
+  /// as long as it stays below its limit, the least recently released buffers are freed first.
+  void deallocate( void* data, size_t size );
+
+  // FLUSH_POOL:
+  /// Free all the buffers that are kept in the pool.
+  void flush_pool();
+
+  // -- Settings --
+public:
+  // SET_POOL_LIMIT:
+  /// Set the number of bytes that the pool may keep. A limit of 0 disables the pool.
+  void set_pool_limit( size_t limit );
+  size_t get_pool_limit();
+
+  // SET_HUGE_PAGES:
+  /// Set whether large buffers are advised to use transparent huge pages. This only has an 
+  /// effect on Linux.
+  void set_huge_pages( bool enable );
+  bool get_huge_pages();
+
+  // -- Statistics --
+public:
+  // GET_STATISTICS:
+  /// Get a snapshot of the counters.
+  DataBlockAllocatorStatistics get_statistics();
+
+  // -- internals --
+private:
+  DataBlockAllocatorPrivateHandle private_;
+
+  // -- constants --
+public:
+  /// Alignment of every buffer
+  static const size_t ALIGNMENT_C;
+
+  /// Smallest buffer that is pooled, touched in parallel and rounded to whole huge pages
+  static const size_t LARGE_BUFFER_SIZE_C;
+
+  /// Size of a transparent huge page
+  static const size_t HUGE_PAGE_SIZE_C;
+};
+
+} // end namespace Core
+
+#endif
@@ -32,9 +32,11 @@
 
 // Boost includes
 #include <boost/algorithm/minmax_element.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
 
 // Core includes
-#include <Core/Utils/Parallel.h>
+#include <Core/Utils/ThreadPool.h>
 #include <Core/Utils/StringUtil.h>
 #include <Core/Math/MathFunctions.h>
 #include <Core/DataBlock/Histogram.h>
@@ -44,11 +46,7 @@ namespace Core
 
 Histogram::Histogram()
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
+  this->reset();
 }
 
 Histogram::Histogram( const signed char* data, size_t size )
@@ -105,748 +103,563 @@ Histogram::~Histogram()
 {
 }
 
-// For char and short data we do a single pass over the data to speed up the computation. The
-// first pass is used to generate the histogram. In the next step we use this data to compute
-// min and max
+// The histogram is computed on the thread pool. The data is split into chunks, each chunk is
+// reduced into its own minimum/maximum or its own set of partial bins and these are merged
+// afterwards. The inner loops are written without branches so that the compiler can vectorize
+// them.
 
-bool Histogram::compute( const signed char* data, size_t size )
+namespace
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
-  if ( size == 0 ) return false;
-
-  try
-  {
-    std::vector<size_t> histogram;
-    histogram.resize( 0x100 , 0 );
 
-    for ( size_t j = 0 ; j < size ; j++ )
-    {
-      histogram[ static_cast<int>( data[ j ] ) + 0x80 ]++;
-    }
+// Minimum number of values that are processed by a single chunk
+const size_t HISTOGRAM_GRAIN_C = 0x40000;
 
-    size_t hist_begin = 0;
-    size_t hist_end = 0;
+// Number of interleaved partial histograms per chunk. Consecutive values are counted in
+// different tables, so that runs of equal values do not stall on the same counter.
+const size_t HISTOGRAM_INTERLEAVE_C = 4;
 
-    for ( size_t j = 0 ; j < histogram.size() ; j++ )
-    {
-      if ( histogram[ j ] > 0 ) hist_end = j;
-    }
-
-    size_t hsize = histogram.size();
-    for ( size_t j = 0 ; j < hsize; j++ )
-    {
-      if ( histogram[ hsize - 1 - j ] > 0 ) hist_begin = hsize - 1 - j;
-    }
-
-    this->min_ = static_cast<double>( hist_begin ) - static_cast<double>( 0x80 );
-    this->max_ = static_cast<double>( hist_end ) - static_cast<double>( 0x80 );
-
-    this->bin_size_  = 1.0;
-    this->bin_start_ = this->min_ - 0.5;
-
-    this->histogram_.resize( hist_end + 1 - hist_begin );
-    for ( size_t j = 0 ; j < histogram_.size() ; j++ )
-    {
-      this->histogram_[ j ] = histogram[ j + hist_begin ];
-    }
+size_t GetNumChunks( size_t size )
+{
+  size_t num_chunks = ( size + HISTOGRAM_GRAIN_C - 1 ) / HISTOGRAM_GRAIN_C;
+  // A few chunks per thread so that the load is balanced
+  size_t max_chunks = 4 * static_cast<size_t>( ThreadPool::Instance()->get_concurrency() );
+  return Max( static_cast<size_t>( 1 ), Min( num_chunks, max_chunks ) );
+}
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
-  }
-  catch( ... )
-  {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
-    return false;
-  }
+size_t GetChunkStart( size_t size, size_t num_chunks, size_t chunk )
+{
+  return static_cast<size_t>( ( static_cast<unsigned long long>( size ) * chunk ) / num_chunks );
+}
 
+// Only finite values are part of the histogram. For floating point values x - x is zero for
+// finite values and NaN otherwise, this test does not need a branch.
+template< class T >
+inline bool IsValidValue( T /*val*/ )
+{
   return true;
 }
 
-bool Histogram::compute( const unsigned char* data, size_t size )
+inline bool IsValidValue( float val )
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
-  if ( size == 0 ) return false;
-
-  try
-  {
-    std::vector<size_t> histogram;
-    histogram.resize( 0x100, 0 );
-
-    for ( size_t j = 0 ; j < size ; j++ )
-    {
-      histogram[ static_cast<int>( data[ j ] ) ]++;
-    }
+  return ( val - val ) == 0.0f;
+}
 
-    size_t hist_begin = 0;
-    size_t hist_end = 0;
+inline bool IsValidValue( double val )
+{
+  return ( val - val ) == 0.0;
+}
 
-    for ( size_t j = 0 ; j < histogram.size() ; j++ )
-    {
-      if ( histogram[ j ] > 0 ) hist_end = j;
-    }
+template< class T >
+void MinMaxChunks( const T* data, size_t size, size_t num_chunks, std::vector<T>& mins,
+  std::vector<T>& maxs, size_t chunk_begin, size_t chunk_end )
+{
+  for ( size_t c = chunk_begin; c < chunk_end; c++ )
+  {
+    size_t end = GetChunkStart( size, num_chunks, c + 1 );
+    T min_val = std::numeric_limits<T>::max();
+    T max_val = std::numeric_limits<T>::lowest();
 
-    size_t hsize = histogram.size();
-    for ( size_t j = 0 ; j < hsize; j++ )
+    for ( size_t j = GetChunkStart( size, num_chunks, c ); j < end; j++ )
     {
-      if ( histogram[ hsize - 1 - j ] > 0 ) hist_begin = hsize - 1 - j;
+      T val = data[ j ];
+      bool valid = IsValidValue( val );
+      min_val = ( valid && val < min_val ) ? val : min_val;
+      max_val = ( valid && val > max_val ) ? val : max_val;
     }
 
+    mins[ c ] = min_val;
+    maxs[ c ] = max_val;
+  }
+}
 
-    this->min_ = static_cast<double>( hist_begin );
-    this->max_ = static_cast<double>( hist_end );
-
-    this->bin_size_  = 1.0;
-    this->bin_start_ = this->min_ - 0.5;
-
-    this->histogram_.resize( hist_end + 1 - hist_begin );
+// COMPUTEMINMAX:
+// Compute the minimum and maximum of the finite values in the data. Returns false if there are
+// no finite values.
+template< class T >
+bool ComputeMinMax( const T* data, size_t size, T& min_val, T& max_val )
+{
+  size_t num_chunks = GetNumChunks( size );
+  std::vector<T> mins( num_chunks );
+  std::vector<T> maxs( num_chunks );
 
-    for ( size_t j = 0 ; j < histogram_.size() ; j++ )
-    {
-      this->histogram_[ j ] = histogram[ j + hist_begin ];
-    }
+  parallel_for( 0, num_chunks, 1, boost::bind( &MinMaxChunks<T>, data, size, num_chunks,
+    boost::ref( mins ), boost::ref( maxs ), _1, _2 ) );
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
-  }
-  catch( ... )
+  min_val = std::numeric_limits<T>::max();
+  max_val = std::numeric_limits<T>::lowest();
+  for ( size_t c = 0; c < num_chunks; c++ )
   {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
-    return false;
+    if ( mins[ c ] < min_val ) min_val = mins[ c ];
+    if ( maxs[ c ] > max_val ) max_val = maxs[ c ];
   }
 
-  return true;
+  return !( min_val > max_val );
 }
 
-bool Histogram::compute( const short* data, size_t size )
+template< class T, class BINNER >
+void BinChunks( const T* data, size_t size, size_t num_chunks, const BINNER& binner,
+  size_t num_bins, std::vector<size_t>& partials, size_t chunk_begin, size_t chunk_end )
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
-  if ( size == 0 ) return false;
-
-  try
+  for ( size_t c = chunk_begin; c < chunk_end; c++ )
   {
-    std::vector<size_t> histogram;
-    histogram.resize( 0x10000 , 0 );
-
-    for ( size_t j = 0 ; j < size ; j++ )
-    {
-      histogram[ static_cast<int>( data[ j ] ) + 0x8000 ]++;
-    }
+    size_t* bins0 = &partials[ c * HISTOGRAM_INTERLEAVE_C * num_bins ];
+    size_t* bins1 = bins0 + num_bins;
+    size_t* bins2 = bins1 + num_bins;
+    size_t* bins3 = bins2 + num_bins;
 
-    size_t hist_begin = 0;
-    size_t hist_end = 0;
+    size_t j = GetChunkStart( size, num_chunks, c );
+    size_t end = GetChunkStart( size, num_chunks, c + 1 );
 
-    for ( size_t j = 0 ; j < histogram.size() ; j++ )
+    for ( ; j + 4 <= end; j += 4 )
     {
-      if ( histogram[ j ] > 0 ) hist_end = j;
+      bins0[ binner( data[ j ] ) ]++;
+      bins1[ binner( data[ j + 1 ] ) ]++;
+      bins2[ binner( data[ j + 2 ] ) ]++;
+      bins3[ binner( data[ j + 3 ] ) ]++;
     }
 
-    size_t hsize = histogram.size();
-    for ( size_t j = 0 ; j < hsize; j++ )
+    for ( ; j < end; j++ )
     {
-      if ( histogram[ hsize - 1 - j ] > 0 ) hist_begin = hsize - 1 - j;
+      bins0[ binner( data[ j ] ) ]++;
     }
+  }
+}
 
-    this->min_ = static_cast<double>( hist_begin ) - static_cast<double>( 0x8000 );
-    this->max_ = static_cast<double>( hist_end ) - static_cast<double>( 0x8000 );
-
-    size_t hist_length = hist_end + 1 - hist_begin;
-    if ( hist_length > 0x100 ) hist_length = 0x100;
-
-    this->histogram_.resize( hist_length, 0 );
+// BINVALUES:
+// Count the values in each bin. The binner maps a value onto a bin index, values that are not
+// part of the histogram are mapped onto index num_bins and are not counted.
+template< class T, class BINNER >
+void BinValues( const T* data, size_t size, const BINNER& binner, size_t num_bins,
+  std::vector<size_t>& bins )
+{
+  size_t num_chunks = GetNumChunks( size );
+  size_t stride = num_bins + 1;
+  std::vector<size_t> partials( num_chunks * HISTOGRAM_INTERLEAVE_C * stride, 0 );
 
-    if ( hist_length == 1 )
-    {
-      this->bin_size_  = 1.0;
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
-    else
-    {
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_length - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
+  parallel_for( 0, num_chunks, 1, boost::bind( &BinChunks<T, BINNER>, data, size, num_chunks,
+    boost::cref( binner ), stride, boost::ref( partials ), _1, _2 ) );
 
-    for ( size_t j = 0 ; j < histogram_.size() ; j++ )
+  bins.assign( num_bins, 0 );
+  for ( size_t p = 0; p < num_chunks * HISTOGRAM_INTERLEAVE_C; p++ )
+  {
+    const size_t* partial = &partials[ p * stride ];
+    for ( size_t j = 0; j < num_bins; j++ )
     {
-      double min_value = this->bin_start_ + j * this->bin_size_;
-      double max_value = this->bin_start_ + ( j + 1 ) * this->bin_size_;
-
-      for ( int k = Ceil( min_value ) ; k < Ceil( max_value ); k++ )
-      {
-        int idx = static_cast<int>( k ) + 0x8000;
-        if ( idx >= 0 && idx < static_cast<int>( histogram.size() ) )
-        {
-          this->histogram_[ j ] += histogram[ idx ];
-        }
-      }
+      bins[ j ] += partial[ j ];
     }
-
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
-  }
-  catch( ... )
-  {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
-    return false;
   }
-
-  return true;
 }
 
-
-bool Histogram::compute( const unsigned short* data, size_t size )
+// CLASS OFFSETBINNER:
+// Maps integer values directly onto bins, one bin per value.
+template< class T >
+class OffsetBinner
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
-  if ( size == 0 ) return false;
-
-  try
+public:
+  OffsetBinner( int offset ) :
+    offset_( offset )
   {
-    std::vector<size_t> histogram;
-    histogram.resize( 0x10000 , 0 );
-
-    for ( size_t j = 0 ; j < size ; j++ )
-    {
-      histogram[ static_cast<int>( data[ j ] ) ]++;
-    }
-
-    size_t hist_begin = 0;
-    size_t hist_end = 0;
-
-    for ( size_t j = 0 ; j < histogram.size() ; j++ )
-    {
-      if ( histogram[ j ] > 0 ) hist_end = j;
-    }
-
-    size_t hsize = histogram.size();
-    for ( size_t j = 0 ; j < hsize; j++ )
-    {
-      if ( histogram[ hsize - 1 - j ] > 0 ) hist_begin = hsize - 1 - j;
-    }
-
-    this->min_ = static_cast<double>( hist_begin );
-    this->max_ = static_cast<double>( hist_end );
-
-    size_t hist_length = hist_end + 1 - hist_begin;
-    if ( hist_length > 0x100 ) hist_length = 0x100;
-
-    this->histogram_.resize( hist_length, 0 );
+  }
 
-    if ( hist_length == 1 )
-    {
-      this->bin_size_  = 1.0;
-      this->bin_start_ = min_ - ( this->bin_size_ * 0.5 );
-    }
-    else
-    {
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_length - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
+  size_t operator()( T val ) const
+  {
+    return static_cast<size_t>( static_cast<int>( val ) + this->offset_ );
+  }
 
-    for ( size_t j = 0 ; j < histogram_.size() ; j++ )
+private:
+  int offset_;
+};
+
+// CLASS TABLEBINNER:
+// Maps 8 and 16 bit integer values onto bins through a lookup table. A value k belongs to bin j
+// if Ceil( bin_start + j * bin_size ) <= k < Ceil( bin_start + ( j + 1 ) * bin_size ).
+template< class T >
+class TableBinner
+{
+public:
+  TableBinner( int min, int max, double bin_start, double bin_size, size_t num_bins ) :
+    min_( min ),
+    num_bins_( num_bins ),
+    table_( max - min + 1, static_cast<unsigned short>( num_bins ) )
+  {
+    for ( size_t j = 0; j < num_bins; j++ )
     {
-      double min_value = this->bin_start_ + j * this->bin_size_;
-      double max_value = this->bin_start_ + ( j + 1 ) * this->bin_size_;
-
-      for ( int k = Ceil( min_value ) ; k < Ceil( max_value ); k ++ )
+      int bin_begin = Max( min, Ceil( bin_start + j * bin_size ) );
+      int bin_end = Min( max + 1, Ceil( bin_start + ( j + 1 ) * bin_size ) );
+      for ( int k = bin_begin; k < bin_end; k++ )
       {
-        int idx = static_cast<int>( k );
-        if ( idx >= 0 && idx < static_cast<int>( histogram.size() ) )
-        {
-          this->histogram_[ j ] += histogram[ idx ];
-        }
+        this->table_[ k - min ] = static_cast<unsigned short>( j );
       }
     }
+  }
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
+  size_t operator()( T val ) const
+  {
+    size_t idx = static_cast<size_t>( static_cast<int>( val ) - this->min_ );
+    return idx < this->table_.size() ? this->table_[ idx ] : this->num_bins_;
   }
-  catch( ... )
+
+private:
+  int min_;
+  size_t num_bins_;
+  std::vector<unsigned short> table_;
+};
+
+// CLASS LINEARBINNER:
+// Maps values onto bins of equal size, R is the type used for the arithmetic.
+template< class T, class R >
+class LinearBinner
+{
+public:
+  LinearBinner( R min, R inv_bin_size, size_t num_bins ) :
+    min_( min ),
+    inv_bin_size_( inv_bin_size ),
+    last_bin_( static_cast<R>( num_bins - 1 ) ),
+    invalid_bin_( static_cast<R>( num_bins ) )
   {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
-    return false;
   }
 
-  return true;
-}
+  size_t operator()( T val ) const
+  {
+    R pos = ( static_cast<R>( val ) - this->min_ ) * this->inv_bin_size_;
+    // Rounding may push the maximum just beyond the last bin
+    pos = ( pos < this->last_bin_ ) ? pos : this->last_bin_;
+    pos = ( pos > R( 0 ) ) ? pos : R( 0 );
+    return static_cast<size_t>( IsValidValue( val ) ? pos : this->invalid_bin_ );
+  }
 
+private:
+  R min_;
+  R inv_bin_size_;
+  R last_bin_;
+  R invalid_bin_;
+};
 
-bool Histogram::compute( const int* data, size_t size )
+} // end anonymous namespace
+
+void Histogram::reset()
 {
   this->min_ = Core::Nan();
   this->max_ = Core::Nan();
   this->bin_start_ = Core::Nan();
   this->bin_size_ = Core::Nan();
+  this->min_bin_ = 0;
+  this->max_bin_ = 0;
   this->histogram_.resize( 0 );
-  if ( size == 0 ) return false;
-
-  try
-  {
-    int int_min = data[ 0 ];
-    int int_max = data[ 0 ];
-
-    for ( size_t j = 1 ; j < size ; j++ )
-    {
-      if ( data[ j ] < int_min ) int_min = data[ j ];
-      if ( data[ j ] > int_max ) int_max = data[ j ];
-    }
-
-    this->min_ = static_cast<double>( int_min );
-    this->max_ = static_cast<double>( int_max );
-
-    if ( this->min_ == this->max_ )
-    {
-      this->bin_size_  = 1.0;
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-      this->histogram_.resize( 1, 0 );
-    }
-    else if ( ( this->max_ - this->min_ ) < 256.0 )
-    {
-      size_t hist_size = static_cast<size_t>( this->max_ - this->min_ ) + 1;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
-    else
-    {
-      size_t hist_size = 0x100;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
+}
 
-    double inv_bin_size = 1.0 / this->bin_size_;
-    for ( size_t j = 1 ; j < size ; j++ )
-    {
-      size_t idx = static_cast<size_t>( ( static_cast<double>( data[j] ) -
-        this->min_ ) * inv_bin_size );
-      this->histogram_[ idx ]++;
-    }
+void Histogram::set_bin_range( double min, double max, size_t num_bins )
+{
+  this->min_ = min;
+  this->max_ = max;
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
+  if ( num_bins == 1 )
+  {
+    this->bin_size_  = 1.0;
   }
-  catch( ... )
+  else
   {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
-    return false;
+    this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( num_bins - 1 );
   }
+  this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
+}
 
-  return true;
+void Histogram::update_min_max_bin()
+{
+  std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
+    boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
+  this->min_bin_ = (*min_max.first);
+  this->max_bin_ = (*min_max.second);
 }
 
+// For char data we do a single pass over the data that counts each value, min and max are
+// derived from the counts. For short data the lookup table is limited to the range of the data,
+// hence we compute min and max first.
 
-bool Histogram::compute( const unsigned int* data, size_t size )
+template< class T >
+bool Histogram::compute_table( const T* data, size_t size )
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
+  this->reset();
   if ( size == 0 ) return false;
 
   try
   {
-    unsigned int int_min = data[ 0 ];
-    unsigned int int_max = data[ 0 ];
+    int data_min = 0;
+    int data_max = 0;
 
-    for ( size_t j = 1 ; j < size ; j++ )
+    if ( sizeof( T ) == 1 )
     {
-      if ( data[ j ] < int_min ) int_min = data[ j ];
-      if ( data[ j ] > int_max ) int_max = data[ j ];
-    }
+      int offset = -static_cast<int>( std::numeric_limits<T>::min() );
+      std::vector<size_t> counts;
+      BinValues( data, size, OffsetBinner<T>( offset ), 0x100, counts );
 
-    this->min_ = static_cast<double>( int_min );
-    this->max_ = static_cast<double>( int_max );
+      size_t hist_begin = 0;
+      while ( counts[ hist_begin ] == 0 ) hist_begin++;
+      size_t hist_end = counts.size() - 1;
+      while ( counts[ hist_end ] == 0 ) hist_end--;
 
-    if ( this->min_ == this->max_ )
-    {
-      this->bin_size_  = 1.0;
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-      this->histogram_.resize( 1, 0 );
-    }
-    else if ( ( this->max_ - this->min_ ) < 256.0 )
-    {
-      size_t hist_size = static_cast<size_t>( this->max_ - this->min_ ) + 1;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
+      data_min = static_cast<int>( hist_begin ) - offset;
+      data_max = static_cast<int>( hist_end ) - offset;
+
+      this->set_bin_range( data_min, data_max, hist_end + 1 - hist_begin );
+      this->histogram_.assign( counts.begin() + hist_begin, counts.begin() + hist_end + 1 );
     }
     else
     {
-      size_t hist_size = 0x100;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
+      T min_val, max_val;
+      ComputeMinMax( data, size, min_val, max_val );
+      data_min = static_cast<int>( min_val );
+      data_max = static_cast<int>( max_val );
 
-    double inv_bin_size = 1.0 / this->bin_size_;
-    for ( size_t j = 1 ; j < size ; j++ )
-    {
-      size_t idx = static_cast<size_t>( ( static_cast<double>( data[j] ) - this->min_ ) * inv_bin_size );
-      this->histogram_[ idx ]++;
+      size_t hist_length = Min( static_cast<size_t>( data_max - data_min ) + 1, 
+        static_cast<size_t>( 0x100 ) );
+      this->set_bin_range( data_min, data_max, hist_length );
+
+      TableBinner<T> binner( data_min, data_max, this->bin_start_, this->bin_size_,
+        hist_length );
+      BinValues( data, size, binner, hist_length, this->histogram_ );
     }
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
+    this->update_min_max_bin();
   }
   catch( ... )
   {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
+    this->reset();
     return false;
   }
 
   return true;
 }
 
-
-bool Histogram::compute( const long long* data, size_t size )
+template< class T, class R >
+bool Histogram::compute_linear( const T* data, size_t size )
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
+  this->reset();
   if ( size == 0 ) return false;
 
   try
   {
-    long long int_min = data[ 0 ];
-    long long int_max = data[ 0 ];
-
-    for ( size_t j = 1 ; j < size ; j++ )
+    T min_val, max_val;
+    if ( !ComputeMinMax( data, size, min_val, max_val ) )
     {
-      if ( data[ j ] < int_min ) int_min = data[ j ];
-      if ( data[ j ] > int_max ) int_max = data[ j ];
+      // Most likely all the data is NaN
+      return false;
     }
 
-    this->min_ = static_cast<double>( int_min );
-    this->max_ = static_cast<double>( int_max );
+    double data_min = static_cast<double>( min_val );
+    double data_max = static_cast<double>( max_val );
 
-    if ( this->min_ == this->max_ )
+    size_t hist_size = 0x100;
+    if ( data_min == data_max )
     {
-      this->bin_size_  = 1.0;
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-      this->histogram_.resize( 1, 0 );
+      hist_size = 1;
     }
-    else if ( ( this->max_ - this->min_ ) < 256.0 )
+    else if ( std::numeric_limits<T>::is_integer && ( data_max - data_min ) < 256.0 )
     {
-      size_t hist_size = static_cast<size_t>( this->max_ - this->min_ ) + 1;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
-    else
-    {
-      size_t hist_size = 0x100;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
+      hist_size = static_cast<size_t>( data_max - data_min ) + 1;
     }
+    this->set_bin_range( data_min, data_max, hist_size );
 
-    double inv_bin_size = 1.0 / this->bin_size_;
-    for ( size_t j = 1 ; j < size ; j++ )
-    {
-      size_t idx = static_cast<size_t>( ( static_cast<double>( data[j] ) -
-        this->min_ ) * inv_bin_size );
-      this->histogram_[ idx ]++;
-    }
+    LinearBinner<T, R> binner( static_cast<R>( min_val ), 
+      static_cast<R>( 1.0 / this->bin_size_ ), hist_size );
+    BinValues( data, size, binner, hist_size, this->histogram_ );
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
+    this->update_min_max_bin();
   }
   catch( ... )
   {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
+    this->reset();
     return false;
   }
 
   return true;
 }
 
+template< class T >
+bool Histogram::update_table( const T* old_data, const T* new_data, size_t size )
+{
+  if ( !this->is_valid() ) return false;
 
-bool Histogram::compute( const unsigned long long* data, size_t size )
+  TableBinner<T> binner( static_cast<int>( this->min_ ), static_cast<int>( this->max_ ), 
+    this->bin_start_, this->bin_size_, this->histogram_.size() );
+  return this->update_bins( old_data, new_data, size, binner );
+}
+
+template< class T, class R >
+bool Histogram::update_linear( const T* old_data, const T* new_data, size_t size )
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
-  if ( size == 0 ) return false;
+  if ( !this->is_valid() ) return false;
+
+  LinearBinner<T, R> binner( static_cast<R>( this->min_ ), 
+    static_cast<R>( 1.0 / this->bin_size_ ), this->histogram_.size() );
+  return this->update_bins( old_data, new_data, size, binner );
+}
+
+template< class T, class BINNER >
+bool Histogram::update_bins( const T* old_data, const T* new_data, size_t size,
+  const BINNER& binner )
+{
+  if ( size == 0 ) return true;
 
   try
   {
-    unsigned long long int_min = data[ 0 ];
-    unsigned long long int_max = data[ 0 ];
-
-    for ( size_t j = 1 ; j < size ; j++ )
+    // New values outside of the current range change the layout of the bins
+    T min_val, max_val;
+    if ( ComputeMinMax( new_data, size, min_val, max_val ) && 
+      ( static_cast<double>( min_val ) < this->min_ || 
+      static_cast<double>( max_val ) > this->max_ ) )
     {
-      if ( data[ j ] < int_min ) int_min = data[ j ];
-      if ( data[ j ] > int_max ) int_max = data[ j ];
+      return false;
     }
 
-    this->min_ = static_cast<double>( int_min );
-    this->max_ = static_cast<double>( int_max );
-
-    if ( this->min_ == this->max_ )
-    {
-      this->bin_size_  = 1.0;
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-      this->histogram_.resize( 1, 0 );
-    }
-    else if ( ( this->max_ - this->min_ ) < 256.0 )
+    // If the bins count single integer values, the counts of the first and last bin tell
+    // whether the minimum and maximum are still present. Otherwise we cannot tell whether we
+    // removed the last occurrence of the minimum or maximum.
+    bool exact_bins = std::numeric_limits<T>::is_integer && this->bin_size_ == 1.0;
+    if ( ComputeMinMax( old_data, size, min_val, max_val ) )
     {
-      size_t hist_size = static_cast<size_t>( this->max_ - this->min_ ) + 1;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
-    else
-    {
-      size_t hist_size = 0x100;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
+      if ( static_cast<double>( min_val ) < this->min_ ||
+        static_cast<double>( max_val ) > this->max_ ) 
+      {
+        // The old data was not part of this histogram
+        return false;
+      }
+
+      if ( !exact_bins && ( static_cast<double>( min_val ) == this->min_ || 
+        static_cast<double>( max_val ) == this->max_ ) )
+      {
+        return false;
+      }
     }
 
-    double inv_bin_size = 1.0 / this->bin_size_;
-    for ( size_t j = 1 ; j < size ; j++ )
+    size_t num_bins = this->histogram_.size();
+    std::vector<size_t> old_bins;
+    std::vector<size_t> new_bins;
+    BinValues( old_data, size, binner, num_bins, old_bins );
+    BinValues( new_data, size, binner, num_bins, new_bins );
+
+    for ( size_t j = 0; j < num_bins; j++ )
     {
-      size_t idx = static_cast<size_t>( ( static_cast<double>( data[j] ) - this->min_ ) * inv_bin_size );
-      this->histogram_[ idx ]++;
+      new_bins[ j ] += this->histogram_[ j ];
+      if ( new_bins[ j ] < old_bins[ j ] ) return false;
+      new_bins[ j ] -= old_bins[ j ];
     }
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
+    if ( new_bins.front() == 0 || new_bins.back() == 0 ) return false;
+
+    this->histogram_.swap( new_bins );
+    this->update_min_max_bin();
   }
   catch( ... )
   {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
     return false;
   }
 
   return true;
 }
 
-
-bool Histogram::compute( const float* data, size_t size )
+bool Histogram::compute( const signed char* data, size_t size )
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
-  if ( size == 0 ) return false;
-
-  try
-  {
-    float float_min = std::numeric_limits<float>::max();
-    float float_max = std::numeric_limits<float>::min();
+  return this->compute_table( data, size );
+}
 
-    for ( size_t j = 0 ; j < size ; j++ )
-    {
-      float val = data[ j ];
-      if ( ! Core::IsFinite( val ) ) continue;
-      if ( val < float_min ) float_min = val;
-      if ( val > float_max ) float_max = val;
-    }
+bool Histogram::compute( const unsigned char* data, size_t size )
+{
+  return this->compute_table( data, size );
+}
 
-    if ( float_min > float_max )
-    {
-      // Most likely all the data is NaN
-      this->min_ = Core::Nan();
-      this->max_ = Core::Nan();
-      this->bin_start_ = Core::Nan();
-      this->bin_size_ = Core::Nan();
-      this->histogram_.resize( 0 );
-      return false;
-    }
+bool Histogram::compute( const short* data, size_t size )
+{
+  return this->compute_table( data, size );
+}
 
-    this->min_ = static_cast<double>( float_min );
-    this->max_ = static_cast<double>( float_max );
+bool Histogram::compute( const unsigned short* data, size_t size )
+{
+  return this->compute_table( data, size );
+}
 
-    if ( this->min_ == this->max_ )
-    {
-      this->bin_size_  = 1.0;
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-      this->histogram_.resize( 1, 0 );
-    }
-    else
-    {
-      size_t hist_size = 0x100;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
+bool Histogram::compute( const int* data, size_t size )
+{
+  return this->compute_linear<int, double>( data, size );
+}
 
-    float inv_bin_size = static_cast< float >( 1.0f / this->bin_size_ );
-    for ( size_t j = 1 ; j < size ; j++ )
-    {
-      float val = data[ j ];
-      if ( Core::IsFinite( val ) )
-      {
-        size_t idx = static_cast<size_t>( ( val - float_min ) * inv_bin_size );
-        this->histogram_[ idx ]++;
-      }
-    }
+bool Histogram::compute( const unsigned int* data, size_t size )
+{
+  return this->compute_linear<unsigned int, double>( data, size );
+}
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
-  }
-  catch( ... )
-  {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
-    return false;
-  }
+bool Histogram::compute( const long long* data, size_t size )
+{
+  return this->compute_linear<long long, double>( data, size );
+}
 
-  return true;
+bool Histogram::compute( const unsigned long long* data, size_t size )
+{
+  return this->compute_linear<unsigned long long, double>( data, size );
 }
 
+bool Histogram::compute( const float* data, size_t size )
+{
+  return this->compute_linear<float, float>( data, size );
+}
 
 bool Histogram::compute( const double* data, size_t size )
 {
-  this->min_ = Core::Nan();
-  this->max_ = Core::Nan();
-  this->bin_start_ = Core::Nan();
-  this->bin_size_ = Core::Nan();
-  this->histogram_.resize( 0 );
-  if ( size == 0 ) return false;
+  return this->compute_linear<double, double>( data, size );
+}
 
-  try
-  {
-    this->min_ = std::numeric_limits<double>::max();
-    this->max_ = std::numeric_limits<double>::min();
+bool Histogram::update( const signed char* old_data, const signed char* new_data, size_t size )
+{
+  return this->update_table( old_data, new_data, size );
+}
 
-    for ( size_t j = 0 ; j < size ; j++ )
-    {
-      double val = data[ j ];
-      if ( ! Core::IsFinite( val ) ) continue;
-      if ( val < this->min_ ) this->min_ = val;
-      if ( val > this->max_ ) this->max_ = val;
-    }
+bool Histogram::update( const unsigned char* old_data, const unsigned char* new_data, 
+  size_t size )
+{
+  return this->update_table( old_data, new_data, size );
+}
 
-    if ( this->min_ > this->max_ )
-    {
-      // Most likely all the data is NaN
-      this->min_ = Core::Nan();
-      this->max_ = Core::Nan();
-      this->bin_start_ = Core::Nan();
-      this->bin_size_ = Core::Nan();
-      this->histogram_.resize( 0 );
-      return false;
-    }
+bool Histogram::update( const short* old_data, const short* new_data, size_t size )
+{
+  return this->update_table( old_data, new_data, size );
+}
 
-    if ( this->min_ == this->max_ )
-    {
-      this->bin_size_  = 1.0;
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-      this->histogram_.resize( 1, 0 );
-    }
-    else
-    {
-      size_t hist_size = 0x100;
-      this->histogram_.resize( hist_size, 0 );
-      this->bin_size_ = ( this->max_ - this->min_ ) / static_cast<double>( hist_size - 1 );
-      this->bin_start_ = this->min_ - ( this->bin_size_ * 0.5 );
-    }
+bool Histogram::update( const unsigned short* old_data, const unsigned short* new_data, 
+  size_t size )
+{
+  return this->update_table( old_data, new_data, size );
+}
+
+bool Histogram::update( const int* old_data, const int* new_data, size_t size )
+{
+  return this->update_linear<int, double>( old_data, new_data, size );
+}
 
-    double inv_bin_size = 1.0 / bin_size_;
+bool Histogram::update( const unsigned int* old_data, const unsigned int* new_data, 
+  size_t size )
+{
+  return this->update_linear<unsigned int, double>( old_data, new_data, size );
+}
 
+bool Histogram::update( const long long* old_data, const long long* new_data, size_t size )
+{
+  return this->update_linear<long long, double>( old_data, new_data, size );
+}
 
-    for ( size_t j = 1 ; j < size ; j++ )
-    {
-      double val = data[ j ];
-      if ( Core::IsFinite( val ) )
-      {
-        size_t idx = static_cast<size_t>( ( val - this->min_ ) * inv_bin_size );
-        this->histogram_[ idx ]++;
-      }
-    }
+bool Histogram::update( const unsigned long long* old_data, 
+  const unsigned long long* new_data, size_t size )
+{
+  return this->update_linear<unsigned long long, double>( old_data, new_data, size );
+}
 
-    std::pair< std::vector<size_t>::iterator, std::vector<size_t>::iterator > min_max =
-      boost::minmax_element( this->histogram_.begin(), this->histogram_.end() );
-    this->min_bin_ = (*min_max.first);
-    this->max_bin_ = (*min_max.second);
-  }
-  catch( ... )
-  {
-    this->min_ = Core::Nan();
-    this->max_ = Core::Nan();
-    this->bin_start_ = Core::Nan();
-    this->bin_size_ = Core::Nan();
-    this->histogram_.resize( 0 );
-    return false;
-  }
+bool Histogram::update( const float* old_data, const float* new_data, size_t size )
+{
+  return this->update_linear<float, float>( old_data, new_data, size );
+}
 
-  return true;
+bool Histogram::update( const double* old_data, const double* new_data, size_t size )
+{
+  return this->update_linear<double, double>( old_data, new_data, size );
 }
 
 double Histogram::get_min() const
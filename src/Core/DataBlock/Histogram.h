@@ -30,6 +30,7 @@
 #ifndef CORE_DATABLOCK_HISTOGRAM_H
 #define CORE_DATABLOCK_HISTOGRAM_H
 
+#include <string>
 #include <vector>
 
 namespace Core
@@ -71,6 +72,23 @@ public:
   bool compute( const float* data, size_t size );
   bool compute( const double* data, size_t size );
 
+  // UPDATE:
+  /// Update the histogram after the values in old_data have been overwritten by the values in
+  /// new_data. Only the bins are adjusted, hence this only succeeds if the minimum and maximum of
+  /// the data remain the same. If false is returned the histogram was not altered and it needs
+  /// to be recomputed.
+  bool update( const signed char* old_data, const signed char* new_data, size_t size );
+  bool update( const unsigned char* old_data, const unsigned char* new_data, size_t size );
+  bool update( const short* old_data, const short* new_data, size_t size );
+  bool update( const unsigned short* old_data, const unsigned short* new_data, size_t size );
+  bool update( const int* old_data, const int* new_data, size_t size );
+  bool update( const unsigned int* old_data, const unsigned int* new_data, size_t size );
+  bool update( const long long* old_data, const long long* new_data, size_t size );
+  bool update( const unsigned long long* old_data, const unsigned long long* new_data, 
+    size_t size );
+  bool update( const float* old_data, const float* new_data, size_t size );
+  bool update( const double* old_data, const double* new_data, size_t size );
+
   // GET_MIN:
   /// Get the minimum value of the data
   double get_min() const;
@@ -115,6 +133,32 @@ public:
   /// Check whether histogram is valid
   bool is_valid() const;
 
+private:
+  // Internals shared by all data types. Integer data of 8 or 16 bits is binned through a lookup
+  // table, all other data is binned linearly.
+  template< class T >
+  bool compute_table( const T* data, size_t size );
+  template< class T, class R >
+  bool compute_linear( const T* data, size_t size );
+  template< class T >
+  bool update_table( const T* old_data, const T* new_data, size_t size );
+  template< class T, class R >
+  bool update_linear( const T* old_data, const T* new_data, size_t size );
+  template< class T, class BINNER >
+  bool update_bins( const T* old_data, const T* new_data, size_t size, const BINNER& binner );
+
+  // RESET:
+  /// Invalidate the histogram
+  void reset();
+
+  // SET_BIN_RANGE:
+  /// Set up the layout of the bins for a given minimum, maximum and number of bins
+  void set_bin_range( double min, double max, size_t num_bins );
+
+  // UPDATE_MIN_MAX_BIN:
+  /// Recompute the size of the smallest and largest bin
+  void update_min_max_bin();
+
 private:
   friend std::string ExportToString( const Histogram& value );
   friend bool ImportFromString( const std::string& str, Histogram& value );
@@ -26,6 +26,9 @@
  DEALINGS IN THE SOFTWARE.
  */
 
+// STL includes
+#include <algorithm>
+
 #include <Core/DataBlock/MaskDataBlock.h>
 #include <Core/DataBlock/MaskDataBlockManager.h>
 
@@ -42,6 +45,7 @@ MaskDataBlock::MaskDataBlock( DataBlockHandle data_block, unsigned int mask_bit
   not_mask_value_( ~( 1 << mask_bit ) ) 
 {
   this->data_ = reinterpret_cast<unsigned char*>( this->data_block_->get_data() );
+  this->slice_generation_.resize( this->nz_, this->data_block_->get_generation() );
 }
 
 MaskDataBlock::~MaskDataBlock()
@@ -61,7 +65,28 @@ DataBlock::generation_type MaskDataBlock::get_generation() const
 
 void MaskDataBlock::increase_generation()
 {
-  this->data_block_->increase_generation();
+  // NOTE: The caller holds the write lock, so the generation cannot be read through 
+  // get_generation(), which takes a shared lock.
+  std::fill( this->slice_generation_.begin(), this->slice_generation_.end(), 
+    this->data_block_->increase_generation() );
+}
+
+void MaskDataBlock::increase_generation( SliceType type, size_t index )
+{
+  this->increase_generation( type, index, index );
+}
+
+void MaskDataBlock::increase_generation( SliceType type, size_t min_index, size_t max_index )
+{
+  // Only axial slices are confined to a range of z-slices
+  if ( type != SliceType::AXIAL_E || min_index > max_index || max_index >= this->nz_ )
+  {
+    this->increase_generation();
+    return;
+  }
+
+  std::fill( this->slice_generation_.begin() + min_index, 
+    this->slice_generation_.begin() + max_index + 1, this->data_block_->increase_generation() );
 }
 
 bool MaskDataBlock::extract_slice( SliceType type, 
@@ -369,7 +394,7 @@ bool MaskDataBlock::insert_slice( const MaskDataSliceHandle slice )
       }
 
       // Generate a new generation number for the new volume
-      this->increase_generation();
+      this->increase_generation( slice->get_slice_type(), index );
 
       return true;
     }
@@ -432,7 +457,7 @@ bool MaskDataBlock::insert_slice( const MaskDataSliceHandle slice )
       }
 
       // Generate a new generation number for the new volume
-      this->increase_generation();
+      this->increase_generation( slice->get_slice_type(), index );
 
       return true;
     }
@@ -495,7 +520,7 @@ bool MaskDataBlock::insert_slice( const MaskDataSliceHandle slice )
       }
       
       // Generate a new generation number for the new volume
-      this->increase_generation();
+      this->increase_generation( slice->get_slice_type(), index );
 
       return true;
     }
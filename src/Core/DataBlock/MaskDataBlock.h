@@ -33,6 +33,9 @@
 # pragma once
 #endif 
 
+// STL includes
+#include <vector>
+
 // Boost includes
 #include <boost/utility.hpp>
 #include <boost/smart_ptr.hpp>
@@ -142,6 +145,27 @@ public:
   /// Increase the generation number to a new unique number.
   void increase_generation();
 
+  // INCREASE_GENERATION:
+  /// Increase the generation number to a new unique number and record that only the given
+  /// slice was modified.
+  /// NOTE: This should be called while holding the write lock on the data.
+  void increase_generation( SliceType type, size_t index );
+
+  // INCREASE_GENERATION:
+  /// Increase the generation number to a new unique number and record that only the slices 
+  /// min_index up to and including max_index were modified.
+  /// NOTE: This should be called while holding the write lock on the data.
+  void increase_generation( SliceType type, size_t min_index, size_t max_index );
+
+  // GET_SLICE_GENERATION:
+  /// Get the generation in which the axial slice z was last modified. Consumers that cache
+  /// results derived from the mask can compare this against the generation they were computed
+  /// with to find the z-ranges that need to be updated.
+  DataBlock::generation_type get_slice_generation( size_t z ) const
+  {
+    return this->slice_generation_[ z ];
+  }
+
   // GET_MASK_AT:
   /// Get the mask value at a certain coordinate
   inline bool get_mask_at( size_t x, size_t y, size_t z ) const
@@ -240,6 +264,9 @@ private:
   /// Cached data pointer of the underlying DataBlock
   unsigned char* data_;
 
+  /// Generation in which each axial slice was last modified
+  std::vector< DataBlock::generation_type > slice_generation_;
+
 };
 
 } // end namespace Core
@@ -31,9 +31,13 @@
 #endif
 
 // STL includes
+#include <algorithm>
 #include <bitset>
+#include <map>
+#include <set>
 
 // Boost includes
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 
 // Core includes
@@ -41,6 +45,7 @@
 #include <Core/DataBlock/MaskDataBlockManager.h>
 #include <Core/DataBlock/StdDataBlock.h>
 #include <Core/DataBlock/DataBlockManager.h>
+#include <Core/Utils/ThreadPool.h>
 
 namespace Core
 {
@@ -94,7 +99,8 @@ MaskDataBlockManager::~MaskDataBlockManager()
 {
 }
 
-bool MaskDataBlockManager::create( GridTransform grid_transform, MaskDataBlockHandle& mask )
+bool MaskDataBlockManager::create( GridTransform grid_transform, MaskDataBlockHandle& mask,
+  bool clear_mask )
 {
   lock_type lock( get_mutex() );
 
@@ -142,27 +148,29 @@ bool MaskDataBlockManager::create( GridTransform grid_transform, MaskDataBlockHa
   mask = MaskDataBlockHandle( new MaskDataBlock( data_block, mask_bit ) );
 
   // Clear the mask before using it
-
-  size_t data_size = grid_transform.get_nx() * grid_transform.get_ny() * grid_transform.get_nz();
-  unsigned char* data = mask->get_mask_data();
-  unsigned char not_mask_value = ~( mask->get_mask_value() );
-
-  size_t data_size8 =  RemoveRemainder8( data_size );
-  size_t i = 0;
-  for ( ; i< data_size8; i+=8 )
-  {
-    data[ i ] &= not_mask_value;
-    data[ i+1 ] &= not_mask_value;
-    data[ i+2 ] &= not_mask_value;
-    data[ i+3 ] &= not_mask_value;
-    data[ i+4 ] &= not_mask_value;
-    data[ i+5 ] &= not_mask_value;
-    data[ i+6 ] &= not_mask_value;
-    data[ i+7 ] &= not_mask_value;
-  }
-  for ( ; i< data_size; i++ )
+  if ( clear_mask )
   {
-    data[ i ] &= not_mask_value;
+    size_t data_size = grid_transform.get_nx() * grid_transform.get_ny() * grid_transform.get_nz();
+    unsigned char* data = mask->get_mask_data();
+    unsigned char not_mask_value = ~( mask->get_mask_value() );
+
+    size_t data_size8 =  RemoveRemainder8( data_size );
+    size_t i = 0;
+    for ( ; i< data_size8; i+=8 )
+    {
+      data[ i ] &= not_mask_value;
+      data[ i+1 ] &= not_mask_value;
+      data[ i+2 ] &= not_mask_value;
+      data[ i+3 ] &= not_mask_value;
+      data[ i+4 ] &= not_mask_value;
+      data[ i+5 ] &= not_mask_value;
+      data[ i+6 ] &= not_mask_value;
+      data[ i+7 ] &= not_mask_value;
+    }
+    for ( ; i< data_size; i++ )
+    {
+      data[ i ] &= not_mask_value;
+    }
   }
 
   // Mark the bitplane as being used before returning the mask
@@ -880,6 +888,105 @@ bool MaskDataBlockManager::CreateMaskFromBitPlaneData( const DataBlockHandle& da
   }
 }
 
+namespace
+{
+
+// Number of voxels that are searched for labels by one task
+const size_t LABEL_CHUNK_SIZE_C = 0x100000;
+
+// Number of voxels that are encoded or decoded together. The label indices of a tile stay in
+// the cache, while the bit-planes of all the mask data blocks are merged into them.
+const size_t LABEL_TILE_SIZE_C = 4096;
+
+// Maximum number of masks that is extracted from label data
+const size_t MAX_LABEL_MASKS_C = 32;
+
+// FINDLABELCHUNKS:
+// Find the first max_labels distinct non zero labels of each chunk, in the order in which they
+// occur. A label that is among the first max_labels of the whole data is also among the first 
+// max_labels of the chunk in which it first occurs, so each chunk can stop searching early.
+template< class DATA >
+void FindLabelChunks( const DATA* src, size_t size, size_t max_labels, 
+  std::vector< std::vector< DATA > >& chunk_labels, size_t chunk_begin, size_t chunk_end )
+{
+  const DATA zero_label( 0 );
+  for ( size_t c = chunk_begin; c < chunk_end; c++ )
+  {
+    std::vector< DATA >& labels = chunk_labels[ c ];
+    std::set< DATA > found;
+    DATA last_label( 0 );
+
+    size_t end = std::min( size, ( c + 1 ) * LABEL_CHUNK_SIZE_C );
+    for ( size_t j = c * LABEL_CHUNK_SIZE_C; j < end; j++ )
+    {
+      const DATA label = src[ j ];
+      // NOTE: label != label skips NaN values, which can never be matched
+      if ( label == last_label || label == zero_label || label != label ) continue;
+      last_label = label;
+
+      if ( found.insert( label ).second )
+      {
+        labels.push_back( label );
+        if ( labels.size() == max_labels ) break;
+      }
+    }
+  }
+}
+
+// CLASS LABELPLANE:
+// The new bit-planes that share one mask data block. The bits table has an entry for each mask
+// index plus one, it holds the bit of the mask if it is in this data block and zero otherwise.
+class LabelPlane
+{
+public:
+  unsigned char* data_;
+  unsigned char keep_value_;
+  std::vector< unsigned char > bits_;
+};
+
+template< class DATA >
+void DecodeLabelRange( const DATA* src, const std::map< DATA, int >& label_index, 
+  const std::vector< LabelPlane >& planes, size_t begin, size_t end )
+{
+  int indices[ LABEL_TILE_SIZE_C ];
+  for ( size_t tile = begin; tile < end; tile += LABEL_TILE_SIZE_C )
+  {
+    const size_t tile_size = std::min( LABEL_TILE_SIZE_C, end - tile );
+
+    // Look up the mask index of each voxel, offset by one so voxels without a mask get zero
+    DATA last_label = src[ tile ];
+    typename std::map< DATA, int >::const_iterator it = last_label == last_label ? 
+      label_index.find( last_label ) : label_index.end();
+    int last_index = it == label_index.end() ? 0 : it->second + 1;
+    for ( size_t j = 0; j < tile_size; j++ )
+    {
+      const DATA label = src[ tile + j ];
+      if ( !( label == last_label ) )
+      {
+        // NOTE: NaN values compare as equivalent to any key of the map
+        it = label == label ? label_index.find( label ) : label_index.end();
+        last_label = label;
+        last_index = it == label_index.end() ? 0 : it->second + 1;
+      }
+      indices[ j ] = last_index;
+    }
+
+    // Write all the new bits of each mask data block at once
+    for ( size_t p = 0; p < planes.size(); p++ )
+    {
+      unsigned char* mask_data = planes[ p ].data_ + tile;
+      const unsigned char keep_value = planes[ p ].keep_value_;
+      const unsigned char* bits = &planes[ p ].bits_[ 0 ];
+      for ( size_t j = 0; j < tile_size; j++ )
+      {
+        mask_data[ j ] = ( mask_data[ j ] & keep_value ) | bits[ indices[ j ] ];
+      }
+    }
+  }
+}
+
+} // end anonymous namespace
+
 template< class DATA >
 static bool CreateMaskFromLabelDataInternal( const DataBlockHandle& data,
                       const GridTransform& grid_transform,
@@ -887,56 +994,69 @@ static bool CreateMaskFromLabelDataInternal( const DataBlockHandle& data,
 {
   masks.clear();
 
-  DATA* src   = reinterpret_cast<DATA*>( data->get_data() );
+  const DATA* src   = reinterpret_cast<DATA*>( data->get_data() );
   size_t size = data->get_size();
-  DATA label( 0 );
-  DATA zero_label( 0 );
+  if ( size == 0 ) return true;
 
-  size_t next_label_index = 0;
-  while ( next_label_index < size && masks.size() < 32 )
+  // Find the labels, in the order in which they first occur
+  size_t num_chunks = ( size + LABEL_CHUNK_SIZE_C - 1 ) / LABEL_CHUNK_SIZE_C;
+  std::vector< std::vector< DATA > > chunk_labels( num_chunks );
+  parallel_for( 0, num_chunks, 1, boost::bind( &FindLabelChunks< DATA >, src, size, 
+    MAX_LABEL_MASKS_C, boost::ref( chunk_labels ), _1, _2 ) );
+
+  std::map< DATA, int > label_index;
+  for ( size_t c = 0; c < num_chunks && label_index.size() < MAX_LABEL_MASKS_C; c++ )
   {
-    // find the mask we are looking for
-    while ( next_label_index < size )
+    for ( size_t k = 0; k < chunk_labels[ c ].size() && 
+      label_index.size() < MAX_LABEL_MASKS_C; k++ )
     {
-      if ( src[ next_label_index ] != zero_label ) break;
-      next_label_index++;
+      if ( label_index.count( chunk_labels[ c ][ k ] ) ) continue;
+      int index = static_cast< int >( label_index.size() );
+      label_index[ chunk_labels[ c ][ k ] ] = index;
     }
+  }
+  if ( label_index.empty() ) return true;
 
-    if ( next_label_index < size )
+  // Create the masks, every voxel of the new bit-planes is written below
+  std::vector< LabelPlane > planes;
+  std::map< DataBlock*, size_t > plane_index;
+  masks.resize( label_index.size() );
+  for ( size_t k = 0; k < masks.size(); k++ )
+  {
+    if ( ! ( MaskDataBlockManager::Instance()->create( grid_transform, masks[ k ], false ) ) )
     {
-      MaskDataBlockHandle mask;
-      if ( ! ( MaskDataBlockManager::Instance()->create( grid_transform, mask) ) )
-      {
-        masks.clear();
-        return false;
-      }
-
-      unsigned char* mask_data  = mask->get_mask_data();
-      unsigned char  mask_value = mask->get_mask_value();
-      unsigned char  not_mask_value = ~( mask->get_mask_value() );
-      label = src[ next_label_index ];
+      masks.clear();
+      return false;
+    }
 
-      // Lock the mask layer as it may contain additional masks that are currently in use
-      // Hence we need to have full access
-      MaskDataBlock::lock_type mask_lock( mask->get_mutex() );
+    DataBlock* mask_data_block = masks[ k ]->get_data_block().get();
+    if ( plane_index.find( mask_data_block ) == plane_index.end() )
+    {
+      plane_index[ mask_data_block ] = planes.size();
+      planes.push_back( LabelPlane() );
+      planes.back().data_ = masks[ k ]->get_mask_data();
+      planes.back().keep_value_ = 0xff;
+      planes.back().bits_.assign( masks.size() + 1, 0 );
+    }
 
-      for ( size_t j = next_label_index; j < size; j++ )
-      {
-        if ( src[ j ] == label )
-        {
-          src[ j ] = zero_label;
-          mask_data[ j ] |= mask_value;
-        }
-        else
-        {
-          mask_data[ j ] &= not_mask_value;
-        }
-      }
+    LabelPlane& plane = planes[ plane_index[ mask_data_block ] ];
+    plane.keep_value_ &= ~( masks[ k ]->get_mask_value() );
+    plane.bits_[ k + 1 ] = masks[ k ]->get_mask_value();
+  }
 
-      masks.push_back( mask );
-    }
+  // Lock the mask data blocks as they may contain additional masks that are currently in use
+  // Hence we need to have full access
+  std::vector< boost::shared_ptr< MaskDataBlock::lock_type > > locks;
+  for ( std::map< DataBlock*, size_t >::iterator it = plane_index.begin(); 
+    it != plane_index.end(); ++it )
+  {
+    locks.push_back( boost::shared_ptr< MaskDataBlock::lock_type >( 
+      new MaskDataBlock::lock_type( it->first->get_mutex() ) ) );
   }
 
+  parallel_for( 0, size, 0x40000, boost::bind( &DecodeLabelRange< DATA >, src, 
+    boost::cref( label_index ), boost::cref( planes ), _1, _2 ) );
+
   return true;
 }
 
@@ -1077,4 +1197,137 @@ bool MaskDataBlockManager::Inscribe( MaskDataBlockHandle mask, DataBlockHandle d
   }
 }
 
+namespace
+{
+
+// CLASS MASKPLANE:
+// The masks that share one mask data block. The lookup table maps each byte of the data block
+// onto the highest index of the masks whose bit is set in it, or -1 if none of them is set.
+class MaskPlane
+{
+public:
+  const unsigned char* data_;
+  int lookup_[ 256 ];
+};
+
+template< class T >
+void EncodeLabelRange( const std::vector< MaskPlane >& planes, const std::vector< T >& labels, 
+  T background, T* data, size_t begin, size_t end )
+{
+  int winners[ LABEL_TILE_SIZE_C ];
+  for ( size_t tile = begin; tile < end; tile += LABEL_TILE_SIZE_C )
+  {
+    const size_t tile_size = std::min( LABEL_TILE_SIZE_C, end - tile );
+    std::fill( winners, winners + tile_size, -1 );
+
+    for ( size_t p = 0; p < planes.size(); p++ )
+    {
+      const unsigned char* mask_data = planes[ p ].data_ + tile;
+      const int* lookup = planes[ p ].lookup_;
+      for ( size_t j = 0; j < tile_size; j++ )
+      {
+        winners[ j ] = std::max( winners[ j ], lookup[ mask_data[ j ] ] );
+      }
+    }
+
+    T* dst = data + tile;
+    for ( size_t j = 0; j < tile_size; j++ )
+    {
+      dst[ j ] = winners[ j ] < 0 ? background : labels[ winners[ j ] ];
+    }
+  }
+}
+
+} // end anonymous namespace
+
+template< class T >
+static bool InscribeLabelsInternal( const std::vector< MaskPlane >& planes, 
+  const std::vector< double >& labels, double background, DataBlockHandle data )
+{
+  std::vector< T > typed_labels( labels.size() );
+  for ( size_t k = 0; k < labels.size(); k++ )
+  {
+    typed_labels[ k ] = static_cast< T >( labels[ k ] );
+  }
+
+  parallel_for( 0, data->get_size(), 0x40000, boost::bind( &EncodeLabelRange< T >, 
+    boost::cref( planes ), boost::cref( typed_labels ), static_cast< T >( background ),
+    reinterpret_cast< T* >( data->get_data() ), _1, _2 ) );
+  return true;
+}
+
+bool MaskDataBlockManager::InscribeLabels( const std::vector<MaskDataBlockHandle>& masks,
+  const std::vector<double>& labels, double background, DataBlockHandle data )
+{
+  if ( !data || masks.size() != labels.size() ) return false;
+
+  // Group the masks by the data block that holds their bit-planes
+  std::vector< MaskPlane > planes;
+  std::map< DataBlock*, size_t > plane_index;
+  for ( size_t k = 0; k < masks.size(); k++ )
+  {
+    if ( !masks[ k ] ) return false;
+
+    // Check dimensions and do not continue if dimensions do not match.
+    if ( data->get_nx() != masks[ k ]->get_nx() || data->get_ny() != masks[ k ]->get_ny() ||
+      data->get_nz() != masks[ k ]->get_nz() )
+    {
+      return false;
+    }
+
+    DataBlock* mask_data_block = masks[ k ]->get_data_block().get();
+    if ( plane_index.find( mask_data_block ) == plane_index.end() )
+    {
+      plane_index[ mask_data_block ] = planes.size();
+      planes.push_back( MaskPlane() );
+      planes.back().data_ = masks[ k ]->get_mask_data();
+      std::fill( planes.back().lookup_, planes.back().lookup_ + 256, -1 );
+    }
+
+    // Later masks take precedence, so they overwrite the entries of earlier ones
+    MaskPlane& plane = planes[ plane_index[ mask_data_block ] ];
+    unsigned char mask_value = masks[ k ]->get_mask_value();
+    for ( int byte = 0; byte < 256; byte++ )
+    {
+      if ( byte & mask_value ) plane.lookup_[ byte ] = static_cast< int >( k );
+    }
+  }
+
+  // Lock the masks and the destination
+  std::vector< boost::shared_ptr< MaskDataBlock::shared_lock_type > > locks;
+  for ( std::map< DataBlock*, size_t >::iterator it = plane_index.begin(); 
+    it != plane_index.end(); ++it )
+  {
+    locks.push_back( boost::shared_ptr< MaskDataBlock::shared_lock_type >( 
+      new MaskDataBlock::shared_lock_type( it->first->get_mutex() ) ) );
+  }
+  DataBlock::lock_type lock( data->get_mutex( ) );
+
+  switch( data->get_data_type() )
+  {
+  case DataType::CHAR_E:
+    return InscribeLabelsInternal<signed char>( planes, labels, background, data );
+  case DataType::UCHAR_E:
+    return InscribeLabelsInternal<unsigned char>( planes, labels, background, data );
+  case DataType::SHORT_E:
+    return InscribeLabelsInternal<short>( planes, labels, background, data );
+  case DataType::USHORT_E:
+    return InscribeLabelsInternal<unsigned short>( planes, labels, background, data );
+  case DataType::INT_E:
+    return InscribeLabelsInternal<int>( planes, labels, background, data );
+  case DataType::UINT_E:
+    return InscribeLabelsInternal<unsigned int>( planes, labels, background, data );
+  case DataType::LONGLONG_E:
+    return InscribeLabelsInternal<long long>( planes, labels, background, data );
+  case DataType::ULONGLONG_E:
+    return InscribeLabelsInternal<unsigned long long>( planes, labels, background, data );
+  case DataType::FLOAT_E:
+    return InscribeLabelsInternal<float>( planes, labels, background, data );
+  case DataType::DOUBLE_E:
+    return InscribeLabelsInternal<double>( planes, labels, background, data );
+  default:
+    return false;
+  }
+}
+
 } // end namespace Core
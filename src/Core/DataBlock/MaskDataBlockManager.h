@@ -75,8 +75,9 @@ private:
 public:
 
   // CREATE:
-  /// Create a new mask layer
-  bool create( GridTransform grid_transform, MaskDataBlockHandle& mask );
+  /// Create a new mask layer. If clear_mask is false the bit-plane is handed out as is, the
+  /// caller then needs to write every voxel of the mask.
+  bool create( GridTransform grid_transform, MaskDataBlockHandle& mask, bool clear_mask = true );
 
   // CREATE:
   /// Create a new mask layer with a given generation number and bit
@@ -162,10 +163,19 @@ public:
     const GridTransform& grid_transform, std::vector<MaskDataBlockHandle>& masks );
 
   // CREATEMASKFROMLABELDATA:
-  // Create a mask from each label in integer data
+  /// Create a mask from each label in integer data. The masks follow the order in which the
+  /// labels first occur in the data, zero is background and at most 32 masks are created.
+  /// The data is decoded in a single pass that writes all the new bit-planes at once.
   static bool CreateMaskFromLabelData( const DataBlockHandle& data, 
     const GridTransform& grid_transform, std::vector<MaskDataBlockHandle>& masks );
 
+  // INSCRIBELABELS:
+  /// Write a label map of the masks into a datablock in a single pass over all their bit-planes.
+  /// Voxels that are part of several masks get the label of the last of these masks, voxels that
+  /// are not part of any mask get the background value.
+  static bool InscribeLabels( const std::vector<MaskDataBlockHandle>& masks, 
+    const std::vector<double>& labels, double background, DataBlockHandle data );
+
   // DUPLICATE:
   /// Duplicate a MaskDataBlock into a DataBlock
   static bool Duplicate( MaskDataBlockHandle src_mask_data_block, 
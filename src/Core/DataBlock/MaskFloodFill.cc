@@ -0,0 +1,514 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+
+// Boost includes
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Core includes
+#include <Core/DataBlock/MaskFloodFill.h>
+#include <Core/DataBlock/MaskThreshold.h>
+#include <Core/Utils/ThreadPool.h>
+
+namespace Core
+{
+
+namespace
+{
+
+typedef boost::uint64_t word_type;
+
+// Number of bits in a word
+const size_t WORD_BITS_C = 64;
+
+// Word with all bits set
+const word_type ALL_ONES_C = ~word_type( 0 );
+
+// Minimum number of rows of a wave that a task scans
+const size_t ROW_GRAIN_C = 16;
+
+// Minimum number of spans that a task writes into the mask
+const size_t SPAN_GRAIN_C = 256;
+
+// CLASS SPAN:
+// The voxels x0 up to x1 - 1 of a row, where row is the index y + z * ny of the row.
+class Span
+{
+public:
+  Span() :
+    row_( 0 ),
+    x0_( 0 ),
+    x1_( 0 )
+  {
+  }
+
+  Span( size_t row, size_t x0, size_t x1 ) :
+    row_( row ),
+    x0_( x0 ),
+    x1_( x1 )
+  {
+  }
+
+  bool operator<( const Span& other ) const
+  {
+    return this->row_ < other.row_ || ( this->row_ == other.row_ && this->x0_ < other.x0_ );
+  }
+
+  size_t row_;
+  size_t x0_;
+  size_t x1_;
+};
+
+// FINDSET:
+// Find the first set bit of a row within [ begin, end ), returns end if there is none.
+inline size_t FindSet( const word_type* row, size_t begin, size_t end )
+{
+  size_t x = begin;
+  while ( x < end )
+  {
+    word_type word = row[ x / WORD_BITS_C ] >> ( x % WORD_BITS_C );
+    if ( word == 0 )
+    {
+      x = ( x / WORD_BITS_C + 1 ) * WORD_BITS_C;
+      continue;
+    }
+    while ( !( word & 1 ) )
+    {
+      word >>= 1;
+      x++;
+    }
+    return std::min( x, end );
+  }
+  return end;
+}
+
+// FINDCLEAR:
+// Find the first clear bit of a row of nx bits at or after begin, returns nx if there is none.
+inline size_t FindClear( const word_type* row, size_t begin, size_t nx )
+{
+  size_t x = begin;
+  while ( x < nx )
+  {
+    word_type word = ~row[ x / WORD_BITS_C ] >> ( x % WORD_BITS_C );
+    if ( word == 0 )
+    {
+      x = ( x / WORD_BITS_C + 1 ) * WORD_BITS_C;
+      continue;
+    }
+    while ( !( word & 1 ) )
+    {
+      word >>= 1;
+      x++;
+    }
+    return std::min( x, nx );
+  }
+  return nx;
+}
+
+// FINDRUNSTART:
+// Find the first bit of the run of set bits of a row that contains bit x.
+inline size_t FindRunStart( const word_type* row, size_t x )
+{
+  while ( x > 0 )
+  {
+    size_t w = ( x - 1 ) / WORD_BITS_C;
+    size_t bit = ( x - 1 ) % WORD_BITS_C;
+    if ( bit == WORD_BITS_C - 1 && row[ w ] == ALL_ONES_C )
+    {
+      x -= WORD_BITS_C;
+      continue;
+    }
+    if ( !( ( row[ w ] >> bit ) & 1 ) ) return x;
+    x--;
+  }
+  return 0;
+}
+
+// CLEARBITS:
+// Clear the bits x0 up to x1 - 1 of a row.
+inline void ClearBits( word_type* row, size_t x0, size_t x1 )
+{
+  size_t x = x0;
+  while ( x < x1 )
+  {
+    size_t bit = x % WORD_BITS_C;
+    size_t count = std::min( WORD_BITS_C - bit, x1 - x );
+    word_type bits = ( count == WORD_BITS_C ) ? ALL_ONES_C : 
+      ( ( word_type( 1 ) << count ) - 1 ) << bit;
+    row[ x / WORD_BITS_C ] &= ~bits;
+    x += count;
+  }
+}
+
+} // end anonymous namespace
+
+class MaskFloodFillPrivate
+{
+public:
+  // BUILD_SLICES:
+  // Mark the voxels of the axial slices begin up to end - 1 that meet the constraints and do
+  // not have the fill value yet as open.
+  void build_slices( size_t begin, size_t end );
+
+  // SCAN_ROWS:
+  // Fill the open voxels that are reached by the candidates of the rows groups_[ begin ] up to
+  // groups_[ end ] - 1 of the current wave, and add the neighboring rows to the next wave.
+  void scan_rows( size_t begin, size_t end );
+
+  // WRITE_SPANS:
+  // Write the spans begin up to end - 1 into the mask.
+  void write_spans( size_t begin, size_t end );
+
+  MaskDataBlockHandle mask_;
+  bool erase_;
+
+  DataBlockHandle data_cstr_;
+  double min_val_;
+  double max_val_;
+  bool negative_data_cstr_;
+
+  std::vector< MaskDataBlockHandle > mask_cstrs_;
+  std::vector< bool > negative_mask_cstrs_;
+
+  size_t nx_;
+  size_t ny_;
+  size_t nz_;
+  size_t row_words_;
+
+  // One bit per voxel that can be filled and has not been reached yet. Each row is padded to a 
+  // whole number of words, so rows never share a word.
+  std::vector< word_type > open_;
+
+  // The candidate spans of the current wave sorted by row, and the index of the first candidate
+  // of each row followed by the number of candidates
+  std::vector< Span > wave_;
+  std::vector< size_t > groups_;
+
+  // Protects next_wave_ and spans_
+  boost::mutex mutex_;
+  std::vector< Span > next_wave_;
+  std::vector< Span > spans_;
+
+  size_t count_;
+  size_t min_z_;
+  size_t max_z_;
+};
+
+void MaskFloodFillPrivate::build_slices( size_t begin, size_t end )
+{
+  const size_t nx = this->nx_;
+  const size_t ny = this->ny_;
+  const size_t slice_size = nx * ny;
+  const unsigned char mask_value = this->mask_->get_mask_value();
+  const unsigned char fill_value = this->erase_ ? 0 : mask_value;
+  std::vector< unsigned char > buffer( slice_size );
+
+  for ( size_t z = begin; z < end; z++ )
+  {
+    const size_t start = z * slice_size;
+    if ( this->data_cstr_ )
+    {
+      MaskThreshold::ThresholdSlice( this->data_cstr_.get(), start, 1, nx, nx, ny, 
+        this->min_val_, this->max_val_, this->negative_data_cstr_, &buffer[ 0 ] );
+    }
+    else
+    {
+      std::fill( buffer.begin(), buffer.end(), 1 );
+    }
+
+    for ( size_t k = 0; k < this->mask_cstrs_.size(); k++ )
+    {
+      const unsigned char* cstr = this->mask_cstrs_[ k ]->get_mask_data() + start;
+      const unsigned char cstr_value = this->mask_cstrs_[ k ]->get_mask_value();
+      const bool negative = this->negative_mask_cstrs_[ k ];
+      for ( size_t j = 0; j < slice_size; j++ )
+      {
+        buffer[ j ] &= static_cast< unsigned char >( ( ( cstr[ j ] & cstr_value ) != 0 ) != negative );
+      }
+    }
+
+    // Like the 2D flood fill, voxels that already have the fill value stop the fill
+    const unsigned char* target = this->mask_->get_mask_data() + start;
+    for ( size_t j = 0; j < slice_size; j++ )
+    {
+      buffer[ j ] &= static_cast< unsigned char >( ( target[ j ] & mask_value ) != fill_value );
+    }
+
+    for ( size_t y = 0; y < ny; y++ )
+    {
+      const unsigned char* flags = &buffer[ y * nx ];
+      word_type* row = &this->open_[ ( z * ny + y ) * this->row_words_ ];
+      for ( size_t w = 0; w < this->row_words_; w++ )
+      {
+        const size_t x0 = w * WORD_BITS_C;
+        const size_t count = std::min( WORD_BITS_C, nx - x0 );
+        word_type word = 0;
+        for ( size_t b = 0; b < count; b++ )
+        {
+          word |= static_cast< word_type >( flags[ x0 + b ] ) << b;
+        }
+        row[ w ] = word;
+      }
+    }
+  }
+}
+
+void MaskFloodFillPrivate::scan_rows( size_t begin, size_t end )
+{
+  const size_t nx = this->nx_;
+  const size_t ny = this->ny_;
+  const size_t nz = this->nz_;
+  std::vector< Span > spans;
+  std::vector< Span > next_wave;
+
+  for ( size_t g = begin; g < end; g++ )
+  {
+    const size_t row = this->wave_[ this->groups_[ g ] ].row_;
+    const size_t y = row % ny;
+    const size_t z = row / ny;
+
+    // Each row occurs in one group only, hence no other task touches its bits in this wave
+    word_type* bits = &this->open_[ row * this->row_words_ ];
+    for ( size_t c = this->groups_[ g ]; c < this->groups_[ g + 1 ]; c++ )
+    {
+      const size_t x1 = this->wave_[ c ].x1_;
+      size_t x = FindSet( bits, this->wave_[ c ].x0_, x1 );
+      while ( x < x1 )
+      {
+        // Grow the span over all open voxels around the one that was reached
+        const size_t span_start = FindRunStart( bits, x );
+        const size_t span_end = FindClear( bits, x, nx );
+        ClearBits( bits, span_start, span_end );
+        spans.push_back( Span( row, span_start, span_end ) );
+
+        if ( y > 0 ) next_wave.push_back( Span( row - 1, span_start, span_end ) );
+        if ( y + 1 < ny ) next_wave.push_back( Span( row + 1, span_start, span_end ) );
+        if ( z > 0 ) next_wave.push_back( Span( row - ny, span_start, span_end ) );
+        if ( z + 1 < nz ) next_wave.push_back( Span( row + ny, span_start, span_end ) );
+
+        x = FindSet( bits, span_end, x1 );
+      }
+    }
+  }
+
+  boost::mutex::scoped_lock lock( this->mutex_ );
+  this->spans_.insert( this->spans_.end(), spans.begin(), spans.end() );
+  this->next_wave_.insert( this->next_wave_.end(), next_wave.begin(), next_wave.end() );
+}
+
+void MaskFloodFillPrivate::write_spans( size_t begin, size_t end )
+{
+  unsigned char* data = this->mask_->get_mask_data();
+  const unsigned char mask_value = this->mask_->get_mask_value();
+  const unsigned char keep_value = static_cast< unsigned char >( ~mask_value );
+
+  for ( size_t j = begin; j < end; j++ )
+  {
+    const Span& span = this->spans_[ j ];
+    unsigned char* row = data + span.row_ * this->nx_;
+    if ( this->erase_ )
+    {
+      for ( size_t x = span.x0_; x < span.x1_; x++ ) row[ x ] &= keep_value;
+    }
+    else
+    {
+      for ( size_t x = span.x0_; x < span.x1_; x++ ) row[ x ] |= mask_value;
+    }
+  }
+}
+
+MaskFloodFill::MaskFloodFill( const MaskDataBlockHandle& mask, bool erase ) :
+  private_( new MaskFloodFillPrivate )
+{
+  this->private_->mask_ = mask;
+  this->private_->erase_ = erase;
+  this->private_->min_val_ = 0.0;
+  this->private_->max_val_ = 0.0;
+  this->private_->negative_data_cstr_ = false;
+  this->private_->nx_ = mask->get_nx();
+  this->private_->ny_ = mask->get_ny();
+  this->private_->nz_ = mask->get_nz();
+  this->private_->row_words_ = ( this->private_->nx_ + WORD_BITS_C - 1 ) / WORD_BITS_C;
+  this->private_->count_ = 0;
+  this->private_->min_z_ = 0;
+  this->private_->max_z_ = 0;
+}
+
+MaskFloodFill::~MaskFloodFill()
+{
+}
+
+void MaskFloodFill::set_data_constraint( const DataBlockHandle& data, double min_val, 
+  double max_val, bool negative )
+{
+  this->private_->data_cstr_ = data;
+  this->private_->min_val_ = min_val;
+  this->private_->max_val_ = max_val;
+  this->private_->negative_data_cstr_ = negative;
+}
+
+void MaskFloodFill::add_mask_constraint( const MaskDataBlockHandle& mask, bool negative )
+{
+  this->private_->mask_cstrs_.push_back( mask );
+  this->private_->negative_mask_cstrs_.push_back( negative );
+}
+
+bool MaskFloodFill::compute( const std::vector< IndexVector >& seeds, 
+  abort_function_type abort )
+{
+  MaskFloodFillPrivate* priv = this->private_.get();
+  priv->spans_.clear();
+  priv->count_ = 0;
+
+  const size_t nx = priv->nx_;
+  const size_t ny = priv->ny_;
+  const size_t nz = priv->nz_;
+
+  // Masks of the same group share a data block, so lock each mutex only once
+  std::vector< DataBlock::mutex_type* > mutexes( 1, &priv->mask_->get_mutex() );
+  if ( priv->data_cstr_ ) mutexes.push_back( &priv->data_cstr_->get_mutex() );
+  for ( size_t k = 0; k < priv->mask_cstrs_.size(); k++ )
+  {
+    mutexes.push_back( &priv->mask_cstrs_[ k ]->get_mutex() );
+  }
+  std::sort( mutexes.begin(), mutexes.end() );
+  mutexes.erase( std::unique( mutexes.begin(), mutexes.end() ), mutexes.end() );
+
+  std::vector< boost::shared_ptr< DataBlock::shared_lock_type > > locks;
+  for ( size_t k = 0; k < mutexes.size(); k++ )
+  {
+    locks.push_back( boost::shared_ptr< DataBlock::shared_lock_type >( 
+      new DataBlock::shared_lock_type( *mutexes[ k ] ) ) );
+  }
+
+  priv->open_.resize( priv->row_words_ * ny * nz );
+  bool completed = parallel_for( 0, nz, 1, boost::bind( &MaskFloodFillPrivate::build_slices, 
+    priv, _1, _2 ), abort );
+
+  priv->wave_.clear();
+  for ( size_t j = 0; j < seeds.size(); j++ )
+  {
+    const IndexVector& seed = seeds[ j ];
+    if ( seed.x() < 0 || seed.y() < 0 || seed.z() < 0 || 
+      seed.x() >= static_cast< IndexVector::index_type >( nx ) ||
+      seed.y() >= static_cast< IndexVector::index_type >( ny ) ||
+      seed.z() >= static_cast< IndexVector::index_type >( nz ) ) continue;
+
+    size_t x = static_cast< size_t >( seed.x() );
+    priv->wave_.push_back( Span( static_cast< size_t >( seed.z() ) * ny + 
+      static_cast< size_t >( seed.y() ), x, x + 1 ) );
+  }
+
+  // Each wave fills the spans reached from the spans filled by the previous one
+  while ( completed && !priv->wave_.empty() )
+  {
+    if ( abort && abort() )
+    {
+      completed = false;
+      break;
+    }
+
+    std::sort( priv->wave_.begin(), priv->wave_.end() );
+    priv->groups_.clear();
+    for ( size_t j = 0; j < priv->wave_.size(); j++ )
+    {
+      if ( j == 0 || priv->wave_[ j ].row_ != priv->wave_[ j - 1 ].row_ ) 
+      {
+        priv->groups_.push_back( j );
+      }
+    }
+    priv->groups_.push_back( priv->wave_.size() );
+
+    priv->next_wave_.clear();
+    parallel_for( 0, priv->groups_.size() - 1, ROW_GRAIN_C, 
+      boost::bind( &MaskFloodFillPrivate::scan_rows, priv, _1, _2 ) );
+    priv->wave_.swap( priv->next_wave_ );
+  }
+
+  std::vector< word_type >().swap( priv->open_ );
+  std::vector< Span >().swap( priv->wave_ );
+  std::vector< Span >().swap( priv->next_wave_ );
+
+  if ( !completed )
+  {
+    priv->spans_.clear();
+    return false;
+  }
+
+  for ( size_t j = 0; j < priv->spans_.size(); j++ )
+  {
+    const size_t z = priv->spans_[ j ].row_ / ny;
+    if ( j == 0 )
+    {
+      priv->min_z_ = z;
+      priv->max_z_ = z;
+    }
+    else
+    {
+      priv->min_z_ = std::min( priv->min_z_, z );
+      priv->max_z_ = std::max( priv->max_z_, z );
+    }
+    priv->count_ += priv->spans_[ j ].x1_ - priv->spans_[ j ].x0_;
+  }
+
+  return true;
+}
+
+size_t MaskFloodFill::get_count() const
+{
+  return this->private_->count_;
+}
+
+bool MaskFloodFill::get_z_range( size_t& min_z, size_t& max_z ) const
+{
+  if ( this->private_->spans_.empty() ) return false;
+  min_z = this->private_->min_z_;
+  max_z = this->private_->max_z_;
+  return true;
+}
+
+void MaskFloodFill::apply()
+{
+  MaskFloodFillPrivate* priv = this->private_.get();
+  if ( priv->spans_.empty() ) return;
+
+  {
+    MaskDataBlock::lock_type lock( priv->mask_->get_mutex() );
+    parallel_for( 0, priv->spans_.size(), SPAN_GRAIN_C, 
+      boost::bind( &MaskFloodFillPrivate::write_spans, priv, _1, _2 ) );
+    priv->mask_->increase_generation( SliceType::AXIAL_E, priv->min_z_, priv->max_z_ );
+  }
+
+  priv->mask_->mask_updated_signal_();
+}
+
+} // end namespace Core
@@ -0,0 +1,120 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORE_DATABLOCK_MASKFLOODFILL_H
+#define CORE_DATABLOCK_MASKFLOODFILL_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif 
+
+// STL includes
+#include <vector>
+
+// Boost includes
+#include <boost/function.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/utility.hpp>
+
+// Core includes
+#include <Core/DataBlock/DataBlock.h>
+#include <Core/DataBlock/MaskDataBlock.h>
+#include <Core/Geometry/IndexVector.h>
+
+namespace Core
+{
+
+class MaskFloodFill;
+class MaskFloodFillPrivate;
+typedef boost::shared_ptr< MaskFloodFill > MaskFloodFillHandle;
+typedef boost::shared_ptr< MaskFloodFillPrivate > MaskFloodFillPrivateHandle;
+
+// CLASS MASKFLOODFILL:
+/// 3D flood fill of a mask through the faces of the voxels. The fill is found first, so the 
+/// caller can make a check point of the slices that will change, and is then written straight
+/// into the bit-plane of the mask. The fill advances in waves of spans along the x-axis, the
+/// rows of each wave are scanned in parallel on the ThreadPool.
+
+class MaskFloodFill : public boost::noncopyable
+{
+  // -- types --
+public:
+  typedef boost::function< bool () > abort_function_type;
+
+  // -- constructor/destructor --
+public:
+  // If erase is set the fill clears the voxels of the mask instead of setting them
+  MaskFloodFill( const MaskDataBlockHandle& mask, bool erase = false );
+  virtual ~MaskFloodFill();
+
+  // -- constraints --
+public:
+  // SET_DATA_CONSTRAINT:
+  /// Only fill voxels of which the data value is within [ min_val, max_val ], or outside of it
+  /// if negative is set. The data needs to have the same size as the mask.
+  void set_data_constraint( const DataBlockHandle& data, double min_val, double max_val, 
+    bool negative );
+
+  // ADD_MASK_CONSTRAINT:
+  /// Only fill voxels inside the constraint mask, or outside of it if negative is set. The mask
+  /// needs to have the same size as the mask that is filled.
+  void add_mask_constraint( const MaskDataBlockHandle& mask, bool negative );
+
+  // -- fill --
+public:
+  // COMPUTE:
+  /// Find the voxels that are connected to the seeds and meet the constraints. Like the 2D flood 
+  /// fill, the fill stops at voxels that already have the fill value, and a seed that does not
+  /// meet the constraints does not fill anything. Seeds outside of the mask are ignored. Returns
+  /// false if the abort function returned true.
+  /// NOTE: This function takes shared locks on the mask and the constraints.
+  bool compute( const std::vector< IndexVector >& seeds, 
+    abort_function_type abort = abort_function_type() );
+
+  // GET_COUNT:
+  /// Get the number of voxels that the fill changes.
+  size_t get_count() const;
+
+  // GET_Z_RANGE:
+  /// Get the first and last axial slice that the fill changes. Returns false if the fill does
+  /// not change anything.
+  bool get_z_range( size_t& min_z, size_t& max_z ) const;
+
+  // APPLY:
+  /// Write the computed fill into the mask, update the generation of the modified slices and
+  /// trigger the mask_updated_signal_ of the mask.
+  /// NOTE: This function takes a write lock on the mask.
+  void apply();
+
+private:
+  MaskFloodFillPrivateHandle private_;
+};
+
+} // end namespace Core
+
+#endif
@@ -0,0 +1,786 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Boost includes
+#include <boost/bind.hpp>
+
+// Core includes
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/MaskMorphology.h>
+#include <Core/Utils/ThreadPool.h>
+
+namespace Core
+{
+
+namespace
+{
+
+// Distances along a row are clamped at this value, which is larger than any supported radius
+const unsigned char FAR_C = 255;
+const int MAX_RADIUS_C = 254;
+
+// Squared distances that are too large to matter
+const int INFINITE_C = std::numeric_limits< int >::max();
+
+// Labels used when growing or shrinking in steps. The front of the propagation alternates
+// between the two front labels, so the new front can be told apart from the current one.
+const unsigned char UNREACHED_C = 0;
+const unsigned char REACHED_C = 1;
+const unsigned char FRONT_A_C = 2;
+const unsigned char FRONT_B_C = 3;
+const unsigned char BLOCKED_C = 4;
+
+// Number of planes of constant x that are transformed together, which keeps the reads and 
+// writes of the plane pass within cache lines
+const size_t TILE_SIZE_C = 16;
+
+// Number of times progress is reported during the plane pass
+const size_t NUM_BATCHES_C = 10;
+
+// Neighbors in the direction of the row ( -1, 0, +1 ) that need to be checked in a neighboring
+// row when propagating in steps
+const int LEFT_C = 0x1;
+const int CENTER_C = 0x2;
+const int RIGHT_C = 0x4;
+
+// DISTANCETRANSFORM1D:
+// Compute d[ q ] = min_p( f[ p ] + ( q - p )^2 ) for n samples of f that are stride apart,
+// using the lower envelope algorithm of Felzenszwalb and Huttenlocher. Samples that are 
+// INFINITE_C do not contribute, results that are larger than limit are set to INFINITE_C.
+// Returns false if all results are INFINITE_C.
+bool DistanceTransform1D( const int* f, size_t stride, int n, int limit, int* d, int* v, 
+  double* z )
+{
+  int k = -1;
+  for ( int q = 0; q < n; q++ )
+  {
+    int fq = f[ q * stride ];
+    if ( fq == INFINITE_C ) continue;
+
+    if ( k < 0 )
+    {
+      k = 0;
+      v[ 0 ] = q;
+      z[ 0 ] = -std::numeric_limits< double >::infinity();
+      continue;
+    }
+
+    // Remove the parabolas that are hidden by the new one, the first one cannot be removed as 
+    // its range starts at minus infinity
+    double s;
+    double fq_q2 = static_cast< double >( fq ) + static_cast< double >( q ) * q;
+    while ( true )
+    {
+      int p = v[ k ];
+      s = ( fq_q2 - ( static_cast< double >( f[ p * stride ] ) + 
+        static_cast< double >( p ) * p ) ) / ( 2.0 * ( q - p ) );
+      if ( s > z[ k ] ) break;
+      k--;
+    }
+
+    k++;
+    v[ k ] = q;
+    z[ k ] = s;
+  }
+
+  if ( k < 0 )
+  {
+    for ( int q = 0; q < n; q++ ) d[ q * stride ] = INFINITE_C;
+    return false;
+  }
+
+  bool found = false;
+  int j = 0;
+  for ( int q = 0; q < n; q++ )
+  {
+    while ( j < k && z[ j + 1 ] < q ) j++;
+    int dq = q - v[ j ];
+    long long value = static_cast< long long >( f[ v[ j ] * stride ] ) + 
+      static_cast< long long >( dq ) * dq;
+    if ( value > limit )
+    {
+      d[ q * stride ] = INFINITE_C;
+    }
+    else
+    {
+      d[ q * stride ] = static_cast< int >( value );
+      found = true;
+    }
+  }
+  return found;
+}
+
+} // end anonymous namespace
+
+class MaskMorphologyPrivate
+{
+public:
+  MaskMorphologyPrivate() :
+    nx_( 0 ),
+    ny_( 0 ),
+    nz_( 0 ),
+    constraint_data_( 0 ),
+    constraint_value_( 0 ),
+    invert_constraint_( false ),
+    use_x_( true ),
+    use_y_( true ),
+    use_z_( true ),
+    only2d_( false ),
+    slice_type_( SliceType::AXIAL_E ),
+    dilate_( true ),
+    squared_radius_( 0 ),
+    phase_( 0 ),
+    front_( FRONT_A_C ),
+    next_( FRONT_B_C )
+  {
+  }
+
+  // IS_ALLOWED:
+  // Whether the voxel may be changed
+  inline bool is_allowed( size_t index ) const
+  {
+    if ( this->constraint_data_ == 0 ) return true;
+    return ( ( this->constraint_data_[ index ] & this->constraint_value_ ) != 0 ) != 
+      this->invert_constraint_;
+  }
+
+  // Copy the bit-plane of the input into the labels
+  void load_input( unsigned char* mask_data, unsigned char mask_value, size_t begin, 
+    size_t end );
+
+  // Write the labels into the bit-plane of the output
+  void save_output( unsigned char* mask_data, unsigned char mask_value, size_t begin, 
+    size_t end );
+
+  // -- distance transform --
+
+  // Dilate or erode with a ball that contains all voxels up to a squared distance
+  bool transform( bool dilate, int squared_radius );
+
+  // Replace the labels of rows [ begin, end ) with the distance along the row to the nearest 
+  // voxel of the set that is being grown
+  void row_pass( size_t begin, size_t end );
+
+  // Compute the distance transform in planes of constant x and threshold it, for the tiles 
+  // [ begin, end )
+  void plane_pass( size_t begin, size_t end );
+
+  // -- propagation in steps --
+
+  // Grow the mask or the outside of the mask a number of steps
+  bool propagate( bool dilate, int steps );
+
+  // Label the sources, passable and blocked voxels for slices [ begin, end )
+  void initialize_propagation( size_t begin, size_t end );
+
+  // Propagate the front by one step for every other slice, starting at the slice given by the 
+  // phase
+  void propagate_slices( size_t begin, size_t end );
+
+  // Convert the propagation labels back into a mask for slices [ begin, end )
+  void finish_propagation( size_t begin, size_t end );
+
+  void update_progress( double amount );
+
+  bool check_abort();
+
+  // Dimensions of the volume
+  size_t nx_;
+  size_t ny_;
+  size_t nz_;
+
+  // State of each voxel, one byte per voxel
+  std::vector< unsigned char > labels_;
+
+  // Constraint on which voxels can change
+  MaskDataBlockHandle constraint_;
+  unsigned char* constraint_data_;
+  unsigned char constraint_value_;
+  bool invert_constraint_;
+
+  // Which directions the structuring elements extend in
+  bool use_x_;
+  bool use_y_;
+  bool use_z_;
+  bool only2d_;
+  SliceType slice_type_;
+
+  MaskMorphology::abort_function_type abort_;
+  MaskMorphology::progress_function_type progress_;
+
+  // State of the current operation
+  bool dilate_;
+  int squared_radius_;
+  int phase_;
+  unsigned char front_;
+  unsigned char next_;
+  std::vector< char > has_label_[ 2 ];
+  std::vector< char > slice_changed_;
+};
+
+void MaskMorphologyPrivate::load_input( unsigned char* mask_data, unsigned char mask_value, 
+  size_t begin, size_t end )
+{
+  unsigned char* labels = &this->labels_[ 0 ];
+  for ( size_t j = begin; j < end; j++ )
+  {
+    labels[ j ] = ( mask_data[ j ] & mask_value ) ? 1 : 0;
+  }
+}
+
+void MaskMorphologyPrivate::save_output( unsigned char* mask_data, unsigned char mask_value, 
+  size_t begin, size_t end )
+{
+  const unsigned char* labels = &this->labels_[ 0 ];
+  unsigned char not_mask_value = ~mask_value;
+  for ( size_t j = begin; j < end; j++ )
+  {
+    if ( labels[ j ] ) mask_data[ j ] |= mask_value;
+    else mask_data[ j ] &= not_mask_value;
+  }
+}
+
+void MaskMorphologyPrivate::update_progress( double amount )
+{
+  if ( this->progress_ ) this->progress_( amount );
+}
+
+bool MaskMorphologyPrivate::check_abort()
+{
+  return this->abort_ && this->abort_();
+}
+
+void MaskMorphologyPrivate::row_pass( size_t begin, size_t end )
+{
+  size_t nx = this->nx_;
+  // When dilating the distance to the mask is needed, when eroding the distance to the outside
+  unsigned char member = this->dilate_ ? 1 : 0;
+
+  for ( size_t r = begin; r < end; r++ )
+  {
+    unsigned char* row = &this->labels_[ r * nx ];
+
+    if ( !this->use_x_ )
+    {
+      for ( size_t x = 0; x < nx; x++ )
+      {
+        row[ x ] = ( row[ x ] == member ) ? 0 : FAR_C;
+      }
+      continue;
+    }
+
+    // Skip rows that do not contain the set at all
+    if ( std::find( row, row + nx, member ) == row + nx )
+    {
+      std::fill( row, row + nx, FAR_C );
+      continue;
+    }
+
+    // Forward sweep, voxels of the set get distance zero
+    unsigned char dist = FAR_C;
+    for ( size_t x = 0; x < nx; x++ )
+    {
+      if ( row[ x ] == member ) dist = 0;
+      else if ( dist < FAR_C ) dist++;
+      row[ x ] = dist;
+    }
+
+    // Backward sweep
+    dist = FAR_C;
+    for ( size_t x = nx; x-- > 0; )
+    {
+      if ( row[ x ] == 0 ) dist = 0;
+      else if ( dist < FAR_C ) dist++;
+      if ( dist < row[ x ] ) row[ x ] = dist;
+    }
+  }
+}
+
+void MaskMorphologyPrivate::plane_pass( size_t begin, size_t end )
+{
+  size_t nx = this->nx_;
+  size_t ny = this->ny_;
+  size_t nz = this->nz_;
+  size_t nxy = nx * ny;
+  size_t nyz = ny * nz;
+  size_t n = std::max( ny, nz );
+  int limit = this->squared_radius_;
+
+  std::vector< unsigned char > tile( TILE_SIZE_C * nyz );
+  std::vector< int > f( nyz );
+  std::vector< int > g( nyz );
+  std::vector< int > h( nyz );
+  std::vector< int > column( nz );
+  std::vector< int > v( n );
+  std::vector< double > z( n + 1 );
+  std::vector< char > tile_empty( TILE_SIZE_C );
+
+  for ( size_t t = begin; t < end; t++ )
+  {
+    size_t x0 = t * TILE_SIZE_C;
+    size_t tile_size = std::min( TILE_SIZE_C, nx - x0 );
+
+    // Gather the distances along x for the planes of this tile
+    std::fill( tile_empty.begin(), tile_empty.end(), 1 );
+    for ( size_t yz = 0; yz < nyz; yz++ )
+    {
+      const unsigned char* src = &this->labels_[ yz * nx + x0 ];
+      for ( size_t i = 0; i < tile_size; i++ )
+      {
+        tile[ i * nyz + yz ] = src[ i ];
+        if ( src[ i ] != FAR_C ) tile_empty[ i ] = 0;
+      }
+    }
+
+    for ( size_t i = 0; i < tile_size; i++ )
+    {
+      const unsigned char* dist = &tile[ i * nyz ];
+      size_t x = x0 + i;
+
+      // Nothing is within reach of this plane
+      bool near_any = false;
+      if ( !tile_empty[ i ] )
+      {
+        for ( size_t yz = 0; yz < nyz; yz++ )
+        {
+          f[ yz ] = ( dist[ yz ] == FAR_C ) ? INFINITE_C : 
+            static_cast< int >( dist[ yz ] ) * dist[ yz ];
+        }
+
+        // Transform along y
+        if ( this->use_y_ )
+        {
+          for ( size_t zz = 0; zz < nz; zz++ )
+          {
+            if ( DistanceTransform1D( &f[ zz * ny ], 1, static_cast< int >( ny ), limit, 
+              &g[ zz * ny ], &v[ 0 ], &z[ 0 ] ) ) near_any = true;
+          }
+        }
+        else
+        {
+          for ( size_t yz = 0; yz < nyz; yz++ )
+          {
+            g[ yz ] = f[ yz ] > limit ? INFINITE_C : f[ yz ];
+            if ( g[ yz ] != INFINITE_C ) near_any = true;
+          }
+        }
+      }
+
+      // Transform along z and write the result
+      for ( size_t y = 0; y < ny; y++ )
+      {
+        bool near_column = false;
+        if ( near_any )
+        {
+          if ( this->use_z_ )
+          {
+            near_column = DistanceTransform1D( &g[ y ], ny, static_cast< int >( nz ), limit, 
+              &h[ y ], &v[ 0 ], &z[ 0 ] );
+            for ( size_t zz = 0; zz < nz; zz++ ) column[ zz ] = h[ zz * ny + y ];
+          }
+          else
+          {
+            for ( size_t zz = 0; zz < nz; zz++ )
+            {
+              column[ zz ] = g[ zz * ny + y ];
+              if ( column[ zz ] != INFINITE_C ) near_column = true;
+            }
+          }
+        }
+
+        for ( size_t zz = 0; zz < nz; zz++ )
+        {
+          size_t index = zz * nxy + y * nx + x;
+          bool in_set = dist[ zz * ny + y ] == 0;
+          bool reached = near_column && column[ zz ] != INFINITE_C && this->is_allowed( index );
+          if ( this->dilate_ )
+          {
+            this->labels_[ index ] = ( in_set || reached ) ? 1 : 0;
+          }
+          else
+          {
+            this->labels_[ index ] = ( !in_set && !reached ) ? 1 : 0;
+          }
+        }
+      }
+    }
+  }
+}
+
+bool MaskMorphologyPrivate::transform( bool dilate, int squared_radius )
+{
+  this->dilate_ = dilate;
+  this->squared_radius_ = squared_radius;
+
+  size_t num_rows = this->ny_ * this->nz_;
+  if ( !parallel_for( 0, num_rows, std::max( size_t( 1 ), size_t( 0x10000 ) / this->nx_ ), 
+    boost::bind( &MaskMorphologyPrivate::row_pass, this, _1, _2 ), this->abort_ ) )
+  {
+    return false;
+  }
+  this->update_progress( 0.1 );
+
+  size_t num_tiles = ( this->nx_ + TILE_SIZE_C - 1 ) / TILE_SIZE_C;
+  for ( size_t b = 0; b < NUM_BATCHES_C; b++ )
+  {
+    size_t begin = num_tiles * b / NUM_BATCHES_C;
+    size_t end = num_tiles * ( b + 1 ) / NUM_BATCHES_C;
+    if ( begin == end ) continue;
+
+    if ( !parallel_for( begin, end, 1, 
+      boost::bind( &MaskMorphologyPrivate::plane_pass, this, _1, _2 ), this->abort_ ) )
+    {
+      return false;
+    }
+    this->update_progress( 0.1 + 0.9 * static_cast< double >( b + 1 ) / NUM_BATCHES_C );
+  }
+
+  return true;
+}
+
+void MaskMorphologyPrivate::initialize_propagation( size_t begin, size_t end )
+{
+  size_t nx = this->nx_;
+  size_t ny = this->ny_;
+  // Dilation grows from the mask, erosion grows from the outside of the mask
+  unsigned char source = this->dilate_ ? 1 : 0;
+
+  for ( size_t r = begin * ny; r < end * ny; r++ )
+  {
+    unsigned char* row = &this->labels_[ r * nx ];
+    bool has_front = false;
+    for ( size_t x = 0; x < nx; x++ )
+    {
+      if ( row[ x ] == source )
+      {
+        row[ x ] = FRONT_A_C;
+        has_front = true;
+      }
+      else
+      {
+        row[ x ] = this->is_allowed( r * nx + x ) ? UNREACHED_C : BLOCKED_C;
+      }
+    }
+    this->has_label_[ 0 ][ r ] = has_front;
+    this->has_label_[ 1 ][ r ] = false;
+  }
+}
+
+void MaskMorphologyPrivate::propagate_slices( size_t begin, size_t end )
+{
+  int nx = static_cast< int >( this->nx_ );
+  int ny = static_cast< int >( this->ny_ );
+  int nz = static_cast< int >( this->nz_ );
+  unsigned char front = this->front_;
+  unsigned char next = this->next_;
+  const std::vector< char >& front_rows = this->has_label_[ front == FRONT_A_C ? 0 : 1 ];
+  std::vector< char >& next_rows = this->has_label_[ next == FRONT_A_C ? 0 : 1 ];
+
+  // Neighboring rows and which voxels of those rows are neighbors
+  bool face_x = !this->only2d_ || this->slice_type_ != SliceType::SAGITTAL_E;
+  bool face_y = !this->only2d_ || this->slice_type_ != SliceType::CORONAL_E;
+  bool face_z = !this->only2d_ || this->slice_type_ != SliceType::AXIAL_E;
+  bool edge_xy = !this->only2d_ || this->slice_type_ == SliceType::AXIAL_E;
+  bool edge_xz = !this->only2d_ || this->slice_type_ == SliceType::CORONAL_E;
+  bool edge_yz = !this->only2d_ || this->slice_type_ == SliceType::SAGITTAL_E;
+
+  int pattern[ 3 ][ 3 ];
+  for ( int dz = -1; dz <= 1; dz++ )
+  {
+    for ( int dy = -1; dy <= 1; dy++ )
+    {
+      int p = 0;
+      if ( dy == 0 && dz == 0 ) p = face_x ? ( LEFT_C | RIGHT_C ) : 0;
+      else if ( dz == 0 ) p = ( face_y ? CENTER_C : 0 ) | ( edge_xy ? ( LEFT_C | RIGHT_C ) : 0 );
+      else if ( dy == 0 ) p = ( face_z ? CENTER_C : 0 ) | ( edge_xz ? ( LEFT_C | RIGHT_C ) : 0 );
+      else p = edge_yz ? CENTER_C : 0;
+      pattern[ dz + 1 ][ dy + 1 ] = p;
+    }
+  }
+
+  const unsigned char* neighbor_rows[ 9 ];
+  int neighbor_pattern[ 9 ];
+
+  for ( size_t s = begin; s < end; s++ )
+  {
+    int zz = static_cast< int >( 2 * s ) + this->phase_;
+    bool changed = false;
+
+    for ( int y = 0; y < ny; y++ )
+    {
+      size_t r = static_cast< size_t >( zz ) * ny + y;
+
+      // Find the neighboring rows that contain the front
+      int num_neighbors = 0;
+      for ( int dz = -1; dz <= 1; dz++ )
+      {
+        if ( zz + dz < 0 || zz + dz >= nz ) continue;
+        for ( int dy = -1; dy <= 1; dy++ )
+        {
+          if ( y + dy < 0 || y + dy >= ny ) continue;
+          int p = pattern[ dz + 1 ][ dy + 1 ];
+          size_t nr = static_cast< size_t >( zz + dz ) * ny + ( y + dy );
+          if ( p == 0 || !front_rows[ nr ] ) continue;
+          neighbor_rows[ num_neighbors ] = &this->labels_[ nr * nx ];
+          neighbor_pattern[ num_neighbors ] = p;
+          num_neighbors++;
+        }
+      }
+
+      // Nothing to reach and nothing to clean up
+      if ( num_neighbors == 0 && !next_rows[ r ] ) continue;
+
+      unsigned char* row = &this->labels_[ r * nx ];
+      bool has_next = false;
+      for ( int x = 0; x < nx; x++ )
+      {
+        unsigned char label = row[ x ];
+        if ( label == next )
+        {
+          // This was the front of the previous step
+          row[ x ] = REACHED_C;
+        }
+        else if ( label == UNREACHED_C )
+        {
+          for ( int n = 0; n < num_neighbors; n++ )
+          {
+            const unsigned char* nrow = neighbor_rows[ n ];
+            int p = neighbor_pattern[ n ];
+            if ( ( ( p & CENTER_C ) && nrow[ x ] == front ) ||
+              ( ( p & LEFT_C ) && x > 0 && nrow[ x - 1 ] == front ) ||
+              ( ( p & RIGHT_C ) && x + 1 < nx && nrow[ x + 1 ] == front ) )
+            {
+              row[ x ] = next;
+              has_next = true;
+              break;
+            }
+          }
+        }
+      }
+
+      next_rows[ r ] = has_next;
+      if ( has_next ) changed = true;
+    }
+
+    if ( changed ) this->slice_changed_[ zz ] = true;
+  }
+}
+
+void MaskMorphologyPrivate::finish_propagation( size_t begin, size_t end )
+{
+  unsigned char* labels = &this->labels_[ 0 ];
+  for ( size_t j = begin; j < end; j++ )
+  {
+    unsigned char label = labels[ j ];
+    bool reached = label == REACHED_C || label == FRONT_A_C || label == FRONT_B_C;
+    if ( this->dilate_ ) labels[ j ] = reached ? 1 : 0;
+    else labels[ j ] = reached ? 0 : 1;
+  }
+}
+
+bool MaskMorphologyPrivate::propagate( bool dilate, int steps )
+{
+  this->dilate_ = dilate;
+  size_t num_rows = this->ny_ * this->nz_;
+  this->has_label_[ 0 ].assign( num_rows, 0 );
+  this->has_label_[ 1 ].assign( num_rows, 0 );
+  this->slice_changed_.assign( this->nz_, 0 );
+
+  if ( !parallel_for( 0, this->nz_, 1, 
+    boost::bind( &MaskMorphologyPrivate::initialize_propagation, this, _1, _2 ), this->abort_ ) )
+  {
+    return false;
+  }
+
+  for ( int step = 0; step < steps; step++ )
+  {
+    this->front_ = ( step % 2 == 0 ) ? FRONT_A_C : FRONT_B_C;
+    this->next_ = ( step % 2 == 0 ) ? FRONT_B_C : FRONT_A_C;
+    std::fill( this->slice_changed_.begin(), this->slice_changed_.end(), 0 );
+
+    // Even and odd slices are processed separately, so no slice is written while its 
+    // neighbors are read
+    for ( this->phase_ = 0; this->phase_ < 2; this->phase_++ )
+    {
+      size_t num_slices = ( this->nz_ + 1 - this->phase_ ) / 2;
+      if ( !parallel_for( 0, num_slices, 1, 
+        boost::bind( &MaskMorphologyPrivate::propagate_slices, this, _1, _2 ), this->abort_ ) )
+      {
+        return false;
+      }
+    }
+
+    this->update_progress( static_cast< double >( step + 1 ) / steps );
+
+    // Stop when the front has nowhere left to go
+    if ( std::find( this->slice_changed_.begin(), this->slice_changed_.end(), 1 ) == 
+      this->slice_changed_.end() ) break;
+  }
+
+  size_t size = this->labels_.size();
+  return parallel_for( 0, size, 0x40000, 
+    boost::bind( &MaskMorphologyPrivate::finish_propagation, this, _1, _2 ), this->abort_ );
+}
+
+MaskMorphology::MaskMorphology() :
+  private_( new MaskMorphologyPrivate )
+{
+}
+
+MaskMorphology::~MaskMorphology()
+{
+}
+
+bool MaskMorphology::set_input( MaskDataBlockHandle mask )
+{
+  this->private_->nx_ = mask->get_nx();
+  this->private_->ny_ = mask->get_ny();
+  this->private_->nz_ = mask->get_nz();
+
+  try
+  {
+    this->private_->labels_.resize( mask->get_size() );
+  }
+  catch ( ... )
+  {
+    return false;
+  }
+
+  if ( this->private_->labels_.empty() ) return true;
+
+  MaskDataBlock::shared_lock_type lock( mask->get_mutex() );
+  parallel_for( 0, mask->get_size(), 0x40000, boost::bind( &MaskMorphologyPrivate::load_input, 
+    this->private_, mask->get_mask_data(), mask->get_mask_value(), _1, _2 ) );
+  return true;
+}
+
+void MaskMorphology::set_constraint( MaskDataBlockHandle constraint, bool invert )
+{
+  this->private_->constraint_ = constraint;
+  this->private_->constraint_data_ = constraint ? constraint->get_mask_data() : 0;
+  this->private_->constraint_value_ = constraint ? constraint->get_mask_value() : 0;
+  this->private_->invert_constraint_ = invert;
+}
+
+void MaskMorphology::set_slice_type( bool only2d, SliceType slice_type )
+{
+  this->private_->only2d_ = only2d;
+  this->private_->slice_type_ = slice_type;
+  this->private_->use_x_ = !only2d || slice_type != SliceType::SAGITTAL_E;
+  this->private_->use_y_ = !only2d || slice_type != SliceType::CORONAL_E;
+  this->private_->use_z_ = !only2d || slice_type != SliceType::AXIAL_E;
+}
+
+void MaskMorphology::set_abort_function( abort_function_type abort )
+{
+  this->private_->abort_ = abort;
+}
+
+void MaskMorphology::set_progress_function( progress_function_type progress )
+{
+  this->private_->progress_ = progress;
+}
+
+bool MaskMorphology::dilate( int radius, ball_type ball )
+{
+  if ( this->private_->labels_.empty() ) return true;
+  radius = std::min( std::max( radius, 0 ), MAX_RADIUS_C );
+  int squared_radius = radius * radius + ( ball == ROUNDED_BALL_E ? radius : 0 );
+
+  // The constraint is read directly from its bit-plane
+  boost::shared_ptr< MaskDataBlock::shared_lock_type > lock;
+  if ( this->private_->constraint_ )
+  {
+    lock.reset( new MaskDataBlock::shared_lock_type( 
+      this->private_->constraint_->get_mutex() ) );
+  }
+  return this->private_->transform( true, squared_radius ) && 
+    !this->private_->check_abort();
+}
+
+bool MaskMorphology::erode( int radius, ball_type ball )
+{
+  if ( this->private_->labels_.empty() ) return true;
+  radius = std::min( std::max( radius, 0 ), MAX_RADIUS_C );
+  int squared_radius = radius * radius + ( ball == ROUNDED_BALL_E ? radius : 0 );
+
+  boost::shared_ptr< MaskDataBlock::shared_lock_type > lock;
+  if ( this->private_->constraint_ )
+  {
+    lock.reset( new MaskDataBlock::shared_lock_type( 
+      this->private_->constraint_->get_mutex() ) );
+  }
+  return this->private_->transform( false, squared_radius ) && 
+    !this->private_->check_abort();
+}
+
+bool MaskMorphology::dilate_steps( int steps )
+{
+  if ( this->private_->labels_.empty() || steps <= 0 ) return true;
+
+  boost::shared_ptr< MaskDataBlock::shared_lock_type > lock;
+  if ( this->private_->constraint_ )
+  {
+    lock.reset( new MaskDataBlock::shared_lock_type( 
+      this->private_->constraint_->get_mutex() ) );
+  }
+  return this->private_->propagate( true, steps ) && !this->private_->check_abort();
+}
+
+bool MaskMorphology::erode_steps( int steps )
+{
+  if ( this->private_->labels_.empty() || steps <= 0 ) return true;
+
+  boost::shared_ptr< MaskDataBlock::shared_lock_type > lock;
+  if ( this->private_->constraint_ )
+  {
+    lock.reset( new MaskDataBlock::shared_lock_type( 
+      this->private_->constraint_->get_mutex() ) );
+  }
+  return this->private_->propagate( false, steps ) && !this->private_->check_abort();
+}
+
+bool MaskMorphology::get_output( const GridTransform& grid_transform, 
+  MaskDataBlockHandle& mask )
+{
+  if ( !( MaskDataBlockManager::Create( grid_transform, mask ) ) ) return false;
+  if ( mask->get_size() != this->private_->labels_.size() ) return false;
+  if ( this->private_->labels_.empty() ) return true;
+
+  MaskDataBlock::lock_type lock( mask->get_mutex() );
+  parallel_for( 0, mask->get_size(), 0x40000, boost::bind( &MaskMorphologyPrivate::save_output, 
+    this->private_, mask->get_mask_data(), mask->get_mask_value(), _1, _2 ) );
+  return true;
+}
+
+} // end namespace Core
@@ -0,0 +1,133 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORE_DATABLOCK_MASKMORPHOLOGY_H
+#define CORE_DATABLOCK_MASKMORPHOLOGY_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif 
+
+// Boost includes
+#include <boost/function.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/utility.hpp>
+
+// Core includes
+#include <Core/DataBlock/MaskDataBlock.h>
+#include <Core/DataBlock/SliceType.h>
+#include <Core/Geometry/GridTransform.h>
+
+namespace Core
+{
+
+// CLASS MASKMORPHOLOGY:
+/// Binary dilation and erosion of a mask. The mask is read from and written to its bit-plane
+/// directly, the intermediate state uses one byte per voxel. Ball shaped structuring elements are
+/// evaluated with a separable Euclidean distance transform, hence the run time does not depend
+/// on the radius. The work is distributed over the ThreadPool in slabs of the volume and rows
+/// that cannot change are skipped.
+
+class MaskMorphologyPrivate;
+typedef boost::shared_ptr< MaskMorphologyPrivate > MaskMorphologyPrivateHandle;
+
+class MaskMorphology : public boost::noncopyable
+{
+  // -- types --
+public:
+  typedef boost::function< bool () > abort_function_type;
+  typedef boost::function< void ( double ) > progress_function_type;
+
+  enum ball_type
+  {
+    /// All voxels with x^2 + y^2 + z^2 <= radius^2
+    BALL_E,
+    /// All voxels with x^2 + y^2 + z^2 <= ( radius + 0.5 )^2, which matches the ball 
+    /// structuring element of ITK
+    ROUNDED_BALL_E
+  };
+
+  // -- constructor/destructor --
+public:
+  MaskMorphology();
+  ~MaskMorphology();
+
+  // -- setup --
+public:
+  /// SET_INPUT:
+  /// Load the mask that is processed. Returns false if not enough memory is available.
+  bool set_input( MaskDataBlockHandle mask );
+
+  /// SET_CONSTRAINT:
+  /// Only change voxels that are inside the constraint mask, or outside if invert is set.
+  void set_constraint( MaskDataBlockHandle constraint, bool invert );
+
+  /// SET_SLICE_TYPE:
+  /// If only2d is set, structuring elements only extend within slices of the given orientation.
+  void set_slice_type( bool only2d, SliceType slice_type );
+
+  /// SET_ABORT_FUNCTION:
+  /// Function that is checked regularly, if it returns true the current operation is aborted.
+  void set_abort_function( abort_function_type abort );
+
+  /// SET_PROGRESS_FUNCTION:
+  /// Function that receives the progress of the current operation between 0.0 and 1.0.
+  void set_progress_function( progress_function_type progress );
+
+  // -- operations --
+public:
+  /// DILATE:
+  /// Add all voxels that are within radius of the mask. Returns false if aborted.
+  bool dilate( int radius, ball_type ball = BALL_E );
+
+  /// ERODE:
+  /// Remove all voxels that are within radius of the outside of the mask. Voxels outside of the
+  /// volume are considered to be part of the mask. Returns false if aborted.
+  bool erode( int radius, ball_type ball = BALL_E );
+
+  /// DILATE_STEPS:
+  /// Grow the mask into neighboring voxels, a given number of times. The neighborhood consists of
+  /// the 18 voxels sharing a face or an edge. Growing does not pass through constrained voxels.
+  bool dilate_steps( int steps );
+
+  /// ERODE_STEPS:
+  /// Shrink the mask by removing the voxels that neighbor the outside of the mask, a given 
+  /// number of times. Constrained voxels are never removed and do not pass on the erosion.
+  bool erode_steps( int steps );
+
+  /// GET_OUTPUT:
+  /// Write the current state into a new mask. Returns false if no mask could be allocated.
+  bool get_output( const GridTransform& grid_transform, MaskDataBlockHandle& mask );
+
+private:
+  MaskMorphologyPrivateHandle private_;
+};
+
+} // end namespace Core
+
+#endif
@@ -0,0 +1,395 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+#include <cstring>
+
+// Boost includes
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Core includes
+#include <Core/DataBlock/MaskStatistics.h>
+#include <Core/Utils/ThreadPool.h>
+
+namespace Core
+{
+
+namespace
+{
+
+typedef boost::uint64_t word_type;
+
+// Word with a one in the lowest bit of each byte
+const word_type LANE_ONES_C = 0x0101010101010101ULL;
+
+// Number of bytes in a word
+const size_t WORD_SIZE_C = sizeof( word_type );
+
+// LANECOUNT:
+// Count the bytes that are one in a word that only holds zeros and ones. The multiplication sums
+// all bytes into the top byte, which does not depend on the byte order.
+inline size_t LaneCount( word_type lanes )
+{
+  return static_cast< size_t >( ( lanes * LANE_ONES_C ) >> 56 );
+}
+
+// CLASS SLICESTATISTICS:
+// Voxel count, sums of the coordinates and bounding box of the mask within one axial slice.
+class SliceStatistics
+{
+public:
+  SliceStatistics() :
+    count_( 0 ),
+    sum_x_( 0 ),
+    sum_y_( 0 ),
+    min_x_( 0 ),
+    max_x_( 0 ),
+    min_y_( 0 ),
+    max_y_( 0 )
+  {
+  }
+
+  size_t count_;
+  word_type sum_x_;
+  word_type sum_y_;
+  size_t min_x_;
+  size_t max_x_;
+  size_t min_y_;
+  size_t max_y_;
+};
+
+} // end anonymous namespace
+
+class MaskStatisticsPrivate
+{
+public:
+  MaskStatisticsPrivate();
+
+  // COUNT_SLICE:
+  // Count the voxels of the mask in axial slice z.
+  void count_slice( const unsigned char* data, unsigned int mask_bit, size_t z );
+
+  // COUNT_SLICES:
+  // Count the slices with the indices slices[ begin ] up to slices[ end - 1 ].
+  void count_slices( const unsigned char* data, unsigned int mask_bit, 
+    const std::vector< size_t >* slices, size_t begin, size_t end );
+
+  // SUMMARIZE:
+  // Combine the statistics of the slices into the ones of the volume.
+  void summarize();
+
+  // Protects the cached statistics
+  mutable boost::mutex mutex_;
+
+  // The mask and the generation of the mask the statistics were computed for
+  boost::weak_ptr< MaskDataBlock > mask_;
+  DataBlock::generation_type generation_;
+
+  size_t nx_;
+  size_t ny_;
+  size_t nz_;
+
+  // Words selecting the bytes whose position within the word has bit 0, 1 or 2 set
+  word_type lane_bits_[ 3 ];
+
+  std::vector< SliceStatistics > slices_;
+
+  size_t count_;
+  IndexVector min_;
+  IndexVector max_;
+  Point centroid_;
+};
+
+MaskStatisticsPrivate::MaskStatisticsPrivate() :
+  generation_( -1 ),
+  nx_( 0 ),
+  ny_( 0 ),
+  nz_( 0 ),
+  count_( 0 )
+{
+  // The masks are built from bytes, so they select the same memory positions whatever the byte
+  // order of the word is
+  for ( size_t bit = 0; bit < 3; bit++ )
+  {
+    unsigned char lanes[ WORD_SIZE_C ];
+    for ( size_t k = 0; k < WORD_SIZE_C; k++ )
+    {
+      lanes[ k ] = static_cast< unsigned char >( ( k >> bit ) & 1 );
+    }
+    std::memcpy( &this->lane_bits_[ bit ], lanes, WORD_SIZE_C );
+  }
+}
+
+void MaskStatisticsPrivate::count_slice( const unsigned char* data, unsigned int mask_bit, 
+  size_t z )
+{
+  const size_t nx = this->nx_;
+  const size_t ny = this->ny_;
+  const size_t num_words = nx / WORD_SIZE_C;
+  const unsigned char mask_value = static_cast< unsigned char >( 1 << mask_bit );
+  const unsigned char* slice = data + z * nx * ny;
+
+  SliceStatistics result;
+  for ( size_t y = 0; y < ny; y++ )
+  {
+    const unsigned char* row = slice + y * nx;
+    size_t row_count = 0;
+    word_type row_sum = 0;
+    size_t first_word = num_words;
+    size_t last_word = 0;
+
+    // Move the bit of the mask to the lowest bit of each byte and count eight voxels at once
+    for ( size_t w = 0; w < num_words; w++ )
+    {
+      word_type word;
+      std::memcpy( &word, row + w * WORD_SIZE_C, WORD_SIZE_C );
+      word_type lanes = ( word >> mask_bit ) & LANE_ONES_C;
+      if ( lanes == 0 ) continue;
+
+      size_t count = LaneCount( lanes );
+      row_count += count;
+      row_sum += static_cast< word_type >( w * WORD_SIZE_C ) * count + 
+        4 * LaneCount( lanes & this->lane_bits_[ 2 ] ) +
+        2 * LaneCount( lanes & this->lane_bits_[ 1 ] ) + 
+        LaneCount( lanes & this->lane_bits_[ 0 ] );
+
+      if ( first_word == num_words ) first_word = w;
+      last_word = w;
+    }
+
+    size_t first_x = nx;
+    size_t last_x = 0;
+    if ( first_word < num_words )
+    {
+      first_x = first_word * WORD_SIZE_C;
+      while ( !( row[ first_x ] & mask_value ) ) first_x++;
+      last_x = last_word * WORD_SIZE_C + WORD_SIZE_C - 1;
+      while ( !( row[ last_x ] & mask_value ) ) last_x--;
+    }
+
+    for ( size_t x = num_words * WORD_SIZE_C; x < nx; x++ )
+    {
+      if ( !( row[ x ] & mask_value ) ) continue;
+      row_count++;
+      row_sum += x;
+      first_x = std::min( first_x, x );
+      last_x = x;
+    }
+
+    if ( row_count == 0 ) continue;
+
+    if ( result.count_ == 0 )
+    {
+      result.min_x_ = first_x;
+      result.max_x_ = last_x;
+      result.min_y_ = y;
+    }
+    else
+    {
+      result.min_x_ = std::min( result.min_x_, first_x );
+      result.max_x_ = std::max( result.max_x_, last_x );
+    }
+    result.max_y_ = y;
+    result.count_ += row_count;
+    result.sum_x_ += row_sum;
+    result.sum_y_ += static_cast< word_type >( y ) * row_count;
+  }
+
+  this->slices_[ z ] = result;
+}
+
+void MaskStatisticsPrivate::count_slices( const unsigned char* data, unsigned int mask_bit, 
+  const std::vector< size_t >* slices, size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    this->count_slice( data, mask_bit, ( *slices )[ j ] );
+  }
+}
+
+void MaskStatisticsPrivate::summarize()
+{
+  word_type sum_x = 0;
+  word_type sum_y = 0;
+  word_type sum_z = 0;
+
+  this->count_ = 0;
+  for ( size_t z = 0; z < this->slices_.size(); z++ )
+  {
+    const SliceStatistics& slice = this->slices_[ z ];
+    if ( slice.count_ == 0 ) continue;
+
+    if ( this->count_ == 0 )
+    {
+      this->min_ = IndexVector( slice.min_x_, slice.min_y_, z );
+      this->max_ = IndexVector( slice.max_x_, slice.max_y_, z );
+    }
+    else
+    {
+      this->min_.x( std::min( this->min_.x(), static_cast< IndexVector::index_type >( slice.min_x_ ) ) );
+      this->min_.y( std::min( this->min_.y(), static_cast< IndexVector::index_type >( slice.min_y_ ) ) );
+      this->max_.x( std::max( this->max_.x(), static_cast< IndexVector::index_type >( slice.max_x_ ) ) );
+      this->max_.y( std::max( this->max_.y(), static_cast< IndexVector::index_type >( slice.max_y_ ) ) );
+      this->max_.z( z );
+    }
+
+    this->count_ += slice.count_;
+    sum_x += slice.sum_x_;
+    sum_y += slice.sum_y_;
+    sum_z += static_cast< word_type >( z ) * slice.count_;
+  }
+
+  if ( this->count_ == 0 )
+  {
+    this->min_ = IndexVector();
+    this->max_ = IndexVector();
+    this->centroid_ = Point();
+    return;
+  }
+
+  const double count = static_cast< double >( this->count_ );
+  this->centroid_ = Point( static_cast< double >( sum_x ) / count, 
+    static_cast< double >( sum_y ) / count, static_cast< double >( sum_z ) / count );
+}
+
+MaskStatistics::MaskStatistics() :
+  private_( new MaskStatisticsPrivate )
+{
+}
+
+MaskStatistics::~MaskStatistics()
+{
+}
+
+bool MaskStatistics::update( const MaskDataBlockHandle& mask, abort_function_type abort )
+{
+  // NOTE: get_generation() takes a shared lock itself, which must not be nested in the lock on
+  // the data. A modification in between is counted again by the next update.
+  DataBlock::generation_type generation = mask->get_generation();
+
+  MaskDataBlock::shared_lock_type data_lock( mask->get_mutex() );
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+
+  // Data blocks that are not registered do not have a valid generation and the slices can only
+  // be reused for the same mask with the same dimensions
+  bool update_all = generation < 0 || this->private_->generation_ < 0 ||
+    this->private_->mask_.lock() != mask || this->private_->nx_ != mask->get_nx() || 
+    this->private_->ny_ != mask->get_ny() || this->private_->nz_ != mask->get_nz();
+
+  if ( !update_all && generation == this->private_->generation_ ) return true;
+
+  std::vector< size_t > slices;
+  if ( !update_all )
+  {
+    DataBlock::generation_type last_recorded = -1;
+    for ( size_t z = 0; z < mask->get_nz(); z++ )
+    {
+      DataBlock::generation_type slice_generation = mask->get_slice_generation( z );
+      last_recorded = std::max( last_recorded, slice_generation );
+      if ( slice_generation > this->private_->generation_ ) slices.push_back( z );
+    }
+
+    // If the last change of the data was not recorded per slice, everything needs to be redone
+    update_all = last_recorded != generation;
+  }
+
+  if ( update_all )
+  {
+    this->private_->nx_ = mask->get_nx();
+    this->private_->ny_ = mask->get_ny();
+    this->private_->nz_ = mask->get_nz();
+    this->private_->slices_.assign( this->private_->nz_, SliceStatistics() );
+
+    slices.resize( this->private_->nz_ );
+    for ( size_t z = 0; z < slices.size(); z++ ) slices[ z ] = z;
+  }
+
+  if ( !parallel_for( 0, slices.size(), 1, boost::bind( &MaskStatisticsPrivate::count_slices, 
+    this->private_.get(), mask->get_mask_data(), mask->get_mask_bit(), &slices, _1, _2 ), abort ) )
+  {
+    this->private_->mask_.reset();
+    this->private_->generation_ = -1;
+    return false;
+  }
+
+  this->private_->summarize();
+  this->private_->mask_ = mask;
+  this->private_->generation_ = generation;
+
+  return true;
+}
+
+void MaskStatistics::invalidate()
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  this->private_->mask_.reset();
+  this->private_->generation_ = -1;
+}
+
+DataBlock::generation_type MaskStatistics::get_generation() const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  return this->private_->generation_;
+}
+
+size_t MaskStatistics::get_count() const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  return this->private_->count_;
+}
+
+std::vector< size_t > MaskStatistics::get_slice_counts() const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  std::vector< size_t > counts( this->private_->slices_.size() );
+  for ( size_t z = 0; z < counts.size(); z++ )
+  {
+    counts[ z ] = this->private_->slices_[ z ].count_;
+  }
+  return counts;
+}
+
+bool MaskStatistics::get_bounding_box( IndexVector& min, IndexVector& max ) const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  min = this->private_->min_;
+  max = this->private_->max_;
+  return this->private_->count_ > 0;
+}
+
+bool MaskStatistics::get_centroid( Point& centroid ) const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  centroid = this->private_->centroid_;
+  return this->private_->count_ > 0;
+}
+
+} // end namespace Core
@@ -0,0 +1,117 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORE_DATABLOCK_MASKSTATISTICS_H
+#define CORE_DATABLOCK_MASKSTATISTICS_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif 
+
+// STL includes
+#include <vector>
+
+// Boost includes
+#include <boost/function.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/utility.hpp>
+
+// Core includes
+#include <Core/DataBlock/DataBlock.h>
+#include <Core/DataBlock/MaskDataBlock.h>
+#include <Core/Geometry/IndexVector.h>
+#include <Core/Geometry/Point.h>
+
+namespace Core
+{
+
+class MaskStatistics;
+class MaskStatisticsPrivate;
+typedef boost::shared_ptr< MaskStatistics > MaskStatisticsHandle;
+typedef boost::shared_ptr< MaskStatisticsPrivate > MaskStatisticsPrivateHandle;
+
+// CLASS MASKSTATISTICS:
+/// Voxel count, bounding box, centroid and per-slice counts of a mask. The statistics are kept
+/// per axial slice and are cached with the generation of the mask, so after slice edits only
+/// the modified slices are counted again. All coordinates are in index space.
+
+class MaskStatistics : public boost::noncopyable
+{
+  // -- types --
+public:
+  typedef boost::function< bool () > abort_function_type;
+
+  // -- constructor/destructor --
+public:
+  MaskStatistics();
+  virtual ~MaskStatistics();
+
+  // -- computation --
+public:
+  // UPDATE:
+  /// Bring the statistics up to date with the mask. If the statistics were computed for the
+  /// same mask before, only the slices modified since then are counted again. The slices are
+  /// processed on the ThreadPool. Returns false if the abort function returned true, in which
+  /// case the cache is invalidated.
+  /// NOTE: This function takes a shared lock on the mask data.
+  bool update( const MaskDataBlockHandle& mask, abort_function_type abort = abort_function_type() );
+
+  // INVALIDATE:
+  /// Discard the cached statistics, so the next update counts all slices.
+  void invalidate();
+
+  // -- results --
+public:
+  // GET_GENERATION:
+  /// Get the generation of the mask the statistics were computed for, or -1 if they are not valid.
+  DataBlock::generation_type get_generation() const;
+
+  // GET_COUNT:
+  /// Get the number of voxels in the mask.
+  size_t get_count() const;
+
+  // GET_SLICE_COUNTS:
+  /// Get the number of voxels in the mask for each axial slice.
+  std::vector< size_t > get_slice_counts() const;
+
+  // GET_BOUNDING_BOX:
+  /// Get the first and last index along each axis that contain a voxel of the mask. Returns 
+  /// false if the mask is empty.
+  bool get_bounding_box( IndexVector& min, IndexVector& max ) const;
+
+  // GET_CENTROID:
+  /// Get the average index of the voxels in the mask. Returns false if the mask is empty.
+  bool get_centroid( Point& centroid ) const;
+
+private:
+  MaskStatisticsPrivateHandle private_;
+};
+
+} // end namespace Core
+
+#endif
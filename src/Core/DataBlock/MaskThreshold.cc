@@ -0,0 +1,361 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Boost includes
+#include <boost/bind.hpp>
+
+// Core includes
+#include <Core/DataBlock/MaskThreshold.h>
+#include <Core/Utils/ThreadPool.h>
+
+namespace Core
+{
+
+namespace
+{
+
+// Minimum number of voxels that is handed to a thread at once
+const size_t GRAIN_SIZE_C = 0x40000;
+
+// Number of times progress is reported while thresholding a volume
+const size_t NUM_BATCHES_C = 10;
+
+// GETTHRESHOLDRANGE:
+// Convert the range [ min_val, max_val ] into the range of values of type T that fall within it,
+// so comparing a value of type T against the converted range gives the same answer as comparing
+// it against the original range in double precision. Values of 64 bit types that are not exact
+// in double precision are compared exactly. Returns false if no value of type T is in the range.
+template< class T >
+bool GetThresholdRange( double min_val, double max_val, T& lower, T& upper )
+{
+  if ( !( min_val <= max_val ) ) return false;
+
+  // The maximum of a 64 bit type is not exact in double precision, hence the values are 
+  // compared against the exact power of two above it
+  const double type_min = static_cast< double >( std::numeric_limits< T >::min() );
+  const double type_end = std::ldexp( 1.0, std::numeric_limits< T >::digits );
+
+  min_val = std::ceil( min_val );
+  max_val = std::floor( max_val );
+  if ( min_val > max_val || min_val >= type_end || max_val < type_min ) return false;
+
+  lower = min_val <= type_min ? std::numeric_limits< T >::min() : static_cast< T >( min_val );
+  upper = max_val >= type_end ? std::numeric_limits< T >::max() : static_cast< T >( max_val );
+  return true;
+}
+
+template<>
+bool GetThresholdRange< double >( double min_val, double max_val, double& lower, double& upper )
+{
+  lower = min_val;
+  upper = max_val;
+  return min_val <= max_val;
+}
+
+// The bounds are rounded inwards onto the nearest floats that lie within the double range
+template<>
+bool GetThresholdRange< float >( double min_val, double max_val, float& lower, float& upper )
+{
+  if ( !( min_val <= max_val ) ) return false;
+
+  const float largest = std::numeric_limits< float >::max();
+  const double float_max = static_cast< double >( largest );
+  const float infinity = std::numeric_limits< float >::infinity();
+
+  // Infinite values only fall within bounds beyond the range of float, if they are infinite 
+  // themselves
+  if ( min_val > float_max ) lower = infinity;
+  else if ( min_val < -float_max ) lower = std::isinf( min_val ) ? -infinity : -largest;
+  else
+  {
+    lower = static_cast< float >( min_val );
+    if ( lower < min_val ) lower = std::nextafter( lower, infinity );
+  }
+
+  if ( max_val > float_max ) upper = std::isinf( max_val ) ? infinity : largest;
+  else if ( max_val < -float_max ) upper = -infinity;
+  else
+  {
+    upper = static_cast< float >( max_val );
+    if ( upper > max_val ) upper = std::nextafter( upper, -infinity );
+  }
+
+  return lower <= upper;
+}
+
+// THRESHOLDMASKRANGE:
+// Write the threshold result of the voxels [ begin, end ) into the bit of the mask. The flip
+// value is the bit if the result is inverted and zero otherwise.
+template< class T >
+void ThresholdMaskRange( const T* data, unsigned char* mask_data, T lower, T upper, 
+  unsigned char mask_value, unsigned char flip_value, size_t begin, size_t end )
+{
+  const unsigned char not_mask_value = ~mask_value;
+  for ( size_t j = begin; j < end; j++ )
+  {
+    const T value = data[ j ];
+    const unsigned char in_range = static_cast< unsigned char >( 
+      ( value >= lower ) & ( value <= upper ) );
+    mask_data[ j ] = ( mask_data[ j ] & not_mask_value ) | 
+      ( ( in_range * mask_value ) ^ flip_value );
+  }
+}
+
+// FILLMASKRANGE:
+// Write the same value into the bit of the mask for the voxels [ begin, end ).
+void FillMaskRange( unsigned char* mask_data, unsigned char mask_value, unsigned char value, 
+  size_t begin, size_t end )
+{
+  const unsigned char not_mask_value = ~mask_value;
+  for ( size_t j = begin; j < end; j++ )
+  {
+    mask_data[ j ] = ( mask_data[ j ] & not_mask_value ) | value;
+  }
+}
+
+template< class T >
+bool ThresholdMask( const DataBlockHandle& data, const MaskDataBlockHandle& mask, 
+  double min_val, double max_val, bool invert, MaskThreshold::abort_function_type abort,
+  MaskThreshold::progress_function_type progress )
+{
+  const T* data_ptr = reinterpret_cast< const T* >( data->get_data() );
+  unsigned char* mask_data = mask->get_mask_data();
+  const unsigned char mask_value = mask->get_mask_value();
+  const unsigned char flip_value = invert ? mask_value : 0;
+
+  ThreadPool::range_function_type body;
+  T lower, upper;
+  if ( GetThresholdRange< T >( min_val, max_val, lower, upper ) )
+  {
+    body = boost::bind( &ThresholdMaskRange< T >, data_ptr, mask_data, lower, upper,
+      mask_value, flip_value, _1, _2 );
+  }
+  else
+  {
+    body = boost::bind( &FillMaskRange, mask_data, mask_value, flip_value, _1, _2 );
+  }
+
+  // Run the volume in batches of slices, so progress can be reported in between
+  const size_t slice_size = data->get_nx() * data->get_ny();
+  const size_t nz = data->get_nz();
+  const size_t num_batches = std::max( size_t( 1 ), std::min( nz, NUM_BATCHES_C ) );
+  for ( size_t batch = 0; batch < num_batches; batch++ )
+  {
+    size_t begin = ( nz * batch / num_batches ) * slice_size;
+    size_t end = ( nz * ( batch + 1 ) / num_batches ) * slice_size;
+    if ( !ThreadPool::Instance()->parallel_for( begin, end, GRAIN_SIZE_C, body, abort ) )
+    {
+      return false;
+    }
+
+    if ( progress ) progress( static_cast< double >( batch + 1 ) / num_batches );
+  }
+
+  return true;
+}
+
+// CLASS SLICETHRESHOLDER:
+// Thresholds rows of a slice into the buffer, it is run by parallel_for over the rows.
+template< class T >
+class SliceThresholder
+{
+public:
+  SliceThresholder( const T* data, size_t start, std::ptrdiff_t x_stride, 
+    std::ptrdiff_t y_stride, size_t nx, T lower, T upper, unsigned char flip_value, 
+    unsigned char* buffer ) :
+    data_( data ), start_( start ), x_stride_( x_stride ), y_stride_( y_stride ), nx_( nx ),
+    lower_( lower ), upper_( upper ), flip_value_( flip_value ), buffer_( buffer )
+  {
+  }
+
+  void operator()( size_t row_begin, size_t row_end ) const
+  {
+    for ( size_t j = row_begin; j < row_end; j++ )
+    {
+      const T* row = this->data_ + this->start_ + static_cast< std::ptrdiff_t >( j ) * 
+        this->y_stride_;
+      unsigned char* dst = this->buffer_ + j * this->nx_;
+
+      // Axial slices are contiguous, which keeps the loop free of strided loads
+      if ( this->x_stride_ == 1 )
+      {
+        for ( size_t i = 0; i < this->nx_; i++ )
+        {
+          dst[ i ] = static_cast< unsigned char >( ( row[ i ] >= this->lower_ ) & 
+            ( row[ i ] <= this->upper_ ) ) ^ this->flip_value_;
+        }
+      }
+      else
+      {
+        for ( size_t i = 0; i < this->nx_; i++ )
+        {
+          const T value = row[ static_cast< std::ptrdiff_t >( i ) * this->x_stride_ ];
+          dst[ i ] = static_cast< unsigned char >( ( value >= this->lower_ ) & 
+            ( value <= this->upper_ ) ) ^ this->flip_value_;
+        }
+      }
+    }
+  }
+
+private:
+  const T* data_;
+  size_t start_;
+  std::ptrdiff_t x_stride_;
+  std::ptrdiff_t y_stride_;
+  size_t nx_;
+  T lower_;
+  T upper_;
+  unsigned char flip_value_;
+  unsigned char* buffer_;
+};
+
+template< class T >
+void ThresholdSliceData( DataBlock* data, size_t start, std::ptrdiff_t x_stride, 
+  std::ptrdiff_t y_stride, size_t nx, size_t ny, double min_val, double max_val, 
+  bool invert, unsigned char* buffer )
+{
+  const unsigned char flip_value = invert ? 1 : 0;
+  T lower, upper;
+  if ( !GetThresholdRange< T >( min_val, max_val, lower, upper ) )
+  {
+    std::fill( buffer, buffer + nx * ny, flip_value );
+    return;
+  }
+
+  // Small slices are run on the calling thread, as a single chunk
+  const size_t grain = std::max( size_t( 1 ), GRAIN_SIZE_C / std::max( nx, size_t( 1 ) ) );
+  parallel_for( 0, ny, grain, SliceThresholder< T >( 
+    reinterpret_cast< const T* >( data->get_data() ), start, x_stride, y_stride, nx, 
+    lower, upper, flip_value, buffer ) );
+}
+
+} // end anonymous namespace
+
+bool MaskThreshold::Threshold( const DataBlockHandle& data, const MaskDataBlockHandle& mask,
+  double min_val, double max_val, bool invert, abort_function_type abort, 
+  progress_function_type progress )
+{
+  assert( mask->get_nx() == data->get_nx() );
+  assert( mask->get_ny() == data->get_ny() );
+  assert( mask->get_nz() == data->get_nz() );
+
+  DataBlock::shared_lock_type lock( data->get_mutex() );
+  MaskDataBlock::lock_type mask_lock( mask->get_mutex() );
+
+  switch( data->get_data_type() )
+  {
+    case DataType::CHAR_E:
+      return ThresholdMask< signed char >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::UCHAR_E:
+      return ThresholdMask< unsigned char >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::SHORT_E:
+      return ThresholdMask< short >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::USHORT_E:
+      return ThresholdMask< unsigned short >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::INT_E:
+      return ThresholdMask< int >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::UINT_E:
+      return ThresholdMask< unsigned int >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::LONGLONG_E:
+      return ThresholdMask< long long >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::ULONGLONG_E:
+      return ThresholdMask< unsigned long long >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::FLOAT_E:
+      return ThresholdMask< float >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+    case DataType::DOUBLE_E:
+      return ThresholdMask< double >( data, mask, min_val, max_val, invert, 
+        abort, progress );
+  }
+
+  return false;
+}
+
+void MaskThreshold::ThresholdSlice( DataBlock* data, size_t start, std::ptrdiff_t x_stride, 
+  std::ptrdiff_t y_stride, size_t nx, size_t ny, double min_val, double max_val, bool invert, 
+  unsigned char* buffer )
+{
+  switch( data->get_data_type() )
+  {
+    case DataType::CHAR_E:
+      ThresholdSliceData< signed char >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::UCHAR_E:
+      ThresholdSliceData< unsigned char >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::SHORT_E:
+      ThresholdSliceData< short >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::USHORT_E:
+      ThresholdSliceData< unsigned short >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::INT_E:
+      ThresholdSliceData< int >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::UINT_E:
+      ThresholdSliceData< unsigned int >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::LONGLONG_E:
+      ThresholdSliceData< long long >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::ULONGLONG_E:
+      ThresholdSliceData< unsigned long long >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::FLOAT_E:
+      ThresholdSliceData< float >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+    case DataType::DOUBLE_E:
+      ThresholdSliceData< double >( data, start, x_stride, y_stride, nx, ny, 
+        min_val, max_val, invert, buffer );
+      break;
+  }
+}
+
+} // end namespace Core
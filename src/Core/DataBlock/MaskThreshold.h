@@ -0,0 +1,88 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORE_DATABLOCK_MASKTHRESHOLD_H
+#define CORE_DATABLOCK_MASKTHRESHOLD_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif 
+
+// STL includes
+#include <cstddef>
+
+// Boost includes
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+// Core includes
+#include <Core/DataBlock/DataBlock.h>
+#include <Core/DataBlock/MaskDataBlock.h>
+
+namespace Core
+{
+
+// CLASS MASKTHRESHOLD:
+/// Threshold kernels that write their result straight into a mask bit-plane or a slice buffer.
+/// The threshold range is converted into the data type of the data once, so the inner loops 
+/// compare values without conversions or branches and can be vectorized by the compiler.
+
+class MaskThreshold : public boost::noncopyable
+{
+  // -- types --
+public:
+  typedef boost::function< bool () > abort_function_type;
+  typedef boost::function< void ( double ) > progress_function_type;
+
+  // -- static functions --
+public:
+  // THRESHOLD:
+  /// Set the bit of the mask for every voxel of data with a value within [ min_val, max_val ]
+  /// and clear it for every other voxel, or the other way around if invert is set. The other 
+  /// bits sharing the mask data block are left untouched. The work is distributed over the 
+  /// ThreadPool. Returns false if the abort function returned true, in which case the mask is
+  /// only partially written.
+  static bool Threshold( const DataBlockHandle& data, const MaskDataBlockHandle& mask,
+    double min_val, double max_val, bool invert = false, 
+    abort_function_type abort = abort_function_type(),
+    progress_function_type progress = progress_function_type() );
+
+  // THRESHOLDSLICE:
+  /// Write 1 into the buffer for every value of a slice through data that is within 
+  /// [ min_val, max_val ] and 0 for all others, or the other way around if invert is set.
+  /// The slice starts at index start of data and x_stride and y_stride are the index steps
+  /// between neighboring columns and rows. The buffer receives nx * ny values, row by row.
+  /// NOTE: The caller needs to hold a lock on data.
+  static void ThresholdSlice( DataBlock* data, size_t start, 
+    std::ptrdiff_t x_stride, std::ptrdiff_t y_stride, size_t nx, size_t ny, 
+    double min_val, double max_val, bool invert, unsigned char* buffer );
+};
+
+} // end namespace Core
+
+#endif
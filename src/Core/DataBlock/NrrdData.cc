@@ -27,17 +27,24 @@
  */
 
 #include <locale>
+#include <fstream>
+
+// Zlib includes
+#include <zlib.h>
 
 // Core includes
 #include <Core/Utils/Log.h>
 #include <Core/Utils/StringUtil.h>
 #include <Core/Utils/Exception.h>
+#include <Core/Utils/ThreadPool.h>
 #include <Core/Math/MathFunctions.h>
 #include <Core/Geometry/GridTransform.h>
 #include <Core/DataBlock/NrrdData.h>
 
 // Boost includes
 #include <boost/filesystem.hpp>
+#include <boost/bind.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
 
 namespace Core
 {
@@ -510,41 +517,351 @@ bool NrrdData::get_originally_node_centered() const
 }
 
 
-bool NrrdData::LoadNrrd( const std::string& filename, NrrdDataHandle& nrrddata, std::string& error )
+// Size of the independent gzip members the data of a compressed nrrd is written in
+static const size_t NRRD_GZIP_MEMBER_SIZE_C = 4 << 20;
+
+// Maximum size of a nrrd header that is read by ReadNrrdFile
+static const size_t NRRD_MAX_HEADER_SIZE_C = 1 << 20;
+
+static bool IsLittleEndian()
 {
-  // Lock down the Teem library
-  lock_type lock( GetMutex() );
+  const unsigned short value = 1;
+  return *reinterpret_cast< const unsigned char* >( &value ) == 1;
+}
 
-  Nrrd* nrrd = nrrdNew();
-    boost::filesystem::path nrrd_path = boost::filesystem::path( filename ).parent_path();
-    std::string filename_only = boost::filesystem::path( filename ).filename().string();
+// Compress the blocks [ begin, end ) of data into separate gzip members
+static void CompressGzipMembers( size_t begin, size_t end, const unsigned char* data, size_t size,
+  size_t first_block, int level, std::vector< std::vector< unsigned char > >* members, 
+  std::vector< char >* success )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t start = j * NRRD_GZIP_MEMBER_SIZE_C;
+    size_t length = std::min( NRRD_GZIP_MEMBER_SIZE_C, size - start );
+    std::vector< unsigned char >& member = ( *members )[ j - first_block ];
 
-    boost::system::error_code ec;
-    boost::filesystem::path current_path = boost::filesystem::current_path( ec );
-    if ( ec )
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    // Window bits of 15 + 16 make zlib write a gzip header and trailer
+    if ( deflateInit2( &stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+    {
+      ( *success )[ j - first_block ] = 0;
+      continue;
+    }
+
+    member.resize( deflateBound( &stream, static_cast< uLong >( length ) ) + 32 );
+    stream.next_in = const_cast< Bytef* >( data + start );
+    stream.avail_in = static_cast< uInt >( length );
+    stream.next_out = &member[ 0 ];
+    stream.avail_out = static_cast< uInt >( member.size() );
+
+    ( *success )[ j - first_block ] = deflate( &stream, Z_FINISH ) == Z_STREAM_END;
+    member.resize( stream.total_out );
+    deflateEnd( &stream );
+  }
+}
+
+// Write the data of a nrrd, compressed data is written as a series of gzip members that are
+// compressed in parallel. Readers that support gzip, including Teem, concatenate the members.
+static bool WriteNrrdData( std::ofstream& file, const unsigned char* data, size_t size,
+  bool compress, int level )
+{
+  if ( !compress )
+  {
+    file.write( reinterpret_cast< const char* >( data ), size );
+    return !file.fail();
+  }
+
+  if ( level < 0 || level > 9 ) level = Z_DEFAULT_COMPRESSION;
+
+  size_t num_blocks = std::max( ( size + NRRD_GZIP_MEMBER_SIZE_C - 1 ) / 
+    NRRD_GZIP_MEMBER_SIZE_C, static_cast< size_t >( 1 ) );
+
+  // Compress a few blocks per thread at a time to bound the memory used for the output
+  size_t batch_size = 2 * static_cast< size_t >( ThreadPool::Instance()->get_concurrency() );
+  std::vector< std::vector< unsigned char > > members;
+  std::vector< char > success;
+
+  for ( size_t batch_begin = 0; batch_begin < num_blocks; batch_begin += batch_size )
+  {
+    size_t batch_end = std::min( batch_begin + batch_size, num_blocks );
+    members.clear();
+    members.resize( batch_end - batch_begin );
+    success.assign( batch_end - batch_begin, 0 );
+
+    Core::parallel_for( batch_begin, batch_end, 1, boost::bind( &CompressGzipMembers, 
+      _1, _2, data, size, batch_begin, level, &members, &success ) );
+
+    for ( size_t j = 0; j < members.size(); j++ )
+    {
+      if ( !success[ j ] ) return false;
+      file.write( reinterpret_cast< const char* >( &members[ j ][ 0 ] ), members[ j ].size() );
+      if ( file.fail() ) return false;
+    }
+  }
+
+  return true;
+}
+
+// Read gzip compressed data that may consist of multiple gzip members
+static bool ReadGzipData( std::ifstream& file, unsigned char* data, size_t size )
+{
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.next_in = Z_NULL;
+  stream.avail_in = 0;
+
+  // Window bits of 15 + 32 detect the gzip header automatically
+  if ( inflateInit2( &stream, 15 + 32 ) != Z_OK ) return false;
+
+  std::vector< char > buffer( 1 << 20 );
+  size_t offset = 0;
+  bool success = false;
+
+  while ( true )
+  {
+    if ( offset == size )
+    {
+      success = true;
+      break;
+    }
+
+    if ( stream.avail_in == 0 )
+    {
+      file.read( &buffer[ 0 ], buffer.size() );
+      if ( file.gcount() == 0 ) break;
+      stream.next_in = reinterpret_cast< Bytef* >( &buffer[ 0 ] );
+      stream.avail_in = static_cast< uInt >( file.gcount() );
+    }
+
+    size_t chunk = std::min( size - offset, static_cast< size_t >( 1 << 30 ) );
+    stream.next_out = data + offset;
+    stream.avail_out = static_cast< uInt >( chunk );
+
+    int result = inflate( &stream, Z_NO_FLUSH );
+    offset += chunk - stream.avail_out;
+
+    if ( result == Z_STREAM_END )
     {
-    error = std::string( "Could not open file: " ) + filename + " : Could not get current directory.";
-        return false;
+      // Continue with the next member
+      if ( inflateReset( &stream ) != Z_OK ) break;
     }
-    boost::filesystem::current_path( nrrd_path, ec );
-    if ( ec )
+    else if ( result != Z_OK && result != Z_BUF_ERROR )
     {
-    error = std::string( "Could not open file: " ) + filename + " : Could not access path.";
-        return false;
+      break;
     }
+  }
+
+  inflateEnd( &stream );
+  return success;
+}
+
+// Generate the header of an attached nrrd using Teem
+static bool WriteNrrdHeader( const Nrrd* nrrd, bool compress, std::string& header, 
+  std::string& error )
+{
+  NrrdData::lock_type lock( NrrdData::GetMutex() );
+
+  NrrdIoState* nio = nrrdIoStateNew();
+  nrrdIoStateEncodingSet( nio, nrrdEncodingRaw );
+  nio->skipData = AIR_TRUE;
 
-  if ( nrrdLoad( nrrd, filename_only.c_str(), 0 ) )
+  char* header_string = 0;
+  if ( nrrdStringWrite( &header_string, nrrd, nio ) )
+  {
+    char *err = biffGet( NRRD );
+    error = std::string( err );
+    free( err );
+    biffDone( NRRD );
+    nrrdIoStateNix( nio );
+    return false;
+  }
+  nrrdIoStateNix( nio );
+
+  header = header_string;
+  free( header_string );
+
+  // The header needs to be terminated by an empty line
+  while ( !header.empty() && header[ header.size() - 1 ] == '\n' ) header.resize( header.size() - 1 );
+  header += "\n\n";
+
+  if ( compress )
+  {
+    size_t pos = header.find( "\nencoding: raw\n" );
+    if ( pos == std::string::npos )
+    {
+      error = "Could not set the encoding of the nrrd header.";
+      return false;
+    }
+    header.replace( pos, 15, "\nencoding: gzip\n" );
+  }
+
+  return true;
+}
+
+// Load a nrrd with Teem. This is used for the formats ReadNrrdFile does not handle itself.
+static Nrrd* LoadNrrdWithTeem( const std::string& filename, std::string& error )
+{
+  // Lock down the Teem library
+  NrrdData::lock_type lock( NrrdData::GetMutex() );
+
+  // NOTE: Teem locates detached data files relative to the directory of the header
+  Nrrd* nrrd = nrrdNew();
+  if ( nrrdLoad( nrrd, filename.c_str(), 0 ) )
   {
     char *err = biffGet( NRRD );
     error = std::string( "Could not open file: " ) + filename + " : " + std::string( err );
     free( err );
     biffDone( NRRD );
     nrrdNuke( nrrd );
+    return 0;
+  }
+
+  return nrrd;
+}
+
+// Read an attached nrrd with raw or gzip encoding. Only the header is parsed by Teem, the data
+// is read without holding the Teem lock, so that multiple files can be read at the same time.
+static Nrrd* ReadNrrdFile( const std::string& filename, std::string& error )
+{
+  std::ifstream file( filename.c_str(), std::ios::in | std::ios::binary );
+  if ( !file )
+  {
+    error = std::string( "Could not open file: " ) + filename;
+    return 0;
+  }
+
+  std::string line;
+  std::getline( file, line );
+  if ( line.compare( 0, 7, "NRRD000" ) != 0 )
+  {
+    file.close();
+    return LoadNrrdWithTeem( filename, error );
+  }
+
+  std::string header = line + "\n";
+  bool gzip = false;
+  bool little_endian = IsLittleEndian();
+
+  while ( true )
+  {
+    if ( !std::getline( file, line ) || header.size() > NRRD_MAX_HEADER_SIZE_C )
+    {
+      error = std::string( "Could not open file: " ) + filename + " : Incomplete header.";
+      return 0;
+    }
+
+    if ( !line.empty() && line[ line.size() - 1 ] == '\r' ) line.resize( line.size() - 1 );
+    if ( line.empty() ) break;
+
+    // Comments and key/value pairs are passed on to Teem
+    size_t colon = line.find( ':' );
+    if ( line[ 0 ] == '#' || colon == std::string::npos || line.compare( colon, 2, ":=" ) == 0 )
+    {
+      header += line + "\n";
+      continue;
+    }
+
+    std::string field = StringToLower( line.substr( 0, colon ) );
+    StripSurroundingSpaces( field );
+    std::string value = StringToLower( line.substr( colon + 1 ) );
+    StripSurroundingSpaces( value );
+
+    if ( field == "data file" || field == "datafile" || field == "line skip" || 
+      field == "lineskip" || field == "byte skip" || field == "byteskip" )
+    {
+      file.close();
+      return LoadNrrdWithTeem( filename, error );
+    }
+    else if ( field == "encoding" )
+    {
+      if ( value == "gzip" || value == "gz" )
+      {
+        gzip = true;
+      }
+      else if ( value != "raw" )
+      {
+        file.close();
+        return LoadNrrdWithTeem( filename, error );
+      }
+      line = "encoding: raw";
+    }
+    else if ( field == "endian" )
+    {
+      little_endian = ( value == "little" );
+    }
+
+    header += line + "\n";
+  }
+  header += "\n";
+
+  Nrrd* nrrd = nrrdNew();
+  {
+    NrrdData::lock_type lock( NrrdData::GetMutex() );
+    NrrdIoState* nio = nrrdIoStateNew();
+    nio->skipData = AIR_TRUE;
+    if ( nrrdStringRead( nrrd, header.c_str(), nio ) )
+    {
+      char *err = biffGet( NRRD );
+      error = std::string( "Could not open file: " ) + filename + " : " + std::string( err );
+      free( err );
+      biffDone( NRRD );
+      nrrdIoStateNix( nio );
+      nrrdNuke( nrrd );
+      return 0;
+    }
+    nrrdIoStateNix( nio );
+  }
+
+  size_t size = nrrdElementNumber( nrrd ) * nrrdElementSize( nrrd );
+  nrrd->data = malloc( std::max( size, static_cast< size_t >( 1 ) ) );
+  if ( nrrd->data == 0 )
+  {
+    error = std::string( "Could not open file: " ) + filename + " : Not enough memory.";
+    nrrdNuke( nrrd );
+    return 0;
+  }
+
+  unsigned char* data = reinterpret_cast< unsigned char* >( nrrd->data );
+  bool success;
+  if ( gzip )
+  {
+    success = ReadGzipData( file, data, size );
+  }
+  else
+  {
+    file.read( reinterpret_cast< char* >( data ), size );
+    success = static_cast< size_t >( file.gcount() ) == size;
+  }
+
+  if ( !success )
+  {
+    error = std::string( "Could not open file: " ) + filename + " : Could not read data.";
+    nrrdNuke( nrrd );
+    return 0;
+  }
+
+  if ( little_endian != IsLittleEndian() && nrrdElementSize( nrrd ) > 1 )
+  {
+    nrrdSwapEndian( nrrd );
+  }
+
+  return nrrd;
+}
+
+bool NrrdData::LoadNrrd( const std::string& filename, NrrdDataHandle& nrrddata, std::string& error )
+{
+  Nrrd* nrrd = ReadNrrdFile( filename, error );
+  if ( nrrd == 0 )
+  {
     nrrddata.reset();
-        boost::filesystem::current_path( current_path, ec );
     return false;
   }
-    boost::filesystem::current_path( current_path, ec );
 
   if ( nrrd->dim < 2 )
   {
@@ -632,20 +949,12 @@ bool NrrdData::LoadNrrd( const std::string& filename, NrrdDataHandle& nrrddata,
   return true;
 }
 
-bool NrrdData::SaveNrrd( const std::string& filename,
-                         NrrdDataHandle nrrddata,
-                         std::string& error,
-                         bool compress,
-                         int level )
+// Save a nrrd with Teem. This is used for detached headers and formats other than nrrd.
+static bool SaveNrrdWithTeem( const std::string& filename, NrrdDataHandle nrrddata, 
+  std::string& error, bool compress, int level )
 {
   // Lock down the Teem library
-  lock_type lock( GetMutex() );
-
-  if ( ! nrrddata.get() )
-  {
-    error = "Error writing file: " + filename + " : no data volume available";
-    return false;
-  }
+  NrrdData::lock_type lock( NrrdData::GetMutex() );
 
   NrrdIoState* nio = nrrdIoStateNew();
 
@@ -668,6 +977,7 @@ bool NrrdData::SaveNrrd( const std::string& filename,
     error = "Error writing file: " + filename + " : " + std::string( err );
     free( err );
     biffDone( NRRD );
+    nrrdIoStateNix( nio );
 
     return false;
   }
@@ -678,6 +988,54 @@ bool NrrdData::SaveNrrd( const std::string& filename,
   return true;
 }
 
+bool NrrdData::SaveNrrd( const std::string& filename,
+                         NrrdDataHandle nrrddata,
+                         std::string& error,
+                         bool compress,
+                         int level )
+{
+  if ( ! nrrddata.get() )
+  {
+    error = "Error writing file: " + filename + " : no data volume available";
+    return false;
+  }
+
+  // Only attached nrrds are written directly, Teem handles detached headers and other formats
+  std::string extension = boost::algorithm::to_lower_copy( 
+    boost::filesystem::path( filename ).extension().string() );
+  std::string header;
+  if ( extension != ".nrrd" || !WriteNrrdHeader( nrrddata->nrrd(), compress, header, error ) ||
+    header.find( "\ndata file:" ) != std::string::npos )
+  {
+    return SaveNrrdWithTeem( filename, nrrddata, error, compress, level );
+  }
+
+  std::ofstream file( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  if ( !file )
+  {
+    error = "Error writing file: " + filename + " : could not open file for writing";
+    return false;
+  }
+
+  file.write( header.c_str(), header.size() );
+  size_t size = nrrdElementNumber( nrrddata->nrrd() ) * nrrdElementSize( nrrddata->nrrd() );
+  bool success = !file.fail() && WriteNrrdData( file, reinterpret_cast< const unsigned char* >( 
+    nrrddata->get_data() ), size, compress, level );
+  // Closing flushes the last buffered data, which can fail as well
+  file.close();
+  if ( !success || file.fail() )
+  {
+    // Do not leave a truncated file behind, as session saves reuse data files that exist
+    boost::system::error_code ec;
+    boost::filesystem::remove( filename, ec );
+    error = "Error writing file: " + filename + " : could not write data";
+    return false;
+  }
+
+  error = "";
+  return true;
+}
+
 NrrdData::mutex_type& NrrdData::GetMutex()
 {
   // Mutex protecting Teem calls like nrrdLoad and nrrdSave that are known
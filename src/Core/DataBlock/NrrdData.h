@@ -153,6 +153,8 @@ public:
 
   // LOADNRRD:
   /// Load a nrrd into the nrrd data structure
+  /// NOTE: Attached nrrds with raw or gzip encoding are read without holding the Teem lock,
+  /// hence multiple files can be loaded at the same time.
   static bool LoadNrrd( const std::string& filename, NrrdDataHandle& nrrddata, 
     std::string& error );
 
@@ -160,6 +162,8 @@ public:
   /// Save a nrrd to file from nrrd data structure
   /// If compress is false, level will be overridden and set to 0, which
   /// corresponds to zlib setting for no compression
+  /// NOTE: Files with a .nrrd extension are written without holding the Teem lock. Compressed
+  /// data is written as a series of gzip members that are compressed in parallel.
   static bool SaveNrrd( const std::string& filename,
                         NrrdDataHandle nrrddata,
                         std::string& error,
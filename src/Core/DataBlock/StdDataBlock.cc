@@ -27,12 +27,15 @@
  */
 
 #include <Core/DataBlock/StdDataBlock.h>
+#include <Core/DataBlock/DataBlockAllocator.h>
 #include <Core/DataBlock/DataBlockManager.h>
 
 namespace Core
 {
 
-StdDataBlock::StdDataBlock( size_t nx, size_t ny, size_t nz, DataType dtype )
+StdDataBlock::StdDataBlock( size_t nx, size_t ny, size_t nz, DataType dtype ) :
+  buffer_( 0 ),
+  buffer_size_( 0 )
 {
   // Set the properties of this datablock
   set_nx( nx );
@@ -40,51 +43,28 @@ StdDataBlock::StdDataBlock( size_t nx, size_t ny, size_t nz, DataType dtype )
   set_nz( nz );
   set_type( dtype );
 
-  // Allocate the memory block through C++'s std library
-  switch( get_data_type() )
+  if ( get_data_type() == DataType::UNKNOWN_E )
   {
-  case DataType::UNKNOWN_E:
     set_nx( 0 );
     set_ny( 0 );
     set_nz( 0 );
     set_data( 0 );
-    break;
-  case DataType::CHAR_E:
-    set_data( reinterpret_cast< void* > ( new char[ get_size() ] ) );
-    break;
-  case DataType::UCHAR_E:
-    set_data( reinterpret_cast<void*>( new unsigned char[ get_size() ] ) );
-    break;
-  case DataType::SHORT_E:
-    set_data( reinterpret_cast< void* > ( new short[ get_size() ] ) );
-    break;
-  case DataType::USHORT_E:
-    set_data(reinterpret_cast<void*>( new unsigned short[ get_size() ] ) );
-    break;
-  case DataType::INT_E:
-    set_data( reinterpret_cast< void* > ( new int[ get_size() ] ) );
-    break;
-  case DataType::UINT_E:
-    set_data( reinterpret_cast<void*>( new unsigned int[ get_size() ] ) );
-    break;
-  case DataType::LONGLONG_E:
-    set_data( reinterpret_cast< void* > ( new long long[ get_size() ] ) );
-    break;
-  case DataType::ULONGLONG_E:
-    set_data(reinterpret_cast<void*>( new unsigned long long[ get_size() ] ) );
-    break;
-  case DataType::FLOAT_E:
-    set_data( reinterpret_cast< void* > ( new float[ get_size() ] ) );
-    break;
-  case DataType::DOUBLE_E:
-    set_data( reinterpret_cast< void* > ( new double[ get_size() ] ) );
-    break;
+    return;
   }
+
+  // Allocate the memory block through the allocator, which reuses the buffers of volumes that
+  // were released recently
+  this->buffer_size_ = get_byte_size();
+  this->buffer_ = DataBlockAllocator::Instance()->allocate( this->buffer_size_ );
+  set_data( this->buffer_ );
 }
 
 StdDataBlock::~StdDataBlock()
 {
-  if ( get_data() )
+  DataBlockAllocator::Instance()->deallocate( this->buffer_, this->buffer_size_ );
+
+  // Data that replaced the buffer through set_data() was allocated with new[]
+  if ( get_data() && get_data() != this->buffer_ )
   {
     switch( get_data_type() )
     {
@@ -58,6 +58,11 @@ public:
   static DataBlockHandle New( size_t nx, size_t ny, size_t nz, DataType type );
 
   static DataBlockHandle New( GridTransform transform, DataType type );
+
+private:
+  // Buffer from the DataBlockAllocator and its size in bytes
+  void* buffer_;
+  size_t buffer_size_;
 };
 
 } // end namespace Core
@@ -0,0 +1,98 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <Core/DataBlock/DataBlockAllocator.h>
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+namespace
+{
+
+// Restores the settings of the allocator and empties its pool
+class DataBlockAllocatorBenchmark : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    DataBlockAllocator* allocator = DataBlockAllocator::Instance();
+    this->pool_limit_ = allocator->get_pool_limit();
+    this->huge_pages_ = allocator->get_huge_pages();
+    allocator->flush_pool();
+  }
+
+  virtual void TearDown()
+  {
+    DataBlockAllocator* allocator = DataBlockAllocator::Instance();
+    allocator->set_pool_limit( this->pool_limit_ );
+    allocator->set_huge_pages( this->huge_pages_ );
+    allocator->flush_pool();
+  }
+
+  size_t pool_limit_;
+  bool huge_pages_;
+};
+
+}
+
+TEST_F( DataBlockAllocatorBenchmark, BackToBackVolumes )
+{
+  // A chain of filters that each create a volume of the same size and release the previous one
+  const size_t size = 256;
+  const int num_runs = 8;
+  double times[ 2 ];
+  for ( int pooled = 0; pooled < 2; pooled++ )
+  {
+    DataBlockAllocator::Instance()->set_pool_limit( pooled ? size_t( 1 ) << 30 : 0 );
+    DataBlockHandle previous = StdDataBlock::New( size, size, size, DataType::FLOAT_E );
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+    for ( int i = 0; i < num_runs; i++ )
+    {
+      DataBlockHandle data = StdDataBlock::New( size, size, size, DataType::FLOAT_E );
+      ASSERT_TRUE( data );
+      float* values = reinterpret_cast< float* >( data->get_data() );
+      for ( size_t j = 0; j < data->get_size(); j += 1024 ) values[ j ] = static_cast< float >( i );
+      previous = data;
+    }
+    times[ pooled ] = static_cast< double >( 
+      ( boost::posix_time::microsec_clock::local_time() - start ).total_microseconds() ) / 
+      num_runs;
+  }
+
+  DataBlockAllocatorStatistics statistics = DataBlockAllocator::Instance()->get_statistics();
+  EXPECT_LT( 0u, statistics.num_pool_hits_ );
+  std::cout << "Volume of " << size << "^3 floats: " << times[ 0 ] / 1000.0 << 
+    " ms without pool, " << times[ 1 ] / 1000.0 << " ms with pool, " << 
+    statistics.num_huge_page_allocations_ << " huge page allocations" << std::endl;
+}
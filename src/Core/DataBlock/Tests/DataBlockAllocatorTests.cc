@@ -0,0 +1,181 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <Core/DataBlock/DataBlockAllocator.h>
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+namespace
+{
+
+bool isAligned( const void* data, size_t alignment )
+{
+  return reinterpret_cast< boost::uintptr_t >( data ) % alignment == 0;
+}
+
+// Restores the settings of the allocator and empties its pool
+class DataBlockAllocatorTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    DataBlockAllocator* allocator = DataBlockAllocator::Instance();
+    this->pool_limit_ = allocator->get_pool_limit();
+    this->huge_pages_ = allocator->get_huge_pages();
+    allocator->flush_pool();
+  }
+
+  virtual void TearDown()
+  {
+    DataBlockAllocator* allocator = DataBlockAllocator::Instance();
+    allocator->set_pool_limit( this->pool_limit_ );
+    allocator->set_huge_pages( this->huge_pages_ );
+    allocator->flush_pool();
+  }
+
+  size_t pool_limit_;
+  bool huge_pages_;
+};
+
+}
+
+TEST_F( DataBlockAllocatorTest, Alignment )
+{
+  DataBlockAllocator* allocator = DataBlockAllocator::Instance();
+  const size_t sizes[] = { 0, 1, 3, 63, 64, 1000, 4096 * 3 + 5, 
+    DataBlockAllocator::LARGE_BUFFER_SIZE_C + 17 };
+  for ( size_t i = 0; i < sizeof( sizes ) / sizeof( size_t ); i++ )
+  {
+    void* data = allocator->allocate( sizes[ i ] );
+    ASSERT_TRUE( data != 0 );
+    EXPECT_TRUE( isAligned( data, DataBlockAllocator::ALIGNMENT_C ) ) << sizes[ i ];
+    std::memset( data, 0xab, sizes[ i ] );
+    allocator->deallocate( data, sizes[ i ] );
+  }
+
+  // Large buffers start on a huge page
+  allocator->set_huge_pages( true );
+  size_t size = 3 * DataBlockAllocator::LARGE_BUFFER_SIZE_C;
+  void* data = allocator->allocate( size );
+  EXPECT_TRUE( isAligned( data, DataBlockAllocator::HUGE_PAGE_SIZE_C ) );
+  allocator->deallocate( data, size );
+}
+
+TEST_F( DataBlockAllocatorTest, PoolReusesBuffers )
+{
+  DataBlockAllocator* allocator = DataBlockAllocator::Instance();
+  size_t size = 5 * DataBlockAllocator::LARGE_BUFFER_SIZE_C + 100;
+  DataBlockAllocatorStatistics before = allocator->get_statistics();
+
+  void* data = allocator->allocate( size );
+  std::memset( data, 1, size );
+  allocator->deallocate( data, size );
+  DataBlockAllocatorStatistics released = allocator->get_statistics();
+  EXPECT_EQ( before.bytes_in_use_, released.bytes_in_use_ );
+  EXPECT_LE( size, released.bytes_pooled_ );
+
+  // A request of a slightly different size falls into the same bucket
+  void* reused = allocator->allocate( size - 50 );
+  EXPECT_EQ( data, reused );
+  DataBlockAllocatorStatistics after = allocator->get_statistics();
+  EXPECT_EQ( before.num_pool_hits_ + 1, after.num_pool_hits_ );
+  EXPECT_EQ( before.num_system_allocations_ + 1, after.num_system_allocations_ );
+  EXPECT_EQ( before.num_allocations_ + 2, after.num_allocations_ );
+  EXPECT_EQ( 0u, after.bytes_pooled_ );
+  EXPECT_LE( before.bytes_in_use_ + size, after.peak_bytes_in_use_ );
+
+  // Small buffers are not pooled
+  void* small = allocator->allocate( 1000 );
+  allocator->deallocate( small, 1000 );
+  EXPECT_EQ( 0u, allocator->get_statistics().bytes_pooled_ );
+
+  allocator->deallocate( reused, size - 50 );
+  allocator->flush_pool();
+  EXPECT_EQ( 0u, allocator->get_statistics().bytes_pooled_ );
+  EXPECT_EQ( before.bytes_in_use_, allocator->get_statistics().bytes_in_use_ );
+}
+
+TEST_F( DataBlockAllocatorTest, PoolLimit )
+{
+  DataBlockAllocator* allocator = DataBlockAllocator::Instance();
+  size_t size = 2 * DataBlockAllocator::LARGE_BUFFER_SIZE_C;
+  allocator->set_pool_limit( 3 * size );
+
+  std::vector< void* > buffers;
+  for ( int i = 0; i < 5; i++ ) buffers.push_back( allocator->allocate( size ) );
+  for ( int i = 0; i < 5; i++ ) allocator->deallocate( buffers[ i ], size );
+
+  // Only the most recently released buffers are kept
+  EXPECT_EQ( 3 * size, allocator->get_statistics().bytes_pooled_ );
+  void* data = allocator->allocate( size );
+  EXPECT_EQ( buffers[ 4 ], data );
+  allocator->deallocate( data, size );
+
+  // Lowering the limit releases buffers, a limit of 0 disables the pool
+  allocator->set_pool_limit( size );
+  EXPECT_EQ( size, allocator->get_statistics().bytes_pooled_ );
+  allocator->set_pool_limit( 0 );
+  EXPECT_EQ( 0u, allocator->get_statistics().bytes_pooled_ );
+  data = allocator->allocate( size );
+  allocator->deallocate( data, size );
+  EXPECT_EQ( 0u, allocator->get_statistics().bytes_pooled_ );
+}
+
+TEST_F( DataBlockAllocatorTest, StdDataBlock )
+{
+  DataBlockAllocator* allocator = DataBlockAllocator::Instance();
+  DataBlockAllocatorStatistics before = allocator->get_statistics();
+  {
+    DataBlockHandle data = StdDataBlock::New( 128, 128, 64, DataType::FLOAT_E );
+    ASSERT_TRUE( data );
+    EXPECT_TRUE( isAligned( data->get_data(), DataBlockAllocator::ALIGNMENT_C ) );
+    EXPECT_LE( before.bytes_in_use_ + data->get_byte_size(), 
+      allocator->get_statistics().bytes_in_use_ );
+    data->set_data_at( 127, 127, 63, 2.5 );
+    EXPECT_EQ( 2.5, data->get_data_at( 127, 127, 63 ) );
+  }
+  EXPECT_EQ( before.bytes_in_use_, allocator->get_statistics().bytes_in_use_ );
+
+  // Data that replaces the buffer is still released with delete[]
+  {
+    DataBlockHandle data = StdDataBlock::New( 3, 3, 3, DataType::INT_E );
+    int* values = new int[ 27 ];
+    for ( int i = 0; i < 27; i++ ) values[ i ] = i;
+    data->set_data( values );
+    EXPECT_EQ( 13.0, data->get_data_at( 1, 1, 1 ) );
+  }
+  EXPECT_EQ( before.bytes_in_use_, allocator->get_statistics().bytes_in_use_ );
+}
@@ -0,0 +1,83 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+TEST( DataBlockTransformBenchmarks, Throughput )
+{
+  const size_t size = 256;
+  DataBlockHandle src = StdDataBlock::New( size, size, size, DataType::FLOAT_E );
+  float* data = reinterpret_cast< float* >( src->get_data() );
+  for ( size_t j = 0; j < src->get_size(); j++ ) data[ j ] = static_cast< float >( j % 1000 );
+  ASSERT_TRUE( src->update_histogram() );
+
+  DataBlockHandle dst;
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( DataBlock::ConvertDataType( src, dst, DataType::USHORT_E ) );
+  boost::posix_time::time_duration convert_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( DataBlock::QuantizeData( src, dst, DataType::UCHAR_E ) );
+  boost::posix_time::time_duration quantize_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  std::vector< int > permutation( 3 );
+  permutation[ 0 ] = 3;
+  permutation[ 1 ] = -1;
+  permutation[ 2 ] = 2;
+  start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( DataBlock::PermuteData( src, dst, permutation ) );
+  boost::posix_time::time_duration permute_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( DataBlock::Pad( src, dst, 4, 0.0 ) );
+  boost::posix_time::time_duration pad_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( DataBlock::Duplicate( src, dst ) );
+  dst->swap_endian();
+  boost::posix_time::time_duration duplicate_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  std::cout << "Float data of " << size << "^3: convert " << convert_time.total_milliseconds() <<
+    " ms, quantize " << quantize_time.total_milliseconds() << " ms, permute " << 
+    permute_time.total_milliseconds() << " ms, pad " << pad_time.total_milliseconds() << 
+    " ms, duplicate and swap " << duplicate_time.total_milliseconds() << " ms" << std::endl;
+}
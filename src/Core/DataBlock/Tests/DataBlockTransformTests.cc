@@ -0,0 +1,263 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+namespace
+{
+
+const size_t NX_C = 37;
+const size_t NY_C = 23;
+const size_t NZ_C = 19;
+
+const DataType TYPES_C[] = { DataType::CHAR_E, DataType::UCHAR_E, DataType::SHORT_E,
+  DataType::USHORT_E, DataType::INT_E, DataType::UINT_E, DataType::LONGLONG_E, 
+  DataType::ULONGLONG_E, DataType::FLOAT_E, DataType::DOUBLE_E };
+const size_t NUM_TYPES_C = sizeof( TYPES_C ) / sizeof( DataType );
+
+// Value of a voxel that fits in every data type
+double voxelValue( size_t x, size_t y, size_t z )
+{
+  return static_cast< double >( ( x * 7 + y * 13 + z * 29 ) % 101 ) + 
+    ( ( x + y ) % 4 ) * 0.25;
+}
+
+DataBlockHandle createData( size_t nx, size_t ny, size_t nz, DataType data_type )
+{
+  DataBlockHandle data = StdDataBlock::New( nx, ny, nz, data_type );
+  for ( size_t z = 0; z < nz; z++ )
+    for ( size_t y = 0; y < ny; y++ )
+      for ( size_t x = 0; x < nx; x++ )
+        data->set_data_at( x, y, z, voxelValue( x, y, z ) );
+  return data;
+}
+
+} // end anonymous namespace
+
+TEST( DataBlockTransformTests, ConvertDataType )
+{
+  for ( size_t s = 0; s < NUM_TYPES_C; s++ )
+  {
+    DataBlockHandle src = createData( NX_C, NY_C, NZ_C, TYPES_C[ s ] );
+    for ( size_t d = 0; d < NUM_TYPES_C; d++ )
+    {
+      DataBlockHandle dst;
+      ASSERT_TRUE( DataBlock::ConvertDataType( src, dst, TYPES_C[ d ] ) );
+      ASSERT_EQ( TYPES_C[ d ], dst->get_data_type() );
+      for ( size_t j = 0; j < src->get_size(); j++ )
+      {
+        double value = src->get_data_at( j );
+        double expected = IsInteger( TYPES_C[ d ] ) ? std::floor( value ) : value;
+        ASSERT_EQ( expected, dst->get_data_at( j ) );
+      }
+    }
+  }
+}
+
+TEST( DataBlockTransformTests, PermuteData )
+{
+  const size_t n[ 3 ] = { NX_C, NY_C, NZ_C };
+  for ( size_t t = 0; t < NUM_TYPES_C; t++ )
+  {
+    DataBlockHandle src = createData( NX_C, NY_C, NZ_C, TYPES_C[ t ] );
+
+    // All orders of the axes, each with all combinations of inverted axes
+    const int orders[ 6 ][ 3 ] = { { 1, 2, 3 }, { 1, 3, 2 }, { 2, 1, 3 }, { 2, 3, 1 }, 
+      { 3, 1, 2 }, { 3, 2, 1 } };
+    for ( size_t o = 0; o < 6; o++ )
+    {
+      for ( int signs = 0; signs < 8; signs++ )
+      {
+        std::vector< int > permutation( 3 );
+        for ( size_t j = 0; j < 3; j++ )
+        {
+          permutation[ j ] = ( signs & ( 1 << j ) ) ? -orders[ o ][ j ] : orders[ o ][ j ];
+        }
+
+        DataBlockHandle dst;
+        ASSERT_TRUE( DataBlock::PermuteData( src, dst, permutation ) );
+        ASSERT_EQ( n[ orders[ o ][ 0 ] - 1 ], dst->get_nx() );
+        ASSERT_EQ( n[ orders[ o ][ 1 ] - 1 ], dst->get_ny() );
+        ASSERT_EQ( n[ orders[ o ][ 2 ] - 1 ], dst->get_nz() );
+
+        for ( size_t dz = 0; dz < dst->get_nz(); dz++ )
+          for ( size_t dy = 0; dy < dst->get_ny(); dy++ )
+            for ( size_t dx = 0; dx < dst->get_nx(); dx++ )
+            {
+              const size_t dst_index[ 3 ] = { dx, dy, dz };
+              size_t src_index[ 3 ];
+              for ( size_t j = 0; j < 3; j++ )
+              {
+                size_t axis = orders[ o ][ j ] - 1;
+                src_index[ axis ] = permutation[ j ] > 0 ? dst_index[ j ] : 
+                  n[ axis ] - 1 - dst_index[ j ];
+              }
+              ASSERT_EQ( src->get_data_at( src_index[ 0 ], src_index[ 1 ], src_index[ 2 ] ),
+                dst->get_data_at( dx, dy, dz ) );
+            }
+      }
+    }
+  }
+}
+
+TEST( DataBlockTransformTests, QuantizeData )
+{
+  const DataType dst_types[] = { DataType::CHAR_E, DataType::UCHAR_E, DataType::SHORT_E,
+    DataType::USHORT_E, DataType::INT_E, DataType::UINT_E };
+  for ( size_t s = 0; s < NUM_TYPES_C; s++ )
+  {
+    DataBlockHandle src = createData( NX_C, NY_C, NZ_C, TYPES_C[ s ] );
+    ASSERT_TRUE( src->update_histogram() );
+    double min = src->get_min();
+    double max = src->get_max();
+    float fmin = static_cast< float >( min );
+    float fmax = static_cast< float >( max );
+
+    for ( size_t d = 0; d < sizeof( dst_types ) / sizeof( DataType ); d++ )
+    {
+      DataBlockHandle dst;
+      ASSERT_TRUE( DataBlock::QuantizeData( src, dst, dst_types[ d ] ) );
+      for ( size_t j = 0; j < src->get_size(); j++ )
+      {
+        double value = src->get_data_at( j );
+        double expected = 0.0;
+        switch ( dst_types[ d ] )
+        {
+        case DataType::CHAR_E:
+          expected = static_cast< signed char >( static_cast< float >( 0x100 ) / ( fmax - fmin ) *
+            ( static_cast< float >( value ) - fmin ) + ( 0.5f - static_cast< float >( 0x80 ) ) );
+          break;
+        case DataType::UCHAR_E:
+          expected = static_cast< unsigned char >( static_cast< float >( 0x100 ) / ( fmax - fmin ) *
+            ( static_cast< float >( value ) - fmin ) + 0.5f );
+          break;
+        case DataType::SHORT_E:
+          expected = static_cast< short >( static_cast< float >( 0x10000 ) / ( fmax - fmin ) *
+            ( static_cast< float >( value ) - fmin ) + ( 0.5f - static_cast< float >( 0x8000 ) ) );
+          break;
+        case DataType::USHORT_E:
+          expected = static_cast< unsigned short >( static_cast< float >( 0x10000 ) / 
+            ( fmax - fmin ) * ( static_cast< float >( value ) - fmin ) + 0.5f );
+          break;
+        case DataType::INT_E:
+          expected = static_cast< int >( static_cast< double >( 0x100000000ull ) / ( max - min ) *
+            ( value - min ) + ( 0.5 - static_cast< double >( 0x80000000 ) ) );
+          break;
+        case DataType::UINT_E:
+          expected = static_cast< unsigned int >( static_cast< double >( 0x100000000ull ) / 
+            ( max - min ) * ( value - min ) + 0.5 );
+          break;
+        default:
+          break;
+        }
+        ASSERT_EQ( expected, dst->get_data_at( j ) );
+      }
+    }
+  }
+}
+
+TEST( DataBlockTransformTests, DuplicateAndSwapEndian )
+{
+  for ( size_t t = 0; t < NUM_TYPES_C; t++ )
+  {
+    DataBlockHandle src = createData( NX_C, NY_C, NZ_C, TYPES_C[ t ] );
+    DataBlockHandle dst;
+    ASSERT_TRUE( DataBlock::Duplicate( src, dst ) );
+    const size_t mem_size = src->get_size() * src->get_elem_size();
+    ASSERT_EQ( 0, std::memcmp( src->get_data(), dst->get_data(), mem_size ) );
+
+    // Every element has its bytes reversed, swapping twice restores the data
+    dst->swap_endian();
+    const size_t elem_size = src->get_elem_size();
+    const unsigned char* src_bytes = reinterpret_cast< const unsigned char* >( src->get_data() );
+    const unsigned char* dst_bytes = reinterpret_cast< const unsigned char* >( dst->get_data() );
+    for ( size_t j = 0; j < src->get_size(); j++ )
+    {
+      for ( size_t b = 0; b < elem_size; b++ )
+      {
+        ASSERT_EQ( src_bytes[ j * elem_size + b ], dst_bytes[ j * elem_size + elem_size - 1 - b ] );
+      }
+    }
+    dst->swap_endian();
+    ASSERT_EQ( 0, std::memcmp( src->get_data(), dst->get_data(), mem_size ) );
+  }
+}
+
+TEST( DataBlockTransformTests, PadAndClip )
+{
+  for ( size_t t = 0; t < NUM_TYPES_C; t++ )
+  {
+    DataBlockHandle src = createData( NX_C, NY_C, NZ_C, TYPES_C[ t ] );
+    const long long nx = NX_C, ny = NY_C, nz = NZ_C;
+
+    const int pads[] = { 3, 1, -2 };
+    for ( size_t k = 0; k < 3; k++ )
+    {
+      const long long p = pads[ k ];
+      DataBlockHandle dst;
+      ASSERT_TRUE( DataBlock::Pad( src, dst, pads[ k ], 7.0 ) );
+      ASSERT_EQ( static_cast< size_t >( nx + 2 * p ), dst->get_nx() );
+      ASSERT_EQ( static_cast< size_t >( ny + 2 * p ), dst->get_ny() );
+      ASSERT_EQ( static_cast< size_t >( nz + 2 * p ), dst->get_nz() );
+      for ( long long z = 0; z < nz + 2 * p; z++ )
+        for ( long long y = 0; y < ny + 2 * p; y++ )
+          for ( long long x = 0; x < nx + 2 * p; x++ )
+          {
+            long long sx = x - p, sy = y - p, sz = z - p;
+            double expected = ( sx < 0 || sy < 0 || sz < 0 || sx >= nx || sy >= ny || 
+              sz >= nz ) ? 7.0 : src->get_data_at( sx, sy, sz );
+            ASSERT_EQ( expected, dst->get_data_at( x, y, z ) );
+          }
+    }
+
+    // Grow and shrink each axis, also with a width and height that differ
+    const int sizes[][ 3 ] = { { 50, 30, 25 }, { 20, 11, 7 }, { 50, 11, 25 }, { 20, 30, 7 } };
+    for ( size_t k = 0; k < 4; k++ )
+    {
+      DataBlockHandle dst;
+      ASSERT_TRUE( DataBlock::Clip( src, dst, sizes[ k ][ 0 ], sizes[ k ][ 1 ], 
+        sizes[ k ][ 2 ], 5.0 ) );
+      for ( long long z = 0; z < sizes[ k ][ 2 ]; z++ )
+        for ( long long y = 0; y < sizes[ k ][ 1 ]; y++ )
+          for ( long long x = 0; x < sizes[ k ][ 0 ]; x++ )
+          {
+            double expected = ( x >= nx || y >= ny || z >= nz ) ? 5.0 : 
+              src->get_data_at( x, y, z );
+            ASSERT_EQ( expected, dst->get_data_at( x, y, z ) );
+          }
+    }
+  }
+}
@@ -0,0 +1,231 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/Histogram.h>
+
+using namespace Core;
+
+namespace
+{
+
+template< class T >
+std::vector<T> generateData( size_t size, double min, double max, unsigned int seed )
+{
+  boost::mt19937 rng( seed );
+  boost::uniform_real<> dist( min, max );
+  std::vector<T> data( size );
+  for ( size_t j = 0; j < size; j++ )
+  {
+    data[ j ] = static_cast<T>( dist( rng ) );
+  }
+  return data;
+}
+
+template< class T >
+void expectSameHistogram( const Histogram& expected, const Histogram& result )
+{
+  ASSERT_TRUE( result.is_valid() );
+  EXPECT_EQ( expected.get_min(), result.get_min() );
+  EXPECT_EQ( expected.get_max(), result.get_max() );
+  EXPECT_EQ( expected.get_bin_start(), result.get_bin_start() );
+  EXPECT_EQ( expected.get_bin_size(), result.get_bin_size() );
+  EXPECT_EQ( expected.get_min_bin(), result.get_min_bin() );
+  EXPECT_EQ( expected.get_max_bin(), result.get_max_bin() );
+  EXPECT_EQ( expected.get_bins(), result.get_bins() );
+}
+
+size_t countValues( const Histogram& histogram )
+{
+  size_t total = 0;
+  for ( size_t j = 0; j < histogram.get_size(); j++ )
+  {
+    total += histogram.get_bins()[ j ];
+  }
+  return total;
+}
+
+}
+
+TEST(HistogramTest, EmptyData)
+{
+  Histogram histogram;
+  ASSERT_FALSE( histogram.is_valid() );
+
+  std::vector<float> data;
+  ASSERT_FALSE( histogram.compute( &data[ 0 ], 0 ) );
+  ASSERT_FALSE( histogram.is_valid() );
+}
+
+TEST(HistogramTest, UnsignedCharExactBins)
+{
+  std::vector<unsigned char> data = generateData<unsigned char>( 1000000, 10.0, 200.0, 1 );
+  Histogram histogram( &data[ 0 ], data.size() );
+
+  std::vector<size_t> expected( 256, 0 );
+  for ( size_t j = 0; j < data.size(); j++ ) expected[ data[ j ] ]++;
+
+  ASSERT_TRUE( histogram.is_valid() );
+  ASSERT_EQ( histogram.get_min(), 10.0 );
+  ASSERT_EQ( histogram.get_max(), 199.0 );
+  ASSERT_EQ( histogram.get_bin_size(), 1.0 );
+  ASSERT_EQ( histogram.get_size(), 190u );
+  for ( size_t j = 0; j < histogram.get_size(); j++ )
+  {
+    ASSERT_EQ( histogram.get_bins()[ j ], expected[ j + 10 ] );
+  }
+}
+
+TEST(HistogramTest, SignedCharExactBins)
+{
+  std::vector<signed char> data = generateData<signed char>( 100000, -100.0, 100.0, 2 );
+  data[ 0 ] = -128;
+  Histogram histogram( &data[ 0 ], data.size() );
+
+  ASSERT_EQ( histogram.get_min(), -128.0 );
+  ASSERT_EQ( histogram.get_bins()[ 0 ], 1u );
+  ASSERT_EQ( countValues( histogram ), data.size() );
+}
+
+TEST(HistogramTest, ShortMatchesRebinnedCounts)
+{
+  std::vector<short> data = generateData<short>( 3000000, -1024.0, 3071.0, 3 );
+  Histogram histogram( &data[ 0 ], data.size() );
+
+  ASSERT_TRUE( histogram.is_valid() );
+  ASSERT_EQ( histogram.get_size(), 256u );
+  ASSERT_EQ( countValues( histogram ), data.size() );
+
+  // Each integer value belongs to the bin whose range contains it
+  std::vector<size_t> counts( 0x10000, 0 );
+  for ( size_t j = 0; j < data.size(); j++ ) counts[ data[ j ] + 0x8000 ]++;
+  for ( size_t j = 0; j < histogram.get_size(); j++ )
+  {
+    size_t expected = 0;
+    for ( int k = -0x8000; k < 0x8000; k++ )
+    {
+      if ( k >= histogram.get_bin_start( j ) && k < histogram.get_bin_end( j ) )
+      {
+        expected += counts[ k + 0x8000 ];
+      }
+    }
+    ASSERT_EQ( histogram.get_bins()[ j ], expected ) << "bin " << j;
+  }
+}
+
+TEST(HistogramTest, IntIncludesAllValues)
+{
+  std::vector<int> data = generateData<int>( 1000000, -100000.0, 100000.0, 4 );
+  data[ 0 ] = -200000;
+  Histogram histogram( &data[ 0 ], data.size() );
+
+  ASSERT_EQ( histogram.get_min(), -200000.0 );
+  ASSERT_EQ( histogram.get_bins()[ 0 ], 1u );
+  ASSERT_EQ( countValues( histogram ), data.size() );
+}
+
+TEST(HistogramTest, FloatSkipsNonFiniteValues)
+{
+  std::vector<float> data = generateData<float>( 2000000, -5.0, -1.0, 5 );
+  data[ 10 ] = std::numeric_limits<float>::quiet_NaN();
+  data[ 20 ] = std::numeric_limits<float>::infinity();
+  data[ 30 ] = -std::numeric_limits<float>::infinity();
+  Histogram histogram( &data[ 0 ], data.size() );
+
+  ASSERT_TRUE( histogram.is_valid() );
+  ASSERT_LT( histogram.get_max(), -1.0 );
+  ASSERT_GE( histogram.get_min(), -5.0 );
+  ASSERT_EQ( histogram.get_size(), 256u );
+  ASSERT_EQ( countValues( histogram ), data.size() - 3 );
+}
+
+TEST(HistogramTest, DoubleAllNaN)
+{
+  std::vector<double> data( 1000, std::numeric_limits<double>::quiet_NaN() );
+  Histogram histogram;
+  ASSERT_FALSE( histogram.compute( &data[ 0 ], data.size() ) );
+  ASSERT_FALSE( histogram.is_valid() );
+}
+
+TEST(HistogramTest, IncrementalUpdateMatchesCompute)
+{
+  const size_t slice_size = 256 * 256;
+  std::vector<float> data = generateData<float>( slice_size * 32, 0.0, 1000.0, 6 );
+  data[ 5 ] = -1.0f;
+  data[ 6 ] = 1001.0f;
+  Histogram histogram( &data[ 0 ], data.size() );
+
+  // Overwrite a slab in the middle with new values within the range of the data
+  std::vector<float> slab = generateData<float>( slice_size, 100.0, 900.0, 7 );
+  float* target = &data[ slice_size * 10 ];
+  ASSERT_TRUE( histogram.update( target, &slab[ 0 ], slab.size() ) );
+  std::copy( slab.begin(), slab.end(), target );
+
+  expectSameHistogram<float>( Histogram( &data[ 0 ], data.size() ), histogram );
+}
+
+TEST(HistogramTest, IncrementalUpdateExactBins)
+{
+  std::vector<unsigned short> data = generateData<unsigned short>( 100000, 0.0, 100.0, 8 );
+  Histogram histogram( &data[ 0 ], data.size() );
+  ASSERT_EQ( histogram.get_bin_size(), 1.0 );
+
+  // Removing values at the minimum is fine as long as others remain
+  std::vector<unsigned short> old_values( data.begin(), data.begin() + 1000 );
+  std::vector<unsigned short> new_values( 1000, 50 );
+  ASSERT_TRUE( histogram.update( &old_values[ 0 ], &new_values[ 0 ], old_values.size() ) );
+  std::copy( new_values.begin(), new_values.end(), data.begin() );
+
+  expectSameHistogram<unsigned short>( Histogram( &data[ 0 ], data.size() ), histogram );
+}
+
+TEST(HistogramTest, IncrementalUpdateRangeChange)
+{
+  std::vector<double> data = generateData<double>( 100000, 0.0, 1.0, 9 );
+  Histogram histogram( &data[ 0 ], data.size() );
+  std::vector<size_t> bins = histogram.get_bins();
+
+  // A new value outside the range requires a full recompute
+  std::vector<double> new_values( 1, 2.0 );
+  ASSERT_FALSE( histogram.update( &data[ 3 ], &new_values[ 0 ], 1 ) );
+  ASSERT_EQ( histogram.get_bins(), bins );
+
+  // Removing the maximum requires a full recompute as well
+  size_t max_index = std::max_element( data.begin(), data.end() ) - data.begin();
+  new_values[ 0 ] = 0.5;
+  ASSERT_FALSE( histogram.update( &data[ max_index ], &new_values[ 0 ], 1 ) );
+  ASSERT_EQ( histogram.get_bins(), bins );
+}
@@ -0,0 +1,74 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/MaskFloodFill.h>
+
+using namespace Core;
+
+TEST( MaskFloodFillBenchmarks, Throughput )
+{
+  // Fill the space around a set of random blocks from one corner
+  const size_t size = 256;
+  MaskDataBlockHandle mask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( size, size, size ), mask ) );
+  boost::mt19937 rng( 17 );
+  boost::uniform_int<> dist( 0, size - 9 );
+  for ( size_t k = 0; k < 2000; k++ )
+  {
+    size_t x0 = dist( rng ), y0 = dist( rng ), z0 = dist( rng );
+    for ( size_t z = z0; z < z0 + 8; z++ )
+      for ( size_t y = y0; y < y0 + 8; y++ )
+        for ( size_t x = x0; x < x0 + 8; x++ )
+          mask->set_mask_at( x, y, z );
+  }
+  size_t filled = 0;
+  for ( size_t j = 0; j < mask->get_size(); j++ ) filled += mask->get_mask_at( j ) ? 1 : 0;
+
+  std::vector< IndexVector > seeds( 1, IndexVector( 0, 0, 0 ) );
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+  MaskFloodFill fill( mask );
+  ASSERT_TRUE( fill.compute( seeds ) );
+  fill.apply();
+  boost::posix_time::time_duration fill_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  EXPECT_LT( 0u, fill.get_count() );
+  EXPECT_GE( mask->get_size() - filled, fill.get_count() );
+
+  std::cout << "Flood fill of " << fill.get_count() << " voxels in " << size << "^3: " <<
+    fill_time.total_milliseconds() << " ms" << std::endl;
+}
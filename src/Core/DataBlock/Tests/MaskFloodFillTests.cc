@@ -0,0 +1,265 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/DataBlockManager.h>
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/MaskFloodFill.h>
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+namespace
+{
+
+const size_t NX_C = 70;
+const size_t NY_C = 29;
+const size_t NZ_C = 23;
+
+// Create a mask with a random fraction of its voxels set
+MaskDataBlockHandle createRandomMask( unsigned int seed, double fraction )
+{
+  MaskDataBlockHandle mask;
+  MaskDataBlockManager::Create( GridTransform( NX_C, NY_C, NZ_C ), mask );
+  boost::mt19937 rng( seed );
+  boost::uniform_01<> dist;
+  for ( size_t j = 0; j < mask->get_size(); j++ )
+  {
+    if ( dist( rng ) < fraction ) mask->set_mask_at( j );
+  }
+  return mask;
+}
+
+// Voxel by voxel flood fill through the faces of the voxels
+std::vector< bool > referenceFill( const MaskDataBlockHandle& mask, bool erase, 
+  const DataBlockHandle& data, double min_val, double max_val, bool negative_data,
+  const std::vector< MaskDataBlockHandle >& cstrs, const std::vector< bool >& negative_cstrs,
+  const std::vector< IndexVector >& seeds )
+{
+  const size_t nx = mask->get_nx();
+  const size_t ny = mask->get_ny();
+  const size_t nz = mask->get_nz();
+  std::vector< bool > result( mask->get_size() );
+  std::vector< bool > fillable( mask->get_size() );
+  for ( size_t j = 0; j < mask->get_size(); j++ )
+  {
+    result[ j ] = mask->get_mask_at( j );
+    bool ok = result[ j ] == erase;
+    if ( data )
+    {
+      double value = data->get_data_at( j );
+      ok = ok && ( ( value >= min_val && value <= max_val ) != negative_data );
+    }
+    for ( size_t k = 0; k < cstrs.size(); k++ )
+    {
+      ok = ok && ( cstrs[ k ]->get_mask_at( j ) != negative_cstrs[ k ] );
+    }
+    fillable[ j ] = ok;
+  }
+
+  std::deque< size_t > queue;
+  for ( size_t k = 0; k < seeds.size(); k++ )
+  {
+    if ( seeds[ k ].x() >= static_cast< IndexVector::index_type >( nx ) ) continue;
+    size_t j = mask->to_index( seeds[ k ].x(), seeds[ k ].y(), seeds[ k ].z() );
+    if ( fillable[ j ] )
+    {
+      fillable[ j ] = false;
+      queue.push_back( j );
+    }
+  }
+
+  while ( !queue.empty() )
+  {
+    size_t j = queue.front();
+    queue.pop_front();
+    result[ j ] = !erase;
+    size_t x = j % nx, y = ( j / nx ) % ny, z = j / ( nx * ny );
+    std::vector< size_t > neighbors;
+    if ( x > 0 ) neighbors.push_back( j - 1 );
+    if ( x + 1 < nx ) neighbors.push_back( j + 1 );
+    if ( y > 0 ) neighbors.push_back( j - nx );
+    if ( y + 1 < ny ) neighbors.push_back( j + nx );
+    if ( z > 0 ) neighbors.push_back( j - nx * ny );
+    if ( z + 1 < nz ) neighbors.push_back( j + nx * ny );
+    for ( size_t n = 0; n < neighbors.size(); n++ )
+    {
+      if ( fillable[ neighbors[ n ] ] )
+      {
+        fillable[ neighbors[ n ] ] = false;
+        queue.push_back( neighbors[ n ] );
+      }
+    }
+  }
+
+  return result;
+}
+
+} // end anonymous namespace
+
+TEST( MaskFloodFillTests, MatchesReferenceFill )
+{
+  MaskDataBlockHandle mask;
+  MaskDataBlockHandle cstr1 = createRandomMask( 5, 0.8 );
+  MaskDataBlockHandle cstr2 = createRandomMask( 7, 0.1 );
+
+  DataBlockHandle data = StdDataBlock::New( NX_C, NY_C, NZ_C, DataType::SHORT_E );
+  boost::mt19937 rng( 13 );
+  boost::uniform_int<> dist( -50, 50 );
+  for ( size_t j = 0; j < data->get_size(); j++ ) data->set_data_at( j, dist( rng ) );
+
+  std::vector< IndexVector > seeds;
+  seeds.push_back( IndexVector( 0, 0, 0 ) );
+  seeds.push_back( IndexVector( 35, 14, 11 ) );
+  seeds.push_back( IndexVector( 69, 28, 22 ) );
+  seeds.push_back( IndexVector( 100, 0, 0 ) );
+  boost::uniform_int<> dist_x( 0, NX_C - 1 );
+  boost::uniform_int<> dist_y( 0, NY_C - 1 );
+  boost::uniform_int<> dist_z( 0, NZ_C - 1 );
+  for ( size_t k = 0; k < 8; k++ )
+  {
+    seeds.push_back( IndexVector( dist_x( rng ), dist_y( rng ), dist_z( rng ) ) );
+  }
+
+  std::vector< MaskDataBlockHandle > no_cstrs;
+  std::vector< bool > no_negative;
+  std::vector< MaskDataBlockHandle > cstrs;
+  cstrs.push_back( cstr1 );
+  cstrs.push_back( cstr2 );
+  std::vector< bool > negative;
+  negative.push_back( false );
+  negative.push_back( true );
+
+  // The constraint masks share the data block with the mask that is filled
+  std::vector< bool > cstr1_bits;
+  for ( size_t j = 0; j < cstr1->get_size(); j++ ) cstr1_bits.push_back( cstr1->get_mask_at( j ) );
+
+  for ( int test = 0; test < 6; test++ )
+  {
+    SCOPED_TRACE( test );
+    bool erase = test >= 3;
+    bool use_data = test % 3 != 0;
+    bool use_cstrs = test % 3 == 2;
+
+    // Erasing starts from a mask of which the set voxels are connected
+    mask = createRandomMask( 3 + test, erase ? 0.7 : 0.15 );
+    std::vector< bool > expected = referenceFill( mask, erase, 
+      use_data ? data : DataBlockHandle(), -40, 40, test == 4, 
+      use_cstrs ? cstrs : no_cstrs, use_cstrs ? negative : no_negative, seeds );
+
+    MaskFloodFill fill( mask, erase );
+    if ( use_data ) fill.set_data_constraint( data, -40, 40, test == 4 );
+    if ( use_cstrs )
+    {
+      fill.add_mask_constraint( cstr1, false );
+      fill.add_mask_constraint( cstr2, true );
+    }
+    ASSERT_TRUE( fill.compute( seeds ) );
+
+    // Nothing is written before the fill is applied
+    size_t changed = 0;
+    size_t min_z = NZ_C, max_z = 0;
+    for ( size_t j = 0; j < expected.size(); j++ )
+    {
+      if ( expected[ j ] == mask->get_mask_at( j ) ) continue;
+      changed++;
+      min_z = std::min( min_z, j / ( NX_C * NY_C ) );
+      max_z = std::max( max_z, j / ( NX_C * NY_C ) );
+    }
+    ASSERT_LT( 0u, changed );
+    EXPECT_EQ( changed, fill.get_count() );
+    size_t fill_min_z, fill_max_z;
+    ASSERT_TRUE( fill.get_z_range( fill_min_z, fill_max_z ) );
+    EXPECT_EQ( min_z, fill_min_z );
+    EXPECT_EQ( max_z, fill_max_z );
+
+    fill.apply();
+    for ( size_t j = 0; j < expected.size(); j++ )
+    {
+      ASSERT_EQ( expected[ j ], mask->get_mask_at( j ) );
+    }
+  }
+
+  for ( size_t j = 0; j < cstr1->get_size(); j++ )
+  {
+    ASSERT_EQ( cstr1_bits[ j ], cstr1->get_mask_at( j ) );
+  }
+}
+
+TEST( MaskFloodFillTests, StopsAtFilledVoxels )
+{
+  MaskDataBlockHandle mask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( NX_C, NY_C, NZ_C ), mask ) );
+  if ( mask->get_generation() == -1 )
+  {
+    DataBlockManager::Instance()->register_datablock( mask->get_data_block() );
+  }
+
+  // A wall at z = 9 keeps the fill within the slices below it
+  for ( size_t y = 0; y < NY_C; y++ )
+  {
+    for ( size_t x = 0; x < NX_C; x++ ) mask->set_mask_at( x, y, 9 );
+  }
+  mask->increase_generation();
+  DataBlock::generation_type generation = mask->get_generation();
+
+  std::vector< IndexVector > seeds( 1, IndexVector( 5, 6, 4 ) );
+  MaskFloodFill fill( mask );
+  ASSERT_TRUE( fill.compute( seeds ) );
+  EXPECT_EQ( NX_C * NY_C * 9, fill.get_count() );
+  size_t min_z, max_z;
+  ASSERT_TRUE( fill.get_z_range( min_z, max_z ) );
+  EXPECT_EQ( 0u, min_z );
+  EXPECT_EQ( 8u, max_z );
+
+  fill.apply();
+  for ( size_t z = 0; z < NZ_C; z++ )
+  {
+    EXPECT_EQ( z <= 9, mask->get_mask_at( NX_C - 1, NY_C - 1, z ) );
+    if ( z <= 8 )
+    {
+      EXPECT_LT( generation, mask->get_slice_generation( z ) );
+    }
+    else
+    {
+      EXPECT_EQ( generation, mask->get_slice_generation( z ) );
+    }
+  }
+
+  // A seed on a filled voxel does not fill anything
+  MaskFloodFill refill( mask );
+  ASSERT_TRUE( refill.compute( seeds ) );
+  EXPECT_EQ( 0u, refill.get_count() );
+  EXPECT_FALSE( refill.get_z_range( min_z, max_z ) );
+}
@@ -0,0 +1,87 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+TEST( MaskLabelBenchmarks, Throughput )
+{
+  // Compare writing a label map one mask at a time with writing it in a single pass
+  const size_t size = 160;
+  const size_t num_masks = 64;
+  GridTransform grid_transform( size, size, size );
+  std::vector< MaskDataBlockHandle > masks( num_masks );
+  std::vector< double > labels( num_masks );
+  for ( size_t k = 0; k < num_masks; k++ )
+  {
+    ASSERT_TRUE( MaskDataBlockManager::Create( grid_transform, masks[ k ] ) );
+    for ( size_t j = k; j < masks[ k ]->get_size(); j += num_masks + k ) masks[ k ]->set_mask_at( j );
+    labels[ k ] = static_cast< double >( k + 1 );
+  }
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+  DataBlockHandle sequential = StdDataBlock::New( size, size, size, DataType::USHORT_E );
+  sequential->clear();
+  for ( size_t k = 0; k < num_masks; k++ )
+  {
+    MaskDataBlockManager::Inscribe( masks[ k ], sequential, labels[ k ] );
+  }
+  boost::posix_time::time_duration sequential_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  start = boost::posix_time::microsec_clock::local_time();
+  DataBlockHandle fused = StdDataBlock::New( size, size, size, DataType::USHORT_E );
+  ASSERT_TRUE( MaskDataBlockManager::InscribeLabels( masks, labels, 0.0, fused ) );
+  boost::posix_time::time_duration fused_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  start = boost::posix_time::microsec_clock::local_time();
+  std::vector< MaskDataBlockHandle > decoded;
+  ASSERT_TRUE( MaskDataBlockManager::CreateMaskFromLabelData( fused, grid_transform, decoded ) );
+  boost::posix_time::time_duration decode_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  for ( size_t j = 0; j < fused->get_size(); j++ )
+  {
+    ASSERT_EQ( sequential->get_data_at( j ), fused->get_data_at( j ) );
+  }
+
+  std::cout << num_masks << " masks of " << size << "^3: one pass per mask " << 
+    sequential_time.total_milliseconds() << " ms, single pass " << 
+    fused_time.total_milliseconds() << " ms, decoding 32 labels " << 
+    decode_time.total_milliseconds() << " ms" << std::endl;
+}
@@ -0,0 +1,206 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+namespace
+{
+
+const size_t NX_C = 41;
+const size_t NY_C = 23;
+const size_t NZ_C = 17;
+
+// Create masks covering random boxes, which overlap each other
+void createMasks( size_t num_masks, unsigned int seed, std::vector< MaskDataBlockHandle >& masks )
+{
+  boost::mt19937 rng( seed );
+  boost::uniform_int<> dist_x( 0, NX_C - 1 );
+  boost::uniform_int<> dist_y( 0, NY_C - 1 );
+  boost::uniform_int<> dist_z( 0, NZ_C - 1 );
+
+  masks.resize( num_masks );
+  for ( size_t k = 0; k < num_masks; k++ )
+  {
+    ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( NX_C, NY_C, NZ_C ), masks[ k ] ) );
+    size_t x0 = dist_x( rng ), x1 = dist_x( rng ), y0 = dist_y( rng ), y1 = dist_y( rng );
+    size_t z0 = dist_z( rng ), z1 = dist_z( rng );
+    for ( size_t z = std::min( z0, z1 ); z <= std::max( z0, z1 ); z++ )
+      for ( size_t y = std::min( y0, y1 ); y <= std::max( y0, y1 ); y++ )
+        for ( size_t x = std::min( x0, x1 ); x <= std::max( x0, x1 ); x++ )
+          masks[ k ]->set_mask_at( x, y, z );
+  }
+}
+
+// The label map as it was written by inscribing the masks one after another
+DataBlockHandle referenceLabels( const std::vector< MaskDataBlockHandle >& masks, 
+  const std::vector< double >& labels, double background, DataType data_type )
+{
+  DataBlockHandle data = StdDataBlock::New( NX_C, NY_C, NZ_C, data_type );
+  data->clear();
+  MaskDataBlockManager::Inscribe( masks[ 0 ], data, background, true );
+  for ( size_t k = 0; k < masks.size(); k++ )
+  {
+    MaskDataBlockManager::Inscribe( masks[ k ], data, labels[ k ] );
+  }
+  return data;
+}
+
+} // end anonymous namespace
+
+TEST( MaskLabelTests, InscribeLabelsMatchesSequentialInscribe )
+{
+  std::vector< MaskDataBlockHandle > masks;
+  createMasks( 21, 11, masks );
+  std::vector< double > labels;
+  for ( size_t k = 0; k < masks.size(); k++ ) labels.push_back( 3.0 * k + 1.0 );
+
+  DataBlockHandle reference = referenceLabels( masks, labels, 0.0, DataType::USHORT_E );
+
+  DataBlockHandle data = StdDataBlock::New( NX_C, NY_C, NZ_C, DataType::USHORT_E );
+  ASSERT_TRUE( MaskDataBlockManager::InscribeLabels( masks, labels, 0.0, data ) );
+  for ( size_t j = 0; j < data->get_size(); j++ )
+  {
+    ASSERT_EQ( reference->get_data_at( j ), data->get_data_at( j ) );
+  }
+
+  // A float label map with another background
+  data = StdDataBlock::New( NX_C, NY_C, NZ_C, DataType::FLOAT_E );
+  ASSERT_TRUE( MaskDataBlockManager::InscribeLabels( masks, labels, -2.5, data ) );
+  for ( size_t j = 0; j < data->get_size(); j++ )
+  {
+    double expected = -2.5;
+    for ( size_t k = 0; k < masks.size(); k++ )
+    {
+      if ( masks[ k ]->get_mask_at( j ) ) expected = labels[ k ];
+    }
+    ASSERT_EQ( expected, data->get_data_at( j ) );
+  }
+
+  // Mismatching sizes are rejected
+  labels.pop_back();
+  EXPECT_FALSE( MaskDataBlockManager::InscribeLabels( masks, labels, 0.0, data ) );
+}
+
+TEST( MaskLabelTests, CreateMaskFromLabelDataRoundTrip )
+{
+  // Masks that are in use keep their bits, including one next to a released bit-plane
+  std::vector< MaskDataBlockHandle > existing;
+  createMasks( 3, 5, existing );
+  std::vector< std::vector< bool > > existing_bits( existing.size() );
+  for ( size_t k = 0; k < existing.size(); k++ )
+  {
+    for ( size_t j = 0; j < existing[ k ]->get_size(); j++ )
+    {
+      existing_bits[ k ].push_back( existing[ k ]->get_mask_at( j ) );
+    }
+  }
+  existing[ 1 ].reset();
+
+  std::vector< MaskDataBlockHandle > masks;
+  createMasks( 12, 23, masks );
+  std::vector< double > labels;
+  for ( size_t k = 0; k < masks.size(); k++ ) labels.push_back( 100.0 + 7.0 * k );
+  DataBlockHandle data = StdDataBlock::New( NX_C, NY_C, NZ_C, DataType::INT_E );
+  ASSERT_TRUE( MaskDataBlockManager::InscribeLabels( masks, labels, 0.0, data ) );
+  masks.clear();
+
+  std::vector< int > original( reinterpret_cast< int* >( data->get_data() ),
+    reinterpret_cast< int* >( data->get_data() ) + data->get_size() );
+
+  std::vector< MaskDataBlockHandle > decoded;
+  ASSERT_TRUE( MaskDataBlockManager::CreateMaskFromLabelData( data, 
+    GridTransform( NX_C, NY_C, NZ_C ), decoded ) );
+
+  // The labels in order of their first occurrence
+  std::vector< int > order;
+  for ( size_t j = 0; j < original.size(); j++ )
+  {
+    if ( original[ j ] != 0 && std::find( order.begin(), order.end(), original[ j ] ) == 
+      order.end() )
+    {
+      order.push_back( original[ j ] );
+    }
+  }
+
+  ASSERT_EQ( order.size(), decoded.size() );
+  for ( size_t k = 0; k < decoded.size(); k++ )
+  {
+    for ( size_t j = 0; j < original.size(); j++ )
+    {
+      ASSERT_EQ( original[ j ] == order[ k ], decoded[ k ]->get_mask_at( j ) );
+    }
+  }
+
+  // The label data is left untouched
+  for ( size_t j = 0; j < original.size(); j++ )
+  {
+    ASSERT_EQ( original[ j ], reinterpret_cast< int* >( data->get_data() )[ j ] );
+  }
+
+  for ( size_t k = 0; k < existing.size(); k++ )
+  {
+    if ( !existing[ k ] ) continue;
+    for ( size_t j = 0; j < existing[ k ]->get_size(); j++ )
+    {
+      ASSERT_EQ( existing_bits[ k ][ j ], existing[ k ]->get_mask_at( j ) );
+    }
+  }
+}
+
+TEST( MaskLabelTests, CreateMaskFromLabelDataLimit )
+{
+  // Only the first 32 labels are extracted
+  DataBlockHandle data = StdDataBlock::New( NX_C, NY_C, NZ_C, DataType::SHORT_E );
+  short* data_ptr = reinterpret_cast< short* >( data->get_data() );
+  for ( size_t j = 0; j < data->get_size(); j++ )
+  {
+    data_ptr[ j ] = static_cast< short >( 50 - static_cast< int >( ( j / 11 ) % 50 ) );
+  }
+
+  std::vector< MaskDataBlockHandle > decoded;
+  ASSERT_TRUE( MaskDataBlockManager::CreateMaskFromLabelData( data, 
+    GridTransform( NX_C, NY_C, NZ_C ), decoded ) );
+  ASSERT_EQ( 32u, decoded.size() );
+  for ( size_t k = 0; k < decoded.size(); k++ )
+  {
+    for ( size_t j = 0; j < data->get_size(); j++ )
+    {
+      ASSERT_EQ( data_ptr[ j ] == 50 - static_cast< int >( k ), decoded[ k ]->get_mask_at( j ) );
+    }
+  }
+}
@@ -0,0 +1,280 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/MaskMorphology.h>
+
+using namespace Core;
+
+namespace
+{
+
+const int NX_C = 23;
+const int NY_C = 17;
+const int NZ_C = 13;
+
+typedef std::vector< char > volume_type;
+
+size_t index( int x, int y, int z )
+{
+  return ( static_cast< size_t >( z ) * NY_C + y ) * NX_C + x;
+}
+
+volume_type generateVolume( double fraction, unsigned int seed )
+{
+  boost::mt19937 rng( seed );
+  boost::uniform_real<> dist( 0.0, 1.0 );
+  volume_type volume( NX_C * NY_C * NZ_C );
+  for ( size_t j = 0; j < volume.size(); j++ )
+  {
+    volume[ j ] = dist( rng ) < fraction;
+  }
+  return volume;
+}
+
+MaskDataBlockHandle createMask( const volume_type& volume )
+{
+  MaskDataBlockHandle mask;
+  if ( !MaskDataBlockManager::Create( GridTransform( NX_C, NY_C, NZ_C ), mask ) ) return mask;
+
+  MaskDataBlock::lock_type lock( mask->get_mutex() );
+  unsigned char* data = mask->get_mask_data();
+  unsigned char value = mask->get_mask_value();
+  for ( size_t j = 0; j < volume.size(); j++ )
+  {
+    if ( volume[ j ] ) data[ j ] |= value;
+    else data[ j ] &= ~value;
+  }
+  return mask;
+}
+
+volume_type readMask( const MaskDataBlockHandle& mask )
+{
+  volume_type volume( mask->get_size() );
+  for ( size_t j = 0; j < volume.size(); j++ )
+  {
+    volume[ j ] = ( mask->get_mask_data()[ j ] & mask->get_mask_value() ) != 0;
+  }
+  return volume;
+}
+
+bool isAllowed( const volume_type& constraint, bool invert, size_t j )
+{
+  if ( constraint.empty() ) return true;
+  return ( constraint[ j ] != 0 ) != invert;
+}
+
+// Whether an offset lies in the plane of the slice type
+bool inPlane( bool only2d, SliceType slice_type, int dx, int dy, int dz )
+{
+  if ( !only2d ) return true;
+  if ( slice_type == SliceType::AXIAL_E ) return dz == 0;
+  if ( slice_type == SliceType::CORONAL_E ) return dy == 0;
+  return dx == 0;
+}
+
+// Stamp the structuring element at every voxel of the set that is grown
+volume_type referenceBall( const volume_type& input, bool dilate, int squared_radius, 
+  const volume_type& constraint, bool invert, bool only2d, SliceType slice_type )
+{
+  volume_type output( input );
+  int r = 0;
+  while ( ( r + 1 ) * ( r + 1 ) <= squared_radius ) r++;
+
+  for ( int z = 0; z < NZ_C; z++ )
+  for ( int y = 0; y < NY_C; y++ )
+  for ( int x = 0; x < NX_C; x++ )
+  {
+    size_t j = index( x, y, z );
+    if ( ( input[ j ] != 0 ) == dilate || !isAllowed( constraint, invert, j ) ) continue;
+
+    bool reached = false;
+    for ( int dz = -r; dz <= r && !reached; dz++ )
+    for ( int dy = -r; dy <= r && !reached; dy++ )
+    for ( int dx = -r; dx <= r && !reached; dx++ )
+    {
+      if ( dx * dx + dy * dy + dz * dz > squared_radius ) continue;
+      if ( !inPlane( only2d, slice_type, dx, dy, dz ) ) continue;
+      int px = x + dx, py = y + dy, pz = z + dz;
+      if ( px < 0 || py < 0 || pz < 0 || px >= NX_C || py >= NY_C || pz >= NZ_C ) continue;
+      if ( ( input[ index( px, py, pz ) ] != 0 ) == dilate ) reached = true;
+    }
+    if ( reached ) output[ j ] = dilate;
+  }
+  return output;
+}
+
+// Grow the set one 18-neighborhood step at a time, without passing through voxels that may 
+// not change
+volume_type referenceSteps( const volume_type& input, bool dilate, int steps, 
+  const volume_type& constraint, bool invert, bool only2d, SliceType slice_type )
+{
+  volume_type grown( input.size() );
+  for ( size_t j = 0; j < input.size(); j++ ) grown[ j ] = ( input[ j ] != 0 ) == dilate;
+
+  for ( int step = 0; step < steps; step++ )
+  {
+    volume_type next( grown );
+    for ( int z = 0; z < NZ_C; z++ )
+    for ( int y = 0; y < NY_C; y++ )
+    for ( int x = 0; x < NX_C; x++ )
+    {
+      size_t j = index( x, y, z );
+      if ( grown[ j ] || !isAllowed( constraint, invert, j ) ) continue;
+      for ( int dz = -1; dz <= 1; dz++ )
+      for ( int dy = -1; dy <= 1; dy++ )
+      for ( int dx = -1; dx <= 1; dx++ )
+      {
+        int d = dx * dx + dy * dy + dz * dz;
+        if ( d == 0 || d == 3 || !inPlane( only2d, slice_type, dx, dy, dz ) ) continue;
+        int px = x + dx, py = y + dy, pz = z + dz;
+        if ( px < 0 || py < 0 || pz < 0 || px >= NX_C || py >= NY_C || pz >= NZ_C ) continue;
+        if ( grown[ index( px, py, pz ) ] ) next[ j ] = 1;
+      }
+    }
+    grown.swap( next );
+  }
+
+  volume_type output( input.size() );
+  for ( size_t j = 0; j < input.size(); j++ ) output[ j ] = grown[ j ] == dilate;
+  return output;
+}
+
+volume_type runMorphology( const volume_type& input, bool dilate, bool steps, int radius, 
+  MaskMorphology::ball_type ball, const volume_type& constraint, bool invert, bool only2d, 
+  SliceType slice_type )
+{
+  MaskMorphology morphology;
+  EXPECT_TRUE( morphology.set_input( createMask( input ) ) );
+  if ( !constraint.empty() ) morphology.set_constraint( createMask( constraint ), invert );
+  morphology.set_slice_type( only2d, slice_type );
+
+  bool success = false;
+  if ( steps ) success = dilate ? morphology.dilate_steps( radius ) : 
+    morphology.erode_steps( radius );
+  else success = dilate ? morphology.dilate( radius, ball ) : morphology.erode( radius, ball );
+  EXPECT_TRUE( success );
+
+  MaskDataBlockHandle output;
+  EXPECT_TRUE( morphology.get_output( GridTransform( NX_C, NY_C, NZ_C ), output ) );
+  return readMask( output );
+}
+
+bool alwaysAbort()
+{
+  return true;
+}
+
+} // end anonymous namespace
+
+TEST(MaskMorphologyTests, BallMatchesReference)
+{
+  volume_type input = generateVolume( 0.02, 1 );
+  volume_type no_constraint;
+
+  for ( int radius = 0; radius <= 4; radius++ )
+  {
+    for ( int dilate = 0; dilate < 2; dilate++ )
+    {
+      volume_type source = dilate ? input : generateVolume( 0.98, radius + 2 );
+      EXPECT_EQ( referenceBall( source, dilate != 0, radius * radius, no_constraint, false, 
+        false, SliceType::AXIAL_E ), runMorphology( source, dilate != 0, false, radius, 
+        MaskMorphology::BALL_E, no_constraint, false, false, SliceType::AXIAL_E ) ) 
+        << "radius " << radius << " dilate " << dilate;
+      EXPECT_EQ( referenceBall( source, dilate != 0, radius * radius + radius, no_constraint, 
+        false, false, SliceType::AXIAL_E ), runMorphology( source, dilate != 0, false, radius, 
+        MaskMorphology::ROUNDED_BALL_E, no_constraint, false, false, SliceType::AXIAL_E ) ) 
+        << "radius " << radius << " dilate " << dilate;
+    }
+  }
+}
+
+TEST(MaskMorphologyTests, BallWithConstraintIn2D)
+{
+  volume_type input = generateVolume( 0.05, 7 );
+  volume_type constraint = generateVolume( 0.5, 8 );
+
+  for ( int slice_type = 0; slice_type < 3; slice_type++ )
+  {
+    SliceType type = static_cast< SliceType::enum_type >( slice_type );
+    for ( int invert = 0; invert < 2; invert++ )
+    {
+      for ( int dilate = 0; dilate < 2; dilate++ )
+      {
+        EXPECT_EQ( referenceBall( input, dilate != 0, 9, constraint, invert != 0, true, type ),
+          runMorphology( input, dilate != 0, false, 3, MaskMorphology::BALL_E, constraint, 
+          invert != 0, true, type ) ) << "slice type " << slice_type;
+      }
+    }
+  }
+}
+
+TEST(MaskMorphologyTests, StepsMatchReference)
+{
+  volume_type input = generateVolume( 0.01, 3 );
+  volume_type constraint = generateVolume( 0.8, 4 );
+  volume_type no_constraint;
+
+  for ( int steps = 1; steps <= 5; steps += 2 )
+  {
+    for ( int dilate = 0; dilate < 2; dilate++ )
+    {
+      volume_type source = dilate ? input : generateVolume( 0.97, steps );
+      EXPECT_EQ( referenceSteps( source, dilate != 0, steps, no_constraint, false, false, 
+        SliceType::AXIAL_E ), runMorphology( source, dilate != 0, true, steps, 
+        MaskMorphology::BALL_E, no_constraint, false, false, SliceType::AXIAL_E ) );
+      EXPECT_EQ( referenceSteps( source, dilate != 0, steps, constraint, false, false, 
+        SliceType::AXIAL_E ), runMorphology( source, dilate != 0, true, steps, 
+        MaskMorphology::BALL_E, constraint, false, false, SliceType::AXIAL_E ) );
+
+      for ( int slice_type = 0; slice_type < 3; slice_type++ )
+      {
+        SliceType type = static_cast< SliceType::enum_type >( slice_type );
+        EXPECT_EQ( referenceSteps( source, dilate != 0, steps, constraint, true, true, type ),
+          runMorphology( source, dilate != 0, true, steps, MaskMorphology::BALL_E, 
+          constraint, true, true, type ) ) << "slice type " << slice_type;
+      }
+    }
+  }
+}
+
+TEST(MaskMorphologyTests, AbortStopsOperation)
+{
+  MaskMorphology morphology;
+  ASSERT_TRUE( morphology.set_input( createMask( generateVolume( 0.1, 5 ) ) ) );
+  morphology.set_abort_function( &alwaysAbort );
+  EXPECT_FALSE( morphology.dilate( 2 ) );
+  EXPECT_FALSE( morphology.erode_steps( 2 ) );
+}
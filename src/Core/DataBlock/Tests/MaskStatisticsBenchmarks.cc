@@ -0,0 +1,96 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <Core/DataBlock/DataBlockManager.h>
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/MaskStatistics.h>
+
+using namespace Core;
+
+namespace
+{
+
+// Create a mask and register its data block, as the mask volumes do, so it has a valid generation
+void createMask( size_t nx, size_t ny, size_t nz, MaskDataBlockHandle& mask )
+{
+  ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( nx, ny, nz ), mask ) );
+  if ( mask->get_generation() == -1 )
+  {
+    DataBlockManager::Instance()->register_datablock( mask->get_data_block() );
+  }
+  ASSERT_NE( -1, mask->get_generation() );
+}
+
+}
+
+TEST( MaskStatisticsBenchmarks, Throughput )
+{
+  // Compare counting voxel by voxel with the cached statistics
+  const size_t size = 256;
+  MaskDataBlockHandle mask;
+  createMask( size, size, size, mask );
+  for ( size_t z = size / 4; z < 3 * size / 4; z++ )
+    for ( size_t y = size / 4; y < 3 * size / 4; y++ )
+      for ( size_t x = size / 4; x < 3 * size / 4; x++ )
+        if ( ( x + y + z ) % 3 ) mask->set_mask_at( x, y, z );
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+  size_t count = 0;
+  for ( size_t j = 0; j < mask->get_size(); j++ )
+  {
+    if ( mask->get_mask_at( j ) ) count++;
+  }
+  boost::posix_time::time_duration voxel_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  MaskStatistics statistics;
+  start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( statistics.update( mask ) );
+  boost::posix_time::time_duration full_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+  ASSERT_EQ( count, statistics.get_count() );
+
+  mask->set_mask_at( 1, 1, size / 2 );
+  mask->increase_generation( SliceType::AXIAL_E, size / 2 );
+  start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( statistics.update( mask ) );
+  boost::posix_time::time_duration slice_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+  ASSERT_EQ( count + 1, statistics.get_count() );
+
+  std::cout << "Mask of " << size << "^3: voxel by voxel " << 
+    voxel_time.total_microseconds() << " us, all slices " << 
+    full_time.total_microseconds() << " us, one modified slice " << 
+    slice_time.total_microseconds() << " us" << std::endl;
+}
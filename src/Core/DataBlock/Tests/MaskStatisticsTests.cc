@@ -0,0 +1,222 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/DataBlockManager.h>
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/MaskStatistics.h>
+
+using namespace Core;
+
+namespace
+{
+
+const size_t NX_C = 43;
+const size_t NY_C = 29;
+const size_t NZ_C = 19;
+
+// Create a mask and register its data block, as the mask volumes do, so it has a valid generation
+void createMask( size_t nx, size_t ny, size_t nz, MaskDataBlockHandle& mask )
+{
+  ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( nx, ny, nz ), mask ) );
+  if ( mask->get_generation() == -1 )
+  {
+    DataBlockManager::Instance()->register_datablock( mask->get_data_block() );
+  }
+  ASSERT_NE( -1, mask->get_generation() );
+}
+
+// Set random voxels within a random box of the mask
+void fillMask( MaskDataBlockHandle mask, boost::mt19937& rng )
+{
+  boost::uniform_int<> dist_x( 0, static_cast< int >( mask->get_nx() ) - 1 );
+  boost::uniform_int<> dist_y( 0, static_cast< int >( mask->get_ny() ) - 1 );
+  boost::uniform_int<> dist_z( 0, static_cast< int >( mask->get_nz() ) - 1 );
+  boost::uniform_int<> dist_p( 0, 3 );
+
+  size_t x0 = dist_x( rng ), x1 = dist_x( rng ), y0 = dist_y( rng ), y1 = dist_y( rng );
+  size_t z0 = dist_z( rng ), z1 = dist_z( rng );
+  for ( size_t z = std::min( z0, z1 ); z <= std::max( z0, z1 ); z++ )
+    for ( size_t y = std::min( y0, y1 ); y <= std::max( y0, y1 ); y++ )
+      for ( size_t x = std::min( x0, x1 ); x <= std::max( x0, x1 ); x++ )
+        if ( dist_p( rng ) == 0 ) mask->set_mask_at( x, y, z );
+}
+
+// Compare the statistics with the ones computed voxel by voxel
+void checkStatistics( MaskDataBlockHandle mask, const MaskStatistics& statistics )
+{
+  size_t count = 0;
+  std::vector< size_t > slice_counts( mask->get_nz(), 0 );
+  IndexVector min( mask->get_nx(), mask->get_ny(), mask->get_nz() );
+  IndexVector max( 0, 0, 0 );
+  double sum_x = 0.0, sum_y = 0.0, sum_z = 0.0;
+  for ( size_t z = 0; z < mask->get_nz(); z++ )
+    for ( size_t y = 0; y < mask->get_ny(); y++ )
+      for ( size_t x = 0; x < mask->get_nx(); x++ )
+      {
+        if ( !mask->get_mask_at( x, y, z ) ) continue;
+        count++;
+        slice_counts[ z ]++;
+        IndexVector index( x, y, z );
+        for ( size_t k = 0; k < 3; k++ )
+        {
+          min[ k ] = std::min( min[ k ], index[ k ] );
+          max[ k ] = std::max( max[ k ], index[ k ] );
+        }
+        sum_x += x; sum_y += y; sum_z += z;
+      }
+
+  EXPECT_EQ( count, statistics.get_count() );
+  EXPECT_EQ( slice_counts, statistics.get_slice_counts() );
+
+  IndexVector stat_min, stat_max;
+  Point centroid;
+  ASSERT_EQ( count > 0, statistics.get_bounding_box( stat_min, stat_max ) );
+  ASSERT_EQ( count > 0, statistics.get_centroid( centroid ) );
+  if ( count == 0 ) return;
+
+  EXPECT_EQ( min, stat_min );
+  EXPECT_EQ( max, stat_max );
+  EXPECT_NEAR( sum_x / count, centroid.x(), 1e-9 );
+  EXPECT_NEAR( sum_y / count, centroid.y(), 1e-9 );
+  EXPECT_NEAR( sum_z / count, centroid.z(), 1e-9 );
+}
+
+bool abortNow()
+{
+  return true;
+}
+
+} // end anonymous namespace
+
+TEST( MaskStatisticsTests, MatchesVoxelCount )
+{
+  boost::mt19937 rng( 5 );
+  for ( size_t k = 0; k < 10; k++ )
+  {
+    // Masks sharing a data block, with rows that are not a multiple of eight voxels long
+    MaskDataBlockHandle mask;
+    createMask( NX_C, NY_C, NZ_C, mask );
+    fillMask( mask, rng );
+
+    MaskStatistics statistics;
+    ASSERT_TRUE( statistics.update( mask ) );
+    checkStatistics( mask, statistics );
+  }
+}
+
+TEST( MaskStatisticsTests, EmptyAndSingleVoxel )
+{
+  MaskDataBlockHandle mask;
+  createMask( NX_C, NY_C, NZ_C, mask );
+
+  MaskStatistics statistics;
+  ASSERT_TRUE( statistics.update( mask ) );
+  checkStatistics( mask, statistics );
+
+  // Voxels in the last column are handled by the remainder of the rows
+  mask->set_mask_at( NX_C - 1, NY_C - 1, NZ_C - 1 );
+  mask->increase_generation();
+  ASSERT_TRUE( statistics.update( mask ) );
+  checkStatistics( mask, statistics );
+
+  mask->set_mask_at( 0, 0, 0 );
+  mask->increase_generation();
+  ASSERT_TRUE( statistics.update( mask ) );
+  checkStatistics( mask, statistics );
+}
+
+TEST( MaskStatisticsTests, IncrementalSliceUpdates )
+{
+  boost::mt19937 rng( 17 );
+  MaskDataBlockHandle mask;
+  createMask( NX_C, NY_C, NZ_C, mask );
+  fillMask( mask, rng );
+
+  MaskStatistics statistics;
+  ASSERT_TRUE( statistics.update( mask ) );
+  DataBlock::generation_type generation = statistics.get_generation();
+  ASSERT_EQ( mask->get_generation(), generation );
+
+  // Nothing changed, hence nothing is recomputed
+  ASSERT_TRUE( statistics.update( mask ) );
+  EXPECT_EQ( generation, statistics.get_generation() );
+
+  // Edit single axial slices the way the slice tools do
+  boost::uniform_int<> dist( 0, static_cast< int >( mask->get_size() ) - 1 );
+  for ( size_t k = 0; k < 20; k++ )
+  {
+    size_t z = k % NZ_C;
+    for ( size_t j = 0; j < 50; j++ )
+    {
+      size_t index = dist( rng ) % ( NX_C * NY_C ) + z * NX_C * NY_C;
+      if ( j % 3 == 0 ) mask->clear_mask_at( index );
+      else mask->set_mask_at( index );
+    }
+    mask->increase_generation( SliceType::AXIAL_E, z );
+
+    ASSERT_TRUE( statistics.update( mask ) );
+    EXPECT_EQ( mask->get_generation(), statistics.get_generation() );
+    checkStatistics( mask, statistics );
+  }
+
+  // A coronal edit is not confined to one axial slice
+  for ( size_t z = 0; z < NZ_C; z++ ) mask->set_mask_at( 3, 7, z );
+  mask->increase_generation( SliceType::CORONAL_E, 7 );
+  ASSERT_TRUE( statistics.update( mask ) );
+  checkStatistics( mask, statistics );
+
+  // Another mask with the same dimensions does not reuse the slices
+  MaskDataBlockHandle other;
+  createMask( NX_C, NY_C, NZ_C, other );
+  fillMask( other, rng );
+  other->increase_generation( SliceType::AXIAL_E, 0 );
+  ASSERT_TRUE( statistics.update( other ) );
+  checkStatistics( other, statistics );
+}
+
+TEST( MaskStatisticsTests, Abort )
+{
+  boost::mt19937 rng( 3 );
+  MaskDataBlockHandle mask;
+  createMask( NX_C, NY_C, NZ_C, mask );
+  fillMask( mask, rng );
+
+  MaskStatistics statistics;
+  ASSERT_FALSE( statistics.update( mask, &abortNow ) );
+  EXPECT_EQ( -1, statistics.get_generation() );
+
+  ASSERT_TRUE( statistics.update( mask ) );
+  checkStatistics( mask, statistics );
+}
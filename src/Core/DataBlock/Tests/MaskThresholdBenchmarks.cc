@@ -0,0 +1,81 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/MaskThreshold.h>
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+TEST( MaskThresholdBenchmarks, Throughput )
+{
+  // Compare thresholding into a byte volume followed by a conversion into a mask, which is how
+  // the threshold filter used to work, with thresholding directly into the bit-plane.
+  const size_t size = 192;
+  GridTransform grid_transform( size, size, size );
+  DataBlockHandle data = StdDataBlock::New( size, size, size, DataType::SHORT_E );
+  short* data_ptr = reinterpret_cast< short* >( data->get_data() );
+  boost::mt19937 rng( 3 );
+  boost::uniform_int<> dist( -1000, 3000 );
+  for ( size_t j = 0; j < data->get_size(); j++ ) data_ptr[ j ] = static_cast< short >( dist( rng ) );
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+  DataBlockHandle bytes = StdDataBlock::New( size, size, size, DataType::UCHAR_E );
+  unsigned char* bytes_ptr = reinterpret_cast< unsigned char* >( bytes->get_data() );
+  for ( size_t j = 0; j < data->get_size(); j++ )
+  {
+    bytes_ptr[ j ] = ( data_ptr[ j ] >= 200.0 && data_ptr[ j ] <= 1500.0 ) ? 1 : 0;
+  }
+  MaskDataBlockHandle two_pass_mask;
+  ASSERT_TRUE( MaskDataBlockManager::Convert( bytes, grid_transform, two_pass_mask ) );
+  boost::posix_time::time_duration two_pass_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  start = boost::posix_time::microsec_clock::local_time();
+  MaskDataBlockHandle mask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( grid_transform, mask ) );
+  ASSERT_TRUE( MaskThreshold::Threshold( data, mask, 200.0, 1500.0 ) );
+  boost::posix_time::time_duration direct_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  for ( size_t j = 0; j < data->get_size(); j++ )
+  {
+    ASSERT_EQ( two_pass_mask->get_mask_at( j ), mask->get_mask_at( j ) );
+  }
+
+  std::cout << "Threshold of " << size << "^3 shorts: two pass " << 
+    two_pass_time.total_milliseconds() << " ms, direct " << 
+    direct_time.total_milliseconds() << " ms" << std::endl;
+}
@@ -0,0 +1,236 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/DataBlock/MaskThreshold.h>
+#include <Core/DataBlock/StdDataBlock.h>
+
+using namespace Core;
+
+namespace
+{
+
+const size_t NX_C = 37;
+const size_t NY_C = 19;
+const size_t NZ_C = 11;
+
+// Fill the data block with random values, half of them close to the given values
+template< class T >
+DataBlockHandle createData( DataType data_type, const std::vector< double >& values, 
+  unsigned int seed )
+{
+  DataBlockHandle data = StdDataBlock::New( NX_C, NY_C, NZ_C, data_type );
+  T* data_ptr = reinterpret_cast< T* >( data->get_data() );
+
+  boost::mt19937 rng( seed );
+  boost::uniform_real<> dist( -300.0, 300.0 );
+  boost::uniform_int<> pick( 0, static_cast< int >( values.size() ) - 1 );
+  boost::uniform_int<> offset( -1, 1 );
+  for ( size_t j = 0; j < data->get_size(); j++ )
+  {
+    double value = ( j % 2 ) ? dist( rng ) : values[ pick( rng ) ] + offset( rng );
+    value = std::max( value, static_cast< double >( std::numeric_limits< T >::lowest() ) );
+    value = std::min( value, static_cast< double >( std::numeric_limits< T >::max() ) );
+    data_ptr[ j ] = static_cast< T >( value );
+  }
+
+  // The exact values themselves
+  for ( size_t j = 0; j < values.size() && 2 * j + 1 < data->get_size(); j++ )
+  {
+    double value = std::max( values[ j ], 
+      static_cast< double >( std::numeric_limits< T >::lowest() ) );
+    value = std::min( value, static_cast< double >( std::numeric_limits< T >::max() ) );
+    data_ptr[ 2 * j + 1 ] = static_cast< T >( value );
+  }
+  return data;
+}
+
+template< class T >
+void checkThreshold( DataType data_type )
+{
+  std::vector< double > bounds;
+  bounds.push_back( 0.0 );
+  bounds.push_back( 10.0 );
+  bounds.push_back( 10.5 );
+  bounds.push_back( -20.25 );
+  bounds.push_back( 0.1 );
+  bounds.push_back( 127.0 );
+  bounds.push_back( 255.5 );
+  bounds.push_back( -1000.0 );
+  bounds.push_back( 1.0e6 );
+
+  DataBlockHandle data = createData< T >( data_type, bounds, 7 );
+  const T* data_ptr = reinterpret_cast< const T* >( data->get_data() );
+
+  // Two masks that share their data block, only the first one may change
+  GridTransform grid_transform( NX_C, NY_C, NZ_C );
+  MaskDataBlockHandle mask, other_mask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( grid_transform, other_mask ) );
+  ASSERT_TRUE( MaskDataBlockManager::Create( grid_transform, mask ) );
+  for ( size_t j = 0; j < other_mask->get_size(); j++ )
+  {
+    if ( j % 3 ) other_mask->set_mask_at( j );
+    else other_mask->clear_mask_at( j );
+  }
+
+  std::vector< unsigned char > slice( NX_C * NZ_C );
+  for ( size_t b0 = 0; b0 < bounds.size(); b0++ )
+  {
+    for ( size_t b1 = 0; b1 < bounds.size(); b1++ )
+    {
+      for ( int invert = 0; invert < 2; invert++ )
+      {
+        double min_val = bounds[ b0 ];
+        double max_val = bounds[ b1 ];
+        ASSERT_TRUE( MaskThreshold::Threshold( data, mask, min_val, max_val, invert != 0 ) );
+
+        // A coronal slice, traversed with a negative x stride
+        size_t y = NY_C / 2;
+        {
+          DataBlock::shared_lock_type lock( data->get_mutex() );
+          MaskThreshold::ThresholdSlice( data.get(), y * NX_C + NX_C - 1, -1, NX_C * NY_C,
+            NX_C, NZ_C, min_val, max_val, invert != 0, &slice[ 0 ] );
+        }
+
+        for ( size_t j = 0; j < data->get_size(); j++ )
+        {
+          bool in_range = data_ptr[ j ] >= min_val && data_ptr[ j ] <= max_val;
+          ASSERT_EQ( in_range != ( invert != 0 ), mask->get_mask_at( j ) ) << 
+            "value " << static_cast< double >( data_ptr[ j ] ) << " range [" << min_val << 
+            ", " << max_val << "]";
+          ASSERT_EQ( ( j % 3 ) != 0, other_mask->get_mask_at( j ) );
+        }
+
+        for ( size_t z = 0; z < NZ_C; z++ )
+        {
+          for ( size_t x = 0; x < NX_C; x++ )
+          {
+            size_t j = ( z * NY_C + y ) * NX_C + NX_C - 1 - x;
+            bool in_range = data_ptr[ j ] >= min_val && data_ptr[ j ] <= max_val;
+            ASSERT_EQ( in_range != ( invert != 0 ), slice[ z * NX_C + x ] != 0 );
+          }
+        }
+      }
+    }
+  }
+}
+
+bool abortNow()
+{
+  return true;
+}
+
+} // end anonymous namespace
+
+TEST( MaskThresholdTests, MatchesReferenceForAllTypes )
+{
+  checkThreshold< signed char >( DataType::CHAR_E );
+  checkThreshold< unsigned char >( DataType::UCHAR_E );
+  checkThreshold< short >( DataType::SHORT_E );
+  checkThreshold< unsigned short >( DataType::USHORT_E );
+  checkThreshold< int >( DataType::INT_E );
+  checkThreshold< unsigned int >( DataType::UINT_E );
+  checkThreshold< long long >( DataType::LONGLONG_E );
+  checkThreshold< unsigned long long >( DataType::ULONGLONG_E );
+  checkThreshold< float >( DataType::FLOAT_E );
+  checkThreshold< double >( DataType::DOUBLE_E );
+}
+
+TEST( MaskThresholdTests, FloatBoundsBetweenFloats )
+{
+  // 0.1 is not a float, the floats next to it need to be classified as in double precision
+  DataBlockHandle data = StdDataBlock::New( 4, 1, 1, DataType::FLOAT_E );
+  float* data_ptr = reinterpret_cast< float* >( data->get_data() );
+  data_ptr[ 0 ] = 0.1f;
+  data_ptr[ 1 ] = std::nextafter( 0.1f, 0.0f );
+  data_ptr[ 2 ] = std::numeric_limits< float >::quiet_NaN();
+  data_ptr[ 3 ] = std::numeric_limits< float >::infinity();
+
+  MaskDataBlockHandle mask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( 4, 1, 1 ), mask ) );
+  ASSERT_TRUE( MaskThreshold::Threshold( data, mask, 0.1, 1.0e300 ) );
+
+  EXPECT_EQ( 0.1f >= 0.1, mask->get_mask_at( 0 ) );
+  EXPECT_FALSE( mask->get_mask_at( 1 ) );
+  EXPECT_FALSE( mask->get_mask_at( 2 ) );
+  EXPECT_FALSE( mask->get_mask_at( 3 ) );
+}
+
+TEST( MaskThresholdTests, Bounds64Bit )
+{
+  // The maximum of a 64 bit type rounds up to the next power of two in double precision, which 
+  // is outside of the range of the type
+  const double two63 = std::ldexp( 1.0, 63 );
+  const double two64 = std::ldexp( 1.0, 64 );
+  const double below63 = two63 - 1024.0;
+
+  DataBlockHandle data = StdDataBlock::New( 3, 1, 1, DataType::LONGLONG_E );
+  long long* data_ptr = reinterpret_cast< long long* >( data->get_data() );
+  data_ptr[ 0 ] = std::numeric_limits< long long >::max();
+  data_ptr[ 1 ] = static_cast< long long >( below63 );
+  data_ptr[ 2 ] = std::numeric_limits< long long >::min();
+
+  MaskDataBlockHandle mask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( 3, 1, 1 ), mask ) );
+  ASSERT_TRUE( MaskThreshold::Threshold( data, mask, two63, 1.0e300 ) );
+  EXPECT_FALSE( mask->get_mask_at( 0 ) || mask->get_mask_at( 1 ) || mask->get_mask_at( 2 ) );
+  ASSERT_TRUE( MaskThreshold::Threshold( data, mask, below63, two63 ) );
+  EXPECT_TRUE( mask->get_mask_at( 0 ) && mask->get_mask_at( 1 ) );
+  EXPECT_FALSE( mask->get_mask_at( 2 ) );
+  ASSERT_TRUE( MaskThreshold::Threshold( data, mask, -two63, below63 ) );
+  EXPECT_TRUE( !mask->get_mask_at( 0 ) && mask->get_mask_at( 1 ) && mask->get_mask_at( 2 ) );
+
+  DataBlockHandle udata = StdDataBlock::New( 2, 1, 1, DataType::ULONGLONG_E );
+  unsigned long long* udata_ptr = reinterpret_cast< unsigned long long* >( udata->get_data() );
+  udata_ptr[ 0 ] = std::numeric_limits< unsigned long long >::max();
+  udata_ptr[ 1 ] = 0;
+
+  MaskDataBlockHandle umask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( 2, 1, 1 ), umask ) );
+  ASSERT_TRUE( MaskThreshold::Threshold( udata, umask, two64, 1.0e300 ) );
+  EXPECT_FALSE( umask->get_mask_at( 0 ) || umask->get_mask_at( 1 ) );
+  ASSERT_TRUE( MaskThreshold::Threshold( udata, umask, 1.0, two64 ) );
+  EXPECT_TRUE( umask->get_mask_at( 0 ) );
+  EXPECT_FALSE( umask->get_mask_at( 1 ) );
+}
+
+TEST( MaskThresholdTests, Abort )
+{
+  DataBlockHandle data = StdDataBlock::New( NX_C, NY_C, NZ_C, DataType::SHORT_E );
+  MaskDataBlockHandle mask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( GridTransform( NX_C, NY_C, NZ_C ), mask ) );
+  EXPECT_FALSE( MaskThreshold::Threshold( data, mask, 0.0, 1.0, false, &abortNow ) );
+}
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <fstream>
 
 #include <Core/DataBlock/NrrdData.h>
+#include <Core/DataBlock/StdDataBlock.h>
 #include <Testing/Utils/DataBlockSource.h>
 #include <Testing/Utils/FilesystemPaths.h>
 
@@ -71,3 +72,38 @@ TEST(NrrdDataTests, DetachedNrrdFromStdDataBlockNodeCentered)
 //  inputfile.exceptions( std::ifstream::failbit | std::ifstream::badbit );
   
 }
+
+// Round trip of attached nrrds that are written and read without Teem handling the data.
+// The data is larger than a gzip member, hence the compressed file consists of several members.
+TEST(NrrdDataTests, AttachedNrrdRoundTrip)
+{
+  Core::GridTransform gridTransform( 200, 150, 80 );
+  Core::DataBlockHandle dataBlock = Core::StdDataBlock::New( gridTransform, Core::DataType::SHORT_E );
+  ASSERT_FALSE(dataBlock.get() == 0);
+  short* data = reinterpret_cast<short*>( dataBlock->get_data() );
+  for ( size_t i = 0; i < dataBlock->get_size(); ++i )
+  {
+    data[ i ] = static_cast<short>( ( i * 7 ) % 1001 - 500 );
+  }
+
+  for ( int compress = 0; compress < 2; ++compress )
+  {
+    Core::NrrdDataHandle nrrd( new Core::NrrdData( dataBlock, gridTransform ) );
+    boost::filesystem::path nrrdFile = testOutputDir() / 
+      ( compress ? "attachedCompressed.nrrd" : "attachedRaw.nrrd" );
+
+    std::string error;
+    EXPECT_TRUE(NrrdData::SaveNrrd(nrrdFile.string(), nrrd, error, compress != 0, 6));
+    EXPECT_TRUE(error.empty());
+
+    Core::NrrdDataHandle loaded;
+    ASSERT_TRUE(NrrdData::LoadNrrd(nrrdFile.string(), loaded, error));
+    EXPECT_TRUE(error.empty());
+    ASSERT_EQ(dataBlock->get_nx(), loaded->get_nx());
+    ASSERT_EQ(dataBlock->get_ny(), loaded->get_ny());
+    ASSERT_EQ(dataBlock->get_nz(), loaded->get_nz());
+    ASSERT_EQ(Core::DataType::SHORT_E, loaded->get_data_type());
+    EXPECT_TRUE(std::equal(data, data + dataBlock->get_size(),
+      reinterpret_cast<short*>( loaded->get_data() )));
+  }
+}
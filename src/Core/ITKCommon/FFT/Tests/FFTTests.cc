@@ -0,0 +1,191 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <list>
+#include <vector>
+
+#include <Core/ITKCommon/FFT/fft.hxx>
+#include <Core/ITKCommon/FFT/fft_common.hxx>
+
+using namespace itk_fft;
+
+namespace
+{
+
+// Smooth synthetic texture, so that overlapping tiles correlate well.
+float SyntheticTexture( unsigned int x, unsigned int y )
+{
+  return static_cast<float>(
+    std::sin( x * 0.071 ) * std::cos( y * 0.053 ) +
+    0.5 * std::sin( ( x + 2 * y ) * 0.031 ) +
+    0.25 * std::cos( ( 3 * x - y ) * 0.117 ) +
+    0.1 * ( ( ( x * 7919 ) ^ ( y * 104729 ) ) % 17 ) / 17.0 );
+}
+
+itk_imageptr_t CreateTile( unsigned int x0, unsigned int y0, unsigned int w, unsigned int h )
+{
+  itk_imageptr_t image = itk_image_t::New();
+  itk_image_t::SizeType size;
+  size[ 0 ] = w;
+  size[ 1 ] = h;
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk_image_t::IndexType index;
+  for ( unsigned int y = 0; y < h; y++ )
+  {
+    for ( unsigned int x = 0; x < w; x++ )
+    {
+      index[ 0 ] = x;
+      index[ 1 ] = y;
+      image->SetPixel( index, SyntheticTexture( x0 + x, y0 + y ) );
+    }
+  }
+  return image;
+}
+
+// Correlate all the horizontally and vertically adjacent tiles of a grid.
+void CorrelateTileGrid( const std::vector< itk_imageptr_t >& tiles, unsigned int grid_size,
+  bool clear_plans, std::vector< local_max_t >& best_peaks )
+{
+  best_peaks.clear();
+  for ( unsigned int j = 0; j < grid_size; j++ )
+  {
+    for ( unsigned int i = 0; i < grid_size; i++ )
+    {
+      for ( unsigned int k = 0; k < 2; k++ )
+      {
+        unsigned int ni = i + ( k == 0 ? 1 : 0 );
+        unsigned int nj = j + ( k == 1 ? 1 : 0 );
+        if ( ni >= grid_size || nj >= grid_size ) continue;
+
+        if ( clear_plans ) clear_fft_plan_cache();
+
+        std::list< local_max_t > peaks;
+        find_correlation< itk_image_t >( peaks, tiles[ j * grid_size + i ],
+          tiles[ nj * grid_size + ni ], 0.5, 0.1 );
+        EXPECT_FALSE( peaks.empty() );
+        if ( peaks.empty() ) continue;
+
+        peaks.sort();
+        best_peaks.push_back( peaks.back() );
+      }
+    }
+  }
+}
+
+} // end anonymous namespace
+
+TEST(FFTTests, InverseOfHermitianSpectrumIsReal)
+{
+  // Odd and even sizes, alternating between them exercises the plan cache.
+  const unsigned int sizes[][ 2 ] = { { 16, 12 }, { 15, 9 }, { 16, 12 }, { 7, 32 } };
+  for ( unsigned int s = 0; s < 4; s++ )
+  {
+    const unsigned int w = sizes[ s ][ 0 ];
+    const unsigned int h = sizes[ s ][ 1 ];
+    itk_imageptr_t a = CreateTile( 0, 0, w, h );
+    itk_imageptr_t b = CreateTile( 3, 2, w, h );
+
+    fft_data_t fa, fb;
+    ASSERT_TRUE( fft( a, fa ) );
+    ASSERT_TRUE( fft( b, fb ) );
+
+    fft_data_t p( w, h );
+    for ( unsigned int x = 0; x < w; x++ )
+    {
+      for ( unsigned int y = 0; y < h; y++ )
+      {
+        p( x, y ) = fb( x, y ) * std::conj( fa( x, y ) );
+      }
+    }
+
+    fft_data_t complex_result;
+    ASSERT_TRUE( ifft( p, complex_result ) );
+    itk_imageptr_t real_result;
+    ASSERT_TRUE( ifft_real( p, real_result ) );
+
+    fft_data_t round_trip;
+    ASSERT_TRUE( ifft( fa, round_trip ) );
+
+    itk_image_t::IndexType index;
+    for ( unsigned int x = 0; x < w; x++ )
+    {
+      for ( unsigned int y = 0; y < h; y++ )
+      {
+        index[ 0 ] = x;
+        index[ 1 ] = y;
+        float expected = complex_result( x, y ).real();
+        float tolerance = 1e-4f * ( 1.0f + std::fabs( expected ) );
+        EXPECT_NEAR( real_result->GetPixel( index ), expected, tolerance );
+        EXPECT_NEAR( complex_result( x, y ).imag(), 0.0f, tolerance );
+
+        // the inverse transform is not normalized:
+        EXPECT_NEAR( round_trip( x, y ).real() / ( w * h ), a->GetPixel( index ), 1e-4f );
+      }
+    }
+  }
+}
+
+TEST(FFTTests, CachedPlansMatchReplanned)
+{
+  const unsigned int grid_size = 3;
+  const unsigned int tile_size = 128;
+  const unsigned int tile_step = 96;
+
+  std::vector< itk_imageptr_t > tiles;
+  for ( unsigned int j = 0; j < grid_size; j++ )
+  {
+    for ( unsigned int i = 0; i < grid_size; i++ )
+    {
+      tiles.push_back( CreateTile( i * tile_step, j * tile_step, tile_size, tile_size ) );
+    }
+  }
+
+  std::vector< local_max_t > uncached_peaks, cached_peaks, measured_peaks;
+  CorrelateTileGrid( tiles, grid_size, true, uncached_peaks );
+  CorrelateTileGrid( tiles, grid_size, false, cached_peaks );
+
+  bool previous_measure = set_fft_planning_measure( true );
+  CorrelateTileGrid( tiles, grid_size, false, measured_peaks );
+  set_fft_planning_measure( previous_measure );
+  clear_fft_plan_cache();
+
+  ASSERT_EQ( uncached_peaks.size(), cached_peaks.size() );
+  ASSERT_EQ( uncached_peaks.size(), measured_peaks.size() );
+  for ( size_t i = 0; i < cached_peaks.size(); i++ )
+  {
+    EXPECT_DOUBLE_EQ( uncached_peaks[ i ].x_, cached_peaks[ i ].x_ );
+    EXPECT_DOUBLE_EQ( uncached_peaks[ i ].y_, cached_peaks[ i ].y_ );
+    EXPECT_NEAR( cached_peaks[ i ].x_, measured_peaks[ i ].x_, 0.5 );
+    EXPECT_NEAR( cached_peaks[ i ].y_, measured_peaks[ i ].y_, 0.5 );
+  }
+}
@@ -39,6 +39,8 @@
 #endif
 #include <string.h>
 #include <math.h>
+#include <map>
+#include <string>
 
 // ITK includes:
 #include <itkImage.h>
@@ -46,6 +48,8 @@
 #include <itkImageRegionConstIteratorWithIndex.h>
 
 // Boost includes:
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/tss.hpp>
 
 // local includes:
@@ -90,104 +94,273 @@ namespace itk_fft
   
   
   //----------------------------------------------------------------
-  // fft_cache_t
+  // FFTW_PLANNER_FLAGS
   // 
-  class fft_cache_t
+  // planning rigor used for new plans, FFTW_ESTIMATE or FFTW_MEASURE:
+  static unsigned int FFTW_PLANNER_FLAGS = FFTW_ESTIMATE;
+  
+  //----------------------------------------------------------------
+  // set_fft_planning_measure
+  // 
+  bool set_fft_planning_measure(bool measure)
+  {
+    the_lock_t<the_mutex_interface_t> lock(fftw_mutex());
+    bool prev = (FFTW_PLANNER_FLAGS == FFTW_MEASURE);
+    FFTW_PLANNER_FLAGS = measure ? FFTW_MEASURE : FFTW_ESTIMATE;
+    return prev;
+  }
+  
+  //----------------------------------------------------------------
+  // load_fftw_wisdom
+  // 
+  bool load_fftw_wisdom(const std::string & filename)
+  {
+    // fftw is not thread safe:
+    the_lock_t<the_mutex_interface_t> lock(fftw_mutex());
+    return fftwf_import_wisdom_from_filename(filename.c_str()) != 0;
+  }
+  
+  //----------------------------------------------------------------
+  // save_fftw_wisdom
+  // 
+  bool save_fftw_wisdom(const std::string & filename)
+  {
+    // fftw is not thread safe:
+    the_lock_t<the_mutex_interface_t> lock(fftw_mutex());
+    return fftwf_export_wisdom_to_filename(filename.c_str()) != 0;
+  }
+  
+  
+  //----------------------------------------------------------------
+  // fft_plan_kind_t
+  // 
+  enum fft_plan_kind_t
+  {
+    // in-place, real to half-complex, forward:
+    FFT_PLAN_R2C_E,
+    
+    // in-place, half-complex to real, backward:
+    FFT_PLAN_C2R_E,
+    
+    // out-of-place, complex to complex, backward:
+    FFT_PLAN_C2C_BACKWARD_E
+  };
+  
+  //----------------------------------------------------------------
+  // fft_plan_key_t
+  // 
+  // a plan is only valid for the transform kind and size it was
+  // created for, and it remembers the number of threads and the
+  // planning rigor it was created with:
+  class fft_plan_key_t
   {
   public:
-    fft_cache_t():
-    fwd_(nullptr),
-    inv_(nullptr),
-    w_(0),
-    h_(0),
-    h_complex_(0),
-    h_padded_(0),
-    buffer_(nullptr)
+    fft_plan_key_t(const fft_plan_kind_t kind,
+                   const unsigned int w,
+                   const unsigned int h,
+                   const std::size_t num_threads,
+                   const unsigned int flags):
+    kind_(kind),
+    w_(w),
+    h_(h),
+    num_threads_(num_threads),
+    flags_(flags)
     {}
     
-    ~fft_cache_t()
+    bool operator < (const fft_plan_key_t & key) const
     {
-      clear();
+      if (kind_ != key.kind_) return kind_ < key.kind_;
+      if (w_ != key.w_) return w_ < key.w_;
+      if (h_ != key.h_) return h_ < key.h_;
+      if (num_threads_ != key.num_threads_) return num_threads_ < key.num_threads_;
+      return flags_ < key.flags_;
     }
     
-    void clear()
+    fft_plan_kind_t kind_;
+    unsigned int w_;
+    unsigned int h_;
+    std::size_t num_threads_;
+    unsigned int flags_;
+  };
+  
+  //----------------------------------------------------------------
+  // fft_plan_t
+  // 
+  // Owns an fftw plan. Plans are shared between threads (executing a
+  // plan is thread safe) and destroyed when the last user lets go:
+  class fft_plan_t : private boost::noncopyable
+  {
+  public:
+    explicit fft_plan_t(fftwf_plan plan):
+    plan_(plan)
+    {}
+    
+    ~fft_plan_t()
     {
-      if (buffer_)
-      {
-        // fftw is not thread safe:
-        the_lock_t<the_mutex_interface_t> lock(fftw_mutex());
-        
-        fftwf_destroy_plan(fwd_);
-        fwd_ = nullptr;
-        
-        fftwf_destroy_plan(inv_);
-        inv_ = nullptr;
-        
-        fftwf_free(buffer_);
-        buffer_ = nullptr;
-      }
-      
-      w_ = 0;
-      h_ = 0;
-      h_complex_ = 0;
-      h_padded_ = 0;
+      // fftw is not thread safe:
+      the_lock_t<the_mutex_interface_t> lock(fftw_mutex());
+      fftwf_destroy_plan(plan_);
+    }
+    
+    fftwf_plan plan_;
+  };
+  
+  typedef boost::shared_ptr<fft_plan_t> fft_plan_ptr_t;
+  typedef std::map<fft_plan_key_t, fft_plan_ptr_t> fft_plan_cache_t;
+  
+  //----------------------------------------------------------------
+  // PLAN_CACHE
+  // 
+  // plans created so far, access is guarded by the fftw mutex:
+  static fft_plan_cache_t PLAN_CACHE;
+  
+  //----------------------------------------------------------------
+  // get_fft_plan
+  // 
+  // Look up a cached plan, the plan is created on first use. The
+  // plans are executed with the new-array interface, so they are
+  // created on scratch arrays (FFTW_MEASURE overwrites its arrays)
+  // allocated with fftwf_malloc just like all the arrays they are
+  // executed on, which guarantees matching alignment:
+  static fft_plan_ptr_t
+  get_fft_plan(const fft_plan_kind_t kind,
+               const unsigned int w,
+               const unsigned int h)
+  {
+    // fftw is not thread safe:
+    the_lock_t<the_mutex_interface_t> lock(fftw_mutex());
+    
+    fft_plan_key_t key(kind, w, h, NUM_FFTW_THREADS, FFTW_PLANNER_FLAGS);
+    fft_plan_cache_t::iterator found = PLAN_CACHE.find(key);
+    if (found != PLAN_CACHE.end())
+    {
+      return found->second;
     }
     
-    void update(const unsigned int & w, const unsigned int & h)
+    const std::size_t h_padded = (h / 2 + 1) * 2;
+    const std::size_t num_floats = (kind == FFT_PLAN_C2C_BACKWARD_E) ?
+    std::size_t(w) * h * 2 : std::size_t(w) * h_padded;
+    
+    float * a = (float *)(fftwf_malloc(num_floats * sizeof(float)));
+    float * b = (kind == FFT_PLAN_C2C_BACKWARD_E) ?
+    (float *)(fftwf_malloc(num_floats * sizeof(float))) : a;
+    
+    fftwf_plan plan = nullptr;
+    if (a != nullptr && b != nullptr)
     {
-      if (w_ == w && h_ == h)
+      fftwf_plan_with_nthreads(NUM_FFTW_THREADS);
+      switch (kind)
       {
-        return;
+        case FFT_PLAN_R2C_E:
+          plan = fftwf_plan_dft_r2c_2d(w,
+                                       h,
+                                       a,
+                                       (fftwf_complex *)a,
+                                       FFTW_DESTROY_INPUT | FFTW_PLANNER_FLAGS);
+          break;
+          
+        case FFT_PLAN_C2R_E:
+          plan = fftwf_plan_dft_c2r_2d(w,
+                                       h,
+                                       (fftwf_complex *)a,
+                                       a,
+                                       FFTW_DESTROY_INPUT | FFTW_PLANNER_FLAGS);
+          break;
+          
+        case FFT_PLAN_C2C_BACKWARD_E:
+          plan = fftwf_plan_dft_2d(w,
+                                   h,
+                                   (fftwf_complex *)a,
+                                   (fftwf_complex *)b,
+                                   FFTW_BACKWARD,
+                                   FFTW_PLANNER_FLAGS);
+          break;
       }
-      
-      // fftw is not thread safe:
+    }
+    
+    if (b != a) fftwf_free(b);
+    if (a != nullptr) fftwf_free(a);
+    
+    if (plan == nullptr)
+    {
+      return fft_plan_ptr_t();
+    }
+    
+    fft_plan_ptr_t fft_plan(new fft_plan_t(plan));
+    PLAN_CACHE[key] = fft_plan;
+    return fft_plan;
+  }
+  
+  //----------------------------------------------------------------
+  // clear_fft_plan_cache
+  // 
+  void clear_fft_plan_cache()
+  {
+    fft_plan_cache_t plans;
+    {
       the_lock_t<the_mutex_interface_t> lock(fftw_mutex());
-      
-      if (buffer_)
+      plans.swap(PLAN_CACHE);
+    }
+    
+    // the plans are destroyed here, outside of the lock, unless
+    // another thread is still executing them:
+  }
+  
+  
+  //----------------------------------------------------------------
+  // fft_buffer_t
+  // 
+  // per-thread scratch buffer for the in-place real transforms:
+  class fft_buffer_t
+  {
+  public:
+    fft_buffer_t():
+    data_(nullptr),
+    size_(0)
+    {}
+    
+    ~fft_buffer_t()
+    {
+      if (data_ != nullptr) fftwf_free(data_);
+    }
+    
+    float * get(const std::size_t size)
+    {
+      if (size > size_)
       {
-        fftwf_destroy_plan(fwd_);
-        fftwf_destroy_plan(inv_);
-        fftwf_free(buffer_);
+        if (data_ != nullptr) fftwf_free(data_);
+        data_ = (float *)(fftwf_malloc(size * sizeof(float)));
+        size_ = (data_ != nullptr) ? size : 0;
       }
       
-      w_ = w;
-      h_ = h;
-      
-      h_complex_ = h_ / 2 + 1;
-      h_padded_ = h_complex_ * 2;
-      
-      buffer_ = (float *)(fftwf_malloc(w_ * h_padded_ * sizeof(float)));
-      fftwf_plan_with_nthreads(NUM_FFTW_THREADS);
-      fwd_ = fftwf_plan_dft_r2c_2d(w_,
-                                   h_,
-                                   buffer_,
-                                   (fftwf_complex *)buffer_,
-                                   FFTW_DESTROY_INPUT | FFTW_ESTIMATE);
-      
-      fft_data_t dummy_in(4, 4);
-      fft_data_t dummy_out(4, 4);
-      fftwf_plan_with_nthreads(NUM_FFTW_THREADS);
-      inv_ = fftwf_plan_dft_2d(w_,
-                               h_,
-                               (fftwf_complex *)(dummy_in.data()),
-                               (fftwf_complex *)(dummy_out.data()),
-                               FFTW_BACKWARD,
-                               FFTW_ESTIMATE);
+      return data_;
     }
     
-    fftwf_plan fwd_; // analysis, forward fft
-    fftwf_plan inv_; // synthesis, inverse fft
-    unsigned int w_;
-    unsigned int h_;
-    unsigned int h_complex_;
-    unsigned int h_padded_;
-    float * buffer_;
+  private:
+    float * data_;
+    std::size_t size_;
   };
   
   //----------------------------------------------------------------
   // tss
   // 
-  static boost::thread_specific_ptr<fft_cache_t> tss;
+  static boost::thread_specific_ptr<fft_buffer_t> tss;
+  
+  //----------------------------------------------------------------
+  // get_fft_buffer
+  // 
+  static float *
+  get_fft_buffer(const std::size_t size)
+  {
+    fft_buffer_t * buffer = tss.get();
+    if (!buffer)
+    {
+      buffer = new fft_buffer_t();
+      tss.reset(buffer);
+    }
+    
+    return buffer->get(size);
+  }
   
   //----------------------------------------------------------------
   // fft_data_t::fft_data_t
@@ -439,13 +612,13 @@ namespace itk_fft
     const unsigned int w = size[0];
     const unsigned int h = size[1];
     
-    fft_cache_t * cache = tss.get();
-    if (!cache)
-    {
-      cache = new fft_cache_t();
-      tss.reset(cache);
-    }
-    cache->update(w, h);
+    // shortcuts:
+    const unsigned int h_complex = h / 2 + 1;
+    const unsigned int h_padded = h_complex * 2;
+    
+    fft_plan_ptr_t plan = get_fft_plan(FFT_PLAN_R2C_E, w, h);
+    float * buffer = get_fft_buffer(std::size_t(w) * h_padded);
+    if (!plan || !buffer) return false;
     
     // iterate over the image:
     itex_t itex(in, in->GetLargestPossibleRegion());
@@ -454,19 +627,17 @@ namespace itk_fft
       const index_t index = itex.GetIndex();
       const unsigned int x = index[0];
       const unsigned int y = index[1];
-      const unsigned int i = y + cache->h_padded_ * x;
+      const unsigned int i = y + h_padded * x;
       
-      cache->buffer_[i] = itex.Get();
+      buffer[i] = itex.Get();
     }
     
-    if (!cache->fwd_) return false;
-    fftwf_execute_dft_r2c(cache->fwd_,
-                          cache->buffer_,
-                          (fftwf_complex *)(cache->buffer_));
+    fftwf_execute_dft_r2c(plan->plan_,
+                          buffer,
+                          (fftwf_complex *)(buffer));
     
-    // shortcuts:
-    const unsigned int h_complex = cache->h_complex_;
-    fft_complex_t * buffer = (fft_complex_t *)cache->buffer_;
+    // shortcut:
+    const fft_complex_t * half = (const fft_complex_t *)(buffer);
     
     // fill in the rest of the output data:
     out.resize(w, h);
@@ -475,13 +646,13 @@ namespace itk_fft
       for (unsigned int y = 0; y < h_complex; y++)
       {
         unsigned int i = y + h_complex * x;
-        out(x, y) = buffer[i];
+        out(x, y) = half[i];
       }
       
       for (unsigned int y = h_complex; y < h; y++)
       {
         unsigned int i = (h - y) + h_complex * ((w - x) % w);
-        out(x, y) = std::conj(buffer[i]);
+        out(x, y) = std::conj(half[i]);
       }
     }
     
@@ -495,17 +666,74 @@ namespace itk_fft
   bool
   ifft(const fft_data_t & in, fft_data_t & out)
   {
+    fft_plan_ptr_t plan = get_fft_plan(FFT_PLAN_C2C_BACKWARD_E,
+                                       in.nx(),
+                                       in.ny());
+    if (!plan) return false;
+    
     out.resize(in.nx(), in.ny());
     
-    fft_cache_t * cache = tss.get();
-    if (!cache)
+    // out-of-place complex transforms preserve the input:
+    fftwf_execute_dft(plan->plan_,
+                      (fftwf_complex *)(const_cast<fft_complex_t *>(in.data())),
+                      (fftwf_complex *)(out.data()));
+    return true;
+  }
+  
+  //----------------------------------------------------------------
+  // ifft_real
+  // 
+  bool
+  ifft_real(const fft_data_t & in, itk_image_t::Pointer & out)
+  {
+    typedef itk::ImageRegionIteratorWithIndex<itk_image_t> itex_t;
+    typedef itk_image_t::IndexType index_t;
+    
+    const unsigned int w = in.nx();
+    const unsigned int h = in.ny();
+    
+    // shortcuts:
+    const unsigned int h_complex = h / 2 + 1;
+    const unsigned int h_padded = h_complex * 2;
+    
+    fft_plan_ptr_t plan = get_fft_plan(FFT_PLAN_C2R_E, w, h);
+    float * buffer = get_fft_buffer(std::size_t(w) * h_padded);
+    if (!plan || !buffer) return false;
+    
+    // the other half of a hermitian spectrum is redundant:
+    fft_complex_t * half = (fft_complex_t *)(buffer);
+    for (unsigned int x = 0; x < w; x++)
+    {
+      for (unsigned int y = 0; y < h_complex; y++)
+      {
+        unsigned int i = y + h_complex * x;
+        half[i] = in(x, y);
+      }
+    }
+    
+    fftwf_execute_dft_c2r(plan->plan_,
+                          (fftwf_complex *)(buffer),
+                          buffer);
+    
+    out = itk_image_t::New();
+    itk::Size<2> size;
+    size[0] = w;
+    size[1] = h;
+    out->SetRegions(size);
+    out->Allocate();
+    
+    // iterate over the image:
+    itex_t itex(out, out->GetLargestPossibleRegion());
+    for (itex.GoToBegin(); !itex.IsAtEnd(); ++itex)
     {
-      return false;
+      const index_t index = itex.GetIndex();
+      const unsigned int x = index[0];
+      const unsigned int y = index[1];
+      const unsigned int i = y + h_padded * x;
+      
+      itex.Set(buffer[i]);
     }
     
-    fftwf_execute_dft(cache->inv_,
-                      (fftwf_complex *)(in.data()),
-                      (fftwf_complex *)(out.data()));
     return true;
   }
   
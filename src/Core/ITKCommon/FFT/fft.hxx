@@ -45,6 +45,7 @@
 // system includes:
 #include <complex>
 #include <stdlib.h>
+#include <string>
 
 #include <Core/Utils/Exception.h>
 
@@ -57,6 +58,36 @@ namespace itk_fft
   // set's number of threads used by fftw, returns previous value:
   extern std::size_t set_num_fftw_threads(std::size_t num_threads);
   
+  //----------------------------------------------------------------
+  // set_fft_planning_measure
+  // 
+  // select FFTW_MEASURE (true) or FFTW_ESTIMATE (false) planning for
+  // plans created from now on, returns previous value. Measured plans
+  // are slow to create but faster to execute, so they pay off when
+  // many transforms of the same size are computed. Plans are cached
+  // per transform size, direction and number of threads:
+  extern bool set_fft_planning_measure(bool measure);
+  
+  //----------------------------------------------------------------
+  // load_fftw_wisdom
+  // 
+  // import fftw wisdom (previously measured plans) from a file,
+  // returns false if the file could not be read:
+  extern bool load_fftw_wisdom(const std::string & filename);
+  
+  //----------------------------------------------------------------
+  // save_fftw_wisdom
+  // 
+  // export the fftw wisdom accumulated so far to a file:
+  extern bool save_fftw_wisdom(const std::string & filename);
+  
+  //----------------------------------------------------------------
+  // clear_fft_plan_cache
+  // 
+  // release the cached plans, plans still executing in other
+  // threads are released once those transforms finish:
+  extern void clear_fft_plan_cache();
+  
   //----------------------------------------------------------------
   // itk_image_t
   // 
@@ -159,6 +190,15 @@ namespace itk_fft
   extern bool
   ifft(const fft_data_t & in, fft_data_t & out);
   
+  //----------------------------------------------------------------
+  // ifft_real
+  // 
+  // inverse transform of a hermitian spectrum (such as the transform
+  // of a real image, or a product of such transforms), only the
+  // real component of the result is computed:
+  extern bool
+  ifft_real(const fft_data_t & in, itk_image_t::Pointer & out);
+  
   //----------------------------------------------------------------
   // ifft
   // 
@@ -511,21 +511,20 @@ find_correlation(std::list<local_max_t> & max_list,
   // resampled data produces less noisy PDF and requires less smoothing:
   P.apply_lp_filter(lp_filter_r * 0.8, lp_filter_s);
 
-  // calculate the displacement probability density function:
-  fft_data_t ifft_P;
+  // calculate the displacement probability density function,
+  // P is hermitian so only the real component needs to be computed:
+  itk_image_t::Pointer PDF;
 
   //#ifndef NDEBUG // get around an annoying compiler warning:
   //  bool ok =
   //#endif
-  bool ok =ifft(P, ifft_P);
+  bool ok = ifft_real(P, PDF);
   //  assert(ok);
   if (! ok)
   {
     CORE_THROW_EXCEPTION("ifft failed");
   }
 
-  itk_image_t::Pointer PDF = ifft_P.real();
-
   // look for the maxima in the PDF:
   double area = static_cast<double>(max_sz[0] * max_sz[1]);
 
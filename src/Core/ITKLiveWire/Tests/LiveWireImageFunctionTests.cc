@@ -0,0 +1,234 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include <itkImage.h>
+
+#include <Core/ITKLiveWire/itkLiveWireImageFunction.h>
+
+namespace
+{
+
+typedef itk::Image< float, 2 > ImageType;
+typedef itk::LiveWireImageFunction< ImageType > LiveWireType;
+typedef LiveWireType::OutputType PathType;
+typedef LiveWireType::MaskImageType MaskImageType;
+typedef ImageType::IndexType IndexType;
+
+const unsigned int NX_C = 48, NY_C = 40;
+
+IndexType MakeIndex( long x, long y )
+{
+  IndexType index;
+  index[ 0 ] = x;
+  index[ 1 ] = y;
+  return index;
+}
+
+// Two blobs on a ramp with some noise, so there are edges to follow and few ties in the costs
+ImageType::Pointer CreateImage( double spacing_y )
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size[ 0 ] = NX_C;
+  size[ 1 ] = NY_C;
+  image->SetRegions( size );
+  ImageType::SpacingType spacing;
+  spacing[ 0 ] = 1.0;
+  spacing[ 1 ] = spacing_y;
+  image->SetSpacing( spacing );
+  image->Allocate();
+
+  for ( unsigned int y = 0; y < NY_C; y++ )
+  {
+    for ( unsigned int x = 0; x < NX_C; x++ )
+    {
+      double d1 = ( x - 15.0 ) * ( x - 15.0 ) + ( y - 12.0 ) * ( y - 12.0 );
+      double d2 = ( x - 32.0 ) * ( x - 32.0 ) + ( y - 25.0 ) * ( y - 25.0 );
+      double value = ( d1 < 64.0 ? 100.0 : 0.0 ) + ( d2 < 49.0 ? 60.0 : 0.0 ) + 0.5 * x +
+        ( ( x * 7919 + y * 104729 ) % 13 );
+      image->SetPixel( MakeIndex( x, y ), static_cast< float >( value ) );
+    }
+  }
+  return image;
+}
+
+// A wall that can only be passed at the top, and a closed box that cannot be entered
+MaskImageType::Pointer CreateMask()
+{
+  MaskImageType::Pointer mask = MaskImageType::New();
+  MaskImageType::SizeType size;
+  size[ 0 ] = NX_C;
+  size[ 1 ] = NY_C;
+  mask->SetRegions( size );
+  mask->Allocate();
+  mask->FillBuffer( 1 );
+
+  for ( unsigned int y = 4; y < NY_C; y++ )
+  {
+    mask->SetPixel( MakeIndex( 24, y ), 0 );
+  }
+  for ( unsigned int j = 35; j <= 45; j++ )
+  {
+    mask->SetPixel( MakeIndex( j, 25 ), 0 );
+    mask->SetPixel( MakeIndex( j, 35 ), 0 );
+    mask->SetPixel( MakeIndex( 35, j - 10 ), 0 );
+    mask->SetPixel( MakeIndex( 45, j - 10 ), 0 );
+  }
+  return mask;
+}
+
+struct Settings
+{
+  bool face_connected_;
+  double spacing_y_;
+  bool use_mask_;
+};
+
+LiveWireType::Pointer CreateLiveWire( const ImageType* image, const MaskImageType::Pointer& mask,
+  const Settings& settings, double direction_weight )
+{
+  LiveWireType::Pointer live_wire = LiveWireType::New();
+  live_wire->SetUseFaceConnectedness( settings.face_connected_ );
+  live_wire->SetInputImage( image );
+  live_wire->SetGradientDirectionWeight( static_cast< LiveWireType::RealType >( 
+    direction_weight ) );
+  if ( settings.use_mask_ )
+  {
+    live_wire->SetMaskImage( mask );
+    live_wire->SetInsidePixelValue( 1 );
+  }
+  return live_wire;
+}
+
+void ExpectSamePath( const PathType* path, const PathType* reference )
+{
+  ASSERT_EQ( reference == nullptr, path == nullptr );
+  if ( reference == nullptr ) return;
+
+  const PathType::VertexListType* vertices = path->GetVertexList();
+  const PathType::VertexListType* reference_vertices = reference->GetVertexList();
+  ASSERT_EQ( reference_vertices->Size(), vertices->Size() );
+  for ( unsigned int j = 0; j < reference_vertices->Size(); j++ )
+  {
+    EXPECT_EQ( reference_vertices->ElementAt( j ), vertices->ElementAt( j ) );
+  }
+}
+
+}
+
+TEST( LiveWireImageFunctionTests, ResumedSearchesMatchNewSearches )
+{
+  itk::Object::GlobalWarningDisplayOff();
+
+  // Anchor seeds and the free points that are traced from them, in the order of evaluation. 
+  // Anchors are revisited while their search is cached, after it was evicted, and after the 
+  // costs changed. Free points include points that were already expanded, the anchor itself,
+  // points behind the wall and points inside the closed box.
+  const IndexType a = MakeIndex( 5, 5 ), b = MakeIndex( 40, 8 ), c = MakeIndex( 10, 33 ),
+    d = MakeIndex( 40, 30 );
+  std::vector< std::pair< IndexType, IndexType > > sequence;
+  sequence.push_back( std::make_pair( a, MakeIndex( 6, 5 ) ) );
+  sequence.push_back( std::make_pair( a, MakeIndex( 20, 12 ) ) );
+  sequence.push_back( std::make_pair( a, MakeIndex( 12, 7 ) ) );
+  sequence.push_back( std::make_pair( a, MakeIndex( 47, 39 ) ) );
+  sequence.push_back( std::make_pair( a, a ) );
+  sequence.push_back( std::make_pair( a, MakeIndex( 21, 12 ) ) );
+  sequence.push_back( std::make_pair( b, MakeIndex( 30, 30 ) ) );
+  sequence.push_back( std::make_pair( b, MakeIndex( 41, 8 ) ) );
+  sequence.push_back( std::make_pair( b, MakeIndex( 2, 38 ) ) );
+  sequence.push_back( std::make_pair( a, MakeIndex( 25, 20 ) ) );
+  sequence.push_back( std::make_pair( a, MakeIndex( 46, 2 ) ) );
+  sequence.push_back( std::make_pair( c, MakeIndex( 44, 2 ) ) );
+  sequence.push_back( std::make_pair( c, MakeIndex( 12, 30 ) ) );
+  sequence.push_back( std::make_pair( b, MakeIndex( 30, 30 ) ) );
+  sequence.push_back( std::make_pair( b, MakeIndex( 0, 0 ) ) );
+  sequence.push_back( std::make_pair( d, MakeIndex( 38, 28 ) ) );
+  sequence.push_back( std::make_pair( d, MakeIndex( 10, 10 ) ) );
+  sequence.push_back( std::make_pair( a, d ) );
+  sequence.push_back( std::make_pair( a, MakeIndex( 30, 25 ) ) );
+  const size_t weight_change = sequence.size();
+  sequence.push_back( std::make_pair( a, MakeIndex( 30, 25 ) ) );
+  sequence.push_back( std::make_pair( a, MakeIndex( 20, 12 ) ) );
+  sequence.push_back( std::make_pair( b, MakeIndex( 2, 38 ) ) );
+
+  const Settings settings[] = { { true, 1.0, false }, { false, 1.0, false }, 
+    { true, 1.5, true }, { false, 1.0, true } };
+
+  MaskImageType::Pointer mask = CreateMask();
+  for ( size_t s = 0; s < 4; s++ )
+  {
+    SCOPED_TRACE( testing::Message() << "settings " << s );
+    ImageType::Pointer image = CreateImage( settings[ s ].spacing_y_ );
+
+    double direction_weight = 0.14;
+    LiveWireType::Pointer live_wire = CreateLiveWire( image, mask, settings[ s ], 
+      direction_weight );
+
+    size_t num_paths = 0;
+    for ( size_t j = 0; j < sequence.size(); j++ )
+    {
+      SCOPED_TRACE( testing::Message() << "step " << j );
+
+      // Changing the costs restarts the searches
+      if ( j == weight_change )
+      {
+        direction_weight = 0.5;
+        live_wire->SetGradientDirectionWeight( static_cast< LiveWireType::RealType >( 
+          direction_weight ) );
+      }
+
+      live_wire->SetAnchorSeed( sequence[ j ].first );
+      PathType::Pointer path = live_wire->EvaluateAtIndex( sequence[ j ].second );
+
+      LiveWireType::Pointer reference_live_wire = CreateLiveWire( image, mask, settings[ s ], 
+        direction_weight );
+      reference_live_wire->SetAnchorSeed( sequence[ j ].first );
+      PathType::Pointer reference = reference_live_wire->EvaluateAtIndex( 
+        sequence[ j ].second );
+
+      ExpectSamePath( path.GetPointer(), reference.GetPointer() );
+      if ( reference ) num_paths++;
+    }
+
+    // Without a mask every point can be reached, with the mask the closed box cannot
+    if ( settings[ s ].use_mask_ )
+    {
+      EXPECT_LT( num_paths, sequence.size() );
+    }
+    else
+    {
+      EXPECT_EQ( sequence.size(), num_paths );
+    }
+  }
+}
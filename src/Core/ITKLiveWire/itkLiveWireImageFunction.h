@@ -21,10 +21,12 @@
 
 #include "itkGradientImageFilter.h"
 #include "itkPolyLineParametricPath.h"
-#include "itkPriorityQueueContainer.h"
 
-#include <vector>
+#include <functional>
+#include <list>
 #include <queue>
+#include <utility>
+#include <vector>
 
 namespace itk
 {
@@ -37,6 +39,12 @@ namespace itk
  * from the ImageFunction class where an N-D dimensional image
  * is taken as input and the output consists of a path in that image.
  *
+ * The shortest paths from the anchor seed are computed on demand: the
+ * search is only expanded until the requested index is reached and is
+ * resumed for the next index that is evaluated. The searches from the
+ * most recently used anchor seeds are kept, so switching between a few
+ * anchors does not restart them.
+ *
  * \reference
  * W. A. Barrett and E. N. Mortenson, "Interactive live-wire boundary 
  * extraction", Medical Image Analysis, 1(4):331-341, 1996/7.
@@ -89,24 +97,13 @@ public:
   typedef GradientImageFilter<InputImageType, RealType,
     RealType>                                               GradientFilterType;
   typedef typename GradientFilterType::OutputImageType      GradientImageType;
-  typedef Image<typename InputImageType::OffsetType, 
-    itkGetStaticConstMacro( ImageDimension )>               OffsetImageType;
+  typedef typename InputImageType::OffsetType               OffsetType;
+  typedef typename InputImageType::OffsetValueType          OffsetValueType;
   typedef Image<int, 
     itkGetStaticConstMacro( ImageDimension )>               MaskImageType;
   typedef typename MaskImageType::PixelType                 MaskPixelType;
 
 
-  /**
-   * Priority queue typedefs
-   */
-  typedef MinPriorityQueueElementWrapper
-    <IndexType, RealType, ElementIdentifier>         PriorityQueueElementType;
-  typedef PriorityQueueContainer<
-    PriorityQueueElementType, 
-    PriorityQueueElementType,
-    RealType, long>                                  PriorityQueueType;
-    
-
   /** Set the input image.
    * \warning this method caches BufferedRegion information.
    * If the BufferedRegion has changed, user must call
@@ -157,18 +154,14 @@ public:
   itkSetMacro( InsidePixelValue, MaskPixelType );
   itkGetConstMacro( InsidePixelValue, MaskPixelType );
 
+  /** Set the anchor seed from which the paths are computed. The search
+   * from the anchor is started when the first path is evaluated, or
+   * resumed if it is still cached. Changing the anchor does not modify
+   * the function. */
   virtual void SetAnchorSeed( IndexType index )
     {
     itkDebugMacro( "setting AnchorSeed to " << index );
-    if ( this->m_AnchorSeed != index ) 
-      {
-      this->m_AnchorSeed = index;
-      if ( this->GetInputImage() != nullptr )
-        {
-        this->GeneratePathDirectionImage();
-        }
-      this->Modified(); 
-      } 
+    this->m_AnchorSeed = index;
     } 
   itkGetConstMacro( AnchorSeed, IndexType );
 
@@ -190,7 +183,45 @@ private:
   LiveWireImageFunction(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
-  void GeneratePathDirectionImage();
+  /** MaximumNumberOfSearches is the number of anchor seeds for which the
+   * search is kept. The direction code of a pixel holds the neighbor the
+   * path continues to in the lower bits, or NoDirection if the pixel was
+   * not reached yet, and ExpandedFlag once the pixel is expanded. */
+  enum 
+    { 
+    MaximumNumberOfSearches = 2,
+    NoDirection = 0x7f,
+    ExpandedFlag = 0x80
+    };
+
+  /** Element of the search front: path cost and buffer offset. */
+  typedef std::pair<RealType, OffsetValueType>              QueueElementType;
+  typedef std::priority_queue<QueueElementType,
+    std::vector<QueueElementType>,
+    std::greater<QueueElementType> >                        QueueType;
+
+  /** State of the shortest path search from one anchor seed. */
+  struct SearchState
+    {
+    IndexType                     m_Anchor;
+    std::vector<RealType>         m_Cost;
+    std::vector<unsigned char>    m_Direction;
+    std::vector<OffsetValueType>  m_Touched;
+    QueueType                     m_Queue;
+    };
+  typedef std::list<SearchState>                            SearchListType;
+
+  /** Compute the neighborhood and the local costs that do not depend on
+   * the anchor seed, if the settings changed since the last search. */
+  void PrepareSearch() const;
+
+  /** Get the search for the current anchor seed, starting a new one if
+   * it is not cached. */
+  SearchState& GetSearch() const;
+
+  /** Expand the search until the pixel at offset target is reached or no
+   * more pixels can be reached. */
+  void ExpandSearch( SearchState& search, OffsetValueType target ) const;
 
   RealType                                   m_GradientMagnitudeWeight;
   RealType                                   m_ZeroCrossingWeight;
@@ -200,8 +231,21 @@ private:
   typename RealImageType::Pointer            m_GradientMagnitudeImage;
   typename RealImageType::Pointer            m_RescaledGradientMagnitudeImage;  
   typename RealImageType::Pointer            m_ZeroCrossingImage;
-  
-  typename OffsetImageType::Pointer          m_PathDirectionImage;
+
+  /** Weighted sum of the gradient magnitude and zero crossing costs. */
+  mutable std::vector<RealType>              m_LocalCost;
+
+  /** Offsets, buffer strides, physical vectors and scale factors of the
+   * neighbors that are connected to a pixel. */
+  mutable std::vector<OffsetType>            m_NeighborOffsets;
+  mutable std::vector<OffsetValueType>       m_NeighborStrides;
+  mutable std::vector<typename PointType::VectorType> m_NeighborVectors;
+  mutable std::vector<RealType>              m_NeighborScales;
+
+  /** Searches of the most recently used anchor seeds, the most recent one
+   * first, and the modification time they were computed for. */
+  mutable SearchListType                     m_Searches;
+  mutable ModifiedTimeType                   m_SearchTime;
 
   typename MaskImageType::Pointer            m_MaskImage;
   MaskPixelType                              m_InsidePixelValue;
@@ -21,7 +21,6 @@
 #include "itkLiveWireImageFunction.h"
 
 #include "itkCastImageFilter.h"
-#include "itkConstNeighborhoodIterator.h"
 #include "itkNeighborhood.h"
 #include "itkRescaleIntensityImageFilter.h"
 #include "itkZeroCrossingBasedEdgeDetectionImageFilter.h"
@@ -48,6 +47,8 @@ LiveWireImageFunction<TInputImage>
   this->m_InsidePixelValue = NumericTraits<MaskPixelType>::One;
 
   this->m_AnchorSeed.Fill( 0 );
+
+  this->m_SearchTime = 0;
 }
 
 // Destructor
@@ -120,56 +121,47 @@ LiveWireImageFunction<TInputImage>
 				this->m_ZeroCrossingImage = zeroCrossing->GetOutput();
     }
 
-  this->GeneratePathDirectionImage();
+  /**
+   * The searches need to be restarted on the new costs
+   */
+  this->m_Searches.clear();
+  this->m_NeighborScales.clear();
 }
 
 template <class TInputImage>
 void
 LiveWireImageFunction<TInputImage>
-::GeneratePathDirectionImage()
+::PrepareSearch() const
 {
-  if ( !this->IsInsideBuffer( this->m_AnchorSeed ) )
+  if ( !this->m_NeighborScales.empty() && this->m_SearchTime == this->GetMTime() )
     {
-    itkExceptionMacro( "m_AnchorSeed is not inside buffer." );
+    return;
     }
 
+  const InputImageType *image = this->GetInputImage();
+  this->m_Searches.clear();
+  this->m_NeighborOffsets.clear();
+  this->m_NeighborStrides.clear();
+  this->m_NeighborVectors.clear();
+  this->m_NeighborScales.clear();
+
   /**
-   * Initialize data structures
+   * Scale factors of the neighbors, neighbors that are not connected
+   * to the center get a scale factor of zero and are left out. As the
+   * neighborhood is symmetric, neighbor n of the remaining ones is the
+   * opposite of neighbor ( count - 1 - n ).
    */
-  typedef Image<bool, ImageDimension> BooleanImageType;
-  typename BooleanImageType::Pointer expanded = BooleanImageType::New();
-  expanded->SetOrigin( this->GetInputImage()->GetOrigin() );
-  expanded->SetSpacing( this->GetInputImage()->GetSpacing() );
-  expanded->SetRegions( this->GetInputImage()->GetLargestPossibleRegion() );
-  expanded->Allocate();
-  expanded->FillBuffer( false );
-  expanded->SetPixel( this->m_AnchorSeed, true );
-
-  typename RealImageType::Pointer costImage = RealImageType::New();
-  costImage->SetOrigin( this->GetInputImage()->GetOrigin() );
-  costImage->SetSpacing( this->GetInputImage()->GetSpacing() );
-  costImage->SetRegions( this->GetInputImage()->GetLargestPossibleRegion() );
-  costImage->Allocate();
-  costImage->FillBuffer( NumericTraits<RealType>::max() );
-  costImage->SetPixel( this->m_AnchorSeed, 0.0 );
-
-  this->m_PathDirectionImage = OffsetImageType::New();
-  this->m_PathDirectionImage->SetOrigin( this->GetInputImage()->GetOrigin() );
-  this->m_PathDirectionImage->SetSpacing( this->GetInputImage()->GetSpacing() );
-  this->m_PathDirectionImage->SetRegions( this->GetInputImage()->GetLargestPossibleRegion() );
-  this->m_PathDirectionImage->Allocate();
-
-  typename ConstNeighborhoodIterator<InputImageType>::RadiusType radius;
+  typename Neighborhood<RealType, ImageDimension>::RadiusType radius;
   radius.Fill( 1 );
-  ConstNeighborhoodIterator<BooleanImageType> It( radius, expanded,
-    expanded->GetLargestPossibleRegion() );
-  unsigned int numberOfNeighbors = 1;
-  for ( unsigned int d = 0; d < ImageDimension; d++ )
-    {
-    numberOfNeighbors *= ( 2*radius[d] + 1 );
-    }
   Neighborhood<RealType, ImageDimension> scaleFactors;
   scaleFactors.SetRadius( radius );
+  const unsigned int numberOfNeighbors = scaleFactors.Size();
+
+  const IndexType startIndex = image->GetBufferedRegion().GetIndex();
+  const OffsetValueType *offsetTable = image->GetOffsetTable();
+  PointType startPoint;
+  image->TransformIndexToPhysicalPoint( startIndex, startPoint );
+
   for ( unsigned int n = 0; n < numberOfNeighbors; n++ )
     {
     scaleFactors[n] = 0;
@@ -177,8 +169,7 @@ LiveWireImageFunction<TInputImage>
       {
       continue;
       }
-    typename Neighborhood<RealType, ImageDimension>::OffsetType offset
-      = scaleFactors.GetOffset( n );
+    OffsetType offset = scaleFactors.GetOffset( n );
 
 				bool isFaceConnected = true;
 				unsigned int sumOffset = 0;
@@ -188,8 +179,7 @@ LiveWireImageFunction<TInputImage>
 						if ( this->m_UseImageSpacing )
 								{
 								scaleFactors[n] += ( static_cast<RealType>( offset[d] * offset[d] )
-										* this->GetInputImage()->GetSpacing()[d]
-          * this->GetInputImage()->GetSpacing()[d] );
+										* image->GetSpacing()[d] * image->GetSpacing()[d] );
 								}
 						else
 								{
@@ -201,131 +191,218 @@ LiveWireImageFunction<TInputImage>
 								break;
 								}
       }
-				if ( !isFaceConnected )
+				if ( !isFaceConnected || scaleFactors[n] <= 0 )
 						{
-						scaleFactors[n] = 0;
+						continue;
 						}
-    if ( scaleFactors[n] > 0 )
+
+    OffsetValueType stride = 0;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
       {
-      scaleFactors[n] = std::sqrt( scaleFactors[n] );
+      stride += offset[d] * offsetTable[d];
       }
+    PointType neighborPoint;
+    image->TransformIndexToPhysicalPoint( startIndex + offset, neighborPoint );
+
+    this->m_NeighborOffsets.push_back( offset );
+    this->m_NeighborStrides.push_back( stride );
+    this->m_NeighborVectors.push_back( neighborPoint - startPoint );
+    this->m_NeighborScales.push_back( std::sqrt( scaleFactors[n] ) );
     }
 
   /**
-   * Generate the PathDirectionImage with Dijkstra's algorithm
+   * The gradient magnitude and zero crossing costs only depend on the
+   * pixel that is entered, hence they are combined once
    */
+  const SizeValueType numberOfPixels = 
+    image->GetBufferedRegion().GetNumberOfPixels();
+  const RealType *rescaledMagnitude = 
+    this->m_RescaledGradientMagnitudeImage->GetBufferPointer();
+  const RealType *zeroCrossing = ( this->m_ZeroCrossingWeight > 0 &&
+    this->m_ZeroCrossingImage ) ? this->m_ZeroCrossingImage->GetBufferPointer() : nullptr;
+
+  this->m_LocalCost.resize( numberOfPixels );
+  for ( SizeValueType i = 0; i < numberOfPixels; i++ )
+    {
+    RealType fz = 0.0;
+    RealType fg = 0.0;
+    if ( zeroCrossing )
+      {
+      fz = 1.0 - zeroCrossing[i];
+      }
+    if ( this->m_GradientMagnitudeWeight > 0.0 )
+      {
+      fg = 1.0 - rescaledMagnitude[i];
+      }
+    this->m_LocalCost[i] = fg * this->m_GradientMagnitudeWeight
+      + fz * this->m_ZeroCrossingWeight;
+    }
 
-  PriorityQueueElementType anchorElement( this->m_AnchorSeed, 0.0 );
+  this->m_SearchTime = this->GetMTime();
+}
 
-  if ( this->m_MaskImage &&
-       this->m_MaskImage->GetPixel( this->m_AnchorSeed )
-         != this->m_InsidePixelValue )
+template <class TInputImage>
+typename LiveWireImageFunction<TInputImage>::SearchState &
+LiveWireImageFunction<TInputImage>
+::GetSearch() const
+{
+  this->PrepareSearch();
+
+  typename SearchListType::iterator it;
+  for ( it = this->m_Searches.begin(); it != this->m_Searches.end(); ++it )
     {
-    itkWarningMacro( "The anchor seed is outside the user-defined mask region." );
-    return;
+    if ( it->m_Anchor == this->m_AnchorSeed )
+      {
+      this->m_Searches.splice( this->m_Searches.begin(), this->m_Searches, it );
+      return this->m_Searches.front();
+      }
     }
 
-  typename PriorityQueueType::Pointer Q = PriorityQueueType::New();
-  Q->Initialize();
-  Q->Push( anchorElement );
+  /**
+   * Start a new search, reusing the buffers of the least recently used
+   * search if the maximum number of searches is reached. Only the pixels
+   * that search reached need to be reset.
+   */
+  const SizeValueType numberOfPixels = 
+    this->GetInputImage()->GetBufferedRegion().GetNumberOfPixels();
+  if ( this->m_Searches.size() < MaximumNumberOfSearches )
+    {
+    this->m_Searches.push_front( SearchState() );
+    this->m_Searches.front().m_Cost.assign( numberOfPixels, 
+      NumericTraits<RealType>::max() );
+    this->m_Searches.front().m_Direction.assign( numberOfPixels, 
+      static_cast<unsigned char>( NoDirection ) );
+    }
+  else
+    {
+    this->m_Searches.splice( this->m_Searches.begin(), this->m_Searches, 
+      --this->m_Searches.end() );
+    SearchState &search = this->m_Searches.front();
+    for ( size_t i = 0; i < search.m_Touched.size(); i++ )
+      {
+      search.m_Cost[ search.m_Touched[i] ] = NumericTraits<RealType>::max();
+      search.m_Direction[ search.m_Touched[i] ] = 
+        static_cast<unsigned char>( NoDirection );
+      }
+    search.m_Touched.clear();
+    search.m_Queue = QueueType();
+    }
 
-  while ( !Q->Empty() )
+  SearchState &search = this->m_Searches.front();
+  search.m_Anchor = this->m_AnchorSeed;
+
+  OffsetValueType anchor = this->GetInputImage()->ComputeOffset( this->m_AnchorSeed );
+  search.m_Cost[anchor] = 0.0;
+  search.m_Touched.push_back( anchor );
+  search.m_Queue.push( QueueElementType( 0.0, anchor ) );
+
+  return search;
+}
+
+template <class TInputImage>
+void
+LiveWireImageFunction<TInputImage>
+::ExpandSearch( SearchState &search, OffsetValueType target ) const
+{
+  const InputImageType *image = this->GetInputImage();
+  const IndexType startIndex = image->GetBufferedRegion().GetIndex();
+  const typename InputImageType::SizeType size = image->GetBufferedRegion().GetSize();
+
+  const unsigned int numberOfNeighbors = 
+    static_cast<unsigned int>( this->m_NeighborScales.size() );
+  const typename GradientImageType::PixelType *gradient = 
+    this->m_GradientImage->GetBufferPointer();
+  const RealType *magnitude = this->m_GradientMagnitudeImage->GetBufferPointer();
+  const MaskPixelType *mask = this->m_MaskImage ? 
+    this->m_MaskImage->GetBufferPointer() : nullptr;
+  const bool useDirection = this->m_GradientDirectionWeight > 0.0;
+
+  /**
+   * Dijkstra's algorithm, stopped as soon as the target is expanded. Queue
+   * entries of pixels that were expanded through a cheaper entry are
+   * skipped when they come up.
+   */
+  while ( !( search.m_Direction[target] & ExpandedFlag ) && !search.m_Queue.empty() )
     {
-    PriorityQueueElementType centerElement = Q->Peek();
-    Q->Pop();
+    QueueElementType centerElement = search.m_Queue.top();
+    search.m_Queue.pop();
 
-    expanded->SetPixel( centerElement.m_Element, true );
-    It.SetLocation( centerElement.m_Element );
-    PointType centerPoint;
-    this->GetInputImage()->TransformIndexToPhysicalPoint(
-      centerElement.m_Element, centerPoint );
+    const OffsetValueType center = centerElement.second;
+    if ( search.m_Direction[center] & ExpandedFlag )
+      {
+      continue;
+      }
+    search.m_Direction[center] |= static_cast<unsigned char>( ExpandedFlag );
 
-				typename GradientImageType::PixelType centerGradient
-						= this->m_GradientImage->GetPixel( centerElement.m_Element );
-    RealType centerNorm
-      = this->m_GradientMagnitudeImage->GetPixel( centerElement.m_Element );
+    const IndexType centerIndex = image->ComputeIndex( center );
+    const typename GradientImageType::PixelType &centerGradient = gradient[center];
+    const RealType centerNorm = magnitude[center];
 
     for ( unsigned int n = 0; n < numberOfNeighbors; n++ )
       {
-      if ( scaleFactors[n] == 0 )
+      const OffsetType &offset = this->m_NeighborOffsets[n];
+      bool inBounds = true;
+      for ( unsigned int d = 0; d < ImageDimension; d++ )
         {
-        continue;
+        const OffsetValueType position = centerIndex[d] + offset[d] - startIndex[d];
+        if ( position < 0 || position >= static_cast<OffsetValueType>( size[d] ) )
+          {
+          inBounds = false;
+          break;
+          }
         }
-      bool inBounds;
-      bool isExpanded = It.GetPixel( n, inBounds );
-      if ( isExpanded || !inBounds )
+      if ( !inBounds )
         {
         continue;
         }
 
-						IndexType neighborIndex = It.GetIndex( n );
-
-						if ( this->m_MaskImage && this->m_MaskImage->GetPixel(
-						  neighborIndex ) != this->m_InsidePixelValue )
-								{
-								continue;
-								}
-
-						typename GradientImageType::PixelType neighborGradient
-								= this->m_GradientImage->GetPixel( neighborIndex );
-						RealType neighborNorm
-						  = this->m_GradientMagnitudeImage->GetPixel( neighborIndex );
+      const OffsetValueType neighbor = center + this->m_NeighborStrides[n];
+      if ( search.m_Direction[neighbor] & ExpandedFlag )
+        {
+        continue;
+        }
+      if ( mask && mask[neighbor] != this->m_InsidePixelValue )
+        {
+        continue;
+        }
 
-						RealType fz = 0.0;
-      RealType fg = 0.0;
       RealType fd = 0.0;
-
-      if ( this->m_ZeroCrossingWeight > 0 && this->m_ZeroCrossingImage )
+      const RealType neighborNorm = magnitude[neighbor];
+      if ( useDirection && neighborNorm > 0 && centerNorm > 0 )
         {
-        fz = 1.0 - this->m_ZeroCrossingImage->GetPixel( neighborIndex );
+        const typename PointType::VectorType &vector = this->m_NeighborVectors[n];
+        const typename GradientImageType::PixelType &neighborGradient = gradient[neighbor];
+        RealType vectorNorm = vector.GetNorm();
+
+        RealType centerMin = vnl_math_min( centerGradient * vector,
+          centerGradient * -vector );
+        RealType neighborMin = vnl_math_min( neighborGradient * vector,
+          neighborGradient * -vector );
+
+        // Rounding may push the cosines just outside [-1, 1]
+        RealType centerCos = vnl_math_max( static_cast<RealType>( -1.0 ), 
+          vnl_math_min( static_cast<RealType>( 1.0 ), centerMin / ( centerNorm * vectorNorm ) ) );
+        RealType neighborCos = vnl_math_max( static_cast<RealType>( -1.0 ), 
+          vnl_math_min( static_cast<RealType>( 1.0 ), neighborMin / ( neighborNorm * vectorNorm ) ) );
+
+        fd = 1.0 - ( std::acos( centerCos ) + std::acos( neighborCos ) ) / vnl_math::pi;
         }
 
-						if ( this->m_GradientMagnitudeWeight > 0.0 )
-								{
-								fg = 1.0 -
-								  this->m_RescaledGradientMagnitudeImage->GetPixel( neighborIndex );
-								}
-						if ( this->m_GradientDirectionWeight > 0.0
-											&& neighborNorm > 0 && centerNorm > 0 )
-								{
-								PointType neighborPoint;
-								this->GetInputImage()->TransformIndexToPhysicalPoint(
-										neighborIndex, neighborPoint );
-								typename PointType::VectorType vector
-										= neighborPoint - centerPoint;
-								RealType vectorNorm = vector.GetNorm();
-
-								RealType centerMin = vnl_math_min( centerGradient * vector,
-										centerGradient * -vector );
-								RealType neighborMin = vnl_math_min( neighborGradient * vector,
-										neighborGradient * -vector );
-
-								fd = 1.0 - ( std::acos( centerMin / ( centerNorm * vectorNorm ) ) +
-										std::acos( neighborMin / ( neighborNorm * vectorNorm ) ) )
-										/ vnl_math::pi;
-								}
+      const RealType neighborCost = centerElement.first + this->m_NeighborScales[n] *
+        ( this->m_LocalCost[neighbor] + fd * this->m_GradientDirectionWeight );
 
-						RealType neighborCost
-						  = centerElement.m_Priority + scaleFactors[n] *
-        ( fg * this->m_GradientMagnitudeWeight
-								+ fz * this->m_ZeroCrossingWeight
-								+ fd * this->m_GradientDirectionWeight );
-
-            PriorityQueueElementType neighborElement( neighborIndex, neighborCost );
-            if ( neighborCost < costImage->GetPixel( neighborIndex ) ) {
-              costImage->SetPixel( neighborIndex, neighborCost );
-              this->m_PathDirectionImage->SetPixel( neighborIndex,
-								  centerElement.m_Element - neighborElement.m_Element );
-              Q->Push( neighborElement );
-              }
-
-						PriorityQueueElementType element = Q->Peek();
-						while ( expanded->GetPixel( element.m_Element ) )
-								{
-								Q->Pop();
-								element = Q->Peek();
-								}
-            }
+      if ( neighborCost < search.m_Cost[neighbor] )
+        {
+        if ( search.m_Direction[neighbor] == NoDirection )
+          {
+          search.m_Touched.push_back( neighbor );
+          }
+        search.m_Cost[neighbor] = neighborCost;
+        search.m_Direction[neighbor] = 
+          static_cast<unsigned char>( numberOfNeighbors - 1 - n );
+        search.m_Queue.push( QueueElementType( neighborCost, neighbor ) );
+        }
+      }
     }
 }
 
@@ -348,14 +425,42 @@ LiveWireImageFunction<TInputImage>
     return nullptr;
     }
 
+  if ( !this->IsInsideBuffer( this->m_AnchorSeed ) )
+    {
+    itkWarningMacro( "The anchor seed is not inside buffer." );
+    return nullptr;
+    }
+
+  if ( this->m_MaskImage &&
+       this->m_MaskImage->GetPixel( this->m_AnchorSeed )
+         != this->m_InsidePixelValue )
+    {
+    itkWarningMacro( "The anchor seed is outside the user-defined mask region." );
+    return nullptr;
+    }
+
+  SearchState &search = this->GetSearch();
+  const OffsetValueType target = this->GetInputImage()->ComputeOffset( index );
+  this->ExpandSearch( search, target );
+
+  if ( !( search.m_Direction[target] & ExpandedFlag ) )
+    {
+    itkWarningMacro( "The index cannot be reached from the anchor seed." );
+    return nullptr;
+    }
+
   typename OutputType::Pointer output = OutputType::New();
   output->Initialize();
 
   IndexType currentIndex = index;
+  OffsetValueType current = target;
   while ( currentIndex != this->m_AnchorSeed )
     {
     output->AddVertex( VertexType( currentIndex ) );
-    currentIndex += this->m_PathDirectionImage->GetPixel( currentIndex );
+    const unsigned int n = search.m_Direction[current] & 
+      static_cast<unsigned char>( ~ExpandedFlag );
+    currentIndex += this->m_NeighborOffsets[n];
+    current += this->m_NeighborStrides[n];
     }
   output->AddVertex( VertexType( currentIndex ) );
 
@@ -27,17 +27,20 @@
 */
 
 // STL includes
+#include <algorithm>
 #include <fstream>
 
 // Boost includes
 #include <boost/array.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
  
 // Core includes
 #include <Core/DataBlock/StdDataBlock.h>
 #include <Core/Isosurface/Isosurface.h>
 #include <Core/Isosurface/IsosurfaceExporter.h>
-#include <Core/Utils/StackVector.h>
-#include <Core/Utils/Parallel.h>
+#include <Core/Isosurface/MeshDecimator.h>
+#include <Core/Utils/ThreadPool.h>
 #include <Core/Utils/Log.h>
 #include <Core/Graphics/VertexBufferObject.h>
 #include <Core/RenderResources/RenderResources.h>
@@ -357,53 +360,165 @@ public:
 typedef boost::shared_ptr< VertexBufferBatch > VertexBufferBatchHandle;
 
 #if defined (_WIN32) || defined(__APPLE__)
-const std::string Isosurface::EXPORT_FORMATS_C( "VTK (*.vtk);;OBJ (*.obj);;ASCII (*.fac *.pts *.val);;ASCII STL (*.stl);;Binary STL (*.stl)" );
+const std::string Isosurface::EXPORT_FORMATS_C( "VTK (*.vtk);;OBJ (*.obj);;Binary PLY (*.ply);;ASCII (*.fac *.pts *.val);;ASCII STL (*.stl);;Binary STL (*.stl)" );
 #else
-const std::string Isosurface::EXPORT_FORMATS_C( "VTK (*.vtk);;OBJ (*.obj);;ASCII (*.fac *.pts *.val);;ASCII STL (*.stl);;Binary STL (*.stl *)" );
+const std::string Isosurface::EXPORT_FORMATS_C( "VTK (*.vtk);;OBJ (*.obj);;Binary PLY (*.ply);;ASCII (*.fac *.pts *.val);;ASCII STL (*.stl);;Binary STL (*.stl *)" );
 #endif
 
 // Binary STL handled as special case in LayerIOFunctions::ExportIsosurface
     const FilterMap Isosurface::EXPORT_FORMATS_MAP_C = { { "VTK (*.vtk)", ".vtk" }, {"OBJ (*.obj)", ".obj"},
-        { "ASCII (*.fac *.pts *.val)", ".fac" }, { "ASCII STL (*.stl)", ".stl" } };
+        { "Binary PLY (*.ply)", ".ply" }, { "ASCII (*.fac *.pts *.val)", ".fac" }, { "ASCII STL (*.stl)", ".stl" } };
+
+// ISOSURFACESLAB:
+// The part of the isosurface that is generated by a range of marching cube layers along z. The
+// points on the first plane of a slab are stored first, in an order that only depends on the
+// mask data in that plane. Faces refer either to the points of the slab itself or, if
+// NEXT_SLAB_C is set, to the points on the first plane of the next slab. Hence a slab can be 
+// regenerated without renumbering the points of its neighbors.
+class IsosurfaceSlab
+{
+public:
+  IsosurfaceSlab() :
+    plane_points_( 0 ),
+    area_( 0.0f )
+  {
+  }
+
+  PointFVector points_;
+  VectorFVector normals_;
+  UIntVector faces_;
+
+  // Number of points on the first plane of the slab
+  size_t plane_points_;
+
+  // Surface area of the faces of the slab
+  float area_;
+};
+
+// ISOSURFACELEVEL:
+// A decimated version of the isosurface. It is split into the same render batches as the full
+// resolution mesh.
+class IsosurfaceLevel
+{
+public:
+  IsosurfaceLevel() :
+    area_( 0.0f ),
+    error_( 0.0 )
+  {
+  }
+
+  PointFVector points_;
+  VectorFVector normals_;
+  UIntVector faces_;
+  float area_;
+
+  // Largest quadric error of the collapses that produced this level and the levels before it
+  double error_;
+
+  // Partitioning of the mesh into batches
+  MeshDecimator::range_vector_type part_points_;
+  MeshDecimator::range_vector_type part_faces_;
+  std::vector< UIntVector > part_indices_;
+};
 
 class IsosurfacePrivate 
 {
 
 public:
-  void downsample_setup( int num_threads, double quality_factor );
+  void downsample_setup( double quality_factor );
 
   // PARALLEL_DOWNSAMPLE:
   // Downsample mask prior to computing the isosurface in order to reduce the mesh to speed up
-  // rendering.
-  void parallel_downsample_mask( int thread, int num_threads, boost::barrier& barrier, 
-    double quality_factor );
+  // rendering. Each call processes the range [ z_begin, z_end ) of downsampled slices.
+  void parallel_downsample_mask( size_t z_begin, size_t z_end );
 
   // Copy values to members just to simplify and shorten code.  Must be called after downsample
   // and before face computation.
   void compute_setup();
 
-  // SETUP:
-  // Setup the algorithm and the buffers for face computation
-  void compute_faces_setup( int num_threads );
+  // FIND_CHANGED_SLICES:
+  // Mark the slices of the compute mask that were modified since the slabs were computed.
+  // Returns false if the modifications were not recorded per slice and everything needs to be
+  // recomputed.
+  bool find_changed_slices( std::vector< char >& slice_changed );
+
+  // FIND_DIRTY_SLABS:
+  // Determine which slabs need to be regenerated, either all of them if no changed slices are
+  // given, or only the ones that touch the changed slices. Returns false if all the slabs were
+  // reset.
+  bool find_dirty_slabs( const std::vector< char >* slice_changed );
 
-  // PARALLEL_COMPUTE_FACES:
-  // Parallelized isosurface computation algorithm 
-  void parallel_compute_faces( int thread, int num_threads, boost::barrier& barrier );
+  // COMPUTE_PLANE_POINTS:
+  // Add the points on the split edges in plane z and record their indices in the edge tables.
+  void compute_plane_points( size_t z, UIntVector& edge_x, UIntVector& edge_y, 
+    PointFVector& points, unsigned int flag );
+
+  // COMPUTE_SLAB:
+  // Run marching cubes over the layers of one slab.
+  void compute_slab( size_t slab );
+
+  // PARALLEL_COMPUTE_SLABS:
+  // Regenerate the dirty slabs [ begin, end ).
+  void parallel_compute_slabs( size_t begin, size_t end );
+
+  // PARALLEL_COMPUTE_NORMALS:
+  // Recompute the normals of slabs [ begin, end ) from the list of slabs with outdated normals.
+  void parallel_compute_normals( size_t begin, size_t end );
+
+  // PARALLEL_MERGE_SLABS:
+  // Copy slabs [ begin, end ) into the combined mesh. The index one past the last slab refers
+  // to the caps.
+  void parallel_merge_slabs( size_t begin, size_t end );
 
   void translate_cap_coords( int cap_num, float i, float j, float& x, float& y, float& z );
 
   size_t get_data_index( float x, float y, float z );
 
+  // COMPUTE_CAP:
+  // Compute the faces of one of the six caps into cap_slabs_ and record the area of each of its
+  // triangles in cap_areas_.
+  void compute_cap( int cap_num );
+
+  // PARALLEL_COMPUTE_CAPS:
+  // Compute caps [ begin, end ).
+  void parallel_compute_caps( size_t begin, size_t end );
+
+  // PARALLEL_MERGE_CAPS:
+  // Copy caps [ begin, end ) into the combined caps, offsetting their face indices.
+  void parallel_merge_caps( size_t begin, size_t end );
+
   // COMPUTE_CAP_FACES:
   // Compute the "cap" faces at the boundary of the mask volume to handle the case where the 
   // mask goes all the way to the boundary.  Otherwise, we end up with holes in the 
   // isosurface at the boundary.  The cap faces are computed as separate geometry so that they can 
-  // be turned on/off independently from the rest of the isosurface.
-  void compute_cap_faces();
-
-  // PARALLEL_COMPUTE_NORMALS:
-  // Parallelized isosurface normal computation algorithm 
-  void parallel_compute_normals( int thread, int num_threads,  boost::barrier& barrier );
+  // be turned on/off independently from the rest of the isosurface. The six caps are computed
+  // in parallel and concatenated in order, so the result does not depend on the number of
+  // threads. Returns false if the computation was aborted.
+  bool compute_cap_faces();
+
+  // MERGE_SLABS:
+  // Rebuild the combined points, normals and faces from the slabs and caps.
+  bool merge_slabs();
+
+  // UPDATE_PARTITION:
+  // Update the partitioning of the mesh into batches for rendering. Batches are made up of 
+  // whole slabs and are only rebuilt if a full computation was done, so the batches of the 
+  // slabs that did not change can remain on the graphics card.
+  void update_partition( bool rebuild );
+
+  // PARALLEL_REMAP_PARTITIONS:
+  // Fill the local face indices [ begin, end ) of the changed parts, as numbered by
+  // remap_offset_.
+  void parallel_remap_partitions( size_t begin, size_t end );
+
+  // PARALLEL_UPDATE_LEVEL_INDICES:
+  // Fill the local face indices of batches [ begin, end ) of the last level of detail.
+  void parallel_update_level_indices( size_t begin, size_t end );
+
+  // GET_LEVEL:
+  // Get a level of detail, or null for the full resolution mesh and for levels that have not 
+  // been computed.
+  const IsosurfaceLevel* get_level( size_t level_of_detail ) const;
 
   // UPLOAD_TO_VERTEX_BUFFER:
   void upload_to_vertex_buffer();
@@ -417,8 +532,6 @@ public:
   // Downsample params
   MaskVolumeHandle downsample_mask_volume_;
   int neighborhood_size_;
-  size_t zsize_;
-  size_t total_neighborhoods_;
 
   // Input to isosurface computation, not downsampled
   MaskVolumeHandle orig_mask_volume_; 
@@ -441,49 +554,83 @@ public:
   unsigned char* data_; // Mask data is stored in bit-plane (8 masks per data block)
   size_t nx_, ny_, nz_; // Mask dimensions of original or downsampled volume depending on quality
   size_t elem_nx_, elem_ny_, elem_nz_; // Number of (marching) cubes
-
-  UCharVector type_buffer_;
-  std::vector< UIntVector > edge_buffer_;
-
-  UIntVector min_point_index_;
-  UIntVector max_point_index_;
-  UIntVector min_face_index_;
-  UIntVector max_face_index_;
-
+  GridTransform grid_transform_;
+
+  // Isosurface without the caps, split into slabs along z
+  std::vector< IsosurfaceSlab > slabs_;
+  // The caps of the isosurface
+  IsosurfaceSlab caps_;
+  bool capping_enabled_;
+
+  // The six caps while they are computed, the areas of their triangles and their offsets in 
+  // the combined caps
+  std::vector< IsosurfaceSlab > cap_slabs_;
+  std::vector< FloatVector > cap_areas_;
+  IVector cap_point_offset_;
+  IVector cap_face_offset_;
+
+  // Parameters and mask generation the slabs were computed with
+  double quality_factor_;
+  DataBlock::generation_type generation_;
+
+  // Slabs that need to be regenerated and slabs whose normals need to be recomputed
+  IVector dirty_slabs_;
+  IVector normal_slabs_;
+  std::vector< char > slab_dirty_;
+
+  // Offsets of the slabs in the combined points and faces
+  IVector slab_point_offset_;
+  IVector slab_face_offset_;
+
+  // Progress of the slab computation
+  size_t slabs_done_;
+  boost::mutex progress_mutex_;
+
+  // Partitioning of the mesh into batches, the last batch holds the caps if there are any
+  std::vector< std::pair< size_t, size_t > > part_slabs_;
   std::vector< std::pair< unsigned int, unsigned int > > part_points_;
   std::vector< std::pair< unsigned int, unsigned int > > part_faces_;
   std::vector< UIntVector > part_indices_;
+  std::vector< char > part_changed_;
 
-  std::vector< PointFVector > new_points_; 
-  std::vector< std::vector< StackVector< size_t, 3 > > > new_elems_;
-  FloatVector new_elem_areas_;
+  // Changed parts whose local indices are rebuilt and the prefix sum of their sizes
+  IVector remap_parts_;
+  IVector remap_offset_;
 
-  IVector front_offset_;
-  IVector back_offset_;
-  size_t global_point_cnt_;
-
-  unsigned int prev_point_min_;
-  unsigned int prev_point_max_;
+  // Levels of detail, starting at level 1, the level that is rendered and the level that was 
+  // uploaded to the vertex buffers
+  std::vector< IsosurfaceLevel > levels_;
+  size_t level_of_detail_;
+  size_t vbo_level_of_detail_;
 
   std::vector< VertexBufferBatchHandle > vbo_batches_;
   bool vbo_available_;
   bool surface_changed_;
   bool values_changed_;
 
-  bool need_abort_;
   boost::function< bool () > check_abort_;
 
   const static double COMPUTE_PERCENT_PROGRESS_C;
   const static double NORMAL_PERCENT_PROGRESS_C;
   const static double PARTITION_PERCENT_PROGRESS_C;
+
+  // Number of layers of marching cubes in a slab
+  const static size_t SLAB_SIZE_C;
+  // Flag that marks a face index as referring to the next slab
+  const static unsigned int NEXT_SLAB_C;
+  // Number of face indices remapped per task
+  const static size_t REMAP_GRAIN_C;
 };
 
 // Initialize static variables
 const double IsosurfacePrivate::COMPUTE_PERCENT_PROGRESS_C = 0.8;
 const double IsosurfacePrivate::NORMAL_PERCENT_PROGRESS_C = 0.05;
 const double IsosurfacePrivate::PARTITION_PERCENT_PROGRESS_C = 0.15; 
+const size_t IsosurfacePrivate::SLAB_SIZE_C = 16;
+const unsigned int IsosurfacePrivate::NEXT_SLAB_C = 0x80000000;
+const size_t IsosurfacePrivate::REMAP_GRAIN_C = 1 << 16;
 
-void IsosurfacePrivate::downsample_setup( int num_threads, double quality_factor )
+void IsosurfacePrivate::downsample_setup( double quality_factor )
 {
   this->nx_ = this->orig_mask_volume_->get_mask_data_block()->get_nx();
   this->ny_ = this->orig_mask_volume_->get_mask_data_block()->get_ny();
@@ -519,25 +666,6 @@ void IsosurfacePrivate::downsample_setup( int num_threads, double quality_factor
 
   // Point to downsampled mask rather than original mask
   this->compute_mask_volume_ = this->downsample_mask_volume_;
-
-  // For parallelization, divide mask into slabs along z.  No synchronization is needed.
-  this->zsize_ = static_cast< size_t >( this->nz_ / num_threads );
-  // Make sure this zsize will cover all the data
-  if ( this->zsize_ * num_threads < this->nz_ ) 
-  {
-    this->zsize_++;
-  }
-  int remainder = this->zsize_ % this->neighborhood_size_;
-  // Round up to the next neighborhood increment -- leaves least work for last thread
-  if( remainder != 0 )
-  {
-    this->zsize_ += ( this->neighborhood_size_ - remainder );
-  }
-
-  size_t x_neighborhoods = this->nx_ / this->neighborhood_size_;
-  size_t y_neighborhoods = this->ny_ / this->neighborhood_size_;
-  size_t z_neighborhoods = this->zsize_ / this->neighborhood_size_;
-  this->total_neighborhoods_ = x_neighborhoods * y_neighborhoods * z_neighborhoods;
 }
 
 /*
@@ -545,41 +673,27 @@ Allow downsampling by only half, quarter, and eighth.  When downsampling by half
 neighborhood of nodes is downsampled to a single node.  If at least one neighborhood node is "on", 
 result is "on".  This method was chosen to prevent holes in the downsampled data.
 */
-void IsosurfacePrivate::parallel_downsample_mask( int thread, int num_threads, 
-  boost::barrier& barrier, double quality_factor )
+void IsosurfacePrivate::parallel_downsample_mask( size_t z_begin, size_t z_end )
 {
-  // Only need to setup once 
-  if( thread == 0 )
-  {
-    this->downsample_setup( num_threads, quality_factor );
-  }
-
-  // All threads must wait for setup to complete
-  barrier.wait();
-
-  // Different thread process slabs along the z axis.  Each slab contains one or more 
-  // neighborhoods to be downsampled.
-  // [nzstart, nzend) 
-  size_t nzstart = thread * this->zsize_;
-  size_t nzend = ( thread + 1 ) * this->zsize_;
-  if ( nzend > this->nz_ ) 
-  {
-    nzend = this->nz_;
-  }
-
+  // Different tasks process different downsampled slices along the z axis, each downsampled
+  // slice covers a slab of neighborhood_size_ slices. No synchronization is needed.
   unsigned char* downsampled_data = 
     this->downsample_mask_volume_->get_mask_data_block()->get_mask_data();
 
   size_t z_offset = this->nx_ * this->ny_;
   unsigned char not_mask_value = ~( this->mask_value_ );
 
-  size_t target_index = thread * this->total_neighborhoods_;
+  size_t x_neighborhoods = this->nx_ / this->neighborhood_size_;
+  size_t y_neighborhoods = this->ny_ / this->neighborhood_size_;
+
+  size_t target_index = z_begin * x_neighborhoods * y_neighborhoods;
   size_t x_start_end = this->nx_ - this->neighborhood_size_ + 1;
   size_t y_start_end = this->ny_ - this->neighborhood_size_ + 1;
-  size_t z_start_end = nzend - this->neighborhood_size_ + 1;
+  size_t z_start_end = z_end * this->neighborhood_size_;
 
   // Loop over neighborhoods, chop off border values
-  for ( size_t z_start = nzstart; z_start < z_start_end; z_start += this->neighborhood_size_ ) 
+  for ( size_t z_start = z_begin * this->neighborhood_size_; z_start < z_start_end; 
+    z_start += this->neighborhood_size_ ) 
   {
     for ( size_t y_start = 0; y_start < y_start_end; y_start += this->neighborhood_size_ ) 
     {
@@ -630,455 +744,251 @@ void IsosurfacePrivate::compute_setup()
 
   // Bit where mask bit is stored
   this->mask_value_ = this->compute_mask_volume_->get_mask_data_block()->get_mask_value();
-}
 
-void IsosurfacePrivate::compute_faces_setup( int num_threads )
-{
   // Number of elements (cubes) in each dimension
   this->elem_nx_ = this->nx_ - 1;
   this->elem_ny_ = this->ny_ - 1;
   this->elem_nz_ = this->nz_ - 1;
 
-  // Stores index into polygon configuration table for each element (cube)?
-  // Why +1?  Maybe just padding for safety?
-  this->type_buffer_.resize( ( this->nx_ + 1 ) * ( this->ny_ + 1 ) );
-  // For each element (cube), holds edge ID (12 edges) back_buffer_x, back_buffer_y, 
-  // front_buffer_x, front_buffer_y, and side_buffer 
-  this->edge_buffer_.resize( 5 ); 
-  for ( size_t q = 0; q < 5; q++ )
+  // Get mask transform from MaskVolume 
+  this->grid_transform_ = this->compute_mask_volume_->get_grid_transform();
+}
+
+bool IsosurfacePrivate::find_changed_slices( std::vector< char >& slice_changed )
+{
+  MaskDataBlockHandle mask = this->orig_mask_volume_->get_mask_data_block();
+  size_t scale = static_cast< size_t >( this->neighborhood_size_ );
+  slice_changed.assign( this->nz_, 0 );
+
+  // Data blocks that are not registered do not have a valid generation
+  DataBlock::generation_type generation = mask->get_generation();
+  if ( generation < 0 ) return false;
+  if ( generation == this->generation_ ) return true;
+
+  DataBlock::generation_type last_recorded = -1;
+  for ( size_t z = 0; z < mask->get_nz(); z++ )
   {
-    this->edge_buffer_[ q ].resize( ( this->nx_ + 1 ) * ( this->ny_ + 1 ) );
+    DataBlock::generation_type slice_generation = mask->get_slice_generation( z );
+    last_recorded = std::max( last_recorded, slice_generation );
+    if ( slice_generation > this->generation_ && z / scale < this->nz_ )
+    {
+      slice_changed[ z / scale ] = 1;
+    }
   }
 
-  // Interpolated edge points for isosurface per thread
-  this->new_points_.resize( num_threads );
+  // If the last change of the data was not recorded per slice, everything needs to be redone
+  return last_recorded == generation;
+}
 
-  // Vector of face indices per triangle, per thread
-  this->new_elems_.resize( num_threads );
-  // Surface areas of generated triangles per thread
-  this->new_elem_areas_.resize( num_threads, 0 );
-  // Offset allows zero-based indexing over multiple slices
-  this->front_offset_.resize( num_threads, 0 );
-  this->back_offset_.resize( num_threads, 0 ); 
+bool IsosurfacePrivate::find_dirty_slabs( const std::vector< char >* slice_changed )
+{
+  size_t num_slabs = 0;
+  if ( this->nx_ > 1 && this->ny_ > 1 && this->nz_ > 1 )
+  {
+    num_slabs = ( this->elem_nz_ + SLAB_SIZE_C - 1 ) / SLAB_SIZE_C;
+  }
 
-  // Total number of isosurface points
-  this->global_point_cnt_ = 0;
+  bool update = slice_changed != 0 && this->slabs_.size() == num_slabs;
+  if ( !update )
+  {
+    this->slabs_.clear();
+    this->slabs_.resize( num_slabs );
+    this->slab_dirty_.assign( num_slabs, 1 );
+  }
+  else
+  {
+    // A slab reads the slices from its first layer up to and including its last layer, hence
+    // a slice on the boundary between two slabs affects both of them
+    this->slab_dirty_.assign( num_slabs, 0 );
+    for ( size_t z = 0; z < slice_changed->size() && num_slabs > 0; z++ )
+    {
+      if ( !( *slice_changed )[ z ] ) continue;
+      this->slab_dirty_[ std::min( z / SLAB_SIZE_C, num_slabs - 1 ) ] = 1;
+      if ( z > 0 && z % SLAB_SIZE_C == 0 ) this->slab_dirty_[ z / SLAB_SIZE_C - 1 ] = 1;
+    }
+  }
 
-  this->min_point_index_.resize( this->elem_nz_ );
-  this->max_point_index_.resize( this->elem_nz_ );
-  this->min_face_index_.resize( this->elem_nz_ );
-  this->max_face_index_.resize( this->elem_nz_ );
+  this->dirty_slabs_.clear();
+  this->normal_slabs_.clear();
+  for ( size_t k = 0; k < num_slabs; k++ )
+  {
+    if ( this->slab_dirty_[ k ] ) this->dirty_slabs_.push_back( k );
+    // The normals of the first plane of a slab depend on the faces of the previous slab
+    if ( this->slab_dirty_[ k ] || ( k > 0 && this->slab_dirty_[ k - 1 ] ) )
+    {
+      this->normal_slabs_.push_back( k );
+    }
+  }
 
-  this->prev_point_min_ = 0;
-  this->prev_point_max_ = 0;
-  
-  this->need_abort_ = false;
+  return update;
+}
+
+void IsosurfacePrivate::compute_plane_points( size_t z, UIntVector& edge_x, UIntVector& edge_y, 
+  PointFVector& points, unsigned int flag )
+{
+  // Since mask values are either on or off, no need to interpolate 
+  // between vertices along edges.  Always put point in center of edge.
+  const float INTERP_EDGE_OFFSET_C = 0.5f;
+
+  unsigned char* data = this->data_ + z * ( this->nx_ * this->ny_ );
+  size_t q = 0;
+  for ( size_t y = 0; y < this->ny_; y++ )
+  {
+    for ( size_t x = 0; x < this->nx_; x++, q++ )
+    {
+      // Edge along the x direction
+      if ( x + 1 < this->nx_ && ( ( data[ q ] ^ data[ q + 1 ] ) & this->mask_value_ ) )
+      {
+        edge_x[ q ] = flag | static_cast< unsigned int >( points.size() );
+        points.push_back( this->grid_transform_.project( PointF( 
+          static_cast< float >( x ) + INTERP_EDGE_OFFSET_C, static_cast< float >( y ), 
+          static_cast< float >( z ) ) ) );
+      }
 
+      // Edge along the y direction
+      if ( y + 1 < this->ny_ && ( ( data[ q ] ^ data[ q + this->nx_ ] ) & this->mask_value_ ) )
+      {
+        edge_y[ q ] = flag | static_cast< unsigned int >( points.size() );
+        points.push_back( this->grid_transform_.project( PointF( 
+          static_cast< float >( x ), static_cast< float >( y ) + INTERP_EDGE_OFFSET_C, 
+          static_cast< float >( z ) ) ) );
+      }
+    }
+  }
 }
 
 /*
 Basic ideas:
-- Move through volume two slices at a time along z axis.  Back and front refer to these two slices.
+- The volume is split into slabs of SLAB_SIZE_C layers of cubes along the z axis. Each slab is 
+  computed independently, so slabs are processed in parallel and when the mask is edited only 
+  the slabs that touch the modified slices need to be regenerated.
+- Move through a slab two slices at a time along z axis.  Back and front refer to these two 
+  slices.
 - Points are shared by multiple triangles in the isosurface.  We don't want to store a copy of a
   point for each triangle.  In order to avoid duplicates, we go through edges in one direction at a 
   time, looking at edges that need to be split.  This way we encounter each edge only once.
 - Sort edges into 5 configurations
-  - back_buffer_x - Edges along the x direction on the back buffer (slice) 
-  - back_buffer_y - Edges along the y direction on the back buffer (slice)
-  - front_buffer_x - Edges along the x direction on the front buffer (slice)
-  - front_buffer_y - Edges along the y direction on the front buffer (slice)
-  - side_buffer - Edges along the sides between the back and front buffers (slices)
+  - back_x - Edges along the x direction on the back buffer (slice) 
+  - back_y - Edges along the y direction on the back buffer (slice)
+  - front_x - Edges along the x direction on the front buffer (slice)
+  - front_y - Edges along the y direction on the front buffer (slice)
+  - side - Edges along the sides between the back and front buffers (slices)
 - These are tables of split edges with indices into a points vector of actual points.
-- Number points as you encounter split edges.
+- The points on the last plane of a slab belong to the next slab, where they are the first points
+  that are generated. As their order only depends on the data in that plane, faces can refer to
+  them by their index in the next slab. This keeps the mesh watertight across slab boundaries.
 - After edge tables are built, go back to type list, use configurations to lookup into the tables.
-- Tables are built in parallel using relative indices per thread.
-- Parallel point lists are merged together at the end.
 - At end, swap front and back data (front is now back).
 - One advantage of this approach is that we don't need complex and confusing linked lists; we can
   use tables that directly correspond to elements.
 - Point of confusion: sometimes "element" is synonymous with "cube" and sometimes it refers
   to a triangle.
 */
-void IsosurfacePrivate::parallel_compute_faces( int thread, int num_threads, 
-  boost::barrier& barrier )
+void IsosurfacePrivate::compute_slab( size_t slab_index )
 {
-  // Setup the algorithm and the buffers
-  if ( thread == 0 ) // Only need to setup once 
-  {
-    this->compute_faces_setup( num_threads ); 
-  }
+  IsosurfaceSlab& slab = this->slabs_[ slab_index ];
+  slab.points_.clear();
+  slab.normals_.clear();
+  slab.faces_.clear();
+  slab.area_ = 0.0f;
 
-  // An object of class barrier is a synchronization primitive used to cause a set of threads 
-  // to wait until they each perform a certain function or each reach a particular point in their 
-  // execution.  This mechanism proves useful in situations where processing progresses in 
-  // stages and completion of the current stage by all threads is the entry criteria for the next 
-  // stage.
-  barrier.wait();
-
-  // In order to parallelize the algorithm, each thread processes a different horizontal strip
-  // of data
-  // Determine the element (cube) range for each thread in the y dimension
-  size_t ysize = static_cast< size_t >( this->ny_ / num_threads );
-  if ( ysize * num_threads < this->ny_ ) 
-  {
-    ysize++;
-  }
+  size_t nx = this->nx_;
+  size_t nxy = this->nx_ * this->ny_;
+  size_t z_begin = slab_index * SLAB_SIZE_C;
+  size_t z_end = std::min( z_begin + SLAB_SIZE_C, this->elem_nz_ );
+  bool has_next_slab = z_end < this->elem_nz_;
 
-  size_t nystart = thread * ysize;
-  size_t nyend = ( thread + 1 ) * ysize;
-  if ( nyend > this->ny_ ) 
-  {
-    nyend = this->ny_;
-  }
+  // Edge tables for the back and front slices and the sides between them
+  UIntVector back_x( nxy ), back_y( nxy );
+  UIntVector front_x( nxy ), front_y( nxy );
+  UIntVector side( nxy );
 
-  size_t elem_ysize = static_cast< size_t >( this->elem_ny_ / num_threads );
-  if ( elem_ysize * num_threads < this->elem_ny_ ) 
-  {
-    elem_ysize++;
-  }
+  // Points on the first plane of the next slab, only used to compute the surface area
+  PointFVector next_points;
 
-  size_t elem_nystart = thread * elem_ysize;
-  size_t elem_nyend = ( thread + 1 ) * elem_ysize;
-  if ( elem_nyend > this->elem_ny_ ) 
-  {
-    elem_nyend = this->elem_ny_;
-  }
+  // Since mask values are either on or off, no need to interpolate 
+  // between vertices along edges.  Always put point in center of edge.
+  const float INTERP_EDGE_OFFSET_C = 0.5f;
 
-  // Each thread generates new points for the isosurface
-  PointFVector& points = this->new_points_[ thread ];
-  // StackVector is a SCIRun class.  
-  // StackVector implements a subclass of the std::vector class, except that
-  // the vector is statically allocated on the stack for performance.
-  // elems = triangles
-  std::vector< StackVector < size_t, 3 > >& elements = this->new_elems_[ thread ];
+  this->compute_plane_points( z_begin, back_x, back_y, slab.points_, 0 );
+  slab.plane_points_ = slab.points_.size();
 
-  // mark the point counter with the process number
-  unsigned int point_cnt = 0;
+  // Pointers into the edge tables for each of the 12 edges of a cube
+  unsigned int* edge_table[ 12 ];
 
-  // Vector of pointers into edge_buffer_ for each of the 12 edges.  edge_buffer_ has indices into
-  // vector of actual points.
-  std::vector< unsigned int* > edge_table( 12 );
-
-  barrier.wait();
-
-  // See function description
-  int back_buffer_x = 0;
-  int back_buffer_y = 1;
-  int front_buffer_x = 2;
-  int front_buffer_y = 3;
-  int side_buffer = 4;
-
-  StackVector< size_t, 3 > elems( 3 );    
-
-  // Get mask transform from MaskVolume 
-  GridTransform grid_transform = this->compute_mask_volume_->get_grid_transform();
-
-  // Loop over all the slices
-  for ( size_t z = 0;  z < this->elem_nz_; z++ ) 
+  for ( size_t z = z_begin; z < z_end; z++ )
   {
     // Process two adjacent slices at a time (back and front)
     // Get pointer to beginning of each slice in the data
-    unsigned char* data1 = this->data_ + z * ( this->nx_ * this->ny_ );
-    unsigned char* data2 = this->data_ + ( z + 1 ) * ( this->nx_ * this->ny_ );
-
-    points.clear();
-    point_cnt = thread<<24; // upper 8 bits are used to store thread id -- efficiency trick
+    unsigned char* data1 = this->data_ + z * nxy;
+    unsigned char* data2 = this->data_ + ( z + 1 ) * nxy;
 
-    // References to back/front/side tables
-    UIntVector& back_edge_x = this->edge_buffer_[ back_buffer_x ];
-    UIntVector& back_edge_y = this->edge_buffer_[ back_buffer_y ];
-
-    UIntVector& front_edge_x = this->edge_buffer_[ front_buffer_x ];
-    UIntVector& front_edge_y = this->edge_buffer_[ front_buffer_y ];
-
-    UIntVector& side_edge = this->edge_buffer_[ side_buffer ];
-
-    // Use relative offsets to find edges
-    edge_table[ 0 ] = &( this->edge_buffer_[ back_buffer_x ][ 0 ] );
-    edge_table[ 1 ] = &( this->edge_buffer_[ back_buffer_y ][ 1 ] );
-    edge_table[ 2 ] = &( this->edge_buffer_[ back_buffer_x ][ this->nx_ ] );
-    edge_table[ 3 ] = &( this->edge_buffer_[ back_buffer_y ][ 0 ] );
-
-    edge_table[ 4 ] = &( this->edge_buffer_[ front_buffer_x ][ 0 ] );
-    edge_table[ 5 ] = &( this->edge_buffer_[ front_buffer_y ][ 1 ] );
-    edge_table[ 6 ] = &( this->edge_buffer_[ front_buffer_x ][ this->nx_ ] );
-    edge_table[ 7 ] = &( this->edge_buffer_[ front_buffer_y ][ 0 ] );
-
-    edge_table[ 8 ] = &( this->edge_buffer_[ side_buffer ][ 0 ] );
-    edge_table[ 9 ] = &( this->edge_buffer_[ side_buffer ][ 1 ] );
-    edge_table[ 10 ] = &( this->edge_buffer_[ side_buffer ][ this->nx_ ] );
-    edge_table[ 11 ] = &( this->edge_buffer_[ side_buffer ][ this->nx_ + 1 ] );
-
-    // Step 1: determine the type of marching cube pattern (triangles) that needs
-    // to go in each element (cube) and the intersecting points on each edge
-
-    // Loop over horizontal strip of elements (cubes)
-    for ( size_t y = nystart; y < nyend; y++ )
+    // Step 1: find the intersecting points on each edge
+    if ( z + 1 == z_end && has_next_slab )
     {
-      for ( size_t x = 0; x < this->nx_; x++ )
-      {
-        // There are dim - 1 elements (cubes)
-        if ( x < this->elem_nx_ && y < this->elem_ny_ )
-        {
-          // type = index into polygonal configuration table
-          unsigned char type = 0;
-          size_t q = y * this->nx_ + x; // Index into data
-          // An 8 bit index is formed where each bit corresponds to a vertex 
-          // Bit on if vertex is inside surface, off otherwise
-          if ( data1[ q ] & this->mask_value_ )         type |= 0x1;
-          if ( data1[ q + 1 ] & this->mask_value_ )       type |= 0x2;
-          if ( data1[ q + this->nx_ + 1 ] & this->mask_value_ ) type |= 0x4;
-          if ( data1[ q + this->nx_ ] & this->mask_value_ )   type |= 0x8;
-
-          if ( data2[ q ] & this->mask_value_ )         type |= 0x10;
-          if ( data2[ q + 1 ] & this->mask_value_ )       type |= 0x20;
-          if ( data2[ q + this->nx_ + 1 ] & this->mask_value_ ) type |= 0x40;
-          if ( data2[ q + this->nx_ ] & this->mask_value_ )   type |= 0x80;
-
-          this->type_buffer_[ q ] = type;
-
-          // All points are inside or outside the cube -- does not contribute to the 
-          // isosurface 
-          if (type == 0x00 || type == 0xFF ) 
-          {
-            continue;
-          }
-
-          // Since mask values are either on or off, no need to interpolate 
-          // between vertices along edges.  Always put point in center of edge.
-          const float INTERP_EDGE_OFFSET_C = 0.5f;
-
-          if ( z == 0 )
-          {
-            // top border and center ones
-            if ( ( ( type>>0 ) ^ ( type>>1 ) ) & 0x01 ) 
-            {
-              PointF edge_point = PointF( static_cast< float >( x ) + 
-                INTERP_EDGE_OFFSET_C,
-                static_cast< float >( y ),
-                static_cast< float >( z ) );
-
-              // Transform point by mask transform
-              edge_point = grid_transform.project( edge_point );
-
-              points.push_back( edge_point );
-              back_edge_x[ q ] = point_cnt;
-              point_cnt++;
-            }
-
-            // bottom border one
-            if ( ( y == this->elem_ny_ - 1 ) && ( ( ( type>>2 ) ^ ( type>>3 ) ) & 0x01 ) )
-            {
-              PointF edge_point = PointF( static_cast< float >( x ) + 
-                INTERP_EDGE_OFFSET_C,
-                static_cast< float>( y + 1 ),
-                static_cast< float >( z ) );
-
-              // Transform point by mask transform
-              edge_point = grid_transform.project( edge_point );
-
-              points.push_back( edge_point );
-              back_edge_x[ q + this->nx_ ] = point_cnt;
-              point_cnt++;
-            }
-
-            // left border and center ones
-            if ( ( ( type>>0 ) ^ ( type>>3 ) ) & 0x01 )
-            {
-              PointF edge_point = PointF( static_cast< float >( x ),
-                static_cast< float >( y ) + INTERP_EDGE_OFFSET_C,
-                static_cast< float >( z ) );
-
-              // Transform point by mask transform
-              edge_point = grid_transform.project( edge_point );
-
-              points.push_back( edge_point );
-              back_edge_y[ q ] = point_cnt;
-              point_cnt++;
-            }
-
-            // right one
-            if ( ( x == this->elem_nx_ - 1 ) && ( ( ( type>>1 ) ^ ( type>>2 ) ) & 0x01 ) )
-            {
-              PointF edge_point = PointF( static_cast< float >( x + 1 ), 
-                static_cast< float >( y ) + INTERP_EDGE_OFFSET_C,
-                static_cast< float >( z ) );
-
-              // Transform point by mask transform
-              edge_point = grid_transform.project( edge_point );
-
-              points.push_back( edge_point );
-              back_edge_y[ q + 1 ] = point_cnt;
-              point_cnt++;
-            }
-          }
-
-          // top border and center ones
-          if ( ( ( type>>4 ) ^ ( type>>5 ) ) & 0x01 )
-          {
-            PointF edge_point = PointF( static_cast< float >( x ) + INTERP_EDGE_OFFSET_C,
-              static_cast< float >( y ),
-              static_cast< float >( z + 1 ) );
-
-            // Transform point by mask transform
-            edge_point = grid_transform.project( edge_point );
-
-            points.push_back( edge_point );
-            front_edge_x[ q ] = point_cnt;
-            point_cnt++;
-          }
-
-          // bottom border one
-
-          if ( ( y == this->elem_ny_ - 1 ) && ( ( ( type>>6 ) ^ ( type>>7 ) ) & 0x01 ) )
-          {
-            PointF edge_point = PointF( static_cast< float >( x ) + INTERP_EDGE_OFFSET_C,
-              static_cast< float >( y + 1 ),
-              static_cast< float >( z + 1 ) );
-
-            // Transform point by mask transform
-            edge_point = grid_transform.project( edge_point );
-
-            points.push_back( edge_point );
-            front_edge_x[ q + this->nx_ ] = point_cnt;
-            point_cnt++;
-          }
-
-          // left border and center ones
-          if ( ( ( type>>4 ) ^ ( type>>7 ) ) & 0x01 )
-          {
-            PointF edge_point = PointF( static_cast< float >( x ),
-              static_cast< float >( y ) + INTERP_EDGE_OFFSET_C,
-              static_cast< float >( z + 1 ) );
-
-            // Transform point by mask transform
-            edge_point = grid_transform.project( edge_point );
-
-            points.push_back( edge_point );
-            front_edge_y[ q ] = point_cnt;
-            point_cnt++;
-          }
-
-          // bottom one
-          if ( ( x== this->elem_nx_ - 1 ) && ( ( ( type>>5 ) ^ ( type>>6 ) ) & 0x01 ) )
-          {
-            PointF edge_point = PointF( static_cast< float >( x + 1 ), 
-              static_cast< float >( y ) + INTERP_EDGE_OFFSET_C,
-              static_cast< float >( z + 1 ) );
-
-            // Transform point by mask transform
-            edge_point = grid_transform.project( edge_point );
-
-            points.push_back( edge_point );
-            front_edge_y[ q + 1 ] = point_cnt;
-            point_cnt++;
-          }
-
-          // side edges
-
-          if ( ( ( type>>0 ) ^ ( type >> 4 ) ) & 0x01 )
-          {
-            PointF edge_point = PointF( static_cast< float >( x ), 
-              static_cast< float >( y ), 
-              static_cast< float >( z ) + INTERP_EDGE_OFFSET_C );
-
-            // Transform point by mask transform
-            edge_point = grid_transform.project( edge_point );
-
-            points.push_back( edge_point );
-            side_edge[ q ] = point_cnt;
-            point_cnt++;              
-          }    
-
-
-          if ( ( x == this->elem_nx_ - 1 ) && ( ( ( type>>1 ) ^ ( type>>5 ) ) & 0x01 ) )
-          {
-            PointF edge_point = PointF( static_cast< float >( x + 1 ), 
-              static_cast< float >( y ),
-              static_cast< float >( z ) + INTERP_EDGE_OFFSET_C );
-
-            // Transform point by mask transform
-            edge_point = grid_transform.project( edge_point );
-
-            points.push_back( edge_point );
-            side_edge[ q + 1 ] = point_cnt;
-            point_cnt++;              
-          }
-
-          if ( ( y == this->elem_ny_ - 1 ) && ( ( ( type>>3 ) ^ ( type>>7 ) ) & 0x01 ) )
-          {
-            PointF edge_point = PointF( static_cast< float >( x ), 
-              static_cast< float >( y + 1 ), 
-              static_cast< float >( z ) + INTERP_EDGE_OFFSET_C );
-
-            // Transform point by mask transform
-            edge_point = grid_transform.project( edge_point );
-
-            points.push_back( edge_point );
-            side_edge[ q + this->nx_ ] = point_cnt;
-            point_cnt++;              
-          }
-
-          if ( ( ( y == this->elem_ny_ - 1 ) && ( x == this->elem_nx_ - 1 ) ) && 
-            ( ( ( type>>2 ) ^ ( type>>6 ) ) & 0x01 ) )
-          {
-            PointF edge_point = PointF( static_cast< float >( x + 1 ), 
-              static_cast< float >( y + 1 ), 
-              static_cast< float >( z ) + INTERP_EDGE_OFFSET_C );
-
-            // Transform point by mask transform
-            edge_point = grid_transform.project( edge_point );
-
-            points.push_back( edge_point );
-            side_edge[ q + this->nx_ + 1 ] = point_cnt;
-            point_cnt++;              
-          }
-        }
-      }
+      next_points.clear();
+      this->compute_plane_points( z + 1, front_x, front_y, next_points, NEXT_SLAB_C );
+    }
+    else
+    {
+      this->compute_plane_points( z + 1, front_x, front_y, slab.points_, 0 );
     }
 
-    barrier.wait();
-    elements.clear();
-
-    // Combine points from all threads
-    if ( thread == 0 )
-    {   
-      size_t local_size = 0;
-      for ( int p = 0; p < num_threads; p++ )
-      {            
-        this->front_offset_[ p ] = this->global_point_cnt_ + local_size;
-        if ( z == 0 )
-        {
-          this->back_offset_[ p ] = this->front_offset_[ p ];
-        }
-        local_size += this->new_points_[ p ].size();
-        PointFVector& points = this->new_points_[ p ];
-        for ( size_t q = 0; q < points.size(); q++ )
+    size_t q = 0;
+    for ( size_t y = 0; y < this->ny_; y++ )
+    {
+      for ( size_t x = 0; x < nx; x++, q++ )
+      {
+        if ( ( data1[ q ] ^ data2[ q ] ) & this->mask_value_ )
         {
-          this->points_.push_back( points[ q ] ); 
+          side[ q ] = static_cast< unsigned int >( slab.points_.size() );
+          slab.points_.push_back( this->grid_transform_.project( PointF( 
+            static_cast< float >( x ), static_cast< float >( y ), 
+            static_cast< float >( z ) + INTERP_EDGE_OFFSET_C ) ) );
         }
       }
-      this->global_point_cnt_ += local_size;
-    
-      this->min_point_index_[ z ] = this->prev_point_min_;
-      this->max_point_index_[ z ] = static_cast<unsigned int>( this->points_.size() );
-      this->prev_point_min_ = this->prev_point_max_;
-      this->prev_point_max_ = this->max_point_index_[ z ];
     }
 
-    barrier.wait();
-
-    // Build triangles
-    for ( size_t y = elem_nystart; y < elem_nyend; y++ )
+    // Use relative offsets to find edges
+    edge_table[ 0 ] = &back_x[ 0 ];
+    edge_table[ 1 ] = &back_y[ 1 ];
+    edge_table[ 2 ] = &back_x[ nx ];
+    edge_table[ 3 ] = &back_y[ 0 ];
+
+    edge_table[ 4 ] = &front_x[ 0 ];
+    edge_table[ 5 ] = &front_y[ 1 ];
+    edge_table[ 6 ] = &front_x[ nx ];
+    edge_table[ 7 ] = &front_y[ 0 ];
+
+    edge_table[ 8 ] = &side[ 0 ];
+    edge_table[ 9 ] = &side[ 1 ];
+    edge_table[ 10 ] = &side[ nx ];
+    edge_table[ 11 ] = &side[ nx + 1 ];
+
+    // Step 2: determine the type of marching cube pattern (triangles) that needs
+    // to go in each element (cube) and build the triangles
+    for ( size_t y = 0; y < this->elem_ny_; y++ )
     {
-      for (size_t x=0;x<elem_nx_;x++)
+      for ( size_t x = 0; x < this->elem_nx_; x++ )
       {
-        size_t elem_offset = y * this->nx_ + x;
-        unsigned char type = this->type_buffer_[ elem_offset ];
+        // type = index into polygonal configuration table
+        unsigned char type = 0;
+        size_t elem_offset = y * nx + x; // Index into data
+        // An 8 bit index is formed where each bit corresponds to a vertex 
+        // Bit on if vertex is inside surface, off otherwise
+        if ( data1[ elem_offset ] & this->mask_value_ )          type |= 0x1;
+        if ( data1[ elem_offset + 1 ] & this->mask_value_ )      type |= 0x2;
+        if ( data1[ elem_offset + nx + 1 ] & this->mask_value_ ) type |= 0x4;
+        if ( data1[ elem_offset + nx ] & this->mask_value_ )     type |= 0x8;
+
+        if ( data2[ elem_offset ] & this->mask_value_ )          type |= 0x10;
+        if ( data2[ elem_offset + 1 ] & this->mask_value_ )      type |= 0x20;
+        if ( data2[ elem_offset + nx + 1 ] & this->mask_value_ ) type |= 0x40;
+        if ( data2[ elem_offset + nx ] & this->mask_value_ )     type |= 0x80;
 
         // All points are inside or outside the cube -- does not contribute to the 
         // isosurface 
-        if ( type == 0 || type == 0xFF ) 
+        if ( type == 0x00 || type == 0xFF ) 
         {
           continue;
         }
@@ -1088,108 +998,44 @@ void IsosurfacePrivate::parallel_compute_faces( int thread, int num_threads,
 
         for ( int k = 0; k < table.num_triangles_; k++ )
         {
-          // Get the edge index (0-11 for 12 edges)
-          int i1 = table.edges_[ 3 * k ];
-          int i2 = table.edges_[ 3 * k + 1 ];
-          int i3 = table.edges_[ 3 * k + 2 ];
-
-          unsigned int p1 = edge_table[ i1 ][ elem_offset ];
-          unsigned int p2 = edge_table[ i2 ][ elem_offset ];
-          unsigned int p3 = edge_table[ i3 ][ elem_offset ];
-
-          if ( i1 < 4 ) 
-          {
-            elems[ 0 ] = ( p1 & 0x00FFFFFF ) + this->back_offset_[ p1>>24 ];
-          }
-          else
-          {
-            elems[ 0 ] = ( p1 & 0x00FFFFFF ) + this->front_offset_[ p1>>24 ];            
-          }
-
-          if ( i2 < 4 ) 
+          const PointF* vertices[ 3 ];
+          for ( int v = 0; v < 3; v++ )
           {
-            elems[ 1 ] = ( p2 & 0x00FFFFFF ) + this->back_offset_[ p2>>24 ];
-          }
-          else
-          {
-            elems[ 1 ] = ( p2 & 0x00FFFFFF ) + this->front_offset_[ p2>>24 ];            
+            // Get the edge index (0-11 for 12 edges) and look up its point
+            unsigned int p = edge_table[ table.edges_[ 3 * k + v ] ][ elem_offset ];
+            slab.faces_.push_back( p );
+            vertices[ v ] = ( p & NEXT_SLAB_C ) ? &next_points[ p & ~NEXT_SLAB_C ] : 
+              &slab.points_[ p ];
           }
 
-          if ( i3 < 4 ) 
-          {
-            elems[ 2 ] = ( p3 & 0x00FFFFFF ) + this->back_offset_[ p3>>24 ];
-          }
-          else
-          {
-            elems[ 2 ] = ( p3 & 0x00FFFFFF ) + this->front_offset_[ p3>>24 ];            
-          }
-          elements.push_back( elems );
           // Add the area of the triangle to the total
-          this->new_elem_areas_[ thread ] += 0.5f * 
-            Cross( this->points_[ elems[ 1 ] ] - this->points_[ elems[ 0 ] ], 
-            this->points_[ elems[ 2 ] ] - this->points_[ elems[ 0 ] ] ).length();
+          slab.area_ += 0.5f * Cross( *vertices[ 1 ] - *vertices[ 0 ], 
+            *vertices[ 2 ] - *vertices[ 0 ] ).length();
         }
       }
     }
 
-    std::swap( back_buffer_x, front_buffer_x );
-    std::swap( back_buffer_y, front_buffer_y );
-    barrier.wait();
-
-    if ( thread == 0 )
-    {
-      this->min_face_index_[ z ] = static_cast<unsigned int>( this->faces_.size() );
-
-      for ( int w = 0;  w < num_threads; w++ )
-      {
-        std::vector< StackVector< size_t, 3 > >& pelements = this->new_elems_[ w ];
-        for ( size_t p = 0; p < pelements.size(); p++ )
-        {
-          StackVector< size_t, 3 >& el = pelements[ p ];
-          this->faces_.push_back( static_cast< unsigned int >( el[ 0 ] ) );
-          this->faces_.push_back( static_cast< unsigned int >( el[ 1 ] ) );
-          this->faces_.push_back( static_cast< unsigned int >( el[ 2 ] ) );
-        }
-      }
-      this->back_offset_ = this->front_offset_;
-
-      this->max_face_index_[ z ] = static_cast<unsigned int>( this->faces_.size() );
-    }
-
-    if ( thread == 0 )
-    {
-      if ( this->check_abort_() ) 
-      {
-        this->need_abort_ = true;
-      }
-    }
-
-    barrier.wait();   
-
-    if ( this->need_abort_ ) 
-    {
-      return;
-    }
-    
-    // Update progress based on number of z slices processed
-    double compute_progress = 
-      static_cast< double >( z + 1 ) / static_cast< double >( this->elem_nz_ );
-    double total_progress = compute_progress * COMPUTE_PERCENT_PROGRESS_C;
-    this->isosurface_->update_progress_signal_( total_progress );
-  }   
-
-  barrier.wait();
+    std::swap( back_x, front_x );
+    std::swap( back_y, front_y );
+  }
+}
 
-  // Add up surface areas computed in all threads
-  if ( thread == 0 )
+void IsosurfacePrivate::parallel_compute_slabs( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
   {
-    for ( int p = 0; p < num_threads; ++p )
+    this->compute_slab( this->dirty_slabs_[ j ] );
+
+    // Update progress based on number of slabs processed
+    double compute_progress;
     {
-      this->area_ += this->new_elem_areas_[ p ];
+      boost::mutex::scoped_lock lock( this->progress_mutex_ );
+      this->slabs_done_++;
+      compute_progress = static_cast< double >( this->slabs_done_ ) / 
+        static_cast< double >( this->dirty_slabs_.size() );
     }
+    this->isosurface_->update_progress_signal_( compute_progress * COMPUTE_PERCENT_PROGRESS_C );
   }
-  
-  barrier.wait();
 }
 
 //  Translates border face coords (i, j) to volume coords (x, y, z).  
@@ -1279,7 +1125,7 @@ Basic ideas:
   8 canonical indices for a cell (4 nodes, 4 edge points).
 */
 // Naive implementation -- needs to be optimized!
-void IsosurfacePrivate::compute_cap_faces()
+void IsosurfacePrivate::compute_cap( int cap_num )
 {
   // TODO Figure out how to handle x/y/z indices for caps so that code doesn't have to
   // be duplicated for each cap
@@ -1287,7 +1133,9 @@ void IsosurfacePrivate::compute_cap_faces()
   // Solution A: have function that translates (i, j) to (x, y, z).  Try this first.
   // Solution B (faster): Have (i, j, k) Vector offsets based on cap.  Add at end of loops.
 
-  // Process 6 caps independently.  At most this will duplicate volume edge nodes twice.
+  // Each cap is processed independently.  At most this will duplicate volume edge nodes twice.
+  IsosurfaceSlab& cap = this->cap_slabs_[ cap_num ];
+  FloatVector& triangle_areas = this->cap_areas_[ cap_num ];
   
   size_t nx = this->nx_; // Store local copy just to make code more concise
   size_t ny = this->ny_;
@@ -1298,12 +1146,7 @@ void IsosurfacePrivate::compute_cap_faces()
   cap_dimensions.push_back( std::make_pair( ny, nz ) ); // left and right side caps
   PointF elem_vertices[ 3 ]; // Temporary storage for triangle vertices
 
-  // For each of 6 caps
-  for( int cap_num = 0; cap_num < 6; cap_num++ )
   {
-    unsigned int min_point_index = static_cast< unsigned int >( this->points_.size() );
-    unsigned int min_face_index = static_cast< unsigned int >( this->faces_.size() );
-
     // Each 
     // STEP 1: Find cell types
 
@@ -1359,7 +1202,7 @@ void IsosurfacePrivate::compute_cap_faces()
     // If no border nodes for this cap are on, skip this cap
     if( !some_nodes_on )
     {
-      continue;
+      return;
     }
 
     // STEP 2: Add nodes to points list and translation table
@@ -1392,9 +1235,9 @@ void IsosurfacePrivate::compute_cap_faces()
           // Transform point by mask transform
           PointF node_point = grid_transform.project( PointF( x, y, z ) );
           // Add node to the points list.
-          this->points_.push_back( node_point );
+          cap.points_.push_back( node_point );
           unsigned int point_index = 
-            static_cast< unsigned int >( this->points_.size() - 1 );
+            static_cast< unsigned int >( cap.points_.size() - 1 );
 
           // Add relevant canonical coordinates to translation table for adjacent cells.
           // Find indices and canonical coordinates of 1-4 adjacent cells
@@ -1464,9 +1307,9 @@ void IsosurfacePrivate::compute_cap_faces()
           // Transform point by mask transform
           PointF edge_point = grid_transform.project( PointF( edge_x, edge_y, edge_z) );
           // Add edge to the points list.
-          this->points_.push_back( edge_point );
+          cap.points_.push_back( edge_point );
           unsigned int point_index = 
-            static_cast< unsigned int >( this->points_.size() - 1 );
+            static_cast< unsigned int >( cap.points_.size() - 1 );
 
           // Add the relevant canonical coordinates to the translation table for adjacent 1-2 cells.
 
@@ -1516,9 +1359,9 @@ void IsosurfacePrivate::compute_cap_faces()
           // Transform point by mask transform
           PointF edge_point = grid_transform.project( PointF( edge_x, edge_y, edge_z) );
           // Add edge to the points list.
-          this->points_.push_back( edge_point );
+          cap.points_.push_back( edge_point );
           unsigned int point_index = 
-            static_cast< unsigned int >( this->points_.size() - 1 );
+            static_cast< unsigned int >( cap.points_.size() - 1 );
 
           // Add the relevant canonical coordinates to the translation table for adjacent 1-2 cells.
 
@@ -1567,106 +1410,360 @@ void IsosurfacePrivate::compute_cap_faces()
           // Look up the point index in the translation table for this cell 
           unsigned int point_index = point_trans_table[ cell_index ][ canonical_index ];
           // Store the point coordinates in the temporary variable
-          elem_vertices[ triangle_point_index ] = this->points_[ point_index ];
+          elem_vertices[ triangle_point_index ] = cap.points_[ point_index ];
           // Add point index to the faces list
-          this->faces_.push_back( point_index );
+          cap.faces_.push_back( point_index );
         }
         // Compute the area of  the triangle and add it to the total area
-        this->area_ += 0.5f * Cross( elem_vertices[ 1 ] - elem_vertices[ 0 ], 
-          elem_vertices[ 2 ] - elem_vertices[ 0 ] ).length();
+        triangle_areas.push_back( 0.5f * Cross( elem_vertices[ 1 ] - elem_vertices[ 0 ], 
+          elem_vertices[ 2 ] - elem_vertices[ 0 ] ).length() );
       }
     }
+  }
+}
+
+void IsosurfacePrivate::parallel_compute_caps( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    this->compute_cap( static_cast< int >( j ) );
+  }
+}
+
+void IsosurfacePrivate::parallel_merge_caps( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    const IsosurfaceSlab& cap = this->cap_slabs_[ j ];
+    unsigned int point_offset = static_cast< unsigned int >( this->cap_point_offset_[ j ] );
+
+    std::copy( cap.points_.begin(), cap.points_.end(), 
+      this->caps_.points_.begin() + point_offset );
 
-    // Create a rendering "patch" for each cap 
-    unsigned int max_point_index = static_cast< unsigned int >( this->points_.size() );
-    unsigned int max_face_index = static_cast< unsigned int >( this->faces_.size() );
-    if( min_point_index != max_point_index && min_face_index != max_face_index )
+    UIntVector::iterator face_it = this->caps_.faces_.begin() + this->cap_face_offset_[ j ];
+    for ( size_t i = 0; i < cap.faces_.size(); i++, ++face_it )
     {
-      this->min_point_index_.push_back( min_point_index );
-      this->max_point_index_.push_back( max_point_index );
+      *face_it = point_offset + cap.faces_[ i ];
+    }
+  }
+}
+
+bool IsosurfacePrivate::compute_cap_faces()
+{
+  this->cap_slabs_.assign( 6, IsosurfaceSlab() );
+  this->cap_areas_.assign( 6, FloatVector() );
+
+  bool success = parallel_for( 0, 6, 1, boost::bind( 
+    &IsosurfacePrivate::parallel_compute_caps, this, _1, _2 ), this->check_abort_ );
 
-      this->min_face_index_.push_back( min_face_index );
-      this->max_face_index_.push_back( max_face_index );
+  if ( success )
+  {
+    // Number the points of the caps in order, as if they were computed one after another
+    this->cap_point_offset_.resize( 7 );
+    this->cap_face_offset_.resize( 7 );
+    this->cap_point_offset_[ 0 ] = 0;
+    this->cap_face_offset_[ 0 ] = 0;
+    for ( size_t j = 0; j < 6; j++ )
+    {
+      this->cap_point_offset_[ j + 1 ] = this->cap_point_offset_[ j ] + 
+        this->cap_slabs_[ j ].points_.size();
+      this->cap_face_offset_[ j + 1 ] = this->cap_face_offset_[ j ] + 
+        this->cap_slabs_[ j ].faces_.size();
+    }
+
+    this->caps_.points_.resize( this->cap_point_offset_[ 6 ] );
+    this->caps_.faces_.resize( this->cap_face_offset_[ 6 ] );
+    success = parallel_for( 0, 6, 1, boost::bind( 
+      &IsosurfacePrivate::parallel_merge_caps, this, _1, _2 ), this->check_abort_ );
+
+    // NOTE: The area is accumulated triangle by triangle in the same order as before, so it
+    // does not change with the number of threads either.
+    for ( size_t j = 0; j < 6 && success; j++ )
+    {
+      const FloatVector& triangle_areas = this->cap_areas_[ j ];
+      for ( size_t i = 0; i < triangle_areas.size(); i++ )
+      {
+        this->caps_.area_ += triangle_areas[ i ];
+      }
     }
   }
+
+  this->cap_slabs_.clear();
+  this->cap_areas_.clear();
+  return success;
 }
 
-void IsosurfacePrivate::parallel_compute_normals( int thread, int num_threads, 
-  boost::barrier& barrier )
+// Accumulate the face normals of a set of faces onto their vertices. Face indices flagged with
+// next_flag refer to next_points. The normals of the flagged vertices are added to next_normals
+// and those of the other vertices to normals, if given.
+static void AddFaceNormals( const UIntVector& faces, const PointFVector& points, 
+  const PointFVector* next_points, VectorFVector* normals, VectorFVector* next_normals, 
+  unsigned int next_flag )
 {
-  size_t num_vertices = this->points_.size();
+  for( size_t i = 0; i + 2 < faces.size(); i += 3 )
+  {
+    unsigned int vertex_index[ 3 ] = { faces[ i ], faces[ i + 1 ], faces[ i + 2 ] };
+    
+    // Faces that do not reach into the next slab do not contribute to the next normals
+    bool next_slab = ( ( vertex_index[ 0 ] | vertex_index[ 1 ] | vertex_index[ 2 ] ) & 
+      next_flag ) != 0;
+    if ( normals == 0 && !next_slab ) continue;
+
+    // Get vertices of face
+    PointF p[ 3 ];
+    for ( int v = 0; v < 3; v++ )
+    {
+      p[ v ] = ( vertex_index[ v ] & next_flag ) ? 
+        ( *next_points )[ vertex_index[ v ] & ~next_flag ] : points[ vertex_index[ v ] ];
+    }
 
-  if ( thread == 0 ) // Only need to setup once 
-  { 
-    // Reset the normals vector
-    this->normals_.clear();
-    this->normals_.resize( num_vertices, VectorF( 0, 0, 0 ) );
+    // Calculate cross product of edges
+    VectorF v0 = p[ 2 ] - p[ 1 ];
+    VectorF v1 = p[ 0 ] - p[ 1 ];
+    VectorF n = Cross( v0, v1 );
+
+    for ( int v = 0; v < 3; v++ )
+    {
+      if ( vertex_index[ v ] & next_flag )
+      {
+        if ( next_normals ) ( *next_normals )[ vertex_index[ v ] & ~next_flag ] += n;
+      }
+      else if ( normals )
+      {
+        ( *normals )[ vertex_index[ v ] ] += n;
+      }
+    }
   }
+}
 
-  // All threads have to wait until setup is done before proceeding
-  barrier.wait();
+void IsosurfacePrivate::parallel_compute_normals( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    // The caps are stored after the slabs
+    bool caps = j == this->normal_slabs_.size();
+    IsosurfaceSlab& slab = caps ? this->caps_ : this->slabs_[ this->normal_slabs_[ j ] ];
+    slab.normals_.clear();
+    slab.normals_.resize( slab.points_.size(), VectorF( 0, 0, 0 ) );
+
+    // Faces of the slab itself, which may use the points on the first plane of the next slab
+    const PointFVector* next_points = 0;
+    if ( !caps && this->normal_slabs_[ j ] + 1 < this->slabs_.size() )
+    {
+      next_points = &this->slabs_[ this->normal_slabs_[ j ] + 1 ].points_;
+    }
+    AddFaceNormals( slab.faces_, slab.points_, next_points, &slab.normals_, 0, NEXT_SLAB_C );
+
+    // Faces of the previous slab that share the points on the first plane of this slab
+    if ( !caps && this->normal_slabs_[ j ] > 0 )
+    {
+      const IsosurfaceSlab& prev_slab = this->slabs_[ this->normal_slabs_[ j ] - 1 ];
+      AddFaceNormals( prev_slab.faces_, prev_slab.points_, &slab.points_, 0, &slab.normals_, 
+        NEXT_SLAB_C );
+    }
+
+    for( size_t i = 0; i < slab.normals_.size(); i++ )
+    {
+      // Normalize normal
+      slab.normals_[ i ].normalize();
+    }
+  }
+}
 
-  // In order to parallelize the algorithm, each thread processes a different range of vertex 
-  // indices [vertex_index_start, vertex_index_end)
-  size_t vertex_range_size = static_cast< size_t >( num_vertices / num_threads );
-  if ( vertex_range_size * num_threads < num_vertices ) 
+void IsosurfacePrivate::parallel_merge_slabs( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
   {
-    vertex_range_size++;
+    // The caps are stored after the slabs
+    const IsosurfaceSlab& slab = ( j == this->slabs_.size() ) ? this->caps_ : this->slabs_[ j ];
+    
+    unsigned int point_offset = static_cast< unsigned int >( this->slab_point_offset_[ j ] );
+    unsigned int next_point_offset = 
+      static_cast< unsigned int >( this->slab_point_offset_[ j + 1 ] );
+
+    std::copy( slab.points_.begin(), slab.points_.end(), this->points_.begin() + point_offset );
+    std::copy( slab.normals_.begin(), slab.normals_.end(), 
+      this->normals_.begin() + point_offset );
+
+    UIntVector::iterator face_it = this->faces_.begin() + this->slab_face_offset_[ j ];
+    for ( size_t i = 0; i < slab.faces_.size(); i++, ++face_it )
+    {
+      unsigned int index = slab.faces_[ i ];
+      *face_it = ( index & NEXT_SLAB_C ) ? next_point_offset + ( index & ~NEXT_SLAB_C ) :
+        point_offset + index;
+    }
   }
+}
 
-  size_t vertex_index_start = thread * vertex_range_size;
-  size_t vertex_index_end = ( thread + 1 ) * vertex_range_size;
-  if ( vertex_index_end > num_vertices ) 
+bool IsosurfacePrivate::merge_slabs()
+{
+  size_t num_slabs = this->slabs_.size();
+
+  // Compute the offset of each slab in the combined arrays, the caps come last
+  this->slab_point_offset_.resize( num_slabs + 2 );
+  this->slab_face_offset_.resize( num_slabs + 2 );
+  this->slab_point_offset_[ 0 ] = 0;
+  this->slab_face_offset_[ 0 ] = 0;
+  this->area_ = 0.0f;
+  for ( size_t j = 0; j <= num_slabs; j++ )
   {
-    vertex_index_end = num_vertices;
+    const IsosurfaceSlab& slab = ( j == num_slabs ) ? this->caps_ : this->slabs_[ j ];
+    this->slab_point_offset_[ j + 1 ] = this->slab_point_offset_[ j ] + slab.points_.size();
+    this->slab_face_offset_[ j + 1 ] = this->slab_face_offset_[ j ] + slab.faces_.size();
+    this->area_ += slab.area_;
   }
 
-  // For each face
-  for( size_t i = 0; i + 2 < this->faces_.size(); i += 3 )
+  // Face indices are stored as unsigned int and the top bit is used to flag the next slab
+  if ( this->slab_point_offset_[ num_slabs + 1 ] >= NEXT_SLAB_C )
   {
-    size_t vertex_index1 = this->faces_[ i ];
-    size_t vertex_index2 = this->faces_[ i + 1 ];
-    size_t vertex_index3 = this->faces_[ i + 2 ];
-
-    // If this face has at least one vertex in our range
-    if( ( vertex_index_start <= vertex_index1 && vertex_index1 < vertex_index_end ) ||
-      ( vertex_index_start <= vertex_index2 && vertex_index2 < vertex_index_end ) ||
-      ( vertex_index_start <= vertex_index3 && vertex_index3 < vertex_index_end ) )
-    { 
-      // Get vertices of face
-      PointF p1 = this->points_[ vertex_index1 ];
-      PointF p2 = this->points_[ vertex_index2 ];
-      PointF p3 = this->points_[ vertex_index3 ];
-
-      // Calculate cross product of edges
-      VectorF v0 = p3 - p2;
-      VectorF v1 = p1 - p2;
-      VectorF n = Cross( v0, v1 );
-
-      // Add to normal for each vertex in our range
-      if( ( vertex_index_start <= vertex_index1 && vertex_index1 < vertex_index_end ) )
-      {
-        this->normals_[ vertex_index1 ] += n;
-      }
-      if( ( vertex_index_start <= vertex_index2 && vertex_index2 < vertex_index_end ) )
-      {
-        this->normals_[ vertex_index2 ] += n;
-      }
-      if( ( vertex_index_start <= vertex_index3 && vertex_index3 < vertex_index_end ) )
+    CORE_LOG_ERROR( "Isosurface has too many points" );
+    return false;
+  }
+
+  this->points_.resize( this->slab_point_offset_[ num_slabs + 1 ] );
+  this->normals_.resize( this->slab_point_offset_[ num_slabs + 1 ] );
+  this->faces_.resize( this->slab_face_offset_[ num_slabs + 1 ] );
+
+  return parallel_for( 0, num_slabs + 1, 1, boost::bind( 
+    &IsosurfacePrivate::parallel_merge_slabs, this, _1, _2 ), this->check_abort_ );
+}
+
+void IsosurfacePrivate::update_partition( bool rebuild )
+{
+  size_t num_slabs = this->slabs_.size();
+
+  // Remove the caps part, it is always regenerated
+  if ( !this->part_slabs_.empty() && this->part_slabs_.back().first == num_slabs )
+  {
+    this->part_slabs_.pop_back();
+  }
+
+  if ( rebuild )
+  {
+    // Group the slabs in batches of about a million face indices
+    this->part_slabs_.clear();
+    size_t num_face_indices = 0;
+    size_t first_slab = 0;
+    for ( size_t j = 0; j < num_slabs; j++ )
+    {
+      num_face_indices += this->slabs_[ j ].faces_.size();
+      if ( num_face_indices > 1000000 || j == num_slabs - 1 )
       {
-        this->normals_[ vertex_index3 ] += n;
+        this->part_slabs_.push_back( std::make_pair( first_slab, j + 1 ) );
+        first_slab = j + 1;
+        num_face_indices = 0;
       }
     }
   }
 
-  // For each vertex in our range
-  for( size_t i = vertex_index_start; i < vertex_index_end; i++ )
+  size_t num_parts = this->part_slabs_.size();
+  this->part_changed_.resize( num_parts );
+  for ( size_t i = 0; i < num_parts; i++ )
+  {
+    // A part changes if one of its slabs changed or if the previous slab changed, as its faces 
+    // use the points on the first plane of the part and their normals
+    size_t first_slab = this->part_slabs_[ i ].first;
+    size_t end_slab = this->part_slabs_[ i ].second;
+    bool changed = rebuild;
+    for ( size_t j = ( first_slab > 0 ? first_slab - 1 : 0 ); 
+      j <= end_slab && j < num_slabs && !changed; j++ )
+    {
+      changed = this->slab_dirty_[ j ] != 0;
+    }
+    this->part_changed_[ i ] = changed;
+  }
+
+  if ( !this->caps_.faces_.empty() )
+  {
+    this->part_slabs_.push_back( std::make_pair( num_slabs, num_slabs + 1 ) );
+    this->part_changed_.push_back( 1 );
+    num_parts++;
+  }
+
+  // Update the ranges of the parts and allocate the local indices of the changed parts
+  this->part_points_.resize( num_parts );
+  this->part_faces_.resize( num_parts );
+  this->part_indices_.resize( num_parts );
+  this->remap_parts_.clear();
+  this->remap_offset_.assign( 1, 0 );
+  for ( size_t i = 0; i < num_parts; i++ )
+  {
+    size_t first_slab = this->part_slabs_[ i ].first;
+    size_t end_slab = this->part_slabs_[ i ].second;
+
+    // The faces of the last slab of a part use the first plane of the next slab
+    size_t end_point = this->slab_point_offset_[ end_slab ];
+    if ( end_slab < num_slabs ) end_point += this->slabs_[ end_slab ].plane_points_;
+
+    this->part_points_[ i ] = std::make_pair( 
+      static_cast< unsigned int >( this->slab_point_offset_[ first_slab ] ),
+      static_cast< unsigned int >( end_point ) );
+    this->part_faces_[ i ] = std::make_pair(
+      static_cast< unsigned int >( this->slab_face_offset_[ first_slab ] ), 
+      static_cast< unsigned int >( this->slab_face_offset_[ end_slab ] ) );
+
+    if ( !this->part_changed_[ i ] ) continue;
+
+    unsigned int num_face_indices = this->part_faces_[ i ].second - this->part_faces_[ i ].first;
+    this->part_indices_[ i ].resize( num_face_indices );
+    this->remap_parts_.push_back( i );
+    this->remap_offset_.push_back( this->remap_offset_.back() + num_face_indices );
+  }
+
+  // The face indices of all the changed parts are remapped as one range, so a single large 
+  // part is split over multiple threads as well
+  parallel_for( 0, this->remap_offset_.back(), REMAP_GRAIN_C, boost::bind( 
+    &IsosurfacePrivate::parallel_remap_partitions, this, _1, _2 ) );
+}
+
+void IsosurfacePrivate::parallel_remap_partitions( size_t begin, size_t end )
+{
+  // Find the changed part that contains the first index
+  size_t k = std::upper_bound( this->remap_offset_.begin(), this->remap_offset_.end(), begin ) - 
+    this->remap_offset_.begin() - 1;
+
+  while ( begin < end )
+  {
+    size_t i = this->remap_parts_[ k ];
+    size_t part_end = std::min( end, this->remap_offset_[ k + 1 ] );
+    UIntVector& local_indices = this->part_indices_[ i ];
+    unsigned int first_point = this->part_points_[ i ].first;
+    size_t first_face = this->part_faces_[ i ].first;
+
+    for ( size_t j = begin; j < part_end; ++j )
+    {
+      size_t local_idx = j - this->remap_offset_[ k ];
+      local_indices[ local_idx ] = this->faces_[ first_face + local_idx ] - first_point;
+      assert( local_indices[ local_idx ] < ( this->part_points_[ i ].second - first_point ) );
+    }
+
+    begin = part_end;
+    k++;
+  }
+}
+
+void IsosurfacePrivate::parallel_update_level_indices( size_t begin, size_t end )
+{
+  IsosurfaceLevel& level = this->levels_.back();
+  for ( size_t i = begin; i < end; i++ )
   {
-    // Normalize normal
-    this->normals_[ i ].normalize();
+    unsigned int first_point = level.part_points_[ i ].first;
+    UIntVector& local_indices = level.part_indices_[ i ];
+    local_indices.resize( level.part_faces_[ i ].second - level.part_faces_[ i ].first );
+    for ( size_t j = 0; j < local_indices.size(); j++ )
+    {
+      local_indices[ j ] = level.faces_[ level.part_faces_[ i ].first + j ] - first_point;
+      assert( local_indices[ j ] < level.part_points_[ i ].second - first_point );
+    }
   }
 }
 
+const IsosurfaceLevel* IsosurfacePrivate::get_level( size_t level_of_detail ) const
+{
+  if ( level_of_detail == 0 || level_of_detail > this->levels_.size() ) return 0;
+  return &this->levels_[ level_of_detail - 1 ];
+}
+
 void IsosurfacePrivate::upload_to_vertex_buffer()
 {
   if ( !this->surface_changed_ && !this->values_changed_ )
@@ -1674,24 +1771,44 @@ void IsosurfacePrivate::upload_to_vertex_buffer()
     return;
   }
 
-  size_t num_of_parts = this->part_points_.size();
-  bool has_values = this->values_.size() == this->points_.size();
+  // The geometry of the level of detail that is rendered
+  const IsosurfaceLevel* level = this->get_level( this->level_of_detail_ );
+  size_t level_of_detail = level ? this->level_of_detail_ : 0;
+  const PointFVector& points = level ? level->points_ : this->points_;
+  const VectorFVector& normals = level ? level->normals_ : this->normals_;
+  const MeshDecimator::range_vector_type& part_points = 
+    level ? level->part_points_ : this->part_points_;
+  const MeshDecimator::range_vector_type& part_faces = 
+    level ? level->part_faces_ : this->part_faces_;
+  const std::vector< UIntVector >& part_indices = 
+    level ? level->part_indices_ : this->part_indices_;
+
+  size_t num_of_parts = part_points.size();
+  bool has_values = !level && this->values_.size() == this->points_.size();
+
+  // If only the geometry of some slabs changed, the batches of the other parts remain valid
+  bool partial_upload = this->vbo_available_ && !this->values_changed_ && 
+    this->vbo_batches_.size() == num_of_parts && level_of_detail == 0 && 
+    this->vbo_level_of_detail_ == 0;
 
   // Estimate the size of video memory required to upload the isosurface
   ptrdiff_t total_size = 0;
   for ( size_t i = 0; i < num_of_parts; ++i )
   {
-    unsigned int num_pts = this->part_points_[ i ].second - this->part_points_[ i ].first;
+    unsigned int num_pts = part_points[ i ].second - part_points[ i ].first;
     ptrdiff_t vertex_size = num_pts * sizeof( PointF );
     ptrdiff_t normal_size = num_pts * sizeof( VectorF );
     ptrdiff_t value_size = has_values ? num_pts * sizeof( float ) : 0;
-    unsigned int num_face_indices = this->part_faces_[ i ].second - this->part_faces_[ i ].first;
+    unsigned int num_face_indices = part_faces[ i ].second - part_faces[ i ].first;
     ptrdiff_t face_size = num_face_indices * sizeof( unsigned int );
     ptrdiff_t batch_size = vertex_size + normal_size + value_size + face_size;
-    CORE_LOG_MESSAGE( "Isosurface Batch " + ExportToString( i ) + ": " +
-             ExportToString( num_pts ) + " vertices, " +
-             ExportToString( num_face_indices / 3 ) + " triangles. Total memory: " + 
-             ExportToString( batch_size ) );
+    if ( !partial_upload || this->part_changed_[ i ] )
+    {
+      CORE_LOG_MESSAGE( "Isosurface Batch " + ExportToString( i ) + ": " +
+               ExportToString( num_pts ) + " vertices, " +
+               ExportToString( num_face_indices / 3 ) + " triangles. Total memory: " + 
+               ExportToString( batch_size ) );
+    }
     total_size += batch_size;
   }
   CORE_LOG_MESSAGE( "Total memory required for the isosurface: " +
@@ -1712,6 +1829,24 @@ void IsosurfacePrivate::upload_to_vertex_buffer()
   this->vbo_batches_.resize( num_of_parts );
   for ( size_t i = 0; i < num_of_parts; ++i )
   {
+    if ( partial_upload && !this->part_changed_[ i ] )
+    {
+      continue;
+    }
+
+    unsigned int num_pts = part_points[ i ].second - part_points[ i ].first;
+    ptrdiff_t vertex_size = num_pts * sizeof( PointF );
+    ptrdiff_t normal_size = num_pts * sizeof( VectorF );
+    unsigned int num_face_indices = part_faces[ i ].second - part_faces[ i ].first;
+    ptrdiff_t face_size = num_face_indices * sizeof( unsigned int );
+
+    // Slabs without any faces do not need a batch
+    if ( num_face_indices == 0 )
+    {
+      this->vbo_batches_[ i ].reset();
+      continue;
+    }
+
     this->vbo_batches_[ i ].reset( new VertexBufferBatch );
     this->vbo_batches_[ i ]->vertex_buffer_.reset( new Core::VertexAttribArrayBuffer );
     this->vbo_batches_[ i ]->normal_buffer_.reset( new Core::VertexAttribArrayBuffer );
@@ -1721,31 +1856,27 @@ void IsosurfacePrivate::upload_to_vertex_buffer()
     this->vbo_batches_[ i ]->normal_buffer_->set_array( 
       VertexAttribArrayType::NORMAL_E, GL_FLOAT, 0, 0 );
 
-    unsigned int num_pts = this->part_points_[ i ].second - this->part_points_[ i ].first;
-    ptrdiff_t vertex_size = num_pts * sizeof( PointF );
-    ptrdiff_t normal_size = num_pts * sizeof( VectorF );
-    unsigned int num_face_indices = this->part_faces_[ i ].second - this->part_faces_[ i ].first;
-    ptrdiff_t face_size = num_face_indices * sizeof( unsigned int );
-
     this->vbo_batches_[ i ]->vertex_buffer_->set_buffer_data( vertex_size, 
-      &this->points_[ this->part_points_[ i ].first ], GL_STATIC_DRAW );
+      &points[ part_points[ i ].first ], GL_STATIC_DRAW );
     this->vbo_batches_[ i ]->normal_buffer_->set_buffer_data( normal_size, 
-      &this->normals_[ this->part_points_[ i ].first ], GL_STATIC_DRAW );
+      &normals[ part_points[ i ].first ], GL_STATIC_DRAW );
     this->vbo_batches_[ i ]->faces_buffer_->set_buffer_data( face_size, 
-      &this->part_indices_[ i ][ 0 ], GL_STATIC_DRAW );
+      &part_indices[ i ][ 0 ], GL_STATIC_DRAW );
     if ( has_values )
     {
       this->vbo_batches_[ i ]->value_buffer_.reset( new Core::VertexAttribArrayBuffer );
       this->vbo_batches_[ i ]->value_buffer_->set_generic_array( 1, 1, GL_FLOAT, 
         GL_FALSE, 0, 0 );
       this->vbo_batches_[ i ]->value_buffer_->set_buffer_data( num_pts * sizeof( float ),
-        &this->values_[ this->part_points_[ i ].first ], GL_STATIC_DRAW );
+        &this->values_[ part_points[ i ].first ], GL_STATIC_DRAW );
     }
   }
   
+  this->part_changed_.assign( num_of_parts, 0 );
   this->surface_changed_ = false;
   this->values_changed_ = false;
   this->vbo_available_ = true;
+  this->vbo_level_of_detail_ = level_of_detail;
 }
 
 void IsosurfacePrivate::reset()
@@ -1754,6 +1885,18 @@ void IsosurfacePrivate::reset()
   this->normals_.clear();
   this->faces_.clear();
   this->values_.clear();
+  this->area_ = 0;
+
+  // Force a full computation the next time
+  this->slabs_.clear();
+  this->caps_ = IsosurfaceSlab();
+  this->part_slabs_.clear();
+  this->part_points_.clear();
+  this->part_faces_.clear();
+  this->part_indices_.clear();
+  this->part_changed_.clear();
+  this->levels_.clear();
+  this->surface_changed_ = true;
 }
 
 Isosurface::Isosurface( const MaskVolumeHandle& mask_volume ) :
@@ -1762,9 +1905,17 @@ Isosurface::Isosurface( const MaskVolumeHandle& mask_volume ) :
   this->private_->isosurface_ = this;
   this->private_->orig_mask_volume_ = mask_volume;
   this->private_->compute_mask_volume_ = mask_volume;
+  this->private_->neighborhood_size_ = 1;
+  this->private_->area_ = 0;
+  this->private_->capping_enabled_ = false;
+  this->private_->quality_factor_ = 0.0;
+  this->private_->generation_ = -1;
+  this->private_->slabs_done_ = 0;
   this->private_->surface_changed_ = false;
   this->private_->values_changed_ = false;
   this->private_->vbo_available_ = false;
+  this->private_->level_of_detail_ = 0;
+  this->private_->vbo_level_of_detail_ = 0;
 
   // Test code -- set default colormap
   //this->private_->color_map_ = ColorMapHandle( new ColorMap() );
@@ -1775,27 +1926,65 @@ void Isosurface::compute( double quality_factor, bool capping_enabled,
 {
   lock_type lock( this->get_mutex() );
 
-  this->private_->points_.clear();
-  this->private_->normals_.clear();
-  this->private_->faces_.clear();
-  this->private_->values_.clear();
-  this->private_->area_ = 0;
-  this->private_->values_changed_ = false;
   this->private_->check_abort_ = check_abort;
 
+  // Only regenerate the slabs that were affected by changes to the mask since the last
+  // computation, if it was done with the same quality
+  bool update = !this->private_->slabs_.empty() && 
+    quality_factor == this->private_->quality_factor_;
+
   {
     Core::MaskVolume::shared_lock_type vol_lock( this->private_->orig_mask_volume_->get_mutex() );
 
-    // Initially assume we're computing the isosurface for the original volume (not downsampled)
-    this->private_->compute_mask_volume_ = this->private_->orig_mask_volume_;
+    std::vector< char > slice_changed;
+    if ( update )
+    {
+      update = this->private_->find_changed_slices( slice_changed );
+    }
+    this->private_->generation_ = 
+      this->private_->orig_mask_volume_->get_mask_data_block()->get_generation();
+    this->private_->quality_factor_ = quality_factor;
+
+    if ( !update )
+    {
+      // Initially assume we're computing the isosurface for the original volume (not 
+      // downsampled)
+      this->private_->compute_mask_volume_ = this->private_->orig_mask_volume_;
+      this->private_->neighborhood_size_ = 1;
 
-    // Downsample mask if needed
-    if( quality_factor != 1.0 )
+      // Downsample mask if needed
+      if( quality_factor != 1.0 )
+      {
+        assert( quality_factor == 0.5 || quality_factor == 0.25 || quality_factor == 0.125 );
+        this->private_->downsample_setup( quality_factor );
+        // NOTE: The grid transform of the downsampled volume keeps the original dimensions
+        size_t downsampled_nz = 
+          this->private_->downsample_mask_volume_->get_mask_data_block()->get_nz();
+        parallel_for( 0, downsampled_nz, 1, boost::bind( 
+          &IsosurfacePrivate::parallel_downsample_mask, this->private_, _1, _2 ), check_abort );
+      }
+    }
+    else if ( this->private_->compute_mask_volume_ != this->private_->orig_mask_volume_ )
     {
-      assert( quality_factor == 0.5 || quality_factor == 0.25 || quality_factor == 0.125 );
-      Parallel parallel_downsample( boost::bind( &IsosurfacePrivate::parallel_downsample_mask, 
-        this->private_, _1, _2, _3, quality_factor ) );
-      parallel_downsample.run();
+      // Downsample the runs of modified slices
+      MaskDataBlockHandle mask = this->private_->orig_mask_volume_->get_mask_data_block();
+      this->private_->nx_ = mask->get_nx();
+      this->private_->ny_ = mask->get_ny();
+      this->private_->nz_ = mask->get_nz();
+      this->private_->data_ = mask->get_mask_data();
+      size_t z = 0;
+      while ( z < slice_changed.size() && !check_abort() )
+      {
+        size_t z_end = z;
+        while ( z_end < slice_changed.size() && slice_changed[ z_end ] ) z_end++;
+        if ( z_end > z )
+        {
+          parallel_for( z, z_end, 1, boost::bind( 
+            &IsosurfacePrivate::parallel_downsample_mask, this->private_, _1, _2 ), 
+            check_abort );
+        }
+        z = z_end + 1;
+      }
     }
 
     if ( check_abort() )
@@ -1808,12 +1997,25 @@ void Isosurface::compute( double quality_factor, bool capping_enabled,
     // Copy values to members just to simplify and shorten code.
     this->private_->compute_setup();
 
-    // Compute isosurface without caps
-    Parallel parallel_faces( boost::bind( &IsosurfacePrivate::parallel_compute_faces, 
-      this->private_, _1, _2, _3 ) );
-    parallel_faces.run();
+    update = this->private_->find_dirty_slabs( update ? &slice_changed : 0 ) && update;
 
-    if ( check_abort() )
+    if ( update && this->private_->dirty_slabs_.empty() && 
+      capping_enabled == this->private_->capping_enabled_ )
+    {
+      // Nothing changed
+      this->update_progress_signal_( 1.0 );
+      return;
+    }
+
+    // The values and the levels of detail belong to the previous surface
+    this->private_->values_.clear();
+    this->private_->values_changed_ = false;
+    this->private_->levels_.clear();
+
+    // Compute isosurface without caps
+    this->private_->slabs_done_ = 0;
+    if ( !parallel_for( 0, this->private_->dirty_slabs_.size(), 1, boost::bind( 
+      &IsosurfacePrivate::parallel_compute_slabs, this->private_, _1, _2 ), check_abort ) )
     {
       // leave it in a decent state
       this->private_->reset();
@@ -1821,29 +2023,37 @@ void Isosurface::compute( double quality_factor, bool capping_enabled,
     }
 
     // Compute isosurface caps
-    if( capping_enabled )
+    this->private_->caps_ = IsosurfaceSlab();
+    this->private_->capping_enabled_ = capping_enabled;
+    if( capping_enabled && !this->private_->compute_cap_faces() )
     {
-      this->private_->compute_cap_faces();
+      // leave it in a decent state
+      this->private_->reset();
+      return;
     }
   }
 
-  // Check for empty isosurface
-  if( this->private_->points_.size() == 0 ) 
+  // The caps are processed after the slabs
+  if ( !parallel_for( 0, this->private_->normal_slabs_.size() + 1, 1, boost::bind( 
+    &IsosurfacePrivate::parallel_compute_normals, this->private_, _1, _2 ), check_abort ) )
   {
+    // leave it in a decent state
+    this->private_->reset();
     return;
   }
 
-  // Test code -- assign values to vertices in range [0, 1].  
-  /*size_t num_points = this->private_->points_.size();
-  for( size_t i = 0; i < num_points; i++ )
+  this->update_progress_signal_( IsosurfacePrivate::COMPUTE_PERCENT_PROGRESS_C + 
+    IsosurfacePrivate::NORMAL_PERCENT_PROGRESS_C );
+
+  if ( !this->private_->merge_slabs() || check_abort() )
   {
-    float val = static_cast< float >( i ) / static_cast< float >( num_points );
-    this->private_->values_.push_back( val );
-  }*/
+    // leave it in a decent state
+    this->private_->reset();
+    return;
+  }
 
-  Parallel parallel_normals( boost::bind( &IsosurfacePrivate::parallel_compute_normals, 
-    this->private_, _1, _2, _3 ) );
-  parallel_normals.run();
+  this->private_->update_partition( !update );
+  this->private_->surface_changed_ = true;
 
   if ( check_abort() )
   {
@@ -1852,110 +2062,105 @@ void Isosurface::compute( double quality_factor, bool capping_enabled,
     return;
   }
 
-  this->update_progress_signal_( IsosurfacePrivate::COMPUTE_PERCENT_PROGRESS_C + 
-    IsosurfacePrivate::NORMAL_PERCENT_PROGRESS_C );
+  this->update_progress_signal_( 1.0 );
 
-  this->private_->type_buffer_.clear();
-  this->private_->edge_buffer_.clear();
-  this->private_->new_points_.clear();
-  this->private_->new_elems_.clear();
-  this->private_->new_elem_areas_.clear();
-  this->private_->front_offset_.clear();
-  this->private_->back_offset_.clear();
-  
-  this->private_->part_points_.clear();
-  this->private_->part_faces_.clear();
-  this->private_->part_indices_.clear();
-  
-  unsigned int num_faces = 0;
-  unsigned int min_point_index = 0;
-  unsigned int min_face_index = 0;
-  
-  for ( size_t j = 0; j < this->private_->min_point_index_.size(); j++ )
-  {
-    if ( num_faces == 0 )
-    {
-      min_point_index = this->private_->min_point_index_[ j ];
-      min_face_index = this->private_->min_face_index_[ j ];
-    }
-    
-    num_faces += this->private_->max_face_index_[ j ] - this->private_->min_face_index_[ j ];
-    
-    if ( num_faces > 0 && (num_faces > 1000000 || j == this->private_->min_point_index_.size() - 1 ) )
-    {
-      this->private_->part_points_.push_back( std::make_pair(
-        min_point_index, this->private_->max_point_index_[ j ] ) );
-      this->private_->part_faces_.push_back( std::make_pair(
-        min_face_index, this->private_->max_face_index_[ j ] ) );
-      num_faces = 0;
-    }
+  // Test code
+  // this->export_legacy_isosurface( "", "test_isosurface" );
+}
 
-    if ( check_abort() )
+bool Isosurface::compute_levels_of_detail( const std::vector< double >& face_fractions, 
+  double max_error, boost::function< bool () > check_abort )
+{
+  lock_type lock( this->get_mutex() );
+
+  // NOTE: Each level refers to the previous one while it is computed, so the levels must not
+  // be reallocated.
+  this->private_->levels_.clear();
+  this->private_->levels_.reserve( face_fractions.size() );
+  size_t num_faces = this->private_->faces_.size() / 3;
+  for ( size_t k = 0; k < face_fractions.size(); k++ )
+  {
+    // Decimate the previous level, which keeps the collapses cheap for the coarse levels
+    const IsosurfaceLevel* prev_level = this->private_->get_level( k );
+    MeshDecimator decimator( prev_level ? prev_level->points_ : this->private_->points_,
+      prev_level ? prev_level->faces_ : this->private_->faces_ );
+    decimator.set_partitions( prev_level ? prev_level->part_faces_ : 
+      this->private_->part_faces_ );
+    if ( !decimator.decimate( static_cast< size_t >( face_fractions[ k ] * num_faces ), 
+      max_error, check_abort ) )
     {
-      // leave it in a decent state
-      this->private_->reset();
-      return;
+      this->private_->levels_.clear();
+      return false;
     }
 
-    // Update progress
-    double partition_progress = 
-      static_cast< double >( j + 1 ) / static_cast< double >( this->private_->min_point_index_.size() ); 
-    double total_progress = IsosurfacePrivate::COMPUTE_PERCENT_PROGRESS_C + 
-      IsosurfacePrivate::NORMAL_PERCENT_PROGRESS_C +
-      ( partition_progress * IsosurfacePrivate::PARTITION_PERCENT_PROGRESS_C );
-    this->update_progress_signal_( total_progress );
+    this->private_->levels_.push_back( IsosurfaceLevel() );
+    IsosurfaceLevel& level = this->private_->levels_.back();
+    level.points_ = decimator.get_points();
+    level.normals_ = decimator.get_normals();
+    level.faces_ = decimator.get_faces();
+    level.area_ = decimator.get_area();
+    level.error_ = std::max( decimator.get_max_error(), prev_level ? prev_level->error_ : 0.0 );
+
+    // Collapses along the seams can make the point ranges of neighboring batches overlap
+    level.part_faces_ = decimator.get_part_faces();
+    level.part_points_ = decimator.get_part_points();
+    level.part_indices_.resize( level.part_faces_.size() );
+    parallel_for( 0, level.part_faces_.size(), 1, boost::bind( 
+      &IsosurfacePrivate::parallel_update_level_indices, this->private_, _1, _2 ) );
   }
-  size_t num_batches = this->private_->part_points_.size();
-  for ( size_t i = 0; i < num_batches; ++i )
+
+  if ( this->private_->level_of_detail_ != 0 )
   {
-    unsigned int num_face_indices = this->private_->part_faces_[ i ].second - 
-      this->private_->part_faces_[ i ].first;
-    UIntVector local_indices( num_face_indices );
-    for ( size_t j = 0; j < num_face_indices; ++j )
-    {
-      size_t pt_global_idx = this->private_->part_faces_[ i ].first + j;
-      local_indices[ j ] = this->private_->faces_[ pt_global_idx ] - 
-        this->private_->part_points_[ i ].first;
-      assert( local_indices[ j ] >= 0 && 
-           local_indices[ j ] < ( this->private_->part_points_[ i ].second - 
-                     this->private_->part_points_[ i ].first ) );
-    }
-    this->private_->part_indices_.push_back( local_indices );
+    this->private_->surface_changed_ = true;
   }
-  
-  this->private_->min_point_index_.clear();
-  this->private_->max_point_index_.clear();
-  this->private_->min_face_index_.clear();
-  this->private_->max_face_index_.clear();
+  return true;
+}
 
-  this->private_->surface_changed_ = true;
+size_t Isosurface::get_num_levels_of_detail() const
+{
+  lock_type lock( this->get_mutex() );
+  return this->private_->levels_.size() + 1;
+}
 
-  if ( check_abort() )
+double Isosurface::get_level_of_detail_error( size_t level_of_detail ) const
+{
+  lock_type lock( this->get_mutex() );
+  const IsosurfaceLevel* level = this->private_->get_level( level_of_detail );
+  return level ? level->error_ : 0.0;
+}
+
+void Isosurface::set_level_of_detail( size_t level_of_detail )
+{
+  lock_type lock( this->get_mutex() );
+  if ( level_of_detail != this->private_->level_of_detail_ )
   {
-    // leave it in a decent state
-    this->private_->reset();
-    return;
+    this->private_->level_of_detail_ = level_of_detail;
+    this->private_->surface_changed_ = true;
   }
+}
 
-  this->update_progress_signal_( 1.0 );
-
-  // Test code
-  // this->export_legacy_isosurface( "", "test_isosurface" );
+size_t Isosurface::get_level_of_detail() const
+{
+  lock_type lock( this->get_mutex() );
+  return this->private_->level_of_detail_;
 }
 
-const PointFVector& Isosurface::get_points() const
+const PointFVector& Isosurface::get_points( size_t level_of_detail ) const
 {
-  return this->private_->points_;
+  const IsosurfaceLevel* level = this->private_->get_level( level_of_detail );
+  return level ? level->points_ : this->private_->points_;
 }
 
-const UIntVector& Isosurface::get_faces() const
+const UIntVector& Isosurface::get_faces( size_t level_of_detail ) const
 {
-  return this->private_->faces_;
+  const IsosurfaceLevel* level = this->private_->get_level( level_of_detail );
+  return level ? level->faces_ : this->private_->faces_;
 }
 
-const VectorFVector& Isosurface::get_normals() const
+const VectorFVector& Isosurface::get_normals( size_t level_of_detail ) const
 { 
-  return this->private_->normals_;
+  const IsosurfaceLevel* level = this->private_->get_level( level_of_detail );
+  return level ? level->normals_ : this->private_->normals_;
 }
 
 const FloatVector& Isosurface::get_values() const
@@ -1998,13 +2203,25 @@ void Isosurface::redraw( bool use_colormap )
   }
   
   this->private_->upload_to_vertex_buffer();
-  size_t num_batches = this->private_->part_points_.size();
-  bool has_values = this->private_->values_.size() == this->private_->points_.size();
+
+  // The geometry of the level of detail that is rendered
+  const IsosurfaceLevel* level = this->private_->get_level( this->private_->level_of_detail_ );
+  const PointFVector& points = level ? level->points_ : this->private_->points_;
+  const VectorFVector& normals = level ? level->normals_ : this->private_->normals_;
+  const MeshDecimator::range_vector_type& part_points = 
+    level ? level->part_points_ : this->private_->part_points_;
+  const MeshDecimator::range_vector_type& part_faces = 
+    level ? level->part_faces_ : this->private_->part_faces_;
+  const std::vector< UIntVector >& part_indices = 
+    level ? level->part_indices_ : this->private_->part_indices_;
+
+  size_t num_batches = part_points.size();
+  bool has_values = !level && this->private_->values_.size() == this->private_->points_.size();
   
   // Error checking
   if( use_colormap ) 
   {
-    if( !has_values )
+    if( !has_values && !level )
     {
       CORE_LOG_WARNING( "Isosurface colormap enabled, but no per-vertex values assigned." ); 
     }
@@ -2019,6 +2236,9 @@ void Isosurface::redraw( bool use_colormap )
   {
     for ( size_t i = 0; i < num_batches; ++i )
     {
+      // Parts without faces have no batch
+      if ( !this->private_->vbo_batches_[ i ] ) continue;
+
       this->private_->vbo_batches_[ i ]->vertex_buffer_->enable_arrays();
       this->private_->vbo_batches_[ i ]->normal_buffer_->enable_arrays();
       if ( has_values && use_colormap )
@@ -2026,8 +2246,8 @@ void Isosurface::redraw( bool use_colormap )
         this->private_->vbo_batches_[ i ]->value_buffer_->enable_arrays();
       }
       this->private_->vbo_batches_[ i ]->faces_buffer_->draw_elements( GL_TRIANGLES, 
-        static_cast< GLsizei >( ( this->private_->part_faces_[ i ].second - 
-        this->private_->part_faces_[ i ].first ) ), GL_UNSIGNED_INT );
+        static_cast< GLsizei >( ( part_faces[ i ].second - 
+        part_faces[ i ].first ) ), GL_UNSIGNED_INT );
       this->private_->vbo_batches_[ i ]->vertex_buffer_->disable_arrays();
       this->private_->vbo_batches_[ i ]->normal_buffer_->disable_arrays();
       if ( has_values && use_colormap )
@@ -2054,12 +2274,13 @@ void Isosurface::redraw( bool use_colormap )
   ElementArrayBufferHandle face_buffer( new ElementArrayBuffer );
   for ( size_t i = 0; i < num_batches; ++i )
   {
-    unsigned int num_pts = this->private_->part_points_[ i ].second - this->private_->part_points_[ i ].first;
+    unsigned int num_pts = part_points[ i ].second - part_points[ i ].first;
     ptrdiff_t vertex_size = num_pts * sizeof( PointF );
     ptrdiff_t normal_size = num_pts * sizeof( VectorF );
     ptrdiff_t value_size = has_values && use_colormap ? num_pts * sizeof( float ) : 0;
-    unsigned int num_face_indices = this->private_->part_faces_[ i ].second - this->private_->part_faces_[ i ].first;
+    unsigned int num_face_indices = part_faces[ i ].second - part_faces[ i ].first;
     ptrdiff_t face_size = num_face_indices * sizeof( unsigned int );
+    if ( num_face_indices == 0 ) continue;
     
     vertex_buffer->set_buffer_data( vertex_size, 0, GL_STREAM_DRAW );
     void* buffer = vertex_buffer->map_buffer( GL_WRITE_ONLY );
@@ -2069,7 +2290,7 @@ void Isosurface::redraw( bool use_colormap )
         " be incomplete!" );
       return;
     }
-    memcpy( buffer, &this->private_->points_[ this->private_->part_points_[ i ].first ], vertex_size );
+    memcpy( buffer, &points[ part_points[ i ].first ], vertex_size );
     vertex_buffer->unmap_buffer();
     
     normal_buffer->set_buffer_data( normal_size, 0, GL_STREAM_DRAW );
@@ -2080,7 +2301,7 @@ void Isosurface::redraw( bool use_colormap )
         " be incomplete!" );
       return;
     }
-    memcpy( buffer, &this->private_->normals_[ this->private_->part_points_[ i ].first ], normal_size );
+    memcpy( buffer, &normals[ part_points[ i ].first ], normal_size );
     normal_buffer->unmap_buffer();
     
     if ( has_values && use_colormap )
@@ -2093,7 +2314,7 @@ void Isosurface::redraw( bool use_colormap )
           " be incomplete!" );
         return;
       }
-      memcpy( buffer, &this->private_->values_[ this->private_->part_points_[ i ].first ], value_size );
+      memcpy( buffer, &this->private_->values_[ part_points[ i ].first ], value_size );
       value_buffer->unmap_buffer();
     }
 
@@ -2105,7 +2326,7 @@ void Isosurface::redraw( bool use_colormap )
         " be incomplete!" );
       return;
     }
-    memcpy( buffer, &this->private_->part_indices_[ i ][ 0 ], face_size );
+    memcpy( buffer, &part_indices[ i ][ 0 ], face_size );
     face_buffer->unmap_buffer();
 
     vertex_buffer->enable_arrays();
@@ -2115,8 +2336,8 @@ void Isosurface::redraw( bool use_colormap )
       value_buffer->enable_arrays();
     }
     face_buffer->draw_elements( GL_TRIANGLES, 
-      static_cast< GLsizei >( ( this->private_->part_faces_[ i ].second - 
-      this->private_->part_faces_[ i ].first ) ), GL_UNSIGNED_INT );
+      static_cast< GLsizei >( ( part_faces[ i ].second - 
+      part_faces[ i ].first ) ), GL_UNSIGNED_INT );
     vertex_buffer->disable_arrays();
     normal_buffer->disable_arrays();
     if ( has_values && use_colormap )
@@ -2127,65 +2348,85 @@ void Isosurface::redraw( bool use_colormap )
 }
 
 bool Isosurface::export_legacy_isosurface( const boost::filesystem::path& path,
-                                           const std::string& file_prefix )
+                                           const std::string& file_prefix,
+                                           size_t level_of_detail )
 {
   lock_type lock( this->get_mutex() );
+  // The values belong to the points of the full resolution mesh
+  const IsosurfaceLevel* level = this->private_->get_level( level_of_detail );
   bool result = IsosurfaceExporter::ExportLegacy( path, file_prefix,
-                                                  this->private_->points_,
-                                                  this->private_->faces_,
-                                                  this->private_->values_
+                                                  this->get_points( level_of_detail ),
+                                                  this->get_faces( level_of_detail ),
+                                                  level ? FloatVector() : this->private_->values_
                                                 );
   return result;
 }
 
 
-bool Isosurface::export_vtk_isosurface( const boost::filesystem::path& filename )
+bool Isosurface::export_vtk_isosurface( const boost::filesystem::path& filename,
+                                        size_t level_of_detail )
 {
   lock_type lock( this->get_mutex() );
   bool result = IsosurfaceExporter::ExportVTKASCII( filename,
-                                                    this->private_->points_,
-                                                    this->private_->faces_
+                                                    this->get_points( level_of_detail ),
+                                                    this->get_faces( level_of_detail )
                                                   );
   return result;
 }
     
-bool Isosurface::export_obj_isosurface( const boost::filesystem::path& filename )
+bool Isosurface::export_obj_isosurface( const boost::filesystem::path& filename,
+                                        size_t level_of_detail )
 {
   lock_type lock( this->get_mutex() );
   bool result = IsosurfaceExporter::ExportOBJ( filename,
-                                               this->private_->points_,
-                                               this->private_->faces_
+                                               this->get_points( level_of_detail ),
+                                               this->get_faces( level_of_detail )
                                              );
   return result;
 }
 
+bool Isosurface::export_ply_isosurface( const boost::filesystem::path& filename,
+                                        size_t level_of_detail )
+{
+  lock_type lock( this->get_mutex() );
+  bool result = IsosurfaceExporter::ExportPLYBinary( filename,
+                                                     this->get_points( level_of_detail ),
+                                                     this->get_normals( level_of_detail ),
+                                                     this->get_faces( level_of_detail )
+                                                   );
+  return result;
+}
+
 bool Isosurface::export_stl_ascii_isosurface( const boost::filesystem::path& filename,
-                                              const std::string& name )
+                                              const std::string& name,
+                                              size_t level_of_detail )
 {
   lock_type lock( this->get_mutex() );
   bool result = IsosurfaceExporter::ExportSTLASCII( filename, name,
-                                                    this->private_->points_,
-                                                    this->private_->faces_
+                                                    this->get_points( level_of_detail ),
+                                                    this->get_faces( level_of_detail )
                                                   );
   return result;
 }
 
 bool Isosurface::export_stl_binary_isosurface( const boost::filesystem::path& filename,
-                                               const std::string& name )
+                                               const std::string& name,
+                                               size_t level_of_detail )
 {
   lock_type lock( this->get_mutex() );
   bool result = IsosurfaceExporter::ExportSTLBinary( filename, name,
-                                                     this->private_->points_,
-                                                     this->private_->faces_
+                                                     this->get_points( level_of_detail ),
+                                                     this->get_faces( level_of_detail )
                                                    );
   return result;
 }
 
 
-float Isosurface::surface_area() const
+float Isosurface::surface_area( size_t level_of_detail ) const
 {
   lock_type lock( this->get_mutex() );
-  return this->private_->area_;
+  const IsosurfaceLevel* level = this->private_->get_level( level_of_detail );
+  return level ? level->area_ : this->private_->area_;
 }
 
 } // end namespace Core
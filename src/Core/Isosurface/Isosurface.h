@@ -74,27 +74,55 @@ public:
   /// Compute isosurface.  quality_factor must be one of: {0.125, 0.25, 0.5, 1.0} 
   void compute( double quality_factor, bool capping_enabled, boost::function< bool () > check_abort );
 
+  // COMPUTE_LEVELS_OF_DETAIL:
+  /// Compute decimated versions of the isosurface. Level i + 1 keeps about face_fractions[ i ]
+  /// of the faces of the full resolution mesh, which is level 0. Each level is decimated from 
+  /// the previous one in parallel over the render batches, and no edge collapse has a quadric
+  /// error larger than max_error (0 means unbounded). The levels are discarded when compute()
+  /// changes the surface.
+  /// Returns false if the computation was aborted.
+  bool compute_levels_of_detail( const std::vector< double >& face_fractions, double max_error,
+    boost::function< bool () > check_abort );
+
+  // GET_NUM_LEVELS_OF_DETAIL:
+  /// Get the number of levels of detail, including the full resolution mesh.
+  size_t get_num_levels_of_detail() const;
+
+  // GET_LEVEL_OF_DETAIL_ERROR:
+  /// Get the largest quadric error of the edge collapses that produced the level of detail,
+  /// accumulated over the levels before it.
+  double get_level_of_detail_error( size_t level_of_detail ) const;
+
+  // SET_LEVEL_OF_DETAIL:
+  /// Set the level of detail that is rendered. The full resolution mesh is rendered while the
+  /// level has not been computed.
+  void set_level_of_detail( size_t level_of_detail );
+
+  // GET_LEVEL_OF_DETAIL:
+  /// Get the level of detail that is rendered.
+  size_t get_level_of_detail() const;
+
   // GET_POINTS:
   /// Get 3D points for vertices, each stored only once
   /// NOTE: This function is not thread-safe, make sure you have the mutex
   /// allocated before using this array (use get_mutex())
-  const PointFVector& get_points() const;
+  const PointFVector& get_points( size_t level_of_detail = 0 ) const;
 
   // GET_FACES:
   /// Indices into vertices, 3 per face
   /// NOTE: This function is not thread-safe, make sure you have the mutex
   /// allocated before using this array (use get_mutex())
-  const UIntVector& get_faces() const;
+  const UIntVector& get_faces( size_t level_of_detail = 0 ) const;
 
   // GET_NORMALS:
   /// Get one normal per vertex, interpolated
   /// NOTE: This function is not thread-safe, make sure you have the mutex
   /// allocated before using this array (use get_mutex())
-  const VectorFVector& get_normals() const;
+  const VectorFVector& get_normals( size_t level_of_detail = 0 ) const;
 
   // SURFACE_AREA:
   /// Return the area of the isosurface.
-  float surface_area() const;
+  float surface_area( size_t level_of_detail = 0 ) const;
 
   // GET_VALUES:
   /// Get values per vertex.  Returns empty vector if use has not set values.
@@ -121,7 +149,7 @@ public:
 
   // REDRAW:
   /// Render the isosurface.  This function doesn't work in isolation -- it must be called from the 
-  /// Seg3D Renderer. 
+  /// Seg3D Renderer. The values are only used for the full resolution mesh.
   void redraw( bool use_colormap );
 
   // EXPORT_LEGACY_ISOSURFACE:
@@ -147,26 +175,40 @@ public:
   /// ...
   ///
   /// Note: can't call this function "export" because it is reserved by the Visual C++ compiler.
+  /// The values are only written for the full resolution mesh.
+  ///
+  /// The export functions write the given level of detail, or the full resolution mesh if the
+  /// level has not been computed.
   bool export_legacy_isosurface( const boost::filesystem::path& path,
-                                 const std::string& file_prefix ); 
+                                 const std::string& file_prefix,
+                                 size_t level_of_detail = 0 ); 
 
   // EXPORT_VTK_ISOSURFACE:
   /// Writes out an isosurface in ASCII VTK mesh format
-  bool export_vtk_isosurface( const boost::filesystem::path& filename );
+  bool export_vtk_isosurface( const boost::filesystem::path& filename,
+                              size_t level_of_detail = 0 );
     
   // EXPORT_OBJ_ISOSURFACE:
   /// Writes out an isosurface in OBJ file format
-  bool export_obj_isosurface( const boost::filesystem::path& filename );
+  bool export_obj_isosurface( const boost::filesystem::path& filename,
+                              size_t level_of_detail = 0 );
+
+  // EXPORT_PLY_ISOSURFACE:
+  /// Writes out an isosurface with its vertex normals in binary PLY file format
+  bool export_ply_isosurface( const boost::filesystem::path& filename,
+                              size_t level_of_detail = 0 );
 
   // EXPORT_STL_ASCII_ISOSURFACE:
   /// Writes out an isosurface in ASCII STL file format
   bool export_stl_ascii_isosurface( const boost::filesystem::path& filename,
-                                    const std::string& name );
+                                    const std::string& name,
+                                    size_t level_of_detail = 0 );
 
   // EXPORT_STL_BINARY_ISOSURFACE:
   /// Writes out an isosurface in Binary STL file format
   bool export_stl_binary_isosurface( const boost::filesystem::path& filename,
-                                     const std::string& name );
+                                     const std::string& name,
+                                     size_t level_of_detail = 0 );
 
   typedef boost::signals2::signal< void (double) > update_progress_signal_type;
 
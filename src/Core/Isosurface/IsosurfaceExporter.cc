@@ -28,18 +28,40 @@
 
 #include <Core/Isosurface/IsosurfaceExporter.h>
 #include <Core/Geometry/Point.h>
+#include <Core/Utils/ThreadPool.h>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/shared_array.hpp>
+#include <boost/function.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <string>
 
 namespace Core
 {
 
-std::vector<float>
-computeFaceNormal(const PointF& p1, const PointF& p2, const PointF& p3)
+namespace
+{
+
+// Number of points or faces that a task formats
+const size_t EXPORT_GRAIN_C = 1 << 15;
+
+// Number of formatted blocks that are kept in memory before they are written
+const size_t EXPORT_ROUND_C = 64;
+
+// Number of points that a task hashes or renumbers when welding
+const size_t WELD_GRAIN_C = 1 << 16;
+
+// Number of shards the points are hashed into when welding
+const size_t WELD_SHARDS_C = 256;
+
+// Size of a binary STL facet: normal, three vertices and the attribute byte count
+const size_t STL_FACET_SIZE_C = 50;
+
+VectorF ComputeFaceNormal( const PointF& p1, const PointF& p2, const PointF& p3 )
 {
   // compute face normal:
   //   U = p2 - p1
@@ -47,13 +69,446 @@ computeFaceNormal(const PointF& p1, const PointF& p2, const PointF& p3)
   //   Ni = UyVz - UzVy
   //   Nj = UzVx - UxVz
   //   Nk = UxVy - UyVx
-
   VectorF U = p2 - p1;
   VectorF V = p3 - p1;
+  return VectorF( ( U.y() * V.z() ) - ( U.z() * V.y() ), ( U.z() * V.x() ) - ( U.x() * V.z() ), 
+    ( U.x() * V.y() ) - ( U.y() * V.x() ) );
+}
+
+bool ValidFaces( const PointFVector& points, const UIntVector& faces )
+{
+  for ( size_t i = 0; i < faces.size(); i++ )
+  {
+    if ( faces[ i ] >= points.size() ) return false;
+  }
+  return true;
+}
+
+// Formatting with %g and %f matches the default and std::fixed output of iostreams
+void AppendFloats( std::string& out, const char* format, float x, float y, float z )
+{
+  char buffer[ 64 ];
+  int length = std::snprintf( buffer, sizeof( buffer ), format, x, y, z );
+  out.append( buffer, length );
+}
+
+void AppendUInt( std::string& out, unsigned int value )
+{
+  char buffer[ 16 ];
+  char* end = buffer + sizeof( buffer );
+  char* begin = end;
+  do
+  {
+    *--begin = static_cast< char >( '0' + value % 10 );
+    value /= 10;
+  } while ( value != 0 );
+  out.append( begin, end );
+}
+
+template< class T >
+char* CopyBinary( char* out, T value )
+{
+  std::memcpy( out, &value, sizeof( T ) );
+  return out + sizeof( T );
+}
+
+char* CopyBinary( char* out, const PointF& p )
+{
+  out = CopyBinary( out, p.x() );
+  out = CopyBinary( out, p.y() );
+  return CopyBinary( out, p.z() );
+}
+
+char* CopyBinary( char* out, const VectorF& v )
+{
+  out = CopyBinary( out, v.x() );
+  out = CopyBinary( out, v.y() );
+  return CopyBinary( out, v.z() );
+}
+
+// FORMAT FUNCTIONS:
+// Each formats the items [ begin, end ) and appends them to out.
+
+void FormatPointLines( const PointFVector& points, const char* format, 
+  size_t begin, size_t end, std::string& out )
+{
+  out.reserve( ( end - begin ) * 32 );
+  for ( size_t i = begin; i < end; i++ )
+  {
+    AppendFloats( out, format, points[ i ].x(), points[ i ].y(), points[ i ].z() );
+  }
+}
+
+void FormatFaceLines( const UIntVector& faces, const std::string& prefix, unsigned int offset, 
+  size_t begin, size_t end, std::string& out )
+{
+  out.reserve( ( end - begin ) * ( prefix.size() + 24 ) );
+  for ( size_t i = begin; i < end; i++ )
+  {
+    out.append( prefix );
+    AppendUInt( out, faces[ 3 * i ] + offset );
+    out.push_back( ' ' );
+    AppendUInt( out, faces[ 3 * i + 1 ] + offset );
+    out.push_back( ' ' );
+    AppendUInt( out, faces[ 3 * i + 2 ] + offset );
+    out.push_back( '\n' );
+  }
+}
+
+void FormatValueLines( const FloatVector& values, size_t begin, size_t end, std::string& out )
+{
+  char buffer[ 32 ];
+  for ( size_t i = begin; i < end; i++ )
+  {
+    int length = std::snprintf( buffer, sizeof( buffer ), "%g\n", values[ i ] );
+    out.append( buffer, length );
+  }
+}
+
+void FormatSTLFacets( const PointFVector& points, const UIntVector& faces, 
+  size_t begin, size_t end, std::string& out )
+{
+  out.reserve( ( end - begin ) * 256 );
+  for ( size_t i = begin; i < end; i++ )
+  {
+    const PointF& p1 = points[ faces[ 3 * i ] ];
+    const PointF& p2 = points[ faces[ 3 * i + 1 ] ];
+    const PointF& p3 = points[ faces[ 3 * i + 2 ] ];
+    VectorF normal = ComputeFaceNormal( p1, p2, p3 );
+    AppendFloats( out, "  facet normal %f %f %f\n", normal.x(), normal.y(), normal.z() );
+    out.append( "    outer loop\n" );
+    AppendFloats( out, "      vertex %f %f %f\n", p1.x(), p1.y(), p1.z() );
+    AppendFloats( out, "      vertex %f %f %f\n", p2.x(), p2.y(), p2.z() );
+    AppendFloats( out, "      vertex %f %f %f\n", p3.x(), p3.y(), p3.z() );
+    out.append( "    endloop\n" );
+    out.append( "  endfacet\n" );
+  }
+}
+
+void FormatSTLRecords( const PointFVector& points, const UIntVector& faces, 
+  size_t begin, size_t end, std::string& out )
+{
+  // 0 is an acceptable value for the attribute byte count
+  const unsigned short attribute_byte_count = 0;
+  out.resize( ( end - begin ) * STL_FACET_SIZE_C );
+  char* data = &out[ 0 ];
+  for ( size_t i = begin; i < end; i++ )
+  {
+    const PointF& p1 = points[ faces[ 3 * i ] ];
+    const PointF& p2 = points[ faces[ 3 * i + 1 ] ];
+    const PointF& p3 = points[ faces[ 3 * i + 2 ] ];
+    data = CopyBinary( data, ComputeFaceNormal( p1, p2, p3 ) );
+    data = CopyBinary( data, p1 );
+    data = CopyBinary( data, p2 );
+    data = CopyBinary( data, p3 );
+    data = CopyBinary( data, attribute_byte_count );
+  }
+}
+
+void FormatPLYVertices( const PointFVector& points, const VectorFVector& normals, 
+  size_t begin, size_t end, std::string& out )
+{
+  bool has_normals = !normals.empty();
+  out.resize( ( end - begin ) * ( has_normals ? 24 : 12 ) );
+  char* data = &out[ 0 ];
+  for ( size_t i = begin; i < end; i++ )
+  {
+    data = CopyBinary( data, points[ i ] );
+    if ( has_normals ) data = CopyBinary( data, normals[ i ] );
+  }
+}
+
+void FormatPLYFaces( const UIntVector& faces, size_t begin, size_t end, std::string& out )
+{
+  const unsigned char num_vertices = 3;
+  out.resize( ( end - begin ) * 13 );
+  char* data = &out[ 0 ];
+  for ( size_t i = begin; i < end; i++ )
+  {
+    data = CopyBinary( data, num_vertices );
+    for ( int k = 0; k < 3; k++ )
+    {
+      data = CopyBinary( data, static_cast< int >( faces[ 3 * i + k ] ) );
+    }
+  }
+}
+
+// CLASS BLOCKWRITER:
+// Formats blocks of items on the ThreadPool and writes them to a stream in order. Only 
+// EXPORT_ROUND_C blocks are kept in memory at a time, so the file is streamed out while it is 
+// being formatted.
+class BlockWriter
+{
+public:
+  typedef boost::function< void ( size_t, size_t, std::string& ) > format_function_type;
+
+  explicit BlockWriter( std::ostream& stream ) :
+    stream_( stream ),
+    num_items_( 0 ),
+    first_block_( 0 )
+  {
+  }
+
+  // WRITE:
+  // Format and write items [ 0, num_items ). Returns false if writing failed.
+  bool write( size_t num_items, format_function_type format )
+  {
+    this->num_items_ = num_items;
+    this->format_ = format;
+    size_t num_blocks = ( num_items + EXPORT_GRAIN_C - 1 ) / EXPORT_GRAIN_C;
+    for ( size_t round = 0; round < num_blocks && this->stream_; round += EXPORT_ROUND_C )
+    {
+      size_t round_end = std::min( round + EXPORT_ROUND_C, num_blocks );
+      this->first_block_ = round;
+      this->blocks_.resize( round_end - round );
+      parallel_for( round, round_end, 1, boost::bind( &BlockWriter::parallel_format, 
+        this, _1, _2 ) );
+      for ( size_t j = 0; j < this->blocks_.size(); j++ )
+      {
+        this->stream_.write( this->blocks_[ j ].data(), this->blocks_[ j ].size() );
+      }
+    }
+    this->blocks_.clear();
+    return !this->stream_.fail();
+  }
+
+private:
+  void parallel_format( size_t begin, size_t end )
+  {
+    for ( size_t j = begin; j < end; j++ )
+    {
+      std::string& block = this->blocks_[ j - this->first_block_ ];
+      block.clear();
+      this->format_( j * EXPORT_GRAIN_C, std::min( ( j + 1 ) * EXPORT_GRAIN_C, 
+        this->num_items_ ), block );
+    }
+  }
+
+  std::ostream& stream_;
+  format_function_type format_;
+  size_t num_items_;
+  size_t first_block_;
+  std::vector< std::string > blocks_;
+};
+
+// CLASS POINTWELDER:
+// Merges points with identical coordinates, such as the points that the caps share with the 
+// isosurface along the border of the volume. The points are hashed into shards that are welded
+// in parallel. The first of a set of identical points is kept, so the points that remain keep 
+// their order and the result does not depend on the number of threads. The normals are 
+// optional.
+class PointWelder
+{
+public:
+  PointWelder( const PointFVector& points, const VectorFVector* normals, 
+    const UIntVector& faces ) :
+    points_( points ),
+    normals_( normals ),
+    faces_( faces )
+  {
+  }
+
+  void weld();
+
+  PointFVector welded_points_;
+  VectorFVector welded_normals_;
+  UIntVector welded_faces_;
+
+private:
+  // Coordinates with -0 mapped onto 0, so that points compare by value
+  unsigned int key( size_t index, int k ) const
+  {
+    float value = this->points_[ index ][ k ];
+    unsigned int bits = 0;
+    if ( value != 0.0f ) std::memcpy( &bits, &value, sizeof( bits ) );
+    return bits;
+  }
+
+  size_t shard( size_t index ) const
+  {
+    unsigned int hash = this->key( index, 0 ) * 73856093u ^ this->key( index, 1 ) * 19349663u ^ 
+      this->key( index, 2 ) * 83492791u;
+    return ( hash * 2654435761u ) >> 24;
+  }
+
+  bool less( unsigned int a, unsigned int b ) const
+  {
+    for ( int k = 0; k < 3; k++ )
+    {
+      unsigned int key_a = this->key( a, k );
+      unsigned int key_b = this->key( b, k );
+      if ( key_a != key_b ) return key_a < key_b;
+    }
+    return a < b;
+  }
+
+  bool equal( unsigned int a, unsigned int b ) const
+  {
+    return this->key( a, 0 ) == this->key( b, 0 ) && this->key( a, 1 ) == this->key( b, 1 ) &&
+      this->key( a, 2 ) == this->key( b, 2 );
+  }
+
+  void parallel_count_shards( size_t begin, size_t end );
+  void parallel_scatter( size_t begin, size_t end );
+  void parallel_weld_shards( size_t begin, size_t end );
+  void parallel_count_kept( size_t begin, size_t end );
+  void parallel_copy_points( size_t begin, size_t end );
+  void parallel_remap_faces( size_t begin, size_t end );
+
+  const PointFVector& points_;
+  const VectorFVector* normals_;
+  const UIntVector& faces_;
+
+  // Number of points of each block in each shard, and where they go in shard_points_
+  std::vector< size_t > block_shard_offset_;
+  std::vector< size_t > shard_offset_;
+  UIntVector shard_points_;
+
+  // First point with the same coordinates as each point, and the new index of the kept points
+  UIntVector representative_;
+  std::vector< size_t > block_offset_;
+  UIntVector index_;
+};
+
+void PointWelder::parallel_count_shards( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t* counts = &this->block_shard_offset_[ j * WELD_SHARDS_C ];
+    size_t point_end = std::min( ( j + 1 ) * WELD_GRAIN_C, this->points_.size() );
+    for ( size_t i = j * WELD_GRAIN_C; i < point_end; i++ )
+    {
+      counts[ this->shard( i ) ]++;
+    }
+  }
+}
+
+void PointWelder::parallel_scatter( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t* offsets = &this->block_shard_offset_[ j * WELD_SHARDS_C ];
+    size_t point_end = std::min( ( j + 1 ) * WELD_GRAIN_C, this->points_.size() );
+    for ( size_t i = j * WELD_GRAIN_C; i < point_end; i++ )
+    {
+      this->shard_points_[ offsets[ this->shard( i ) ]++ ] = static_cast< unsigned int >( i );
+    }
+  }
+}
+
+void PointWelder::parallel_weld_shards( size_t begin, size_t end )
+{
+  for ( size_t s = begin; s < end; s++ )
+  {
+    UIntVector::iterator first = this->shard_points_.begin() + this->shard_offset_[ s ];
+    UIntVector::iterator last = this->shard_points_.begin() + this->shard_offset_[ s + 1 ];
+    std::sort( first, last, boost::bind( &PointWelder::less, this, _1, _2 ) );
+    for ( UIntVector::iterator it = first; it != last; ++it )
+    {
+      if ( it == first || !this->equal( *( it - 1 ), *it ) )
+      {
+        this->representative_[ *it ] = *it;
+      }
+      else
+      {
+        this->representative_[ *it ] = this->representative_[ *( it - 1 ) ];
+      }
+    }
+  }
+}
 
-  return{ (U.y() * V.z()) - (U.z() * V.y()),(U.z() * V.x()) - (U.x() * V.z()),(U.x() * V.y()) - (U.y() * V.x()) };
+void PointWelder::parallel_count_kept( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t count = 0;
+    size_t point_end = std::min( ( j + 1 ) * WELD_GRAIN_C, this->points_.size() );
+    for ( size_t i = j * WELD_GRAIN_C; i < point_end; i++ )
+    {
+      if ( this->representative_[ i ] == i ) count++;
+    }
+    this->block_offset_[ j + 1 ] = count;
+  }
 }
 
+void PointWelder::parallel_copy_points( size_t begin, size_t end )
+{
+  bool has_normals = this->normals_ && !this->normals_->empty();
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t index = this->block_offset_[ j ];
+    size_t point_end = std::min( ( j + 1 ) * WELD_GRAIN_C, this->points_.size() );
+    for ( size_t i = j * WELD_GRAIN_C; i < point_end; i++ )
+    {
+      if ( this->representative_[ i ] != i ) continue;
+      this->welded_points_[ index ] = this->points_[ i ];
+      if ( has_normals ) this->welded_normals_[ index ] = ( *this->normals_ )[ i ];
+      this->index_[ i ] = static_cast< unsigned int >( index++ );
+    }
+  }
+}
+
+void PointWelder::parallel_remap_faces( size_t begin, size_t end )
+{
+  size_t index_end = std::min( end * WELD_GRAIN_C, this->faces_.size() );
+  for ( size_t i = begin * WELD_GRAIN_C; i < index_end; i++ )
+  {
+    this->welded_faces_[ i ] = this->index_[ this->representative_[ this->faces_[ i ] ] ];
+  }
+}
+
+void PointWelder::weld()
+{
+  size_t num_points = this->points_.size();
+  size_t num_blocks = ( num_points + WELD_GRAIN_C - 1 ) / WELD_GRAIN_C;
+
+  // Sort the points into shards, in their original order within each shard
+  this->block_shard_offset_.assign( num_blocks * WELD_SHARDS_C, 0 );
+  parallel_for( 0, num_blocks, 1, boost::bind( &PointWelder::parallel_count_shards, 
+    this, _1, _2 ) );
+  this->shard_offset_.resize( WELD_SHARDS_C + 1 );
+  size_t offset = 0;
+  for ( size_t s = 0; s < WELD_SHARDS_C; s++ )
+  {
+    this->shard_offset_[ s ] = offset;
+    for ( size_t j = 0; j < num_blocks; j++ )
+    {
+      size_t count = this->block_shard_offset_[ j * WELD_SHARDS_C + s ];
+      this->block_shard_offset_[ j * WELD_SHARDS_C + s ] = offset;
+      offset += count;
+    }
+  }
+  this->shard_offset_[ WELD_SHARDS_C ] = offset;
+  this->shard_points_.resize( num_points );
+  parallel_for( 0, num_blocks, 1, boost::bind( &PointWelder::parallel_scatter, 
+    this, _1, _2 ) );
+
+  this->representative_.resize( num_points );
+  parallel_for( 0, WELD_SHARDS_C, 1, boost::bind( &PointWelder::parallel_weld_shards, 
+    this, _1, _2 ) );
+  UIntVector().swap( this->shard_points_ );
+
+  // Number the points that are kept in their original order
+  this->block_offset_.assign( num_blocks + 1, 0 );
+  parallel_for( 0, num_blocks, 1, boost::bind( &PointWelder::parallel_count_kept, 
+    this, _1, _2 ) );
+  for ( size_t j = 0; j < num_blocks; j++ )
+  {
+    this->block_offset_[ j + 1 ] += this->block_offset_[ j ];
+  }
+  size_t num_kept = this->block_offset_[ num_blocks ];
+  this->welded_points_.resize( num_kept );
+  this->welded_normals_.resize( this->normals_ && !this->normals_->empty() ? num_kept : 0 );
+  this->index_.resize( num_points );
+  parallel_for( 0, num_blocks, 1, boost::bind( &PointWelder::parallel_copy_points, 
+    this, _1, _2 ) );
+
+  this->welded_faces_.resize( this->faces_.size() );
+  parallel_for( 0, ( this->faces_.size() + WELD_GRAIN_C - 1 ) / WELD_GRAIN_C, 1, boost::bind( 
+    &PointWelder::parallel_remap_faces, this, _1, _2 ) );
+}
+
+} // end anonymous namespace
 
 bool IsosurfaceExporter::ExportLegacy( const boost::filesystem::path& path,
                                        const std::string& file_prefix,
@@ -64,31 +519,33 @@ bool IsosurfaceExporter::ExportLegacy( const boost::filesystem::path& path,
 {
   // Write points to .pts file
   boost::filesystem::path points_path = path / ( file_prefix + ".pts" );
-  std::ofstream pts_file( points_path.string().c_str() );
+  std::ofstream pts_file( points_path.string().c_str(), std::ios::binary );
   if ( ! pts_file.is_open() )
   {
     return false;
   }
 
-  for ( auto &pt: points )
+  BlockWriter pts_writer( pts_file );
+  if ( ! pts_writer.write( points.size(), boost::bind( &FormatPointLines, boost::cref( points ),
+    "%g %g %g\n", _1, _2, _3 ) ) )
   {
-    pts_file << pt.x() << " " << pt.y() << " " << pt.z() << std::endl;
+    return false;
   }
   pts_file.close();
 
   // Write faces to .fac file
   boost::filesystem::path faces_path = path / ( file_prefix + ".fac" );
-  std::ofstream fac_file( faces_path.string().c_str() );
+  std::ofstream fac_file( faces_path.string().c_str(), std::ios::binary );
   if ( ! fac_file.is_open() )
   {
     return false;
   }
 
-  for ( size_t i = 0; i + 2 < faces.size(); i += 3 )
+  BlockWriter fac_writer( fac_file );
+  if ( ! fac_writer.write( faces.size() / 3, boost::bind( &FormatFaceLines, boost::cref( faces ),
+    std::string(), 0u, _1, _2, _3 ) ) )
   {
-    fac_file << faces[ i ] << " " <<
-                faces[ i + 1 ] << " " <<
-                faces[ i + 2 ] << std::endl;
+    return false;
   }
   fac_file.close();
 
@@ -96,16 +553,17 @@ bool IsosurfaceExporter::ExportLegacy( const boost::filesystem::path& path,
   if ( values.size() > 0 )
   {
     boost::filesystem::path values_path = path / ( file_prefix + ".val" );
-    std::ofstream val_file( values_path.string().c_str() );
+    std::ofstream val_file( values_path.string().c_str(), std::ios::binary );
     if( ! val_file.is_open() )
     {
       return false;
     }
 
-//    for ( size_t i = 0; i < this->private_->values_.size(); i++ )
-    for ( auto &value: values )
+    BlockWriter val_writer( val_file );
+    if ( ! val_writer.write( values.size(), boost::bind( &FormatValueLines, 
+      boost::cref( values ), _1, _2, _3 ) ) )
     {
-      val_file << value << std::endl;
+      return false;
     }
     val_file.close();
   }
@@ -119,40 +577,49 @@ bool IsosurfaceExporter::ExportVTKASCII( const boost::filesystem::path& filename
                                          const UIntVector& faces
                                         )
 {
-  std::ofstream vtk_file( filename.string().c_str() );
+  if ( ! ValidFaces( points, faces ) )
+  {
+    return false;
+  }
+
+  std::ofstream vtk_file( filename.string().c_str(), std::ios::binary );
   if ( ! vtk_file.is_open() )
   {
     return false;
   }
 
+  PointWelder welder( points, 0, faces );
+  welder.weld();
+
   // write header
   vtk_file << "# vtk DataFile Version 3.0\n";
   vtk_file << "vtk output\n";
 
   vtk_file << "ASCII\n";
   vtk_file << "DATASET POLYDATA\n";
-  vtk_file << "POINTS " << points.size() << " float\n";
+  vtk_file << "POINTS " << welder.welded_points_.size() << " float\n";
 
-  for ( auto &pt : points )
+  BlockWriter writer( vtk_file );
+  if ( ! writer.write( welder.welded_points_.size(), boost::bind( &FormatPointLines, 
+    boost::cref( welder.welded_points_ ), "%g %g %g\n", _1, _2, _3 ) ) )
   {
-    vtk_file << pt.x() << " " << pt.y() << " " << pt.z() << std::endl;
+    return false;
   }
 
-  unsigned int num_triangles = faces.size() / 3;
-  unsigned int triangle_list_size = num_triangles * 4;
+  size_t num_triangles = faces.size() / 3;
+  size_t triangle_list_size = num_triangles * 4;
 
-  vtk_file << "\nPOLYGONS " << num_triangles << " " << triangle_list_size << std::endl;
+  vtk_file << "\nPOLYGONS " << num_triangles << " " << triangle_list_size << "\n";
 
-  for( size_t i = 0; i + 2 < faces.size(); i += 3 )
+  if ( ! writer.write( num_triangles, boost::bind( &FormatFaceLines, 
+    boost::cref( welder.welded_faces_ ), std::string( "3 " ), 0u, _1, _2, _3 ) ) )
   {
-    vtk_file << "3 " << faces[ i ] << " " <<
-                        faces[ i + 1 ] << " " <<
-                        faces[ i + 2 ] << std::endl;
+    return false;
   }
 
   vtk_file.close();
 
-  return true;
+  return ! vtk_file.fail();
 }
 
 //OBJ format: https://en.wikipedia.org/wiki/Wavefront_.obj_file
@@ -161,39 +628,99 @@ bool IsosurfaceExporter::ExportOBJ( const boost::filesystem::path& filename,
                                     const UIntVector& faces
                                   )
 {
-  std::ofstream obj_file( filename.string().c_str() );
-
-  if( points.size() == 0 )
+  if( points.size() == 0 || ! ValidFaces( points, faces ) )
   {
     return false;
   }
-    
+
+  std::ofstream obj_file( filename.string().c_str(), std::ios::binary );
   if (! obj_file.is_open() )
   {
     return false;
   }
-  
+
+  PointWelder welder( points, 0, faces );
+  welder.weld();
+
   //Print points
-  for( size_t i = 0; i < points.size(); i++ )
+  BlockWriter writer( obj_file );
+  if ( ! writer.write( welder.welded_points_.size(), boost::bind( &FormatPointLines, 
+    boost::cref( welder.welded_points_ ), "v %g %g %g\n", _1, _2, _3 ) ) )
   {
-    PointF p = points[ i ];
-    
-    obj_file << "v " << p.x() << " " << p.y() << " " << p.z() << std::endl;
+    return false;
   }
-   
-  //Print faces
-  for( size_t i = 0; i + 2 < faces.size(); i += 3 )
+
+  //Print faces, OBJ face indices are 1-based.  Seriously.
+  if ( ! writer.write( faces.size() / 3, boost::bind( &FormatFaceLines, 
+    boost::cref( welder.welded_faces_ ), std::string( "f " ), 1u, _1, _2, _3 ) ) )
   {
-    // OBJ face indices are 1-based.  Seriously.
-    obj_file << "f " << faces[ i ] + 1 << " "
-                     << faces[ i+1 ] + 1 << " "
-                     << faces[ i+2 ] + 1 << std::endl;
+    return false;
   }
-    
+
   obj_file.close();
-    
-  return true;
-    
+
+  return ! obj_file.fail();
+}
+
+// Binary PLY format: http://paulbourke.net/dataformats/ply/
+bool IsosurfaceExporter::ExportPLYBinary( const boost::filesystem::path& filename,
+                                          const PointFVector& points,
+                                          const VectorFVector& normals,
+                                          const UIntVector& faces
+                                        )
+{
+  if ( ! ValidFaces( points, faces ) || ( ! normals.empty() && normals.size() != points.size() ) )
+  {
+    return false;
+  }
+
+  std::ofstream ply_file( filename.string().c_str(), std::ios::binary | std::ios::out );
+  if ( ! ply_file.is_open() )
+  {
+    return false;
+  }
+
+  PointWelder welder( points, &normals, faces );
+  welder.weld();
+
+  // The data is written in the byte order of this machine
+  const unsigned int one = 1;
+  bool little_endian = *reinterpret_cast< const unsigned char* >( &one ) == 1;
+
+  ply_file << "ply\n";
+  ply_file << "format " << ( little_endian ? "binary_little_endian" : "binary_big_endian" ) << 
+    " 1.0\n";
+  ply_file << "comment Seg3D isosurface\n";
+  ply_file << "element vertex " << welder.welded_points_.size() << "\n";
+  ply_file << "property float x\n";
+  ply_file << "property float y\n";
+  ply_file << "property float z\n";
+  if ( ! normals.empty() )
+  {
+    ply_file << "property float nx\n";
+    ply_file << "property float ny\n";
+    ply_file << "property float nz\n";
+  }
+  ply_file << "element face " << faces.size() / 3 << "\n";
+  ply_file << "property list uchar int vertex_indices\n";
+  ply_file << "end_header\n";
+
+  BlockWriter writer( ply_file );
+  if ( ! writer.write( welder.welded_points_.size(), boost::bind( &FormatPLYVertices, 
+    boost::cref( welder.welded_points_ ), boost::cref( welder.welded_normals_ ), 
+    _1, _2, _3 ) ) )
+  {
+    return false;
+  }
+  if ( ! writer.write( faces.size() / 3, boost::bind( &FormatPLYFaces, 
+    boost::cref( welder.welded_faces_ ), _1, _2, _3 ) ) )
+  {
+    return false;
+  }
+
+  ply_file.close();
+
+  return ! ply_file.fail();
 }
 
 // ASCII STL format: https://en.wikipedia.org/wiki/STL_(file_format)
@@ -203,53 +730,31 @@ bool IsosurfaceExporter::ExportSTLASCII( const boost::filesystem::path& filename
                                          const UIntVector& faces
                                        )
 {
-  std::ofstream stl_file( filename.string().c_str() );
+  if ( ! ValidFaces( points, faces ) )
+  {
+    return false;
+  }
+
+  std::ofstream stl_file( filename.string().c_str(), std::ios::binary );
   if ( ! stl_file.is_open() )
   {
     return false;
   }
 
-  const std::string delim(" ");
-  const std::string indent_level1("  ");
-  const std::string indent_level2("    ");
-  const std::string indent_level3("      ");
-  stl_file << "solid " << name << std::endl;
-
-  for( size_t i = 0; i + 2 < faces.size(); i += 3 )
-  {
-    size_t vertex_index1 = faces[ i ];
-    size_t vertex_index2 = faces[ i + 1 ];
-    size_t vertex_index3 = faces[ i + 2 ];
-
-    // Get vertices of face
-    PointF p1 = points[ vertex_index1 ];
-    PointF p2 = points[ vertex_index2 ];
-    PointF p3 = points[ vertex_index3 ];
-
-   auto normal = computeFaceNormal(p1, p2, p3);
-
-    stl_file << indent_level1 << "facet normal " << std::fixed <<
-                                 normal[0] << delim <<
-                                 normal[1] << delim <<
-                                 normal[2] << std::endl;
-    stl_file << indent_level2 << "outer loop" << std::endl;
-    stl_file << indent_level3 << "vertex " << std::fixed << p1.x() << delim <<
-                                                            p1.y() << delim <<
-                                                            p1.z() << std::endl;
-    stl_file << indent_level3 << "vertex " << std::fixed << p2.x() << delim <<
-                                                            p2.y() << delim <<
-                                                            p2.z() << std::endl;
-    stl_file << indent_level3 << "vertex " << std::fixed << p3.x() << delim <<
-                                                            p3.y() << delim <<
-                                                            p3.z() << std::endl;
-    stl_file << indent_level2 << "endloop" << std::endl;
-    stl_file << indent_level1 << "endfacet" << std::endl;
-  }
-  stl_file << "endsolid" << std::endl;
+  stl_file << "solid " << name << "\n";
+
+  BlockWriter writer( stl_file );
+  if ( ! writer.write( faces.size() / 3, boost::bind( &FormatSTLFacets, boost::cref( points ), 
+    boost::cref( faces ), _1, _2, _3 ) ) )
+  {
+    return false;
+  }
+
+  stl_file << "endsolid" << "\n";
 
   stl_file.close();
   
-  return true;
+  return ! stl_file.fail();
 }
 
 // Binary STL format: https://en.wikipedia.org/wiki/STL_(file_format)
@@ -263,9 +768,12 @@ bool IsosurfaceExporter::ExportSTLBinary( const boost::filesystem::path& filenam
   const unsigned short STL_HEADER_LENGTH = 80;
   // STL binary contains unsigned ints, floats
   const unsigned short STL_FIELD_LENGTH = 4;
-  const unsigned short POINT_LEN = 3;
-  const unsigned short FIELD_LEN = 12;
-  const unsigned short ATTRIBUTE_BYTE_COUNT = 2;
+
+  // STL has no shared vertices, so there is nothing to weld, but every face needs valid points
+  if ( ! ValidFaces( points, faces ) )
+  {
+    return false;
+  }
 
   std::ofstream stl_file(filename.string().c_str(), std::ios::binary | std::ios::out);
   if ( ! stl_file.is_open() )
@@ -275,43 +783,20 @@ bool IsosurfaceExporter::ExportSTLBinary( const boost::filesystem::path& filenam
 
   std::string header("STL header: Seg3D isosurface to STL Binary export");
   header.resize(STL_HEADER_LENGTH);
-  char* headerBuffer = const_cast<char*>(header.c_str());
-  stl_file.write(headerBuffer, STL_HEADER_LENGTH);
+  stl_file.write(header.data(), STL_HEADER_LENGTH);
 
-  unsigned int numTriangles = faces.size() / 3;
+  unsigned int numTriangles = static_cast< unsigned int >( faces.size() / 3 );
   stl_file.write(reinterpret_cast<char*>(&numTriangles), STL_FIELD_LENGTH);
 
-  // 0 is an acceptable value for this field
-  const unsigned short byteAttributeCount = 0;
-
-  for (size_t i = 0; i + 2 < faces.size(); i += 3)
+  BlockWriter writer( stl_file );
+  if ( ! writer.write( numTriangles, boost::bind( &FormatSTLRecords, boost::cref( points ), 
+    boost::cref( faces ), _1, _2, _3 ) ) )
   {
-    size_t vertex_index1 = faces[i];
-    size_t vertex_index2 = faces[i + 1];
-    size_t vertex_index3 = faces[i + 2];
-
-    // Get vertices of face
-    if (vertex_index1 >= points.size() || vertex_index2 >= points.size() || vertex_index3 >= points.size())
-    {
-      throw("vertices are out of points bounds");
-    }
-
-    PointF p1 = points[vertex_index1];
-    PointF p2 = points[vertex_index2];
-    PointF p3 = points[vertex_index3];
-   
-    auto normal = computeFaceNormal(p1, p2, p3);
-    stl_file.write(reinterpret_cast<char*>(&normal[0]), FIELD_LEN);
-
-    stl_file.write(reinterpret_cast<char*>(&p1[0]), FIELD_LEN);
-    stl_file.write(reinterpret_cast<char*>(&p2[0]), FIELD_LEN);
-    stl_file.write(reinterpret_cast<char*>(&p3[0]), FIELD_LEN);
-
-    stl_file.write(reinterpret_cast<const char*>(&byteAttributeCount), ATTRIBUTE_BYTE_COUNT);
+    return false;
   }
   stl_file.close();
 
-  return true;
+  return ! stl_file.fail();
 }
 
 }
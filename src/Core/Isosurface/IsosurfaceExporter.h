@@ -50,6 +50,12 @@ class IsosurfaceExporter
                               const UIntVector& faces
                             );
     
+  static bool ExportPLYBinary( const boost::filesystem::path& filename,
+                               const PointFVector& points,
+                               const VectorFVector& normals,
+                               const UIntVector& faces
+                             );
+
   static bool ExportVTKASCII( const boost::filesystem::path& filename,
                               const PointFVector& points,
                               const UIntVector& faces
@@ -0,0 +1,1205 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+// Boost includes
+#include <boost/bind.hpp>
+
+// Core includes
+#include <Core/Isosurface/MeshDecimator.h>
+#include <Core/Utils/ThreadPool.h>
+
+namespace Core
+{
+
+namespace
+{
+
+// Number of points that a task renumbers
+const size_t POINT_GRAIN_C = 1 << 16;
+
+// Marks a point that is not used by any partition
+const unsigned int NO_PARTITION_C = ~0u;
+
+// Smallest cosine of the angle by which a collapse may rotate the normal of a face
+const double MIN_NORMAL_COSINE_C = 0.2;
+
+// Compactness below which a collapse may not make a face any thinner. The compactness is 1 for
+// an equilateral triangle and 0 for a degenerate one.
+const double MIN_COMPACTNESS_C = 0.02;
+
+// CLASS QUADRIC:
+// Sum of the squared distances to a set of planes, stored as the upper triangle of a symmetric 
+// 4x4 matrix.
+class Quadric
+{
+public:
+  Quadric()
+  {
+    std::fill( this->q_, this->q_ + 10, 0.0 );
+  }
+
+  // Quadric of the plane a * x + b * y + c * z + d = 0, with ( a, b, c ) of unit length
+  Quadric( double a, double b, double c, double d )
+  {
+    this->q_[ 0 ] = a * a; this->q_[ 1 ] = a * b; this->q_[ 2 ] = a * c; this->q_[ 3 ] = a * d;
+    this->q_[ 4 ] = b * b; this->q_[ 5 ] = b * c; this->q_[ 6 ] = b * d;
+    this->q_[ 7 ] = c * c; this->q_[ 8 ] = c * d;
+    this->q_[ 9 ] = d * d;
+  }
+
+  Quadric& operator+=( const Quadric& q )
+  {
+    for ( int i = 0; i < 10; i++ ) this->q_[ i ] += q.q_[ i ];
+    return *this;
+  }
+
+  // EVALUATE:
+  // Get the sum of the squared distances from the point to the planes.
+  double evaluate( const double* p ) const
+  {
+    const double* q = this->q_;
+    double x = p[ 0 ], y = p[ 1 ], z = p[ 2 ];
+    return q[ 0 ] * x * x + 2.0 * ( q[ 1 ] * x * y + q[ 2 ] * x * z + q[ 3 ] * x ) + 
+      q[ 4 ] * y * y + 2.0 * ( q[ 5 ] * y * z + q[ 6 ] * y ) + 
+      q[ 7 ] * z * z + 2.0 * q[ 8 ] * z + q[ 9 ];
+  }
+
+  // MINIMIZE:
+  // Find the point with the smallest error. Returns false if the planes do not determine a 
+  // single point, e.g. if they are all parallel.
+  bool minimize( double* p ) const
+  {
+    const double* q = this->q_;
+    double c00 = q[ 4 ] * q[ 7 ] - q[ 5 ] * q[ 5 ];
+    double c01 = q[ 2 ] * q[ 5 ] - q[ 1 ] * q[ 7 ];
+    double c02 = q[ 1 ] * q[ 5 ] - q[ 2 ] * q[ 4 ];
+    double det = q[ 0 ] * c00 + q[ 1 ] * c01 + q[ 2 ] * c02;
+    double trace = q[ 0 ] + q[ 4 ] + q[ 7 ];
+    if ( !( std::fabs( det ) > 1e-6 * trace * trace * trace ) ) return false;
+
+    double c11 = q[ 0 ] * q[ 7 ] - q[ 2 ] * q[ 2 ];
+    double c12 = q[ 1 ] * q[ 2 ] - q[ 0 ] * q[ 5 ];
+    double c22 = q[ 0 ] * q[ 4 ] - q[ 1 ] * q[ 1 ];
+    p[ 0 ] = -( c00 * q[ 3 ] + c01 * q[ 6 ] + c02 * q[ 8 ] ) / det;
+    p[ 1 ] = -( c01 * q[ 3 ] + c11 * q[ 6 ] + c12 * q[ 8 ] ) / det;
+    p[ 2 ] = -( c02 * q[ 3 ] + c12 * q[ 6 ] + c22 * q[ 8 ] ) / det;
+    return true;
+  }
+
+private:
+  double q_[ 10 ];
+};
+
+// PLANEQUADRIC:
+// Get the quadric of the plane through a face. Returns false if the face is degenerate.
+bool PlaneQuadric( const double* p0, const double* p1, const double* p2, Quadric& quadric )
+{
+  double e1[ 3 ] = { p1[ 0 ] - p0[ 0 ], p1[ 1 ] - p0[ 1 ], p1[ 2 ] - p0[ 2 ] };
+  double e2[ 3 ] = { p2[ 0 ] - p0[ 0 ], p2[ 1 ] - p0[ 1 ], p2[ 2 ] - p0[ 2 ] };
+  double n[ 3 ] = { e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ], e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ],
+    e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ] };
+  double length = std::sqrt( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+  if ( length == 0.0 ) return false;
+  n[ 0 ] /= length; n[ 1 ] /= length; n[ 2 ] /= length;
+  quadric = Quadric( n[ 0 ], n[ 1 ], n[ 2 ], 
+    -( n[ 0 ] * p0[ 0 ] + n[ 1 ] * p0[ 1 ] + n[ 2 ] * p0[ 2 ] ) );
+  return true;
+}
+
+// CLASS COLLAPSE:
+// Collapse of vertex v_ into vertex u_, which is moved to position_. The collapse is outdated if
+// the stamp of one of the vertices changed since it was computed.
+class Collapse
+{
+public:
+  // The priority queue returns the collapse with the smallest cost first
+  bool operator<( const Collapse& c ) const
+  {
+    return this->cost_ > c.cost_;
+  }
+
+  double cost_;
+  double position_[ 3 ];
+  unsigned int u_;
+  unsigned int v_;
+  unsigned int u_stamp_;
+  unsigned int v_stamp_;
+};
+
+// CLASS PARTITIONDECIMATOR:
+// Decimates the faces of one partition in a local numbering of its vertices.
+class PartitionDecimator
+{
+public:
+  // The quadrics of the vertices are computed from the faces of the partition, unless they are
+  // given in the original numbering of the points
+  PartitionDecimator( const unsigned int* faces, size_t num_face_indices, 
+    const PointFVector& points, const std::vector< char >& shared, 
+    const std::vector< Quadric >* quadrics = 0 );
+
+  // GET_NUM_SEAM_FACES:
+  // Get the number of faces that use a vertex shared with other partitions.
+  size_t get_num_seam_faces() const;
+
+  // DECIMATE:
+  // Collapse edges until at most target_faces faces are left or the next collapse costs more
+  // than max_error2. A max_error2 of 0 does not bound the cost.
+  void decimate( size_t target_faces, double max_error2 );
+
+  // GET_RESULT:
+  // Append the remaining faces in the original point numbering to faces, and store the 
+  // position of the remaining vertices that are not shared with other partitions in points. 
+  // Their entries in keep are set. If face_indices is given, the input index of each remaining
+  // face is appended to it. If quadrics is given, the quadrics of those vertices are stored in
+  // it as well.
+  void get_result( UIntVector& faces, PointFVector& points, std::vector< char >& keep,
+    UIntVector* face_indices = 0, std::vector< Quadric >* quadrics = 0 ) const;
+
+  // Largest cost of the collapses that were done
+  double max_cost_;
+
+private:
+  // GET_NEIGHBORS:
+  // Get the sorted vertices that share a face with vertex u.
+  void get_neighbors( unsigned int u, UIntVector& neighbors ) const;
+
+  // LOCK_BOUNDARY:
+  // Lock the vertices of edges that do not have exactly two faces.
+  void lock_boundary();
+
+  // ADD_COLLAPSE:
+  // Compute the cheapest collapse of edge ( a, b ) and add it to the queue.
+  void add_collapse( unsigned int a, unsigned int b );
+
+  // PRESERVES_FACE:
+  // Check that moving vertex w of face f to position p does not flip the face or turn it into 
+  // a sliver.
+  bool preserves_face( unsigned int f, unsigned int w, const double* p ) const;
+
+  // TRY_COLLAPSE:
+  // Do the collapse if it preserves the topology and does not flip faces.
+  bool try_collapse( const Collapse& collapse );
+
+  const double* position( unsigned int v ) const
+  {
+    return &this->positions_[ 3 * v ];
+  }
+
+  // Original index of each local vertex
+  UIntVector vertices_;
+  // Three local vertices per face
+  UIntVector faces_;
+  std::vector< char > face_removed_;
+  // Faces that use each vertex
+  std::vector< UIntVector > vertex_faces_;
+  std::vector< double > positions_;
+  std::vector< Quadric > quadrics_;
+  std::vector< char > locked_;
+  size_t num_seam_faces_;
+  UIntVector stamps_;
+  std::priority_queue< Collapse > queue_;
+  size_t num_faces_;
+
+  // Buffers for neighbor lists
+  UIntVector neighbors_u_;
+  UIntVector neighbors_v_;
+  UIntVector neighbors_;
+};
+
+PartitionDecimator::PartitionDecimator( const unsigned int* faces, size_t num_face_indices, 
+  const PointFVector& points, const std::vector< char >& shared, 
+  const std::vector< Quadric >* quadrics ) :
+  max_cost_( 0.0 )
+{
+  // Number the vertices of the partition in the order of their original index
+  this->vertices_.assign( faces, faces + num_face_indices );
+  std::sort( this->vertices_.begin(), this->vertices_.end() );
+  this->vertices_.erase( std::unique( this->vertices_.begin(), this->vertices_.end() ), 
+    this->vertices_.end() );
+  size_t num_vertices = this->vertices_.size();
+
+  this->num_faces_ = num_face_indices / 3;
+  this->faces_.resize( this->num_faces_ * 3 );
+  for ( size_t i = 0; i < this->faces_.size(); i++ )
+  {
+    this->faces_[ i ] = static_cast< unsigned int >( std::lower_bound( this->vertices_.begin(), 
+      this->vertices_.end(), faces[ i ] ) - this->vertices_.begin() );
+  }
+  this->face_removed_.resize( this->num_faces_, 0 );
+
+  this->positions_.resize( 3 * num_vertices );
+  this->locked_.resize( num_vertices );
+  for ( size_t v = 0; v < num_vertices; v++ )
+  {
+    const PointF& p = points[ this->vertices_[ v ] ];
+    this->positions_[ 3 * v ] = p.x();
+    this->positions_[ 3 * v + 1 ] = p.y();
+    this->positions_[ 3 * v + 2 ] = p.z();
+    // Vertices that other partitions use are left in place
+    this->locked_[ v ] = shared[ this->vertices_[ v ] ];
+  }
+  this->stamps_.resize( num_vertices, 0 );
+
+  this->vertex_faces_.resize( num_vertices );
+  this->quadrics_.resize( num_vertices );
+  this->num_seam_faces_ = 0;
+  for ( unsigned int f = 0; f < this->num_faces_; f++ )
+  {
+    const unsigned int* face = &this->faces_[ 3 * f ];
+    for ( int k = 0; k < 3; k++ ) this->vertex_faces_[ face[ k ] ].push_back( f );
+    if ( this->locked_[ face[ 0 ] ] || this->locked_[ face[ 1 ] ] || this->locked_[ face[ 2 ] ] )
+    {
+      this->num_seam_faces_++;
+    }
+
+    // Each vertex starts with the planes of its faces, unless the quadrics are given
+    Quadric plane;
+    if ( quadrics || !PlaneQuadric( this->position( face[ 0 ] ), this->position( face[ 1 ] ),
+      this->position( face[ 2 ] ), plane ) ) continue;
+    for ( int k = 0; k < 3; k++ ) this->quadrics_[ face[ k ] ] += plane;
+  }
+
+  if ( quadrics )
+  {
+    for ( size_t v = 0; v < num_vertices; v++ )
+    {
+      this->quadrics_[ v ] = ( *quadrics )[ this->vertices_[ v ] ];
+    }
+  }
+
+  this->lock_boundary();
+}
+
+size_t PartitionDecimator::get_num_seam_faces() const
+{
+  return this->num_seam_faces_;
+}
+
+void PartitionDecimator::get_neighbors( unsigned int u, UIntVector& neighbors ) const
+{
+  neighbors.clear();
+  const UIntVector& faces = this->vertex_faces_[ u ];
+  for ( size_t i = 0; i < faces.size(); i++ )
+  {
+    const unsigned int* face = &this->faces_[ 3 * faces[ i ] ];
+    for ( int k = 0; k < 3; k++ )
+    {
+      if ( face[ k ] != u ) neighbors.push_back( face[ k ] );
+    }
+  }
+  std::sort( neighbors.begin(), neighbors.end() );
+  neighbors.erase( std::unique( neighbors.begin(), neighbors.end() ), neighbors.end() );
+}
+
+void PartitionDecimator::lock_boundary()
+{
+  UIntVector ring;
+  for ( unsigned int u = 0; u < this->vertex_faces_.size(); u++ )
+  {
+    // Each neighbor appears once for every face of the edge to it
+    ring.clear();
+    const UIntVector& faces = this->vertex_faces_[ u ];
+    for ( size_t i = 0; i < faces.size(); i++ )
+    {
+      const unsigned int* face = &this->faces_[ 3 * faces[ i ] ];
+      if ( face[ 0 ] == face[ 1 ] || face[ 1 ] == face[ 2 ] || face[ 0 ] == face[ 2 ] )
+      {
+        // Leave degenerate faces alone
+        for ( int k = 0; k < 3; k++ ) this->locked_[ face[ k ] ] = 1;
+        continue;
+      }
+      for ( int k = 0; k < 3; k++ )
+      {
+        if ( face[ k ] != u ) ring.push_back( face[ k ] );
+      }
+    }
+    std::sort( ring.begin(), ring.end() );
+
+    for ( size_t i = 0; i < ring.size(); )
+    {
+      size_t j = i + 1;
+      while ( j < ring.size() && ring[ j ] == ring[ i ] ) j++;
+      if ( j - i != 2 )
+      {
+        this->locked_[ u ] = 1;
+        this->locked_[ ring[ i ] ] = 1;
+      }
+      i = j;
+    }
+  }
+}
+
+void PartitionDecimator::add_collapse( unsigned int a, unsigned int b )
+{
+  if ( this->locked_[ a ] && this->locked_[ b ] ) return;
+
+  // A locked vertex stays where it is
+  if ( this->locked_[ a ] ) std::swap( a, b );
+  Collapse collapse;
+  collapse.u_ = b;
+  collapse.v_ = a;
+  collapse.u_stamp_ = this->stamps_[ b ];
+  collapse.v_stamp_ = this->stamps_[ a ];
+
+  Quadric quadric = this->quadrics_[ a ];
+  quadric += this->quadrics_[ b ];
+  const double* pa = this->position( a );
+  const double* pb = this->position( b );
+  double* p = collapse.position_;
+
+  if ( this->locked_[ b ] )
+  {
+    std::copy( pb, pb + 3, p );
+    collapse.cost_ = quadric.evaluate( p );
+  }
+  else
+  {
+    // Use the optimal position if it is close to the edge, otherwise the best of the end 
+    // points and the midpoint
+    double mid[ 3 ] = { 0.5 * ( pa[ 0 ] + pb[ 0 ] ), 0.5 * ( pa[ 1 ] + pb[ 1 ] ), 
+      0.5 * ( pa[ 2 ] + pb[ 2 ] ) };
+    double edge2 = ( pa[ 0 ] - pb[ 0 ] ) * ( pa[ 0 ] - pb[ 0 ] ) + 
+      ( pa[ 1 ] - pb[ 1 ] ) * ( pa[ 1 ] - pb[ 1 ] ) + ( pa[ 2 ] - pb[ 2 ] ) * ( pa[ 2 ] - pb[ 2 ] );
+    if ( quadric.minimize( p ) && ( p[ 0 ] - mid[ 0 ] ) * ( p[ 0 ] - mid[ 0 ] ) + 
+      ( p[ 1 ] - mid[ 1 ] ) * ( p[ 1 ] - mid[ 1 ] ) + ( p[ 2 ] - mid[ 2 ] ) * ( p[ 2 ] - mid[ 2 ] ) 
+      <= edge2 )
+    {
+      collapse.cost_ = quadric.evaluate( p );
+    }
+    else
+    {
+      const double* candidates[ 3 ] = { mid, pb, pa };
+      collapse.cost_ = -1.0;
+      for ( int i = 0; i < 3; i++ )
+      {
+        double cost = quadric.evaluate( candidates[ i ] );
+        if ( collapse.cost_ < 0.0 || cost < collapse.cost_ )
+        {
+          collapse.cost_ = cost;
+          std::copy( candidates[ i ], candidates[ i ] + 3, p );
+        }
+      }
+    }
+  }
+
+  // Rounding can make the error slightly negative
+  collapse.cost_ = std::max( collapse.cost_, 0.0 );
+  this->queue_.push( collapse );
+}
+
+bool PartitionDecimator::preserves_face( unsigned int f, unsigned int w, 
+  const double* p ) const
+{
+  const unsigned int* face = &this->faces_[ 3 * f ];
+  double normals[ 2 ][ 3 ];
+  double compactness[ 2 ];
+  for ( int j = 0; j < 2; j++ )
+  {
+    // The face before and after the collapse
+    const double* t[ 3 ];
+    for ( int k = 0; k < 3; k++ )
+    {
+      t[ k ] = ( j == 1 && face[ k ] == w ) ? p : this->position( face[ k ] );
+    }
+    double e[ 3 ][ 3 ];
+    double sum_edges2 = 0.0;
+    for ( int k = 0; k < 3; k++ )
+    {
+      for ( int i = 0; i < 3; i++ ) e[ k ][ i ] = t[ ( k + 1 ) % 3 ][ i ] - t[ k ][ i ];
+      sum_edges2 += e[ k ][ 0 ] * e[ k ][ 0 ] + e[ k ][ 1 ] * e[ k ][ 1 ] + 
+        e[ k ][ 2 ] * e[ k ][ 2 ];
+    }
+    double* n = normals[ j ];
+    n[ 0 ] = e[ 0 ][ 1 ] * e[ 1 ][ 2 ] - e[ 0 ][ 2 ] * e[ 1 ][ 1 ];
+    n[ 1 ] = e[ 0 ][ 2 ] * e[ 1 ][ 0 ] - e[ 0 ][ 0 ] * e[ 1 ][ 2 ];
+    n[ 2 ] = e[ 0 ][ 0 ] * e[ 1 ][ 1 ] - e[ 0 ][ 1 ] * e[ 1 ][ 0 ];
+    double length = std::sqrt( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+    // The length of the normal is twice the area of the face
+    compactness[ j ] = sum_edges2 > 0.0 ? 2.0 * std::sqrt( 3.0 ) * length / sum_edges2 : 0.0;
+    if ( length > 0.0 )
+    {
+      n[ 0 ] /= length; n[ 1 ] /= length; n[ 2 ] /= length;
+    }
+  }
+
+  if ( compactness[ 1 ] < MIN_COMPACTNESS_C && compactness[ 1 ] < compactness[ 0 ] ) return false;
+  return normals[ 0 ][ 0 ] * normals[ 1 ][ 0 ] + normals[ 0 ][ 1 ] * normals[ 1 ][ 1 ] + 
+    normals[ 0 ][ 2 ] * normals[ 1 ][ 2 ] > MIN_NORMAL_COSINE_C;
+}
+
+bool PartitionDecimator::try_collapse( const Collapse& collapse )
+{
+  unsigned int u = collapse.u_;
+  unsigned int v = collapse.v_;
+
+  // An interior manifold edge has two faces
+  unsigned int edge_faces[ 2 ];
+  unsigned int opposite[ 2 ];
+  size_t num_edge_faces = 0;
+  const UIntVector& faces_v = this->vertex_faces_[ v ];
+  for ( size_t i = 0; i < faces_v.size(); i++ )
+  {
+    const unsigned int* face = &this->faces_[ 3 * faces_v[ i ] ];
+    if ( face[ 0 ] != u && face[ 1 ] != u && face[ 2 ] != u ) continue;
+    if ( num_edge_faces == 2 ) return false;
+    edge_faces[ num_edge_faces ] = faces_v[ i ];
+    opposite[ num_edge_faces ] = face[ 0 ] ^ face[ 1 ] ^ face[ 2 ] ^ u ^ v;
+    num_edge_faces++;
+  }
+  if ( num_edge_faces != 2 || opposite[ 0 ] == opposite[ 1 ] ) return false;
+
+  // Link condition: the only vertices adjacent to both u and v are the opposite vertices,
+  // otherwise the collapse would pinch the surface
+  this->get_neighbors( u, this->neighbors_u_ );
+  this->get_neighbors( v, this->neighbors_v_ );
+  this->neighbors_.clear();
+  std::set_intersection( this->neighbors_u_.begin(), this->neighbors_u_.end(), 
+    this->neighbors_v_.begin(), this->neighbors_v_.end(), std::back_inserter( this->neighbors_ ) );
+  if ( this->neighbors_.size() != 2 ) return false;
+
+  // Do not create vertices with fewer than three neighbors, e.g. by collapsing a tetrahedron
+  if ( this->neighbors_u_.size() + this->neighbors_v_.size() < 7 ) return false;
+  for ( int k = 0; k < 2; k++ )
+  {
+    this->get_neighbors( opposite[ k ], this->neighbors_ );
+    if ( this->neighbors_.size() <= 3 ) return false;
+  }
+
+  // The faces that remain must not flip
+  const double* p = collapse.position_;
+  for ( int j = 0; j < 2; j++ )
+  {
+    unsigned int w = j == 0 ? u : v;
+    const UIntVector& faces = this->vertex_faces_[ w ];
+    for ( size_t i = 0; i < faces.size(); i++ )
+    {
+      if ( faces[ i ] == edge_faces[ 0 ] || faces[ i ] == edge_faces[ 1 ] ) continue;
+      if ( !this->preserves_face( faces[ i ], w, p ) ) return false;
+    }
+  }
+
+  // Remove the faces of the edge
+  for ( int k = 0; k < 2; k++ )
+  {
+    this->face_removed_[ edge_faces[ k ] ] = 1;
+    unsigned int w[ 2 ] = { u, opposite[ k ] };
+    for ( int j = 0; j < 2; j++ )
+    {
+      UIntVector& faces = this->vertex_faces_[ w[ j ] ];
+      faces.erase( std::find( faces.begin(), faces.end(), edge_faces[ k ] ) );
+    }
+  }
+
+  // Move the other faces of v to u
+  UIntVector& faces_u = this->vertex_faces_[ u ];
+  for ( size_t i = 0; i < faces_v.size(); i++ )
+  {
+    unsigned int f = faces_v[ i ];
+    if ( this->face_removed_[ f ] ) continue;
+    unsigned int* face = &this->faces_[ 3 * f ];
+    for ( int k = 0; k < 3; k++ )
+    {
+      if ( face[ k ] == v ) face[ k ] = u;
+    }
+    faces_u.push_back( f );
+  }
+  UIntVector().swap( this->vertex_faces_[ v ] );
+
+  this->quadrics_[ u ] += this->quadrics_[ v ];
+  std::copy( p, p + 3, this->positions_.begin() + 3 * u );
+  this->stamps_[ u ]++;
+  this->stamps_[ v ]++;
+  this->num_faces_ -= 2;
+  this->max_cost_ = std::max( this->max_cost_, collapse.cost_ );
+
+  // The edges around u have a new cost
+  this->get_neighbors( u, this->neighbors_u_ );
+  for ( size_t i = 0; i < this->neighbors_u_.size(); i++ )
+  {
+    this->add_collapse( u, this->neighbors_u_[ i ] );
+  }
+  return true;
+}
+
+void PartitionDecimator::decimate( size_t target_faces, double max_error2 )
+{
+  UIntVector neighbors;
+  for ( unsigned int u = 0; u < this->vertex_faces_.size(); u++ )
+  {
+    this->get_neighbors( u, neighbors );
+    for ( size_t i = 0; i < neighbors.size(); i++ )
+    {
+      if ( neighbors[ i ] > u ) this->add_collapse( u, neighbors[ i ] );
+    }
+  }
+
+  while ( this->num_faces_ > target_faces && !this->queue_.empty() )
+  {
+    Collapse collapse = this->queue_.top();
+    this->queue_.pop();
+    if ( collapse.u_stamp_ != this->stamps_[ collapse.u_ ] || 
+      collapse.v_stamp_ != this->stamps_[ collapse.v_ ] ) continue;
+    if ( max_error2 > 0.0 && collapse.cost_ > max_error2 ) break;
+    this->try_collapse( collapse );
+  }
+
+  // Release the memory of the queue
+  std::priority_queue< Collapse >().swap( this->queue_ );
+}
+
+void PartitionDecimator::get_result( UIntVector& faces, PointFVector& points, 
+  std::vector< char >& keep, UIntVector* face_indices, std::vector< Quadric >* quadrics ) const
+{
+  faces.reserve( faces.size() + 3 * this->num_faces_ );
+  for ( size_t f = 0; f < this->face_removed_.size(); f++ )
+  {
+    if ( this->face_removed_[ f ] ) continue;
+    if ( face_indices ) face_indices->push_back( static_cast< unsigned int >( f ) );
+    for ( int k = 0; k < 3; k++ )
+    {
+      faces.push_back( this->vertices_[ this->faces_[ 3 * f + k ] ] );
+    }
+  }
+
+  for ( size_t v = 0; v < this->vertices_.size(); v++ )
+  {
+    unsigned int index = this->vertices_[ v ];
+    if ( this->vertex_faces_[ v ].empty() || keep[ index ] ) continue;
+    const double* p = this->position( static_cast< unsigned int >( v ) );
+    points[ index ] = PointF( static_cast< float >( p[ 0 ] ), static_cast< float >( p[ 1 ] ), 
+      static_cast< float >( p[ 2 ] ) );
+    if ( quadrics ) ( *quadrics )[ index ] = this->quadrics_[ v ];
+    keep[ index ] = 1;
+  }
+}
+
+} // end anonymous namespace
+
+class MeshDecimatorPrivate
+{
+public:
+  // MARK_SHARED_POINTS:
+  // Mark the points that are used by more than one of the lists of face indices in shared.
+  void mark_shared_points( const std::vector< std::pair< const unsigned int*, size_t > >& parts,
+    std::vector< char >& shared );
+
+  // DECIMATE_SEAMS:
+  // Decimate the faces around the points that were shared between partitions, which the 
+  // partitions themselves had to leave in place, in regions that straddle the seams. The 
+  // remaining faces go back to the partition they came from.
+  bool decimate_seams( MeshDecimator::abort_function_type abort );
+
+  // DECIMATE_FINAL:
+  // Decimate the faces of all partitions together if they are still above the target. Collapses
+  // in the seams are often blocked, as the faces there are much smaller than the decimated faces
+  // next to them. The remaining faces go back to the partition they came from.
+  void decimate_final();
+
+  // PARALLEL_DECIMATE_SEAMS:
+  // Decimate the regions [ begin, end ) around the seams.
+  void parallel_decimate_seams( size_t begin, size_t end );
+
+  // PARALLEL_DECIMATE:
+  // Decimate partitions [ begin, end ).
+  void parallel_decimate( size_t begin, size_t end );
+
+  // PARALLEL_COUNT_POINTS:
+  // Count the points that are kept in the blocks [ begin, end ) of POINT_GRAIN_C points.
+  void parallel_count_points( size_t begin, size_t end );
+
+  // PARALLEL_RENUMBER_POINTS:
+  // Number the points that are kept in the blocks [ begin, end ) and copy them.
+  void parallel_renumber_points( size_t begin, size_t end );
+
+  // PARALLEL_COPY_FACES:
+  // Copy the faces of partitions [ begin, end ) into the result in the new point numbering.
+  void parallel_copy_faces( size_t begin, size_t end );
+
+  // PARALLEL_COMPUTE_NORMALS:
+  // Accumulate the face normals and areas of partitions [ begin, end ). Normals of points that 
+  // other partitions use are collected separately, so they can be added in a fixed order.
+  void parallel_compute_normals( size_t begin, size_t end );
+
+  // PARALLEL_NORMALIZE:
+  // Normalize the normals of the blocks [ begin, end ).
+  void parallel_normalize( size_t begin, size_t end );
+
+  // Input mesh
+  PointFVector input_points_;
+  UIntVector input_faces_;
+  MeshDecimator::range_vector_type input_part_faces_;
+
+  // Parameters of the decimation
+  size_t target_faces_;
+  double target_fraction_;
+  double max_error2_;
+
+  // Whether each point is used by more than one partition and whether it is kept
+  std::vector< char > shared_;
+  std::vector< char > keep_;
+  // Positions of the points after decimation, in the original numbering
+  PointFVector positions_;
+  // Quadrics of the points after the first pass, in the original numbering, which the seam 
+  // pass continues from
+  std::vector< Quadric > quadrics_;
+
+  // Remaining faces of each partition in the original numbering, and the largest cost
+  std::vector< UIntVector > part_result_faces_;
+  std::vector< double > part_max_cost_;
+
+  // Faces of the regions around the seams, the partition of each face, the points that are 
+  // used by more than one region and the largest cost
+  std::vector< UIntVector > region_faces_;
+  std::vector< UIntVector > region_parts_;
+  std::vector< char > region_shared_;
+  std::vector< double > region_max_cost_;
+  // Largest cost of the final pass
+  double final_max_cost_;
+
+  // Number of kept points in each block and in the blocks before it
+  IVector block_count_;
+  IVector block_offset_;
+  // New index of each original point and whether the new point is shared
+  UIntVector point_index_;
+  std::vector< char > point_shared_;
+
+  // Area of each partition and normals of the shared points of each partition
+  std::vector< float > part_area_;
+  std::vector< std::vector< std::pair< unsigned int, VectorF > > > part_shared_normals_;
+
+  // Output mesh
+  PointFVector points_;
+  VectorFVector normals_;
+  UIntVector faces_;
+  MeshDecimator::range_vector_type part_faces_;
+  MeshDecimator::range_vector_type part_points_;
+  float area_;
+  double max_error_;
+};
+
+void MeshDecimatorPrivate::mark_shared_points( 
+  const std::vector< std::pair< const unsigned int*, size_t > >& parts, 
+  std::vector< char >& shared )
+{
+  // NOTE: This is a single pass over the face indices, which is cheap compared to the 
+  // decimation itself.
+  UIntVector partition( shared.size(), NO_PARTITION_C );
+  std::fill( shared.begin(), shared.end(), 0 );
+  for ( size_t j = 0; j < parts.size(); j++ )
+  {
+    for ( size_t i = 0; i < parts[ j ].second; i++ )
+    {
+      unsigned int index = parts[ j ].first[ i ];
+      if ( partition[ index ] == NO_PARTITION_C )
+      {
+        partition[ index ] = static_cast< unsigned int >( j );
+      }
+      else if ( partition[ index ] != j )
+      {
+        shared[ index ] = 1;
+      }
+    }
+  }
+}
+
+bool MeshDecimatorPrivate::decimate_seams( MeshDecimator::abort_function_type abort )
+{
+  // Region j covers the second half of partition j - 1 and the first half of partition j, so 
+  // the seam between them is in its interior. The first half of the first partition and the 
+  // second half of the last partition are left as they are.
+  size_t num_parts = this->part_result_faces_.size();
+  this->region_faces_.assign( num_parts + 1, UIntVector() );
+  this->region_parts_.assign( num_parts + 1, UIntVector() );
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    const UIntVector& faces = this->part_result_faces_[ j ];
+    size_t half = 3 * ( faces.size() / 6 );
+    this->region_faces_[ j ].insert( this->region_faces_[ j ].end(), faces.begin(), 
+      faces.begin() + half );
+    this->region_parts_[ j ].insert( this->region_parts_[ j ].end(), half / 3, 
+      static_cast< unsigned int >( j ) );
+    this->region_faces_[ j + 1 ].insert( this->region_faces_[ j + 1 ].end(), 
+      faces.begin() + half, faces.end() );
+    this->region_parts_[ j + 1 ].insert( this->region_parts_[ j + 1 ].end(), 
+      ( faces.size() - half ) / 3, static_cast< unsigned int >( j ) );
+  }
+
+  // The points used by more than one region stay in place this time
+  std::vector< std::pair< const unsigned int*, size_t > > regions( num_parts + 1 );
+  for ( size_t j = 0; j <= num_parts; j++ )
+  {
+    const UIntVector& faces = this->region_faces_[ j ];
+    regions[ j ] = std::make_pair( faces.empty() ? 0 : &faces[ 0 ], faces.size() );
+  }
+  this->region_shared_.assign( this->shared_.size(), 0 );
+  this->mark_shared_points( regions, this->region_shared_ );
+  for ( size_t j = 1; j < num_parts; j++ )
+  {
+    const UIntVector& faces = this->region_faces_[ j ];
+    for ( size_t i = 0; i < faces.size(); i++ )
+    {
+      this->keep_[ faces[ i ] ] = this->region_shared_[ faces[ i ] ];
+    }
+  }
+
+  this->region_max_cost_.assign( num_parts + 1, 0.0 );
+  if ( !parallel_for( 1, num_parts, 1, boost::bind( 
+    &MeshDecimatorPrivate::parallel_decimate_seams, this, _1, _2 ), abort ) )
+  {
+    return false;
+  }
+
+  // The faces go back to the partition they came from, the first half of each partition is
+  // followed by its second half
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    UIntVector& faces = this->part_result_faces_[ j ];
+    faces.clear();
+    for ( size_t r = j; r <= j + 1; r++ )
+    {
+      const UIntVector& region_faces = this->region_faces_[ r ];
+      const UIntVector& region_parts = this->region_parts_[ r ];
+      for ( size_t i = 0; i < region_parts.size(); i++ )
+      {
+        if ( region_parts[ i ] != j ) continue;
+        faces.insert( faces.end(), &region_faces[ 3 * i ], &region_faces[ 3 * i ] + 3 );
+      }
+    }
+  }
+  this->region_faces_.clear();
+  this->region_parts_.clear();
+  return true;
+}
+
+void MeshDecimatorPrivate::decimate_final()
+{
+  this->final_max_cost_ = 0.0;
+  size_t num_parts = this->part_result_faces_.size();
+  UIntVector faces;
+  UIntVector parts;
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    const UIntVector& part_faces = this->part_result_faces_[ j ];
+    faces.insert( faces.end(), part_faces.begin(), part_faces.end() );
+    parts.insert( parts.end(), part_faces.size() / 3, static_cast< unsigned int >( j ) );
+  }
+  if ( faces.size() / 3 <= this->target_faces_ ) return;
+
+  // None of the points is shared anymore, the quadrics continue from the previous passes
+  std::vector< char > shared( this->keep_.size(), 0 );
+  for ( size_t i = 0; i < faces.size(); i++ )
+  {
+    this->keep_[ faces[ i ] ] = 0;
+  }
+  PartitionDecimator decimator( &faces[ 0 ], faces.size(), this->positions_, shared, 
+    &this->quadrics_ );
+  decimator.decimate( this->target_faces_, this->max_error2_ );
+
+  UIntVector result_faces;
+  UIntVector face_indices;
+  decimator.get_result( result_faces, this->positions_, this->keep_, &face_indices );
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    this->part_result_faces_[ j ].clear();
+  }
+  for ( size_t i = 0; i < face_indices.size(); i++ )
+  {
+    UIntVector& part_faces = this->part_result_faces_[ parts[ face_indices[ i ] ] ];
+    part_faces.insert( part_faces.end(), &result_faces[ 3 * i ], &result_faces[ 3 * i ] + 3 );
+  }
+  this->final_max_cost_ = decimator.max_cost_;
+}
+
+void MeshDecimatorPrivate::parallel_decimate_seams( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    UIntVector& faces = this->region_faces_[ j ];
+    UIntVector& parts = this->region_parts_[ j ];
+    if ( faces.empty() ) continue;
+
+    // Only the faces along the seam, which the first pass left alone, are reduced further
+    size_t num_seam_faces = 0;
+    for ( size_t i = 0; i < faces.size(); i += 3 )
+    {
+      if ( this->shared_[ faces[ i ] ] || this->shared_[ faces[ i + 1 ] ] || 
+        this->shared_[ faces[ i + 2 ] ] )
+      {
+        num_seam_faces++;
+      }
+    }
+    size_t target_faces = faces.size() / 3 - num_seam_faces + static_cast< size_t >( 
+      this->target_fraction_ * static_cast< double >( num_seam_faces ) + 0.5 );
+
+    PartitionDecimator decimator( &faces[ 0 ], faces.size(), this->positions_, 
+      this->region_shared_, &this->quadrics_ );
+    decimator.decimate( target_faces, this->max_error2_ );
+
+    UIntVector result_faces;
+    UIntVector face_indices;
+    decimator.get_result( result_faces, this->positions_, this->keep_, &face_indices, 
+      &this->quadrics_ );
+    UIntVector result_parts( face_indices.size() );
+    for ( size_t i = 0; i < face_indices.size(); i++ )
+    {
+      result_parts[ i ] = parts[ face_indices[ i ] ];
+    }
+    faces.swap( result_faces );
+    parts.swap( result_parts );
+    this->region_max_cost_[ j ] = decimator.max_cost_;
+  }
+}
+
+void MeshDecimatorPrivate::parallel_decimate( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    const MeshDecimator::range_type& range = this->input_part_faces_[ j ];
+    size_t num_face_indices = range.second - range.first;
+    if ( num_face_indices == 0 ) continue;
+
+    PartitionDecimator decimator( &this->input_faces_[ range.first ], num_face_indices, 
+      this->input_points_, this->shared_ );
+
+    // The faces along the seams with other partitions can hardly be reduced, so they are left
+    // out of the target instead of reducing the rest of the partition further
+    size_t num_seam_faces = decimator.get_num_seam_faces();
+    size_t target_faces = num_seam_faces + static_cast< size_t >( this->target_fraction_ * 
+      static_cast< double >( num_face_indices / 3 - num_seam_faces ) + 0.5 );
+    decimator.decimate( target_faces, this->max_error2_ );
+    decimator.get_result( this->part_result_faces_[ j ], this->positions_, this->keep_, 0,
+      this->quadrics_.empty() ? 0 : &this->quadrics_ );
+    this->part_max_cost_[ j ] = decimator.max_cost_;
+  }
+}
+
+void MeshDecimatorPrivate::parallel_count_points( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t point_end = std::min( ( j + 1 ) * POINT_GRAIN_C, this->keep_.size() );
+    size_t count = 0;
+    for ( size_t i = j * POINT_GRAIN_C; i < point_end; i++ )
+    {
+      if ( this->keep_[ i ] ) count++;
+    }
+    this->block_count_[ j ] = count;
+  }
+}
+
+void MeshDecimatorPrivate::parallel_renumber_points( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    size_t point_end = std::min( ( j + 1 ) * POINT_GRAIN_C, this->keep_.size() );
+    unsigned int index = static_cast< unsigned int >( this->block_offset_[ j ] );
+    for ( size_t i = j * POINT_GRAIN_C; i < point_end; i++ )
+    {
+      this->point_index_[ i ] = index;
+      if ( !this->keep_[ i ] ) continue;
+      this->points_[ index ] = this->positions_[ i ];
+      this->point_shared_[ index ] = this->shared_[ i ];
+      index++;
+    }
+  }
+}
+
+void MeshDecimatorPrivate::parallel_copy_faces( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    UIntVector& faces = this->part_result_faces_[ j ];
+    UIntVector::iterator face_it = this->faces_.begin() + this->part_faces_[ j ].first;
+    unsigned int first = NO_PARTITION_C;
+    unsigned int last = 0;
+    for ( size_t i = 0; i < faces.size(); i++, ++face_it )
+    {
+      *face_it = this->point_index_[ faces[ i ] ];
+      first = std::min( first, *face_it );
+      last = std::max( last, *face_it );
+    }
+    this->part_points_[ j ] = faces.empty() ? MeshDecimator::range_type( 0, 0 ) : 
+      MeshDecimator::range_type( first, last + 1 );
+    UIntVector().swap( faces );
+  }
+}
+
+void MeshDecimatorPrivate::parallel_compute_normals( size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    float area = 0.0f;
+    std::vector< std::pair< unsigned int, VectorF > >& shared_normals = 
+      this->part_shared_normals_[ j ];
+    for ( size_t i = this->part_faces_[ j ].first; i < this->part_faces_[ j ].second; i += 3 )
+    {
+      const unsigned int* face = &this->faces_[ i ];
+      const PointF& p0 = this->points_[ face[ 0 ] ];
+      const PointF& p1 = this->points_[ face[ 1 ] ];
+      const PointF& p2 = this->points_[ face[ 2 ] ];
+
+      // The length of the cross product is twice the area of the face
+      VectorF n = Cross( p2 - p1, p0 - p1 );
+      area += 0.5f * n.length();
+      for ( int k = 0; k < 3; k++ )
+      {
+        if ( this->point_shared_[ face[ k ] ] )
+        {
+          shared_normals.push_back( std::make_pair( face[ k ], n ) );
+        }
+        else
+        {
+          this->normals_[ face[ k ] ] += n;
+        }
+      }
+    }
+    this->part_area_[ j ] = area;
+  }
+}
+
+void MeshDecimatorPrivate::parallel_normalize( size_t begin, size_t end )
+{
+  size_t point_end = std::min( end * POINT_GRAIN_C, this->normals_.size() );
+  for ( size_t i = begin * POINT_GRAIN_C; i < point_end; i++ )
+  {
+    this->normals_[ i ].normalize();
+  }
+}
+
+MeshDecimator::MeshDecimator( const PointFVector& points, const UIntVector& faces ) :
+  private_( new MeshDecimatorPrivate )
+{
+  this->private_->input_points_ = points;
+  this->private_->input_faces_ = faces;
+  this->private_->input_part_faces_.push_back( range_type( 0, 
+    static_cast< unsigned int >( faces.size() ) ) );
+  this->private_->target_faces_ = 0;
+  this->private_->target_fraction_ = 1.0;
+  this->private_->max_error2_ = 0.0;
+  this->private_->final_max_cost_ = 0.0;
+  this->private_->area_ = 0.0f;
+  this->private_->max_error_ = 0.0;
+}
+
+MeshDecimator::~MeshDecimator()
+{
+}
+
+void MeshDecimator::set_partitions( const range_vector_type& part_faces )
+{
+  this->private_->input_part_faces_ = part_faces;
+}
+
+bool MeshDecimator::decimate( size_t target_faces, double max_error, 
+  abort_function_type abort )
+{
+  MeshDecimatorPrivateHandle d = this->private_;
+  size_t num_points = d->input_points_.size();
+  size_t num_parts = d->input_part_faces_.size();
+  size_t num_faces = d->input_faces_.size() / 3;
+
+  d->target_faces_ = target_faces;
+  d->target_fraction_ = num_faces == 0 ? 1.0 : 
+    std::min( 1.0, static_cast< double >( target_faces ) / static_cast< double >( num_faces ) );
+  d->max_error2_ = max_error * max_error;
+
+  // Find the points that are used by more than one partition, they are kept as they are
+  std::vector< std::pair< const unsigned int*, size_t > > parts( num_parts );
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    const range_type& range = d->input_part_faces_[ j ];
+    parts[ j ] = std::make_pair( d->input_faces_.empty() ? 0 : &d->input_faces_[ 0 ] + 
+      range.first, static_cast< size_t >( range.second - range.first ) );
+  }
+  d->shared_.assign( num_points, 0 );
+  d->mark_shared_points( parts, d->shared_ );
+  d->keep_ = d->shared_;
+
+  d->positions_ = d->input_points_;
+
+  // The seam pass continues from the quadrics of the first pass, so collapses in the seams 
+  // account for the faces that were removed before. The points on the seams start with the
+  // planes of all their faces, as no single partition sees all of them.
+  d->quadrics_.clear();
+  if ( num_parts > 1 )
+  {
+    d->quadrics_.resize( num_points );
+    for ( size_t i = 0; i < d->input_faces_.size(); i += 3 )
+    {
+      const unsigned int* face = &d->input_faces_[ i ];
+      if ( !d->shared_[ face[ 0 ] ] && !d->shared_[ face[ 1 ] ] && !d->shared_[ face[ 2 ] ] ) 
+      {
+        continue;
+      }
+      double p[ 3 ][ 3 ];
+      for ( int k = 0; k < 3; k++ )
+      {
+        const PointF& point = d->input_points_[ face[ k ] ];
+        p[ k ][ 0 ] = point.x(); p[ k ][ 1 ] = point.y(); p[ k ][ 2 ] = point.z();
+      }
+      Quadric plane;
+      if ( !PlaneQuadric( p[ 0 ], p[ 1 ], p[ 2 ], plane ) ) continue;
+      for ( int k = 0; k < 3; k++ )
+      {
+        if ( d->shared_[ face[ k ] ] ) d->quadrics_[ face[ k ] ] += plane;
+      }
+    }
+  }
+
+  d->part_result_faces_.assign( num_parts, UIntVector() );
+  d->part_max_cost_.assign( num_parts, 0.0 );
+  d->region_max_cost_.clear();
+  d->final_max_cost_ = 0.0;
+  if ( !parallel_for( 0, num_parts, 1, boost::bind( &MeshDecimatorPrivate::parallel_decimate, 
+    d, _1, _2 ), abort ) )
+  {
+    return false;
+  }
+
+  if ( num_parts > 1 )
+  {
+    if ( !d->decimate_seams( abort ) ) return false;
+    d->decimate_final();
+    std::vector< Quadric >().swap( d->quadrics_ );
+    if ( abort && abort() ) return false;
+
+    // Collapses in the seams can move faces onto points of a neighboring partition
+    for ( size_t j = 0; j < num_parts; j++ )
+    {
+      const UIntVector& faces = d->part_result_faces_[ j ];
+      parts[ j ] = std::make_pair( faces.empty() ? 0 : &faces[ 0 ], faces.size() );
+    }
+    d->mark_shared_points( parts, d->shared_ );
+  }
+
+  // Renumber the points that are kept in their original order
+  size_t num_blocks = ( num_points + POINT_GRAIN_C - 1 ) / POINT_GRAIN_C;
+  d->block_count_.resize( num_blocks );
+  d->block_offset_.resize( num_blocks + 1 );
+  parallel_for( 0, num_blocks, 1, boost::bind( &MeshDecimatorPrivate::parallel_count_points,
+    d, _1, _2 ) );
+  d->block_offset_[ 0 ] = 0;
+  for ( size_t j = 0; j < num_blocks; j++ )
+  {
+    d->block_offset_[ j + 1 ] = d->block_offset_[ j ] + d->block_count_[ j ];
+  }
+
+  size_t num_kept = d->block_offset_[ num_blocks ];
+  d->points_.resize( num_kept );
+  d->point_shared_.resize( num_kept );
+  d->point_index_.resize( num_points + 1 );
+  d->point_index_[ num_points ] = static_cast< unsigned int >( num_kept );
+  parallel_for( 0, num_blocks, 1, boost::bind( &MeshDecimatorPrivate::parallel_renumber_points,
+    d, _1, _2 ) );
+  PointFVector().swap( d->positions_ );
+
+  // The faces of the partitions are stored one after another
+  d->part_faces_.resize( num_parts );
+  d->part_points_.resize( num_parts );
+  unsigned int face_offset = 0;
+  d->max_error_ = std::sqrt( d->final_max_cost_ );
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    unsigned int size = static_cast< unsigned int >( d->part_result_faces_[ j ].size() );
+    d->part_faces_[ j ] = range_type( face_offset, face_offset + size );
+    face_offset += size;
+    d->max_error_ = std::max( d->max_error_, std::sqrt( d->part_max_cost_[ j ] ) );
+    if ( j < d->region_max_cost_.size() )
+    {
+      d->max_error_ = std::max( d->max_error_, std::sqrt( d->region_max_cost_[ j ] ) );
+    }
+  }
+  d->faces_.resize( face_offset );
+  parallel_for( 0, num_parts, 1, boost::bind( &MeshDecimatorPrivate::parallel_copy_faces,
+    d, _1, _2 ) );
+
+  // Area weighted normals, the shared points are added in the order of the partitions
+  d->normals_.assign( num_kept, VectorF( 0.0f, 0.0f, 0.0f ) );
+  d->part_area_.assign( num_parts, 0.0f );
+  d->part_shared_normals_.assign( num_parts, std::vector< std::pair< unsigned int, VectorF > >() );
+  parallel_for( 0, num_parts, 1, boost::bind( &MeshDecimatorPrivate::parallel_compute_normals,
+    d, _1, _2 ) );
+  d->area_ = 0.0f;
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    const std::vector< std::pair< unsigned int, VectorF > >& shared_normals = 
+      d->part_shared_normals_[ j ];
+    for ( size_t i = 0; i < shared_normals.size(); i++ )
+    {
+      d->normals_[ shared_normals[ i ].first ] += shared_normals[ i ].second;
+    }
+    d->area_ += d->part_area_[ j ];
+  }
+  d->part_shared_normals_.clear();
+  parallel_for( 0, ( num_kept + POINT_GRAIN_C - 1 ) / POINT_GRAIN_C, 1, boost::bind( 
+    &MeshDecimatorPrivate::parallel_normalize, d, _1, _2 ) );
+
+  return true;
+}
+
+const PointFVector& MeshDecimator::get_points() const
+{
+  return this->private_->points_;
+}
+
+const VectorFVector& MeshDecimator::get_normals() const
+{
+  return this->private_->normals_;
+}
+
+const UIntVector& MeshDecimator::get_faces() const
+{
+  return this->private_->faces_;
+}
+
+const MeshDecimator::range_vector_type& MeshDecimator::get_part_faces() const
+{
+  return this->private_->part_faces_;
+}
+
+const MeshDecimator::range_vector_type& MeshDecimator::get_part_points() const
+{
+  return this->private_->part_points_;
+}
+
+float MeshDecimator::get_area() const
+{
+  return this->private_->area_;
+}
+
+double MeshDecimator::get_max_error() const
+{
+  return this->private_->max_error_;
+}
+
+} // end namespace Core
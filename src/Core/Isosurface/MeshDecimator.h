@@ -0,0 +1,134 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORE_ISOSURFACE_MESHDECIMATOR_H
+#define CORE_ISOSURFACE_MESHDECIMATOR_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif 
+
+// STL includes
+#include <utility>
+#include <vector>
+
+// Boost includes
+#include <boost/function.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/utility.hpp>
+
+// Core includes
+#include <Core/Isosurface/Isosurface.h>
+
+namespace Core
+{
+
+class MeshDecimator;
+class MeshDecimatorPrivate;
+typedef boost::shared_ptr< MeshDecimator > MeshDecimatorHandle;
+typedef boost::shared_ptr< MeshDecimatorPrivate > MeshDecimatorPrivateHandle;
+
+// CLASS MESHDECIMATOR:
+/// Reduces a triangle mesh by collapsing edges in the order of their quadric error (Garland and
+/// Heckbert). The mesh is split into partitions of faces that are decimated in parallel on the
+/// ThreadPool. Vertices that are used by more than one partition are left in place, and the 
+/// faces around them are decimated afterwards in a second parallel pass over regions that 
+/// straddle the seams. Collapses in the seams are often blocked by the larger faces next to them,
+/// so if the mesh is still above the target a final serial pass decimates all the faces
+/// together. Vertices on boundary or non-manifold edges are never moved. A collapse
+/// is only done if it preserves the topology of the mesh and does not flip any face.
+
+class MeshDecimator : public boost::noncopyable
+{
+  // -- types --
+public:
+  typedef boost::function< bool () > abort_function_type;
+  typedef std::pair< unsigned int, unsigned int > range_type;
+  typedef std::vector< range_type > range_vector_type;
+
+  // -- constructor/destructor --
+public:
+  // The mesh is copied, face indices refer to points and there are 3 per face
+  MeshDecimator( const PointFVector& points, const UIntVector& faces );
+  virtual ~MeshDecimator();
+
+  // -- decimation --
+public:
+  // SET_PARTITIONS:
+  /// Split the mesh into ranges [ first, second ) of face indices that are decimated 
+  /// independently. The ranges need to cover all the faces. By default the whole mesh is a 
+  /// single partition.
+  void set_partitions( const range_vector_type& part_faces );
+
+  // DECIMATE:
+  /// Collapse edges until the mesh has at most target_faces faces or until the next collapse
+  /// would have a quadric error larger than max_error, measured as a distance. A max_error of 0 
+  /// does not bound the error. Each partition, and the seams between them, is reduced by the 
+  /// same fraction. Without a max_error the mesh is reduced to target_faces faces whether it
+  /// is partitioned or not. Returns false if the abort function returned true.
+  bool decimate( size_t target_faces, double max_error, 
+    abort_function_type abort = abort_function_type() );
+
+  // -- results --
+public:
+  // GET_POINTS:
+  /// Get the points of the decimated mesh. The points that remain keep their relative order.
+  const PointFVector& get_points() const;
+
+  // GET_NORMALS:
+  /// Get the area weighted vertex normals of the decimated mesh.
+  const VectorFVector& get_normals() const;
+
+  // GET_FACES:
+  /// Get the faces of the decimated mesh, 3 indices per face.
+  const UIntVector& get_faces() const;
+
+  // GET_PART_FACES:
+  /// Get the range of face indices of each partition in the decimated mesh. The faces of a
+  /// partition are stored in the same order as the partitions.
+  const range_vector_type& get_part_faces() const;
+
+  // GET_PART_POINTS:
+  /// Get the range [ first, second ) of points that the faces of each partition use.
+  const range_vector_type& get_part_points() const;
+
+  // GET_AREA:
+  /// Get the surface area of the decimated mesh.
+  float get_area() const;
+
+  // GET_MAX_ERROR:
+  /// Get the largest quadric error, as a distance, of the collapses that were done.
+  double get_max_error() const;
+
+private:
+  MeshDecimatorPrivateHandle private_;
+};
+
+} // end namespace Core
+
+#endif
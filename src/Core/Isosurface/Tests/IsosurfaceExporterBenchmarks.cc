@@ -0,0 +1,102 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <string>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/Isosurface/Isosurface.h>
+#include <Core/Volume/MaskVolume.h>
+
+using namespace Core;
+
+namespace
+{
+
+bool NoAbort()
+{
+  return false;
+}
+
+MaskVolumeHandle createSphere( size_t size )
+{
+  GridTransform grid_transform( size, size, size );
+  MaskDataBlockHandle mask;
+  MaskDataBlockManager::Create( grid_transform, mask );
+  double center = 0.5 * size, radius = 0.44 * size;
+  for ( size_t z = 0; z < size; z++ )
+    for ( size_t y = 0; y < size; y++ )
+      for ( size_t x = 0; x < size; x++ )
+      {
+        double dx = x - center, dy = y - center, dz = z - center;
+        if ( dx * dx + dy * dy + dz * dz < radius * radius ) mask->set_mask_at( x, y, z );
+      }
+  return MaskVolumeHandle( new MaskVolume( grid_transform, mask ) );
+}
+
+boost::filesystem::path tempPath( const std::string& extension )
+{
+  return boost::filesystem::temp_directory_path() / 
+    boost::filesystem::unique_path( "seg3d-export-%%%%-%%%%" + extension );
+}
+
+}
+
+TEST( IsosurfaceExporterBenchmarks, Throughput )
+{
+  MaskVolumeHandle volume = createSphere( 160 );
+  IsosurfaceHandle iso( new Isosurface( volume ) );
+  iso->compute( 1.0, false, &NoAbort );
+  size_t num_faces = iso->get_faces().size() / 3;
+
+  boost::filesystem::path path = tempPath( ".ply" );
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( iso->export_ply_isosurface( path ) );
+  boost::posix_time::ptime ply_done = boost::posix_time::microsec_clock::local_time();
+  boost::filesystem::remove( path );
+
+  path = tempPath( ".stl" );
+  ASSERT_TRUE( iso->export_stl_binary_isosurface( path, "sphere" ) );
+  boost::posix_time::ptime stl_done = boost::posix_time::microsec_clock::local_time();
+  boost::filesystem::remove( path );
+
+  path = tempPath( ".obj" );
+  ASSERT_TRUE( iso->export_obj_isosurface( path ) );
+  boost::posix_time::ptime obj_done = boost::posix_time::microsec_clock::local_time();
+  boost::filesystem::remove( path );
+
+  std::cout << "Exported " << num_faces << " faces: PLY " << 
+    ( ply_done - start ).total_milliseconds() << " ms, binary STL " << 
+    ( stl_done - ply_done ).total_milliseconds() << " ms, OBJ " << 
+    ( obj_done - stl_done ).total_milliseconds() << " ms" << std::endl;
+}
@@ -0,0 +1,346 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/function.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/Isosurface/Isosurface.h>
+#include <Core/Volume/MaskVolume.h>
+
+using namespace Core;
+
+namespace
+{
+
+typedef boost::function< bool ( double, double, double ) > shape_function_type;
+
+bool NoAbort()
+{
+  return false;
+}
+
+// Create a mask volume of the voxels that are inside the shape
+MaskVolumeHandle createMask( size_t nx, size_t ny, size_t nz, shape_function_type inside )
+{
+  GridTransform grid_transform( nx, ny, nz );
+  MaskDataBlockHandle mask;
+  MaskDataBlockManager::Create( grid_transform, mask );
+  for ( size_t z = 0; z < nz; z++ )
+    for ( size_t y = 0; y < ny; y++ )
+      for ( size_t x = 0; x < nx; x++ )
+        if ( inside( x, y, z ) ) mask->set_mask_at( x, y, z );
+  return MaskVolumeHandle( new MaskVolume( grid_transform, mask ) );
+}
+
+// A blob that is cut off by the border of the volume, so the capped isosurface has caps
+bool CornerBlob( double x, double y, double z )
+{
+  return x * x + y * y * 1.5 + z * z < 30.0 * 30.0;
+}
+
+boost::filesystem::path tempPath( const std::string& extension )
+{
+  return boost::filesystem::temp_directory_path() / 
+    boost::filesystem::unique_path( "seg3d-export-%%%%-%%%%" + extension );
+}
+
+// A mesh that is read back from a file
+struct Mesh
+{
+  PointFVector points_;
+  VectorFVector normals_;
+  UIntVector faces_;
+};
+
+bool readPLY( const boost::filesystem::path& path, Mesh& mesh )
+{
+  std::ifstream file( path.string().c_str(), std::ios::binary );
+  std::string line;
+  size_t num_vertices = 0, num_faces = 0, num_properties = 0;
+  while ( std::getline( file, line ) && line != "end_header" )
+  {
+    std::istringstream stream( line );
+    std::string word, element;
+    stream >> word;
+    if ( word == "format" )
+    {
+      stream >> word;
+      if ( word != "binary_little_endian" ) return false;
+    }
+    else if ( word == "element" )
+    {
+      stream >> element;
+      if ( element == "vertex" ) stream >> num_vertices;
+      else stream >> num_faces;
+    }
+    else if ( word == "property" && num_faces == 0 )
+    {
+      num_properties++;
+    }
+  }
+  if ( num_properties != 3 && num_properties != 6 ) return false;
+
+  mesh.points_.resize( num_vertices );
+  mesh.normals_.resize( num_properties == 6 ? num_vertices : 0 );
+  for ( size_t i = 0; i < num_vertices; i++ )
+  {
+    float v[ 6 ];
+    file.read( reinterpret_cast< char* >( v ), num_properties * sizeof( float ) );
+    mesh.points_[ i ] = PointF( v[ 0 ], v[ 1 ], v[ 2 ] );
+    if ( num_properties == 6 ) mesh.normals_[ i ] = VectorF( v[ 3 ], v[ 4 ], v[ 5 ] );
+  }
+  mesh.faces_.resize( 3 * num_faces );
+  for ( size_t i = 0; i < num_faces; i++ )
+  {
+    unsigned char count;
+    int indices[ 3 ];
+    file.read( reinterpret_cast< char* >( &count ), 1 );
+    file.read( reinterpret_cast< char* >( indices ), sizeof( indices ) );
+    if ( count != 3 ) return false;
+    for ( int k = 0; k < 3; k++ ) mesh.faces_[ 3 * i + k ] = indices[ k ];
+  }
+  // Nothing may follow the faces
+  return file.good() && file.peek() == EOF;
+}
+
+bool readOBJ( const boost::filesystem::path& path, Mesh& mesh )
+{
+  std::ifstream file( path.string().c_str() );
+  std::string line;
+  while ( std::getline( file, line ) )
+  {
+    std::istringstream stream( line );
+    std::string type;
+    stream >> type;
+    if ( type == "v" )
+    {
+      float x, y, z;
+      stream >> x >> y >> z;
+      mesh.points_.push_back( PointF( x, y, z ) );
+    }
+    else if ( type == "f" )
+    {
+      for ( int k = 0; k < 3; k++ )
+      {
+        unsigned int index;
+        stream >> index;
+        if ( index == 0 || index > mesh.points_.size() ) return false;
+        mesh.faces_.push_back( index - 1 );
+      }
+    }
+    if ( stream.fail() ) return false;
+  }
+  return true;
+}
+
+// The coordinates of the corners of each face must match, up to tolerance
+void expectSameFaces( const PointFVector& points, const UIntVector& faces, const Mesh& mesh, 
+  float tolerance )
+{
+  ASSERT_EQ( faces.size(), mesh.faces_.size() );
+  for ( size_t i = 0; i < faces.size(); i++ )
+  {
+    const PointF& p = points[ faces[ i ] ];
+    const PointF& q = mesh.points_[ mesh.faces_[ i ] ];
+    for ( int k = 0; k < 3; k++ )
+    {
+      ASSERT_NEAR( p[ k ], q[ k ], tolerance * std::max( 1.0f, std::fabs( p[ k ] ) ) ) << 
+        "face index " << i;
+    }
+  }
+}
+
+// Number of edges that do not have exactly two faces
+size_t countOpenEdges( const UIntVector& faces )
+{
+  std::map< std::pair< unsigned int, unsigned int >, int > edges;
+  for ( size_t i = 0; i < faces.size(); i += 3 )
+  {
+    for ( int k = 0; k < 3; k++ )
+    {
+      unsigned int a = faces[ i + k ], b = faces[ i + ( k + 1 ) % 3 ];
+      edges[ std::make_pair( std::min( a, b ), std::max( a, b ) ) ]++;
+    }
+  }
+  size_t count = 0;
+  for ( std::map< std::pair< unsigned int, unsigned int >, int >::iterator it = edges.begin();
+    it != edges.end(); ++it )
+  {
+    if ( it->second != 2 ) count++;
+  }
+  return count;
+}
+
+IsosurfaceHandle createCappedIsosurface()
+{
+  MaskVolumeHandle volume = createMask( 40, 36, 32, &CornerBlob );
+  IsosurfaceHandle iso( new Isosurface( volume ) );
+  iso->compute( 1.0, true, &NoAbort );
+  return iso;
+}
+
+}
+
+TEST( IsosurfaceExporterTests, PLYRoundTrip )
+{
+  IsosurfaceHandle iso = createCappedIsosurface();
+  const PointFVector& points = iso->get_points();
+  const UIntVector& faces = iso->get_faces();
+  ASSERT_FALSE( faces.empty() );
+
+  boost::filesystem::path path = tempPath( ".ply" );
+  ASSERT_TRUE( iso->export_ply_isosurface( path ) );
+  Mesh mesh;
+  ASSERT_TRUE( readPLY( path, mesh ) );
+  boost::filesystem::remove( path );
+
+  // Binary output is exact
+  expectSameFaces( points, faces, mesh, 0.0f );
+
+  // The caps duplicate the points along the border of the volume, welding them closes the 
+  // surface and leaves one point per position
+  std::set< std::pair< std::pair< float, float >, float > > positions;
+  for ( size_t i = 0; i < points.size(); i++ )
+  {
+    positions.insert( std::make_pair( std::make_pair( points[ i ].x(), points[ i ].y() ), 
+      points[ i ].z() ) );
+  }
+  EXPECT_LT( mesh.points_.size(), points.size() );
+  EXPECT_EQ( positions.size(), mesh.points_.size() );
+  EXPECT_EQ( 0u, countOpenEdges( mesh.faces_ ) );
+  EXPECT_LT( 0u, countOpenEdges( faces ) );
+
+  // The points that are kept keep their order and their normals
+  ASSERT_EQ( mesh.points_.size(), mesh.normals_.size() );
+  size_t j = 0;
+  for ( size_t i = 0; i < mesh.points_.size(); i++ )
+  {
+    while ( j < points.size() && points[ j ] != mesh.points_[ i ] ) j++;
+    ASSERT_LT( j, points.size() );
+    EXPECT_EQ( iso->get_normals()[ j ], mesh.normals_[ i ] );
+  }
+}
+
+TEST( IsosurfaceExporterTests, STLBinaryRoundTrip )
+{
+  IsosurfaceHandle iso = createCappedIsosurface();
+  const PointFVector& points = iso->get_points();
+  const UIntVector& faces = iso->get_faces();
+
+  boost::filesystem::path path = tempPath( ".stl" );
+  ASSERT_TRUE( iso->export_stl_binary_isosurface( path, "blob" ) );
+  std::ifstream file( path.string().c_str(), std::ios::binary );
+  std::vector< char > data( ( std::istreambuf_iterator< char >( file ) ), 
+    std::istreambuf_iterator< char >() );
+  file.close();
+  boost::filesystem::remove( path );
+
+  size_t num_faces = faces.size() / 3;
+  ASSERT_EQ( 84 + 50 * num_faces, data.size() );
+  unsigned int count;
+  std::memcpy( &count, &data[ 80 ], 4 );
+  ASSERT_EQ( num_faces, count );
+
+  Mesh mesh;
+  for ( size_t i = 0; i < num_faces; i++ )
+  {
+    float record[ 12 ];
+    std::memcpy( record, &data[ 84 + 50 * i ], sizeof( record ) );
+    const PointF& p1 = points[ faces[ 3 * i ] ];
+    const PointF& p2 = points[ faces[ 3 * i + 1 ] ];
+    VectorF normal = Cross( p2 - p1, points[ faces[ 3 * i + 2 ] ] - p1 );
+    EXPECT_EQ( normal, VectorF( record[ 0 ], record[ 1 ], record[ 2 ] ) );
+    for ( int k = 0; k < 3; k++ )
+    {
+      mesh.points_.push_back( PointF( record[ 3 + 3 * k ], record[ 4 + 3 * k ], 
+        record[ 5 + 3 * k ] ) );
+      mesh.faces_.push_back( static_cast< unsigned int >( 3 * i + k ) );
+    }
+  }
+  expectSameFaces( points, faces, mesh, 0.0f );
+}
+
+TEST( IsosurfaceExporterTests, ASCIIRoundTrip )
+{
+  IsosurfaceHandle iso = createCappedIsosurface();
+  const PointFVector& points = iso->get_points();
+  const UIntVector& faces = iso->get_faces();
+
+  // OBJ is welded as well and has six significant digits
+  boost::filesystem::path path = tempPath( ".obj" );
+  ASSERT_TRUE( iso->export_obj_isosurface( path ) );
+  Mesh mesh;
+  ASSERT_TRUE( readOBJ( path, mesh ) );
+  boost::filesystem::remove( path );
+  expectSameFaces( points, faces, mesh, 1e-5f );
+  EXPECT_EQ( 0u, countOpenEdges( mesh.faces_ ) );
+
+  // ASCII STL has a facet per face
+  path = tempPath( ".stl" );
+  ASSERT_TRUE( iso->export_stl_ascii_isosurface( path, "blob" ) );
+  std::ifstream file( path.string().c_str() );
+  std::string line;
+  std::getline( file, line );
+  EXPECT_EQ( "solid blob", line );
+  size_t num_facets = 0, num_vertices = 0;
+  std::string last;
+  Mesh stl;
+  while ( std::getline( file, line ) )
+  {
+    std::istringstream stream( line );
+    std::string word;
+    stream >> word;
+    if ( word == "facet" ) num_facets++;
+    if ( word == "vertex" )
+    {
+      float x, y, z;
+      stream >> x >> y >> z;
+      stl.points_.push_back( PointF( x, y, z ) );
+      stl.faces_.push_back( static_cast< unsigned int >( num_vertices++ ) );
+    }
+    last = line;
+  }
+  file.close();
+  boost::filesystem::remove( path );
+  EXPECT_EQ( faces.size() / 3, num_facets );
+  EXPECT_EQ( "endsolid", last );
+  expectSameFaces( points, faces, stl, 1e-5f );
+}
@@ -0,0 +1,214 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/Isosurface/Isosurface.h>
+#include <Core/Utils/ThreadPool.h>
+#include <Core/Volume/MaskVolume.h>
+
+using namespace Core;
+
+namespace
+{
+
+bool NoAbort()
+{
+  return false;
+}
+
+// A sphere that is cut by the x and y boundaries, a tube along z with a hollow core, and a 
+// few isolated voxels
+bool BoundaryShape( size_t x, size_t y, size_t z )
+{
+  double dx = x - 24.0, dy = y - 20.0, dz = z - 36.0;
+  double tube = ( x - 31.0 ) * ( x - 31.0 ) + ( y - 11.0 ) * ( y - 11.0 );
+  return ( dx * dx + dy * dy + dz * dz < 28.0 * 28.0 && dx * dx + dz * dz > 36.0 ) ||
+    ( tube < 40.0 && tube > 6.0 ) || ( x % 13 == 3 && y % 11 == 5 && z % 17 == 9 );
+}
+
+// A hollow ball that is cut by all six boundaries of a 120x100x90 volume, with a few isolated 
+// voxels
+bool CutBall( size_t x, size_t y, size_t z )
+{
+  double dx = x - 60.0, dy = y - 50.0, dz = z - 45.0;
+  double r2 = dx * dx + dy * dy + dz * dz;
+  return ( r2 < 64.0 * 64.0 && r2 > 40.0 * 40.0 ) || 
+    ( x % 7 == 3 && y % 9 == 4 && z % 5 == 2 );
+}
+
+typedef bool ( *shape_function_type )( size_t x, size_t y, size_t z );
+
+MaskVolumeHandle createMask( size_t nx, size_t ny, size_t nz, 
+  shape_function_type inside = &BoundaryShape )
+{
+  GridTransform grid_transform( nx, ny, nz );
+  MaskDataBlockHandle mask;
+  MaskDataBlockManager::Create( grid_transform, mask );
+  for ( size_t z = 0; z < nz; z++ )
+    for ( size_t y = 0; y < ny; y++ )
+      for ( size_t x = 0; x < nx; x++ )
+        if ( inside( x, y, z ) ) mask->set_mask_at( x, y, z );
+  // Only registered data blocks have a generation, which the incremental update relies on
+  MaskVolumeHandle volume( new MaskVolume( grid_transform, mask ) );
+  volume->register_data();
+  return volume;
+}
+
+// Set or clear a box of voxels in the axial slices z0 up to z1 and record the slices that
+// were modified
+void editSlices( const MaskVolumeHandle& volume, size_t z0, size_t z1, size_t x0, size_t x1, 
+  size_t y0, size_t y1, bool set )
+{
+  MaskDataBlockHandle mask = volume->get_mask_data_block();
+  MaskDataBlock::lock_type lock( mask->get_mutex() );
+  for ( size_t z = z0; z <= z1; z++ )
+  {
+    for ( size_t y = y0; y < y1; y++ )
+      for ( size_t x = x0; x < x1; x++ )
+      {
+        if ( set ) mask->set_mask_at( x, y, z );
+        else mask->clear_mask_at( x, y, z );
+      }
+    mask->increase_generation( SliceType::AXIAL_E, z );
+  }
+}
+
+template< class T >
+bool sameBytes( const std::vector< T >& a, const std::vector< T >& b )
+{
+  return a.size() == b.size() && 
+    ( a.empty() || std::memcmp( &a[ 0 ], &b[ 0 ], a.size() * sizeof( T ) ) == 0 );
+}
+
+void expectSameSurface( const Isosurface& result, const Isosurface& reference )
+{
+  ASSERT_LT( 0u, reference.get_faces().size() );
+  EXPECT_EQ( reference.get_points().size(), result.get_points().size() );
+  EXPECT_EQ( reference.get_faces().size(), result.get_faces().size() );
+  EXPECT_TRUE( sameBytes( result.get_points(), reference.get_points() ) );
+  EXPECT_TRUE( sameBytes( result.get_normals(), reference.get_normals() ) );
+  EXPECT_TRUE( sameBytes( result.get_faces(), reference.get_faces() ) );
+  EXPECT_EQ( reference.surface_area(), result.surface_area() );
+}
+
+}
+
+TEST( IsosurfaceTests, IncrementalMatchesFullRecompute )
+{
+  const double qualities[] = { 1.0, 0.5, 0.25 };
+  for ( size_t q = 0; q < 3; q++ )
+  {
+    for ( int capping = 0; capping < 2; capping++ )
+    {
+      SCOPED_TRACE( testing::Message() << "quality " << qualities[ q ] << 
+        ( capping ? " with caps" : " without caps" ) );
+
+      MaskVolumeHandle volume = createMask( 48, 40, 72 );
+      Isosurface incremental( volume );
+      incremental.compute( qualities[ q ], capping != 0, &NoAbort );
+
+      // Edits on the boundary, across the border of two slabs and in the middle of a slab
+      editSlices( volume, 0, 0, 2, 30, 3, 12, true );
+      incremental.compute( qualities[ q ], capping != 0, &NoAbort );
+      editSlices( volume, 15, 17, 10, 40, 5, 35, false );
+      editSlices( volume, 40, 40, 20, 22, 20, 22, true );
+      incremental.compute( qualities[ q ], capping != 0, &NoAbort );
+      editSlices( volume, 71, 71, 0, 48, 0, 40, true );
+      editSlices( volume, 33, 34, 0, 48, 0, 40, false );
+      incremental.compute( qualities[ q ], capping != 0, &NoAbort );
+
+      Isosurface full( volume );
+      full.compute( qualities[ q ], capping != 0, &NoAbort );
+      expectSameSurface( incremental, full );
+    }
+  }
+}
+
+TEST( IsosurfaceTests, UnchangedMaskKeepsValues )
+{
+  MaskVolumeHandle volume = createMask( 48, 40, 72 );
+  Isosurface isosurface( volume );
+  isosurface.compute( 1.0, true, &NoAbort );
+
+  FloatVector values( isosurface.get_points().size(), 1.0f );
+  ASSERT_TRUE( isosurface.set_values( values ) );
+  std::vector< double > fractions( 1, 0.5 );
+  ASSERT_TRUE( isosurface.compute_levels_of_detail( fractions, 0.0, &NoAbort ) );
+
+  // Nothing needs to be recomputed, hence the values and levels still belong to the surface
+  isosurface.compute( 1.0, true, &NoAbort );
+  EXPECT_EQ( isosurface.get_points().size(), isosurface.get_values().size() );
+  EXPECT_EQ( 2u, isosurface.get_num_levels_of_detail() );
+
+  // After an edit the values and levels are discarded
+  editSlices( volume, 20, 20, 10, 30, 10, 30, true );
+  isosurface.compute( 1.0, true, &NoAbort );
+  EXPECT_TRUE( isosurface.get_values().empty() );
+  EXPECT_EQ( 1u, isosurface.get_num_levels_of_detail() );
+}
+
+TEST( IsosurfaceTests, ParallelMatchesSerial )
+{
+  const size_t nx = 120, ny = 100, nz = 90;
+  MaskVolumeHandle volume = createMask( nx, ny, nz, &CutBall );
+
+  // The mask touches all six boundaries, so each of the caps has faces
+  MaskDataBlockHandle mask = volume->get_mask_data_block();
+  EXPECT_TRUE( mask->get_mask_at( 0, 50, 45 ) && mask->get_mask_at( nx - 1, 50, 45 ) );
+  EXPECT_TRUE( mask->get_mask_at( 60, 0, 45 ) && mask->get_mask_at( 60, ny - 1, 45 ) );
+  EXPECT_TRUE( mask->get_mask_at( 60, 50, 0 ) && mask->get_mask_at( 60, 50, nz - 1 ) );
+
+  const double qualities[] = { 1.0, 0.5 };
+  for ( size_t q = 0; q < 2; q++ )
+  {
+    SCOPED_TRACE( testing::Message() << "quality " << qualities[ q ] );
+
+    int concurrency = ThreadPool::Instance()->get_concurrency();
+    ThreadPool::Instance()->set_concurrency( 1 );
+    Isosurface serial( volume );
+    serial.compute( qualities[ q ], true, &NoAbort );
+    ThreadPool::Instance()->set_concurrency( std::max( concurrency, 4 ) );
+    Isosurface parallel( volume );
+    parallel.compute( qualities[ q ], true, &NoAbort );
+    ThreadPool::Instance()->set_concurrency( concurrency );
+
+    expectSameSurface( parallel, serial );
+
+    // The caps add to the surface
+    Isosurface uncapped( volume );
+    uncapped.compute( qualities[ q ], false, &NoAbort );
+    EXPECT_LT( uncapped.get_faces().size(), serial.get_faces().size() );
+  }
+}
@@ -0,0 +1,84 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/random.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/Isosurface/Isosurface.h>
+#include <Core/Volume/MaskVolume.h>
+
+using namespace Core;
+
+namespace
+{
+
+bool NoAbort()
+{
+  return false;
+}
+
+}
+
+TEST( MeshDecimatorBenchmarks, Throughput )
+{
+  // A noisy surface with many small features
+  const size_t size = 160;
+  GridTransform grid_transform( size, size, size );
+  MaskDataBlockHandle mask;
+  ASSERT_TRUE( MaskDataBlockManager::Create( grid_transform, mask ) );
+  boost::mt19937 rng( 5 );
+  boost::uniform_01<> dist;
+  for ( size_t z = 0; z < size; z++ )
+    for ( size_t y = 0; y < size; y++ )
+      for ( size_t x = 0; x < size; x++ )
+      {
+        double dx = x - 80.0, dy = y - 80.0, dz = z - 80.0;
+        if ( dx * dx + dy * dy + dz * dz < 70.0 * 70.0 * ( 0.9 + 0.1 * dist( rng ) ) )
+          mask->set_mask_at( x, y, z );
+      }
+  MaskVolumeHandle volume( new MaskVolume( grid_transform, mask ) );
+  IsosurfaceHandle iso( new Isosurface( volume ) );
+  iso->compute( 1.0, false, &NoAbort );
+
+  std::vector< double > fractions( 1, 0.1 );
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+  ASSERT_TRUE( iso->compute_levels_of_detail( fractions, 0.0, &NoAbort ) );
+  boost::posix_time::time_duration decimate_time = 
+    boost::posix_time::microsec_clock::local_time() - start;
+
+  EXPECT_LT( iso->get_faces( 1 ).size() * 5, iso->get_faces().size() );
+  std::cout << "Decimated " << iso->get_faces().size() / 3 << " to " << 
+    iso->get_faces( 1 ).size() / 3 << " faces in " << decimate_time.total_milliseconds() << 
+    " ms" << std::endl;
+}
@@ -0,0 +1,510 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/function.hpp>
+
+#include <Core/DataBlock/MaskDataBlockManager.h>
+#include <Core/Isosurface/Isosurface.h>
+#include <Core/Isosurface/MeshDecimator.h>
+#include <Core/Utils/StringUtil.h>
+#include <Core/Volume/MaskVolume.h>
+
+using namespace Core;
+
+namespace
+{
+
+typedef boost::function< bool ( double, double, double ) > shape_function_type;
+
+bool NoAbort()
+{
+  return false;
+}
+
+// Create a mask volume of the voxels that are inside the shape
+MaskVolumeHandle createMask( size_t nx, size_t ny, size_t nz, shape_function_type inside )
+{
+  GridTransform grid_transform( nx, ny, nz );
+  MaskDataBlockHandle mask;
+  MaskDataBlockManager::Create( grid_transform, mask );
+  for ( size_t z = 0; z < nz; z++ )
+    for ( size_t y = 0; y < ny; y++ )
+      for ( size_t x = 0; x < nx; x++ )
+        if ( inside( x, y, z ) ) mask->set_mask_at( x, y, z );
+  return MaskVolumeHandle( new MaskVolume( grid_transform, mask ) );
+}
+
+bool SphereAndTorus( double x, double y, double z )
+{
+  double sphere = ( x - 12 ) * ( x - 12 ) + ( y - 24 ) * ( y - 24 ) + ( z - 24 ) * ( z - 24 );
+  double ring = std::sqrt( ( x - 36 ) * ( x - 36 ) + ( y - 24 ) * ( y - 24 ) ) - 8.0;
+  return sphere < 81.0 || ring * ring + ( z - 24 ) * ( z - 24 ) < 12.0;
+}
+
+bool LargeSphereAndTorus( double x, double y, double z )
+{
+  return SphereAndTorus( x / 2.0, y / 2.0, z / 2.0 );
+}
+
+bool Box( double x, double y, double z )
+{
+  return x >= 5 && x < 25 && y >= 6 && y < 22 && z >= 4 && z < 16;
+}
+
+bool CornerBlob( double x, double y, double z )
+{
+  return x * x + y * y * 1.5 + z * z < 30.0 * 30.0;
+}
+
+// Topological statistics of the part of a mesh that is used by its faces
+class MeshInfo
+{
+public:
+  MeshInfo( const PointFVector& points, const UIntVector& faces ) :
+    num_faces_( faces.size() / 3 ),
+    num_boundary_edges_( 0 ),
+    num_non_manifold_edges_( 0 ),
+    num_degenerate_faces_( 0 )
+  {
+    std::map< std::pair< unsigned int, unsigned int >, int > edges;
+    std::set< unsigned int > vertices;
+    std::vector< unsigned int > component( points.size() );
+    for ( size_t i = 0; i < component.size(); i++ )
+    {
+      component[ i ] = static_cast< unsigned int >( i );
+    }
+
+    for ( size_t f = 0; f < this->num_faces_; f++ )
+    {
+      const unsigned int* face = &faces[ 3 * f ];
+      if ( face[ 0 ] == face[ 1 ] || face[ 1 ] == face[ 2 ] || face[ 0 ] == face[ 2 ] ||
+        Cross( points[ face[ 1 ] ] - points[ face[ 0 ] ], 
+        points[ face[ 2 ] ] - points[ face[ 0 ] ] ).length() == 0.0f )
+      {
+        this->num_degenerate_faces_++;
+      }
+      for ( int k = 0; k < 3; k++ )
+      {
+        unsigned int a = face[ k ], b = face[ ( k + 1 ) % 3 ];
+        edges[ std::make_pair( std::min( a, b ), std::max( a, b ) ) ]++;
+        vertices.insert( a );
+        unsigned int ra = find( component, a ), rb = find( component, b );
+        component[ ra ] = rb;
+      }
+    }
+
+    std::set< unsigned int > roots;
+    for ( std::set< unsigned int >::iterator it = vertices.begin(); it != vertices.end(); ++it )
+    {
+      roots.insert( find( component, *it ) );
+    }
+    for ( std::map< std::pair< unsigned int, unsigned int >, int >::iterator it = edges.begin();
+      it != edges.end(); ++it )
+    {
+      if ( it->second == 1 ) this->num_boundary_edges_++;
+      if ( it->second > 2 ) this->num_non_manifold_edges_++;
+    }
+
+    this->num_components_ = roots.size();
+    this->euler_characteristic_ = static_cast< long >( vertices.size() ) - 
+      static_cast< long >( edges.size() ) + static_cast< long >( this->num_faces_ );
+  }
+
+  size_t num_faces_;
+  size_t num_components_;
+  size_t num_boundary_edges_;
+  size_t num_non_manifold_edges_;
+  size_t num_degenerate_faces_;
+  long euler_characteristic_;
+
+private:
+  static unsigned int find( std::vector< unsigned int >& component, unsigned int v )
+  {
+    while ( component[ v ] != v ) v = component[ v ] = component[ component[ v ] ];
+    return v;
+  }
+};
+
+// Distance from a point to a triangle
+double pointTriangleDistance( const PointF& p, const PointF& a, const PointF& b, 
+  const PointF& c )
+{
+  VectorF ab = b - a, ac = c - a, ap = p - a;
+  double d1 = Dot( ab, ap ), d2 = Dot( ac, ap );
+  if ( d1 <= 0 && d2 <= 0 ) return ( p - a ).length();
+  VectorF bp = p - b;
+  double d3 = Dot( ab, bp ), d4 = Dot( ac, bp );
+  if ( d3 >= 0 && d4 <= d3 ) return ( p - b ).length();
+  double vc = d1 * d4 - d3 * d2;
+  if ( vc <= 0 && d1 >= 0 && d3 <= 0 )
+  {
+    return ( p - ( a + ab * float( d1 / ( d1 - d3 ) ) ) ).length();
+  }
+  VectorF cp = p - c;
+  double d5 = Dot( ab, cp ), d6 = Dot( ac, cp );
+  if ( d6 >= 0 && d5 <= d6 ) return ( p - c ).length();
+  double vb = d5 * d2 - d1 * d6;
+  if ( vb <= 0 && d2 >= 0 && d6 <= 0 )
+  {
+    return ( p - ( a + ac * float( d2 / ( d2 - d6 ) ) ) ).length();
+  }
+  double va = d3 * d6 - d5 * d4;
+  if ( va <= 0 && ( d4 - d3 ) >= 0 && ( d5 - d6 ) >= 0 )
+  {
+    double t = ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) );
+    return ( p - ( b + ( c - b ) * float( t ) ) ).length();
+  }
+  double denom = 1.0 / ( va + vb + vc );
+  return ( p - ( a + ab * float( vb * denom ) + ac * float( vc * denom ) ) ).length();
+}
+
+// Largest distance from the used points of one mesh to the surface of the other. The faces of
+// the surface are sorted into a grid, so only the faces near a point need to be checked.
+double oneSidedDistance( const PointFVector& points, const UIntVector& faces, 
+  const PointFVector& surface_points, const UIntVector& surface_faces )
+{
+  const float cell_size = 2.0f;
+  const int search_cells = 2;
+  PointF min_point = surface_points[ surface_faces[ 0 ] ];
+  PointF max_point = min_point;
+  for ( size_t i = 0; i < surface_faces.size(); i++ )
+  {
+    min_point = Min( min_point, surface_points[ surface_faces[ i ] ] );
+    max_point = Max( max_point, surface_points[ surface_faces[ i ] ] );
+  }
+  int n[ 3 ];
+  for ( int k = 0; k < 3; k++ )
+  {
+    n[ k ] = static_cast< int >( ( max_point[ k ] - min_point[ k ] ) / cell_size ) + 1;
+  }
+  std::vector< std::vector< size_t > > cells( n[ 0 ] * n[ 1 ] * n[ 2 ] );
+  for ( size_t i = 0; i < surface_faces.size(); i += 3 )
+  {
+    int lo[ 3 ], hi[ 3 ];
+    for ( int k = 0; k < 3; k++ )
+    {
+      float a = surface_points[ surface_faces[ i ] ][ k ];
+      float b = surface_points[ surface_faces[ i + 1 ] ][ k ];
+      float c = surface_points[ surface_faces[ i + 2 ] ][ k ];
+      lo[ k ] = static_cast< int >( ( std::min( a, std::min( b, c ) ) - min_point[ k ] ) / 
+        cell_size );
+      hi[ k ] = static_cast< int >( ( std::max( a, std::max( b, c ) ) - min_point[ k ] ) / 
+        cell_size );
+    }
+    for ( int z = lo[ 2 ]; z <= hi[ 2 ]; z++ )
+      for ( int y = lo[ 1 ]; y <= hi[ 1 ]; y++ )
+        for ( int x = lo[ 0 ]; x <= hi[ 0 ]; x++ )
+          cells[ ( z * n[ 1 ] + y ) * n[ 0 ] + x ].push_back( i );
+  }
+
+  std::vector< char > used( points.size(), 0 );
+  for ( size_t i = 0; i < faces.size(); i++ ) used[ faces[ i ] ] = 1;
+  double max_distance = 0.0;
+  for ( size_t v = 0; v < points.size(); v++ )
+  {
+    if ( !used[ v ] ) continue;
+    const PointF& p = points[ v ];
+    int lo[ 3 ], hi[ 3 ];
+    for ( int k = 0; k < 3; k++ )
+    {
+      int c = static_cast< int >( std::floor( ( p[ k ] - min_point[ k ] ) / cell_size ) );
+      lo[ k ] = std::max( 0, c - search_cells );
+      hi[ k ] = std::min( n[ k ] - 1, c + search_cells );
+    }
+
+    double distance = -1.0;
+    for ( int z = lo[ 2 ]; z <= hi[ 2 ]; z++ )
+      for ( int y = lo[ 1 ]; y <= hi[ 1 ]; y++ )
+        for ( int x = lo[ 0 ]; x <= hi[ 0 ]; x++ )
+        {
+          const std::vector< size_t >& cell = cells[ ( z * n[ 1 ] + y ) * n[ 0 ] + x ];
+          for ( size_t j = 0; j < cell.size(); j++ )
+          {
+            size_t i = cell[ j ];
+            double d = pointTriangleDistance( p, surface_points[ surface_faces[ i ] ], 
+              surface_points[ surface_faces[ i + 1 ] ], surface_points[ surface_faces[ i + 2 ] ] );
+            if ( distance < 0.0 || d < distance ) distance = d;
+          }
+        }
+
+    // The search only finds the faces within search_cells * cell_size of the point
+    if ( distance < 0.0 || distance > search_cells * cell_size )
+    {
+      for ( size_t i = 0; i < surface_faces.size(); i += 3 )
+      {
+        double d = pointTriangleDistance( p, surface_points[ surface_faces[ i ] ], 
+          surface_points[ surface_faces[ i + 1 ] ], surface_points[ surface_faces[ i + 2 ] ] );
+        if ( distance < 0.0 || d < distance ) distance = d;
+      }
+    }
+    max_distance = std::max( max_distance, distance );
+  }
+  return max_distance;
+}
+
+// Vertex sampled symmetric Hausdorff distance between two meshes
+double hausdorffDistance( const PointFVector& points1, const UIntVector& faces1, 
+  const PointFVector& points2, const UIntVector& faces2 )
+{
+  return std::max( oneSidedDistance( points1, faces1, points2, faces2 ), 
+    oneSidedDistance( points2, faces2, points1, faces1 ) );
+}
+
+// Split the faces into a number of partitions of about the same size
+MeshDecimator::range_vector_type splitFaces( size_t num_face_indices, size_t num_parts )
+{
+  MeshDecimator::range_vector_type parts;
+  size_t num_faces = num_face_indices / 3;
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    parts.push_back( std::make_pair( 
+      static_cast< unsigned int >( 3 * ( num_faces * j / num_parts ) ),
+      static_cast< unsigned int >( 3 * ( num_faces * ( j + 1 ) / num_parts ) ) ) );
+  }
+  return parts;
+}
+
+// The boundary edges of a mesh by the coordinates of their end points
+std::set< std::vector< float > > boundaryEdges( const PointFVector& points, 
+  const UIntVector& faces )
+{
+  std::map< std::pair< unsigned int, unsigned int >, int > edges;
+  for ( size_t i = 0; i < faces.size(); i += 3 )
+  {
+    for ( int k = 0; k < 3; k++ )
+    {
+      unsigned int a = faces[ i + k ], b = faces[ i + ( k + 1 ) % 3 ];
+      edges[ std::make_pair( std::min( a, b ), std::max( a, b ) ) ]++;
+    }
+  }
+
+  std::set< std::vector< float > > boundary;
+  for ( std::map< std::pair< unsigned int, unsigned int >, int >::iterator it = edges.begin();
+    it != edges.end(); ++it )
+  {
+    if ( it->second != 1 ) continue;
+    const PointF& a = points[ it->first.first ];
+    const PointF& b = points[ it->first.second ];
+    float coords[ 6 ] = { a.x(), a.y(), a.z(), b.x(), b.y(), b.z() };
+    std::vector< float > edge( coords, coords + 6 );
+    // Order the end points, they may be numbered differently
+    if ( std::lexicographical_compare( edge.begin() + 3, edge.end(), edge.begin(), 
+      edge.begin() + 3 ) )
+    {
+      std::rotate( edge.begin(), edge.begin() + 3, edge.end() );
+    }
+    boundary.insert( edge );
+  }
+  return boundary;
+}
+
+// Check that the decimated mesh is a closed manifold with the topology of the original
+void checkDecimation( const MeshInfo& original, const MeshDecimator& decimator )
+{
+  MeshInfo result( decimator.get_points(), decimator.get_faces() );
+  EXPECT_LT( result.num_faces_, original.num_faces_ );
+  EXPECT_EQ( original.num_components_, result.num_components_ );
+  EXPECT_EQ( original.euler_characteristic_, result.euler_characteristic_ );
+  EXPECT_EQ( 0u, result.num_boundary_edges_ );
+  EXPECT_EQ( 0u, result.num_non_manifold_edges_ );
+  EXPECT_EQ( 0u, result.num_degenerate_faces_ );
+  EXPECT_EQ( decimator.get_points().size(), decimator.get_normals().size() );
+}
+
+} // end anonymous namespace
+
+TEST( MeshDecimatorTests, PreservesTopology )
+{
+  MaskVolumeHandle volume = createMask( 50, 48, 48, &SphereAndTorus );
+  IsosurfaceHandle iso( new Isosurface( volume ) );
+  iso->compute( 1.0, false, &NoAbort );
+  const PointFVector& points = iso->get_points();
+  const UIntVector& faces = iso->get_faces();
+  MeshInfo original( points, faces );
+  ASSERT_EQ( 2u, original.num_components_ );
+  ASSERT_EQ( 0u, original.num_boundary_edges_ );
+
+  const double fractions[] = { 0.5, 0.2, 0.05 };
+  for ( int k = 0; k < 3; k++ )
+  {
+    SCOPED_TRACE( "fraction " + ExportToString( fractions[ k ] ) );
+    size_t target = static_cast< size_t >( fractions[ k ] * original.num_faces_ );
+    MeshDecimator decimator( points, faces );
+    ASSERT_TRUE( decimator.decimate( target, 0.0 ) );
+    checkDecimation( original, decimator );
+
+    size_t num_faces = decimator.get_faces().size() / 3;
+    double hausdorff = hausdorffDistance( points, faces, decimator.get_points(), 
+      decimator.get_faces() );
+
+    EXPECT_LE( num_faces, target + 2 );
+    EXPECT_LT( hausdorff, 1.5 );
+    EXPECT_NEAR( decimator.get_area(), iso->surface_area(), 0.1 * iso->surface_area() );
+  }
+}
+
+TEST( MeshDecimatorTests, Partitions )
+{
+  // The seams between the partitions are reduced in a second pass, and whatever is left above
+  // the target in a final pass over the whole mesh, hence the target is met as without partitions
+  MaskVolumeHandle volume = createMask( 100, 96, 96, &LargeSphereAndTorus );
+  IsosurfaceHandle iso( new Isosurface( volume ) );
+  iso->compute( 1.0, false, &NoAbort );
+  const PointFVector& points = iso->get_points();
+  const UIntVector& faces = iso->get_faces();
+  MeshInfo original( points, faces );
+  ASSERT_EQ( 2u, original.num_components_ );
+
+  const size_t num_parts = 4;
+  size_t target = original.num_faces_ / 10;
+  MeshDecimator decimator( points, faces );
+  decimator.set_partitions( splitFaces( faces.size(), num_parts ) );
+  ASSERT_TRUE( decimator.decimate( target, 0.0 ) );
+  checkDecimation( original, decimator );
+
+  // The partitions are stored one after another
+  const MeshDecimator::range_vector_type& part_faces = decimator.get_part_faces();
+  ASSERT_EQ( num_parts, part_faces.size() );
+  EXPECT_EQ( 0u, part_faces.front().first );
+  for ( size_t j = 1; j < num_parts; j++ )
+  {
+    EXPECT_EQ( part_faces[ j - 1 ].second, part_faces[ j ].first );
+  }
+  EXPECT_EQ( decimator.get_faces().size(), part_faces.back().second );
+
+  // The point range of each partition covers its faces
+  const MeshDecimator::range_vector_type& part_points = decimator.get_part_points();
+  ASSERT_EQ( num_parts, part_points.size() );
+  for ( size_t j = 0; j < num_parts; j++ )
+  {
+    for ( size_t i = part_faces[ j ].first; i < part_faces[ j ].second; i++ )
+    {
+      ASSERT_LE( part_points[ j ].first, decimator.get_faces()[ i ] );
+      ASSERT_GT( part_points[ j ].second, decimator.get_faces()[ i ] );
+    }
+  }
+
+  size_t num_faces = decimator.get_faces().size() / 3;
+  double hausdorff = hausdorffDistance( points, faces, decimator.get_points(), 
+    decimator.get_faces() );
+
+  EXPECT_LE( num_faces, target + 2 );
+  EXPECT_LT( hausdorff, 1.5 );
+}
+
+TEST( MeshDecimatorTests, ErrorBound )
+{
+  // The flat sides of a box can be collapsed without error
+  MaskVolumeHandle volume = createMask( 32, 32, 32, &Box );
+  IsosurfaceHandle iso( new Isosurface( volume ) );
+  iso->compute( 1.0, false, &NoAbort );
+  const PointFVector& points = iso->get_points();
+  const UIntVector& faces = iso->get_faces();
+  MeshInfo original( points, faces );
+
+  MeshDecimator decimator( points, faces );
+  ASSERT_TRUE( decimator.decimate( 0, 1e-3 ) );
+  MeshInfo result( decimator.get_points(), decimator.get_faces() );
+  double hausdorff = hausdorffDistance( points, faces, decimator.get_points(), 
+    decimator.get_faces() );
+
+  EXPECT_LE( decimator.get_max_error(), 1e-3 );
+  EXPECT_LT( result.num_faces_ * 5, original.num_faces_ );
+  EXPECT_LT( hausdorff, 1e-2 );
+  EXPECT_EQ( original.euler_characteristic_, result.euler_characteristic_ );
+  EXPECT_EQ( 0u, result.num_boundary_edges_ );
+}
+
+TEST( MeshDecimatorTests, IsosurfaceLevelsOfDetail )
+{
+  MaskVolumeHandle volume = createMask( 40, 36, 44, &CornerBlob );
+  IsosurfaceHandle iso( new Isosurface( volume ) );
+  iso->compute( 1.0, true, &NoAbort );
+  EXPECT_EQ( 1u, iso->get_num_levels_of_detail() );
+
+  std::vector< double > fractions;
+  fractions.push_back( 0.5 );
+  fractions.push_back( 0.2 );
+  ASSERT_TRUE( iso->compute_levels_of_detail( fractions, 0.0, &NoAbort ) );
+  ASSERT_EQ( 3u, iso->get_num_levels_of_detail() );
+
+  // The rims of the surface and of the caps stay in place, so they still meet
+  std::set< std::vector< float > > rim = boundaryEdges( iso->get_points(), iso->get_faces() );
+  EXPECT_FALSE( rim.empty() );
+  for ( size_t level = 1; level < 3; level++ )
+  {
+    SCOPED_TRACE( "level " + ExportToString( level ) );
+    MeshInfo info( iso->get_points( level ), iso->get_faces( level ) );
+    MeshInfo prev_info( iso->get_points( level - 1 ), iso->get_faces( level - 1 ) );
+    EXPECT_LT( info.num_faces_, prev_info.num_faces_ );
+    EXPECT_EQ( prev_info.euler_characteristic_, info.euler_characteristic_ );
+    EXPECT_EQ( 0u, info.num_degenerate_faces_ );
+    EXPECT_EQ( iso->get_points( level ).size(), iso->get_normals( level ).size() );
+    EXPECT_GE( iso->get_level_of_detail_error( level ), 
+      iso->get_level_of_detail_error( level - 1 ) );
+    EXPECT_TRUE( rim == boundaryEdges( iso->get_points( level ), iso->get_faces( level ) ) );
+    EXPECT_NEAR( iso->surface_area( level ), iso->surface_area(), 0.05 * iso->surface_area() );
+
+    double hausdorff = hausdorffDistance( iso->get_points(), iso->get_faces(), 
+      iso->get_points( level ), iso->get_faces( level ) );
+    EXPECT_LT( hausdorff, 1.5 );
+  }
+
+  // Levels that were not computed fall back to the full resolution mesh
+  EXPECT_EQ( &iso->get_faces(), &iso->get_faces( 3 ) );
+
+  // The export functions write the selected level
+  boost::filesystem::path path = boost::filesystem::temp_directory_path() /
+    boost::filesystem::unique_path( "seg3d-lod-%%%%-%%%%.obj" );
+  ASSERT_TRUE( iso->export_obj_isosurface( path, 2 ) );
+  std::ifstream obj_file( path.string().c_str() );
+  std::string line;
+  size_t num_faces = 0;
+  while ( std::getline( obj_file, line ) )
+  {
+    if ( line.compare( 0, 2, "f " ) == 0 ) num_faces++;
+  }
+  obj_file.close();
+  boost::filesystem::remove( path );
+  EXPECT_EQ( iso->get_faces( 2 ).size() / 3, num_faces );
+
+  // A new computation discards the levels
+  iso->compute( 1.0, true, &NoAbort );
+  EXPECT_EQ( 1u, iso->get_num_levels_of_detail() );
+}
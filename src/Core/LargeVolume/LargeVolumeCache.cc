@@ -27,12 +27,16 @@
  */
 
 #include <list>
-#include <queue>
+#include <set>
 
+#include <boost/thread.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
 #include <Core/Application/Application.h>
 #include <Core/Utils/ConnectionHandler.h>
+#include <Core/Utils/Log.h>
+#include <Core/Math/MathFunctions.h>
 #include <Core/DataBlock/DataBlock.h>
 #include <Core/LargeVolume/LargeVolumeCache.h>
 
@@ -40,7 +44,7 @@ namespace Core
 {
 CORE_SINGLETON_IMPLEMENTATION( LargeVolumeCache );
 
-class LargeVolumeCachePrivate : ConnectionHandler, Lockable, public EventHandler
+class LargeVolumeCachePrivate : ConnectionHandler, Lockable
 {
   typedef std::list<std::string> cache_access_list_type;
 
@@ -52,16 +56,43 @@ class LargeVolumeCachePrivate : ConnectionHandler, Lockable, public EventHandler
 
   struct LoadJob
   {
-    LoadJob( LargeVolumeSchemaHandle schema, BrickInfo bi ) :
-      schema_( schema ), bi_( bi )
+    LoadJob( LargeVolumeSchemaHandle schema, BrickInfo bi, long long sequence ) :
+      schema_( schema ), bi_( bi ), sequence_( sequence )
     {
     };
 
     LargeVolumeSchemaHandle schema_;
     BrickInfo bi_;
+
+    // Order in which the brick was requested
+    long long sequence_;
+
+    // The viewers that still want this brick
+    std::set<std::string> load_keys_;
+  };
+
+  // Priority of a queued job: coarse levels are loaded first, so a low resolution image can be
+  // shown quickly, then bricks are loaded in the order they were requested.
+  struct LoadPriority
+  {
+    LoadPriority( BrickInfo::index_type level, long long sequence, const std::string& brick_name ) :
+      level_( level ), sequence_( sequence ), brick_name_( brick_name )
+    {
+    }
+
+    bool operator<( const LoadPriority& rhs ) const
+    {
+      if ( this->level_ != rhs.level_ ) return this->level_ > rhs.level_;
+      return this->sequence_ < rhs.sequence_;
+    }
+
+    BrickInfo::index_type level_;
+    long long sequence_;
+    std::string brick_name_;
   };
 
   typedef boost::unordered_map<std::string, CacheEntry> cache_map_type;
+  typedef boost::unordered_map<std::string, LoadJob> job_map_type;
 
 public:
   long long cache_capacity_;
@@ -71,9 +102,22 @@ public:
 
   LargeVolumeCache* instance_;
 
-  boost::unordered_map<std::string,std::queue<LoadJob> > jobs_;
+  // Jobs that are waiting to be loaded, indexed by brick name and ordered by priority
+  boost::mutex job_mutex_;
+  boost::condition_variable job_condition_;
+  job_map_type jobs_;
+  std::set<LoadPriority> job_queue_;
+  long long job_sequence_;
+
+  // Bricks that are currently being read by one of the loader threads
+  boost::unordered_set<std::string> jobs_in_flight_;
+
+  boost::thread_group loader_threads_;
+  bool shutdown_;
 
-  LargeVolumeCachePrivate()
+  LargeVolumeCachePrivate() :
+    job_sequence_( 0 ),
+    shutdown_( false )
   {
     if (sizeof( void * ) == 4)
     {
@@ -107,10 +151,36 @@ public:
     this->disconnect_all();
   }
 
+  void start_loader_threads()
+  {
+    // Reading and decompressing bricks is done by multiple threads, at least two so reading
+    // from disk and decompressing overlap.
+    int num_threads = Clamp( static_cast<int>( boost::thread::hardware_concurrency() ), 
+      LOADER_THREADS_MIN_C, LOADER_THREADS_MAX_C );
+
+    for (int j = 0; j < num_threads; j++)
+    {
+      this->loader_threads_.create_thread( boost::bind( &LargeVolumeCachePrivate::run_loader, this ) );
+    }
+  }
+
+  void stop_loader_threads()
+  {
+    {
+      boost::mutex::scoped_lock lock( this->job_mutex_ );
+      this->shutdown_ = true;
+    }
+    this->job_condition_.notify_all();
+    this->loader_threads_.join_all();
+  }
+
   void add_entry(const std::string& brick_name, DataBlockHandle data_block)
   {
     lock_type lock( this->get_mutex() );
 
+    // Another thread may have added it in the mean time
+    if (this->cache_map_.find( brick_name ) != this->cache_map_.end()) return;
+
     this->cache_access_list_.push_front( brick_name );
     this->cache_size_ += data_block->get_byte_size();
 
@@ -150,6 +220,12 @@ public:
     return true;
   }
 
+  bool has_entry( const std::string& brick_name )
+  {
+    lock_type lock( this->get_mutex() );
+    return this->cache_map_.find( brick_name ) != this->cache_map_.end();
+  }
+
   void clear_cache()
   {
     lock_type lock( this->get_mutex() );
@@ -159,52 +235,118 @@ public:
     this->cache_size_ = 0;
   }
 
-  void load_brick( LargeVolumeSchemaHandle schema, BrickInfo bi, std::string load_key )
+  void load_brick( LargeVolumeSchemaHandle schema, const BrickInfo& bi, 
+    const std::string& brick_name, const std::string& load_key )
   {
-    this->jobs_[ load_key ].push( LoadJob( schema, bi ) );
+    boost::mutex::scoped_lock lock( this->job_mutex_ );
 
-    this->post_event( boost::bind( &LargeVolumeCachePrivate::process_load_job, this, load_key ) );
+    // Do not load the same brick twice
+    if (this->jobs_in_flight_.find( brick_name ) != this->jobs_in_flight_.end()) return;
+
+    job_map_type::iterator it = this->jobs_.find( brick_name );
+    if (it == this->jobs_.end())
+    {
+      it = this->jobs_.insert( std::make_pair( brick_name, 
+        LoadJob( schema, bi, this->job_sequence_++ ) ) ).first;
+      this->job_queue_.insert( LoadPriority( bi.level_, it->second.sequence_, brick_name ) );
+      this->job_condition_.notify_one();
+    }
+    it->second.load_keys_.insert( load_key );
   }
 
-  void process_load_job( std::string load_key )
+  void run_loader()
   {
-    if (! this->jobs_[ load_key ].empty() )
+    for (;;)
     {
-      LoadJob lj = this->jobs_[ load_key ].front();
-      this->jobs_[ load_key ].pop();
+      LargeVolumeSchemaHandle schema;
+      BrickInfo bi( 0, 0 );
+      std::string brick_name;
 
-      std::string brick_name = lj.schema_->get_brick_file_name( lj.bi_ ).string();
-      DataBlockHandle data_block;
-      if (! this->get_entry( brick_name, data_block )) 
       {
+        boost::mutex::scoped_lock lock( this->job_mutex_ );
+        while (this->job_queue_.empty() && !this->shutdown_)
+        {
+          this->job_condition_.wait( lock );
+        }
+        if (this->shutdown_) return;
+
+        brick_name = this->job_queue_.begin()->brick_name_;
+        this->job_queue_.erase( this->job_queue_.begin() );
+
+        job_map_type::iterator it = this->jobs_.find( brick_name );
+        schema = it->second.schema_;
+        bi = it->second.bi_;
+        this->jobs_.erase( it );
+        this->jobs_in_flight_.insert( brick_name );
+      }
+
+      bool loaded = false;
+      if (!this->has_entry( brick_name ))
+      {
+        DataBlockHandle data_block;
         std::string error;
-        lj.schema_->read_brick( data_block, lj.bi_, error );
-        this->add_entry( brick_name, data_block );
-        this->instance_->brick_loaded_signal_();
+        if (!schema->read_brick( data_block, bi, error ))
+        {
+          CORE_LOG_ERROR( error );
+          // NOTE: Cache an empty brick, so the brick is not requested over and over again
+          if (data_block) data_block->clear();
+        }
+
+        if (data_block)
+        {
+          this->add_entry( brick_name, data_block );
+          loaded = true;
+        }
       }
-    }
 
-    if (! this->jobs_[ load_key ].empty() )
-    {
-      this->post_event( boost::bind( &LargeVolumeCachePrivate::process_load_job, this, load_key ) );  
+      {
+        boost::mutex::scoped_lock lock( this->job_mutex_ );
+        this->jobs_in_flight_.erase( brick_name );
+      }
+
+      if (loaded) this->instance_->brick_loaded_signal_();
     }
   }
 
-  void clear_load_queue( std::string load_key )
+  void clear_load_queue( const std::string& load_key )
   {
-    this->jobs_[ load_key ] = std::queue<LoadJob>();
+    boost::mutex::scoped_lock lock( this->job_mutex_ );
+
+    // Drop the jobs that were only requested for this load key, bricks that are currently being
+    // read are not interrupted.
+    job_map_type::iterator it = this->jobs_.begin();
+    while (it != this->jobs_.end())
+    {
+      it->second.load_keys_.erase( load_key );
+      if (it->second.load_keys_.empty())
+      {
+        this->job_queue_.erase( LoadPriority( it->second.bi_.level_, it->second.sequence_, it->first ) );
+        it = this->jobs_.erase( it );
+      }
+      else
+      {
+        ++it;
+      }
+    }
   }
+
+  // Bounds on the number of threads that read bricks
+  static const int LOADER_THREADS_MIN_C;
+  static const int LOADER_THREADS_MAX_C;
 };
 
+const int LargeVolumeCachePrivate::LOADER_THREADS_MIN_C = 2;
+const int LargeVolumeCachePrivate::LOADER_THREADS_MAX_C = 8;
+
 LargeVolumeCache::LargeVolumeCache() : private_( new LargeVolumeCachePrivate )
 {
   this->private_->instance_ = this;
-  this->private_->start_eventhandler();
+  this->private_->start_loader_threads();
 }
 
 LargeVolumeCache::~LargeVolumeCache()
 {
-
+  this->private_->stop_loader_threads();
 }
 
 bool LargeVolumeCache::mark_brick( LargeVolumeSchemaHandle schema, const BrickInfo& bi )
@@ -225,7 +367,7 @@ bool LargeVolumeCache::get_brick( LargeVolumeSchemaHandle schema, const BrickInf
     return true;
   }
 
-  this->private_->post_event( boost::bind( &LargeVolumeCachePrivate::load_brick, this->private_, schema, bi, load_key ) );
+  this->private_->load_brick( schema, bi, brick_name, load_key );
 
   return false;
 }
@@ -238,7 +380,7 @@ void LargeVolumeCache::load_brick( LargeVolumeSchemaHandle schema, const BrickIn
 
 void LargeVolumeCache::clear_load_queue( const std::string& load_key )
 {
-  this->private_->post_event( boost::bind( &LargeVolumeCachePrivate::clear_load_queue, this->private_, load_key ) );
+  this->private_->clear_load_queue( load_key );
 }
 
 } // end namespace
@@ -0,0 +1,546 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+// Boost includes
+#include <boost/thread/mutex.hpp>
+
+// Zlib includes
+#include <zlib.h>
+
+#ifdef BUILD_WITH_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef BUILD_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+// Core includes
+#include <Core/Utils/StringUtil.h>
+#include <Core/LargeVolume/LargeVolumeCodec.h>
+
+namespace Core
+{
+
+#ifdef Z_PREFIX
+  #define zlib_uLong z_uLong
+  #define zlib_uLongf z_uLongf
+  #define zlib_uInt z_uInt
+  #define zlib_Bytef z_Bytef
+  #define zlib_uncompress z_uncompress
+  #define zlib_compress2 z_compress2
+  #define zlib_compressBound z_compressBound
+  #define zlib_adler32 z_adler32
+#else
+  #define zlib_uLong uLong
+  #define zlib_uLongf uLongf
+  #define zlib_uInt uInt
+  #define zlib_Bytef Bytef
+  #define zlib_uncompress uncompress
+  #define zlib_compress2 compress2
+  #define zlib_compressBound compressBound
+  #define zlib_adler32 adler32
+#endif
+
+bool ImportFromString( const std::string& filter_string, LargeVolumeFilter& filter )
+{
+  if ( filter_string == "none" ) filter = LargeVolumeFilter::NONE_E;
+  else if ( filter_string == "shuffle" ) filter = LargeVolumeFilter::SHUFFLE_E;
+  else if ( filter_string == "delta" ) filter = LargeVolumeFilter::DELTA_E;
+  else return false;
+
+  return true;
+}
+
+std::string ExportToString( LargeVolumeFilter filter )
+{
+  switch ( filter )
+  {
+    case LargeVolumeFilter::SHUFFLE_E: return "shuffle";
+    case LargeVolumeFilter::DELTA_E: return "delta";
+    default: return "none";
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Codecs
+//////////////////////////////////////////////////////////////////////////
+
+class LargeVolumeRawCodec : public LargeVolumeCodec
+{
+public:
+  virtual std::string get_name() const { return "none"; }
+  virtual unsigned char get_id() const { return 0; }
+
+  virtual bool compress( const char* src, size_t src_size, std::vector<char>& dst ) const
+  {
+    dst.assign( src, src + src_size );
+    return true;
+  }
+
+  virtual bool decompress( const char* src, size_t src_size, char* dst, size_t dst_size ) const
+  {
+    if ( src_size != dst_size ) return false;
+    std::memcpy( dst, src, dst_size );
+    return true;
+  }
+};
+
+class LargeVolumeZlibCodec : public LargeVolumeCodec
+{
+public:
+  LargeVolumeZlibCodec( const std::string& name, unsigned char id, int level ) :
+    name_( name ), id_( id ), level_( level )
+  {
+  }
+
+  virtual std::string get_name() const { return this->name_; }
+  virtual unsigned char get_id() const { return this->id_; }
+
+  virtual bool compress( const char* src, size_t src_size, std::vector<char>& dst ) const
+  {
+    zlib_uLongf dst_size = zlib_compressBound( static_cast<zlib_uLong>( src_size ) );
+    dst.resize( dst_size );
+
+    if ( zlib_compress2( reinterpret_cast<zlib_Bytef*>( &dst[ 0 ] ), &dst_size,
+      reinterpret_cast<const zlib_Bytef*>( src ), src_size, this->level_ ) != Z_OK )
+    {
+      return false;
+    }
+
+    dst.resize( dst_size );
+    return true;
+  }
+
+  virtual bool decompress( const char* src, size_t src_size, char* dst, size_t dst_size ) const
+  {
+    zlib_uLongf size = dst_size;
+    if ( zlib_uncompress( reinterpret_cast<zlib_Bytef*>( dst ), &size,
+      reinterpret_cast<const zlib_Bytef*>( src ), src_size ) != Z_OK )
+    {
+      return false;
+    }
+
+    return size == dst_size;
+  }
+
+private:
+  std::string name_;
+  unsigned char id_;
+  int level_;
+};
+
+#ifdef BUILD_WITH_LZ4
+class LargeVolumeLZ4Codec : public LargeVolumeCodec
+{
+public:
+  virtual std::string get_name() const { return "lz4"; }
+  virtual unsigned char get_id() const { return 3; }
+
+  virtual bool compress( const char* src, size_t src_size, std::vector<char>& dst ) const
+  {
+    if ( src_size > static_cast<size_t>( LZ4_MAX_INPUT_SIZE ) ) return false;
+
+    dst.resize( LZ4_compressBound( static_cast<int>( src_size ) ) );
+    int dst_size = LZ4_compress_default( src, &dst[ 0 ], static_cast<int>( src_size ),
+      static_cast<int>( dst.size() ) );
+    if ( dst_size <= 0 ) return false;
+
+    dst.resize( dst_size );
+    return true;
+  }
+
+  virtual bool decompress( const char* src, size_t src_size, char* dst, size_t dst_size ) const
+  {
+    int size = LZ4_decompress_safe( src, dst, static_cast<int>( src_size ), 
+      static_cast<int>( dst_size ) );
+    return size >= 0 && static_cast<size_t>( size ) == dst_size;
+  }
+};
+#endif
+
+#ifdef BUILD_WITH_ZSTD
+class LargeVolumeZstdCodec : public LargeVolumeCodec
+{
+public:
+  virtual std::string get_name() const { return "zstd"; }
+  virtual unsigned char get_id() const { return 4; }
+
+  virtual bool compress( const char* src, size_t src_size, std::vector<char>& dst ) const
+  {
+    dst.resize( ZSTD_compressBound( src_size ) );
+    size_t dst_size = ZSTD_compress( &dst[ 0 ], dst.size(), src, src_size, 3 );
+    if ( ZSTD_isError( dst_size ) ) return false;
+
+    dst.resize( dst_size );
+    return true;
+  }
+
+  virtual bool decompress( const char* src, size_t src_size, char* dst, size_t dst_size ) const
+  {
+    size_t size = ZSTD_decompress( dst, dst_size, src, src_size );
+    return !ZSTD_isError( size ) && size == dst_size;
+  }
+};
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Registry
+//////////////////////////////////////////////////////////////////////////
+
+class LargeVolumeCodecRegistryPrivate
+{
+public:
+  mutable boost::mutex mutex_;
+  std::map< std::string, LargeVolumeCodecHandle > codecs_by_name_;
+  std::map< unsigned char, LargeVolumeCodecHandle > codecs_by_id_;
+};
+
+CORE_SINGLETON_IMPLEMENTATION( LargeVolumeCodecRegistry );
+
+LargeVolumeCodecRegistry::LargeVolumeCodecRegistry() :
+  private_( new LargeVolumeCodecRegistryPrivate )
+{
+  this->register_codec( LargeVolumeCodecHandle( new LargeVolumeRawCodec ) );
+  this->register_codec( LargeVolumeCodecHandle( 
+    new LargeVolumeZlibCodec( "zlib", 1, Z_DEFAULT_COMPRESSION ) ) );
+  this->register_codec( LargeVolumeCodecHandle( 
+    new LargeVolumeZlibCodec( "zlib-fast", 2, Z_BEST_SPEED ) ) );
+#ifdef BUILD_WITH_LZ4
+  this->register_codec( LargeVolumeCodecHandle( new LargeVolumeLZ4Codec ) );
+#endif
+#ifdef BUILD_WITH_ZSTD
+  this->register_codec( LargeVolumeCodecHandle( new LargeVolumeZstdCodec ) );
+#endif
+}
+
+LargeVolumeCodecRegistry::~LargeVolumeCodecRegistry()
+{
+}
+
+bool LargeVolumeCodecRegistry::register_codec( LargeVolumeCodecHandle codec )
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+
+  if ( this->private_->codecs_by_name_.count( codec->get_name() ) ||
+    this->private_->codecs_by_id_.count( codec->get_id() ) )
+  {
+    return false;
+  }
+
+  this->private_->codecs_by_name_[ codec->get_name() ] = codec;
+  this->private_->codecs_by_id_[ codec->get_id() ] = codec;
+  return true;
+}
+
+LargeVolumeCodecHandle LargeVolumeCodecRegistry::get_codec( const std::string& name ) const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+
+  std::map< std::string, LargeVolumeCodecHandle >::const_iterator it = 
+    this->private_->codecs_by_name_.find( name );
+  if ( it == this->private_->codecs_by_name_.end() ) return LargeVolumeCodecHandle();
+  return it->second;
+}
+
+LargeVolumeCodecHandle LargeVolumeCodecRegistry::get_codec( unsigned char id ) const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+
+  std::map< unsigned char, LargeVolumeCodecHandle >::const_iterator it = 
+    this->private_->codecs_by_id_.find( id );
+  if ( it == this->private_->codecs_by_id_.end() ) return LargeVolumeCodecHandle();
+  return it->second;
+}
+
+std::vector< std::string > LargeVolumeCodecRegistry::get_codec_names() const
+{
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+
+  std::vector< std::string > names;
+  std::map< std::string, LargeVolumeCodecHandle >::const_iterator it = 
+    this->private_->codecs_by_name_.begin();
+  for ( ; it != this->private_->codecs_by_name_.end(); ++it )
+  {
+    names.push_back( it->first );
+  }
+  return names;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Brick encoding
+//////////////////////////////////////////////////////////////////////////
+
+// Layout of the brick header, all numbers are stored little endian:
+//  0- 3  magic "S3DB"
+//  4     header version
+//  5     codec id
+//  6     filter
+//  7     element size
+//  8-15  size of the raw data
+// 16-23  size of the compressed data following the header
+// 24-27  adler32 checksum of the raw data
+// 28-31  reserved
+const size_t LargeVolumeBrickCodec::HEADER_SIZE_C = 32;
+
+static const char BRICK_MAGIC_C[ 4 ] = { 'S', '3', 'D', 'B' };
+static const unsigned char BRICK_HEADER_VERSION_C = 1;
+
+static void WriteUInt( char* dst, unsigned long long value, size_t num_bytes )
+{
+  for ( size_t j = 0; j < num_bytes; j++ )
+  {
+    dst[ j ] = static_cast<char>( ( value >> ( 8 * j ) ) & 0xff );
+  }
+}
+
+static unsigned long long ReadUInt( const char* src, size_t num_bytes )
+{
+  unsigned long long value = 0;
+  for ( size_t j = 0; j < num_bytes; j++ )
+  {
+    value |= static_cast<unsigned long long>( static_cast<unsigned char>( src[ j ] ) ) << ( 8 * j );
+  }
+  return value;
+}
+
+static unsigned int ComputeChecksum( const char* data, size_t size )
+{
+  zlib_uLong checksum = zlib_adler32( 0, 0, 0 );
+
+  // NOTE: adler32 takes 32 bit lengths, hence large bricks are processed in pieces
+  const size_t chunk_size = static_cast<size_t>( 1 ) << 30;
+  for ( size_t offset = 0; offset < size; offset += chunk_size )
+  {
+    size_t length = std::min( chunk_size, size - offset );
+    checksum = zlib_adler32( checksum, reinterpret_cast<const zlib_Bytef*>( data + offset ),
+      static_cast<zlib_uInt>( length ) );
+  }
+
+  return static_cast<unsigned int>( checksum );
+}
+
+static void ApplyFilter( const char* src, char* dst, size_t size, size_t element_size,
+  LargeVolumeFilter filter )
+{
+  size_t num_elements = size / element_size;
+
+  // Shuffle the bytes of each element into separate planes
+  for ( size_t b = 0; b < element_size; b++ )
+  {
+    char* plane = dst + b * num_elements;
+    const char* ptr = src + b;
+    for ( size_t j = 0; j < num_elements; j++, ptr += element_size )
+    {
+      plane[ j ] = *ptr;
+    }
+  }
+
+  // Copy the bytes that do not form a complete element
+  std::memcpy( dst + num_elements * element_size, src + num_elements * element_size,
+    size - num_elements * element_size );
+
+  if ( filter == LargeVolumeFilter::DELTA_E )
+  {
+    unsigned char* data = reinterpret_cast<unsigned char*>( dst );
+    for ( size_t j = size; j-- > 1; )
+    {
+      data[ j ] = static_cast<unsigned char>( data[ j ] - data[ j - 1 ] );
+    }
+  }
+}
+
+static void RemoveFilter( char* src, char* dst, size_t size, size_t element_size,
+  LargeVolumeFilter filter )
+{
+  if ( filter == LargeVolumeFilter::DELTA_E )
+  {
+    unsigned char* data = reinterpret_cast<unsigned char*>( src );
+    for ( size_t j = 1; j < size; j++ )
+    {
+      data[ j ] = static_cast<unsigned char>( data[ j ] + data[ j - 1 ] );
+    }
+  }
+
+  size_t num_elements = size / element_size;
+
+  for ( size_t b = 0; b < element_size; b++ )
+  {
+    const char* plane = src + b * num_elements;
+    char* ptr = dst + b;
+    for ( size_t j = 0; j < num_elements; j++, ptr += element_size )
+    {
+      *ptr = plane[ j ];
+    }
+  }
+
+  std::memcpy( dst + num_elements * element_size, src + num_elements * element_size,
+    size - num_elements * element_size );
+}
+
+bool LargeVolumeBrickCodec::Encode( const char* data, size_t size, size_t element_size,
+  const std::string& codec_name, LargeVolumeFilter filter, std::vector<char>& encoded,
+  std::string& error )
+{
+  LargeVolumeCodecHandle codec = LargeVolumeCodecRegistry::Instance()->get_codec( codec_name );
+  if ( !codec )
+  {
+    error = "Unknown brick codec '" + codec_name + "'.";
+    return false;
+  }
+
+  if ( element_size == 0 ) element_size = 1;
+
+  // Filters do not help uncompressed data
+  if ( codec->get_id() == 0 ) filter = LargeVolumeFilter::NONE_E;
+
+  const char* src = data;
+  std::vector<char> filtered;
+  if ( filter != LargeVolumeFilter::NONE_E )
+  {
+    filtered.resize( size );
+    ApplyFilter( data, size ? &filtered[ 0 ] : 0, size, element_size, filter );
+    src = size ? &filtered[ 0 ] : data;
+  }
+
+  std::vector<char> payload;
+  // NOTE: An encoded brick must always differ in size from the raw data, as files of exactly the
+  // raw size are read as raw bricks without a header.
+  if ( !codec->compress( src, size, payload ) || HEADER_SIZE_C + payload.size() >= size )
+  {
+    // Store the data uncompressed if it cannot be compressed
+    codec = LargeVolumeCodecRegistry::Instance()->get_codec( 0 );
+    filter = LargeVolumeFilter::NONE_E;
+    payload.assign( data, data + size );
+  }
+
+  encoded.resize( HEADER_SIZE_C + payload.size() );
+  char* header = &encoded[ 0 ];
+  std::memset( header, 0, HEADER_SIZE_C );
+  std::memcpy( header, BRICK_MAGIC_C, 4 );
+  header[ 4 ] = static_cast<char>( BRICK_HEADER_VERSION_C );
+  header[ 5 ] = static_cast<char>( codec->get_id() );
+  header[ 6 ] = static_cast<char>( static_cast<int>( filter ) );
+  header[ 7 ] = static_cast<char>( element_size );
+  WriteUInt( header + 8, size, 8 );
+  WriteUInt( header + 16, payload.size(), 8 );
+  WriteUInt( header + 24, ComputeChecksum( data, size ), 4 );
+
+  if ( !payload.empty() )
+  {
+    std::memcpy( header + HEADER_SIZE_C, &payload[ 0 ], payload.size() );
+  }
+
+  return true;
+}
+
+bool LargeVolumeBrickCodec::IsEncoded( const char* header, size_t file_size, size_t raw_size )
+{
+  if ( file_size < HEADER_SIZE_C ) return false;
+  if ( std::memcmp( header, BRICK_MAGIC_C, 4 ) != 0 ) return false;
+  if ( static_cast<unsigned char>( header[ 4 ] ) != BRICK_HEADER_VERSION_C ) return false;
+  if ( ReadUInt( header + 8, 8 ) != raw_size ) return false;
+  if ( ReadUInt( header + 16, 8 ) + HEADER_SIZE_C != file_size ) return false;
+
+  return true;
+}
+
+bool LargeVolumeBrickCodec::Decode( const char* encoded, size_t encoded_size, char* data, 
+  size_t size, size_t element_size, std::string& error )
+{
+  if ( !IsEncoded( encoded, encoded_size, size ) )
+  {
+    error = "Brick has an invalid header.";
+    return false;
+  }
+
+  unsigned char codec_id = static_cast<unsigned char>( encoded[ 5 ] );
+  LargeVolumeCodecHandle codec = LargeVolumeCodecRegistry::Instance()->get_codec( codec_id );
+  if ( !codec )
+  {
+    error = "Brick was compressed with codec " + ExportToString( static_cast<int>( codec_id ) ) +
+      ", which is not available in this build.";
+    return false;
+  }
+
+  int filter_id = static_cast<unsigned char>( encoded[ 6 ] );
+  if ( filter_id > static_cast<int>( LargeVolumeFilter::DELTA_E ) )
+  {
+    error = "Brick was compressed with an unknown filter.";
+    return false;
+  }
+  LargeVolumeFilter filter = static_cast<LargeVolumeFilter::enum_type>( filter_id );
+
+  size_t filter_element_size = static_cast<unsigned char>( encoded[ 7 ] );
+  if ( filter_element_size == 0 ) filter_element_size = element_size;
+
+  const char* payload = encoded + HEADER_SIZE_C;
+  size_t payload_size = encoded_size - HEADER_SIZE_C;
+
+  if ( filter == LargeVolumeFilter::NONE_E )
+  {
+    if ( !codec->decompress( payload, payload_size, data, size ) )
+    {
+      error = "Could not decompress brick.";
+      return false;
+    }
+  }
+  else
+  {
+    std::vector<char> filtered( size );
+    if ( !codec->decompress( payload, payload_size, size ? &filtered[ 0 ] : 0, size ) )
+    {
+      error = "Could not decompress brick.";
+      return false;
+    }
+    RemoveFilter( size ? &filtered[ 0 ] : 0, data, size, filter_element_size, filter );
+  }
+
+  if ( ComputeChecksum( data, size ) != static_cast<unsigned int>( ReadUInt( encoded + 24, 4 ) ) )
+  {
+    error = "Brick checksum does not match, the brick is corrupt.";
+    return false;
+  }
+
+  return true;
+}
+
+std::string LargeVolumeBrickCodec::GetCodecName( const char* header )
+{
+  LargeVolumeCodecHandle codec = LargeVolumeCodecRegistry::Instance()->get_codec( 
+    static_cast<unsigned char>( header[ 5 ] ) );
+  if ( !codec ) return "unknown";
+  return codec->get_name();
+}
+
+} // end namespace Core
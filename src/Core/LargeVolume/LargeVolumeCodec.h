@@ -0,0 +1,171 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORE_LARGEVOLUME_LARGEVOLUMECODEC_H
+#define CORE_LARGEVOLUME_LARGEVOLUMECODEC_H
+
+// STL includes
+#include <string>
+#include <vector>
+
+// Boost includes
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+// Core includes
+#include <Core/Utils/EnumClass.h>
+#include <Core/Utils/Singleton.h>
+
+namespace Core
+{
+
+// CLASS LargeVolumeFilter:
+/// Filters that are applied to the brick data before it is compressed. SHUFFLE_E groups the
+/// n-th byte of every element together, DELTA_E shuffles and replaces each byte with the
+/// difference to its predecessor, which turns smooth 16 bit data into long runs of small values.
+
+CORE_ENUM_CLASS
+(
+  LargeVolumeFilter,
+  NONE_E = 0,
+  SHUFFLE_E,
+  DELTA_E
+)
+
+/// IMPORTFROMSTRING:
+/// Import a filter from its name (none, shuffle or delta)
+bool ImportFromString( const std::string& filter_string, LargeVolumeFilter& filter );
+
+/// EXPORTTOSTRING:
+/// Export the filter to its name
+std::string ExportToString( LargeVolumeFilter filter );
+
+
+class LargeVolumeCodec;
+typedef boost::shared_ptr< LargeVolumeCodec > LargeVolumeCodecHandle;
+
+// CLASS LargeVolumeCodec:
+/// Compression backend for the bricks of a large volume. Each codec is identified in the brick
+/// header by a unique id, hence ids of existing codecs should never change.
+
+class LargeVolumeCodec : public boost::noncopyable
+{
+public:
+  virtual ~LargeVolumeCodec() {}
+
+  /// GET_NAME:
+  /// Name used to select the codec
+  virtual std::string get_name() const = 0;
+
+  /// GET_ID:
+  /// Id that is stored in the brick header
+  virtual unsigned char get_id() const = 0;
+
+  /// COMPRESS:
+  /// Compress src into dst. Returns false if the data could not be compressed.
+  virtual bool compress( const char* src, size_t src_size, std::vector<char>& dst ) const = 0;
+
+  /// DECOMPRESS:
+  /// Decompress src into dst, dst_size needs to be the exact size of the uncompressed data.
+  virtual bool decompress( const char* src, size_t src_size, char* dst, size_t dst_size ) const = 0;
+};
+
+
+// CLASS LargeVolumeCodecRegistry:
+/// Registry of the codecs that are available for storing bricks. The raw and zlib codecs are
+/// always available, LZ4 and Zstd are available if Seg3D was built with those libraries.
+
+class LargeVolumeCodecRegistryPrivate;
+typedef boost::shared_ptr< LargeVolumeCodecRegistryPrivate > LargeVolumeCodecRegistryPrivateHandle;
+
+class LargeVolumeCodecRegistry : public boost::noncopyable
+{
+  CORE_SINGLETON( LargeVolumeCodecRegistry );
+
+  // -- constructor/destructor --
+private:
+  LargeVolumeCodecRegistry();
+  virtual ~LargeVolumeCodecRegistry();
+
+public:
+  /// REGISTER_CODEC:
+  /// Add a codec to the registry. Returns false if a codec with the same name or id exists.
+  bool register_codec( LargeVolumeCodecHandle codec );
+
+  /// GET_CODEC:
+  /// Find a codec by name, returns an empty handle if it does not exist
+  LargeVolumeCodecHandle get_codec( const std::string& name ) const;
+
+  /// GET_CODEC:
+  /// Find a codec by id, returns an empty handle if it does not exist
+  LargeVolumeCodecHandle get_codec( unsigned char id ) const;
+
+  /// GET_CODEC_NAMES:
+  /// Names of all the codecs that are available
+  std::vector< std::string > get_codec_names() const;
+
+private:
+  LargeVolumeCodecRegistryPrivateHandle private_;
+};
+
+
+// CLASS LargeVolumeBrickCodec:
+/// Encoding and decoding of brick files. An encoded brick starts with a header that records the
+/// codec, the filter, the size of the raw data and a checksum of the raw data.
+
+class LargeVolumeBrickCodec
+{
+public:
+  /// Size of the header in front of the compressed data
+  static const size_t HEADER_SIZE_C;
+
+  /// ENCODE:
+  /// Filter and compress raw brick data. If the compressed data including its header is not
+  /// smaller than the raw data, the brick is stored uncompressed instead.
+  static bool Encode( const char* data, size_t size, size_t element_size,
+    const std::string& codec_name, LargeVolumeFilter filter, std::vector<char>& encoded,
+    std::string& error );
+
+  /// IS_ENCODED:
+  /// Check whether a file starts with a valid brick header that matches the file size and the
+  /// expected size of the raw data. Bricks written by older versions have no header.
+  static bool IsEncoded( const char* header, size_t file_size, size_t raw_size );
+
+  /// DECODE:
+  /// Decompress and unfilter an encoded brick and verify its checksum
+  static bool Decode( const char* encoded, size_t encoded_size, char* data, size_t size,
+    size_t element_size, std::string& error );
+
+  /// GET_CODEC_NAME:
+  /// Get the name of the codec that was used for an encoded brick
+  static std::string GetCodecName( const char* header );
+};
+
+} // end namespace Core
+
+#endif
@@ -28,14 +28,21 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
+#include <fstream>
 #include <iomanip>
 
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include <Core/DataBlock/ITKDataBlock.h>
 #include <Core/DataBlock/ITKImage2DData.h>
 #include <Core/DataBlock/StdDataBlock.h>
 #include <Core/Geometry/IndexVector.h>
 #include <Core/Utils/FileUtil.h>
 #include <Core/Utils/Parallel.h>
+#include <Core/Utils/ThreadPool.h>
 
 #include <itkPNGImageIO.h>
 #include <itkTIFFImageIO.h>
@@ -53,6 +60,9 @@ namespace Core
 class LargeVolumeBrickLevel;
 typedef boost::shared_ptr<LargeVolumeBrickLevel> LargeVolumeBrickLevelHandle;
 
+typedef std::pair< BrickInfo, DataBlockHandle > LargeVolumeBrickBuffer;
+typedef std::vector< LargeVolumeBrickBuffer > LargeVolumeBrickBufferList;
+
 class LargeVolumeBrickLevel
 {
 public:
@@ -62,6 +72,7 @@ public:
     buffer_size_( 0 ),
     buffer_index_( 0 ),
     buffer_count_( 0 ),
+    padded_index_( 0 ),
     schema_( schema )
   {
     this->layout_ = schema_->get_level_layout( this->level_ );
@@ -77,6 +88,11 @@ public:
   IndexVector layout_;
 
   std::vector<DataBlockHandle> buffers_;
+
+  // Brick rows that are being filled when bricking in a single pass, indexed by z brick index
+  std::map< IndexVector::index_type, std::vector<DataBlockHandle> > rows_;
+  IndexVector::index_type padded_index_;
+
   LargeVolumeSchemaHandle schema_;
 
 public:
@@ -89,9 +105,27 @@ public:
   void allocate_buffers( size_t size );
 
   template<class T>
-  bool insert_slice_internals( DataBlockHandle slice );
+  bool copy_slice_internals( DataBlockHandle slice, std::vector<DataBlockHandle>& buffers, size_t index );
+  bool copy_slice( DataBlockHandle slice, std::vector<DataBlockHandle>& buffers, size_t index );
+
+  // -- two pass bricking --
   bool insert_slice( DataBlockHandle slice );
   bool sync_buffers( bool done, std::string& error );
+
+  // -- single pass bricking --
+  /// GET_ROW_MEMORY
+  /// Memory needed for one row of bricks (all bricks with the same z index)
+  size_t get_row_memory() const;
+
+  /// GET_ROW_DEPTH
+  /// Maximum number of brick rows that a slice is part of at the same time
+  size_t get_row_depth() const;
+
+  /// INSERT_ROW_SLICE
+  /// Insert a slice into all rows of bricks that contain it. An empty handle inserts an overlap
+  /// slice filled with zeros. Rows that are complete are removed and their bricks are returned
+  /// in completed_bricks.
+  bool insert_row_slice( DataBlockHandle slice, LargeVolumeBrickBufferList& completed_bricks );
 };
 
 void LargeVolumeBrickLevel::allocate_buffers( size_t size )
@@ -107,7 +141,8 @@ void LargeVolumeBrickLevel::allocate_buffers( size_t size )
 }
 
 template<class T>
-bool LargeVolumeBrickLevel::insert_slice_internals( DataBlockHandle slice )
+bool LargeVolumeBrickLevel::copy_slice_internals( DataBlockHandle slice, 
+  std::vector<DataBlockHandle>& buffers, size_t index )
 {
   const IndexVector::index_type overlap = static_cast<IndexVector::index_type>( this->schema_->get_overlap() );
   const IndexVector brick_size = this->schema_->get_brick_size();
@@ -125,13 +160,13 @@ bool LargeVolumeBrickLevel::insert_slice_internals( DataBlockHandle slice )
     {
       for ( IndexVector::index_type bx = 0; bx < this->layout_.x(); bx++, k++ )
       {
-        DataBlockHandle buffer = buffers_[k];
+        DataBlockHandle buffer = buffers[k];
 
         IndexVector::index_type nx = buffer->get_nx();
         IndexVector::index_type ny = buffer->get_ny();
 
         T* data = reinterpret_cast<T*>( buffer->get_data() );
-        data += ( nx * ny * this->buffer_index_ );
+        data += ( nx * ny * index );
 
         IndexVector::index_type sy_begin = by * eff_brick_size.y() - overlap;
         IndexVector::index_type sy_begin2 = Max( by * eff_brick_size.y() - overlap , static_cast<IndexVector::index_type>( 0 ) );
@@ -184,13 +219,13 @@ bool LargeVolumeBrickLevel::insert_slice_internals( DataBlockHandle slice )
     {
       for ( IndexVector::index_type bx = 0; bx < this->layout_.x(); bx++, k++ )
       {
-        DataBlockHandle buffer = buffers_[k];
+        DataBlockHandle buffer = buffers[k];
         IndexVector::index_type nx = buffer->get_nx();
         IndexVector::index_type ny = buffer->get_ny();
         IndexVector::index_type nxy = nx * ny;
 
         T* data = reinterpret_cast<T*>( buffer->get_data() );
-        data += ( nxy * this->buffer_index_ );
+        data += ( nxy * index );
 
         for ( IndexVector::index_type p = 0; p < nxy; p++, data++ )
         {
@@ -200,41 +235,125 @@ bool LargeVolumeBrickLevel::insert_slice_internals( DataBlockHandle slice )
     }
   }
 
-  buffer_index_++;
-  buffer_count_++;
-
   return true;
 }
 
-bool LargeVolumeBrickLevel::insert_slice( DataBlockHandle slice )
+bool LargeVolumeBrickLevel::copy_slice( DataBlockHandle slice, 
+  std::vector<DataBlockHandle>& buffers, size_t index )
 {
-  switch( slice->get_data_type() )
+  switch( this->schema_->get_data_type() )
   {
     case DataType::CHAR_E:
-      return this->insert_slice_internals<signed char>( slice );
+      return this->copy_slice_internals<signed char>( slice, buffers, index );
     case DataType::UCHAR_E:
-      return this->insert_slice_internals<unsigned char>( slice );
+      return this->copy_slice_internals<unsigned char>( slice, buffers, index );
     case DataType::SHORT_E:
-      return this->insert_slice_internals<short>( slice );
+      return this->copy_slice_internals<short>( slice, buffers, index );
     case DataType::USHORT_E:
-      return this->insert_slice_internals<unsigned short>( slice );
+      return this->copy_slice_internals<unsigned short>( slice, buffers, index );
     case DataType::INT_E:
-      return this->insert_slice_internals<int>( slice );
+      return this->copy_slice_internals<int>( slice, buffers, index );
     case DataType::UINT_E:
-      return this->insert_slice_internals<unsigned int>( slice );
+      return this->copy_slice_internals<unsigned int>( slice, buffers, index );
     case DataType::LONGLONG_E:
-      return this->insert_slice_internals<long long>( slice );
+      return this->copy_slice_internals<long long>( slice, buffers, index );
     case DataType::ULONGLONG_E:
-      return this->insert_slice_internals<unsigned long long>( slice );
+      return this->copy_slice_internals<unsigned long long>( slice, buffers, index );
     case DataType::FLOAT_E:
-      return this->insert_slice_internals<float>( slice );
+      return this->copy_slice_internals<float>( slice, buffers, index );
     case DataType::DOUBLE_E:
-      return this->insert_slice_internals<double>( slice );
+      return this->copy_slice_internals<double>( slice, buffers, index );
   }
 
   return false;
 }
 
+bool LargeVolumeBrickLevel::insert_slice( DataBlockHandle slice )
+{
+  if (! this->copy_slice( slice, this->buffers_, this->buffer_index_ ) )
+  {
+    return false;
+  }
+
+  buffer_index_++;
+  buffer_count_++;
+
+  return true;
+}
+
+size_t LargeVolumeBrickLevel::get_row_memory() const
+{
+  size_t row_memory = 0;
+  for ( size_t k = 0; k < this->buffers_.size(); k++ )
+  {
+    IndexVector brick_size = this->schema_->get_brick_size( BrickInfo( k, this->level_ ) );
+    row_memory += brick_size.x() * brick_size.y() * brick_size.z();
+  }
+
+  return row_memory * GetSizeDataType( this->schema_->get_data_type() );
+}
+
+size_t LargeVolumeBrickLevel::get_row_depth() const
+{
+  const IndexVector::index_type eff_z = this->schema_->get_effective_brick_size().z();
+  const IndexVector::index_type overlap = this->schema_->get_overlap();
+  return static_cast<size_t>( ( 2 * overlap + eff_z - 1 ) / eff_z + 1 );
+}
+
+bool LargeVolumeBrickLevel::insert_row_slice( DataBlockHandle slice, 
+  LargeVolumeBrickBufferList& completed_bricks )
+{
+  const IndexVector::index_type overlap = this->schema_->get_overlap();
+  const IndexVector::index_type eff_z = this->schema_->get_effective_brick_size().z();
+  const IndexVector::index_type level_nz = this->schema_->get_level_size( this->level_ ).z();
+  const IndexVector::index_type num_xy = this->layout_.x() * this->layout_.y();
+
+  // Index of the slice including the overlap slices in front of the volume
+  const IndexVector::index_type p = this->padded_index_++;
+
+  // Row z contains the padded slices [ z * eff_z, min( ( z + 1 ) * eff_z, nz ) + 2 * overlap )
+  IndexVector::index_type z_begin = Max( static_cast<IndexVector::index_type>( 0 ),
+    ( p - 2 * overlap ) / eff_z - 1 );
+  IndexVector::index_type z_end = Min( p / eff_z + 1, this->layout_.z() );
+
+  for ( IndexVector::index_type z = z_begin; z < z_end; z++ )
+  {
+    IndexVector::index_type row_start = z * eff_z;
+    IndexVector::index_type row_end = Min( ( z + 1 ) * eff_z, level_nz ) + 2 * overlap;
+    if ( p < row_start || p >= row_end ) continue;
+
+    std::vector<DataBlockHandle>& row = this->rows_[ z ];
+    if ( row.empty() )
+    {
+      row.resize( num_xy );
+      for ( IndexVector::index_type k = 0; k < num_xy; k++ )
+      {
+        BrickInfo bi( k + z * num_xy, this->level_ );
+        IndexVector brick_size = this->schema_->get_brick_size( bi );
+        row[ k ] = StdDataBlock::New( brick_size.x(), brick_size.y(), brick_size.z(),
+          this->schema_->get_data_type() );
+      }
+    }
+
+    if (! this->copy_slice( slice, row, p - row_start ) )
+    {
+      return false;
+    }
+
+    if ( p == row_end - 1 )
+    {
+      for ( IndexVector::index_type k = 0; k < num_xy; k++ )
+      {
+        completed_bricks.push_back( LargeVolumeBrickBuffer( 
+          BrickInfo( k + z * num_xy, this->level_ ), row[ k ] ) );
+      }
+      this->rows_.erase( z );
+    }
+  }
+
+  return true;
+}
+
 bool LargeVolumeBrickLevel::sync_buffers( bool done, std::string& error )
 {
 
@@ -307,7 +426,14 @@ class LargeVolumeConverterPrivate {
 
 public:
   LargeVolumeConverterPrivate() :
-    data_type_( DataType::UNKNOWN_E )
+    data_type_( DataType::UNKNOWN_E ),
+    mem_limit_( 0 ),
+    resume_( false ),
+    single_pass_( false ),
+    success_( true ),
+    input_bytes_( 0 ),
+    output_bytes_( 0 ),
+    elapsed_seconds_( 0.0 )
   {}
 
   // -- input parameters --
@@ -325,6 +451,7 @@ public:
   size_t overlap_;
 
   long long mem_limit_;
+  bool resume_;
 
   LargeVolumeSchemaHandle schema_;
 
@@ -384,6 +511,10 @@ public:
 public:
     bool process_slice( size_t level, std::string& error );
 
+  /// BRICK_SLICE_SINGLE_PASS
+  /// Add the current slice of a level to its brick rows and write out the rows that are done
+  bool brick_slice_single_pass( size_t level, bool first_slice, bool last_slice, std::string& error );
+
 
     // slices at different resolution levels
     std::vector<DataBlockHandle> slices_;
@@ -393,10 +524,218 @@ public:
 
   void run_phase3_parallel( int num_threads, int thread_num, boost::barrier& barrier  );
 
+  // -- slice decoding --
+public:
+  /// DECODE_FILES
+  /// Load, clip and scan a range of files of the current window in parallel
+  void decode_files( size_t window_start, size_t begin, size_t end );
+
+  std::vector<DataBlockHandle> decoded_slices_;
+  std::vector<std::string> decode_errors_;
+  std::vector<char> decode_clipped_;
+  std::vector<double> decode_min_;
+  std::vector<double> decode_max_;
+
+  // -- brick writer --
+public:
+  /// WRITE_BRICKS
+  /// Compress and write completed bricks on the thread pool. Bricks that are submitted earlier
+  /// need to be written first, which limits the number of completed bricks that are kept in memory.
+  bool write_bricks( const LargeVolumeBrickBufferList& bricks, std::string& error );
+
+  /// WRITE_BRICK
+  /// Compress and write one brick and record it in the journal
+  void write_brick( BrickInfo bi, DataBlockHandle brick );
+
+  /// WAIT_FOR_WRITES
+  /// Wait until all bricks are written
+  bool wait_for_writes( std::string& error );
+
+  /// GET_JOURNAL_FILE_NAME
+  /// File that lists the bricks that have been written successfully
+  boost::filesystem::path get_journal_file_name() const;
+
+  /// READ_JOURNAL
+  /// Read the bricks that were written by an interrupted conversion
+  void read_journal();
+
+  // Whether bricks are built in memory and written once
+  bool single_pass_;
+
+  boost::shared_ptr<TaskGroup> writers_;
+  boost::mutex writer_mutex_;
+  std::ofstream journal_;
+  std::set<std::string> journaled_bricks_;
+  std::string write_error_;
+
   bool success_;
 
+  // -- statistics --
+public:
+  long long input_bytes_;
+  long long output_bytes_;
+  double elapsed_seconds_;
 };
 
+boost::filesystem::path LargeVolumeConverterPrivate::get_journal_file_name() const
+{
+  return this->schema_->get_dir() / "conversion.journal";
+}
+
+void LargeVolumeConverterPrivate::read_journal()
+{
+  this->journaled_bricks_.clear();
+
+  std::ifstream journal( this->get_journal_file_name().string().c_str() );
+  std::string brick_name;
+  while ( std::getline( journal, brick_name ) )
+  {
+    // NOTE: Only trust bricks that made it to disk completely
+    if ( !brick_name.empty() && boost::filesystem::exists( this->schema_->get_dir() / brick_name ) )
+    {
+      this->journaled_bricks_.insert( brick_name );
+    }
+  }
+}
+
+void LargeVolumeConverterPrivate::write_brick( BrickInfo bi, DataBlockHandle brick )
+{
+  std::string error;
+  if (! this->schema_->write_brick( brick, bi, error ) )
+  {
+    boost::mutex::scoped_lock lock( this->writer_mutex_ );
+    if ( this->success_ )
+    {
+      this->write_error_ = error;
+      this->success_ = false;
+    }
+    return;
+  }
+
+  boost::filesystem::path brick_file = this->schema_->get_brick_file_name( bi );
+  long long brick_bytes = 0;
+  try
+  {
+    brick_bytes = static_cast<long long>( boost::filesystem::file_size( brick_file ) );
+  }
+  catch ( ... )
+  {
+  }
+
+  boost::mutex::scoped_lock lock( this->writer_mutex_ );
+  this->output_bytes_ += brick_bytes;
+  this->journal_ << brick_file.filename().string() << std::endl;
+}
+
+bool LargeVolumeConverterPrivate::write_bricks( const LargeVolumeBrickBufferList& bricks, std::string& error )
+{
+  // Only keep one set of completed bricks in flight
+  if (! this->wait_for_writes( error ) )
+  {
+    return false;
+  }
+
+  this->writers_.reset( new TaskGroup );
+  for ( size_t k = 0; k < bricks.size(); k++ )
+  {
+    std::string brick_name = this->schema_->get_brick_file_name( bricks[ k ].first ).filename().string();
+    if ( this->journaled_bricks_.count( brick_name ) ) continue;
+
+    this->writers_->run( boost::bind( &LargeVolumeConverterPrivate::write_brick, this,
+      bricks[ k ].first, bricks[ k ].second ) );
+  }
+
+  return true;
+}
+
+bool LargeVolumeConverterPrivate::wait_for_writes( std::string& error )
+{
+  if ( this->writers_ )
+  {
+    this->writers_->wait();
+    this->writers_.reset();
+  }
+
+  if ( !this->success_ )
+  {
+    error = this->write_error_;
+    return false;
+  }
+
+  return true;
+}
+
+void LargeVolumeConverterPrivate::decode_files( size_t window_start, size_t begin, size_t end )
+{
+  IndexVector total_size = this->schema_->get_size();
+
+  for ( size_t j = begin; j < end; j++ )
+  {
+    DataBlockHandle slice = this->load_file( this->files_[ window_start + j ], this->decode_errors_[ j ] );
+    this->decoded_slices_[ j ] = slice;
+    this->decode_clipped_[ j ] = 0;
+    if ( !slice ) continue;
+
+    if ( slice->get_nx() != total_size.x() ||  slice->get_ny() != total_size.y() )
+    {
+      this->decode_clipped_[ j ] = 1;
+      DataBlock::Clip( slice, slice, total_size.x(), total_size.y(), 1, 0.0 );
+    }
+
+    this->decode_min_[ j ] = std::numeric_limits<double>::max();
+    this->decode_max_[ j ] = std::numeric_limits<double>::min();
+    if (! this->compute_min_max( slice, this->decode_min_[ j ], this->decode_max_[ j ] ) )
+    {
+      this->decode_errors_[ j ] = "Could not compute min and max.";
+      this->decoded_slices_[ j ].reset();
+    }
+  }
+}
+
+bool LargeVolumeConverterPrivate::brick_slice_single_pass( size_t level, bool first_slice, 
+  bool last_slice, std::string& error )
+{
+  LargeVolumeBrickLevelHandle brick_level = this->brick_level_[ level ];
+  size_t overlap = this->schema_->get_overlap();
+
+  LargeVolumeBrickBufferList completed_bricks;
+
+  if ( first_slice )
+  {
+    for ( size_t k = 0; k < overlap; k++ )
+    {
+      if ( !brick_level->insert_row_slice( DataBlockHandle(), completed_bricks ) )
+      {
+        error = "Could not brick overlap slice.";
+        return false;
+      }
+    }
+  }
+
+  if (! brick_level->insert_row_slice( this->slices_[ level ], completed_bricks ) )
+  {
+    error = "Could not brick slice.";
+    return false;
+  }
+
+  if ( last_slice )
+  {
+    for ( size_t k = 0; k < overlap; k++ )
+    {
+      if ( !brick_level->insert_row_slice( DataBlockHandle(), completed_bricks ) )
+      {
+        error = "Could not brick overlap slice.";
+        return false;
+      }
+    }
+    std::cout << "done bricking level: " << level << std::endl;
+  }
+
+  if ( completed_bricks.empty() ) return true;
+
+  return this->write_bricks( completed_bricks, error );
+}
+
 template<class T>
 bool LargeVolumeConverterPrivate::compute_min_max_internals( DataBlockHandle slice, double& min, double& max )
 {
@@ -455,42 +794,52 @@ bool LargeVolumeConverterPrivate::process_slice( size_t level, std::string& erro
     DataBlockHandle slice = slices_[ level ];
 
     // Brick the data
-    if ( first_slice )
+  if ( this->single_pass_ )
   {
-    DataBlockHandle empty = Core::StdDataBlock::New( this->slices_[ level ]->get_nx(),
-      this->slices_[ level ]->get_ny(), this->slices_[ level ]->get_nz(),
-      this->slices_[ level ]->get_data_type() );
-    empty->clear();
-
-    size_t overlap = this->schema_->get_overlap();
-    for (size_t k = 0; k < overlap; k++ )
+    if (! this->brick_slice_single_pass( level, first_slice, last_slice, error ) )
     {
-      this->brick_level_[ level ]->insert_slice( empty );
-      this->brick_level_[ level ]->sync_buffers( false, error );
+      return false;
     }
   }
+  else
+  {
+    if ( first_slice )
+    {
+      DataBlockHandle empty = Core::StdDataBlock::New( this->slices_[ level ]->get_nx(),
+        this->slices_[ level ]->get_ny(), this->slices_[ level ]->get_nz(),
+        this->slices_[ level ]->get_data_type() );
+      empty->clear();
+
+      size_t overlap = this->schema_->get_overlap();
+      for (size_t k = 0; k < overlap; k++ )
+      {
+        this->brick_level_[ level ]->insert_slice( empty );
+        this->brick_level_[ level ]->sync_buffers( false, error );
+      }
+    }
 
-  this->brick_level_[ level ]->insert_slice( this->slices_[ level ] );
+    this->brick_level_[ level ]->insert_slice( this->slices_[ level ] );
 
     if ( last_slice )
-  {
-    DataBlockHandle empty = Core::StdDataBlock::New( this->slices_[ level ]->get_nx(),
-      this->slices_[ level ]->get_ny(), this->slices_[ level ]->get_nz(),
-      this->slices_[ level ]->get_data_type() );
-    empty->clear();
+    {
+      DataBlockHandle empty = Core::StdDataBlock::New( this->slices_[ level ]->get_nx(),
+        this->slices_[ level ]->get_ny(), this->slices_[ level ]->get_nz(),
+        this->slices_[ level ]->get_data_type() );
+      empty->clear();
 
-    size_t overlap = this->schema_->get_overlap();
-    for (size_t k = 0; k < overlap; k++ )
+      size_t overlap = this->schema_->get_overlap();
+      for (size_t k = 0; k < overlap; k++ )
+      {
+        this->brick_level_[ level ]->sync_buffers( false, error );
+        this->brick_level_[ level ]->insert_slice( empty );
+      }
+
+      this->brick_level_[ level ]->sync_buffers( true, error );
+    }
+    else
     {
       this->brick_level_[ level ]->sync_buffers( false, error );
-      this->brick_level_[ level ]->insert_slice( empty );
     }
-
-    this->brick_level_[ level ]->sync_buffers( true, error );
-  }
-  else
-  {
-    this->brick_level_[ level ]->sync_buffers( false, error );
   }
 
     // Down sample data for next level
@@ -1024,10 +1373,17 @@ void LargeVolumeConverter::set_mem_limit( long long mem_limit )
 }
 
 
+void LargeVolumeConverter::set_resume( bool resume )
+{
+  this->private_->resume_ = resume;
+}
+
 bool LargeVolumeConverter::run_phase2( std::string& error )
 {
   error = "";
 
+  boost::posix_time::ptime start_time = boost::posix_time::microsec_clock::local_time();
+
   // Save schema file
   if (! this->private_->schema_->save(error) )
   {
@@ -1069,11 +1425,11 @@ bool LargeVolumeConverter::run_phase2( std::string& error )
     // Allocate resample buffers
 
   size_t num_buffers = 0;
+  size_t row_buffer_size = 0;
 
     for ( size_t j = 0; j < num_levels; j++ )
     {
         IndexVector level_size = this->private_->schema_->get_level_size( j );
-        size_t slice_size = level_size.x() * level_size.y();
         if ( j > 0 )
     {
         // NOTE: The first one will always be allocated by ITK
@@ -1082,20 +1438,72 @@ bool LargeVolumeConverter::run_phase2( std::string& error )
     this->private_->brick_level_[ j ] = LargeVolumeBrickLevelHandle( new LargeVolumeBrickLevel( this->private_->schema_, j ) ) ;
 
     num_buffers += this->private_->brick_level_[ j ]->get_num_buffers();
+
+    // Rows that are being filled plus one row that is being written
+    row_buffer_size += ( this->private_->brick_level_[ j ]->get_row_depth() + 1 ) *
+      this->private_->brick_level_[ j ]->get_row_memory();
     }
 
-  IndexVector brick_size = this->private_->schema_->get_brick_size();
-  size_t buffer_size = Min( static_cast<size_t>( brick_size.z() ), static_cast<size_t>( (this->private_->mem_limit_ - slice_buffer_size ) / ( num_buffers * element_size * brick_size.x() * brick_size.y() ) ) );
+  // Decode as many files in parallel as there are threads, as long as the slices fit in memory
+  IndexVector level0_size = this->private_->schema_->get_level_size( 0 );
+  size_t input_slice_size = level0_size.x() * level0_size.y() * element_size;
+  size_t decode_window = static_cast<size_t>( ThreadPool::Instance()->get_concurrency() );
+  while ( decode_window > 1 && slice_buffer_size + ( decode_window - 1 ) * input_slice_size > 
+    static_cast<size_t>( this->private_->mem_limit_ ) )
+  {
+    decode_window--;
+  }
+  size_t decode_buffer_size = ( decode_window - 1 ) * input_slice_size;
 
-  if ( buffer_size == 0 )
+  // If all the rows of bricks that are active at the same time fit in memory, bricks are built
+  // in memory and written once. Otherwise, bricks are appended to their files in pieces and are
+  // compressed in phase 3.
+  this->private_->single_pass_ = ( slice_buffer_size + decode_buffer_size + row_buffer_size <= 
+    static_cast<size_t>( this->private_->mem_limit_ ) );
+
+  if ( this->private_->resume_ && !this->private_->single_pass_ )
   {
-    error = "Please allocate more memory to conversion process.";
+    error = "Conversion can only be resumed if all bricks of a row fit in memory, please allocate more memory to conversion process.";
     return false;
   }
 
+  if ( this->private_->single_pass_ )
+  {
+    std::cout << "Building bricks in memory, decoding " << decode_window << " files at a time." << std::endl;
+
+    this->private_->journaled_bricks_.clear();
+    if ( this->private_->resume_ )
+    {
+      this->private_->read_journal();
+      std::cout << "Resuming conversion, " << this->private_->journaled_bricks_.size() << 
+        " bricks were already written." << std::endl;
+    }
+
+    this->private_->journal_.open( this->private_->get_journal_file_name().string().c_str(), 
+      this->private_->resume_ ? std::ios_base::app : std::ios_base::trunc );
+    if ( !this->private_->journal_ )
+    {
+      error = "Could not open file '" + this->private_->get_journal_file_name().string() + "'.";
+      return false;
+    }
+  }
+  else
+  {
+    IndexVector brick_size = this->private_->schema_->get_brick_size();
+    size_t buffer_size = Min( static_cast<size_t>( brick_size.z() ), static_cast<size_t>( 
+      ( this->private_->mem_limit_ - slice_buffer_size - decode_buffer_size ) / 
+      ( num_buffers * element_size * brick_size.x() * brick_size.y() ) ) );
+
+    if ( buffer_size == 0 )
+    {
+      error = "Please allocate more memory to conversion process.";
+      return false;
+    }
+
     for ( size_t j = 0; j < num_levels; j++ )
     {
-    this->private_->brick_level_[ j ]->allocate_buffers( buffer_size );
+      this->private_->brick_level_[ j ]->allocate_buffers( buffer_size );
+    }
   }
 
     // Main loading loop
@@ -1103,42 +1511,78 @@ bool LargeVolumeConverter::run_phase2( std::string& error )
     double min = std::numeric_limits<double>::max();
   double max = std::numeric_limits<double>::min();
 
-  IndexVector total_size = this->private_->schema_->get_size();
+  this->private_->success_ = true;
+  this->private_->write_error_ = "";
+  this->private_->output_bytes_ = 0;
+  this->private_->input_bytes_ = 0;
+
+  this->private_->decoded_slices_.resize( decode_window );
+  this->private_->decode_errors_.resize( decode_window );
+  this->private_->decode_clipped_.resize( decode_window );
+  this->private_->decode_min_.resize( decode_window );
+  this->private_->decode_max_.resize( decode_window );
+
+  bool success = true;
+  for ( size_t window_start = 0; window_start < num_files && success; window_start += decode_window )
+  {
+    size_t window_size = Min( decode_window, num_files - window_start );
 
-    for ( IndexVector::index_type slice_idx = 0; slice_idx < num_files; slice_idx++)
+    // Decode the files of this window in parallel
+    parallel_for( 0, window_size, 1, boost::bind( &LargeVolumeConverterPrivate::decode_files,
+      this->private_, window_start, _1, _2 ) );
+
+    // Brick the slices in order
+    for ( size_t j = 0; j < window_size; j++ )
     {
+      // indicate which slice is being processed
+      std::cout << "Processing file: " << this->private_->files_[ window_start + j ].string() << std::endl;
 
-        // indicate which slice is being processed
-        std::cout << "Processing file: " << this->private_->files_[ slice_idx ].string() << std::endl;
+      this->private_->slices_[ 0 ] = this->private_->decoded_slices_[ j ];
+      this->private_->decoded_slices_[ j ].reset();
 
-        // load slice
-        this->private_->slices_[ 0 ] = this->private_->load_file( this->private_->files_[ slice_idx ], error );
+      if (! this->private_->slices_[ 0 ] )
+      {
+        error = this->private_->decode_errors_[ j ];
+        success = false;
+        break;
+      }
 
-    if (! this->private_->slices_[ 0 ] )
-    {
-      return false;
-    }
+      if ( this->private_->decode_clipped_[ j ] )
+      {
+        std::cout << "WARNING: Dimensions of the slices are not equal, clipping/padding image to fit dimensions of first image." <<std::endl;
+      }
 
-    if ( this->private_->slices_[ 0 ]->get_nx() != total_size.x() ||  this->private_->slices_[ 0 ]->get_ny() != total_size.y() )
-    {
-      std::cout << "WARNING: Dimensions of the slices are not equal, clipping/padding image to fit dimensions of first image." <<std::endl;
-      DataBlock::Clip( this->private_->slices_[ 0 ], this->private_->slices_[ 0 ], total_size.x(), total_size.y(), 1, 0.0 );
-    }
+      this->private_->input_bytes_ += static_cast<long long>( input_slice_size );
 
+      min = Min( min, this->private_->decode_min_[ j ] );
+      max = Max( max, this->private_->decode_max_[ j ] );
+      this->private_->schema_->set_min_max( min, max );
 
-    if (! this->private_->compute_min_max( this->private_->slices_[ 0 ], min, max ) )
-    {
-      error = "Could not compute min and max.";
-      return false;
+      if (! this->private_->process_slice( 0, error ) )
+      {
+        success = false;
+        break;
+      }
     }
+  }
 
-    this->private_->schema_->set_min_max( min, max );
+  this->private_->decoded_slices_.clear();
 
-        if (! this->private_->process_slice( 0, error ) )
-        {
-            return false;
-        }
+  if ( this->private_->single_pass_ )
+  {
+    std::string write_error;
+    if (! this->private_->wait_for_writes( write_error ) && success )
+    {
+      error = write_error;
+      success = false;
     }
+    this->private_->journal_.close();
+  }
+
+  if ( !success )
+  {
+    return false;
+  }
 
   // Save schema file to update min and max
   if (! this->private_->schema_->save( error ) )
@@ -1146,10 +1590,18 @@ bool LargeVolumeConverter::run_phase2( std::string& error )
     return false;
   }
 
+  // All bricks are final, the journal is no longer needed
+  if ( this->private_->single_pass_ )
+  {
+    boost::filesystem::remove( this->private_->get_journal_file_name() );
+  }
+
   this->private_->slices_.clear();
   this->private_->brick_level_.clear();
   this->private_->index_.clear();
 
+  this->private_->elapsed_seconds_ = static_cast<double>( ( 
+    boost::posix_time::microsec_clock::local_time() - start_time ).total_milliseconds() ) / 1000.0;
 
   return true;
 }
@@ -1206,6 +1658,11 @@ void LargeVolumeConverterPrivate::run_phase3_parallel( int thread_num, int num_t
 bool LargeVolumeConverter::run_phase3( std::string& error )
 {
   error = "";
+
+  // Bricks that were built in memory were already compressed when they were written
+  if ( this->private_->single_pass_ ) return true;
+
+  boost::posix_time::ptime start_time = boost::posix_time::microsec_clock::local_time();
   this->private_->success_ = true;
 
   Parallel parallel( boost::bind( &LargeVolumeConverterPrivate::run_phase3_parallel, this->private_, _1, _2, _3 ) );
@@ -1216,8 +1673,51 @@ bool LargeVolumeConverter::run_phase3( std::string& error )
         error = "Could not compress bricks.";
     }
 
+  this->private_->elapsed_seconds_ += static_cast<double>( ( 
+    boost::posix_time::microsec_clock::local_time() - start_time ).total_milliseconds() ) / 1000.0;
+
+  if ( this->private_->success_ )
+  {
+    // Measure the final size of the bricks
+    this->private_->output_bytes_ = 0;
+    size_t num_levels = this->private_->schema_->get_num_levels();
+    for ( size_t j = 0; j < num_levels; j++ )
+    {
+      IndexVector layout = this->private_->schema_->get_level_layout( j );
+      IndexVector::index_type num_bricks = layout[0] * layout[1] * layout[2];
+      for ( IndexVector::index_type k = 0; k < num_bricks; k++ )
+      {
+        boost::filesystem::path brick_file = this->private_->schema_->get_brick_file_name( BrickInfo( k, j ) );
+        if ( boost::filesystem::exists( brick_file ) )
+        {
+          this->private_->output_bytes_ += static_cast<long long>( boost::filesystem::file_size( brick_file ) );
+        }
+      }
+    }
+  }
+
   return this->private_->success_;
 }
 
+bool LargeVolumeConverter::is_single_pass() const
+{
+  return this->private_->single_pass_;
+}
+
+long long LargeVolumeConverter::get_input_bytes() const
+{
+  return this->private_->input_bytes_;
+}
+
+long long LargeVolumeConverter::get_output_bytes() const
+{
+  return this->private_->output_bytes_;
+}
+
+double LargeVolumeConverter::get_elapsed_seconds() const
+{
+  return this->private_->elapsed_seconds_;
+}
+
 
 } // end namespace
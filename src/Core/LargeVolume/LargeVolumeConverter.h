@@ -85,14 +85,38 @@ public:
   /// How much memory to devote to the conversion process
   void set_mem_limit( long long mem_limit );
 
+  /// SET_RESUME
+  /// Continue an interrupted conversion in an existing output directory. Bricks that were
+  /// completely written are not compressed and written again.
+  void set_resume( bool resume );
+
   /// RUN_PHASE2
-  /// Downsample and build bricks
+  /// Downsample and build bricks. If the bricks that are built at the same time fit within the
+  /// memory limit, bricks are built in memory and compressed and written once.
   bool run_phase2( std::string& error );
 
     /// RUN_PHASE3
-    /// Compress bricks
+    /// Compress bricks that were written in pieces by phase 2
     bool run_phase3( std::string& error );
 
+  /// IS_SINGLE_PASS
+  /// Whether phase 2 wrote final bricks, in which case phase 3 has nothing to do
+  bool is_single_pass() const;
+
+  // -- statistics --
+public:
+  /// GET_INPUT_BYTES
+  /// Number of bytes of image data that were decoded
+  long long get_input_bytes() const;
+
+  /// GET_OUTPUT_BYTES
+  /// Number of bytes that were written to brick files
+  long long get_output_bytes() const;
+
+  /// GET_ELAPSED_SECONDS
+  /// Time spent in phase 2 and 3
+  double get_elapsed_seconds() const;
+
   /// GET_SCHEMA
   /// Get information about bricking schema
   LargeVolumeSchemaHandle get_schema() const;
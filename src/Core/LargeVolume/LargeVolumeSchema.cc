@@ -26,8 +26,6 @@
  DEALINGS IN THE SOFTWARE.
  */
 
-#include <zlib.h>
-
 #include <limits>
 #include <fstream>
 #include <set>
@@ -44,23 +42,13 @@
 
 #include <Core/LargeVolume/LargeVolumeSchema.h>
 #include <Core/LargeVolume/LargeVolumeCache.h>
+#include <Core/LargeVolume/LargeVolumeCodec.h>
 
 namespace bfs=boost::filesystem;
 
 namespace Core
 {
 
-#ifdef Z_PREFIX
-  #define zlib_uLongf z_uLongf
-  #define zlib_Bytef z_Bytef
-  #define zlib_uncompress z_uncompress
-  #define zlib_compress2 z_compress2
-#else
-  #define zlib_uLongf uLongf
-  #define zlib_Bytef Bytef
-  #define zlib_uncompress uncompress
-  #define zlib_compress2 compress2
-#endif
 
 class LargeVolumeSchemaPrivate {
 
@@ -76,6 +64,8 @@ public:
     overlap_(0),
     data_type_(DataType::UNKNOWN_E),
     compression_(false),
+    codec_( "zlib" ),
+    filter_( LargeVolumeFilter::NONE_E ),
     little_endian_(DataBlock::IsLittleEndian()),
     downsample_x_( true ),
     downsample_y_( true ),
@@ -197,6 +187,8 @@ public:
   DataType data_type_;
 
   bool compression_;
+  std::string codec_;
+  LargeVolumeFilter filter_;
   bool little_endian_;
 
   bool downsample_x_;
@@ -488,6 +480,18 @@ bool LargeVolumeSchema::load( std::string& error)
       return false;
     }
 
+    // NOTE: Codec and filter are only used for writing bricks, each brick records how it was
+    // compressed. Older volume files do not contain these fields.
+    if ( values.find( "codec" ) != values.end() )
+    {
+      this->private_->codec_ = values[ "codec" ];
+    }
+
+    if ( values.find( "filter" ) != values.end() )
+    {
+      ImportFromString( values[ "filter" ], this->private_->filter_ );
+    }
+
     size_t level = 0;
 
     while ( values.find( "level" + ExportToString(level)) != values.end() )
@@ -541,6 +545,8 @@ bool LargeVolumeSchema::save( std::string& error ) const
     text_file << "endian: " << ( this->private_->little_endian_ ? "little" : "big" ) << std::endl;
     text_file << "min: " << ExportToString( this->private_->min_ ) << std::endl;
     text_file << "max: " << ExportToString( this->private_->max_ ) << std::endl;
+    text_file << "codec: " << this->private_->codec_ << std::endl;
+    text_file << "filter: " << ExportToString( this->private_->filter_ ) << std::endl;
 
     for (size_t j = 0 ; j < this->private_->levels_.size(); j++ )
     {
@@ -704,6 +710,28 @@ void LargeVolumeSchema::set_compression( bool compression )
   this->private_->compression_ = compression;
 }
 
+bool LargeVolumeSchema::set_codec( const std::string& codec, LargeVolumeFilter filter )
+{
+  if ( !LargeVolumeCodecRegistry::Instance()->get_codec( codec ) )
+  {
+    return false;
+  }
+
+  this->private_->codec_ = codec;
+  this->private_->filter_ = filter;
+  return true;
+}
+
+const std::string& LargeVolumeSchema::get_codec() const
+{
+  return this->private_->codec_;
+}
+
+LargeVolumeFilter LargeVolumeSchema::get_filter() const
+{
+  return this->private_->filter_;
+}
+
 void LargeVolumeSchema::compute_levels()
 {
   // Insert level 0:
@@ -793,32 +821,28 @@ bool LargeVolumeSchema::read_brick( DataBlockHandle& brick, const BrickInfo& bi,
   }
 
   size_t file_size = bfs::file_size( brick_file );
-  size_t brick_size = size[0] * size[1] * size[2] * GetSizeDataType( this->get_data_type() );
+  size_t element_size = GetSizeDataType( this->get_data_type() );
+  size_t brick_size = size[0] * size[1] * size[2] * element_size;
 
-  if ( brick_size > file_size )
+  // Check for a header first, as the size of the file alone does not identify a raw brick
+  bool encoded = false;
+  if ( file_size >= LargeVolumeBrickCodec::HEADER_SIZE_C )
   {
+    std::vector<char> header( LargeVolumeBrickCodec::HEADER_SIZE_C );
+    std::ifstream input( brick_file.string().c_str(), std::ios_base::in | std::ios_base::binary );
+    input.read( &header[ 0 ], header.size() );
+    encoded = input.good() && LargeVolumeBrickCodec::IsEncoded( &header[ 0 ], file_size, 
+      brick_size );
+  }
+
+  if ( !encoded && brick_size == file_size )
+  {
+    // Uncompressed brick without header
     try
     {
-      std::vector<char> buffer( file_size );
-
       std::ifstream input( brick_file.string().c_str(), std::ios_base::in | std::ios_base::binary );
-      input.read( &buffer[0],  file_size);
+      input.read( reinterpret_cast<char *>(brick->get_data()), brick_size );
       input.close();
-
-      zlib_uLongf brick_size_ul = brick_size;
-      if ( zlib_uncompress( reinterpret_cast<zlib_Bytef*>( brick->get_data() ), &brick_size_ul,
-        reinterpret_cast<zlib_Bytef*>(&buffer[0]), file_size ) != Z_OK)
-      {
-        error = "Could not decompress file '" + brick_file.string() + "'.";
-        return false;
-      }
-
-      if ( brick_size_ul != brick_size )
-      {
-        error = "Brick '" + brick_file.string() + "' contains invalid data.";
-        brick->clear();
-        return false;
-      }
     }
     catch ( ... )
     {
@@ -827,13 +851,45 @@ bool LargeVolumeSchema::read_brick( DataBlockHandle& brick, const BrickInfo& bi,
       return false;
     }
   }
-  else if ( brick_size == file_size )
+  else
   {
     try
     {
+      std::vector<char> buffer( file_size );
+
       std::ifstream input( brick_file.string().c_str(), std::ios_base::in | std::ios_base::binary );
-      input.read( reinterpret_cast<char *>(brick->get_data()), brick_size );
+      if ( file_size ) input.read( &buffer[0],  file_size);
       input.close();
+
+      std::string decode_error;
+      if ( encoded )
+      {
+        if ( !LargeVolumeBrickCodec::Decode( &buffer[ 0 ], file_size, 
+          reinterpret_cast<char*>( brick->get_data() ), brick_size, element_size, decode_error ) )
+        {
+          error = "Brick '" + brick_file.string() + "': " + decode_error;
+          brick->clear();
+          return false;
+        }
+      }
+      else if ( brick_size > file_size )
+      {
+        // Bricks written by older versions are plain zlib streams
+        LargeVolumeCodecHandle zlib_codec = LargeVolumeCodecRegistry::Instance()->get_codec( "zlib" );
+        if ( !zlib_codec->decompress( &buffer[ 0 ], file_size, 
+          reinterpret_cast<char*>( brick->get_data() ), brick_size ) )
+        {
+          error = "Could not decompress file '" + brick_file.string() + "'.";
+          brick->clear();
+          return false;
+        }
+      }
+      else
+      {
+        error = "Brick file is too large to be a brick.";
+        brick->clear();
+        return false;
+      }
     }
     catch ( ... )
     {
@@ -842,12 +898,6 @@ bool LargeVolumeSchema::read_brick( DataBlockHandle& brick, const BrickInfo& bi,
       return false;
     }
   }
-  else
-  {
-    error = "Brick file is too large to be a brick.";
-    brick->clear();
-    return false;
-  }
 
   if ( DataBlock::IsLittleEndian() != this->private_->little_endian_ )
   {
@@ -914,66 +964,61 @@ bool LargeVolumeSchema::write_brick( DataBlockHandle data_block, const BrickInfo
     return false;
   }
 
+  // NOTE: The brick is written under a temporary name first, so a brick file is either complete
+  // or missing, even if the process is interrupted.
   bfs::path brick_file = this->private_->get_brick_file_name( bi );
+  bfs::path temp_file = bfs::path( brick_file.string() + ".tmp" );
 
-  size_t brick_size = size[0] * size[1] * size[2] * GetSizeDataType( this->get_data_type() );
+  size_t element_size = GetSizeDataType( this->get_data_type() );
+  size_t brick_size = size[0] * size[1] * size[2] * element_size;
 
   if ( this->private_->compression_)
   {
-    std::vector<char> buffer( brick_size + 12 );
-    zlib_uLongf brick_size_ul = brick_size + 12;
-
-    int result = zlib_compress2( reinterpret_cast<zlib_Bytef*>( &buffer[0] ), &brick_size_ul,
-      reinterpret_cast<zlib_Bytef*>(data_block->get_data()), brick_size, Z_DEFAULT_COMPRESSION );
-    if (result != Z_OK )
+    std::vector<char> buffer;
+    std::string encode_error;
+    if ( !LargeVolumeBrickCodec::Encode( reinterpret_cast<char*>( data_block->get_data() ), 
+      brick_size, element_size, this->private_->codec_, this->private_->filter_, buffer, 
+      encode_error ) )
     {
-      error = "Could not compress file.";
+      error = "Could not compress file: " + encode_error;
       return false;
     }
 
-    if ( brick_size_ul < brick_size )
+    try
     {
-      // Compression succeeded
-      try
-      {
-        std::ofstream output( brick_file.string().c_str(), std::ios_base::trunc | std::ios_base::binary | std::ios_base::out );
-        output.write( &buffer[0], brick_size_ul );
-      }
-      catch ( ... )
-      {
-        error = "Could not write to file '" + brick_file.string() + "'.";
-        return false;
-      }
-
+      std::ofstream output( temp_file.string().c_str(), std::ios_base::trunc | std::ios_base::binary | std::ios_base::out );
+      output.write( &buffer[0], buffer.size() );
     }
-    else
+    catch ( ... )
     {
-      try
-      {
-        std::ofstream output( brick_file.string().c_str(), std::ios_base::trunc | std::ios_base::binary | std::ios_base::out );
-        output.write( reinterpret_cast<char *>( data_block->get_data() ) , brick_size );
-      }
-      catch ( ... )
-      {
-        error = "Could not write to file '" + brick_file.string() + "'.";
-        return false;
-      }
+      error = "Could not write to file '" + temp_file.string() + "'.";
+      return false;
     }
   }
   else
   {
     try
     {
-      std::ofstream output( brick_file.string().c_str(), std::ios_base::trunc | std::ios_base::binary | std::ios_base::out );
+      std::ofstream output( temp_file.string().c_str(), std::ios_base::trunc | std::ios_base::binary | std::ios_base::out );
       output.write( reinterpret_cast<char *>( data_block->get_data() ) , brick_size );
     }
     catch ( ... )
     {
-      error = "Could not write to file '" + brick_file.string() + "'.";
+      error = "Could not write to file '" + temp_file.string() + "'.";
       return false;
     }
   }
 
+  try
+  {
+    bfs::rename( temp_file, brick_file );
+  }
+  catch ( ... )
+  {
+    error = "Could not rename file '" + temp_file.string() + "'.";
+    return false;
+  }
+
   return true;
 }
 
@@ -1376,15 +1421,24 @@ void LargeVolumeSchemaPrivate::load_and_substitue_missing_bricks( std::vector<Br
       {
         // check parents
         BrickInfo parent = brick;
+        bool have_parent = false;
         while (this->schema_->get_parent( parent, parent ))
         {
 
           if (cache->mark_brick( this->schema_->shared_from_this(), parent ))
           {
             bricks_to_render[ parent.level_ ].insert( parent );
+            have_parent = true;
             break;
           }
         }
+
+        // Nothing to substitute, load the coarsest parent as well. The cache loads coarse 
+        // levels first, so a low resolution image becomes available quickly.
+        if (!have_parent && !( parent == brick ))
+        {
+          bricks_to_load.push_back( parent );
+        }
       }
       bricks_to_load.push_back( brick );
     }
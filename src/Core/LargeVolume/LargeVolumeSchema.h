@@ -37,6 +37,7 @@
 #include <Core/Geometry/GridTransform.h>
 #include <Core/DataBlock/DataType.h>
 #include <Core/DataBlock/DataBlock.h>
+#include <Core/LargeVolume/LargeVolumeCodec.h>
 
 // Boost includes
 #include <boost/shared_ptr.hpp>
@@ -221,6 +222,19 @@ public:
   /// Set whether data is compressed
   void set_compression( bool compression );
 
+  /// SET_CODEC
+  /// Set the codec and filter used for compressing bricks, returns false if the codec is not
+  /// available
+  bool set_codec( const std::string& codec, LargeVolumeFilter filter );
+
+  /// GET_CODEC
+  /// Get the name of the codec used for compressing bricks
+  const std::string& get_codec() const;
+
+  /// GET_FILTER
+  /// Get the filter that is applied before compressing bricks
+  LargeVolumeFilter get_filter() const;
+
   /// SET_MIN_MAX
   /// Set min and max values for the dataset
   void set_min_max( double min, double max ) const;
@@ -0,0 +1,236 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <string>
+
+#include <Core/LargeVolume/LargeVolumeCodec.h>
+
+using namespace Core;
+
+namespace
+{
+
+// Smooth 16 bit data with some noise, similar to microscopy data
+std::vector<char> MakeBrickData( size_t num_elements )
+{
+  std::vector<unsigned short> values( num_elements );
+  unsigned int seed = 12345;
+  for ( size_t j = 0; j < num_elements; j++ )
+  {
+    seed = seed * 1103515245 + 12345;
+    values[ j ] = static_cast<unsigned short>( 1000 + ( j % 512 ) * 8 + ( ( seed >> 16 ) & 0x7 ) );
+  }
+
+  const char* bytes = reinterpret_cast<const char*>( &values[ 0 ] );
+  return std::vector<char>( bytes, bytes + num_elements * sizeof( unsigned short ) );
+}
+
+// Codec that drops the trailing zero bytes of the data beyond a fixed size, used to produce
+// a payload of an exact size
+class TruncatingCodec : public LargeVolumeCodec
+{
+public:
+  TruncatingCodec( const std::string& name, unsigned char id, size_t payload_size ) : 
+    name_( name ), id_( id ), payload_size_( payload_size ) {}
+
+  virtual std::string get_name() const { return this->name_; }
+  virtual unsigned char get_id() const { return this->id_; }
+
+  virtual bool compress( const char* src, size_t src_size, std::vector<char>& dst ) const
+  {
+    if ( src_size < this->payload_size_ ) return false;
+    dst.assign( src, src + this->payload_size_ );
+    return true;
+  }
+
+  virtual bool decompress( const char* src, size_t src_size, char* dst, size_t dst_size ) const
+  {
+    if ( src_size > dst_size ) return false;
+    std::copy( src, src + src_size, dst );
+    std::fill( dst + src_size, dst + dst_size, 0 );
+    return true;
+  }
+
+private:
+  std::string name_;
+  unsigned char id_;
+  size_t payload_size_;
+};
+
+}
+
+TEST(LargeVolumeCodecTests, BuiltInCodecsAreRegistered)
+{
+  LargeVolumeCodecRegistry* registry = LargeVolumeCodecRegistry::Instance();
+  ASSERT_TRUE( registry->get_codec( "none" ) );
+  ASSERT_TRUE( registry->get_codec( "zlib" ) );
+  ASSERT_TRUE( registry->get_codec( "zlib-fast" ) );
+  ASSERT_EQ( registry->get_codec( "zlib" ), registry->get_codec( static_cast<unsigned char>( 1 ) ) );
+  ASSERT_FALSE( registry->get_codec( "does-not-exist" ) );
+}
+
+TEST(LargeVolumeCodecTests, RoundTripAllCodecsAndFilters)
+{
+  std::vector<char> data = MakeBrickData( 64 * 64 * 16 );
+  std::vector<std::string> codecs = LargeVolumeCodecRegistry::Instance()->get_codec_names();
+
+  const LargeVolumeFilter::enum_type filters[] = { LargeVolumeFilter::NONE_E, 
+    LargeVolumeFilter::SHUFFLE_E, LargeVolumeFilter::DELTA_E };
+
+  for ( size_t c = 0; c < codecs.size(); c++ )
+  {
+    for ( size_t f = 0; f < 3; f++ )
+    {
+      std::vector<char> encoded;
+      std::string error;
+      ASSERT_TRUE( LargeVolumeBrickCodec::Encode( &data[ 0 ], data.size(), 2, codecs[ c ], 
+        filters[ f ], encoded, error ) ) << error;
+      ASSERT_TRUE( LargeVolumeBrickCodec::IsEncoded( &encoded[ 0 ], encoded.size(), data.size() ) );
+
+      std::vector<char> decoded( data.size() );
+      ASSERT_TRUE( LargeVolumeBrickCodec::Decode( &encoded[ 0 ], encoded.size(), &decoded[ 0 ],
+        decoded.size(), 2, error ) ) << codecs[ c ] << ": " << error;
+      ASSERT_EQ( data, decoded ) << codecs[ c ] << " " << ExportToString( filters[ f ] );
+    }
+  }
+}
+
+TEST(LargeVolumeCodecTests, FilterImprovesCompressionOf16BitData)
+{
+  std::vector<char> data = MakeBrickData( 64 * 64 * 16 );
+  std::vector<char> plain, delta;
+  std::string error;
+
+  ASSERT_TRUE( LargeVolumeBrickCodec::Encode( &data[ 0 ], data.size(), 2, "zlib", 
+    LargeVolumeFilter::NONE_E, plain, error ) );
+  ASSERT_TRUE( LargeVolumeBrickCodec::Encode( &data[ 0 ], data.size(), 2, "zlib", 
+    LargeVolumeFilter::DELTA_E, delta, error ) );
+  ASSERT_LT( delta.size(), plain.size() );
+}
+
+TEST(LargeVolumeCodecTests, OddSizesRoundTrip)
+{
+  std::vector<char> data = MakeBrickData( 1001 );
+  data.push_back( 42 );
+
+  std::vector<char> encoded;
+  std::string error;
+  ASSERT_TRUE( LargeVolumeBrickCodec::Encode( &data[ 0 ], data.size(), 4, "zlib", 
+    LargeVolumeFilter::DELTA_E, encoded, error ) );
+
+  std::vector<char> decoded( data.size() );
+  ASSERT_TRUE( LargeVolumeBrickCodec::Decode( &encoded[ 0 ], encoded.size(), &decoded[ 0 ],
+    decoded.size(), 4, error ) ) << error;
+  ASSERT_EQ( data, decoded );
+}
+
+TEST(LargeVolumeCodecTests, IncompressibleDataIsStoredRaw)
+{
+  std::vector<char> data( 4096 );
+  unsigned int seed = 1;
+  for ( size_t j = 0; j < data.size(); j++ )
+  {
+    seed = seed * 1664525 + 1013904223;
+    data[ j ] = static_cast<char>( seed >> 24 );
+  }
+
+  std::vector<char> encoded;
+  std::string error;
+  ASSERT_TRUE( LargeVolumeBrickCodec::Encode( &data[ 0 ], data.size(), 1, "zlib", 
+    LargeVolumeFilter::SHUFFLE_E, encoded, error ) );
+  ASSERT_EQ( LargeVolumeBrickCodec::HEADER_SIZE_C + data.size(), encoded.size() );
+  ASSERT_EQ( "none", LargeVolumeBrickCodec::GetCodecName( &encoded[ 0 ] ) );
+}
+
+TEST(LargeVolumeCodecTests, CorruptBrickIsDetected)
+{
+  std::vector<char> data = MakeBrickData( 4096 );
+  std::vector<char> encoded;
+  std::string error;
+  ASSERT_TRUE( LargeVolumeBrickCodec::Encode( &data[ 0 ], data.size(), 2, "none", 
+    LargeVolumeFilter::NONE_E, encoded, error ) );
+
+  encoded[ LargeVolumeBrickCodec::HEADER_SIZE_C + 100 ] ^= 0x1;
+
+  std::vector<char> decoded( data.size() );
+  ASSERT_FALSE( LargeVolumeBrickCodec::Decode( &encoded[ 0 ], encoded.size(), &decoded[ 0 ],
+    decoded.size(), 2, error ) );
+}
+
+TEST(LargeVolumeCodecTests, LegacyBricksHaveNoHeader)
+{
+  std::vector<char> data = MakeBrickData( 4096 );
+  std::vector<char> compressed;
+  ASSERT_TRUE( LargeVolumeCodecRegistry::Instance()->get_codec( "zlib" )->compress( 
+    &data[ 0 ], data.size(), compressed ) );
+
+  ASSERT_FALSE( LargeVolumeBrickCodec::IsEncoded( &compressed[ 0 ], compressed.size(), data.size() ) );
+  ASSERT_FALSE( LargeVolumeBrickCodec::IsEncoded( &data[ 0 ], data.size(), data.size() ) );
+
+  std::vector<char> decoded( data.size() );
+  ASSERT_TRUE( LargeVolumeCodecRegistry::Instance()->get_codec( "zlib" )->decompress( 
+    &compressed[ 0 ], compressed.size(), &decoded[ 0 ], decoded.size() ) );
+  ASSERT_EQ( data, decoded );
+}
+
+TEST(LargeVolumeCodecTests, EncodedBrickNeverHasTheRawSize)
+{
+  // The payload plus the header is exactly as large as the raw data
+  std::vector<char> data( 4096, 0 );
+  for ( size_t j = 0; j < 1024; j++ ) data[ j ] = static_cast<char>( j % 251 );
+  size_t payload_size = data.size() - LargeVolumeBrickCodec::HEADER_SIZE_C;
+  LargeVolumeCodecRegistry::Instance()->register_codec( 
+    LargeVolumeCodecHandle( new TruncatingCodec( "truncate_exact", 200, payload_size ) ) );
+  LargeVolumeCodecRegistry::Instance()->register_codec( 
+    LargeVolumeCodecHandle( new TruncatingCodec( "truncate_smaller", 201, payload_size - 1 ) ) );
+
+  std::vector<char> encoded;
+  std::string error;
+  ASSERT_TRUE( LargeVolumeBrickCodec::Encode( &data[ 0 ], data.size(), 1, "truncate_exact", 
+    LargeVolumeFilter::NONE_E, encoded, error ) );
+  ASSERT_NE( data.size(), encoded.size() );
+  ASSERT_EQ( "none", LargeVolumeBrickCodec::GetCodecName( &encoded[ 0 ] ) );
+  ASSERT_TRUE( LargeVolumeBrickCodec::IsEncoded( &encoded[ 0 ], encoded.size(), data.size() ) );
+
+  std::vector<char> decoded( data.size() );
+  ASSERT_TRUE( LargeVolumeBrickCodec::Decode( &encoded[ 0 ], encoded.size(), &decoded[ 0 ],
+    decoded.size(), 1, error ) );
+  ASSERT_EQ( data, decoded );
+
+  // One byte less is stored compressed
+  ASSERT_TRUE( LargeVolumeBrickCodec::Encode( &data[ 0 ], data.size(), 1, "truncate_smaller", 
+    LargeVolumeFilter::NONE_E, encoded, error ) );
+  ASSERT_EQ( data.size() - 1, encoded.size() );
+  ASSERT_EQ( "truncate_smaller", LargeVolumeBrickCodec::GetCodecName( &encoded[ 0 ] ) );
+  ASSERT_TRUE( LargeVolumeBrickCodec::Decode( &encoded[ 0 ], encoded.size(), &decoded[ 0 ],
+    decoded.size(), 1, error ) );
+  ASSERT_EQ( data, decoded );
+}
@@ -80,6 +80,9 @@ public:
   // away, but the type is only know when the parser has validated and optimized
   // the expression tree
   std::vector< OutputDataBlock > data_block_data_;
+
+  // Whether the program computes in double precision
+  bool double_precision_;
 };
 
 ArrayMathEngine::ArrayMathEngine() :
@@ -98,6 +101,7 @@ void ArrayMathEngine::clear()
   this->private_->expression_.clear();
   this->private_->post_expression_.clear();
   this->private_->array_size_ = 1;
+  this->private_->double_precision_ = false;
 }
 
 bool ArrayMathEngine::add_input_data_block( std::string name, DataBlockHandle data_block, std::string& error )
@@ -274,6 +278,11 @@ bool ArrayMathEngine::add_expressions( std::string& expressions )
   return true;
 }
 
+void ArrayMathEngine::set_double_precision( bool double_precision )
+{
+  this->private_->double_precision_ = double_precision;
+}
+
 bool ArrayMathEngine::parse_and_validate( std::string& error )
 {
   // Link everything together
@@ -323,6 +332,13 @@ bool ArrayMathEngine::run( std::string& error )
     }
   }
 
+  // The precision determines the functions and buffers that are selected during translation
+  if ( !( this->create_program( this->private_->mprogram_, error ) ) )
+  {
+    return false;
+  }
+  this->private_->mprogram_->set_double_precision( this->private_->double_precision_ );
+
   // Translate the code
   if ( !( this->translate( this->private_->pprogram_, this->private_->mprogram_, error ) ) )
   {
@@ -64,6 +64,10 @@ public:
   /// Setup the expression                        
   bool add_expressions( std::string& expressions );
 
+  /// Compute the intermediate values in double instead of single precision. This is needed
+  /// to preserve the precision of 32 and 64 bit integer and double data.
+  void set_double_precision( bool double_precision );
+
   /// Parse and validate the inputs/outputs/expression.
   bool parse_and_validate( std::string& error );
 
@@ -33,10 +33,12 @@ namespace Core
 {
 
 ArrayMathFunction::ArrayMathFunction( ArrayMathFunctionObject function,
-    std::string function_id, std::string function_type, int function_flags ) :
+    ArrayMathFunctionObject double_function, std::string function_id, 
+    std::string function_type, int function_flags ) :
   ParserFunction( function_id, function_type, function_flags )
 {
   this->function_ = function;
+  this->double_function_ = double_function;
 }
 
 } // end namespace
@@ -47,9 +47,10 @@ namespace Core
 class ArrayMathFunction : public ParserFunction
 {
 public:
-  /// Build a new function
+  /// Build a new function, function operates on single precision buffers and
+  /// double_function on double precision buffers
   ArrayMathFunction(
-    ArrayMathFunctionObject function,
+    ArrayMathFunctionObject function, ArrayMathFunctionObject double_function,
     std::string function_id, std::string function_type, int function_flags );
 
   // Virtual destructor so I can do dynamic casts on this class 
@@ -61,15 +62,18 @@ public:
     return this->function_; 
   } */
 
-  ArrayMathFunctionObject get_function()
+  ArrayMathFunctionObject get_function( bool double_precision = false )
   {
-    return this->function_;
+    return double_precision ? this->double_function_ : this->function_;
   }
 
 private:
   /// The function to call that needs to be called on the data
   ArrayMathFunctionObject function_;
 
+  /// The same function for buffers in double precision
+  ArrayMathFunctionObject double_function_;
+
 };
 
 }
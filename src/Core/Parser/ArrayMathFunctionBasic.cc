@@ -26,6 +26,9 @@
  DEALINGS IN THE SOFTWARE.
  */
 
+// STL includes
+#include <cmath>
+
 // Core includes
 #include <Core/Parser/ArrayMathFunctionCatalog.h>
 
@@ -36,12 +39,13 @@ namespace ArrayMathFunctions
 // Add functions
 
 // Add scalar + scalar
+template< class T >
 bool add_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -58,12 +62,13 @@ bool add_ss( Core::ArrayMathProgramCode& pc )
 // Sub functions
 
 // Sub scalar - scalar
+template< class T >
 bool sub_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -80,11 +85,12 @@ bool sub_ss( Core::ArrayMathProgramCode& pc )
 // Neg functions
 
 // Negate scalar
+template< class T >
 bool neg_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data1_end = data1 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data1_end = data1 + pc.get_size();
 
   while ( data1 != data1_end )
   {
@@ -100,12 +106,13 @@ bool neg_s( Core::ArrayMathProgramCode& pc )
 // Mult functions
 
 // Mult scalar * scalar
+template< class T >
 bool mult_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -122,12 +129,13 @@ bool mult_ss( Core::ArrayMathProgramCode& pc )
 // Div functions
 
 // Div scalar / scalar
+template< class T >
 bool div_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -144,12 +152,13 @@ bool div_ss( Core::ArrayMathProgramCode& pc )
 // Rem functions
 
 // Rem scalar / scalar
+template< class T >
 bool rem_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -166,13 +175,14 @@ bool rem_ss( Core::ArrayMathProgramCode& pc )
 // Sequence functions (translation from arrays of size 1 into arrays of size n)
 
 // Sequence scalar
+template< class T >
 bool seq_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
-  float val = data1[ 0 ];
+  T val = data1[ 0 ];
   while ( data0 != data0_end )
   {
     *data0 = val;
@@ -185,13 +195,14 @@ bool seq_s( Core::ArrayMathProgramCode& pc )
 //--------------------------------------------------------------------------
 // Assign functions
 
+template< class T >
 bool assign_sss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data3 = pc.get_variable( 3 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data3 = pc.get_variable<T>( 3 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -211,12 +222,13 @@ bool assign_sss( Core::ArrayMathProgramCode& pc )
 // Subs functions
 
 // Subs scalar scalar
+template< class T >
 bool subs_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -232,13 +244,14 @@ bool subs_ss( Core::ArrayMathProgramCode& pc )
 }
 
 // Select functions
+template< class T >
 bool select_sss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data3 = pc.get_variable( 3 );
-  float* data1_end = data1 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data3 = pc.get_variable<T>( 3 );
+  T* data1_end = data1 + pc.get_size();
 
   while ( data1 != data1_end )
   {
@@ -259,6 +272,97 @@ bool select_sss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+//--------------------------------------------------------------------------
+// Fused functions
+
+// Elementwise operators that can be fused into one pass
+template< class T >
+struct AddOp
+{
+  static inline T apply( T a, T b ) { return a + b; }
+};
+
+template< class T >
+struct SubOp
+{
+  static inline T apply( T a, T b ) { return a - b; }
+};
+
+template< class T >
+struct MultOp
+{
+  static inline T apply( T a, T b ) { return a * b; }
+};
+
+template< class T >
+struct DivOp
+{
+  static inline T apply( T a, T b ) { return a / b; }
+};
+
+// Compute OP2( OP1( data1, data2 ), data3 ), or OP2( data3, OP1( data1, data2 ) ) if SWAP is
+// set, without storing the intermediate result in a buffer
+template< class T, class OP1, class OP2, bool SWAP >
+bool fused_sss( Core::ArrayMathProgramCode& pc )
+{
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data3 = pc.get_variable<T>( 3 );
+  T* data0_end = data0 + pc.get_size();
+
+  while ( data0 != data0_end )
+  {
+    T tmp = OP1::apply( *data1, *data2 );
+    *data0 = SWAP ? OP2::apply( *data3, tmp ) : OP2::apply( tmp, *data3 );
+    data0++;
+    data1++;
+    data2++;
+    data3++;
+  }
+
+  return true;
+}
+
+template< class T, class OP1, class OP2 >
+void get_fused_function( bool swap, Core::ArrayMathFunctionObject& function )
+{
+  if ( swap ) function = fused_sss< T, OP1, OP2, true >;
+  else function = fused_sss< T, OP1, OP2, false >;
+}
+
+template< class T, class OP1 >
+bool get_fused_function( const std::string& second_function_id, bool swap, 
+  Core::ArrayMathFunctionObject& function )
+{
+  if ( second_function_id == "add$S:S" ) 
+    get_fused_function< T, OP1, AddOp< T > >( swap, function );
+  else if ( second_function_id == "sub$S:S" ) 
+    get_fused_function< T, OP1, SubOp< T > >( swap, function );
+  else if ( second_function_id == "mult$S:S" ) 
+    get_fused_function< T, OP1, MultOp< T > >( swap, function );
+  else if ( second_function_id == "div$S:S" ) 
+    get_fused_function< T, OP1, DivOp< T > >( swap, function );
+  else 
+    return false;
+  return true;
+}
+
+template< class T >
+bool get_fused_function( const std::string& first_function_id, 
+  const std::string& second_function_id, bool swap, Core::ArrayMathFunctionObject& function )
+{
+  if ( first_function_id == "add$S:S" ) 
+    return get_fused_function< T, AddOp< T > >( second_function_id, swap, function );
+  if ( first_function_id == "sub$S:S" ) 
+    return get_fused_function< T, SubOp< T > >( second_function_id, swap, function );
+  if ( first_function_id == "mult$S:S" ) 
+    return get_fused_function< T, MultOp< T > >( second_function_id, swap, function );
+  if ( first_function_id == "div$S:S" ) 
+    return get_fused_function< T, DivOp< T > >( second_function_id, swap, function );
+  return false;
+}
+
 } // end namsespace 
 
 namespace Core
@@ -267,33 +371,56 @@ namespace Core
 void InsertBasicArrayMathFunctionCatalog( ArrayMathFunctionCatalogHandle& catalog )
 {
   // Add add functions to database
-  catalog->add_sym_function( ArrayMathFunctions::add_ss, "add$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::add_ss<float>,
+    ArrayMathFunctions::add_ss<double>, "add$S:S", "S" );
 
   // Add sub functions to database
-  catalog->add_function( ArrayMathFunctions::sub_ss, "sub$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::sub_ss<float>,
+    ArrayMathFunctions::sub_ss<double>, "sub$S:S", "S" );
 
   // Add neg function to database
-  catalog->add_function( ArrayMathFunctions::neg_s, "neg$S", "S" );
+  catalog->add_function( ArrayMathFunctions::neg_s<float>,
+    ArrayMathFunctions::neg_s<double>, "neg$S", "S" );
 
   // Add mult functions to database
-  catalog->add_sym_function( ArrayMathFunctions::mult_ss, "mult$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::mult_ss<float>,
+    ArrayMathFunctions::mult_ss<double>, "mult$S:S", "S" );
 
   // Add div functions to database
-  catalog->add_function( ArrayMathFunctions::div_ss, "div$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::div_ss<float>,
+    ArrayMathFunctions::div_ss<double>, "div$S:S", "S" );
 
   // Add rem functions to database
-  catalog->add_function( ArrayMathFunctions::rem_ss, "rem$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::rem_ss<float>,
+    ArrayMathFunctions::rem_ss<double>, "rem$S:S", "S" );
 
   // Add assign functions to database
-  catalog->add_function( ArrayMathFunctions::assign_sss, "assign$S:S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::assign_sss<float>,
+    ArrayMathFunctions::assign_sss<double>, "assign$S:S:S", "S" );
 
   // Add subs functions to database
-  catalog->add_function( ArrayMathFunctions::subs_ss, "subs$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::subs_ss<float>,
+    ArrayMathFunctions::subs_ss<double>, "subs$S:S", "S" );
 
   // Add sequencer code: translate from single to sequence of data
-  catalog->add_function( ArrayMathFunctions::seq_s, "seq$S", "S" );
+  catalog->add_function( ArrayMathFunctions::seq_s<float>,
+    ArrayMathFunctions::seq_s<double>, "seq$S", "S" );
 
-  catalog->add_function( ArrayMathFunctions::select_sss, "select$S:S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::select_sss<float>,
+    ArrayMathFunctions::select_sss<double>, "select$S:S:S", "S" );
+}
+
+bool GetFusedArrayMathFunction( const std::string& first_function_id, 
+  const std::string& second_function_id, bool swap, bool double_precision,
+  ArrayMathFunctionObject& function )
+{
+  if ( double_precision )
+  {
+    return ArrayMathFunctions::get_fused_function< double >( first_function_id, 
+      second_function_id, swap, function );
+  }
+  return ArrayMathFunctions::get_fused_function< float >( first_function_id, 
+    second_function_id, swap, function );
 }
 
 } // end namespace
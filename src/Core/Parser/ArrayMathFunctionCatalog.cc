@@ -66,11 +66,11 @@ ParserFunctionCatalogHandle ArrayMathFunctionCatalog::get_catalog()
 // the main catalog. This way we can distribute the function definitions
 // into different classes
 void ArrayMathFunctionCatalog::add_function( ArrayMathFunctionObject function,
-    std::string function_id, std::string return_type )
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type )
 {
   // Adding function to catalog
-  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, function_id, return_type,
-      0 ) );
+  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, double_function,
+    function_id, return_type, 0 ) );
 }
 
 // A symmetric function can have its arguments entered in any combination
@@ -79,35 +79,35 @@ void ArrayMathFunctionCatalog::add_function( ArrayMathFunctionObject function,
 // calls
 
 void ArrayMathFunctionCatalog::add_sym_function( ArrayMathFunctionObject function,
-    std::string function_id, std::string return_type )
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type )
 {
   // Adding function to catalog
-  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, function_id, return_type,
-      PARSER_SYMMETRIC_FUNCTION_E ) );
+  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, double_function,
+    function_id, return_type, PARSER_SYMMETRIC_FUNCTION_E ) );
 }
 
 void ArrayMathFunctionCatalog::add_seq_function( ArrayMathFunctionObject function,
-    std::string function_id, std::string return_type )
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type )
 {
   // Adding function to catalog
-  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, function_id, return_type,
-      PARSER_SEQUENTIAL_FUNCTION_E ) );
+  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, double_function,
+    function_id, return_type, PARSER_SEQUENTIAL_FUNCTION_E ) );
 }
 
 void ArrayMathFunctionCatalog::add_sgl_function( ArrayMathFunctionObject function,
-    std::string function_id, std::string return_type )
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type )
 {
   // Adding function to catalog
-  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, function_id, return_type,
-      PARSER_SINGLE_FUNCTION_E ) );
+  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, double_function,
+    function_id, return_type, PARSER_SINGLE_FUNCTION_E ) );
 }
 
 void ArrayMathFunctionCatalog::add_cst_function( ArrayMathFunctionObject function,
-    std::string function_id, std::string return_type )
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type )
 {
   // Adding function to catalog
-  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, function_id, return_type,
-      PARSER_CONST_FUNCTION_E ) );
+  ParserFunctionCatalog::add_function( new ArrayMathFunction( function, double_function,
+    function_id, return_type, PARSER_CONST_FUNCTION_E ) );
 }
 
 }
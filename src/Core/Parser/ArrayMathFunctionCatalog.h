@@ -51,27 +51,27 @@ public:
   ArrayMathFunctionCatalog()  {}
 
   /// Add a function to the general database
-  void add_function( ArrayMathFunctionObject function, std::string function_id,
-      std::string return_type );
+  void add_function( ArrayMathFunctionObject function, 
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type );
 
   /// Add a function whose input variables can be in any particular order,
   /// e.g. addition, this will allow the optimizer to recognize that two pieces
   /// of the parser tree are equal e.g A+B equals B+A
-  void add_sym_function( ArrayMathFunctionObject function, std::string function_id,
-      std::string return_type );
+  void add_sym_function( ArrayMathFunctionObject function, 
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type );
 
   /// Add a function that independently of the input will output a sequence
   /// e.g. the rand function, will always generate a sequence
-  void add_seq_function( ArrayMathFunctionObject function, std::string function_id,
-      std::string return_type );
+  void add_seq_function( ArrayMathFunctionObject function, 
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type );
 
   /// Add a function that will always output a single
-  void add_sgl_function( ArrayMathFunctionObject function, std::string function_id,
-      std::string return_type );
+  void add_sgl_function( ArrayMathFunctionObject function, 
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type );
 
   /// Add a function that is always a constant
-  void add_cst_function( ArrayMathFunctionObject function, std::string function_id,
-    std::string return_type );
+  void add_cst_function( ArrayMathFunctionObject function, 
+    ArrayMathFunctionObject double_function, std::string function_id, std::string return_type );
 
   static ParserFunctionCatalogHandle get_catalog();
 };
@@ -84,6 +84,15 @@ void InsertBasicArrayMathFunctionCatalog( ArrayMathFunctionCatalogHandle& catalo
 void InsertSourceSinkArrayMathFunctionCatalog( ArrayMathFunctionCatalogHandle& catalog );
 void InsertScalarArrayMathFunctionCatalog( ArrayMathFunctionCatalogHandle& catalog );
 
+/// Get a function that evaluates two consecutive elementwise functions in one pass over the
+/// buffers. The result of the first function is the first (or if swap is set the second) input
+/// of the second function. The fused function takes the output of the second function, the two
+/// inputs of the first function and the other input of the second function as variables.
+/// Returns false if these functions cannot be fused.
+bool GetFusedArrayMathFunction( const std::string& first_function_id, 
+  const std::string& second_function_id, bool swap, bool double_precision,
+  ArrayMathFunctionObject& function );
+
 }
 
 #endif
@@ -26,6 +26,9 @@
  DEALINGS IN THE SOFTWARE.
  */
 
+// STL includes
+#include <cmath>
+
 // Boost includes
 #include <boost/thread/mutex.hpp>
 
@@ -40,11 +43,12 @@ namespace ArrayMathFunctions
 //--------------------------------------------------------------------------
 // Simple Scalar functions
 
+template< class T >
 bool isnan_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -57,11 +61,12 @@ bool isnan_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool isfinite_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -74,11 +79,12 @@ bool isfinite_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool isinfinite_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -91,11 +97,12 @@ bool isinfinite_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool sign_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -109,18 +116,19 @@ bool sign_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool ramp_sss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data3 = pc.get_variable( 3 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data3 = pc.get_variable<T>( 3 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    float start = *data2;
-    float end = *data3;
+    T start = *data2;
+    T end = *data3;
     if ( end > start )
     {
       if ( *data1 <= start ) *data0 = 0.0f;
@@ -142,18 +150,19 @@ bool ramp_sss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool rect_sss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data3 = pc.get_variable( 3 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data3 = pc.get_variable<T>( 3 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    float start = *data2;
-    float end = *data3;
+    T start = *data2;
+    T end = *data3;
     if ( *data1 >= start && *data1 <= end ) *data0 = 1.0f;
     else *data0 = 0.0f;
     data0++;
@@ -165,16 +174,17 @@ bool rect_sss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool step_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    float step = *data2;
+    T step = *data2;
     if ( *data1 >= step ) *data0 = 1.0f;
     else *data0 = 0.0f;
     data0++;
@@ -185,11 +195,12 @@ bool step_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool not_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -202,11 +213,12 @@ bool not_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool inv_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -218,11 +230,12 @@ bool inv_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool boolean_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -235,11 +248,12 @@ bool boolean_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool abs_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -252,11 +266,12 @@ bool abs_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool norm_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -269,15 +284,16 @@ bool norm_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool round_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = static_cast< float > ( static_cast< int > ( *data1 + 0.5f ) );
+    *data0 = static_cast< T >( static_cast< int > ( *data1 + 0.5f ) );
     data0++;
     data1++;
   }
@@ -285,15 +301,16 @@ bool round_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool floor_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::floorf( *data1 );
+    *data0 = std::floor( *data1 );
     data0++;
     data1++;
   }
@@ -301,15 +318,16 @@ bool floor_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool ceil_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::ceilf( *data1 );
+    *data0 = std::ceil( *data1 );
     data0++;
     data1++;
   }
@@ -317,15 +335,16 @@ bool ceil_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool exp_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::expf( *data1 );
+    *data0 = std::exp( *data1 );
     data0++;
     data1++;
   }
@@ -333,16 +352,17 @@ bool exp_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool pow_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::powf( *data1, *data2 );
+    *data0 = std::pow( *data1, *data2 );
     data0++;
     data1++;
     data2++;
@@ -351,15 +371,16 @@ bool pow_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool sqrt_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::sqrtf( *data1 );
+    *data0 = std::sqrt( *data1 );
     data0++;
     data1++;
   }
@@ -367,15 +388,16 @@ bool sqrt_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool log_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::logf( *data1 );
+    *data0 = std::log( *data1 );
     data0++;
     data1++;
   }
@@ -383,15 +405,16 @@ bool log_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool ln_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::logf( *data1 );
+    *data0 = std::log( *data1 );
     data0++;
     data1++;
   }
@@ -399,16 +422,17 @@ bool ln_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool log2_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
-  float s = 1.0f / ::logf( 2.0f );
+  T s = T( 1 ) / std::log( T( 2 ) );
   while ( data0 != data0_end )
   {
-    *data0 = ::logf( *data1 ) * s;
+    *data0 = std::log( *data1 ) * s;
     data0++;
     data1++;
   }
@@ -416,16 +440,17 @@ bool log2_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool log10_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
-  float s = 1.0f / logf( 10.0f );
+  T s = T( 1 ) / std::log( T( 10 ) );
   while ( data0 != data0_end )
   {
-    *data0 = ::logf( *data1 ) * s;
+    *data0 = std::log( *data1 ) * s;
     data0++;
     data1++;
   }
@@ -433,15 +458,16 @@ bool log10_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool cbrt_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::powf( *data1, 1.0f / 3.0f );
+    *data0 = std::pow( *data1, T( 1 ) / T( 3 ) );
     data0++;
     data1++;
   }
@@ -449,15 +475,16 @@ bool cbrt_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool sin_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::sinf( *data1 );
+    *data0 = std::sin( *data1 );
     data0++;
     data1++;
   }
@@ -465,15 +492,16 @@ bool sin_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool cos_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::cosf( *data1 );
+    *data0 = std::cos( *data1 );
     data0++;
     data1++;
   }
@@ -481,15 +509,16 @@ bool cos_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool tan_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::tanf( *data1 );
+    *data0 = std::tan( *data1 );
     data0++;
     data1++;
   }
@@ -497,15 +526,16 @@ bool tan_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool sinh_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::sinhf( *data1 );
+    *data0 = std::sinh( *data1 );
     data0++;
     data1++;
   }
@@ -513,15 +543,16 @@ bool sinh_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool cosh_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::coshf( *data1 );
+    *data0 = std::cosh( *data1 );
     data0++;
     data1++;
   }
@@ -529,15 +560,16 @@ bool cosh_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool asin_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::asinf( *data1 );
+    *data0 = std::asin( *data1 );
     data0++;
     data1++;
   }
@@ -545,15 +577,16 @@ bool asin_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool acos_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::acosf( *data1 );
+    *data0 = std::acos( *data1 );
     data0++;
     data1++;
   }
@@ -561,15 +594,16 @@ bool acos_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool atan_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::atanf( *data1 );
+    *data0 = std::atan( *data1 );
     data0++;
     data1++;
   }
@@ -577,16 +611,17 @@ bool atan_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool atan2_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    *data0 = ::atan2f( *data1, *data2 );
+    *data0 = std::atan2( *data1, *data2 );
     data0++;
     data1++;
     data2++;
@@ -595,17 +630,18 @@ bool atan2_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool asinh_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    float d = *data1;
-    *data0 = ( d == 0.0f ? 0.0f : ( d > 0.0f ? 1.0f : -1.0f ) ) * ::logf( ( d < 0.0f ? -d : d ) 
-      + ::sqrtf( 1.f + d * d ) );
+    T d = *data1;
+    *data0 = ( d == 0.0f ? 0.0f : ( d > 0.0f ? 1.0f : -1.0f ) ) * std::log( ( d < 0.0f ? -d : d ) 
+      + std::sqrt( 1.f + d * d ) );
     data0++;
     data1++;
   }
@@ -613,16 +649,17 @@ bool asinh_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool acosh_s( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
-    float d = *data1;
-    *data0 = ::log( d + ::sqrtf( d * d - 1.0f ) );
+    T d = *data1;
+    *data0 = std::log( d + std::sqrt( d * d - 1.0f ) );
     data0++;
     data1++;
   }
@@ -630,12 +667,13 @@ bool acosh_s( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool or_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -648,12 +686,13 @@ bool or_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool and_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -666,12 +705,13 @@ bool and_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool xor_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -685,12 +725,13 @@ bool xor_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool eq_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -704,12 +745,13 @@ bool eq_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool neq_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -723,12 +765,13 @@ bool neq_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool le_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -742,12 +785,13 @@ bool le_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool ge_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -761,12 +805,13 @@ bool ge_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool ls_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -780,12 +825,13 @@ bool ls_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool gt_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -799,12 +845,13 @@ bool gt_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool max_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -818,13 +865,14 @@ bool max_ss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool median_sss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data3 = pc.get_variable( 3 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data3 = pc.get_variable<T>( 3 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -861,12 +909,13 @@ bool median_sss( Core::ArrayMathProgramCode& pc )
   return true;
 }
 
+template< class T >
 bool min_ss( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data1 = pc.get_variable( 1 );
-  float* data2 = pc.get_variable( 2 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data1 = pc.get_variable<T>( 1 );
+  T* data2 = pc.get_variable<T>( 2 );
+  T* data0_end = data0 + pc.get_size();
 
   while ( data0 != data0_end )
   {
@@ -882,10 +931,11 @@ bool min_ss( Core::ArrayMathProgramCode& pc )
 
 boost::mutex RandomMutex;
 
+template< class T >
 bool random_value_( Core::ArrayMathProgramCode& pc )
 {
-  float* data0 = pc.get_variable( 0 );
-  float* data0_end = data0 + pc.get_size();
+  T* data0 = pc.get_variable<T>( 0 );
+  T* data0_end = data0 + pc.get_size();
 
   // Random is not thread safe
   RandomMutex.lock();
@@ -895,9 +945,9 @@ bool random_value_( Core::ArrayMathProgramCode& pc )
     // (see http://msdn.microsoft.com/en-us/library/b0084kay.aspx).
 #ifdef _WIN32
     // random() not available in Windows stdlib
-    *data0 = static_cast< float >( rand() ) / static_cast< float >( RAND_MAX + 1 );
+    *data0 = static_cast< T >( rand() ) / static_cast< T >( RAND_MAX + 1 );
 #else
-    *data0 = static_cast< float > ( random() ) / static_cast< float > ( 0x7FFFFFFF );
+    *data0 = static_cast< T >( random() ) / static_cast< T >( 0x7FFFFFFF );
 #endif
     data0++;
   }
@@ -914,61 +964,112 @@ namespace Core
 void InsertScalarArrayMathFunctionCatalog( ArrayMathFunctionCatalogHandle& catalog )
 {
   // Functions
-  catalog->add_function( ArrayMathFunctions::isnan_s, "isnan$S", "S" );
-  catalog->add_function( ArrayMathFunctions::isfinite_s, "isfinite$S", "S" );
-  catalog->add_function( ArrayMathFunctions::isinfinite_s, "isinfinite$S", "S" );
-  catalog->add_function( ArrayMathFunctions::isinfinite_s, "isinf$S", "S" );
-  catalog->add_function( ArrayMathFunctions::sign_s, "sign$S", "S" );
-  catalog->add_function( ArrayMathFunctions::ramp_sss, "ramp$S:S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::rect_sss, "rect$S:S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::step_ss, "step$S:S", "S" );
-
-  catalog->add_function( ArrayMathFunctions::not_s, "not$S", "S" );
-  catalog->add_function( ArrayMathFunctions::inv_s, "inv$S", "S" );
-  catalog->add_function( ArrayMathFunctions::boolean_s, "boolean$S", "S" );
-  catalog->add_function( ArrayMathFunctions::abs_s, "abs$S", "S" );
-  catalog->add_function( ArrayMathFunctions::norm_s, "norm$S", "S" );
-  catalog->add_function( ArrayMathFunctions::round_s, "round$S", "S" );
-  catalog->add_function( ArrayMathFunctions::floor_s, "floor$S", "S" );
-  catalog->add_function( ArrayMathFunctions::ceil_s, "ceil$S", "S" );
-  catalog->add_function( ArrayMathFunctions::exp_s, "exp$S", "S" );
-  catalog->add_function( ArrayMathFunctions::pow_ss, "pow$S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::sqrt_s, "sqrt$S", "S" );
-  catalog->add_function( ArrayMathFunctions::log_s, "log$S", "S" );
-  catalog->add_function( ArrayMathFunctions::ln_s, "ln$S", "S" );
-  catalog->add_function( ArrayMathFunctions::log2_s, "log2$S", "S" );
-  catalog->add_function( ArrayMathFunctions::log10_s, "log10$S", "S" );
-  catalog->add_function( ArrayMathFunctions::cbrt_s, "cbrt$S", "S" );
-  catalog->add_function( ArrayMathFunctions::sin_s, "sin$S", "S" );
-  catalog->add_function( ArrayMathFunctions::cos_s, "cos$S", "S" );
-  catalog->add_function( ArrayMathFunctions::tan_s, "tan$S", "S" );
-  catalog->add_function( ArrayMathFunctions::sinh_s, "sinh$S", "S" );
-  catalog->add_function( ArrayMathFunctions::cosh_s, "cosh$S", "S" );
-  catalog->add_function( ArrayMathFunctions::asin_s, "asin$S", "S" );
-  catalog->add_function( ArrayMathFunctions::acos_s, "acos$S", "S" );
-  catalog->add_function( ArrayMathFunctions::atan_s, "atan$S", "S" );
-  catalog->add_function( ArrayMathFunctions::atan2_ss, "atan2$S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::asinh_s, "asinh$S", "S" );
-  catalog->add_function( ArrayMathFunctions::acosh_s, "acosh$S", "S" );
-
-  catalog->add_sym_function( ArrayMathFunctions::and_ss, "and$S:S", "S" );
-  catalog->add_sym_function( ArrayMathFunctions::and_ss, "bitand$S:S", "S" );
-  catalog->add_sym_function( ArrayMathFunctions::xor_ss, "xor$S:S", "S" );
-  catalog->add_sym_function( ArrayMathFunctions::or_ss, "or$S:S", "S" );
-  catalog->add_sym_function( ArrayMathFunctions::or_ss, "bitor$S:S", "S" );
-  catalog->add_sym_function( ArrayMathFunctions::eq_ss, "eq$S:S", "S" );
-  catalog->add_sym_function( ArrayMathFunctions::neq_ss, "neq$S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::le_ss, "le$S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::ge_ss, "ge$S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::ls_ss, "ls$S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::gt_ss, "gt$S:S", "S" );
-
-  catalog->add_sym_function( ArrayMathFunctions::min_ss, "min$S:S", "S" );
-  catalog->add_sym_function( ArrayMathFunctions::max_ss, "max$S:S", "S" );
-  catalog->add_function( ArrayMathFunctions::median_sss, "median$S:S:S", "S" );
-
-  catalog->add_sgl_function( ArrayMathFunctions::random_value_, "rand$", "S" );
-  catalog->add_seq_function( ArrayMathFunctions::random_value_, "randv$", "S" );
+  catalog->add_function( ArrayMathFunctions::isnan_s<float>,
+    ArrayMathFunctions::isnan_s<double>, "isnan$S", "S" );
+  catalog->add_function( ArrayMathFunctions::isfinite_s<float>,
+    ArrayMathFunctions::isfinite_s<double>, "isfinite$S", "S" );
+  catalog->add_function( ArrayMathFunctions::isinfinite_s<float>,
+    ArrayMathFunctions::isinfinite_s<double>, "isinfinite$S", "S" );
+  catalog->add_function( ArrayMathFunctions::isinfinite_s<float>,
+    ArrayMathFunctions::isinfinite_s<double>, "isinf$S", "S" );
+  catalog->add_function( ArrayMathFunctions::sign_s<float>,
+    ArrayMathFunctions::sign_s<double>, "sign$S", "S" );
+  catalog->add_function( ArrayMathFunctions::ramp_sss<float>,
+    ArrayMathFunctions::ramp_sss<double>, "ramp$S:S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::rect_sss<float>,
+    ArrayMathFunctions::rect_sss<double>, "rect$S:S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::step_ss<float>,
+    ArrayMathFunctions::step_ss<double>, "step$S:S", "S" );
+
+  catalog->add_function( ArrayMathFunctions::not_s<float>,
+    ArrayMathFunctions::not_s<double>, "not$S", "S" );
+  catalog->add_function( ArrayMathFunctions::inv_s<float>,
+    ArrayMathFunctions::inv_s<double>, "inv$S", "S" );
+  catalog->add_function( ArrayMathFunctions::boolean_s<float>,
+    ArrayMathFunctions::boolean_s<double>, "boolean$S", "S" );
+  catalog->add_function( ArrayMathFunctions::abs_s<float>,
+    ArrayMathFunctions::abs_s<double>, "abs$S", "S" );
+  catalog->add_function( ArrayMathFunctions::norm_s<float>,
+    ArrayMathFunctions::norm_s<double>, "norm$S", "S" );
+  catalog->add_function( ArrayMathFunctions::round_s<float>,
+    ArrayMathFunctions::round_s<double>, "round$S", "S" );
+  catalog->add_function( ArrayMathFunctions::floor_s<float>,
+    ArrayMathFunctions::floor_s<double>, "floor$S", "S" );
+  catalog->add_function( ArrayMathFunctions::ceil_s<float>,
+    ArrayMathFunctions::ceil_s<double>, "ceil$S", "S" );
+  catalog->add_function( ArrayMathFunctions::exp_s<float>,
+    ArrayMathFunctions::exp_s<double>, "exp$S", "S" );
+  catalog->add_function( ArrayMathFunctions::pow_ss<float>,
+    ArrayMathFunctions::pow_ss<double>, "pow$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::sqrt_s<float>,
+    ArrayMathFunctions::sqrt_s<double>, "sqrt$S", "S" );
+  catalog->add_function( ArrayMathFunctions::log_s<float>,
+    ArrayMathFunctions::log_s<double>, "log$S", "S" );
+  catalog->add_function( ArrayMathFunctions::ln_s<float>,
+    ArrayMathFunctions::ln_s<double>, "ln$S", "S" );
+  catalog->add_function( ArrayMathFunctions::log2_s<float>,
+    ArrayMathFunctions::log2_s<double>, "log2$S", "S" );
+  catalog->add_function( ArrayMathFunctions::log10_s<float>,
+    ArrayMathFunctions::log10_s<double>, "log10$S", "S" );
+  catalog->add_function( ArrayMathFunctions::cbrt_s<float>,
+    ArrayMathFunctions::cbrt_s<double>, "cbrt$S", "S" );
+  catalog->add_function( ArrayMathFunctions::sin_s<float>,
+    ArrayMathFunctions::sin_s<double>, "sin$S", "S" );
+  catalog->add_function( ArrayMathFunctions::cos_s<float>,
+    ArrayMathFunctions::cos_s<double>, "cos$S", "S" );
+  catalog->add_function( ArrayMathFunctions::tan_s<float>,
+    ArrayMathFunctions::tan_s<double>, "tan$S", "S" );
+  catalog->add_function( ArrayMathFunctions::sinh_s<float>,
+    ArrayMathFunctions::sinh_s<double>, "sinh$S", "S" );
+  catalog->add_function( ArrayMathFunctions::cosh_s<float>,
+    ArrayMathFunctions::cosh_s<double>, "cosh$S", "S" );
+  catalog->add_function( ArrayMathFunctions::asin_s<float>,
+    ArrayMathFunctions::asin_s<double>, "asin$S", "S" );
+  catalog->add_function( ArrayMathFunctions::acos_s<float>,
+    ArrayMathFunctions::acos_s<double>, "acos$S", "S" );
+  catalog->add_function( ArrayMathFunctions::atan_s<float>,
+    ArrayMathFunctions::atan_s<double>, "atan$S", "S" );
+  catalog->add_function( ArrayMathFunctions::atan2_ss<float>,
+    ArrayMathFunctions::atan2_ss<double>, "atan2$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::asinh_s<float>,
+    ArrayMathFunctions::asinh_s<double>, "asinh$S", "S" );
+  catalog->add_function( ArrayMathFunctions::acosh_s<float>,
+    ArrayMathFunctions::acosh_s<double>, "acosh$S", "S" );
+
+  catalog->add_sym_function( ArrayMathFunctions::and_ss<float>,
+    ArrayMathFunctions::and_ss<double>, "and$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::and_ss<float>,
+    ArrayMathFunctions::and_ss<double>, "bitand$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::xor_ss<float>,
+    ArrayMathFunctions::xor_ss<double>, "xor$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::or_ss<float>,
+    ArrayMathFunctions::or_ss<double>, "or$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::or_ss<float>,
+    ArrayMathFunctions::or_ss<double>, "bitor$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::eq_ss<float>,
+    ArrayMathFunctions::eq_ss<double>, "eq$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::neq_ss<float>,
+    ArrayMathFunctions::neq_ss<double>, "neq$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::le_ss<float>,
+    ArrayMathFunctions::le_ss<double>, "le$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::ge_ss<float>,
+    ArrayMathFunctions::ge_ss<double>, "ge$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::ls_ss<float>,
+    ArrayMathFunctions::ls_ss<double>, "ls$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::gt_ss<float>,
+    ArrayMathFunctions::gt_ss<double>, "gt$S:S", "S" );
+
+  catalog->add_sym_function( ArrayMathFunctions::min_ss<float>,
+    ArrayMathFunctions::min_ss<double>, "min$S:S", "S" );
+  catalog->add_sym_function( ArrayMathFunctions::max_ss<float>,
+    ArrayMathFunctions::max_ss<double>, "max$S:S", "S" );
+  catalog->add_function( ArrayMathFunctions::median_sss<float>,
+    ArrayMathFunctions::median_sss<double>, "median$S:S:S", "S" );
+
+  catalog->add_sgl_function( ArrayMathFunctions::random_value_<float>,
+    ArrayMathFunctions::random_value_<double>, "rand$", "S" );
+  catalog->add_seq_function( ArrayMathFunctions::random_value_<float>,
+    ArrayMathFunctions::random_value_<double>, "randv$", "S" );
 }
 
 } // end namespace
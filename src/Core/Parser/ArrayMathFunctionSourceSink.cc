@@ -26,6 +26,10 @@
  DEALINGS IN THE SOFTWARE.
  */
 
+// STL includes
+#include <cmath>
+#include <limits>
+
 // Core includes
 #include <Core/DataBlock/DataBlock.h>
 #include <Core/DataBlock/MaskDataBlock.h>
@@ -34,55 +38,110 @@
 namespace ArrayMathFunctions
 {
 
+//--------------------------------------------------------------------------
+// Typed copy kernels
+// The type of the data block is resolved once per buffer, after which the values are converted
+// in a tight loop that the compiler can vectorize.
+
+template< class SRC, class DST >
+void copy_values( const SRC* src, DST* dst, Core::size_type size )
+{
+  for ( Core::size_type j = 0; j < size; j++ )
+  {
+    dst[ j ] = static_cast< DST >( src[ j ] );
+  }
+}
+
+// Integer destinations saturate at the limits of their type and NaN is stored as 0.
+// NOTE: The comparisons are done in double precision against the lower limit and the upper limit
+// plus one, which are powers of two and hence exact. The upper limit itself is not representable
+// for 32 and 64 bit integers and rounds up to a value that cannot be converted.
+template< class SRC, class DST >
+void clamp_values( const SRC* src, DST* dst, Core::size_type size )
+{
+  const double lower = static_cast< double >( std::numeric_limits< DST >::min() );
+  const double upper = std::ldexp( 1.0, std::numeric_limits< DST >::digits );
+  for ( Core::size_type j = 0; j < size; j++ )
+  {
+    double val = static_cast< double >( src[ j ] );
+    if ( val != val ) dst[ j ] = 0;
+    else if ( val <= lower ) dst[ j ] = std::numeric_limits< DST >::min();
+    else if ( val >= upper ) dst[ j ] = std::numeric_limits< DST >::max();
+    else dst[ j ] = static_cast< DST >( val );
+  }
+}
+
 //--------------------------------------------------------------------------
 // Source functions
 
+template< class T >
 bool get_scalar_data( Core::ArrayMathProgramCode& pc )
 {
   // Destination 
-  float* data0 = pc.get_variable( 0 );
+  T* data0 = pc.get_variable<T>( 0 );
 
   // Source
   Core::DataBlock& data1( *( pc.get_data_block( 1 ) ) );
-  // One virtual call to get the data
-
-  float* data0_end = data0 + pc.get_size();
+  Core::size_type size = pc.get_size();
   Core::index_type idx = pc.get_index();
 
-  float val;
-  while( data0 != data0_end ) 
+  switch ( data1.get_data_type() )
   {
-    val = static_cast< float >( data1.get_data_at( idx ) );
-    idx++;
-
-    *data0 = val; 
-    data0++;
+  case Core::DataType::CHAR_E:
+    copy_values( reinterpret_cast< const signed char* >( data1.get_data() ) + idx, data0, size );
+    return true;
+  case Core::DataType::UCHAR_E:
+    copy_values( reinterpret_cast< const unsigned char* >( data1.get_data() ) + idx, data0, 
+      size );
+    return true;
+  case Core::DataType::SHORT_E:
+    copy_values( reinterpret_cast< const short* >( data1.get_data() ) + idx, data0, size );
+    return true;
+  case Core::DataType::USHORT_E:
+    copy_values( reinterpret_cast< const unsigned short* >( data1.get_data() ) + idx, data0, 
+      size );
+    return true;
+  case Core::DataType::INT_E:
+    copy_values( reinterpret_cast< const int* >( data1.get_data() ) + idx, data0, size );
+    return true;
+  case Core::DataType::UINT_E:
+    copy_values( reinterpret_cast< const unsigned int* >( data1.get_data() ) + idx, data0, 
+      size );
+    return true;
+  case Core::DataType::LONGLONG_E:
+    copy_values( reinterpret_cast< const long long* >( data1.get_data() ) + idx, data0, size );
+    return true;
+  case Core::DataType::ULONGLONG_E:
+    copy_values( reinterpret_cast< const unsigned long long* >( data1.get_data() ) + idx, 
+      data0, size );
+    return true;
+  case Core::DataType::FLOAT_E:
+    copy_values( reinterpret_cast< const float* >( data1.get_data() ) + idx, data0, size );
+    return true;
+  case Core::DataType::DOUBLE_E:
+    copy_values( reinterpret_cast< const double* >( data1.get_data() ) + idx, data0, size );
+    return true;
+  default:
+    return false;
   }
-
-  return true;
 }
 
+template< class T >
 bool get_scalar_mask( Core::ArrayMathProgramCode& pc )
 {
   // Destination 
-  float* data0 = pc.get_variable( 0 );
+  T* data0 = pc.get_variable<T>( 0 );
 
   // Source
   Core::MaskDataBlock& data1( *( pc.get_mask_data_block( 1 ) ) );
-  // One virtual call to get the data
-
-  float* data0_end = data0 + pc.get_size();
-  Core::index_type idx = pc.get_index();
+  const unsigned char* mask = data1.get_mask_data() + pc.get_index();
+  const unsigned char mask_value = data1.get_mask_value();
+  Core::size_type size = pc.get_size();
 
   // Get value (on/off) from mask
-  float val;
-  while( data0 != data0_end ) 
+  for ( Core::size_type j = 0; j < size; j++ )
   {
-    val = data1.get_mask_at( idx ) ? 1.0f : 0.0f;
-    idx++;
-
-    *data0 = val; 
-    data0++;
+    data0[ j ] = ( mask[ j ] & mask_value ) ? T( 1 ) : T( 0 );
   }
 
   return true;
@@ -91,38 +150,51 @@ bool get_scalar_mask( Core::ArrayMathProgramCode& pc )
 //--------------------------------------------------------------------------
 // Sink functions
 
+template< class T >
 bool to_data_block_s( Core::ArrayMathProgramCode& pc )
 {
   // Get the pointer to the DataBlock object where we need to store the data
   Core::DataBlock& data0( *( pc.get_data_block( 0 ) ) );
-  float* data1 = pc.get_variable( 1 );
-
-  float* data1_end = data1 + ( pc.get_size() );
+  const T* data1 = pc.get_variable<T>( 1 );
+  Core::size_type size = pc.get_size();
   Core::index_type idx = pc.get_index();
 
-  if ( data0.get_data_type() == Core::DataType::CHAR_E )
+  switch ( data0.get_data_type() )
   {
-    while ( data1 != data1_end ) 
-    {
-      float fdata = *data1;
-      if ( fdata > 127.0f ) fdata = 127.0f;
-      if ( fdata < -128.0f ) fdata = -128.0f;
-      data0.set_data_at( idx, *data1 ); 
-      idx++; 
-      data1++;
-    } 
+  case Core::DataType::CHAR_E:
+    clamp_values( data1, reinterpret_cast< signed char* >( data0.get_data() ) + idx, size );
+    return true;
+  case Core::DataType::UCHAR_E:
+    clamp_values( data1, reinterpret_cast< unsigned char* >( data0.get_data() ) + idx, size );
+    return true;
+  case Core::DataType::SHORT_E:
+    clamp_values( data1, reinterpret_cast< short* >( data0.get_data() ) + idx, size );
+    return true;
+  case Core::DataType::USHORT_E:
+    clamp_values( data1, reinterpret_cast< unsigned short* >( data0.get_data() ) + idx, size );
+    return true;
+  case Core::DataType::INT_E:
+    clamp_values( data1, reinterpret_cast< int* >( data0.get_data() ) + idx, size );
+    return true;
+  case Core::DataType::UINT_E:
+    clamp_values( data1, reinterpret_cast< unsigned int* >( data0.get_data() ) + idx, size );
+    return true;
+  case Core::DataType::LONGLONG_E:
+    clamp_values( data1, reinterpret_cast< long long* >( data0.get_data() ) + idx, size );
+    return true;
+  case Core::DataType::ULONGLONG_E:
+    clamp_values( data1, reinterpret_cast< unsigned long long* >( data0.get_data() ) + idx, 
+      size );
+    return true;
+  case Core::DataType::FLOAT_E:
+    copy_values( data1, reinterpret_cast< float* >( data0.get_data() ) + idx, size );
+    return true;
+  case Core::DataType::DOUBLE_E:
+    copy_values( data1, reinterpret_cast< double* >( data0.get_data() ) + idx, size );
+    return true;
+  default:
+    return false;
   }
-  else
-  {
-    while ( data1 != data1_end ) 
-    {
-      data0.set_data_at( idx, *data1 ); 
-      idx++; 
-      data1++;
-    }
-  }
-  
-  return true;
 }
 
 } //end namespace
@@ -133,11 +205,14 @@ namespace Core
 void InsertSourceSinkArrayMathFunctionCatalog( ArrayMathFunctionCatalogHandle& catalog )
 {
   // Source functions
-  catalog->add_function( ArrayMathFunctions::get_scalar_data, "get_scalar$DATA", "S" );
-  catalog->add_function( ArrayMathFunctions::get_scalar_mask, "get_scalar$MASK", "S" );
+  catalog->add_function( ArrayMathFunctions::get_scalar_data<float>, 
+    ArrayMathFunctions::get_scalar_data<double>, "get_scalar$DATA", "S" );
+  catalog->add_function( ArrayMathFunctions::get_scalar_mask<float>, 
+    ArrayMathFunctions::get_scalar_mask<double>, "get_scalar$MASK", "S" );
 
   // Sink functions
-  catalog->add_function( ArrayMathFunctions::to_data_block_s, "to_data_block$S", "DATA" );
+  catalog->add_function( ArrayMathFunctions::to_data_block_s<float>, 
+    ArrayMathFunctions::to_data_block_s<double>, "to_data_block$S", "DATA" );
 }
 
 } // end namespace
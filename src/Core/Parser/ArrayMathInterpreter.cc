@@ -34,6 +34,7 @@
 
 // Core includes
 #include <Core/Parser/ArrayMathFunction.h>
+#include <Core/Parser/ArrayMathFunctionCatalog.h>
 #include <Core/Parser/ArrayMathInterpreter.h>
 #include <Core/Parser/ArrayMathProgram.h>
 #include <Core/Parser/ArrayMathProgramVariable.h>
@@ -45,6 +46,150 @@
 namespace Core
 {
 
+// Placeholder for a function that has been merged into the function that follows it
+static bool NopArrayMathFunction( ArrayMathProgramCode& pc )
+{
+  return true;
+}
+
+// Connect an input variable of a sequential function to location k of the program code
+static bool SetSequentialInput( ArrayMathProgramHandle& mprogram, 
+  ParserScriptVariableHandle ihandle, size_t k, int nt, ArrayMathProgramCode& pc, 
+  std::string& error )
+{
+  ArrayMathProgramSource ps;
+  std::string name = ihandle->get_name();
+  int inum = ihandle->get_var_number();
+  std::string type = ihandle->get_type();
+  int flags = ihandle->get_flags();
+
+  if ( type == "S" )
+  {
+    if ( flags & SCRIPT_SEQUENTIAL_VAR_E )
+    {
+      if ( flags & SCRIPT_CONST_VAR_E ) pc.set_variable( k,
+          mprogram->get_sequential_variable( inum, 0 )->get_data() );
+      else pc.set_variable( k,
+          mprogram->get_sequential_variable( inum, nt )->get_data() );
+    }
+    else if ( flags & SCRIPT_SINGLE_VAR_E )
+    {
+      pc.set_variable( k, mprogram->get_single_variable( inum )->get_data() );
+    }
+    else if ( flags & SCRIPT_CONST_VAR_E )
+    {
+      pc.set_variable( k, mprogram->get_const_variable( inum )->get_data() );
+    }
+  }
+  else if ( type == "DATA" )
+  {
+    mprogram->find_source( name, ps );
+    if ( ps.is_data_block() )
+    {
+      pc.set_data_block( k, ps.get_data_block() );
+    }
+    else
+    {
+      error
+        = "INTERNAL ERROR - Variable is of DataBlock type, but given source is not a DataBlock.";
+      return false;
+    }
+  }
+  else if ( type == "MASK" )
+  {
+    mprogram->find_source( name, ps );
+    if ( ps.is_mask_data_block() )
+    {
+      pc.set_mask_data_block( k, ps.get_mask_data_block() );
+    }
+    else
+    {
+      error
+        = "INTERNAL ERROR - Variable is of MaskDataBlock type, but given source is not a MaskDataBlock.";
+      return false;
+    }
+  }
+  else
+  {
+    error = "INTERNAL ERROR - Encountered unknown type.";
+    return false;
+  }
+  return true;
+}
+
+// Check whether a variable is a buffer that only lives within one pass of the sequential program
+static bool IsSequentialBuffer( ParserScriptVariableHandle& vhandle )
+{
+  int flags = vhandle->get_flags();
+  return vhandle->get_type() == "S" && ( flags & SCRIPT_SEQUENTIAL_VAR_E ) && 
+    !( flags & SCRIPT_CONST_VAR_E );
+}
+
+// Mark sequential functions whose result is only used by the function directly after it, and 
+// that together with that function have a fused implementation. Instead of writing the
+// intermediate result to a buffer and reading it back, the pair is computed in one pass.
+static void FindFusedSequentialFunctions( ParserProgramHandle& pprogram, 
+  std::vector< char >& fused, std::vector< char >& fused_swap )
+{
+  size_t num_sequential_functions = pprogram->num_sequential_functions();
+  ParserScriptFunctionHandle fhandle;
+  ParserScriptFunctionHandle next_fhandle;
+
+  // Count how often each buffer is read
+  std::vector< size_t > num_uses( pprogram->num_sequential_variables(), 0 );
+  for ( size_t j = 0; j < num_sequential_functions; j++ )
+  {
+    pprogram->get_sequential_function( j, fhandle );
+    size_t num_input_vars = fhandle->num_input_vars();
+    for ( size_t i = 0; i < num_input_vars; i++ )
+    {
+      ParserScriptVariableHandle ihandle = fhandle->get_input_var( i );
+      if ( IsSequentialBuffer( ihandle ) ) num_uses[ ihandle->get_var_number() ]++;
+    }
+  }
+
+  ArrayMathFunctionObject function;
+  size_t j = 0;
+  while ( j + 1 < num_sequential_functions )
+  {
+    pprogram->get_sequential_function( j, fhandle );
+    pprogram->get_sequential_function( j + 1, next_fhandle );
+
+    ParserScriptVariableHandle ohandle = fhandle->get_output_var();
+    if ( !( IsSequentialBuffer( ohandle ) ) || num_uses[ ohandle->get_var_number() ] != 1 ||
+      next_fhandle->num_input_vars() != 2 )
+    {
+      j++;
+      continue;
+    }
+
+    // The intermediate result needs to be an input of the next function
+    int location = -1;
+    for ( size_t i = 0; i < 2; i++ )
+    {
+      ParserScriptVariableHandle ihandle = next_fhandle->get_input_var( i );
+      if ( IsSequentialBuffer( ihandle ) && 
+        ihandle->get_var_number() == ohandle->get_var_number() )
+      {
+        location = static_cast< int >( i );
+      }
+    }
+
+    if ( location < 0 || !( GetFusedArrayMathFunction( 
+      fhandle->get_function()->get_function_id(), 
+      next_fhandle->get_function()->get_function_id(), location == 1, false, function ) ) )
+    {
+      j++;
+      continue;
+    }
+
+    fused[ j ] = true;
+    fused_swap[ j ] = ( location == 1 );
+    // A fused function cannot be fused again
+    j += 2;
+  }
+}
+
 bool ArrayMathInterpreter::create_program( ArrayMathProgramHandle& mprogram, std::string& error )
 {
   if ( mprogram.get() == 0 )
@@ -145,6 +290,15 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
     }
   }
 
+  // Choose the buffer size so the buffers used by one copy of the program stay in cache
+  size_t num_sequential_buffers = 0;
+  for ( size_t j = 0; j < num_sequential_variables; j++ )
+  {
+    pprogram->get_sequential_variable( j, vhandle );
+    if ( vhandle->get_type() == "S" ) num_sequential_buffers++;
+  }
+  mprogram->select_buffer_size( num_sequential_buffers );
+
   // Determine how many space we need to reserve for sequential variables
   size_type buffer_size = mprogram->get_buffer_size();
   int num_threads = mprogram->get_num_threads();
@@ -183,7 +337,10 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
   // Get all the constants in one piece of memory
   // All memory management is inside the ArrayMathProgram
   // We only get the pointer to actually insert all the pieces
-  float* buffer = mprogram->create_buffer( buffer_mem );
+  // Values are stored as floats or doubles depending on the precision of the program
+  bool double_precision = mprogram->get_double_precision();
+  size_t value_size = mprogram->get_value_size();
+  char* buffer = mprogram->create_buffer( buffer_mem );
 
   for ( size_t j = 0; j < num_const_variables; j++ )
   {
@@ -207,13 +364,14 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
       // able to store it right away
       if ( kind == SCRIPT_CONSTANT_SCALAR_E )
       {
-        float val = vhandle->get_scalar_value();
-        buffer[ 0 ] = val;
+        double val = vhandle->get_scalar_value();
+        if ( double_precision ) *reinterpret_cast< double* >( buffer ) = val;
+        else *reinterpret_cast< float* >( buffer ) = static_cast< float >( val );
       }
 
       // Generate a new program variable
       pvhandle = ArrayMathProgramVariableHandle( new ArrayMathProgramVariable( name, buffer ) );
-      buffer += 1;
+      buffer += value_size;
     }
     else
     {
@@ -245,7 +403,7 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
     {
       // Generate a new program variable
       pvhandle = ArrayMathProgramVariableHandle( new ArrayMathProgramVariable( name, buffer ) );
-      buffer += 1;
+      buffer += value_size;
     }
     else
     {
@@ -286,7 +444,7 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
         // Generate a new program variable
         pvhandle = 
           ArrayMathProgramVariableHandle( new ArrayMathProgramVariable( name, buffer ) );
-        buffer += 1 * buffer_size;
+        buffer += buffer_size * value_size;
       }
       else
       {
@@ -318,7 +476,7 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
     pprogram->get_const_function( j, fhandle );
     // Set the function pointer
     ArrayMathFunction* func = dynamic_cast< ArrayMathFunction* > ( fhandle->get_function() );
-    ArrayMathProgramCode pc( func->get_function() );
+    ArrayMathProgramCode pc( func->get_function( double_precision ) );
     pc.set_size( 1 );
     pc.set_index( 0 );
 
@@ -420,7 +578,7 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
 
     // Set the function pointer
     ArrayMathFunction* func = dynamic_cast< ArrayMathFunction* > ( fhandle->get_function() );
-    ArrayMathProgramCode pc( func->get_function() );
+    ArrayMathProgramCode pc( func->get_function( double_precision ) );
 
     pc.set_size( 1 );
     pc.set_index( 0 );
@@ -504,16 +662,29 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
     mprogram->set_single_program_code( j, pc );
   }
 
+  // Determine which pairs of elementwise functions can be computed in one pass
+  std::vector< char > fused( num_sequential_functions, false );
+  std::vector< char > fused_swap( num_sequential_functions, false );
+  FindFusedSequentialFunctions( pprogram, fused, fused_swap );
+
   // Process sequential list
   for ( int nt = 0; nt < num_threads; nt++ )
   {
     for ( size_t j = 0; j < num_sequential_functions; j++ )
     {
+      // The work of this function is done by the next one
+      if ( fused[ j ] )
+      {
+        ArrayMathProgramCode pc( NopArrayMathFunction );
+        mprogram->set_sequential_program_code( j, nt, pc );
+        continue;
+      }
+
       pprogram->get_sequential_function( j, fhandle );
 
       // Set the function pointer
       ArrayMathFunction* func = dynamic_cast< ArrayMathFunction* > ( fhandle->get_function() );
-      ArrayMathProgramCode pc( func->get_function() );
+      ArrayMathProgramCode pc( func->get_function( double_precision ) );
 
       ParserScriptVariableHandle ohandle = fhandle->get_output_var();
       onum = ohandle->get_var_number();
@@ -544,67 +715,44 @@ bool ArrayMathInterpreter::translate( ParserProgramHandle& pprogram,
         return false;
       }
 
-      size_t num_input_vars = fhandle->num_input_vars();
-      for ( size_t i = 0; i < num_input_vars; i++ )
+      if ( j > 0 && fused[ j - 1 ] )
       {
-        ParserScriptVariableHandle ihandle = fhandle->get_input_var( i );
-        name = ihandle->get_name();
-        inum = ihandle->get_var_number();
-        type = ihandle->get_type();
-        flags = ihandle->get_flags();
-
-        if ( type == "S" )
+        // Compute the previous function as part of this one, its inputs become the first two 
+        // inputs of the fused function and the remaining input of this function the third one
+        ParserScriptFunctionHandle prev_fhandle;
+        pprogram->get_sequential_function( j - 1, prev_fhandle );
+
+        ArrayMathFunctionObject function;
+        GetFusedArrayMathFunction( prev_fhandle->get_function()->get_function_id(),
+          fhandle->get_function()->get_function_id(), fused_swap[ j - 1 ] != 0, 
+          double_precision, function );
+        pc.set_function( function );
+
+        for ( size_t i = 0; i < 2; i++ )
         {
-          if ( flags & SCRIPT_SEQUENTIAL_VAR_E )
-          {
-            if ( flags & SCRIPT_CONST_VAR_E ) pc.set_variable( i + 1,
-                mprogram->get_sequential_variable( inum, 0 )->get_data() );
-            else pc.set_variable( i + 1,
-                mprogram->get_sequential_variable( inum, nt )->get_data() );
-          }
-
-          else if ( flags & SCRIPT_SINGLE_VAR_E )
+          if ( !( SetSequentialInput( mprogram, prev_fhandle->get_input_var( i ), i + 1, nt, 
+            pc, error ) ) )
           {
-            pc.set_variable( i + 1, mprogram->get_single_variable( inum )->get_data() );
-          }
-          else if ( flags & SCRIPT_CONST_VAR_E )
-          {
-            pc.set_variable( i + 1, mprogram->get_const_variable( inum )->get_data() );
+            return false;
           }
         }
-        else if ( type == "DATA" )
+        if ( !( SetSequentialInput( mprogram, fhandle->get_input_var( fused_swap[ j - 1 ] ? 
+          0 : 1 ), 3, nt, pc, error ) ) )
         {
-          mprogram->find_source( name, ps );
-          if ( ps.is_data_block() )
-          {
-            pc.set_data_block( i + 1, ps.get_data_block() );
-          }
-          else
-          {
-            error
-              = "INTERNAL ERROR - Variable is of DataBlock type, but given source is not a DataBlock.";
-            return false;
-          }
+          return false;
         }
-        else if ( type == "MASK" )
+      }
+      else
+      {
+        size_t num_input_vars = fhandle->num_input_vars();
+        for ( size_t i = 0; i < num_input_vars; i++ )
         {
-          mprogram->find_source( name, ps );
-          if ( ps.is_mask_data_block() )
+          if ( !( SetSequentialInput( mprogram, fhandle->get_input_var( i ), i + 1, nt, 
+            pc, error ) ) )
           {
-            pc.set_mask_data_block( i + 1, ps.get_mask_data_block() );
-          }
-          else
-          {
-            error
-              = "INTERNAL ERROR - Variable is of MaskDataBlock type, but given source is not a MaskDataBlock.";
             return false;
           }
         }
-        else
-        {
-          error = "INTERNAL ERROR - Encountered unknown type.";
-          return false;
-        }
       }
       mprogram->set_sequential_program_code( j, nt, pc );
     }
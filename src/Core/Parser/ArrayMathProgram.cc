@@ -26,12 +26,16 @@
  DEALINGS IN THE SOFTWARE.
  */
 
+// STL includes
+#include <atomic>
+
 // Boost includes
-#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 // Core includes
+#include <Core/Math/MathFunctions.h>
 #include <Core/Parser/ArrayMathProgram.h> 
-#include <Core/Utils/Parallel.h>
+#include <Core/Utils/ThreadPool.h>
 
 namespace Core
 {
@@ -40,19 +44,31 @@ class ArrayMathProgramPrivate
 {
 public:
 
-  // For parallel code
-  void parallel_run( int thread, int num_threads, boost::barrier& barrier );
+  // For parallel code, runs the sequential program copies [ thread_begin, thread_end )
+  void parallel_run( size_t thread_begin, size_t thread_end );
+
+  // Run one copy of the sequential program on blocks of the array until all are processed
+  void run_thread( size_t thread );
 
   // General parameters that determine how many values are computed at
   // the same time and how many processors to use
   size_type buffer_size_;
   int num_threads_;
 
+  // Whether intermediate values are stored as doubles
+  bool double_precision_;
+
   // The size of the array we are using
   size_type array_size_;
 
-  // Memory buffer
-  std::vector< float > buffer_;
+  // Start of the next block of the array that needs to be processed
+  std::atomic< index_type > next_offset_;
+
+  // Number of values that have been processed, used for progress reporting
+  std::atomic< index_type > processed_count_;
+
+  // Memory buffer, stored as doubles so it is aligned for either value type
+  std::vector< double > buffer_;
 
   // Source and Sink information
   std::map< std::string, ArrayMathProgramSource > input_sources_;
@@ -72,7 +88,8 @@ public:
 
   // Error reporting parallel code
   std::vector< size_type > error_line_;
-  std::vector< bool > success_;
+  // NOTE: A vector of bool cannot be written from different threads
+  std::vector< char > success_;
 
   typedef boost::signals2::signal< void (double) > update_progress_signal_type;
 
@@ -83,73 +100,81 @@ public:
   update_progress_signal_type update_progress_signal_;
 };
 
-void ArrayMathProgramPrivate::parallel_run( int thread, int num_threads, boost::barrier& barrier )
+void ArrayMathProgramPrivate::parallel_run( size_t thread_begin, size_t thread_end )
 {
-  index_type per_thread = this->array_size_ / num_threads;
-  index_type start = thread * per_thread;
-  index_type end = ( thread + 1 ) * per_thread;
-  index_type offset, sz;
-  if ( thread + 1 == num_threads ) 
+  for ( size_t thread = thread_begin; thread < thread_end; thread++ )
   {
-    end = this->array_size_;
+    this->run_thread( thread );
   }
+}
+
+void ArrayMathProgramPrivate::run_thread( size_t thread )
+{
+  // Each copy of the program grabs blocks of the array until none are left, so copies that run 
+  // on a busy core do not hold up the others. A block contains multiple buffers to limit the 
+  // contention on the shared offset.
+  index_type block_size = this->buffer_size_ * 64;
+  index_type start, offset, end, sz;
 
-  offset = start;
   this->success_[ thread ] = true;
 
-  double one_percent_count = 0.01 * per_thread;
+  double one_percent_count = 0.01 * this->array_size_;
   double progress_count = 0;
-  while ( offset < end )
+
+  while ( ( start = this->next_offset_.fetch_add( block_size ) ) < this->array_size_ )
   {
-    if( thread == 0 && progress_count > one_percent_count )
+    offset = start;
+    end = start + block_size;
+    if ( end > this->array_size_ ) 
     {
-      // Report progress here -- only at 1% intervals
-      this->update_progress_signal_( (
-        static_cast< double >( offset ) / static_cast< double >( end ) ) );
-      progress_count -= one_percent_count;
+      end = this->array_size_;
     }
 
-    sz = this->buffer_size_;
-    if ( offset + sz >= end ) 
+    while ( offset < end )
     {
-      sz = end - offset;
-    }
+      sz = this->buffer_size_;
+      if ( offset + sz >= end ) 
+      {
+        sz = end - offset;
+      }
 
-    size_t size = this->sequential_functions_[ thread ].size();
-    for ( size_t j = 0; j < size; j++ )
-    {
-      this->sequential_functions_[ thread ][ j ].set_index( offset );
-      this->sequential_functions_[ thread ][ j ].set_size( sz );
-    }
-    for ( size_t j = 0; j < size; j++ )
-    {
-      if ( !( this->sequential_functions_[ thread ][ j ].run() ) )
+      size_t size = this->sequential_functions_[ thread ].size();
+      for ( size_t j = 0; j < size; j++ )
+      {
+        this->sequential_functions_[ thread ][ j ].set_index( offset );
+        this->sequential_functions_[ thread ][ j ].set_size( sz );
+      }
+      for ( size_t j = 0; j < size; j++ )
       {
-        this->error_line_[ thread ] = j;
-        this->success_[ thread ] = false;
+        if ( !( this->sequential_functions_[ thread ][ j ].run() ) )
+        {
+          this->error_line_[ thread ] = j;
+          this->success_[ thread ] = false;
+        }
       }
+      offset += sz;
     }
-    offset += sz;
-    progress_count += sz;
-  }
 
-  if( thread == 0 )
-  {
-    // Make sure we hit 100%
-    this->update_progress_signal_( 1.0 ); 
+    index_type processed = ( this->processed_count_ += ( end - start ) );
+    if ( thread == 0 && processed - progress_count > one_percent_count )
+    {
+      // Report progress here -- only at 1% intervals
+      this->update_progress_signal_( static_cast< double >( processed ) / 
+        static_cast< double >( this->array_size_ ) );
+      progress_count = static_cast< double >( processed );
+    }
   }
-
-  barrier.wait();
 }
 
 ArrayMathProgram::ArrayMathProgram() :
   private_( new ArrayMathProgramPrivate )
 {
   // Buffer size describes how many values of a sequential variable are
-  // grouped together for vectorized execution
-  this->private_->buffer_size_ = 128;
-  // Number of processors to use
-  this->private_->num_threads_ = boost::thread::hardware_concurrency();
+  // grouped together for vectorized execution, it is selected when the program is translated
+  this->private_->buffer_size_ = 0;
+  // Number of copies of the program that run in parallel
+  this->private_->num_threads_ = ThreadPool::Instance()->get_concurrency();
+  this->private_->double_precision_ = false;
 
   // The size of the array
   this->private_->array_size_ = 1;
@@ -162,12 +187,13 @@ ArrayMathProgram::ArrayMathProgram( size_type array_size, size_type buffer_size,
   // Buffer size describes how many values of a sequential variable are
   // grouped together for vectorized execution
   this->private_->buffer_size_ = buffer_size;
-  // Number of processors to use
+  // Number of copies of the program that run in parallel
   if ( num_threads < 1 ) 
   {
-    num_threads = boost::thread::hardware_concurrency();
+    num_threads = ThreadPool::Instance()->get_concurrency();
   }
   this->private_->num_threads_ = num_threads;
+  this->private_->double_precision_ = false;
 
   // The size of the array
   this->private_->array_size_ = array_size;
@@ -258,10 +284,13 @@ bool ArrayMathProgram::run_sequential( size_t& error_line )
   this->private_->update_progress_signal_.connect( 
     boost::bind( &ArrayMathProgram::update_progress, this, _1 ) );
 
-  Parallel parallel_run_sequential( 
-    boost::bind( &ArrayMathProgramPrivate::parallel_run, this->private_, _1, _2, _3 ), 
-    this->private_->num_threads_ );
-  parallel_run_sequential.run();
+  this->private_->next_offset_ = 0;
+  this->private_->processed_count_ = 0;
+  parallel_for( 0, this->private_->num_threads_, 1, 
+    boost::bind( &ArrayMathProgramPrivate::parallel_run, this->private_, _1, _2 ) );
+
+  // Make sure we hit 100%
+  this->private_->update_progress_signal_( 1.0 ); 
 
   for ( int j = 0; j < this->private_->num_threads_; j++ )
   {
@@ -280,6 +309,38 @@ size_type ArrayMathProgram::get_buffer_size()
   return this->private_->buffer_size_;
 }
 
+void ArrayMathProgram::select_buffer_size( size_t num_buffers )
+{
+  if ( this->private_->buffer_size_ != 0 ) return;
+
+  // Keep the working set of one copy of the program within a typical L2 cache. Larger buffers 
+  // amortize the function call overhead, smaller ones keep the intermediates in cache.
+  const size_t cache_budget = 256 * 1024;
+  const size_t min_buffer_size = 128;
+  const size_t max_buffer_size = 16384;
+
+  size_t buffer_size = cache_budget / ( Max( num_buffers, size_t( 1 ) ) * 
+    this->get_value_size() );
+  // Keep the buffers a multiple of the cache line size
+  buffer_size = buffer_size & ~static_cast< size_t >( 63 );
+  this->private_->buffer_size_ = Min( Max( buffer_size, min_buffer_size ), max_buffer_size );
+}
+
+void ArrayMathProgram::set_double_precision( bool double_precision )
+{
+  this->private_->double_precision_ = double_precision;
+}
+
+bool ArrayMathProgram::get_double_precision()
+{
+  return this->private_->double_precision_;
+}
+
+size_t ArrayMathProgram::get_value_size()
+{
+  return this->private_->double_precision_ ? sizeof( double ) : sizeof( float );
+}
+
 int ArrayMathProgram::get_num_threads()
 {
   return this->private_->num_threads_;
@@ -333,10 +394,12 @@ void ArrayMathProgram::resize_sequential_functions( size_t sz )
   }
 }
 
-float* ArrayMathProgram::create_buffer( size_t size )
+char* ArrayMathProgram::create_buffer( size_t size )
 {
-  this->private_->buffer_.resize( size ); 
-  return &( this->private_->buffer_[ 0 ] );
+  size_t num_bytes = size * this->get_value_size();
+  this->private_->buffer_.resize( ( num_bytes + sizeof( double ) - 1 ) / sizeof( double ) ); 
+  if ( this->private_->buffer_.empty() ) return 0;
+  return reinterpret_cast< char* >( &( this->private_->buffer_[ 0 ] ) );
 }
 
 void ArrayMathProgram::set_const_variable( size_t j, ArrayMathProgramVariableHandle& handle )
@@ -51,6 +51,7 @@ public:
   ArrayMathProgram();
 
   /// Constructor that allows overloading the default optimization parameters
+  /// A buffer size of zero selects the buffer size automatically, see select_buffer_size()
   ArrayMathProgram( size_type array_size, size_type buffer_size, int num_threads = -1 );
 
   /// Get the optimization parameters, these can only be set when creating the
@@ -59,6 +60,18 @@ public:
   /// Get the number of entries that are processed at once
   size_type get_buffer_size();
 
+  /// Choose the number of entries that are processed at once so that the given number of
+  /// sequential buffers of one program copy fit in the L2 cache. This is only done when no
+  /// buffer size was given at construction.
+  void select_buffer_size( size_t num_buffers );
+
+  /// Whether the intermediate values are computed in double instead of single precision
+  void set_double_precision( bool double_precision );
+  bool get_double_precision();
+
+  /// Size in bytes of one intermediate value
+  size_t get_value_size();
+
   /// Get the number of threads
   int get_num_threads();
 
@@ -79,8 +92,8 @@ public:
   void resize_single_functions( size_t sz );
   void resize_sequential_functions( size_t sz );
 
-  /// Central buffer for all parameters
-  float* create_buffer( size_t size );
+  /// Central buffer for all parameters, size is given in number of values
+  char* create_buffer( size_t size );
 
   /// Set variables which we use as temporal information structures
   // TODO: need to remove them at some point
@@ -77,10 +77,10 @@ public:
 
   /// Tell the program where to temporary space has been allocated
   /// for this part of the program
-  inline void set_variable( size_t j, float* variable )
+  inline void set_variable( size_t j, void* variable )
   {
     if ( j >= this->variables_.size() ) this->variables_.resize( j + 1 );
-    this->variables_[ j ] = reinterpret_cast< void* >( variable );
+    this->variables_[ j ] = variable;
   }
 
   inline void set_data_block( size_t j, DataBlock* data_block )
@@ -114,10 +114,12 @@ public:
   }
 
   /// These functions are called by the actual code segments
-  /// For Scalar, Vector and Tensor buffers
-  inline float* get_variable( size_t j )
+  /// For Scalar, Vector and Tensor buffers. T is the type of the values in the buffers, which
+  /// is float, or double if the program runs in double precision.
+  template< class T >
+  inline T* get_variable( size_t j )
   { 
-    return reinterpret_cast< float* >( this->variables_[ j ] );
+    return reinterpret_cast< T* >( this->variables_[ j ] );
   }
 
   inline DataBlock* get_data_block( size_t j )
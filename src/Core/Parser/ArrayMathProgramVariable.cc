@@ -39,17 +39,17 @@ public:
   std::string name_;
 
   // Where the data needs to be store
-  float* data_;
+  void* data_;
 };
 
-ArrayMathProgramVariable::ArrayMathProgramVariable( std::string name, float* data ) : 
+ArrayMathProgramVariable::ArrayMathProgramVariable( std::string name, void* data ) : 
   private_( new ArrayMathProgramVariablePrivate )
 {
   this->private_->name_ = name;
   this->private_->data_ = data;
 }
 
-float* ArrayMathProgramVariable::get_data()
+void* ArrayMathProgramVariable::get_data()
 {
   return this->private_->data_;
 }
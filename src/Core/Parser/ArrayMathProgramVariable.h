@@ -44,11 +44,11 @@ class ArrayMathProgramVariable : public Lockable
 
 public:
   /// Constructor of the variable
-  ArrayMathProgramVariable( std::string name, float* data );
+  ArrayMathProgramVariable( std::string name, void* data );
 
   /// Retrieve the data pointer from the central temporal
   /// storage
-  float* get_data();
+  void* get_data();
 
 private:
   ArrayMathProgramVariablePrivateHandle private_;
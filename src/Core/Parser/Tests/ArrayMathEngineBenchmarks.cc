@@ -0,0 +1,93 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <Core/DataBlock/StdDataBlock.h>
+#include <Core/Parser/ArrayMathEngine.h>
+
+using namespace Core;
+
+namespace
+{
+
+template< class T >
+DataBlockHandle createDataBlock( size_t nx, size_t ny, size_t nz, DataType type, 
+  double offset, double scale )
+{
+  DataBlockHandle data_block = StdDataBlock::New( nx, ny, nz, type );
+  T* data = reinterpret_cast< T* >( data_block->get_data() );
+  size_t size = data_block->get_size();
+  for ( size_t j = 0; j < size; j++ )
+  {
+    data[ j ] = static_cast< T >( offset + scale * static_cast< double >( j % 1000 ) );
+  }
+  return data_block;
+}
+
+}
+
+TEST(ArrayMathEngineBenchmarks, ArithmeticThroughput)
+{
+  // Reports the throughput of a typical Arithmetic filter expression, measured as the number of
+  // bytes read and written per second
+  const size_t nx = 256, ny = 256, nz = 64;
+  DataBlockHandle a = createDataBlock< short >( nx, ny, nz, DataType::SHORT_E, -1000.0, 2.0 );
+  DataBlockHandle b = createDataBlock< float >( nx, ny, nz, DataType::FLOAT_E, 0.0, 0.01 );
+
+  const bool precisions[] = { false, true };
+  for ( size_t p = 0; p < 2; p++ )
+  {
+    ArrayMathEngine engine;
+    std::string error;
+    ASSERT_TRUE( engine.add_input_data_block( "A", a, error ) ) << error;
+    ASSERT_TRUE( engine.add_input_data_block( "B", b, error ) ) << error;
+    ASSERT_TRUE( engine.add_output_data_block( "RESULT", nx, ny, nz, DataType::FLOAT_E, 
+      error ) ) << error;
+    engine.set_double_precision( precisions[ p ] );
+    std::string expressions = "RESULT = A * B + 10;";
+    engine.add_expressions( expressions );
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    ASSERT_TRUE( engine.parse_and_validate( error ) ) << error;
+    ASSERT_TRUE( engine.run( error ) ) << error;
+    boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+
+    double seconds = std::max( ( end - start ).total_microseconds() * 1.0e-6, 1.0e-6 );
+    double bytes = static_cast< double >( nx * ny * nz ) * 
+      ( sizeof( short ) + sizeof( float ) + sizeof( float ) );
+    std::cout << "Arithmetic filter (" << ( precisions[ p ] ? "double" : "float" ) << 
+      " precision): " << bytes / seconds * 1.0e-9 << " GB/s" << std::endl;
+  }
+}
@@ -0,0 +1,236 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <Core/DataBlock/StdDataBlock.h>
+#include <Core/Parser/ArrayMathEngine.h>
+
+using namespace Core;
+
+namespace
+{
+
+template< class T >
+DataBlockHandle createDataBlock( size_t nx, size_t ny, size_t nz, DataType type, 
+  double offset, double scale )
+{
+  DataBlockHandle data_block = StdDataBlock::New( nx, ny, nz, type );
+  T* data = reinterpret_cast< T* >( data_block->get_data() );
+  size_t size = data_block->get_size();
+  for ( size_t j = 0; j < size; j++ )
+  {
+    data[ j ] = static_cast< T >( offset + scale * static_cast< double >( j % 1000 ) );
+  }
+  return data_block;
+}
+
+// Run an expression with inputs A and B and return the RESULT data block
+DataBlockHandle runExpression( const std::string& expression, DataBlockHandle a, 
+  DataBlockHandle b, DataType output_type, bool double_precision = false )
+{
+  ArrayMathEngine engine;
+  std::string error;
+  EXPECT_TRUE( engine.add_input_data_block( "A", a, error ) ) << error;
+  if ( b ) 
+  {
+    EXPECT_TRUE( engine.add_input_data_block( "B", b, error ) ) << error;
+  }
+  EXPECT_TRUE( engine.add_output_data_block( "RESULT", a->get_nx(), a->get_ny(), 
+    a->get_nz(), output_type, error ) ) << error;
+  engine.set_double_precision( double_precision );
+
+  std::string expressions = expression;
+  engine.add_expressions( expressions );
+  EXPECT_TRUE( engine.parse_and_validate( error ) ) << error;
+  EXPECT_TRUE( engine.run( error ) ) << error;
+
+  DataBlockHandle result;
+  EXPECT_TRUE( engine.get_data_block( "RESULT", result ) );
+  return result;
+}
+
+// Values around the limits of the integer types, the integers near 2^31 are exact in single
+// precision
+const double LIMIT_VALUES_C[] = { std::numeric_limits< double >::quiet_NaN(), 
+  -std::numeric_limits< double >::infinity(), std::numeric_limits< double >::infinity(), 
+  -1.0e30, 1.0e30, -0.75, 0.75, 2147483520.0, 2147483648.0, -2147483648.0, 4294967296.0, 
+  9223372036854775808.0, -9223372036854775808.0, 18446744073709551616.0 };
+const size_t NUM_LIMIT_VALUES_C = sizeof( LIMIT_VALUES_C ) / sizeof( double );
+
+// Write LIMIT_VALUES_C into a data block of type T in both precisions and compare the result
+template< class T >
+void checkSinkLimits( DataType type, const T* expected )
+{
+  DataBlockHandle values = StdDataBlock::New( NUM_LIMIT_VALUES_C, 1, 1, DataType::DOUBLE_E );
+  std::copy( LIMIT_VALUES_C, LIMIT_VALUES_C + NUM_LIMIT_VALUES_C, 
+    reinterpret_cast< double* >( values->get_data() ) );
+
+  for ( int double_precision = 0; double_precision < 2; double_precision++ )
+  {
+    DataBlockHandle result = runExpression( "RESULT = A;", values, DataBlockHandle(), type,
+      double_precision != 0 );
+    ASSERT_TRUE( result );
+
+    const T* data = reinterpret_cast< const T* >( result->get_data() );
+    for ( size_t j = 0; j < NUM_LIMIT_VALUES_C; j++ )
+    {
+      EXPECT_EQ( expected[ j ], data[ j ] ) << "value " << LIMIT_VALUES_C[ j ] << 
+        ( double_precision ? " (double precision)" : " (single precision)" );
+    }
+  }
+}
+
+}
+
+TEST(ArrayMathEngineTests, TypedSources)
+{
+  DataBlockHandle uchar_block = createDataBlock< unsigned char >( 64, 32, 3, 
+    DataType::UCHAR_E, 0.0, 0.25 );
+  DataBlockHandle short_block = createDataBlock< short >( 64, 32, 3, 
+    DataType::SHORT_E, -500.0, 1.0 );
+
+  DataBlockHandle result = runExpression( "RESULT = A + B;", uchar_block, short_block, 
+    DataType::FLOAT_E );
+  ASSERT_TRUE( result );
+
+  const float* data = reinterpret_cast< const float* >( result->get_data() );
+  for ( size_t j = 0; j < result->get_size(); j++ )
+  {
+    ASSERT_EQ( static_cast< float >( uchar_block->get_data_at( j ) + 
+      short_block->get_data_at( j ) ), data[ j ] ) << "index " << j;
+  }
+}
+
+TEST(ArrayMathEngineTests, SinkSaturates)
+{
+  DataBlockHandle float_block = createDataBlock< float >( 100, 10, 1, 
+    DataType::FLOAT_E, -2000.0, 4.0 );
+
+  DataBlockHandle result = runExpression( "RESULT = A;", float_block, DataBlockHandle(), 
+    DataType::UCHAR_E );
+  ASSERT_TRUE( result );
+
+  const unsigned char* data = reinterpret_cast< const unsigned char* >( result->get_data() );
+  for ( size_t j = 0; j < result->get_size(); j++ )
+  {
+    double expected = std::min( std::max( float_block->get_data_at( j ), 0.0 ), 255.0 );
+    ASSERT_EQ( static_cast< unsigned char >( expected ), data[ j ] ) << "index " << j;
+  }
+}
+
+TEST(ArrayMathEngineTests, FusedExpressions)
+{
+  DataBlockHandle a = createDataBlock< float >( 50, 40, 3, DataType::FLOAT_E, 1.0, 0.5 );
+  DataBlockHandle b = createDataBlock< float >( 50, 40, 3, DataType::FLOAT_E, -3.0, 0.25 );
+
+  // Chains of elementwise operators are computed in fused passes, the result should not 
+  // depend on whether the intermediate was stored
+  const char* expressions[] = { "RESULT = A * B + A;", "RESULT = A - ( A + B ) * B;", 
+    "RESULT = ( A - B ) / ( B + 300 ) - A * 2;", "RESULT = 3 / ( A * B );" };
+
+  for ( size_t e = 0; e < sizeof( expressions ) / sizeof( expressions[ 0 ] ); e++ )
+  {
+    DataBlockHandle result = runExpression( expressions[ e ], a, b, DataType::FLOAT_E );
+    ASSERT_TRUE( result );
+
+    const float* data = reinterpret_cast< const float* >( result->get_data() );
+    const float* da = reinterpret_cast< const float* >( a->get_data() );
+    const float* db = reinterpret_cast< const float* >( b->get_data() );
+    for ( size_t j = 0; j < result->get_size(); j++ )
+    {
+      float expected = 0.0f;
+      switch ( e )
+      {
+      case 0: expected = da[ j ] * db[ j ] + da[ j ]; break;
+      case 1: expected = da[ j ] - ( da[ j ] + db[ j ] ) * db[ j ]; break;
+      case 2: expected = ( da[ j ] - db[ j ] ) / ( db[ j ] + 300.0f ) - da[ j ] * 2.0f; break;
+      case 3: expected = 3.0f / ( da[ j ] * db[ j ] ); break;
+      }
+      ASSERT_FLOAT_EQ( expected, data[ j ] ) << expressions[ e ] << " index " << j;
+    }
+  }
+}
+
+TEST(ArrayMathEngineTests, DoublePrecision)
+{
+  // Values above 2^24 cannot be represented exactly in single precision
+  DataBlockHandle int_block = createDataBlock< int >( 64, 16, 2, DataType::INT_E, 
+    100000001.0, 1.0 );
+
+  DataBlockHandle result = runExpression( "RESULT = A + 1;", int_block, DataBlockHandle(),
+    DataType::INT_E, true );
+  ASSERT_TRUE( result );
+
+  const int* src = reinterpret_cast< const int* >( int_block->get_data() );
+  const int* data = reinterpret_cast< const int* >( result->get_data() );
+  for ( size_t j = 0; j < result->get_size(); j++ )
+  {
+    ASSERT_EQ( src[ j ] + 1, data[ j ] ) << "index " << j;
+  }
+
+  DataBlockHandle float_result = runExpression( "RESULT = A + 1;", int_block, 
+    DataBlockHandle(), DataType::INT_E, false );
+  ASSERT_TRUE( float_result );
+  EXPECT_NE( 0, std::memcmp( float_result->get_data(), result->get_data(), 
+    result->get_size() * sizeof( int ) ) );
+}
+
+TEST(ArrayMathEngineTests, SinkSaturatesAtTypeLimits)
+{
+  const int int_min = std::numeric_limits< int >::min();
+  const int int_max = std::numeric_limits< int >::max();
+  const int int_expected[] = { 0, int_min, int_max, int_min, int_max, 0, 0, 2147483520, 
+    int_max, int_min, int_max, int_max, int_min, int_max };
+  checkSinkLimits< int >( DataType::INT_E, int_expected );
+
+  const unsigned int uint_max = std::numeric_limits< unsigned int >::max();
+  const unsigned int uint_expected[] = { 0, 0, uint_max, 0, uint_max, 0, 0, 2147483520u, 
+    2147483648u, 0, uint_max, uint_max, 0, uint_max };
+  checkSinkLimits< unsigned int >( DataType::UINT_E, uint_expected );
+
+  const long long ll_min = std::numeric_limits< long long >::min();
+  const long long ll_max = std::numeric_limits< long long >::max();
+  const long long ll_expected[] = { 0, ll_min, ll_max, ll_min, ll_max, 0, 0, 2147483520LL, 
+    2147483648LL, -2147483648LL, 4294967296LL, ll_max, ll_min, ll_max };
+  checkSinkLimits< long long >( DataType::LONGLONG_E, ll_expected );
+
+  const unsigned long long ull_max = std::numeric_limits< unsigned long long >::max();
+  const unsigned long long ull_expected[] = { 0, 0, ull_max, 0, ull_max, 0, 0, 2147483520ULL, 
+    2147483648ULL, 0, 4294967296ULL, 9223372036854775808ULL, 0, ull_max };
+  checkSinkLimits< unsigned long long >( DataType::ULONGLONG_E, ull_expected );
+
+  const signed char char_expected[] = { 0, -128, 127, -128, 127, 0, 0, 127, 127, -128, 127, 
+    127, -128, 127 };
+  checkSinkLimits< signed char >( DataType::CHAR_E, char_expected );
+}
@@ -34,6 +34,7 @@
 
 // Core includes
 #include <Core/Utils/Parallel.h>
+#include <Core/Utils/ThreadPool.h>
 
 namespace Core
 {
@@ -41,10 +42,27 @@ namespace Core
 class ParallelPrivate
 {
 public:
+  // RUN_THREAD:
+  // Run the function for one thread and record when it is done
+  void run_thread( int thread, boost::barrier& barrier );
+
   int num_threads_;
   boost::function< void ( int, int, boost::barrier&  ) > function_;
+
+  // Number of threads still running
+  int running_;
+  boost::mutex mutex_;
+  boost::condition_variable done_;
 };
 
+void ParallelPrivate::run_thread( int thread, boost::barrier& barrier )
+{
+  this->function_( thread, this->num_threads_, barrier );
+
+  boost::mutex::scoped_lock lock( this->mutex_ );
+  if ( --this->running_ == 0 ) this->done_.notify_all();
+}
+
 Parallel::Parallel( boost::function< void ( int, int, boost::barrier& ) > function, int num_threads ) :
   private_( new ParallelPrivate )
 {
@@ -52,7 +70,7 @@ Parallel::Parallel( boost::function< void ( int, int, boost::barrier& ) > functi
 
   if ( num_threads == -1 )
   {
-    this->private_->num_threads_ =  boost::thread::hardware_concurrency();
+    this->private_->num_threads_ = ThreadPool::Instance()->get_concurrency();
   }
   else
   {
@@ -68,19 +86,21 @@ Parallel::Parallel( boost::function< void ( int, int, boost::barrier& ) > functi
 void Parallel::run()
 {
   boost::barrier barrier( this->private_->num_threads_ );
+  this->private_->running_ = this->private_->num_threads_;
 
-  std::vector< boost::thread* > threads( this->private_->num_threads_ );
-
-  for ( int i = 0; i < this->private_->num_threads_; i++ )
+  // NOTE: All threads need to run at the same time as they may wait on each other, hence they
+  // are run on service threads and not as compute tasks.
+  for ( int i = 1; i < this->private_->num_threads_; i++ )
   {
-    threads[ i ] = new boost::thread( boost::bind( this->private_->function_, i, 
-      this->private_->num_threads_, boost::ref( barrier ) ) );
+    ThreadPool::Instance()->start( boost::bind( &ParallelPrivate::run_thread, 
+      this->private_, i, boost::ref( barrier ) ) );
   }
+  this->private_->run_thread( 0, barrier );
 
-  for ( int i = 0; i < this->private_->num_threads_; i++ )
+  boost::mutex::scoped_lock lock( this->private_->mutex_ );
+  while ( this->private_->running_ > 0 )
   {
-    threads[ i ]->join();
-    delete threads[ i ];
+    this->private_->done_.wait( lock );
   }
 }
 
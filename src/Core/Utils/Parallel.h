@@ -45,6 +45,13 @@ namespace Core
 class ParallelPrivate;
 typedef boost::shared_ptr< ParallelPrivate > ParallelPrivateHandle;
 
+// CLASS PARALLEL:
+/// Run a function on a fixed number of threads that can synchronize with each other through a
+/// barrier. The calling thread runs thread 0, the others run on the service threads of the 
+/// ThreadPool, so no threads are created for each call. If the work does not need a barrier,
+/// ThreadPool::parallel_for should be used instead.
+/// NOTE: By default the number of threads is the concurrency of the ThreadPool.
+
 class Parallel : public boost::noncopyable
 {
 
@@ -27,11 +27,11 @@
  */
 
 // Boost includes
-#include <boost/thread.hpp>
 #include <boost/bind.hpp>
  
 // Core includes
 #include <Core/Utils/Runnable.h>
+#include <Core/Utils/ThreadPool.h>
 
 namespace Core
 {
@@ -48,8 +48,8 @@ void ExecuteRunnable( RunnableHandle runnable )
 
 void Runnable::Start( RunnableHandle runnable )
 {
-  // Start a new thread
-  boost::thread thread( boost::bind( &ExecuteRunnable, runnable ) );
+  // Run on one of the service threads of the pool, these are reused between runnables
+  ThreadPool::Instance()->start( boost::bind( &ExecuteRunnable, runnable ) );
 }
 
 } // end namespace Core
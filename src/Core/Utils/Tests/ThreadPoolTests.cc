@@ -0,0 +1,162 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/barrier.hpp>
+
+#include <Core/Utils/AtomicCounter.h>
+#include <Core/Utils/Parallel.h>
+#include <Core/Utils/ThreadPool.h>
+
+static void FillRange( std::vector< int >& values, size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ ) values[ j ]++;
+}
+
+static void CountRange( Core::AtomicCounter& counter, size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ ) ++counter;
+}
+
+static void NestedRange( Core::AtomicCounter& counter, size_t begin, size_t end )
+{
+  for ( size_t j = begin; j < end; j++ )
+  {
+    Core::parallel_for( 0, 100, 1, boost::bind( &CountRange, boost::ref( counter ), _1, _2 ) );
+  }
+}
+
+static bool AbortAfter( Core::AtomicCounter& counter, long limit )
+{
+  return counter >= limit;
+}
+
+static void ThrowRange( size_t, size_t )
+{
+  throw std::runtime_error( "range failed" );
+}
+
+static void BarrierThread( Core::AtomicCounter& counter, int, int num_threads, 
+  boost::barrier& barrier )
+{
+  ++counter;
+  barrier.wait();
+  // All threads need to have passed the first stage before the second
+  if ( counter < num_threads ) ++counter;
+  barrier.wait();
+}
+
+TEST(ThreadPoolTests, Concurrency)
+{
+  int concurrency = Core::ThreadPool::Instance()->get_concurrency();
+  ASSERT_GE( concurrency, 1 );
+
+  Core::ThreadPool::Instance()->set_concurrency( 1 );
+  ASSERT_EQ( 1, Core::ThreadPool::Instance()->get_concurrency() );
+
+  Core::ThreadPool::Instance()->set_concurrency( concurrency );
+  ASSERT_EQ( concurrency, Core::ThreadPool::Instance()->get_concurrency() );
+}
+
+TEST(ThreadPoolTests, ParallelForCoversRange)
+{
+  std::vector< int > values( 100003, 0 );
+  ASSERT_TRUE( Core::parallel_for( 0, values.size(), 16, 
+    boost::bind( &FillRange, boost::ref( values ), _1, _2 ) ) );
+
+  for ( size_t j = 0; j < values.size(); j++ )
+  {
+    ASSERT_EQ( 1, values[ j ] );
+  }
+}
+
+TEST(ThreadPoolTests, ParallelForSingleThread)
+{
+  int concurrency = Core::ThreadPool::Instance()->get_concurrency();
+  Core::ThreadPool::Instance()->set_concurrency( 1 );
+
+  std::vector< int > values( 1000, 0 );
+  ASSERT_TRUE( Core::parallel_for( 10, values.size(), 1, 
+    boost::bind( &FillRange, boost::ref( values ), _1, _2 ) ) );
+  Core::ThreadPool::Instance()->set_concurrency( concurrency );
+
+  for ( size_t j = 0; j < values.size(); j++ )
+  {
+    ASSERT_EQ( j < 10 ? 0 : 1, values[ j ] );
+  }
+}
+
+TEST(ThreadPoolTests, NestedParallelFor)
+{
+  Core::AtomicCounter counter;
+  Core::parallel_for( 0, 64, 1, boost::bind( &NestedRange, boost::ref( counter ), _1, _2 ) );
+  ASSERT_EQ( 6400, counter );
+}
+
+TEST(ThreadPoolTests, ParallelForAbort)
+{
+  Core::AtomicCounter counter;
+  bool finished = Core::parallel_for( 0, 1000000, 1, 
+    boost::bind( &CountRange, boost::ref( counter ), _1, _2 ),
+    boost::bind( &AbortAfter, boost::ref( counter ), 1 ) );
+  ASSERT_FALSE( finished );
+  ASSERT_LT( counter, 1000000 );
+}
+
+TEST(ThreadPoolTests, ParallelForException)
+{
+  ASSERT_THROW( Core::parallel_for( 0, 1000, 1, &ThrowRange ), std::runtime_error );
+}
+
+TEST(ThreadPoolTests, TaskGroup)
+{
+  Core::AtomicCounter counter;
+  Core::TaskGroup group;
+  for ( int j = 0; j < 100; j++ )
+  {
+    group.run( boost::bind( &CountRange, boost::ref( counter ), 0, 10 ) );
+  }
+  group.wait();
+  ASSERT_EQ( 1000, counter );
+}
+
+TEST(ThreadPoolTests, ParallelBarrier)
+{
+  for ( int j = 0; j < 10; j++ )
+  {
+    Core::AtomicCounter counter;
+    Core::Parallel parallel( boost::bind( &BarrierThread, boost::ref( counter ), _1, _2, _3 ), 4 );
+    parallel.run();
+    ASSERT_EQ( 4, counter );
+  }
+}
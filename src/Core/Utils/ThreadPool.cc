@@ -0,0 +1,437 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <vector>
+
+// Boost includes
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+// Core includes
+#include <Core/Utils/ThreadPool.h>
+
+namespace Core
+{
+
+CORE_SINGLETON_IMPLEMENTATION( ThreadPool );
+
+// Number of chunks a parallel_for aims to create per thread, more chunks allow for better
+// balancing of uneven work by stealing at the expense of more scheduling overhead
+static const size_t CHUNKS_PER_THREAD_C = 4;
+
+// Number of seconds an idle service thread is kept around before it exits
+static const int SERVICE_THREAD_TIMEOUT_C = 30;
+
+class ThreadPoolQueue
+{
+public:
+  boost::mutex mutex_;
+  std::deque< ThreadPool::task_type > tasks_;
+};
+
+typedef boost::shared_ptr< ThreadPoolQueue > ThreadPoolQueueHandle;
+
+class ThreadPoolPrivate
+{
+public:
+  // WORKER_MAIN:
+  // Main loop of a compute worker thread
+  void worker_main( size_t index );
+
+  // SERVICE_MAIN:
+  // Main loop of a service thread that runs long running tasks
+  void service_main();
+
+  // POP_TASK:
+  // Get a task from the queue of the current worker, or steal one from the other queues
+  bool pop_task( ThreadPool::task_type& task );
+
+  // Queues for each of the workers, the last one is the shared queue for tasks that are
+  // submitted from outside the pool
+  std::vector< ThreadPoolQueueHandle > queues_;
+
+  // The worker threads
+  boost::thread_group workers_;
+  size_t num_workers_;
+
+  // Number of workers that are allowed to pick up tasks
+  std::atomic< size_t > active_workers_;
+
+  // Number of tasks in all the queues
+  std::atomic< long > queued_tasks_;
+
+  // Idle workers wait on this condition variable
+  boost::mutex idle_mutex_;
+  boost::condition_variable idle_condition_;
+  bool shutdown_;
+
+  // Tasks for service threads
+  boost::mutex service_mutex_;
+  boost::condition_variable service_condition_;
+  std::deque< ThreadPool::task_type > service_tasks_;
+  size_t idle_service_threads_;
+
+  // Index of the worker queue that belongs to the current thread
+  static boost::thread_specific_ptr< size_t > worker_index_;
+};
+
+boost::thread_specific_ptr< size_t > ThreadPoolPrivate::worker_index_;
+
+bool ThreadPoolPrivate::pop_task( ThreadPool::task_type& task )
+{
+  if ( this->queued_tasks_ <= 0 ) return false;
+
+  size_t num_queues = this->queues_.size();
+  size_t* worker_index = worker_index_.get();
+  size_t start = 0;
+
+  // Workers take the most recently added task from their own queue first, as its data is 
+  // most likely still in cache
+  if ( worker_index )
+  {
+    ThreadPoolQueue* queue = this->queues_[ *worker_index ].get();
+    boost::mutex::scoped_lock lock( queue->mutex_ );
+    if ( !queue->tasks_.empty() )
+    {
+      task.swap( queue->tasks_.back() );
+      queue->tasks_.pop_back();
+      --this->queued_tasks_;
+      return true;
+    }
+    start = *worker_index + 1;
+  }
+
+  // Steal the oldest task from one of the other queues, these are generally the largest ones
+  for ( size_t j = 0; j < num_queues; j++ )
+  {
+    size_t index = ( start + j ) % num_queues;
+    if ( worker_index && index == *worker_index ) continue;
+
+    ThreadPoolQueue* queue = this->queues_[ index ].get();
+    boost::mutex::scoped_lock lock( queue->mutex_ );
+    if ( !queue->tasks_.empty() )
+    {
+      task.swap( queue->tasks_.front() );
+      queue->tasks_.pop_front();
+      --this->queued_tasks_;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPoolPrivate::worker_main( size_t index )
+{
+  worker_index_.reset( new size_t( index ) );
+
+  for ( ;; )
+  {
+    ThreadPool::task_type task;
+    if ( index < this->active_workers_ && this->pop_task( task ) )
+    {
+      task();
+      continue;
+    }
+
+    boost::unique_lock< boost::mutex > lock( this->idle_mutex_ );
+    if ( this->shutdown_ ) return;
+    if ( index >= this->active_workers_ || this->queued_tasks_ <= 0 )
+    {
+      this->idle_condition_.wait( lock );
+    }
+  }
+}
+
+void ThreadPoolPrivate::service_main()
+{
+  boost::unique_lock< boost::mutex > lock( this->service_mutex_ );
+  for ( ;; )
+  {
+    while ( this->service_tasks_.empty() )
+    {
+      this->idle_service_threads_++;
+      bool notified = this->service_condition_.timed_wait( lock, 
+        boost::posix_time::seconds( SERVICE_THREAD_TIMEOUT_C ) );
+      this->idle_service_threads_--;
+
+      // Release threads that have not been used for a while
+      if ( !notified && this->service_tasks_.empty() ) return;
+    }
+
+    ThreadPool::task_type task;
+    task.swap( this->service_tasks_.front() );
+    this->service_tasks_.pop_front();
+
+    lock.unlock();
+    task();
+    // Release any resources bound to the task before going idle
+    task.clear();
+    lock.lock();
+  }
+}
+
+ThreadPool::ThreadPool() :
+  private_( new ThreadPoolPrivate )
+{
+  // The thread that submits work participates in running it, hence one worker less than the
+  // number of hardware threads is needed to keep all cores busy.
+  int hardware_threads = static_cast< int >( boost::thread::hardware_concurrency() );
+  this->private_->num_workers_ = static_cast< size_t >( std::max( hardware_threads - 1, 0 ) );
+  this->private_->active_workers_ = this->private_->num_workers_;
+  this->private_->queued_tasks_ = 0;
+  this->private_->shutdown_ = false;
+  this->private_->idle_service_threads_ = 0;
+
+  for ( size_t j = 0; j <= this->private_->num_workers_; j++ )
+  {
+    this->private_->queues_.push_back( ThreadPoolQueueHandle( new ThreadPoolQueue ) );
+  }
+
+  for ( size_t j = 0; j < this->private_->num_workers_; j++ )
+  {
+    this->private_->workers_.create_thread( boost::bind( &ThreadPoolPrivate::worker_main, 
+      this->private_, j ) );
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    boost::unique_lock< boost::mutex > lock( this->private_->idle_mutex_ );
+    this->private_->shutdown_ = true;
+  }
+  this->private_->idle_condition_.notify_all();
+  this->private_->workers_.join_all();
+}
+
+int ThreadPool::get_concurrency()
+{
+  return static_cast< int >( this->private_->active_workers_ ) + 1;
+}
+
+void ThreadPool::set_concurrency( int concurrency )
+{
+  size_t active_workers = static_cast< size_t >( std::max( concurrency - 1, 0 ) );
+  this->private_->active_workers_ = std::min( active_workers, this->private_->num_workers_ );
+
+  // Wake up the workers so they can pick up their new state
+  {
+    boost::unique_lock< boost::mutex > lock( this->private_->idle_mutex_ );
+  }
+  this->private_->idle_condition_.notify_all();
+}
+
+void ThreadPool::schedule( task_type task )
+{
+  size_t* worker_index = ThreadPoolPrivate::worker_index_.get();
+  ThreadPoolQueue* queue = worker_index ? this->private_->queues_[ *worker_index ].get() : 
+    this->private_->queues_.back().get();
+
+  {
+    boost::mutex::scoped_lock lock( queue->mutex_ );
+    queue->tasks_.push_back( task );
+  }
+  ++this->private_->queued_tasks_;
+
+  // NOTE: Take the idle lock, so a worker cannot miss the notification between checking the
+  // number of queued tasks and going to sleep.
+  {
+    boost::unique_lock< boost::mutex > lock( this->private_->idle_mutex_ );
+  }
+  this->private_->idle_condition_.notify_one();
+}
+
+bool ThreadPool::run_one_task()
+{
+  task_type task;
+  if ( !this->private_->pop_task( task ) ) return false;
+  task();
+  return true;
+}
+
+void ThreadPool::start( task_type task )
+{
+  boost::unique_lock< boost::mutex > lock( this->private_->service_mutex_ );
+  this->private_->service_tasks_.push_back( task );
+
+  if ( this->private_->idle_service_threads_ < this->private_->service_tasks_.size() )
+  {
+    boost::thread thread( boost::bind( &ThreadPoolPrivate::service_main, this->private_ ) );
+    thread.detach();
+  }
+  else
+  {
+    this->private_->service_condition_.notify_one();
+  }
+}
+
+static void RunParallelForChunk( ThreadPool::range_function_type& body, 
+  ThreadPool::abort_function_type& abort, std::atomic< bool >& aborted, size_t begin, size_t end )
+{
+  if ( aborted ) return;
+  if ( abort && abort() )
+  {
+    aborted = true;
+    return;
+  }
+  body( begin, end );
+}
+
+bool ThreadPool::parallel_for( size_t begin, size_t end, size_t grain, range_function_type body,
+  abort_function_type abort )
+{
+  if ( end <= begin ) return true;
+  if ( grain < 1 ) grain = 1;
+
+  size_t size = end - begin;
+  size_t num_chunks = static_cast< size_t >( this->get_concurrency() ) * CHUNKS_PER_THREAD_C;
+  size_t chunk_size = std::max( grain, ( size + num_chunks - 1 ) / num_chunks );
+
+  std::atomic< bool > aborted( false );
+
+  // Nothing to distribute, run it on the calling thread
+  if ( chunk_size >= size )
+  {
+    RunParallelForChunk( body, abort, aborted, begin, end );
+    return !aborted;
+  }
+
+  TaskGroup group;
+  for ( size_t chunk_begin = begin; chunk_begin < end; chunk_begin += chunk_size )
+  {
+    size_t chunk_end = std::min( chunk_begin + chunk_size, end );
+    group.run( boost::bind( &RunParallelForChunk, boost::ref( body ), boost::ref( abort ), 
+      boost::ref( aborted ), chunk_begin, chunk_end ) );
+  }
+  group.wait();
+
+  return !aborted;
+}
+
+class TaskGroupPrivate
+{
+public:
+  // EXECUTE:
+  // Run a task and record its completion
+  void execute( ThreadPool::task_type task );
+
+  // WAIT_ALL:
+  // Wait for all tasks to finish, while helping to execute queued tasks
+  void wait_all();
+
+  // Number of tasks that have not finished yet
+  std::atomic< long > pending_;
+
+  boost::mutex mutex_;
+  boost::condition_variable done_;
+
+  // First exception that was thrown by one of the tasks
+  std::exception_ptr exception_;
+};
+
+void TaskGroupPrivate::execute( ThreadPool::task_type task )
+{
+  try
+  {
+    task();
+  }
+  catch ( ... )
+  {
+    boost::mutex::scoped_lock lock( this->mutex_ );
+    if ( !this->exception_ ) this->exception_ = std::current_exception();
+  }
+
+  if ( --this->pending_ == 0 )
+  {
+    boost::mutex::scoped_lock lock( this->mutex_ );
+    this->done_.notify_all();
+  }
+}
+
+void TaskGroupPrivate::wait_all()
+{
+  ThreadPool* pool = ThreadPool::Instance();
+  while ( this->pending_ > 0 )
+  {
+    // Help out while the tasks of this group are still queued or running. This also makes
+    // sure nested task groups cannot run out of threads.
+    if ( pool->run_one_task() ) continue;
+
+    boost::unique_lock< boost::mutex > lock( this->mutex_ );
+    if ( this->pending_ > 0 )
+    {
+      // NOTE: Wake up regularly as the running tasks may queue nested tasks we can help with
+      this->done_.timed_wait( lock, boost::posix_time::milliseconds( 1 ) );
+    }
+  }
+}
+
+TaskGroup::TaskGroup() :
+  private_( new TaskGroupPrivate )
+{
+  this->private_->pending_ = 0;
+}
+
+TaskGroup::~TaskGroup()
+{
+  this->private_->wait_all();
+}
+
+void TaskGroup::run( ThreadPool::task_type task )
+{
+  ++this->private_->pending_;
+  ThreadPool::Instance()->schedule( boost::bind( &TaskGroupPrivate::execute, 
+    this->private_, task ) );
+}
+
+void TaskGroup::wait()
+{
+  this->private_->wait_all();
+
+  std::exception_ptr exception;
+  {
+    boost::mutex::scoped_lock lock( this->private_->mutex_ );
+    exception = this->private_->exception_;
+    this->private_->exception_ = std::exception_ptr();
+  }
+  if ( exception ) std::rethrow_exception( exception );
+}
+
+bool parallel_for( size_t begin, size_t end, size_t grain, ThreadPool::range_function_type body,
+  ThreadPool::abort_function_type abort )
+{
+  return ThreadPool::Instance()->parallel_for( begin, end, grain, body, abort );
+}
+
+} // end namespace Core
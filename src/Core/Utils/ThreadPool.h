@@ -0,0 +1,161 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+
+ The MIT License
+
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CORE_UTILS_THREADPOOL_H
+#define CORE_UTILS_THREADPOOL_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+# pragma once
+#endif 
+
+// Boost includes
+#include <boost/noncopyable.hpp>
+#include <boost/smart_ptr.hpp>
+#include <boost/function.hpp>
+
+// Core includes
+#include <Core/Utils/Singleton.h>
+
+namespace Core
+{
+
+// CLASS THREADPOOL:
+/// Process wide pool of persistent worker threads. Compute work is submitted as tasks that are
+/// distributed over per-worker queues; idle workers steal work from the queues of busy workers.
+/// Threads that wait for a task group to finish execute queued tasks themselves, hence tasks can
+/// safely submit and wait for nested tasks.
+/// NOTE: The concurrency of the pool is the number of worker threads plus the calling thread,
+/// which participates in any parallel_for it issues. Service threads created through start() are
+/// not part of this count, see start().
+
+class ThreadPoolPrivate;
+typedef boost::shared_ptr< ThreadPoolPrivate > ThreadPoolPrivateHandle;
+
+class ThreadPool : public boost::noncopyable
+{
+  CORE_SINGLETON( ThreadPool );
+
+  // -- constructor/destructor --
+private:
+  ThreadPool();
+  virtual ~ThreadPool();
+
+  // -- types --
+public:
+  typedef boost::function< void () > task_type;
+  typedef boost::function< void ( size_t, size_t ) > range_function_type;
+  typedef boost::function< bool () > abort_function_type;
+
+  // -- concurrency --
+public:
+  /// GET_CONCURRENCY:
+  /// Get the maximum number of threads that execute compute tasks at the same time.
+  int get_concurrency();
+
+  /// SET_CONCURRENCY:
+  /// Cap the number of threads that execute compute tasks at the same time. The value is
+  /// clamped between 1 and the number of hardware threads.
+  /// NOTE: The cap does not apply to the service threads of start().
+  void set_concurrency( int concurrency );
+
+  // -- task execution --
+public:
+  /// PARALLEL_FOR:
+  /// Split the range [begin, end) into chunks of at least grain elements and call body( chunk_begin,
+  /// chunk_end ) for each chunk on the pool. The calling thread helps executing the chunks and the
+  /// function returns when all of them are done. If abort is given it is checked before each chunk
+  /// is started and remaining chunks are skipped once it returns true.
+  /// The function returns false if the loop was aborted.
+  bool parallel_for( size_t begin, size_t end, size_t grain, range_function_type body,
+    abort_function_type abort = abort_function_type() );
+
+  /// START:
+  /// Run a long running or blocking task, e.g. a filter, on a pooled service thread. Service
+  /// threads are reused between tasks, but are exempt from the compute concurrency: these tasks
+  /// may wait on each other, so capping them could deadlock. A new service thread is created
+  /// whenever all existing ones are busy, hence the number of service threads is bounded only
+  /// by the number of tasks running at the same time. Parallel loops issued from a service
+  /// thread run their chunks on the capped worker threads, and the service thread itself
+  /// participates as the calling thread.
+  void start( task_type task );
+
+  /// RUN_ONE_TASK:
+  /// Execute one queued compute task on the calling thread. Returns false if no task was
+  /// available.
+  bool run_one_task();
+
+  // -- internals --
+private:
+  friend class TaskGroup;
+  friend class ThreadPoolPrivate;
+
+  /// SCHEDULE:
+  /// Queue a compute task. Tasks submitted from a worker thread go to the queue of that worker,
+  /// others go into the shared queue.
+  void schedule( task_type task );
+
+  ThreadPoolPrivateHandle private_;
+};
+
+// CLASS TASKGROUP:
+/// A set of compute tasks that are run on the ThreadPool and that can be waited on as a whole.
+/// Tasks may create task groups themselves.
+
+class TaskGroupPrivate;
+typedef boost::shared_ptr< TaskGroupPrivate > TaskGroupPrivateHandle;
+
+class TaskGroup : public boost::noncopyable
+{
+public:
+  TaskGroup();
+
+  /// NOTE: The destructor waits for any task that is still running
+  ~TaskGroup();
+
+  /// RUN:
+  /// Queue a task as part of this group.
+  void run( ThreadPool::task_type task );
+
+  /// WAIT:
+  /// Wait until all tasks of this group are done, the calling thread executes queued tasks while
+  /// waiting. If one of the tasks threw an exception, the first one is rethrown here.
+  void wait();
+
+private:
+  TaskGroupPrivateHandle private_;
+};
+
+/// PARALLEL_FOR:
+/// Shortcut for ThreadPool::Instance()->parallel_for().
+bool parallel_for( size_t begin, size_t end, size_t grain, 
+  ThreadPool::range_function_type body,
+  ThreadPool::abort_function_type abort = ThreadPool::abort_function_type() );
+
+} // end namespace Core
+
+#endif
@@ -30,6 +30,7 @@
 
 #include <Core/RenderResources/RenderResources.h>
 #include <Core/Volume/DataVolumeSlice.h>
+#include <Core/DataBlock/MaskThreshold.h>
 #include <Core/Graphics/PixelBufferObject.h>
 
 namespace Core
@@ -229,86 +230,24 @@ void DataVolumeSlice::set_data_at( size_t i, size_t j, double value )
   this->data_block_->set_data_at( this->to_index( i, j ), value );
 }
 
-template<class T >
-void ThresholdTypedData( const DataVolumeSlice* slice, DataBlock* data_block,
-  unsigned char* buffer, double min_val, double max_val, bool negative_constraint )
-{
-  size_t current_index = slice->to_index( 0, 0 );
-
-  // Index strides in X and Y direction. Use int instead of size_t because strides might be negative.
-  const int x_stride = static_cast<int>( slice->to_index( 1, 0 ) - current_index );
-  const int y_stride =  static_cast<int>( slice->to_index( 0, 1 ) - current_index );
-
-  const size_t nx = slice->nx();
-  const size_t ny = slice->ny();
-
-  T* data = static_cast< T* >( data_block->get_data() );
-  size_t row_start = current_index;
-  bool in_range;
-  for ( size_t j = 0; j < ny; j++ )
-  {
-    current_index = row_start;
-    for ( size_t i = 0; i < nx; i++ )
-    {
-      in_range = ( data[ current_index ] >= min_val &&
-        data[ current_index ] <= max_val );
-      buffer[ j * nx + i ] = negative_constraint ? !in_range : in_range;
-      current_index += x_stride;
-    }
-    row_start += y_stride;
-  }
-}
-
 void DataVolumeSlice::create_threshold_mask( std::vector< unsigned char >& mask,
     double min_val, double max_val, bool negative_constraint ) const
 {
   lock_type lock( this->get_mutex() );
 
   mask.resize( this->nx() * this->ny() );
+  if ( mask.empty() ) return;
+
+  size_t start = this->to_index( 0, 0 );
+  // Index strides in X and Y direction. Strides might be negative.
+  std::ptrdiff_t x_stride = static_cast< std::ptrdiff_t >( this->to_index( 1, 0 ) ) - 
+    static_cast< std::ptrdiff_t >( start );
+  std::ptrdiff_t y_stride = static_cast< std::ptrdiff_t >( this->to_index( 0, 1 ) ) - 
+    static_cast< std::ptrdiff_t >( start );
+
   DataBlock::shared_lock_type volume_lock( this->data_block_->get_mutex() );
-  switch ( this->data_block_->get_data_type() )
-  {
-  case DataType::CHAR_E:
-    ThresholdTypedData< signed char >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::UCHAR_E:
-    ThresholdTypedData< unsigned char >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::SHORT_E:
-    ThresholdTypedData< short >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::USHORT_E:
-    ThresholdTypedData< unsigned short >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::INT_E:
-    ThresholdTypedData< int >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::UINT_E:
-    ThresholdTypedData< unsigned int >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::LONGLONG_E:
-    ThresholdTypedData< long long >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::ULONGLONG_E:
-    ThresholdTypedData< unsigned long long >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::FLOAT_E:
-    ThresholdTypedData< float >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  case DataType::DOUBLE_E:
-    ThresholdTypedData< double >( this, this->data_block_, &mask[ 0 ],
-      min_val, max_val, negative_constraint );
-    break;
-  }
+  MaskThreshold::ThresholdSlice( this->data_block_, start, x_stride, y_stride, 
+    this->nx(), this->ny(), min_val, max_val, negative_constraint, &mask[ 0 ] );
 }
 
 
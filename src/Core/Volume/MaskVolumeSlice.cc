@@ -280,7 +280,8 @@ void MaskVolumeSlice::release_cached_data()
   {
     MaskDataBlock::lock_type volume_lock( this->mask_data_block_->get_mutex() );
     CopyCachedDataBack( this, &this->private_->cache_[ 0 ] );
-    this->mask_data_block_->increase_generation();
+    this->mask_data_block_->increase_generation( this->get_slice_type(), 
+      this->get_slice_number() );
   }
   
   this->private_->cache_.resize( 0 );
@@ -341,10 +342,10 @@ void MaskVolumeSlice::set_slice_data( const unsigned char* buffer, bool trigger_
     {
       MaskDataBlock::lock_type volume_lock( this->mask_data_block_->get_mutex() );
       CopyCachedDataBack( this, buffer );
-      if ( trigger_update )
-      {
-        this->mask_data_block_->increase_generation();
-      }
+      // NOTE: The generation is always updated, so the modified slice is recorded even when
+      // the update signal is deferred to the last of a series of slices.
+      this->mask_data_block_->increase_generation( this->get_slice_type(), 
+        this->get_slice_number() );
     }
   }
 
@@ -0,0 +1,202 @@
+/*
+ For more information, please see: http://software.sci.utah.edu
+ 
+ The MIT License
+ 
+ Copyright (c) 2016 Scientific Computing and Imaging Institute,
+ University of Utah.
+ 
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included
+ in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef _MSC_VER
+#pragma warning( disable: 4244 4267 )
+#endif
+
+// STL includes
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// boost includes
+#include <boost/filesystem.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// Core includes
+#include <Core/Utils/Log.h>
+#include <Core/Utils/StringUtil.h>
+#include <Core/Math/MathFunctions.h>
+#include <Core/DataBlock/DataType.h>
+#include <Core/Application/Application.h>
+#include <Core/Log/RolloverLogFile.h>
+
+#include <Core/LargeVolume/LargeVolumeSchema.h>
+#include <Core/LargeVolume/LargeVolumeCodec.h>
+
+void printUsage()
+{
+  std::cout << "USAGE: " << Core::Application::Instance()->GetUtilName()
+            <<  " input_volume [OPTIONS]" << std::endl;
+  std::cout << "Compresses the bricks of a large volume with every available codec and filter and reports"
+            << " the compression ratio and the encode and decode throughput." << std::endl << std::endl;
+  std::cout << "Mandatory arguments:" << std::endl;
+  std::cout << "  input_volume                 - Path to a large volume directory (.s3dvol)." << std::endl << std::endl;
+  std::cout << "Tool parameters (optional):" << std::endl;
+  std::cout << "  --level=SCALAR               - Resolution level to read bricks from, default is 0." << std::endl;
+  std::cout << "  --maxbricks=SCALAR           - Maximum number of bricks to test, default is 16." << std::endl;
+}
+
+static double SecondsSince( const boost::posix_time::ptime& start )
+{
+  return static_cast<double>( ( boost::posix_time::microsec_clock::local_time() - start ).total_microseconds() ) / 1e6;
+}
+
+int main( int argc, char **argv )
+{
+  Core::Application::SetUtilName("BenchmarkLargeVolumeCodecs");
+  
+  if ( argc < 2 )
+  {
+    printUsage();
+    return 0;
+  }
+  
+  // -- Parse the command line parameters --
+  Core::Application::Instance()->parse_command_line_parameters( argc, argv, 1 );
+  
+  // -- Send message to revolving log file --
+  Core::RolloverLogFile event_log( Core::LogMessageType::ALL_E );
+  
+  boost::filesystem::path volume_dir( Core::Application::Instance()->get_argument( 0 ) );
+  
+  Core::LargeVolumeSchemaHandle schema( new Core::LargeVolumeSchema );
+  schema->set_dir( volume_dir );
+  
+  std::string error;
+  if (! schema->load( error ) )
+  {
+    printUsage();
+    CORE_PRINT_AND_LOG_ERROR( error );
+    return -1;
+  }
+  
+  size_t level = 0;
+  std::string level_string;
+  if ( Core::Application::Instance()->check_command_line_parameter( "level", level_string ) )
+  {
+    if ( !Core::ImportFromString( level_string, level ) || level >= schema->get_num_levels() )
+    {
+      printUsage();
+      CORE_PRINT_AND_LOG_ERROR( "Level needs to be smaller than " + 
+        Core::ExportToString( schema->get_num_levels() ) + "." );
+      return -1;
+    }
+  }
+  
+  size_t max_bricks = 16;
+  std::string max_bricks_string;
+  if ( Core::Application::Instance()->check_command_line_parameter( "maxbricks", max_bricks_string ) )
+  {
+    if ( !Core::ImportFromString( max_bricks_string, max_bricks ) || max_bricks == 0 )
+    {
+      printUsage();
+      CORE_PRINT_AND_LOG_ERROR( "Maximum number of bricks needs to be a positive number." );
+      return -1;
+    }
+  }
+  
+  // Load the bricks to test, spread out over the level
+  Core::IndexVector layout = schema->get_level_layout( level );
+  size_t num_bricks = static_cast<size_t>( layout.x() * layout.y() * layout.z() );
+  size_t step = Core::Max( static_cast<size_t>( 1 ), num_bricks / max_bricks );
+  
+  std::vector< Core::DataBlockHandle > bricks;
+  size_t raw_bytes = 0;
+  for ( size_t k = 0; k < num_bricks && bricks.size() < max_bricks; k += step )
+  {
+    Core::DataBlockHandle brick;
+    if (! schema->read_brick( brick, Core::BrickInfo( k, level ), error ) )
+    {
+      CORE_PRINT_AND_LOG_ERROR( error );
+      return -1;
+    }
+    bricks.push_back( brick );
+    raw_bytes += brick->get_size() * brick->get_elem_size();
+  }
+  
+  size_t element_size = Core::GetSizeDataType( schema->get_data_type() );
+  double raw_mb = static_cast<double>( raw_bytes ) / ( 1 << 20 );
+  
+  std::cout << "Bricks:             " << bricks.size() << " of level " << level 
+    << " (" << Core::ExportToString( raw_mb ) << " MB)" << std::endl;
+  std::cout << std::setw( 12 ) << "codec" << std::setw( 10 ) << "filter" << std::setw( 10 ) << "ratio" 
+    << std::setw( 14 ) << "encode MB/s" << std::setw( 14 ) << "decode MB/s" << std::endl;
+  
+  std::vector< std::string > codecs = Core::LargeVolumeCodecRegistry::Instance()->get_codec_names();
+  const Core::LargeVolumeFilter::enum_type filters[] = { Core::LargeVolumeFilter::NONE_E,
+    Core::LargeVolumeFilter::SHUFFLE_E, Core::LargeVolumeFilter::DELTA_E };
+  
+  for ( size_t c = 0; c < codecs.size(); c++ )
+  {
+    for ( size_t f = 0; f < 3; f++ )
+    {
+      std::vector< std::vector<char> > encoded( bricks.size() );
+      size_t encoded_bytes = 0;
+      
+      boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+      for ( size_t k = 0; k < bricks.size(); k++ )
+      {
+        size_t size = bricks[ k ]->get_size() * bricks[ k ]->get_elem_size();
+        if (! Core::LargeVolumeBrickCodec::Encode( reinterpret_cast<char*>( bricks[ k ]->get_data() ),
+          size, element_size, codecs[ c ], filters[ f ], encoded[ k ], error ) )
+        {
+          CORE_PRINT_AND_LOG_ERROR( error );
+          return -1;
+        }
+        encoded_bytes += encoded[ k ].size();
+      }
+      double encode_seconds = SecondsSince( start );
+      
+      std::vector<char> decoded;
+      start = boost::posix_time::microsec_clock::local_time();
+      for ( size_t k = 0; k < bricks.size(); k++ )
+      {
+        size_t size = bricks[ k ]->get_size() * bricks[ k ]->get_elem_size();
+        decoded.resize( size );
+        if (! Core::LargeVolumeBrickCodec::Decode( &encoded[ k ][ 0 ], encoded[ k ].size(), 
+          &decoded[ 0 ], size, element_size, error ) )
+        {
+          CORE_PRINT_AND_LOG_ERROR( error );
+          return -1;
+        }
+      }
+      double decode_seconds = SecondsSince( start );
+      
+      std::cout << std::setw( 12 ) << codecs[ c ] << std::setw( 10 ) << Core::ExportToString( filters[ f ] )
+        << std::setw( 10 ) << std::fixed << std::setprecision( 2 ) 
+        << static_cast<double>( raw_bytes ) / Core::Max( encoded_bytes, static_cast<size_t>( 1 ) )
+        << std::setw( 14 ) << std::setprecision( 1 ) << raw_mb / Core::Max( encode_seconds, 1e-6 )
+        << std::setw( 14 ) << raw_mb / Core::Max( decode_seconds, 1e-6 ) << std::endl;
+    }
+  }
+  
+  return 0;
+}
@@ -68,10 +68,14 @@ void printUsage()
   std::cout << "  --bricksize=VECTOR | SCALAR  - Brick size, default is 256,256,256." << std::endl
             << "                                 Size of bricks can be set with single number (--bricksize=512 for 512,512,512 brick)." << std::endl;
   std::cout << "  --overlap=SCALAR             - Overlap betweeen the bricks, default is 1." << std::endl;
-  std::cout << "  --nodownsample=CHAR          - Do not downsample in given direction (x,y, or z)." << std::endl << std::endl;
+  std::cout << "  --nodownsample=CHAR          - Do not downsample in given direction (x,y, or z)." << std::endl;
+  std::cout << "  --codec=NAME                 - Codec used to compress bricks, default is zlib. Available codecs: " 
+            << Core::ExportToString( Core::LargeVolumeCodecRegistry::Instance()->get_codec_names() ) << "." << std::endl;
+  std::cout << "  --filter=NAME                - Filter applied before compressing bricks (none, shuffle or delta), default is shuffle." << std::endl << std::endl;
   std::cout << "Tool parameters (optional):" << std::endl;
   std::cout << "  --maxgb=SCALAR               - Maximum number of GB to use for conversion, default is based on available memory." << std::endl;
   std::cout << "  --silent                     - Do not wait for user input to continue." << std::endl;
+  std::cout << "  --resume                     - Continue an interrupted conversion in an existing output directory." << std::endl;
 }
 
 // TODO: header full of useful constants (e.g. default brick size)
@@ -141,7 +145,9 @@ int main( int argc, char **argv )
     output_dir = boost::filesystem::path( output_dir.string() + ".s3dvol" );
   }
   
-  if (boost::filesystem::exists(output_dir))
+  bool resume = Core::Application::Instance()->is_command_line_parameter( "resume" );
+  
+  if ( boost::filesystem::exists( output_dir ) && !resume )
   {
     printUsage();
     CORE_PRINT_AND_LOG_ERROR("Output directory '" + output_dir.string() + "' already exists, please delete directory before starting conversion.");
@@ -249,6 +255,30 @@ int main( int argc, char **argv )
     if ( nodownsample == "z" ) down_sample_z = false;
   }
   
+  // -- brick codec --
+  std::string codec = "zlib";
+  if ( Core::Application::Instance()->check_command_line_parameter( "codec" , codec ) )
+  {
+    if (! Core::LargeVolumeCodecRegistry::Instance()->get_codec( codec ) )
+    {
+      printUsage();
+      CORE_PRINT_AND_LOG_ERROR("Codec '" + codec + "' is not available.");
+      return -1;
+    }
+  }
+  
+  Core::LargeVolumeFilter filter = Core::LargeVolumeFilter::SHUFFLE_E;
+  std::string filter_string;
+  if ( Core::Application::Instance()->check_command_line_parameter( "filter" , filter_string ) )
+  {
+    if (! Core::ImportFromString( filter_string, filter ) )
+    {
+      printUsage();
+      CORE_PRINT_AND_LOG_ERROR("Filter needs to be none, shuffle, or delta.");
+      return -1;
+    }
+  }
+  
   long long mem_limit = 0;
   if ( sizeof(void *) == 4 )
   {
@@ -303,7 +333,9 @@ int main( int argc, char **argv )
   converter->set_first_file( first_file );
   converter->set_schema_parameters( spacing, origin, brick_size, overlap );
   converter->get_schema()->enable_downsample( down_sample_x, down_sample_y, down_sample_z );
+  converter->get_schema()->set_codec( codec, filter );
   converter->set_mem_limit( mem_limit );
+  converter->set_resume( resume );
   
   // Scan files and compute schema
   std::string error;
@@ -326,6 +358,7 @@ int main( int argc, char **argv )
   std::cout << "Brick Size:         " << Core::ExportToString( schema->get_brick_size() ) << std::endl;
   std::cout << "Overlap:            " << Core::ExportToString( schema->get_overlap() ) << std::endl;
   std::cout << "Resolution Levels:  " << Core::ExportToString( schema->get_num_levels() ) << std::endl;
+  std::cout << "Brick Codec:        " << codec << " (" << Core::ExportToString( filter ) << ")" << std::endl;
   std::cout << "Memory Usage Limit: " << Core::ExportToString( mem_limit >> 30 ) << " GB" << std::endl;
   if (nodownsample.size())
   {
@@ -353,15 +386,28 @@ int main( int argc, char **argv )
     return -1;
   }
   
-  std::cout << "== Compressing bricks and optimizing brick files ==" << std::endl;
-  
-  if (! converter->run_phase3( error ) )
+  if (! converter->is_single_pass() )
   {
-    printUsage();
-    CORE_PRINT_AND_LOG_ERROR( error );
-    return -1;
+    std::cout << "== Compressing bricks and optimizing brick files ==" << std::endl;
+    
+    if (! converter->run_phase3( error ) )
+    {
+      printUsage();
+      CORE_PRINT_AND_LOG_ERROR( error );
+      return -1;
+    }
   }
   
+  double seconds = Core::Max( converter->get_elapsed_seconds(), 0.001 );
+  double input_mb = static_cast<double>( converter->get_input_bytes() ) / ( 1 << 20 );
+  double output_mb = static_cast<double>( converter->get_output_bytes() ) / ( 1 << 20 );
+  
+  std::cout << "Conversion Time:    " << Core::ExportToString( seconds ) << " s" << std::endl;
+  std::cout << "Input Throughput:   " << Core::ExportToString( input_mb / seconds ) << " MB/s ("
+    << Core::ExportToString( input_mb ) << " MB)" << std::endl;
+  std::cout << "Output Throughput:  " << Core::ExportToString( output_mb / seconds ) << " MB/s ("
+    << Core::ExportToString( output_mb ) << " MB)" << std::endl;
+  
   std::cout << "== done ==" << std::endl;
   
   // Indicate a successful finish of the program